@@ -17,6 +17,8 @@
 
 // forward
 struct memblock_t;
+struct objectcache_type_t;
+struct typeadapt_object_t;
 
 /* typedef: struct objectcache_it
  * Export interface <objectcache_it>. */
@@ -48,6 +50,12 @@ struct objectcache_it {
    /* function: unlock_iobuffer
     * See <objectcache_impl_t.unlockiobuffer_objectcacheimpl> for an implementation. */
    void (*unlock_iobuffer) (struct objectcache_t * cache, struct memblock_t ** iobuffer);
+   /* function: alloc_object
+    * See <objectcache_impl_t.allocobject_objectcacheimpl> for an implementation. */
+   int  (*alloc_object)    (struct objectcache_t * cache, struct objectcache_type_t * type, /*out*/struct typeadapt_object_t ** object);
+   /* function: free_object
+    * See <objectcache_impl_t.freeobject_objectcacheimpl> for an implementation. */
+   int  (*free_object)     (struct objectcache_t * cache, struct objectcache_type_t * type, struct typeadapt_object_t ** object);
 };
 
 // group: generic
@@ -90,7 +98,17 @@ void objectcache_it_DECLARE(TYPENAME declared_it, TYPENAME objectcache_t);
                   &((objectcache_it*) _c)->lock_iobuffer              \
                && &_c->unlock_iobuffer                                \
                   == (void (**) (objectcache_t*,struct memblock_t**)) \
-                     &((objectcache_it*) _c)->unlock_iobuffer,        \
+                     &((objectcache_it*) _c)->unlock_iobuffer         \
+               && &_c->alloc_object                                   \
+                  == (int (**) (objectcache_t*,                       \
+                        struct objectcache_type_t*,                   \
+                        struct typeadapt_object_t**))                 \
+                     &((objectcache_it*) _c)->alloc_object            \
+               && &_c->free_object                                    \
+                  == (int (**) (objectcache_t*,                       \
+                        struct objectcache_type_t*,                   \
+                        struct typeadapt_object_t**))                 \
+                     &((objectcache_it*) _c)->free_object,            \
                "compatible struct"                                    \
             );                                                        \
             (objectcache_it*) _c;                                     \
@@ -103,6 +121,8 @@ void objectcache_it_DECLARE(TYPENAME declared_it, TYPENAME objectcache_t);
          struct declared_it {                               \
             void (*lock_iobuffer)   (objectcache_t * cache, /*out*/struct memblock_t ** iobuffer); \
             void (*unlock_iobuffer) (objectcache_t * cache, struct memblock_t ** iobuffer);        \
+            int  (*alloc_object)    (objectcache_t * cache, struct objectcache_type_t * type, /*out*/struct typeadapt_object_t ** object); \
+            int  (*free_object)     (objectcache_t * cache, struct objectcache_type_t * type, struct typeadapt_object_t ** object);        \
          }
 
 #endif
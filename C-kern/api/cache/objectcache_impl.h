@@ -7,6 +7,11 @@
    storage for cached objects before a new thread is created and frees all storage
    before the thread exits.
 
+   Submodules register an object type with <init_objectcachetype>.
+   Objects of a registered type are allocated and freed with <allocobject_objectcacheimpl>
+   and <freeobject_objectcacheimpl> which are served from per thread magazines.
+   A depot stored in <objectcache_type_t> exchanges magazines between threads.
+
    Copyright:
    This program is free software. See accompanying LICENSE file.
 
@@ -24,11 +29,19 @@
 
 // forward
 struct memblock_t;
+struct typeadapt_t;
+struct typeadapt_object_t;
+struct objectcache_magazine_t;
+struct objectcache_slot_t;
 
 /* typedef: struct objectcache_impl_t
  * Export <objectcache_impl_t>. */
 typedef struct objectcache_impl_t objectcache_impl_t;
 
+/* typedef: struct objectcache_type_t
+ * Export <objectcache_type_t>. */
+typedef struct objectcache_type_t objectcache_type_t;
+
 
 // section: Functions
 
@@ -41,9 +54,80 @@ int unittest_cache_objectcacheimpl(void) ;
 #endif
 
 
+/* struct: objectcache_type_t
+ * Describes a type of objects cached in <objectcache_impl_t>.
+ * A submodule defines one static variable of this type and registers it
+ * with <init_objectcachetype> before any thread allocates objects of this type.
+ *
+ * Objects are constructed with <typeadapt_lifetime_it.newcopy_object> as copy of <prototype>
+ * and destructed with <typeadapt_lifetime_it.delete_object>. Cached objects stay constructed.
+ *
+ * The depot holds magazines which are exchanged between the caches of all threads.
+ * It is protected with <depotlock>. */
+struct objectcache_type_t {
+   /* variable: typeadp
+    * Lifetime of cached objects. Memory of objects is managed by <typeadapt_lifetime_it>. */
+   struct typeadapt_t               * typeadp;
+   /* variable: prototype
+    * Source object given as parameter srcobject to <typeadapt_lifetime_it.newcopy_object>. */
+   const struct typeadapt_object_t  * prototype;
+   /* variable: depotfull
+    * List of magazines which contain objects.
+    * Magazines of exited threads could be only partially filled. */
+   struct objectcache_magazine_t    * depotfull;
+   /* variable: depotempty
+    * List of empty magazines. */
+   struct objectcache_magazine_t    * depotempty;
+   /* variable: typeid
+    * Index into table <objectcache_impl_t.magazine>. Assigned by <init_objectcachetype>. */
+   uint16_t                         typeid;
+   /* variable: depotlock
+    * Lock flag protecting <depotfull> and <depotempty>. Set and cleared with atomic operations. */
+   uint8_t                          depotlock;
+};
+
+// group: lifetime
+
+/* define: objectcache_type_FREE
+ * Static initializer. */
+#define objectcache_type_FREE \
+         { 0, 0, 0, 0, 0, 0 }
+
+/* function: init_objectcachetype
+ * Registers a type of cached objects. The error ENOSPC is returned if
+ * more than <objectcache_impl_NROFTYPE> types are registered at the same time.
+ * The objects are constructed and destructed with the lifetime interface of typeadp.
+ * Parameter prototype is given as srcobject to <typeadapt_lifetime_it.newcopy_object>. */
+int init_objectcachetype(/*out*/objectcache_type_t * type, struct typeadapt_t * typeadp, const struct typeadapt_object_t * prototype);
+
+/* function: free_objectcachetype
+ * Deletes all objects and magazines in the depot and unregisters the type.
+ *
+ * Unchecked Precondition:
+ * - Every <objectcache_impl_t> which has cached objects of this type is freed. */
+int free_objectcachetype(objectcache_type_t * type);
+
+// group: config
+
+/* define: objectcache_impl_NROFTYPE
+ * The maximum number of simultaneously registered <objectcache_type_t>. */
+#define objectcache_impl_NROFTYPE 16
+
+/* define: objectcache_impl_MAGAZINESIZE
+ * The number of objects one magazine can hold. */
+#define objectcache_impl_MAGAZINESIZE 30
+
+
 /* struct: objectcache_impl_t
- * Holds pointers to all cached objects.
- * TODO: remove iobuffer and add other types ! */
+ * Holds pointers to all cached objects of one thread.
+ * Every registered <objectcache_type_t> owns two magazines.
+ * Objects are popped from and pushed onto the loaded magazine.
+ * If it runs empty (or full) it is exchanged with the previous magazine
+ * and only if both can not serve the request the depot is locked.
+ * Objects are constructed only if the depot contains no objects.
+ *
+ * Every thread stores an <objectcache_impl_t> in its static memory.
+ * Therefore the table of magazines is allocated from the <pagecache_t> by <init_objectcacheimpl>. */
 struct objectcache_impl_t {
    /* variable: iobuffer
     * Used in <ALLOC_PAGECACHE>. */
@@ -51,6 +135,10 @@ struct objectcache_impl_t {
       uint8_t *   addr ;
       size_t      size ;
    }           iobuffer ;
+   /* variable: magazine
+    * Table of <objectcache_impl_NROFTYPE> entries. Every entry stores the per thread magazines
+    * of a registered <objectcache_type_t> and is indexed by <objectcache_type_t.typeid>. */
+   struct objectcache_slot_t * magazine ;
 } ;
 
 // group: initthread
@@ -65,14 +153,16 @@ struct objectcache_it * interface_objectcacheimpl(void) ;
 /* define: objectcache_impl_FREE
  * Static initializer. */
 #define objectcache_impl_FREE \
-         { vmpage_FREE }
+         { vmpage_FREE, 0 }
 
 /* function: init_objectcacheimpl
  * Inits <objectcache_impl_t> and all contained objects. */
 int init_objectcacheimpl(/*out*/objectcache_impl_t * objectcache) ;
 
 /* function: free_objectcacheimpl
- * Frees <objectcache_impl_t> and all contained objects. */
+ * Frees <objectcache_impl_t> and all contained objects.
+ * Magazines of registered types are moved to the depot of <objectcache_type_t>
+ * where they can be used by other threads. */
 int free_objectcacheimpl(objectcache_impl_t * objectcache) ;
 
 // group: access
@@ -88,5 +178,20 @@ void lockiobuffer_objectcacheimpl(objectcache_impl_t * objectcache, /*out*/struc
  * Calling unlock with a NULL pointer is a no op. */
 void unlockiobuffer_objectcacheimpl(objectcache_impl_t * objectcache, struct memblock_t ** iobuffer) ;
 
+// group: object
+
+/* function: allocobject_objectcacheimpl
+ * Returns a constructed object of the registered type.
+ * The object is taken from the magazines of this cache or from the depot.
+ * If both contain no objects a new one is constructed with <typeadapt_lifetime_it.newcopy_object>. */
+int allocobject_objectcacheimpl(objectcache_impl_t * objectcache, objectcache_type_t * type, /*out*/struct typeadapt_object_t ** object) ;
+
+/* function: freeobject_objectcacheimpl
+ * Returns an object allocated with <allocobject_objectcacheimpl> to the cache and sets *object to 0.
+ * The object is not destructed. A full magazine is moved to the depot.
+ * Only if no magazine could be allocated the object is deleted with <typeadapt_lifetime_it.delete_object>.
+ * The object could have been allocated by another thread. */
+int freeobject_objectcacheimpl(objectcache_impl_t * objectcache, objectcache_type_t * type, struct typeadapt_object_t ** object) ;
+
 
 #endif
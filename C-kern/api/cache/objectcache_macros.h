@@ -32,5 +32,19 @@
 #define UNLOCKIOBUFFER_OBJECTCACHE(iobuffer) \
          (objectcache_maincontext().iimpl->unlock_iobuffer(objectcache_maincontext().object, (iobuffer)))
 
+// group: object
+
+/* define: ALLOCOBJECT_OBJECTCACHE
+ * Returns a constructed object of the registered type from the cache of the current thread.
+ * See also <allocobject_objectcacheimpl>. */
+#define ALLOCOBJECT_OBJECTCACHE(type, /*out*/object) \
+         (objectcache_maincontext().iimpl->alloc_object(objectcache_maincontext().object, (type), (object)))
+
+/* define: FREEOBJECT_OBJECTCACHE
+ * Returns an object allocated with <ALLOCOBJECT_OBJECTCACHE> to the cache of the current thread.
+ * See also <freeobject_objectcacheimpl>. */
+#define FREEOBJECT_OBJECTCACHE(type, object) \
+         (objectcache_maincontext().iimpl->free_object(objectcache_maincontext().object, (type), (object)))
+
 
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@
 
 // forward
 struct binarystack_t;
+struct perftest_info_t;
 struct typeadapt_member_t;
 
 // === exported types
@@ -40,6 +41,20 @@ struct arraysf_iterator_t;
 int unittest_ds_inmem_arraysf(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_arraysf_sequential
+ * Test insert, find, iterate and remove of 1M sequential keys. */
+int perftest_ds_inmem_arraysf_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_arraysf_random
+ * Test insert, find, iterate and remove of 1M random keys. */
+int perftest_ds_inmem_arraysf_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_arraysf_small
+ * Test insert, find, iterate and remove of 1K random keys repeated 1K times. */
+int perftest_ds_inmem_arraysf_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: arraysf_t
  * Trie implementation to support sparse arrays.
@@ -0,0 +1,166 @@
+/* title: BloomFilter
+
+   A blocked Bloom filter which answers approximate membership queries.
+   It is used as a guard in front of an index (<exthash_t>, <patriciatrie_t>, ...)
+   to skip lookups of keys which are not stored in the index.
+
+   A query answers either "key is definitely not contained" or "key may be contained".
+   There are no false negatives. The rate of false positives depends on the number
+   of bits per inserted key (about 3.3% for 8, 0.5% for 12 and 0.13% for 16 bits per key).
+
+   Keys are not stored. Hash values are computed with the <typeadapt_gethash_it> service
+   of the <typeadapt_t> given in <init_bloomfilter>. Removing keys is not supported
+   cause bits are shared between keys. Call <clear_bloomfilter> and insert all
+   remaining keys again if too many keys were removed from the index.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/bloomfilter.h
+    Header file <BloomFilter>.
+
+   file: C-kern/ds/inmem/bloomfilter.c
+    Implementation file <BloomFilter impl>.
+*/
+#ifndef CKERN_DS_INMEM_BLOOMFILTER_HEADER
+#define CKERN_DS_INMEM_BLOOMFILTER_HEADER
+
+// forward
+struct perftest_info_t;
+struct typeadapt_t;
+struct typeadapt_object_t;
+
+/* typedef: struct bloomfilter_t
+ * Export <bloomfilter_t> into global namespace. */
+typedef struct bloomfilter_t bloomfilter_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_inmem_bloomfilter
+ * Test <bloomfilter_t> functionality. */
+int unittest_ds_inmem_bloomfilter(void);
+#endif
+
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_bloomfilter_8
+ * Test query performance and false positive rate with 8 bits per key. */
+int perftest_ds_inmem_bloomfilter_8(/*out*/struct perftest_info_t* info);
+/* function: perftest_ds_inmem_bloomfilter_12
+ * Test query performance and false positive rate with 12 bits per key. */
+int perftest_ds_inmem_bloomfilter_12(/*out*/struct perftest_info_t* info);
+/* function: perftest_ds_inmem_bloomfilter_16
+ * Test query performance and false positive rate with 16 bits per key. */
+int perftest_ds_inmem_bloomfilter_16(/*out*/struct perftest_info_t* info);
+#endif
+
+
+/* struct: bloomfilter_t
+ * Split block Bloom filter.
+ *
+ * The filter is an array of blocks. Every block has a size of 32 bytes (<bloomfilter_BLOCKSIZE>)
+ * and is aligned to its size so that it never crosses a cache line.
+ * A block consists of 8 words of 32 bits.
+ *
+ * The hash value of a key is mixed and split into two 32 bit values.
+ * The high part selects a single block. The low part is multiplied with 8 different
+ * odd constants and every product selects one bit in one of the 8 words.
+ * Inserting sets these 8 bits, querying tests them.
+ * Therefore every operation touches a single cache line.
+ *
+ * Hash values returned from <typeadapt_gethash_it> need not be well distributed.
+ * They could be the key value itself. */
+struct bloomfilter_t {
+   // group: private fields
+   /* variable: blocks
+    * Array of <nrblocks> * 8 words. */
+   uint32_t    * blocks;
+   /* variable: nrblocks
+    * Number of blocks of size <bloomfilter_BLOCKSIZE>. */
+   size_t        nrblocks;
+   /* variable: memsize
+    * Size in bytes of allocated memory <blocks>. */
+   size_t        memsize;
+   /* variable: typeadp
+    * Computes hash values of keys and objects. Only the gethash service is used. */
+   struct typeadapt_t * typeadp;
+};
+
+// group: configuration
+
+/* define: bloomfilter_BLOCKSIZE
+ * Size in bytes of a single block. */
+#define bloomfilter_BLOCKSIZE 32
+
+// group: lifetime
+
+/* define: bloomfilter_FREE
+ * Static initializer. */
+#define bloomfilter_FREE \
+         { 0, 0, 0, 0 }
+
+/* function: init_bloomfilter
+ * Allocates an empty filter with nrkeys * bitsperkey bits rounded up to
+ * a multiple of <bloomfilter_BLOCKSIZE>.
+ * The value nrkeys is the expected number of keys.
+ * If more keys are inserted the rate of false positives grows.
+ * Parameter typeadp must live as long as filter (only a reference is stored).
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - typeadp is 0 or bitsperkey is 0 or the size of the filter overflows.
+ * ENOMEM - Out of memory. */
+int init_bloomfilter(/*out*/bloomfilter_t * filter, size_t nrkeys, uint8_t bitsperkey, struct typeadapt_t * typeadp);
+
+/* function: free_bloomfilter
+ * Frees allocated memory. */
+int free_bloomfilter(bloomfilter_t * filter);
+
+// group: query
+
+/* function: size_bloomfilter
+ * Returns the number of bytes used by the blocks of the filter. */
+size_t size_bloomfilter(const bloomfilter_t * filter);
+
+/* function: maycontain_bloomfilter
+ * Returns false if key was never inserted. Returns true if key may be inserted.
+ * The hash value is computed with <typeadapt_gethash_it.hashkey>. */
+bool maycontain_bloomfilter(const bloomfilter_t * filter, const void * key);
+
+/* function: maycontainhash_bloomfilter
+ * Same as <maycontain_bloomfilter> but the hash value of the key is given. */
+bool maycontainhash_bloomfilter(const bloomfilter_t * filter, size_t hashvalue);
+
+// group: update
+
+/* function: insert_bloomfilter
+ * Adds the key of object to the filter.
+ * The hash value is computed with <typeadapt_gethash_it.hashobject>. */
+void insert_bloomfilter(bloomfilter_t * filter, const struct typeadapt_object_t * object);
+
+/* function: insertkey_bloomfilter
+ * Adds key to the filter.
+ * The hash value is computed with <typeadapt_gethash_it.hashkey>. */
+void insertkey_bloomfilter(bloomfilter_t * filter, const void * key);
+
+/* function: inserthash_bloomfilter
+ * Adds a key with the given hash value to the filter. */
+void inserthash_bloomfilter(bloomfilter_t * filter, size_t hashvalue);
+
+/* function: clear_bloomfilter
+ * Removes all keys. After return <maycontain_bloomfilter> returns false for every key. */
+void clear_bloomfilter(bloomfilter_t * filter);
+
+
+
+// section: inline implementation
+
+/* define: size_bloomfilter
+ * Implements <bloomfilter_t.size_bloomfilter>. */
+#define size_bloomfilter(filter) \
+         ((filter)->nrblocks * bloomfilter_BLOCKSIZE)
+
+#endif
@@ -0,0 +1,352 @@
+/* title: BPlustree-Index
+
+   Interface to an in-memory B+-tree which allows
+   access to a set of sorted elements in O(log n).
+
+   Every node of the tree is stored in a single page allocated from <pagecache_t>.
+   Inner nodes store only separator pointers and child pointers, leaves store
+   pointers to the inserted nodes and are linked in ascending order.
+
+   The interface has the same shape as <RedBlacktree-Index> so exchanging
+   <redblacktree_IMPLEMENT> with <bptree_IMPLEMENT> (and the node type) is enough
+   to switch the index implementation.
+
+   Precondition:
+   1. - include "C-kern/api/ds/typeadapt.h" before including this file.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/bptree.h
+    Header file of <BPlustree-Index>.
+
+   file: C-kern/ds/inmem/bptree.c
+    Implementation file of <BPlustree-Index impl>.
+*/
+#ifndef CKERN_DS_INMEM_BPTREE_HEADER
+#define CKERN_DS_INMEM_BPTREE_HEADER
+
+#include "C-kern/api/memory/pagecache.h"
+
+// === exported types
+struct bptree_t;
+struct bptree_node_t;
+struct bptree_iterator_t;
+
+// forward
+struct bptree_leaf_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_inmem_bptree
+ * Test implementation of <bptree_t>. */
+int unittest_ds_inmem_bptree(void);
+#endif
+
+
+/* struct: bptree_node_t
+ * Management data of an object stored in <bptree_t>.
+ * The tree stores only the address of this node in its leaves.
+ * The node itself holds no state but determines the offset
+ * used by <typeadapt_member_t> to convert between node and object. */
+typedef struct bptree_node_t {
+   /* variable: unused
+    * Gives the node a size in C. Never read or written by the tree. */
+   uint8_t  unused;
+} bptree_node_t;
+
+// group: lifetime
+
+/* define: bptree_node_INIT
+ * Static initializer. */
+#define bptree_node_INIT { 0 }
+
+
+/* struct: bptree_iterator_t
+ * Iterates over elements contained in <bptree_t>.
+ * The iterator walks along the linked list of leaves.
+ * The iterator supports removing or deleting of the current node.
+ * If the tree has been changed since the last iteration step
+ * the position of the next node is searched again starting from the root.
+ * > bptree_t tree;
+ * > fill_tree(&tree);
+ * > foreach (_bptree, node, &tree) {
+ * >    if (need_to_remove(node)) {
+ * >       err = remove_bptree(&tree, node));
+ * >    }
+ * > }
+ * */
+typedef struct bptree_iterator_t {
+   /* variable: tree
+    * The iterated tree. */
+   struct bptree_t      * tree;
+   /* variable: leaf
+    * The leaf which contains <next>. */
+   struct bptree_leaf_t * leaf;
+   /* variable: index
+    * The index of <next> in <leaf>. */
+   size_t                 index;
+   /* variable: next
+    * The node returned by the next iteration step. 0 if the iteration has finished. */
+   bptree_node_t        * next;
+   /* variable: changecount
+    * The value of <bptree_t.changecount> at the time <leaf> and <index> were valid. */
+   size_t                 changecount;
+} bptree_iterator_t;
+
+// group: lifetime
+
+/* define: bptree_iterator_FREE
+ * Static initializer. */
+#define bptree_iterator_FREE { 0, 0, 0, 0, 0 }
+
+/* function: initfirst_bptreeiterator
+ * Initializes an iterator for <bptree_t>. */
+int initfirst_bptreeiterator(/*out*/bptree_iterator_t * iter, struct bptree_t * tree);
+
+/* function: initlast_bptreeiterator
+ * Initializes an iterator of <bptree_t>. */
+int initlast_bptreeiterator(/*out*/bptree_iterator_t * iter, struct bptree_t * tree);
+
+/* function: initfrom_bptreeiterator
+ * Initializes an iterator of <bptree_t> for a range scan.
+ * The first call to <next_bptreeiterator> returns the node with the lowest key greater or equal to key.
+ * The first call to <prev_bptreeiterator> returns the same node. */
+int initfrom_bptreeiterator(/*out*/bptree_iterator_t * iter, struct bptree_t * tree, const void * key);
+
+/* function: free_bptreeiterator
+ * Frees an iterator of <bptree_t>. */
+int free_bptreeiterator(bptree_iterator_t * iter);
+
+// group: iterate
+
+/* function: next_bptreeiterator
+ * Returns next node of tree in ascending order.
+ * The first call after <initfirst_bptreeiterator> returns the node with the lowest key.
+ * In case no next node exists false is returned and parameter node is not changed. */
+bool next_bptreeiterator(bptree_iterator_t * iter, /*out*/bptree_node_t ** node);
+
+/* function: prev_bptreeiterator
+ * Returns next node of tree in descending order.
+ * The first call after <initlast_bptreeiterator> returns the node with the highest key.
+ * In case no previous node exists false is returned and parameter node is not changed. */
+bool prev_bptreeiterator(bptree_iterator_t * iter, /*out*/bptree_node_t ** node);
+
+
+/* struct: bptree_t
+ * Object which carries all information to implement a B+-tree data type.
+ *
+ * typeadapt_t:
+ * The service <typeadapt_lifetime_it.delete_object> of <typeadapt_t.lifetime> is used in <free_bptree> and <removenodes_bptree>.
+ * The service <typeadapt_comparator_it.cmp_key_object> of <typeadapt_t.comparator> is used in <find_bptree> and <initfrom_bptreeiterator>.
+ * The service <typeadapt_comparator_it.cmp_object> of <typeadapt_t.comparator> is used in <invariant_bptree>, <insert_bptree>, and <remove_bptree>.
+ *
+ * Tree Properties:
+ *    1. - Every tree node is a page of size <pgsize> allocated with <ALLOC_PAGECACHE>.
+ *    2. - All leaves have the same depth <height>.
+ *    3. - Leaves store pointers to <bptree_node_t> in ascending order and are doubly linked.
+ *    4. - An inner node with k separators has k+1 children. Every separator points to the
+ *         smallest node stored in the subtree right of it.
+ *    5. - Every node except the root is at least half full.
+ *
+ * Cache efficiency:
+ * A search reads at most <height>+1 pages. The pointers of a page are stored
+ * consecutively so that a binary search touches only a few cache lines of every page
+ * besides the compared objects. With pages of 4096 bytes a leaf stores 509 and an
+ * inner node 255 separators. A tree of height 2 stores up to 33 million nodes.
+ *
+ * Algorithm:
+ * Inserting splits every full page on the way down so that inserting into a leaf never
+ * needs to touch a parent page again. Removing moves nodes from a sibling or merges
+ * with it for every page on the way down which is exactly half full. */
+typedef struct bptree_t {
+   /* variable: root
+    * Points to the root page. It is a leaf if <height> is 0. The value 0 marks an empty tree. */
+   void                 * root;
+   /* variable: first
+    * Leaf which contains the smallest node. */
+   struct bptree_leaf_t * first;
+   /* variable: last
+    * Leaf which contains the biggest node. */
+   struct bptree_leaf_t * last;
+   /* variable: changecount
+    * Incremented every time a node is inserted, removed, or moved to another page. Used by <bptree_iterator_t>. */
+   size_t                 changecount;
+   /* variable: height
+    * The number of inner pages on the path from root to a leaf. */
+   uint8_t                height;
+   /* variable: pgsize
+    * The size of all pages of the tree. See <pagesize_e>. */
+   uint8_t                pgsize;
+   /* variable: nodeadp
+    * Offers lifetime + comparator services to handle stored nodes. */
+   typeadapt_member_t     nodeadp;
+} bptree_t;
+
+// group: lifetime
+
+/* define: bptree_FREE
+ * Static initializer. Makes calling <free_bptree> safe. */
+#define bptree_FREE \
+         bptree_INIT(pagesize_4096, typeadapt_member_FREE)
+
+/* define: bptree_INIT
+ * Static initializer. Initializes an empty tree whose pages are of size pgsize (see <pagesize_e>).
+ * The smallest supported page size is <pagesize_256>. Parameter nodeadp must be of type <typeadapt_member_t> (no pointer). */
+#define bptree_INIT(pgsize, nodeadp)   { 0, 0, 0, 0, 0, pgsize, nodeadp }
+
+/* function: init_bptree
+ * Inits an empty tree object which uses pages of size <pagesize_4096>.
+ * The <typeadapt_member_t> is copied but the <typeadapt_t> it references is not.
+ * So do not delete <typeadapt_t> as long as this object lives. */
+void init_bptree(/*out*/bptree_t * tree, const typeadapt_member_t * nodeadp);
+
+/* function: free_bptree
+ * Frees all resources. Calling it twice is safe.  */
+int free_bptree(bptree_t * tree);
+
+// group: query
+
+/* function: isempty_bptree
+ * Returns true if tree contains no elements. */
+bool isempty_bptree(const bptree_t * tree);
+
+// group: foreach-support
+
+/* typedef: iteratortype_bptree
+ * Declaration to associate <bptree_iterator_t> with <bptree_t>. */
+typedef bptree_iterator_t     iteratortype_bptree;
+
+/* typedef: iteratedtype_bptree
+ * Declaration to associate <bptree_node_t> with <bptree_t>. */
+typedef bptree_node_t      *  iteratedtype_bptree;
+
+// group: search
+
+/* function: find_bptree
+ * Searches for a node with equal key.
+ * If it exists it is returned in found_node else ESRCH is returned. */
+int find_bptree(bptree_t * tree, const void * key, /*out*/bptree_node_t ** found_node);
+
+// group: change
+
+/* function: insert_bptree
+ * Inserts a new node into the tree only if it is unique.
+ * If another node exists with the same key nothing is inserted and the function returns EEXIST
+ * The caller has to allocate new_node and has to transfer ownership.
+ * ENOMEM is returned if a new page could not be allocated. The tree is not changed in this case. */
+int insert_bptree(bptree_t * tree, bptree_node_t * new_node);
+
+/* function: remove_bptree
+ * Removes a node from the tree. If the node is not part of the tree ESRCH is returned.
+ * The ownership of the removed node is transfered back to the caller. */
+int remove_bptree(bptree_t * tree, bptree_node_t * node);
+
+/* function: removenodes_bptree
+ * Removes all nodes from the tree.
+ * For every removed node <typeadapt_lifetime_it.delete_object> is called. */
+int removenodes_bptree(bptree_t * tree);
+
+// group: test
+
+/* function: invariant_bptree
+ * Checks that this tree meets the properties of a B+-tree. */
+int invariant_bptree(bptree_t * tree);
+
+// group: generic
+
+/* define: bptree_IMPLEMENT
+ * Adapts interface of <bptree_t> to nodes of type object_t.
+ *
+ * Parameter:
+ * _fsuffix  - The suffix name of all generated tree interface functions, e.g. "init##_fsuffix".
+ * object_t  - The type of object which can be stored and retrieved from this tree.
+ *             The object must contain a field of type <bptree_node_t>.
+ * key_t     - The type of key the objects are sorted by.
+ * nodename  - The access path of the field <bptree_node_t> in type object_t.
+ * */
+void bptree_IMPLEMENT(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename);
+
+
+// section: inline implementation
+
+/* define: free_bptreeiterator
+ * Implements <bptree_iterator_t.free_bptreeiterator> as NOP. */
+#define free_bptreeiterator(iter)   \
+         ((iter)->next = 0, 0)
+
+/* define: init_bptree
+ * Implements <bptree_t.init_bptree>. */
+#define init_bptree(tree,nodeadp)      ((void)(*(tree) = (bptree_t) bptree_INIT(pagesize_4096, *(nodeadp))))
+
+/* define: isempty_bptree
+ * Implements <bptree_t.isempty_bptree>. */
+#define isempty_bptree(tree)           (0 == (tree)->root)
+
+/* define: bptree_IMPLEMENT
+ * Implements <bptree_t.bptree_IMPLEMENT>. */
+#define bptree_IMPLEMENT(_fsuffix, object_t, key_t, nodename)  \
+   typedef bptree_iterator_t  iteratortype##_fsuffix; \
+   typedef object_t        *  iteratedtype##_fsuffix; \
+   static inline bptree_node_t * cast2node##_fsuffix(object_t * object) { \
+      static_assert(&((object_t*)0)->nodename == (bptree_node_t*)offsetof(object_t, nodename), "correct type"); \
+      return (bptree_node_t *) ((uintptr_t)object + offsetof(object_t, nodename)); \
+   } \
+   static inline object_t * cast2object##_fsuffix(bptree_node_t * node) { \
+      return (object_t *) ((uintptr_t)node - offsetof(object_t, nodename)); \
+   } \
+   static inline void init##_fsuffix(/*out*/bptree_t * tree, const typeadapt_member_t * nodeadp) { \
+      init_bptree(tree, nodeadp); \
+   } \
+   static inline int  free##_fsuffix(bptree_t * tree) { \
+      return free_bptree(tree); \
+   } \
+   static inline bool isempty##_fsuffix(const bptree_t * tree) { \
+      return isempty_bptree(tree); \
+   } \
+   static inline int  find##_fsuffix(bptree_t * tree, const key_t key, /*out*/object_t ** found_node) { \
+      int err = find_bptree(tree, (void*)key, (bptree_node_t**)found_node); \
+      if (err == 0) *found_node = cast2object##_fsuffix(*(bptree_node_t**)found_node); \
+      return err; \
+   } \
+   static inline int  insert##_fsuffix(bptree_t * tree, object_t * new_node) { \
+      return insert_bptree(tree, cast2node##_fsuffix(new_node)); \
+   } \
+   static inline int  remove##_fsuffix(bptree_t * tree, object_t * node) { \
+      int err = remove_bptree(tree, cast2node##_fsuffix(node)); \
+      return err; \
+   } \
+   static inline int  removenodes##_fsuffix(bptree_t * tree) { \
+      return removenodes_bptree(tree); \
+   } \
+   static inline int  invariant##_fsuffix(bptree_t * tree) { \
+      return invariant_bptree(tree); \
+   } \
+   static inline int  initfirst##_fsuffix##iterator(bptree_iterator_t * iter, bptree_t * tree) { \
+      return initfirst_bptreeiterator(iter, tree); \
+   } \
+   static inline int  initlast##_fsuffix##iterator(bptree_iterator_t * iter, bptree_t * tree) { \
+      return initlast_bptreeiterator(iter, tree); \
+   } \
+   static inline int  initfrom##_fsuffix##iterator(bptree_iterator_t * iter, bptree_t * tree, const key_t key) { \
+      return initfrom_bptreeiterator(iter, tree, (void*)key); \
+   } \
+   static inline int  free##_fsuffix##iterator(bptree_iterator_t * iter) { \
+      return free_bptreeiterator(iter); \
+   } \
+   static inline bool next##_fsuffix##iterator(bptree_iterator_t * iter, object_t ** node) { \
+      bool isNext = next_bptreeiterator(iter, (bptree_node_t**)node); \
+      if (isNext) *node = cast2object##_fsuffix(*(bptree_node_t**)node); \
+      return isNext; \
+   } \
+   static inline bool prev##_fsuffix##iterator(bptree_iterator_t * iter, object_t ** node) { \
+      bool isNext = prev_bptreeiterator(iter, (bptree_node_t**)node); \
+      if (isNext) *node = cast2object##_fsuffix(*(bptree_node_t**)node); \
+      return isNext; \
+   }
+
+#endif
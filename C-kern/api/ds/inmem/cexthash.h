@@ -0,0 +1,315 @@
+/* title: Concurrent-Extendible-Hashing
+
+   Offers a container which organizes stored nodes as a hash table
+   and which can be accessed by more than one thread at the same time.
+   It is the concurrent variant of <Extendible-Hashing>.
+
+   Precondition:
+   1. - include "C-kern/api/ds/typeadapt.h" before including this file.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/cexthash.h
+    Header file <Concurrent-Extendible-Hashing>.
+
+   file: C-kern/ds/inmem/cexthash.c
+    Implementation file <Concurrent-Extendible-Hashing impl>.
+*/
+#ifndef CKERN_DS_INMEM_CEXTHASH_HEADER
+#define CKERN_DS_INMEM_CEXTHASH_HEADER
+
+#include "C-kern/api/ds/inmem/node/lrptree_node.h"
+
+// === exported types
+struct cexthash_t;
+struct cexthash_iterator_t;
+/* typedef: struct cexthash_node_t
+ * Rename <lrptree_node_t> into <cexthash_node_t>. */
+typedef struct lrptree_node_t  cexthash_node_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_inmem_cexthash
+ * Test <cexthash_t> functionality. */
+int unittest_ds_inmem_cexthash(void);
+#endif
+
+
+/* struct: cexthash_iterator_t
+ * Iterates over elements contained in <cexthash_t>.
+ * The iterator supports removing or deleting of the current node.
+ * An iterator must not be used if other threads change the table concurrently. */
+typedef struct cexthash_iterator_t {
+   cexthash_node_t   *next;
+   struct cexthash_t *htable;
+   size_t             tableindex;
+} cexthash_iterator_t;
+
+// group: lifetime
+
+/* define: cexthash_iterator_FREE
+ * Static initializer. */
+#define cexthash_iterator_FREE { 0, 0, 0 }
+
+/* function: initfirst_cexthashiterator
+ * Initializes an iterator for <cexthash_t>. */
+int initfirst_cexthashiterator(/*out*/cexthash_iterator_t *iter, struct cexthash_t *htable);
+
+/* function: free_cexthashiterator
+ * Frees an iterator of <cexthash_t>. */
+int free_cexthashiterator(cexthash_iterator_t *iter);
+
+// group: iterate
+
+/* function: next_cexthashiterator
+ * Returns next node of htable not sorted in any order.
+ * In case no next node exists false is returned and parameter node is not changed. */
+bool next_cexthashiterator(cexthash_iterator_t *iter, /*out*/cexthash_node_t ** node);
+
+
+// struct: cexthash_node_t
+
+// group: lifetime
+
+/* define: cexthash_node_INIT
+ * Static initializer. */
+#define cexthash_node_INIT lrptree_node_INIT
+
+
+// struct: cexthash_t
+
+// group: config
+
+/* define: cexthash_NRLOCK
+ * The number of locks which protect the buckets. */
+#define cexthash_NRLOCK 64
+
+
+/* struct: cexthash_t
+ * Implements a hash table which doubles in size if needed and which supports concurrent access.
+ * The table never shrinks. The hashing is the same as in <exthash_t>.
+ *
+ * Concurrency:
+ * The functions <find_cexthash>, <insert_cexthash> and <remove_cexthash> could be called from
+ * different threads at the same time. Every bucket (tree of nodes) is protected by one of
+ * <cexthash_NRLOCK> reader/writer spin locks. <find_cexthash> acquires a reader lock and
+ * <insert_cexthash>, <remove_cexthash> a writer lock. Operations on buckets protected by different
+ * locks do not wait for each other.
+ *
+ * The directory is split into segments which are never moved in memory. Doubling the table size
+ * appends one new segment whose entries share the buckets of the lower level. This is done by a single
+ * thread without acquiring any bucket lock, no other thread has to wait. Buckets are split lazily by
+ * the next <insert_cexthash>.
+ *
+ * The functions <init_cexthash>, <free_cexthash>, <removenodes_cexthash>, <invariant_cexthash>
+ * and the iterator must not be called concurrently with any other function.
+ *
+ * The memory of nodes is allocated by the user of the container. A node returned from <find_cexthash>
+ * is not locked. The user is responsible to not delete a node which is accessed by another thread.
+ *
+ * typeadapt_t:
+ * The service delete_object of <typeadapt_t.lifetime> is used in <free_cexthash> and <removenodes_cexthash>.
+ * The service cmp_key_object of <typeadapt_t.comparator> is used in <find_cexthash>.
+ * The service cmp_object of <typeadapt_t.comparator> is used in <invariant_cexthash>, <insert_cexthash>, and <remove_cexthash>.
+ * The service hashobject of <typeadapt_t.gethash> is used in <insert_cexthash> and <remove_cexthash>.
+ * The service hashkey of <typeadapt_t.gethash> is used in <find_cexthash>.
+ * All services are called concurrently from different threads.
+ * */
+typedef struct cexthash_t {
+   /* variable: segment
+    * Directory of the hash table split into segments.
+    * Segment 0 contains pow(2,<initlevel>) entries.
+    * Segment s > 0 contains pow(2,<initlevel>+s-1) entries and is allocated if <level> grows to <initlevel>+s.
+    * An entry points to the root of a tree. If it is set to 0 the tree is empty. If it set to the value (intptr_t)-1
+    * it shares the same tree as the entry of the next smaller level. */
+   cexthash_node_t   ** segment[8*sizeof(size_t)];
+   /* variable: lock
+    * Striped reader/writer spin locks. The bucket with index i is protected by lock[i % <cexthash_NRLOCK>].
+    * A value >= 0 counts the number of readers. A negative value means that a writer holds the lock. */
+   int                  lock[cexthash_NRLOCK];
+   /* variable: nr_nodes
+    * The number of stored nodes in the hash table. */
+   size_t               nr_nodes;
+   /* variable: nodeadp
+    * Offers lifetime + keycomparator + gethash services to handle stored nodes. */
+   typeadapt_member_t   nodeadp;
+   /* variable: level
+    * Determines the hash table size as pow(2,level). */
+   uint8_t              level;
+   /* variable: initlevel
+    * The value of <level> after <init_cexthash>. Determines the size of the first segment. */
+   uint8_t              initlevel;
+   /* variable: maxlevel
+    * Determines the max size of the hash table.
+    * Once the <level> value has reached <maxlevel> the table does no more grow. */
+   uint8_t              maxlevel;
+   /* variable: growlock
+    * Set by the thread which adds a new segment to the directory.
+    * Other threads do not wait for it but skip growing. */
+   uint8_t              growlock;
+} cexthash_t;
+
+// group: lifetime
+
+/* define: cexthash_FREE
+ * Static initializer. Makes calling <free_cexthash> safe. */
+#define cexthash_FREE \
+         { { 0 }, { 0 }, 0, typeadapt_member_FREE, 0, 0, 0, 0 }
+
+/* function: init_cexthash
+ * Allocates a hash table of at least size 1.
+ * The parameter initial_size and max_size should be a power of two.
+ * If not the next smaller power of two is chosen. */
+int init_cexthash(/*out*/cexthash_t *htable, size_t initial_size, size_t max_size, const typeadapt_member_t * nodeadp);
+
+/* function: free_cexthash
+ * Calls <removenodes_cexthash> and frees the hash table memory. */
+int free_cexthash(cexthash_t *htable);
+
+// group: query
+
+/* function: isempty_cexthash
+ * Returns true if the table contains no element.
+ * The returned value is only a snapshot if other threads change the table. */
+bool isempty_cexthash(const cexthash_t *htable);
+
+/* function: nrelements_cexthash
+ * Returns the nr of elements stored in the hash table.
+ * The returned value is only a snapshot if other threads change the table. */
+size_t nrelements_cexthash(const cexthash_t *htable);
+
+// group: foreach-support
+
+/* typedef: iteratortype_cexthash
+ * Declaration to associate <cexthash_iterator_t> with <cexthash_t>. */
+typedef cexthash_iterator_t      iteratortype_cexthash;
+
+/* typedef: iteratedtype_cexthash
+ * Declaration to associate <cexthash_node_t> with <cexthash_t>. */
+typedef cexthash_node_t       *  iteratedtype_cexthash;
+
+// group: search
+
+/* function: find_cexthash
+ * Searches for a node with equal key.
+ * If it exists it is returned in found_node else ESRCH is returned.
+ * This function is thread safe. */
+int find_cexthash(cexthash_t *htable, const void * key, /*out*/cexthash_node_t ** found_node);
+
+// group: change
+
+/* function: insert_cexthash
+ * Inserts a new node into the hash table if it is unique.
+ * If another node exists with the same key as *new_node* nothing is inserted and the function returns EEXIST.
+ * The caller has to allocate the new node and has to transfer ownership.
+ * This function is thread safe. */
+int insert_cexthash(cexthash_t *htable, cexthash_node_t * new_node);
+
+/* function: remove_cexthash
+ * Removes a node from the hash table. If the node is not part of the table the behaviour is undefined !
+ * The ownership of the removed node is transfered back to the caller.
+ * This function is thread safe. */
+int remove_cexthash(cexthash_t *htable, cexthash_node_t * node);
+
+/* function: removenodes_cexthash
+ * Removes all nodes from the hash table.
+ * For every removed node <typeadapt_lifetime_it.delete_object> is called.
+ * This function is not thread safe. */
+int removenodes_cexthash(cexthash_t *htable);
+
+// group: generic
+
+/* define: cexthash_IMPLEMENT
+ * Adapts interface of <cexthash_t> to nodes of type object_t.
+ * The generated wrapper functions has the suffix _fsuffix which is provided as first parameter.
+ * They are defined as static inline.
+ *
+ * Parameter:
+ * _fsuffix  - The suffix name of all generated tree interface functions, e.g. "init##_fsuffix".
+ * object_t  - The type of object which can be stored and retrieved from this table.
+ *             The object must contain a field of type <cexthash_node_t>.
+ * key_t     - The type of key the objects are sorted by.
+ * nodename  - The access path of the field <cexthash_node_t> in type object_t. */
+void cexthash_IMPLEMENT(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename);
+
+// group: test
+
+/* function: invariant_cexthash
+ * Checks that every bucket points to a correct red black tree. */
+int invariant_cexthash(const cexthash_t *htable);
+
+
+// section: inline implementation
+
+/* define: free_cexthashiterator
+ * Implements <cexthash_iterator_t.free_cexthashiterator>. */
+#define free_cexthashiterator(iter)    ((iter)->next = 0, 0)
+
+/* define: isempty_cexthash
+ * Implements <cexthash_t.isempty_cexthash>. */
+#define isempty_cexthash(htable)       (0 == ((htable)->nr_nodes))
+
+/* define: nrelements_cexthash
+ * Implements <cexthash_t.nrelements_cexthash>. */
+#define nrelements_cexthash(htable)    ((htable)->nr_nodes)
+
+/* define: cexthash_IMPLEMENT
+ * Implements <cexthash_t.cexthash_IMPLEMENT>. */
+#define cexthash_IMPLEMENT(_fsuffix, object_t, key_t, nodename)  \
+   typedef cexthash_iterator_t iteratortype##_fsuffix;         \
+   typedef object_t         *  iteratedtype##_fsuffix;         \
+   static inline cexthash_node_t * cast2node##_fsuffix(object_t * object) { \
+      static_assert(&((object_t*)0)->nodename == (cexthash_node_t*)offsetof(object_t, nodename), "correct type"); \
+      return (cexthash_node_t *) ((uintptr_t)object + offsetof(object_t, nodename)); \
+   } \
+   static inline object_t * cast2object##_fsuffix(cexthash_node_t * node) { \
+      return (object_t *) ((uintptr_t)node - offsetof(object_t, nodename)); \
+   } \
+   static inline int init##_fsuffix(/*out*/cexthash_t *htable, size_t initial_size, size_t max_size, const typeadapt_member_t * nodeadp) { \
+      return init_cexthash(htable, initial_size, max_size, nodeadp); \
+   } \
+   static inline int  free##_fsuffix(cexthash_t *htable) { \
+      return free_cexthash(htable); \
+   } \
+   static inline bool isempty##_fsuffix(const cexthash_t *htable) { \
+      return isempty_cexthash(htable); \
+   } \
+   static inline size_t nrelements##_fsuffix(const cexthash_t *htable) { \
+      return nrelements_cexthash(htable); \
+   } \
+   static inline int  find##_fsuffix(cexthash_t *htable, const key_t key, /*out*/object_t ** found_node) { \
+      int err = find_cexthash(htable, (void*)key, (cexthash_node_t**)found_node); \
+      if (err == 0) *found_node = cast2object##_fsuffix(*(cexthash_node_t**)found_node); \
+      return err; \
+   } \
+   static inline int  insert##_fsuffix(cexthash_t *htable, object_t * new_node) { \
+      return insert_cexthash(htable, cast2node##_fsuffix(new_node)); \
+   } \
+   static inline int  remove##_fsuffix(cexthash_t *htable, object_t * node) { \
+      int err = remove_cexthash(htable, cast2node##_fsuffix(node)); \
+      return err; \
+   } \
+   static inline int  removenodes##_fsuffix(cexthash_t *htable) { \
+      return removenodes_cexthash(htable); \
+   } \
+   static inline int  invariant##_fsuffix(cexthash_t *htable) { \
+      return invariant_cexthash(htable); \
+   } \
+   static inline int  initfirst##_fsuffix##iterator(cexthash_iterator_t *iter, cexthash_t *htable) { \
+      return initfirst_cexthashiterator(iter, htable); \
+   } \
+   static inline int  free##_fsuffix##iterator(cexthash_iterator_t *iter) { \
+      return free_cexthashiterator(iter); \
+   } \
+   static inline bool next##_fsuffix##iterator(cexthash_iterator_t *iter, object_t ** node) { \
+      bool isNext = next_cexthashiterator(iter, (cexthash_node_t**)node); \
+      if (isNext) *node = cast2object##_fsuffix(*(cexthash_node_t**)node); \
+      return isNext; \
+   }
+
+#endif
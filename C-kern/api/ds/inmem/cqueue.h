@@ -0,0 +1,370 @@
+/* title: Concurrent-Queue
+
+   Offers FIFO queues for passing nodes between threads without locks.
+
+   <spscqueue_t> supports a single producer and a single consumer thread.
+   <mpscqueue_t> supports many producer threads and a single consumer thread.
+
+   Both queues store nodes on memory pages with the same format as <queue_t>
+   (see <queue_page_t>). Pages are allocated with <ALLOC_PAGECACHE>
+   by a producer and released by the consumer after all nodes have been read.
+
+   Page Ownership:
+   A page is always owned by the page cache of the thread which allocated it.
+   The consumer releases pages remotely into the cache of their owner.
+   Therefore a producer thread must not exit before the queue is freed
+   or all pages allocated by it have been released.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/cqueue.h
+    Header file <Concurrent-Queue>.
+
+   file: C-kern/ds/inmem/cqueue.c
+    Implementation file <Concurrent-Queue impl>.
+*/
+#ifndef CKERN_DS_INMEM_CQUEUE_HEADER
+#define CKERN_DS_INMEM_CQUEUE_HEADER
+
+#include "C-kern/api/ds/inmem/queue.h"
+
+// forward
+struct perftest_info_t;
+
+// === exported types
+struct spscqueue_t;
+struct mpscqueue_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_inmem_cqueue
+ * Test <spscqueue_t> and <mpscqueue_t> functionality. */
+int unittest_ds_inmem_cqueue(void);
+#endif
+
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_cqueue_spsc
+ * Test throughput of <spscqueue_t>. */
+int perftest_ds_inmem_cqueue_spsc(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_cqueue_mpsc
+ * Test throughput of <mpscqueue_t>. */
+int perftest_ds_inmem_cqueue_mpsc(/*out*/struct perftest_info_t* info);
+#endif
+
+// group: configuration
+
+/* define: cqueue_CACHELINESIZE
+ * Size in bytes of a cache line. Fields written by the consumer and fields written
+ * by the producer are stored in different cache lines. */
+#define cqueue_CACHELINESIZE 64
+
+
+/* struct: spscqueue_t
+ * Lock-free FIFO queue for a single producer and a single consumer thread.
+ *
+ * Producer:
+ * The producer reserves space for one or more nodes with <insert_spscqueue>
+ * and fills them. A call to <commit_spscqueue> makes all inserted nodes visible
+ * to the consumer at once (batch enqueue).
+ *
+ * Consumer:
+ * The consumer reads all visible nodes of the first page with <firstbatch_spscqueue>
+ * (batch dequeue) or a single node with <first_spscqueue>. Read nodes are
+ * removed with <removefirst_spscqueue>.
+ *
+ * Page Format:
+ * Every page starts with a <queue_page_t> header. <queue_page_t.end_offset> is the
+ * published write index of the producer. The read index of the consumer is stored
+ * in <readoff> and never written into the page. <queue_page_t.next> links a page
+ * to its successor. It is set only after all nodes of the page are published.
+ * <queue_page_t.prev> links a page to its predecessor and is only used by the producer.
+ * <queue_page_t.queue> is unused and set to 0.
+ *
+ * Cache Lines:
+ * The read index (consumer), the write index (producer) and the shared spare page
+ * are stored in separate cache lines. The consumer caches the last read write index
+ * in <readend> and reads the shared value only if it has consumed all cached nodes.
+ * */
+typedef struct spscqueue_t {
+   // group: consumer fields
+   /* variable: first
+    * The page the consumer reads from. */
+   queue_page_t * first;
+   /* variable: readoff
+    * Offset of the first unread byte in <first>. */
+   uint16_t       readoff;
+   /* variable: readend
+    * Cached value of first->end_offset. */
+   uint16_t       readend;
+   // group: producer fields
+   /* variable: last
+    * The page the producer writes to. */
+   queue_page_t * last __attribute__ ((aligned (cqueue_CACHELINESIZE)));
+   /* variable: published
+    * The last page which is reachable by the consumer. */
+   queue_page_t * published;
+   /* variable: lastend
+    * Offset of first unused byte in <last>. Not yet published. */
+   uint16_t       lastend;
+   /* variable: publishedend
+    * Offset of first unused byte in <published> if <last> != <published>. Not yet published. */
+   uint16_t       publishedend;
+   // group: shared fields
+   /* variable: spare
+    * A page released by the consumer which is reused by the producer. */
+   queue_page_t * spare __attribute__ ((aligned (cqueue_CACHELINESIZE)));
+   /* variable: pagesize
+    * Encodes size in bytes of a page as <pagesize_e>. */
+   uint8_t        pagesize;
+} spscqueue_t;
+
+// group: lifetime
+
+/* define: spscqueue_FREE
+ * Static initializer. */
+#define spscqueue_FREE \
+         { 0, 0, 0, 0, 0, 0, 0, 0, 0 }
+
+/* function: init_spscqueue
+ * Initializes queue and allocates the first page.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - pagesize not in [256, 1024, 4096, 16384]
+ * ENOMEM - No memory for the first page. */
+int init_spscqueue(/*out*/spscqueue_t * queue, size_t pagesize);
+
+/* function: free_spscqueue
+ * Frees all pages even if they contain nodes.
+ * Producer and consumer must not access the queue concurrently. */
+int free_spscqueue(spscqueue_t * queue);
+
+// group: query
+
+/* function: isfree_spscqueue
+ * Returns true if queue equals <spscqueue_FREE>. */
+bool isfree_spscqueue(const spscqueue_t * queue);
+
+/* function: pagesize_spscqueue
+ * Returns size in bytes of a memory page. */
+uint16_t pagesize_spscqueue(const spscqueue_t * queue);
+
+// group: producer
+
+/* function: insert_spscqueue
+ * Reserves nodesize bytes and returns its start address in nodeaddr.
+ * The node is invisible to the consumer until <commit_spscqueue> is called.
+ * If the last page does not have nodesize bytes free a new page is allocated.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - nodesize is 0 or greater than <maxelemsize_queue>(<pagesize_spscqueue>).
+ * ENOMEM - No memory for a new page. */
+int insert_spscqueue(spscqueue_t * queue, uint16_t nodesize, /*out*/void ** nodeaddr);
+
+/* function: commit_spscqueue
+ * Makes all nodes inserted since the last call visible to the consumer.
+ * This function contains a release memory barrier. */
+void commit_spscqueue(spscqueue_t * queue);
+
+// group: consumer
+
+/* function: firstbatch_spscqueue
+ * Returns address and size in bytes of all committed and unread nodes of the first page.
+ * A completely read page is released before the next page is returned.
+ *
+ * Returns:
+ * 0       - Success. size is greater than 0.
+ * ENODATA - The queue contains no committed nodes. */
+int firstbatch_spscqueue(spscqueue_t * queue, /*out*/void ** nodes, /*out*/size_t * size);
+
+/* function: first_spscqueue
+ * Returns the address of the first committed and unread node of size nodesize.
+ *
+ * Returns:
+ * 0       - Success.
+ * ENODATA - The queue contains no committed nodes or less than nodesize bytes. */
+int first_spscqueue(spscqueue_t * queue, uint16_t nodesize, /*out*/void ** node);
+
+/* function: removefirst_spscqueue
+ * Removes size bytes from the first page.
+ * Call <firstbatch_spscqueue> or <first_spscqueue> before to make sure
+ * that at least size bytes are returned from the first page.
+ *
+ * Returns:
+ * 0         - Success.
+ * EOVERFLOW - The first page contains less than size bytes returned by the last call to
+ *             <firstbatch_spscqueue> or <first_spscqueue>. Nothing is removed. */
+int removefirst_spscqueue(spscqueue_t * queue, size_t size);
+
+
+/* struct: mpscqueue_t
+ * Lock-free FIFO queue for many producers and a single consumer thread.
+ *
+ * Producer:
+ * A producer reserves a record of nodesize bytes with <insert_mpscqueue>, fills it
+ * and makes it visible with <commit_mpscqueue>. To enqueue a batch of nodes
+ * insert a single record which is large enough to hold all of them.
+ * Records are returned to the consumer in the order of their reservation.
+ * The consumer waits at an uncommitted record until it is committed.
+ *
+ * Consumer:
+ * The consumer reads the next committed record with <first_mpscqueue>
+ * and removes it with <removefirst_mpscqueue>.
+ *
+ * Page Format:
+ * Every page starts with a <queue_page_t> header. <queue_page_t.end_offset>
+ * is the reservation index which is increased by producers with compare and swap.
+ * A full page is closed by setting it to 0xFFFF. Every record starts with a header of 8 bytes
+ * which contains the committed record size. Unused parts of a page are zero.
+ * <queue_page_t.next> links a page to its successor. <queue_page_t.prev> links
+ * consumed pages which could not be released yet. <queue_page_t.queue> is unused and set to 0.
+ *
+ * Page Reclamation:
+ * A producer could still access a page which the consumer has read completely.
+ * The number of producers which execute <insert_mpscqueue> is counted in <nrproducer>.
+ * A read page is released only if no producer is active and it is not the last page.
+ * Else it is kept in list <retired> and released later.
+ * */
+typedef struct mpscqueue_t {
+   // group: consumer fields
+   /* variable: first
+    * The page the consumer reads from. */
+   queue_page_t * first;
+   /* variable: retired
+    * List of read pages linked with <queue_page_t.prev>. They are released if no producer accesses them. */
+   queue_page_t * retired;
+   /* variable: readoff
+    * Offset of the next unread record in <first>. */
+   uint16_t       readoff;
+   // group: producer fields
+   /* variable: last
+    * The page producers reserve records on. */
+   queue_page_t * last __attribute__ ((aligned (cqueue_CACHELINESIZE)));
+   /* variable: nrproducer
+    * Number of producers which execute <insert_mpscqueue>. */
+   int            nrproducer;
+   // group: shared fields
+   /* variable: spare
+    * A page released by the consumer which is reused by the producer. */
+   queue_page_t * spare __attribute__ ((aligned (cqueue_CACHELINESIZE)));
+   /* variable: pagesize
+    * Encodes size in bytes of a page as <pagesize_e>. */
+   uint8_t        pagesize;
+} mpscqueue_t;
+
+// group: lifetime
+
+/* define: mpscqueue_FREE
+ * Static initializer. */
+#define mpscqueue_FREE \
+         { 0, 0, 0, 0, 0, 0, 0 }
+
+/* function: init_mpscqueue
+ * Initializes queue and allocates the first page.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - pagesize not in [256, 1024, 4096, 16384]
+ * ENOMEM - No memory for the first page. */
+int init_mpscqueue(/*out*/mpscqueue_t * queue, size_t pagesize);
+
+/* function: free_mpscqueue
+ * Frees all pages even if they contain records.
+ * Producers and consumer must not access the queue concurrently. */
+int free_mpscqueue(mpscqueue_t * queue);
+
+// group: query
+
+/* function: isfree_mpscqueue
+ * Returns true if queue equals <mpscqueue_FREE>. */
+bool isfree_mpscqueue(const mpscqueue_t * queue);
+
+/* function: pagesize_mpscqueue
+ * Returns size in bytes of a memory page. */
+uint16_t pagesize_mpscqueue(const mpscqueue_t * queue);
+
+/* function: maxnodesize_mpscqueue
+ * Returns the maximum size of a record supported by <insert_mpscqueue>. */
+uint16_t maxnodesize_mpscqueue(const mpscqueue_t * queue);
+
+// group: producer
+
+/* function: insert_mpscqueue
+ * Reserves a record of nodesize bytes and returns its start address in nodeaddr.
+ * The address is aligned to 8 bytes. The record is invisible to the consumer
+ * until <commit_mpscqueue> is called with the returned nodeaddr.
+ * Could be called concurrently by many threads.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - nodesize is 0 or greater than <maxnodesize_mpscqueue>.
+ * ENOMEM - No memory for a new page. */
+int insert_mpscqueue(mpscqueue_t * queue, uint16_t nodesize, /*out*/void ** nodeaddr);
+
+/* function: commit_mpscqueue
+ * Makes the record starting at nodeaddr visible to the consumer.
+ * The value nodeaddr must be returned from a previous call to <insert_mpscqueue>.
+ * This function contains a release memory barrier. */
+void commit_mpscqueue(mpscqueue_t * queue, void * nodeaddr);
+
+// group: consumer
+
+/* function: first_mpscqueue
+ * Returns address and size of the first unread record.
+ * A completely read page is released (or retired) before the next page is read.
+ *
+ * Returns:
+ * 0       - Success.
+ * ENODATA - The queue is empty or the first record is not committed yet. */
+int first_mpscqueue(mpscqueue_t * queue, /*out*/void ** node, /*out*/uint16_t * nodesize);
+
+/* function: removefirst_mpscqueue
+ * Removes the first record. Call <first_mpscqueue> before.
+ *
+ * Returns:
+ * 0       - Success.
+ * ENODATA - The first record is not committed or the page is read completely.
+ *           Call <first_mpscqueue> before. */
+int removefirst_mpscqueue(mpscqueue_t * queue);
+
+
+
+// section: inline implementation
+
+// group: spscqueue_t
+
+/* define: isfree_spscqueue
+ * Implements <spscqueue_t.isfree_spscqueue>. */
+#define isfree_spscqueue(queue) \
+         (0 == (queue)->first && 0 == (queue)->last && 0 == (queue)->spare)
+
+/* define: pagesize_spscqueue
+ * Implements <spscqueue_t.pagesize_spscqueue>. */
+#define pagesize_spscqueue(queue) \
+         ((uint16_t)(256u << (queue)->pagesize))
+
+// group: mpscqueue_t
+
+/* define: isfree_mpscqueue
+ * Implements <mpscqueue_t.isfree_mpscqueue>. */
+#define isfree_mpscqueue(queue) \
+         (0 == (queue)->first && 0 == (queue)->last && 0 == (queue)->spare)
+
+/* define: maxnodesize_mpscqueue
+ * Implements <mpscqueue_t.maxnodesize_mpscqueue>. */
+#define maxnodesize_mpscqueue(queue) \
+         ((uint16_t)(pagesize_mpscqueue(queue) - sizeof(queue_page_t) - 8))
+
+/* define: pagesize_mpscqueue
+ * Implements <mpscqueue_t.pagesize_mpscqueue>. */
+#define pagesize_mpscqueue(queue) \
+         ((uint16_t)(256u << (queue)->pagesize))
+
+#endif
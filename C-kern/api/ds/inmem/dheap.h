@@ -0,0 +1,242 @@
+/* title: DHeap
+
+   Implements an addressable d-ary heap (priority queue) of intrusive nodes.
+
+   In contrast to <heap_t> which copies elements into a fixed size array
+   this heap stores pointers to nodes of type <dheap_node_t>. Every node
+   knows its current position in the heap. The node therefore serves as
+   stable handle which allows to remove an arbitrary node or to restore
+   the heap condition after the key of a node has been changed
+   in O(log n).
+
+   Every inner node has <dheap_ARITY> (4) children. The tree is therefore
+   only half as high as a binary heap. The children of a node are stored
+   consecutively in the same cache line which reduces cache misses during
+   remove operations.
+
+   Usage:
+   Timer and scheduler queues which must cancel entries
+   or change their priority.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/dheap.h
+    Header file <DHeap>.
+
+   file: C-kern/ds/inmem/dheap.c
+    Implementation file <DHeap impl>.
+*/
+#ifndef CKERN_DS_INMEM_DHEAP_HEADER
+#define CKERN_DS_INMEM_DHEAP_HEADER
+
+#include "C-kern/api/ds/inmem/node/dheap_node.h"
+
+// forward
+struct perftest_info_t;
+
+/* typedef: struct dheap_t
+ * Export <dheap_t> into global namespace. */
+typedef struct dheap_t dheap_t;
+
+/* typedef: dheap_compare_f
+ * Define compare function for nodes stored on the heap.
+ * The first parameter cmpstate is a variable which
+ * points to additional shared compare state beyond
+ * the two nodes left and right.
+ *
+ * Returns:
+ * The returned values -1 or +1 stand for any negative
+ * or positive number.
+ * -1 - left  < right
+ *  0 - left == right
+ * +1 - left  > right
+ */
+typedef int (*dheap_compare_f) (void * cmpstate, const dheap_node_t * left, const dheap_node_t * right);
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_inmem_dheap
+ * Test <dheap_t> functionality. */
+int unittest_ds_inmem_dheap(void);
+#endif
+
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_dheap
+ * Test priority queue performance of <dheap_t>. */
+int perftest_ds_inmem_dheap(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_dheap_heap
+ * Test priority queue performance of <heap_t> for comparison. */
+int perftest_ds_inmem_dheap_heap(/*out*/struct perftest_info_t* info);
+#endif
+
+
+/* struct: dheap_t
+ * Manages pointers to nodes with the highest priority node stored at index 0.
+ *
+ * (Max) Heap Condition:
+ * For every node at index i > 0 the following holds:
+ * > cmp(cmpstate, array[(i-1)/dheap_ARITY], array[i]) >= 0
+ * The children of the node at index i are stored at index
+ * dheap_ARITY*i+1 ... dheap_ARITY*i+dheap_ARITY.
+ *
+ * Memory Alignment:
+ * The array is aligned in such a way that all children
+ * of a node are located in the same cache line of 64 bytes.
+ *
+ * Ownership:
+ * The heap does not own the nodes. Freeing the heap does not
+ * free the stored nodes. */
+struct dheap_t {
+   // group: private fields
+   /* variable: cmp
+    * The function pointer pointing to the comparison function (see <dheap_compare_f>). */
+   dheap_compare_f cmp;
+   /* variable: cmpstate
+    * Additional state given as first parameter to the comparison function. */
+   void          * cmpstate;
+   /* variable: array
+    * Points to array of stored nodes. The address of array[1] is aligned to 64 bytes. */
+   dheap_node_t ** array;
+   /* variable: nrofelem
+    * The number of nodes stored in <array>. */
+   size_t          nrofelem;
+   /* variable: capacity
+    * The maximum number of nodes which could be stored in <array> before it is resized. */
+   size_t          capacity;
+   /* variable: mem
+    * Start address of allocated memory which contains <array>. */
+   void          * mem;
+   /* variable: memsize
+    * Size in bytes of allocated memory starting at <mem>. */
+   size_t          memsize;
+};
+
+// group: configuration
+
+/* define: dheap_ARITY
+ * The number of children of every inner node. */
+#define dheap_ARITY 4
+
+// group: lifetime
+
+/* define: dheap_FREE
+ * Static initializer. */
+#define dheap_FREE \
+         { 0, 0, 0, 0, 0, 0, 0 }
+
+/* function: init_dheap
+ * Initializes an empty heap.
+ * Memory for capacity nodes is preallocated. If capacity is 0 memory is allocated
+ * during the first call to <insert_dheap>.
+ * The parameter cmp is the comparison function to compare nodes according their priority.
+ * cmpstate is an additional value passed through as first parameter to the compare function. */
+int init_dheap(/*out*/dheap_t * heap, size_t capacity, dheap_compare_f cmp, void * cmpstate);
+
+/* function: free_dheap
+ * Frees allocated memory. Stored nodes are not freed. */
+int free_dheap(dheap_t * heap);
+
+// group: query
+
+/* function: nrofelem_dheap
+ * Returns the number of nodes currently stored on the heap. */
+size_t nrofelem_dheap(const dheap_t * heap);
+
+/* function: capacity_dheap
+ * Returns the number of nodes which could be stored before memory is reallocated. */
+size_t capacity_dheap(const dheap_t * heap);
+
+/* function: top_dheap
+ * Returns the node with the highest priority or 0 if the heap is empty.
+ * The node is not removed. */
+dheap_node_t * top_dheap(const dheap_t * heap);
+
+/* function: invariant_dheap
+ * Checks the heap condition and that every node stores its correct index.
+ * Returns EINVARIANT in case of an error. */
+int invariant_dheap(const dheap_t * heap);
+
+// group: update
+
+/* function: insert_dheap
+ * Inserts node into the heap.
+ * The value returned by <nrofelem_dheap> is incremented in case of success.
+ * The array is doubled in size if it is full.
+ *
+ * Time O(log n). */
+int insert_dheap(dheap_t * heap, dheap_node_t * node);
+
+/* function: remove_dheap
+ * Removes the node with the highest priority and returns it in node.
+ * Equal nodes could be returned in any order.
+ * Returns ENODATA in case <nrofelem_dheap> is already 0 and this
+ * error is not logged into the error log.
+ *
+ * Time O(log n). */
+int remove_dheap(dheap_t * heap, /*out*/dheap_node_t ** node);
+
+/* function: removenode_dheap
+ * Removes node from the heap. The node could be stored at any position.
+ * Returns EINVAL if node is not stored in heap.
+ *
+ * Time O(log n). */
+int removenode_dheap(dheap_t * heap, dheap_node_t * node);
+
+/* function: increasekey_dheap
+ * Restores the heap condition after the key of node has been increased.
+ * A node with an increased key has a higher priority and moves in direction of the top.
+ * Returns EINVAL if node is not stored in heap.
+ *
+ * Time O(log n). */
+int increasekey_dheap(dheap_t * heap, dheap_node_t * node);
+
+/* function: decreasekey_dheap
+ * Restores the heap condition after the key of node has been decreased.
+ * A node with a decreased key has a lower priority and moves in direction of the leaves.
+ * Returns EINVAL if node is not stored in heap.
+ *
+ * A min-heap, e.g. a timer queue with the earliest expiration time at the top,
+ * is implemented with an inverted comparison function. A decreased expiration time
+ * is then an increased key and <increasekey_dheap> must be called.
+ *
+ * Time O(log n). */
+int decreasekey_dheap(dheap_t * heap, dheap_node_t * node);
+
+/* function: update_dheap
+ * Restores the heap condition after the key of node has been changed in any direction.
+ * Use this function if you do not know whether the key was increased or decreased.
+ * Returns EINVAL if node is not stored in heap.
+ *
+ * Time O(log n). */
+int update_dheap(dheap_t * heap, dheap_node_t * node);
+
+
+// section: inline implementation
+
+// group: dheap_t
+
+/* define: capacity_dheap
+ * Implements <dheap_t.capacity_dheap>. */
+#define capacity_dheap(heap) \
+         ((heap)->capacity)
+
+/* define: nrofelem_dheap
+ * Implements <dheap_t.nrofelem_dheap>. */
+#define nrofelem_dheap(heap) \
+         ((heap)->nrofelem)
+
+/* define: top_dheap
+ * Implements <dheap_t.top_dheap>. */
+#define top_dheap(heap) \
+         ( __extension__ ({                  \
+            const dheap_t * _h = (heap);     \
+            _h->nrofelem ? _h->array[0] : 0; \
+         }))
+
+#endif
@@ -20,6 +20,7 @@
 #include "C-kern/api/ds/inmem/node/dlist_node.h"
 
 // forward
+struct perftest_info_t;
 struct typeadapt_t;
 
 // === exported types
@@ -37,6 +38,20 @@ struct dlist_iterator_t;
 int unittest_ds_inmem_dlist(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_dlist_sequential
+ * Test insertlast, iterate and remove of 1M nodes in FIFO order. */
+int perftest_ds_inmem_dlist_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_dlist_random
+ * Test insertlast, iterate and remove of 1M nodes in random order. */
+int perftest_ds_inmem_dlist_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_dlist_small
+ * Test insertlast, iterate and remove of 1K nodes in random order repeated 1K times. */
+int perftest_ds_inmem_dlist_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: dlist_iterator_t
  * Iterates over elements contained in <dlist_t>.
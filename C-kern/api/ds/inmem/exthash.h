@@ -25,6 +25,10 @@
 // === exported types
 struct exthash_t;
 struct exthash_iterator_t;
+
+// forward
+struct perftest_info_t;
+
 /* typedef: struct exthash_node_t
  * Rename <lrptree_node_t> into <exthash_node_t>. */
 typedef struct lrptree_node_t  exthash_node_t;
@@ -40,6 +44,28 @@ typedef struct lrptree_node_t  exthash_node_t;
 int unittest_ds_inmem_exthash(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_exthash
+ * Test lookup performance of find##_fsuffix generated by <exthash_IMPLEMENT>. */
+int perftest_ds_inmem_exthash(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_exthash_cmp
+ * Test lookup performance of find##_fsuffix generated by <exthash_IMPLEMENTCMP>. */
+int perftest_ds_inmem_exthash_cmp(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_exthash_sequential
+ * Test insert, find, iterate and remove of 1M sequential keys. */
+int perftest_ds_inmem_exthash_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_exthash_random
+ * Test insert, find, iterate and remove of 1M random keys. */
+int perftest_ds_inmem_exthash_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_exthash_small
+ * Test insert, find, iterate and remove of 1K random keys repeated 1K times. */
+int perftest_ds_inmem_exthash_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: exthash_iterator_t
  * Iterates over elements contained in <exthash_t>.
@@ -213,6 +239,20 @@ int removenodes_exthash(exthash_t *htable);
  * nodename  - The access path of the field <exthash_node_t> in type object_t. */
 void exthash_IMPLEMENT(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename);
 
+/* define: exthash_IMPLEMENTCMP
+ * Same as <exthash_IMPLEMENT> except that the generated find##_fsuffix calls hashkey_f and cmpkeyobj_f directly.
+ * Computing the table index and searching the bucket tree is done without any indirect call.
+ * All other generated functions use the services of the <typeadapt_member_t> given in init##_fsuffix.
+ * The hash values and the order of its services must be the same as of hashkey_f and cmpkeyobj_f.
+ *
+ * Parameter:
+ * cmpkeyobj_f - Name of function or macro with signature
+ *               > int cmpkeyobj_f(const key_t key, const object_t * object)
+ *               It returns a value < 0, == 0 or > 0 if key is less, equal or greater than the key of object.
+ * hashkey_f   - Name of function or macro with signature
+ *               > size_t hashkey_f(const key_t key) */
+void exthash_IMPLEMENTCMP(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename, IDNAME cmpkeyobj_f, IDNAME hashkey_f);
+
 // group: test
 
 /* function: invariant_exthash
@@ -237,6 +277,44 @@ int invariant_exthash(const exthash_t *htable);
 /* define: exthash_IMPLEMENT
  * Implements <exthash_t.exthash_IMPLEMENT>. */
 #define exthash_IMPLEMENT(_fsuffix, object_t, key_t, nodename)  \
+   exthash_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename)  \
+   static inline int  find##_fsuffix(exthash_t *htable, const key_t key, /*out*/object_t ** found_node) { \
+      int err = find_exthash(htable, (void*)key, (exthash_node_t**)found_node); \
+      if (err == 0) *found_node = cast2object##_fsuffix(*(exthash_node_t**)found_node); \
+      return err; \
+   }
+
+/* define: exthash_IMPLEMENTCMP
+ * Implements <exthash_t.exthash_IMPLEMENTCMP>.
+ * A table entry with value (uintptr_t)-1 shares the tree of the entry at the next smaller level.
+ * Shifting the mask one bit to the right until a not shared entry is found
+ * yields the same index as find_exthash. Entry 0 is never shared. */
+#define exthash_IMPLEMENTCMP(_fsuffix, object_t, key_t, nodename, cmpkeyobj_f, hashkey_f)  \
+   exthash_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename)  \
+   static inline int  find##_fsuffix(exthash_t *htable, const key_t key, /*out*/object_t ** found_node) { \
+      size_t mask = ((size_t)1 << htable->level) - 1; \
+      size_t tabidx = (size_t)hashkey_f(key) & mask; \
+      exthash_node_t * node = htable->hashtable[tabidx]; \
+      while (0 == ~(uintptr_t)node) { \
+         mask >>= 1; \
+         tabidx &= mask; \
+         node = htable->hashtable[tabidx]; \
+      } \
+      while (node) { \
+         int cmp = cmpkeyobj_f(key, cast2object##_fsuffix(node)); \
+         if (cmp == 0) { \
+            *found_node = cast2object##_fsuffix(node); \
+            return 0; \
+         } \
+         node = cmp < 0 ? node->left : node->right; \
+      } \
+      return ESRCH; \
+   }
+
+/* define: exthash_IMPLEMENTBASE
+ * Generates all functions of <exthash_IMPLEMENT> except find##_fsuffix.
+ * Used by <exthash_IMPLEMENT> and <exthash_IMPLEMENTCMP>. */
+#define exthash_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename)  \
    typedef exthash_iterator_t  iteratortype##_fsuffix;         \
    typedef object_t         *  iteratedtype##_fsuffix;         \
    static inline exthash_node_t * cast2node##_fsuffix(object_t * object) { \
@@ -258,11 +336,6 @@ int invariant_exthash(const exthash_t *htable);
    static inline size_t nrelements##_fsuffix(const exthash_t *htable) { \
       return nrelements_exthash(htable); \
    } \
-   static inline int  find##_fsuffix(exthash_t *htable, const key_t key, /*out*/object_t ** found_node) { \
-      int err = find_exthash(htable, (void*)key, (exthash_node_t**)found_node); \
-      if (err == 0) *found_node = cast2object##_fsuffix(*(exthash_node_t**)found_node); \
-      return err; \
-   } \
    static inline int  insert##_fsuffix(exthash_t *htable, object_t * new_node) { \
       return insert_exthash(htable, cast2node##_fsuffix(new_node)); \
    } \
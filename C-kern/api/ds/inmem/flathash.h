@@ -0,0 +1,315 @@
+/* title: Flat-Hashing
+
+   Offers a container which organizes stored nodes as an open addressing hash table.
+   The table stores pointers to nodes in a single flat array and probes
+   a group of 16 slots at once.
+
+   Precondition:
+   1. - include "C-kern/api/ds/typeadapt.h" before including this file.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/flathash.h
+    Header file <Flat-Hashing>.
+
+   file: C-kern/ds/inmem/flathash.c
+    Implementation file <Flat-Hashing impl>.
+*/
+#ifndef CKERN_DS_INMEM_FLATHASH_HEADER
+#define CKERN_DS_INMEM_FLATHASH_HEADER
+
+// forward
+struct perftest_info_t;
+
+// === exported types
+struct flathash_t;
+struct flathash_node_t;
+struct flathash_iterator_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_inmem_flathash
+ * Test <flathash_t> functionality. */
+int unittest_ds_inmem_flathash(void);
+#endif
+
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_flathash
+ * Test lookup performance of <flathash_t>. */
+int perftest_ds_inmem_flathash(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_flathash_exthash
+ * Test lookup performance of <exthash_t> for comparison. */
+int perftest_ds_inmem_flathash_exthash(/*out*/struct perftest_info_t* info);
+#endif
+
+
+/* struct: flathash_node_t
+ * Node which must be embedded into every object stored in <flathash_t>.
+ * The hash value of the object is computed only once during <insert_flathash> and stored in the node.
+ * Growing the table needs therefore not to call <typeadapt_gethash_it.hashobject>. */
+typedef struct flathash_node_t {
+   /* variable: hashvalue
+    * Cached hash value of the object. */
+   size_t   hashvalue;
+} flathash_node_t;
+
+// group: lifetime
+
+/* define: flathash_node_INIT
+ * Static initializer. */
+#define flathash_node_INIT { 0 }
+
+
+/* struct: flathash_iterator_t
+ * Iterates over elements contained in <flathash_t>.
+ * The iterator supports removing or deleting of the current node.
+ * Inserting nodes while iterating is not supported.
+ * > flathash_t htable;
+ * > fill_table(&htable);
+ * > foreach (_flathash, node, &htable) {
+ * >    if (need_to_remove(node)) {
+ * >       err = remove_flathash(&htable, node));
+ * >    }
+ * > }
+ * */
+typedef struct flathash_iterator_t {
+   struct flathash_t *htable;
+   size_t             index;
+} flathash_iterator_t;
+
+// group: lifetime
+
+/* define: flathash_iterator_FREE
+ * Static initializer. */
+#define flathash_iterator_FREE { 0, 0 }
+
+/* function: initfirst_flathashiterator
+ * Initializes an iterator for <flathash_t>. */
+int initfirst_flathashiterator(/*out*/flathash_iterator_t *iter, struct flathash_t *htable);
+
+/* function: free_flathashiterator
+ * Frees an iterator of <flathash_t>. */
+int free_flathashiterator(flathash_iterator_t *iter);
+
+// group: iterate
+
+/* function: next_flathashiterator
+ * Returns next node of htable not sorted in any order.
+ * In case no next node exists false is returned and parameter node is not changed. */
+bool next_flathashiterator(flathash_iterator_t *iter, /*out*/flathash_node_t ** node);
+
+
+/* struct: flathash_t
+ * Implements an open addressing hash table which stores pointers to nodes.
+ *
+ * Every slot in <slot> has an associated control byte in <ctrl>.
+ * A control byte is either <flathash_EMPTY>, <flathash_DELETED> or contains the 7 lowest bits (h2)
+ * of the mixed hash value of the stored node. The remaining bits (h1) select the first slot which is probed.
+ * A lookup compares h2 with a group of 16 control bytes with a single SSE2 instruction (if supported).
+ * Only slots whose control byte matches are compared with the searched key.
+ * A lookup ends if the group contains an empty slot.
+ *
+ * The table grows if more than 7/8 of the slots are in use (stored or deleted).
+ * The memory for nodes is allocated by the user of the container.
+ *
+ * typeadapt_t:
+ * The service delete_object of <typeadapt_t.lifetime> is used in <free_flathash> and <removenodes_flathash>.
+ * The service cmp_key_object of <typeadapt_t.comparator> is used in <find_flathash>.
+ * The service cmp_object of <typeadapt_t.comparator> is used in <insert_flathash>.
+ * The service hashobject of <typeadapt_t.gethash> is used in <insert_flathash>.
+ * The service hashkey of <typeadapt_t.gethash> is used in <find_flathash>.
+ * */
+typedef struct flathash_t {
+   /* variable: slot
+    * Array of <capacity> pointers to stored nodes. */
+   flathash_node_t   ** slot;
+   /* variable: ctrl
+    * Array of <capacity> + 16 control bytes. The last 16 bytes mirror the first 16 bytes
+    * so that a group of 16 bytes could be loaded beginning from every slot without wrapping around. */
+   uint8_t            * ctrl;
+   /* variable: capacity
+    * Number of slots. A power of two and at least 16. */
+   size_t               capacity;
+   /* variable: nr_nodes
+    * The number of stored nodes in the hash table. */
+   size_t               nr_nodes;
+   /* variable: growthleft
+    * Number of <flathash_EMPTY> slots which could be used before the table must grow. */
+   size_t               growthleft;
+   /* variable: nodeadp
+    * Offers lifetime + keycomparator + gethash services to handle stored nodes. */
+   typeadapt_member_t   nodeadp;
+} flathash_t;
+
+// group: config
+
+/* define: flathash_EMPTY
+ * Control byte of an unused slot. */
+#define flathash_EMPTY     0x80
+
+/* define: flathash_DELETED
+ * Control byte of a slot whose node has been removed. Lookups continue probing after such a slot. */
+#define flathash_DELETED   0xfe
+
+/* define: flathash_GROUPSIZE
+ * Number of control bytes compared in one step. */
+#define flathash_GROUPSIZE 16
+
+// group: lifetime
+
+/* define: flathash_FREE
+ * Static initializer. Makes calling <free_flathash> safe. */
+#define flathash_FREE \
+         { 0, 0, 0, 0, 0, typeadapt_member_FREE }
+
+/* function: init_flathash
+ * Allocates a hash table which could store at least initial_size nodes without growing.
+ * The capacity is at least <flathash_GROUPSIZE>. */
+int init_flathash(/*out*/flathash_t *htable, size_t initial_size, const typeadapt_member_t * nodeadp);
+
+/* function: free_flathash
+ * Calls <removenodes_flathash> and frees the hash table memory. */
+int free_flathash(flathash_t *htable);
+
+// group: query
+
+/* function: isempty_flathash
+ * Returns true if the table contains no element. */
+bool isempty_flathash(const flathash_t *htable);
+
+/* function: nrelements_flathash
+ * Returns the nr of elements stored in the hash table. */
+size_t nrelements_flathash(const flathash_t *htable);
+
+// group: foreach-support
+
+/* typedef: iteratortype_flathash
+ * Declaration to associate <flathash_iterator_t> with <flathash_t>. */
+typedef flathash_iterator_t      iteratortype_flathash;
+
+/* typedef: iteratedtype_flathash
+ * Declaration to associate <flathash_node_t> with <flathash_t>. */
+typedef flathash_node_t       *  iteratedtype_flathash;
+
+// group: search
+
+/* function: find_flathash
+ * Searches for a node with equal key.
+ * If it exists it is returned in found_node else ESRCH is returned. */
+int find_flathash(flathash_t *htable, const void * key, /*out*/flathash_node_t ** found_node);
+
+// group: change
+
+/* function: insert_flathash
+ * Inserts a new node into the hash table if it is unique.
+ * If another node exists with the same key as *new_node* nothing is inserted and the function returns EEXIST.
+ * The caller has to allocate the new node and has to transfer ownership.
+ * The table grows if necessary. */
+int insert_flathash(flathash_t *htable, flathash_node_t * new_node);
+
+/* function: remove_flathash
+ * Removes a node from the hash table. If the node is not part of the table ESRCH is returned.
+ * The ownership of the removed node is transfered back to the caller. */
+int remove_flathash(flathash_t *htable, flathash_node_t * node);
+
+/* function: removenodes_flathash
+ * Removes all nodes from the hash table.
+ * For every removed node <typeadapt_lifetime_it.delete_object> is called. */
+int removenodes_flathash(flathash_t *htable);
+
+// group: generic
+
+/* define: flathash_IMPLEMENT
+ * Adapts interface of <flathash_t> to nodes of type object_t.
+ * The generated wrapper functions has the suffix _fsuffix which is provided as first parameter.
+ * They are defined as static inline.
+ *
+ * Parameter:
+ * _fsuffix  - The suffix name of all generated table interface functions, e.g. "init##_fsuffix".
+ * object_t  - The type of object which can be stored and retrieved from this table.
+ *             The object must contain a field of type <flathash_node_t>.
+ * key_t     - The type of key the objects are hashed by.
+ * nodename  - The access path of the field <flathash_node_t> in type object_t. */
+void flathash_IMPLEMENT(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename);
+
+// group: test
+
+/* function: invariant_flathash
+ * Checks that every stored node is found and that the control bytes are consistent. */
+int invariant_flathash(flathash_t *htable);
+
+
+// section: inline implementation
+
+/* define: free_flathashiterator
+ * Implements <flathash_iterator_t.free_flathashiterator>. */
+#define free_flathashiterator(iter)    ((iter)->htable = 0, 0)
+
+/* define: isempty_flathash
+ * Implements <flathash_t.isempty_flathash>. */
+#define isempty_flathash(htable)       (0 == ((htable)->nr_nodes))
+
+/* define: nrelements_flathash
+ * Implements <flathash_t.nrelements_flathash>. */
+#define nrelements_flathash(htable)    ((htable)->nr_nodes)
+
+/* define: flathash_IMPLEMENT
+ * Implements <flathash_t.flathash_IMPLEMENT>. */
+#define flathash_IMPLEMENT(_fsuffix, object_t, key_t, nodename)  \
+   typedef flathash_iterator_t iteratortype##_fsuffix;         \
+   typedef object_t         *  iteratedtype##_fsuffix;         \
+   static inline flathash_node_t * cast2node##_fsuffix(object_t * object) { \
+      static_assert(&((object_t*)0)->nodename == (flathash_node_t*)offsetof(object_t, nodename), "correct type"); \
+      return (flathash_node_t *) ((uintptr_t)object + offsetof(object_t, nodename)); \
+   } \
+   static inline object_t * cast2object##_fsuffix(flathash_node_t * node) { \
+      return (object_t *) ((uintptr_t)node - offsetof(object_t, nodename)); \
+   } \
+   static inline int init##_fsuffix(/*out*/flathash_t *htable, size_t initial_size, const typeadapt_member_t * nodeadp) { \
+      return init_flathash(htable, initial_size, nodeadp); \
+   } \
+   static inline int  free##_fsuffix(flathash_t *htable) { \
+      return free_flathash(htable); \
+   } \
+   static inline bool isempty##_fsuffix(const flathash_t *htable) { \
+      return isempty_flathash(htable); \
+   } \
+   static inline size_t nrelements##_fsuffix(const flathash_t *htable) { \
+      return nrelements_flathash(htable); \
+   } \
+   static inline int  find##_fsuffix(flathash_t *htable, const key_t key, /*out*/object_t ** found_node) { \
+      int err = find_flathash(htable, (void*)key, (flathash_node_t**)found_node); \
+      if (err == 0) *found_node = cast2object##_fsuffix(*(flathash_node_t**)found_node); \
+      return err; \
+   } \
+   static inline int  insert##_fsuffix(flathash_t *htable, object_t * new_node) { \
+      return insert_flathash(htable, cast2node##_fsuffix(new_node)); \
+   } \
+   static inline int  remove##_fsuffix(flathash_t *htable, object_t * node) { \
+      return remove_flathash(htable, cast2node##_fsuffix(node)); \
+   } \
+   static inline int  removenodes##_fsuffix(flathash_t *htable) { \
+      return removenodes_flathash(htable); \
+   } \
+   static inline int  invariant##_fsuffix(flathash_t *htable) { \
+      return invariant_flathash(htable); \
+   } \
+   static inline int  initfirst##_fsuffix##iterator(flathash_iterator_t *iter, flathash_t *htable) { \
+      return initfirst_flathashiterator(iter, htable); \
+   } \
+   static inline int  free##_fsuffix##iterator(flathash_iterator_t *iter) { \
+      return free_flathashiterator(iter); \
+   } \
+   static inline bool next##_fsuffix##iterator(flathash_iterator_t *iter, object_t ** node) { \
+      bool isNext = next_flathashiterator(iter, (flathash_node_t**)node); \
+      if (isNext) *node = cast2object##_fsuffix(*(flathash_node_t**)node); \
+      return isNext; \
+   }
+
+#endif
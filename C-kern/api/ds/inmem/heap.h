@@ -45,6 +45,9 @@
 #ifndef CKERN_DS_INMEM_HEAP_HEADER
 #define CKERN_DS_INMEM_HEAP_HEADER
 
+// forward
+struct perftest_info_t;
+
 /* typedef: struct heap_t
  * Export <heap_t> into global namespace. */
 typedef struct heap_t heap_t;
@@ -76,6 +79,20 @@ typedef int (*heap_compare_f) (void * cmpstate, const void * left, const void *
 int unittest_ds_inmem_heap(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_heap_sequential
+ * Test insert, iterate and remove of 1M ascending values. */
+int perftest_ds_inmem_heap_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_heap_random
+ * Test insert, iterate and remove of 1M random values. */
+int perftest_ds_inmem_heap_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_heap_small
+ * Test insert, iterate and remove of 1K random values repeated 1K times. */
+int perftest_ds_inmem_heap_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: heap_t
  * Manages an array of elements of size elemsize
@@ -0,0 +1,39 @@
+/* title: DHeap-Node
+
+   Defines node type <dheap_node_t> which can be stored in heaps
+   of type <dheap_t>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/node/dheap_node.h
+    Header file <DHeap-Node>.
+*/
+#ifndef CKERN_DS_INMEM_NODE_DHEAP_NODE_HEADER
+#define CKERN_DS_INMEM_NODE_DHEAP_NODE_HEADER
+
+/* typedef: struct dheap_node_t
+ * Export <dheap_node_t> into global namespace. */
+typedef struct dheap_node_t dheap_node_t;
+
+
+/* struct: dheap_node_t
+ * Management overhead of objects which wants to be stored in a <dheap_t>.
+ * The node is the stable handle of an object stored in the heap.
+ * It is used to remove an arbitrary object or to adapt the heap
+ * after the key of an object has been changed. */
+struct dheap_node_t {
+   /* variable: index
+    * The index of the node in <dheap_t.array>. It is updated
+    * every time the node is moved within the heap. */
+   size_t   index;
+};
+
+// group: lifetime
+
+/* define: dheap_node_INIT
+ * Static initializer. */
+#define dheap_node_INIT { 0 }
+
+
+#endif
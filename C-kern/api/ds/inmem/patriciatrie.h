@@ -26,10 +26,16 @@
 
 #include "C-kern/api/ds/inmem/node/patriciatrie_node.h"
 
+// forward
+struct directory_t;
+struct perftest_info_t;
+
 // === exported types
 struct patriciatrie_t;
 struct patriciatrie_iterator_t;
 struct patriciatrie_prefixiter_t;
+struct patriciatrie_reader_t;
+struct frozenpatriciatrie_t;
 struct getkey_adapter_t;
 struct getkey_data_t;
 
@@ -67,6 +73,11 @@ typedef int (* delete_adapter_f) (void *obj);
  * */
 typedef void (* getkey_adapter_f) (/*inout*/struct getkey_data_t *key, size_t offset/*0 ==> key is initialized*/);
 
+/* typedef: getvalue_adapter_f
+ * Pointer to function which returns the value stored together with the key of an object
+ * in a <frozenpatriciatrie_t>. Parameter obj points to the start address of the object. */
+typedef void * (* getvalue_adapter_f) (void *obj);
+
 
 // section: Functions
 
@@ -78,6 +89,20 @@ typedef void (* getkey_adapter_f) (/*inout*/struct getkey_data_t *key, size_t of
 int unittest_ds_inmem_patriciatrie(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_patriciatrie_sequential
+ * Test insert, find, iterate and remove of 1M sequential keys. */
+int perftest_ds_inmem_patriciatrie_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_patriciatrie_random
+ * Test insert, find, iterate and remove of 1M random keys. */
+int perftest_ds_inmem_patriciatrie_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_patriciatrie_small
+ * Test insert, find, iterate and remove of 1K random keys repeated 1K times. */
+int perftest_ds_inmem_patriciatrie_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: getkey_data_t
  * Describes data block of streamed binary key and the current state of the stream.
@@ -182,10 +207,35 @@ static inline bool isequal_getkeyadapter(const getkey_adapter_t* l, const getkey
  * The reason is that even for very large strings only O(log n) bits are compared. And if
  * strings are large (i.e. strlen >> log n) other algorithms like trees or hash tables has
  * a best effort of at least O(strlen).
+ *
+ * Concurrent Readers:
+ * <find_patriciatrie> and <patriciatrie_prefixiter_t> could run in any number of threads
+ * concurrently with a single writer without acquiring a lock. Nodes are embedded in user objects
+ * so they could not be copied on write. Instead every change increments <seqnr> before
+ * and after it is done. A reader which observed a change of <seqnr> discards its result and
+ * repeats the search.
+ *
+ * A removed node could still be accessed by a reader. Every reader thread registers a
+ * <patriciatrie_reader_t> and encloses all accesses with <enter_patriciatriereader>
+ * and <leave_patriciatriereader>. The writer calls <synchronize_patriciatrie>
+ * after <remove_patriciatrie> before it frees or reuses the memory of a removed node.
+ * <free_patriciatrie> and <removenodes_patriciatrie> must not run concurrently with readers.
  * */
 typedef struct patriciatrie_t {
    patriciatrie_node_t *root;
    getkey_adapter_t     keyadapt;
+   /* variable: seqnr
+    * Incremented before and after every change. An odd value marks a change in progress. */
+   uint32_t             seqnr;
+   /* variable: epoch
+    * Incremented by <synchronize_patriciatrie>. Readers store it in <patriciatrie_reader_t.state>. */
+   uint32_t             epoch;
+   /* variable: readers
+    * List of registered readers. */
+   struct patriciatrie_reader_t * readers;
+   /* variable: readerlock
+    * Protects <readers>. */
+   uint8_t              readerlock;
 } patriciatrie_t;
 
 // group: lifetime
@@ -199,7 +249,7 @@ typedef struct patriciatrie_t {
  * Static initializer. You can use <patriciatrie_INIT> with the returned values prvided by <getinistate_patriciatrie>.
  * Parameter root is a pointer to <patriciatrie_node_t> and nodeadp must be of type <typeadapt_member_t> (no pointer). */
 #define patriciatrie_INIT(root, keyadapt) \
-         { root, keyadapt }
+         { root, keyadapt, 0, 0, 0, 0 }
 
 /* function: init_patriciatrie
  * Inits an empty tree object.
@@ -239,7 +289,8 @@ typedef patriciatrie_node_t       *  iteratedtype_patriciatrie;
 // group: search
 
 /* function: find_patriciatrie
- * Searches for a node with equal key. If it exists it is returned in found_node else ESRCH is returned. */
+ * Searches for a node with equal key. If it exists it is returned in found_node else ESRCH is returned.
+ * The search could run concurrently with a single writer - see <patriciatrie_t>. */
 int find_patriciatrie(patriciatrie_t *tree, size_t len, const uint8_t key[len], /*out*/patriciatrie_node_t ** found_node);
 
 // group: change
@@ -268,6 +319,14 @@ int remove_patriciatrie(patriciatrie_t *tree, size_t len, const uint8_t key[len]
  * */
 int removenodes_patriciatrie(patriciatrie_t *tree, delete_adapter_f delete_f/*0 ==> not called*/);
 
+// group: concurrency
+
+/* function: synchronize_patriciatrie
+ * Waits until every reader which entered before this call has left.
+ * Called by the writer after <remove_patriciatrie> and before a removed node is freed
+ * or reused. Readers which enter after this call can not reach the removed node. */
+void synchronize_patriciatrie(patriciatrie_t *tree);
+
 // group: generic
 
 /* define: patriciatrie_IMPLEMENT
@@ -326,7 +385,11 @@ bool prev_patriciatrieiterator(patriciatrie_iterator_t *iter, /*out*/patriciatri
 
 /* struct: patriciatrie_prefixiter_t
  * Iterates over elements contained in <patriciatrie_t>.
- * The iterator supports removing or deleting of the current node. */
+ * The iterator supports removing or deleting of the current node.
+ *
+ * The iterator could run concurrently with a single writer - see <patriciatrie_t>.
+ * Every node which is stored during the whole iteration is returned.
+ * Nodes inserted or removed during the iteration may or may not be returned. */
 typedef struct patriciatrie_prefixiter_t {
    patriciatrie_node_t *next;
    patriciatrie_t      *tree;
@@ -357,6 +420,151 @@ int free_patriciatrieprefixiter(patriciatrie_iterator_t *iter);
 bool next_patriciatrieprefixiter(patriciatrie_prefixiter_t *iter, /*out*/patriciatrie_node_t ** node);
 
 
+/* struct: patriciatrie_reader_t
+ * Registers a reader thread of a <patriciatrie_t>.
+ * Every thread which reads a <patriciatrie_t> concurrently to a writer
+ * uses its own reader. A reader is enclosed in <enter_patriciatriereader>
+ * and <leave_patriciatriereader> as long as it accesses nodes of the tree.
+ * The writer waits in <synchronize_patriciatrie> for entered readers. */
+typedef struct patriciatrie_reader_t {
+   /* variable: next
+    * Next registered reader in <patriciatrie_t.readers>. */
+   struct patriciatrie_reader_t * next;
+   /* variable: tree
+    * The tree the reader is registered with. */
+   patriciatrie_t               * tree;
+   /* variable: state
+    * The value 0 if reader has left else (epoch << 1) | 1 where epoch is the
+    * value of <patriciatrie_t.epoch> read in <enter_patriciatriereader>. */
+   uint32_t                       state;
+} patriciatrie_reader_t;
+
+// group: lifetime
+
+/* define: patriciatrie_reader_FREE
+ * Static initializer. */
+#define patriciatrie_reader_FREE \
+         { 0, 0, 0 }
+
+/* function: init_patriciatriereader
+ * Registers reader with tree. The reader is in state left. */
+int init_patriciatriereader(/*out*/patriciatrie_reader_t *reader, patriciatrie_t *tree);
+
+/* function: free_patriciatriereader
+ * Unregisters reader from its tree. Calling it twice is safe.
+ *
+ * Unchecked Precondition:
+ * - reader has left (or never entered) */
+int free_patriciatriereader(patriciatrie_reader_t *reader);
+
+// group: synchronize
+
+/* function: enter_patriciatriereader
+ * Marks the start of a sequence of read accesses.
+ * Nodes found after this call are not freed by the writer until <leave_patriciatriereader>. */
+void enter_patriciatriereader(patriciatrie_reader_t *reader);
+
+/* function: leave_patriciatriereader
+ * Marks the end of a sequence of read accesses.
+ * Nodes found since <enter_patriciatriereader> could be freed by the writer after return. */
+void leave_patriciatriereader(patriciatrie_reader_t *reader);
+
+
+/* struct: frozenpatriciatrie_t
+ * Read-only copy of a <patriciatrie_t> which could be saved as snapshot file.
+ * The copy contains the key of every node and a value returned by a <getvalue_adapter_f>.
+ * All nodes are stored in a single memory block in breadth first order.
+ * Nodes reference each other with 32-bit offsets relative to the start of the block
+ * so it is position independent. A lookup tests the same bits as <find_patriciatrie>
+ * and compares the full key stored in the memory block at the end.
+ *
+ * Snapshot:
+ * <save_frozenpatriciatrie> writes a 32 byte header followed by the memory block unchanged.
+ * The header contains the magic bytes "CKPATRIE", the version <frozenpatriciatrie_SNAPSHOTVERSION>,
+ * byte order, pointer size, size of the memory block and its crc32 checksum.
+ * <initload_frozenpatriciatrie> maps the file read-only and lookups read the mapped pages directly. */
+typedef struct frozenpatriciatrie_t {
+   /* variable: mem
+    * Start address of the memory block which contains all nodes.
+    * The root node is stored at offset 0. The value 0 indicates an empty trie. */
+   uint8_t *   mem;
+   /* variable: size
+    * Size in bytes of the memory block <mem> points to. */
+   size_t      size;
+   /* variable: mapaddr
+    * Start address of the mapped snapshot file. The value 0 indicates allocated memory. */
+   uint8_t *   mapaddr;
+   /* variable: mapsize
+    * Size in bytes of the mapped memory <mapaddr> points to. */
+   size_t      mapsize;
+} frozenpatriciatrie_t;
+
+// group: configuration
+
+/* define: frozenpatriciatrie_SNAPSHOTVERSION
+ * Version of the file format written by <save_frozenpatriciatrie>. */
+#define frozenpatriciatrie_SNAPSHOTVERSION 1
+
+// group: lifetime
+
+/* define: frozenpatriciatrie_FREE
+ * Static initializer. */
+#define frozenpatriciatrie_FREE \
+         { 0, 0, 0, 0 }
+
+/* function: init_frozenpatriciatrie
+ * Copies all keys of tree into a newly allocated memory block.
+ * For every node getvalue is called with the start address of the object
+ * and the returned value is stored together with its key.
+ * If getvalue is 0 the start address of the object is stored.
+ * The tree must not be changed concurrently.
+ *
+ * Returns:
+ * 0         - frozen contains a read-only copy of tree.
+ * EOVERFLOW - The frozen representation would exceed 4GB.
+ * ENOMEM    - Out of memory. */
+int init_frozenpatriciatrie(/*out*/frozenpatriciatrie_t * frozen, patriciatrie_t * tree, getvalue_adapter_f getvalue/*0 ==> address of object*/);
+
+/* function: initload_frozenpatriciatrie
+ * Maps the snapshot file filepath written by <save_frozenpatriciatrie> read-only into memory.
+ * Header and crc32 checksum are checked before frozen is returned.
+ * Values which are pointers are only valid in the process which wrote the file.
+ *
+ * Returns:
+ * 0      - frozen contains the mapped snapshot.
+ * EINVAL - The file is no valid snapshot.
+ * ENOENT - The file does not exist. */
+int initload_frozenpatriciatrie(/*out*/frozenpatriciatrie_t * frozen, const char * filepath, const struct directory_t * relative_to/*0 => current working dir*/);
+
+/* function: free_frozenpatriciatrie
+ * Frees the memory block of frozen or unmaps the snapshot file. */
+int free_frozenpatriciatrie(frozenpatriciatrie_t * frozen);
+
+// group: query
+
+/* function: at_frozenpatriciatrie
+ * Returns the memory address of the value stored with key.
+ * The address is valid as long as frozen is not freed.
+ * If key is not stored the address 0 is returned. */
+void * const * at_frozenpatriciatrie(const frozenpatriciatrie_t * frozen, size_t len, const uint8_t key[len]);
+
+/* function: sizeinbytes_frozenpatriciatrie
+ * Returns the number of bytes used to store all nodes of frozen. */
+size_t sizeinbytes_frozenpatriciatrie(const frozenpatriciatrie_t * frozen);
+
+// group: persistence
+
+/* function: save_frozenpatriciatrie
+ * Writes the memory block of frozen into the new snapshot file filepath.
+ * The values are written unchanged.
+ *
+ * Returns:
+ * 0      - The file is written.
+ * EEXIST - The file exists already.
+ * EIO    - The file could not be written completely. It is removed. */
+int save_frozenpatriciatrie(const frozenpatriciatrie_t * frozen, const char * filepath, struct directory_t * relative_to/*0 => current working dir*/);
+
+
 // section: inline implementation
 
 // group: getkey_data_t
@@ -501,5 +709,12 @@ static inline void init_patriciatrie(/*out*/patriciatrie_t *tree, getkey_adapter
       return isPrev; \
    }
 
+// group: frozenpatriciatrie_t
+
+/* define: sizeinbytes_frozenpatriciatrie
+ * Implements <frozenpatriciatrie_t.sizeinbytes_frozenpatriciatrie>. */
+#define sizeinbytes_frozenpatriciatrie(frozen) \
+         ((frozen)->size)
+
 
 #endif
@@ -20,6 +20,7 @@
 
 // forward
 struct dlist_node_t;
+struct perftest_info_t;
 
 // === exported types
 struct queue_t;
@@ -37,6 +38,16 @@ struct queue_page_t;
 int unittest_ds_inmem_queue(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_queue
+ * Test insertlast, iterate and removefirst of 1M elements. */
+int perftest_ds_inmem_queue(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_queue_small
+ * Test insertlast, iterate and removefirst of 1K elements repeated 1K times. */
+int perftest_ds_inmem_queue_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: queue_iterator_t
  * Iterates over elements contained in <queue_t>.
@@ -27,6 +27,9 @@
 struct redblacktree_t;
 struct redblacktree_iterator_t;
 
+// forward
+struct perftest_info_t;
+
 /* typedef: redblacktree_node_t
  * Rename <lrptree_node_t> into <redblacktree_node_t>. */
 typedef struct lrptree_node_t redblacktree_node_t;
@@ -42,6 +45,28 @@ typedef struct lrptree_node_t redblacktree_node_t;
 int unittest_ds_inmem_redblacktree(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_redblacktree
+ * Test lookup performance of find##_fsuffix generated by <redblacktree_IMPLEMENT>. */
+int perftest_ds_inmem_redblacktree(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_redblacktree_cmp
+ * Test lookup performance of find##_fsuffix generated by <redblacktree_IMPLEMENTCMP>. */
+int perftest_ds_inmem_redblacktree_cmp(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_redblacktree_sequential
+ * Test insert, find, iterate and remove of 1M sequential keys. */
+int perftest_ds_inmem_redblacktree_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_redblacktree_random
+ * Test insert, find, iterate and remove of 1M random keys. */
+int perftest_ds_inmem_redblacktree_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_redblacktree_small
+ * Test insert, find, iterate and remove of 1K random keys repeated 1K times. */
+int perftest_ds_inmem_redblacktree_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: redblacktree_iterator_t
  * Iterates over elements contained in <redblacktree_t>.
@@ -97,7 +122,8 @@ bool prev_redblacktreeiterator(redblacktree_iterator_t * iter, /*out*/redblacktr
  * typeadapt_t:
  * The service <typeadapt_lifetime_it.delete_object> of <typeadapt_t.lifetime> is used in <free_redblacktree> and <removenodes_redblacktree>.
  * The service <typeadapt_comparator_it.cmp_key_object> of <typeadapt_t.comparator> is used in <find_redblacktree>.
- * The service <typeadapt_comparator_it.cmp_object> of <typeadapt_t.comparator> is used in <invariant_redblacktree>, <insert_redblacktree>, and <remove_redblacktree>.
+ * The service <typeadapt_comparator_it.cmp_object> of <typeadapt_t.comparator> is used in <invariant_redblacktree>, <insert_redblacktree>, <remove_redblacktree>,
+ * <build_redblacktree>, <buildlist_redblacktree>, and <merge_redblacktree>.
  *
  * Tree Properties:
  *    1. - Every node is colored red or black.
@@ -212,6 +238,32 @@ int remove_redblacktree(redblacktree_t * tree, redblacktree_node_t * node);
  * For every removed node <typeadapt_lifetime_it.delete_object> is called. */
 int removenodes_redblacktree(redblacktree_t * tree);
 
+// group: bulk
+
+/* function: build_redblacktree
+ * Builds a balanced tree from nr_nodes nodes in linear time.
+ * The nodes in array nodes must be sorted in strictly ascending order.
+ * The tree must be empty. The array itself is not changed but the nodes are.
+ * EINVAL is returned if the tree is not empty or the nodes are not sorted (tree is not changed). */
+int build_redblacktree(redblacktree_t * tree, size_t nr_nodes, redblacktree_node_t * nodes[]);
+
+/* function: buildlist_redblacktree
+ * Builds a balanced tree from a list of nodes in linear time.
+ * The list is linked with the <lrptree_node_t.right> pointer of every node
+ * and ends with a node whose right pointer is 0. Parameter first points
+ * to the first node of the list and could be 0.
+ * The nodes of the list must be sorted in strictly ascending order and the tree must be empty.
+ * EINVAL is returned if the tree is not empty or the list is not sorted (tree is not changed). */
+int buildlist_redblacktree(redblacktree_t * tree, redblacktree_node_t * first);
+
+/* function: merge_redblacktree
+ * Moves all nodes of fromtree into tree in time O(n+m).
+ * Both trees are converted into a sorted list, the lists are merged and
+ * tree is rebuilt with <buildlist_redblacktree>. No node is rebalanced individually.
+ * fromtree is empty after return.
+ * EEXIST is returned if both trees contain nodes with equal keys. Both trees are not changed in this case. */
+int merge_redblacktree(redblacktree_t * tree, redblacktree_t * fromtree);
+
 // group: test
 
 /* function: invariant_redblacktree
@@ -232,6 +284,19 @@ int invariant_redblacktree(redblacktree_t * tree);
  * */
 void redblacktree_IMPLEMENT(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename);
 
+/* define: redblacktree_IMPLEMENTCMP
+ * Same as <redblacktree_IMPLEMENT> except that the generated find##_fsuffix calls cmpkeyobj_f directly.
+ * The compiler can inline the comparison and the search loop contains no indirect call.
+ * All other generated functions use the comparator of the <typeadapt_member_t> given in init##_fsuffix
+ * which must order the objects the same way as cmpkeyobj_f.
+ *
+ * Parameter:
+ * cmpkeyobj_f - Name of function or macro with signature
+ *               > int cmpkeyobj_f(const key_t key, const object_t * object)
+ *               It returns a value < 0, == 0 or > 0 if key is less, equal or greater than the key of object.
+ * */
+void redblacktree_IMPLEMENTCMP(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename, IDNAME cmpkeyobj_f);
+
 
 // section: inline implementation
 
@@ -259,6 +324,34 @@ static inline void getinistate_redblacktree(const redblacktree_t * tree, /*out*/
 /* define: redblacktree_IMPLEMENT
  * Implements <redblacktree_t.redblacktree_IMPLEMENT>. */
 #define redblacktree_IMPLEMENT(_fsuffix, object_t, key_t, nodename)  \
+   redblacktree_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename) \
+   static inline int  find##_fsuffix(redblacktree_t * tree, const key_t key, /*out*/object_t ** found_node) { \
+      int err = find_redblacktree(tree, (void*)key, (redblacktree_node_t**)found_node); \
+      if (err == 0) *found_node = cast2object##_fsuffix(*(redblacktree_node_t**)found_node); \
+      return err; \
+   }
+
+/* define: redblacktree_IMPLEMENTCMP
+ * Implements <redblacktree_t.redblacktree_IMPLEMENTCMP>. */
+#define redblacktree_IMPLEMENTCMP(_fsuffix, object_t, key_t, nodename, cmpkeyobj_f)  \
+   redblacktree_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename) \
+   static inline int  find##_fsuffix(redblacktree_t * tree, const key_t key, /*out*/object_t ** found_node) { \
+      redblacktree_node_t * node = tree->root; \
+      while (node) { \
+         int cmp = cmpkeyobj_f(key, cast2object##_fsuffix(node)); \
+         if (cmp == 0) { \
+            *found_node = cast2object##_fsuffix(node); \
+            return 0; \
+         } \
+         node = cmp < 0 ? node->left : node->right; \
+      } \
+      return ESRCH; \
+   }
+
+/* define: redblacktree_IMPLEMENTBASE
+ * Generates all functions of <redblacktree_IMPLEMENT> except find##_fsuffix.
+ * Used by <redblacktree_IMPLEMENT> and <redblacktree_IMPLEMENTCMP>. */
+#define redblacktree_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename)  \
    typedef redblacktree_iterator_t  iteratortype##_fsuffix; \
    typedef object_t              *  iteratedtype##_fsuffix; \
    static inline redblacktree_node_t * cast2node##_fsuffix(object_t * object) { \
@@ -285,11 +378,6 @@ static inline void getinistate_redblacktree(const redblacktree_t * tree, /*out*/
    static inline bool isempty##_fsuffix(const redblacktree_t * tree) { \
       return isempty_redblacktree(tree); \
    } \
-   static inline int  find##_fsuffix(redblacktree_t * tree, const key_t key, /*out*/object_t ** found_node) { \
-      int err = find_redblacktree(tree, (void*)key, (redblacktree_node_t**)found_node); \
-      if (err == 0) *found_node = cast2object##_fsuffix(*(redblacktree_node_t**)found_node); \
-      return err; \
-   } \
    static inline int  insert##_fsuffix(redblacktree_t * tree, object_t * new_node) { \
       return insert_redblacktree(tree, cast2node##_fsuffix(new_node)); \
    } \
@@ -300,6 +388,9 @@ static inline void getinistate_redblacktree(const redblacktree_t * tree, /*out*/
    static inline int  removenodes##_fsuffix(redblacktree_t * tree) { \
       return removenodes_redblacktree(tree); \
    } \
+   static inline int  merge##_fsuffix(redblacktree_t * tree, redblacktree_t * fromtree) { \
+      return merge_redblacktree(tree, fromtree); \
+   } \
    static inline int  invariant##_fsuffix(redblacktree_t * tree) { \
       return invariant_redblacktree(tree); \
    } \
@@ -25,6 +25,7 @@
 #include "C-kern/api/ds/inmem/node/slist_node.h"
 
 // forward
+struct perftest_info_t;
 struct typeadapt_t;
 
 // === exported types
@@ -42,6 +43,16 @@ struct slist_iterator_t;
 int unittest_ds_inmem_slist(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_slist
+ * Test insertlast, iterate and removefirst of 1M nodes. */
+int perftest_ds_inmem_slist(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_slist_small
+ * Test insertlast, iterate and removefirst of 1K nodes repeated 1K times. */
+int perftest_ds_inmem_slist_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: slist_iterator_t
  * Iterates over elements contained in <slist_t>.
@@ -29,6 +29,10 @@
 // === exported types
 struct splaytree_t;
 struct splaytree_iterator_t;
+
+// forward
+struct perftest_info_t;
+
 /* typedef: splaytree_node_t
  * Rename <lrtree_node_t> into <splaytree_node_t>. */
 typedef struct lrtree_node_t splaytree_node_t;
@@ -44,6 +48,28 @@ typedef struct lrtree_node_t splaytree_node_t;
 int unittest_ds_inmem_splaytree(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_splaytree
+ * Test lookup performance of find##_fsuffix generated by <splaytree_IMPLEMENT>. */
+int perftest_ds_inmem_splaytree(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_splaytree_cmp
+ * Test lookup performance of find##_fsuffix generated by <splaytree_IMPLEMENTCMP>. */
+int perftest_ds_inmem_splaytree_cmp(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_splaytree_sequential
+ * Test insert, find, iterate and remove of 1M sequential keys. */
+int perftest_ds_inmem_splaytree_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_splaytree_random
+ * Test insert, find, iterate and remove of 1M random keys. */
+int perftest_ds_inmem_splaytree_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_splaytree_small
+ * Test insert, find, iterate and remove of 1K random keys repeated 1K times. */
+int perftest_ds_inmem_splaytree_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: splaytree_iterator_t
  * Iterates over elements contained in <splaytree_t>.
@@ -205,6 +231,19 @@ splaytree_t * cast_splaytree(void *tree);
  * */
 void splaytree_IMPLEMENT(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename);
 
+/* define: splaytree_IMPLEMENTCMP
+ * Same as <splaytree_IMPLEMENT> except that the generated find##_fsuffix calls cmpkeyobj_f directly.
+ * The splay loop is generated inline and contains no indirect call.
+ * The parameter typeadp of find##_fsuffix is ignored. All other generated functions
+ * use typeadp which must order the objects the same way as cmpkeyobj_f.
+ *
+ * Parameter:
+ * cmpkeyobj_f - Name of function or macro with signature
+ *               > int cmpkeyobj_f(const key_t key, const object_t * object)
+ *               It returns a value < 0, == 0 or > 0 if key is less, equal or greater than the key of object.
+ * */
+void splaytree_IMPLEMENTCMP(IDNAME _fsuffix, TYPENAME object_t, TYPENAME key_t, IDNAME nodename, IDNAME cmpkeyobj_f);
+
 
 
 // section: inline implementation
@@ -247,6 +286,85 @@ static inline void getinistate_splaytree(const splaytree_t *tree, /*out*/splaytr
 /* define: splaytree_IMPLEMENT
  * Implements <splaytree_t.splaytree_IMPLEMENT>. */
 #define splaytree_IMPLEMENT(_fsuffix, object_t, key_t, nodename) \
+   splaytree_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename) \
+   static inline int  find##_fsuffix(splaytree_t *tree, const key_t key, /*out*/object_t ** found_node, typeadapt_t * typeadp) { \
+      int err = find_splaytree(tree, (void*)key, (splaytree_node_t**)found_node, offsetof(object_t, nodename), typeadp); \
+      if (err == 0) *found_node = cast2object##_fsuffix(*(splaytree_node_t**)found_node); \
+      return err; \
+   }
+
+/* define: splaytree_IMPLEMENTCMP
+ * Implements <splaytree_t.splaytree_IMPLEMENTCMP>.
+ * The generated find##_fsuffix is the same top-down splay as find_splaytree
+ * with KEYCOMPARE replaced by cmpkeyobj_f. The result of the last comparison
+ * belongs to the new root so no additional comparison is needed. */
+#define splaytree_IMPLEMENTCMP(_fsuffix, object_t, key_t, nodename, cmpkeyobj_f) \
+   splaytree_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename) \
+   static inline int  find##_fsuffix(splaytree_t *tree, const key_t key, /*out*/object_t ** found_node, typeadapt_t * typeadp) { \
+      (void) typeadp; \
+      splaytree_node_t keyroot = { .left = 0, .right = 0 }; \
+      splaytree_node_t * higherAsKey = &keyroot; \
+      splaytree_node_t * lowerAsKey  = &keyroot; \
+      splaytree_node_t * node = tree->root; \
+      if (!node) return ESRCH; \
+      int cmp = cmpkeyobj_f(key, cast2object##_fsuffix(node)); \
+      for (;;) { \
+         if (cmp > 0) { \
+            splaytree_node_t * rightnode = node->right; \
+            if (!rightnode) break; \
+            cmp = cmpkeyobj_f(key, cast2object##_fsuffix(rightnode)); \
+            if (cmp > 0 && rightnode->right) { \
+               node->right = rightnode->left; \
+               rightnode->left = node; \
+               node = rightnode; \
+               rightnode = node->right; \
+               cmp = cmpkeyobj_f(key, cast2object##_fsuffix(rightnode)); \
+            } else if (cmp < 0 && rightnode->left) { \
+               higherAsKey->left = rightnode; \
+               higherAsKey = rightnode; \
+               rightnode = rightnode->left; \
+               cmp = cmpkeyobj_f(key, cast2object##_fsuffix(rightnode)); \
+            } \
+            lowerAsKey->right = node; \
+            lowerAsKey = node; \
+            node = rightnode; \
+         } else if (cmp < 0) { \
+            splaytree_node_t * leftnode = node->left; \
+            if (!leftnode) break; \
+            cmp = cmpkeyobj_f(key, cast2object##_fsuffix(leftnode)); \
+            if (cmp < 0 && leftnode->left) { \
+               node->left = leftnode->right; \
+               leftnode->right = node; \
+               node = leftnode; \
+               leftnode = node->left; \
+               cmp = cmpkeyobj_f(key, cast2object##_fsuffix(leftnode)); \
+            } else if (cmp > 0 && leftnode->right) { \
+               lowerAsKey->right = leftnode; \
+               lowerAsKey = leftnode; \
+               leftnode = leftnode->right; \
+               cmp = cmpkeyobj_f(key, cast2object##_fsuffix(leftnode)); \
+            } \
+            higherAsKey->left = node; \
+            higherAsKey = node; \
+            node = leftnode; \
+         } else { \
+            break; \
+         } \
+      } \
+      tree->root = node; \
+      higherAsKey->left = node->right; \
+      lowerAsKey->right = node->left; \
+      node->left  = keyroot.right; \
+      node->right = keyroot.left; \
+      if (cmp) return ESRCH; \
+      *found_node = cast2object##_fsuffix(node); \
+      return 0; \
+   }
+
+/* define: splaytree_IMPLEMENTBASE
+ * Generates all functions of <splaytree_IMPLEMENT> except find##_fsuffix.
+ * Used by <splaytree_IMPLEMENT> and <splaytree_IMPLEMENTCMP>. */
+#define splaytree_IMPLEMENTBASE(_fsuffix, object_t, key_t, nodename) \
    typedef splaytree_iterator_t  iteratortype##_fsuffix; \
    typedef object_t           *  iteratedtype##_fsuffix; \
    static inline splaytree_node_t * cast2node##_fsuffix(object_t * object) { \
@@ -273,11 +391,6 @@ static inline void getinistate_splaytree(const splaytree_t *tree, /*out*/splaytr
    static inline bool isempty##_fsuffix(const splaytree_t *tree) { \
       return isempty_splaytree(tree); \
    } \
-   static inline int  find##_fsuffix(splaytree_t *tree, const key_t key, /*out*/object_t ** found_node, typeadapt_t * typeadp) { \
-      int err = find_splaytree(tree, (void*)key, (splaytree_node_t**)found_node, offsetof(object_t, nodename), typeadp); \
-      if (err == 0) *found_node = cast2object##_fsuffix(*(splaytree_node_t**)found_node); \
-      return err; \
-   } \
    static inline int  insert##_fsuffix(splaytree_t *tree, object_t * new_node, typeadapt_t * typeadp) { \
       return insert_splaytree(tree, cast2node##_fsuffix(new_node), offsetof(object_t, nodename), typeadp); \
    } \
@@ -0,0 +1,197 @@
+/* title: Suffix-Array
+
+   A suffix array stores the start positions of all suffixes of a given string
+   in lexicographical order. For "ABABC" the sorted suffixes are
+   ABABC,ABC,BABC,BC,C and the suffix array is [0,2,1,3,4].
+   Like <suffixtree_t> the empty string is not considered a suffix.
+
+   The LCP array stores for every suffix the length of the longest common prefix
+   with its predecessor in the suffix array. For "ABABC" it is [0,2,0,1,0].
+
+   When to choose suffixarray?:
+   A <suffixtree_t> needs many times the size of the input string in node memory.
+   A suffix array with LCP array needs 8 bytes per input byte (plus the input string).
+   Searching a substring of length s needs time O(s * log n) instead of O(s).
+
+   Time in O(n):
+   The suffix array is constructed with SA-IS in time O(n) for an input string
+   of length n. The LCP array is computed with the Φ algorithm in time O(n).
+
+   Reference:
+   SA-IS is from G. Nong, S. Zhang and W. H. Chan, "Two Efficient Algorithms for
+   Linear Time Suffix Array Construction" (2011).
+   The Φ algorithm is from J. Kärkkäinen, G. Manzini and S. J. Puglisi,
+   "Permuted Longest-Common-Prefix Array" (2009).
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/suffixarray.h
+    Header file of <Suffix-Array>.
+
+   file: C-kern/ds/inmem/suffixarray.c
+    Implementation file of <Suffix-Array impl>.
+*/
+#ifndef CKERN_DS_INMEM_SUFFIXARRAY_HEADER
+#define CKERN_DS_INMEM_SUFFIXARRAY_HEADER
+
+// === exported types
+struct suffixarray_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_inmem_suffixarray
+ * Test <suffixarray_t> functionality. */
+int unittest_ds_inmem_suffixarray(void);
+#endif
+
+
+/* struct: suffixarray_t
+ * Suffix array and LCP array of an input string.
+ * Positions are stored as uint32_t therefore the length of the input string
+ * is limited to <suffixarray_MAXLENGTH>.
+ *
+ * Memory:
+ * After <build_suffixarray> returns the arrays need 8 bytes per input byte.
+ * SA-IS uses the not yet computed LCP array as workspace.
+ * Computing the LCP array needs a temporary buffer of 4 bytes per input byte.
+ *
+ * The input string is not copied. It must live at least as long as the suffix array. */
+typedef struct suffixarray_t {
+   // group: private fields
+   /* variable: text
+    * Input string. */
+   const uint8_t * text;
+   /* variable: length
+    * Length in bytes of <text> and number of entries in <sa> and <lcp>. */
+   size_t     length;
+   /* variable: sa
+    * Start positions of all suffixes of <text> in lexicographical order. */
+   uint32_t * sa;
+   /* variable: lcp
+    * lcp[i] is the length of the longest common prefix of suffixes sa[i-1] and sa[i].
+    * lcp[0] is 0. */
+   uint32_t * lcp;
+   /* variable: mem
+    * Start address of allocated memory which contains <sa> and <lcp>. */
+   uint8_t  * mem;
+   /* variable: memsize
+    * Size in bytes of allocated memory <mem>. */
+   size_t     memsize;
+} suffixarray_t;
+
+// group: configuration
+
+/* define: suffixarray_MAXLENGTH
+ * Max length of input string supported by <build_suffixarray>. */
+#define suffixarray_MAXLENGTH ((size_t)UINT32_MAX - 2)
+
+// group: lifetime
+
+/* define: suffixarray_FREE
+ * Static initializer. Sets all fields to 0. */
+#define suffixarray_FREE \
+         { 0, 0, 0, 0, 0, 0 }
+
+/* function: init_suffixarray
+ * Initializes an empty suffix array. */
+void init_suffixarray(/*out*/suffixarray_t * sarray);
+
+/* function: free_suffixarray
+ * Frees all allocated memory. The input string could also be freed if it is no longer needed. */
+int free_suffixarray(suffixarray_t * sarray);
+
+// group: query
+
+/* function: length_suffixarray
+ * Returns the length of the input string which is the number of suffixes. */
+size_t length_suffixarray(const suffixarray_t * sarray);
+
+/* function: suffix_suffixarray
+ * Returns the start position in the input string of the i-th smallest suffix.
+ * The value of i must be less than <length_suffixarray>. */
+size_t suffix_suffixarray(const suffixarray_t * sarray, size_t i);
+
+/* function: lcp_suffixarray
+ * Returns the length of the longest common prefix of the (i-1)-th and i-th smallest suffix.
+ * Returns 0 for i == 0. The value of i must be less than <length_suffixarray>. */
+size_t lcp_suffixarray(const suffixarray_t * sarray, size_t i);
+
+/* function: isstring_suffixarray
+ * Returns true if at least one suffix begins with searchstr.
+ * Same semantics as <isstring_suffixtree>. An empty searchstr is never found.
+ *
+ * Returns:
+ * true  - searched string is contained in input text
+ * false - searched string is not contained in input text */
+bool isstring_suffixarray(const suffixarray_t * sarray, size_t length, const uint8_t searchstr[length]);
+
+/* function: matchall_suffixarray
+ * Returns number of times and start addresses of suffixes which begin with searchstr.
+ * Same semantics as <matchall_suffixtree> except that positions are returned
+ * in lexicographical order of the matched suffixes.
+ *
+ * The number of valid positions in array matchedpos can be computed with
+ * > min((matched_count > skip_count ? matched_count-skip_count : 0), maxmatchcount)
+ *
+ * Parameter:
+ * sarray     - Suffix array of the string which is scanned for searchstr.
+ * length     - The length of searchstr.
+ * searchstr  - The content of the search string.
+ * skip_count - The first skip_count number of found occurrences are not returned in matchedpos array.
+ * matched_count - Returns the number of all found occurrences. This number is independent of skip_count and maxmatchcount.
+ * maxmatchcount - Contains the size of the array matchedpos.
+ * matchedpos - Returns the addresses in the input string where searchstr is found.
+ *
+ * Returns:
+ * 0     - Found at least one occurrence.
+ * ESRCH - searchstr is empty or not contained in input text. No error is logged. */
+int matchall_suffixarray(const suffixarray_t * sarray, size_t length, const uint8_t searchstr[length], size_t skip_count, /*out*/size_t * matched_count, size_t maxmatchcount, /*out*/const uint8_t * matchedpos[maxmatchcount]);
+
+// group: build
+
+/* function: build_suffixarray
+ * Constructs suffix array and LCP array from the given input string.
+ * The input string must live at least as long as sarray cause it is not copied.
+ * Memory of any previously built array is freed before the new one is built.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - length > <suffixarray_MAXLENGTH>.
+ * ENOMEM - Out of memory. sarray is empty. */
+int build_suffixarray(suffixarray_t * sarray, size_t length, const uint8_t input_string[length]);
+
+/* function: clear_suffixarray
+ * All memory is freed and no reference to the input string is held.
+ * Same as <free_suffixarray>. */
+int clear_suffixarray(suffixarray_t * sarray);
+
+
+
+// section: inline implementation
+
+/* define: init_suffixarray
+ * Implements <suffixarray_t.init_suffixarray>. */
+#define init_suffixarray(sarray) \
+         ((void)(*(sarray) = (suffixarray_t) suffixarray_FREE))
+
+/* define: length_suffixarray
+ * Implements <suffixarray_t.length_suffixarray>. */
+#define length_suffixarray(sarray) \
+         ((sarray)->length)
+
+/* define: suffix_suffixarray
+ * Implements <suffixarray_t.suffix_suffixarray>. */
+#define suffix_suffixarray(sarray, i) \
+         ((size_t)(sarray)->sa[i])
+
+/* define: lcp_suffixarray
+ * Implements <suffixarray_t.lcp_suffixarray>. */
+#define lcp_suffixarray(sarray, i) \
+         ((size_t)(sarray)->lcp[i])
+
+#endif
@@ -48,10 +48,13 @@
 #define CKERN_DS_INMEM_TRIE_HEADER
 
 // forward
+struct directory_t;
+struct perftest_info_t;
 struct trie_node_t;
 
 // === exported types
 struct trie_t;
+struct frozentrie_t;
 
 
 // section: Functions
@@ -64,6 +67,20 @@ struct trie_t;
 int unittest_ds_inmem_trie(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_inmem_trie_sequential
+ * Test insert, find and remove of 1M sequential keys. */
+int perftest_ds_inmem_trie_sequential(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_trie_random
+ * Test insert, find and remove of 1M random keys. */
+int perftest_ds_inmem_trie_random(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_inmem_trie_small
+ * Test insert, find and remove of 1K random keys repeated 1K times. */
+int perftest_ds_inmem_trie_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: trie_t
  * Manages an index which associates a binary key with a user defined pointer.
@@ -185,6 +202,120 @@ int insert2_trie(trie_t * trie, uint16_t keylen, const uint8_t key[keylen], void
 int remove2_trie(trie_t * trie, uint16_t keylen, const uint8_t key[keylen], /*out*/void ** value, bool islog);
 
 
+/* struct: frozentrie_t
+ * Read-only copy of a <trie_t> optimized for lookup.
+ * All nodes are stored in a single contiguous memory block.
+ * Nodes reference their childs with 32-bit offsets relative to the start
+ * of the block instead of pointers so the block contains no internal pointers.
+ * Nodes are stored in breadth first order so nodes near the root,
+ * which are visited by every lookup, share the same cache lines and pages.
+ *
+ * Use it for read-mostly tables which are built once with <trie_t>
+ * and queried many times afterwards. After any change to the <trie_t>
+ * the frozen copy must be rebuilt with <init_frozentrie>.
+ *
+ * Snapshot:
+ * Cause the memory block is position independent it is written unchanged
+ * into a snapshot file with <save_frozentrie>. <initload_frozentrie> maps
+ * the file read-only into memory and lookups read the mapped pages directly
+ * without copying or parsing them.
+ *
+ * File Format:
+ * > header (32 bytes) | memory block (size bytes)
+ * The header contains the magic bytes "CKTRIE\0\0", a version number (<frozentrie_SNAPSHOTVERSION>),
+ * a byte order marker, the size of a pointer, the size of the memory block
+ * and its crc32 checksum. All numbers are stored in native byte order.
+ * A snapshot is only loadable on a system with the same byte order and pointer size.
+ * */
+typedef struct frozentrie_t {
+   /* variable: mem
+    * Start address of the memory block which contains all nodes.
+    * The root node is stored at offset 0. The value 0 indicates an empty trie. */
+   uint8_t *   mem;
+   /* variable: size
+    * Size in bytes of the memory block <mem> points to. */
+   size_t      size;
+   /* variable: mapaddr
+    * Start address of the mapped snapshot file if loaded with <initload_frozentrie>.
+    * The value 0 indicates that <mem> is allocated with <init_frozentrie>. */
+   uint8_t *   mapaddr;
+   /* variable: mapsize
+    * Size in bytes of the mapped memory <mapaddr> points to. */
+   size_t      mapsize;
+} frozentrie_t;
+
+// group: configuration
+
+/* define: frozentrie_SNAPSHOTVERSION
+ * Version of the file format written by <save_frozentrie>.
+ * Incremented whenever the layout of the header or of the nodes changes. */
+#define frozentrie_SNAPSHOTVERSION 1
+
+// group: lifetime
+
+/* define: frozentrie_FREE
+ * Static initializer. */
+#define frozentrie_FREE \
+         { 0, 0, 0, 0 }
+
+/* function: init_frozentrie
+ * Freezes trie into a newly allocated memory block.
+ * The values stored in trie are copied but not the objects they point to.
+ * The trie is not changed and could be freed after return.
+ *
+ * Returns:
+ * 0         - frozen contains a read-only copy of trie.
+ * EOVERFLOW - The frozen representation would exceed 4GB.
+ * ENOMEM    - Out of memory. */
+int init_frozentrie(/*out*/frozentrie_t * frozen, const trie_t * trie);
+
+/* function: initload_frozentrie
+ * Maps the snapshot file filepath written by <save_frozentrie> read-only into memory.
+ * The header and the crc32 checksum of the memory block are checked before frozen is returned.
+ * Only the pages visited by lookups are read from disk. The file could be changed or removed
+ * after return without changing frozen as long as it is replaced and not written in place.
+ *
+ * The values are returned as stored in the file. Values which are pointers
+ * are only valid if the file was written by the same process.
+ *
+ * Returns:
+ * 0      - frozen contains the mapped snapshot.
+ * EINVAL - The file is no valid snapshot (wrong magic, version, byte order, pointer size,
+ *          size or checksum).
+ * ENOENT - The file does not exist. */
+int initload_frozentrie(/*out*/frozentrie_t * frozen, const char * filepath, const struct directory_t * relative_to/*0 => current working dir*/);
+
+/* function: free_frozentrie
+ * Frees the memory block of frozen or unmaps the snapshot file. */
+int free_frozentrie(frozentrie_t * frozen);
+
+// group: persistence
+
+/* function: save_frozentrie
+ * Writes the memory block of frozen into a new snapshot file filepath.
+ * See <frozentrie_t> for a description of the file format.
+ * The values are written unchanged. Store integer ids instead of pointers
+ * if the snapshot is loaded by another process.
+ *
+ * Returns:
+ * 0      - The file is written.
+ * EEXIST - The file exists already.
+ * EIO    - The file could not be written completely. It is removed. */
+int save_frozentrie(const frozentrie_t * frozen, const char * filepath, struct directory_t * relative_to/*0 => current working dir*/);
+
+// group: query
+
+/* function: at_frozentrie
+ * Returns memory address of the value of a stored (key, value) pair.
+ * The address is valid as long as frozen is not freed.
+ * If there is no stored value the memory address 0 is returned. */
+void * const * at_frozentrie(const frozentrie_t * frozen, uint16_t keylen, const uint8_t key[keylen]);
+
+/* function: sizeinbytes_frozentrie
+ * Returns the number of bytes used to store all nodes of frozen. */
+size_t sizeinbytes_frozentrie(const frozentrie_t * frozen);
+
+
 // section: inline implementation
 
 /* define: init_trie
@@ -212,5 +343,10 @@ int remove2_trie(trie_t * trie, uint16_t keylen, const uint8_t key[keylen], /*ou
 #define tryremove_trie(trie, keylen, key, value) \
          (remove2_trie((trie), (keylen), (key), (value), false))
 
+/* define: sizeinbytes_frozentrie
+ * Implements <frozentrie_t.sizeinbytes_frozentrie>. */
+#define sizeinbytes_frozentrie(frozen) \
+         ((frozen)->size)
+
 
 #endif
@@ -54,6 +54,9 @@ typedef int (* sort_compare_f) (void * cmpstate, const void * left, const void *
  * Export <mergesort_t> into global namespace. */
 typedef struct mergesort_t mergesort_t;
 
+// forward
+struct perftest_info_t;
+
 
 // section: Functions
 
@@ -65,6 +68,36 @@ typedef struct mergesort_t mergesort_t;
 int unittest_ds_sort_mergesort(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_sort_mergesort
+ * Test sort performance of <sortblob_mergesort>. */
+int perftest_ds_sort_mergesort(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_sort_mergesort_ptr
+ * Test sort performance of <sortptr_mergesort>. */
+int perftest_ds_sort_mergesort_ptr(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_sort_mergesort_implement
+ * Test sort performance of the function generated by <mergesort_IMPLEMENT>. */
+int perftest_ds_sort_mergesort_implement(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_sort_mergesort_parallel2
+ * Test sort performance of <parallelsortblob_mergesort> with 2 threads. */
+int perftest_ds_sort_mergesort_parallel2(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_sort_mergesort_parallel4
+ * Test sort performance of <parallelsortblob_mergesort> with 4 threads. */
+int perftest_ds_sort_mergesort_parallel4(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_sort_mergesort_sorted
+ * Test sort performance of <sortblob_mergesort> with already sorted input. */
+int perftest_ds_sort_mergesort_sorted(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_ds_sort_mergesort_small
+ * Test sort performance of <sortblob_mergesort> with arrays of 1K random elements. */
+int perftest_ds_sort_mergesort_small(/*out*/struct perftest_info_t* info);
+#endif
+
 
 /* struct: mergesort_sortedslice_t
  * Describes a part of an array which contains sorted data.
@@ -210,5 +243,136 @@ int sortptr_mergesort(mergesort_t * sort, size_t len, void * a[len], sort_compar
  * in array a will not be undone! */
 int sortblob_mergesort(mergesort_t * sort, uint8_t elemsize, size_t len, void * a/*uint8_t[len*elemsize]*/, sort_compare_f cmp, void * cmpstate);
 
+// group: parallel sort
+
+/* define: mergesort_MAXTHREAD
+ * The maximum number of threads supported by <parallelsortptr_mergesort> and <parallelsortblob_mergesort>. */
+#define mergesort_MAXTHREAD 64
+
+/* function: parallelsortptr_mergesort
+ * Same as <sortptr_mergesort> but uses up to nrthread threads.
+ * The calling thread is one of them.
+ *
+ * Algorithm:
+ * The array is split into nrthread slices of equal size. Every slice is sorted
+ * by its own thread with <sortptr_mergesort>. Then pairs of adjacent sorted slices
+ * are merged in log2(nrthread) rounds. The output of every round is split into
+ * nrthread parts of equal size with merge path partitioning. Every thread
+ * merges a single part. The merge is stable, equal elements keep their order.
+ *
+ * The temporary memory (size of the whole array) of sort is used as merge
+ * buffer. It is freed with <free_mergesort>.
+ *
+ * If len is too small to be worth the thread overhead fewer threads are used.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - nrthread is 0 or greater than <mergesort_MAXTHREAD> or cmp is 0.
+ * ENOMEM - Out of memory. Array a is not sorted. */
+int parallelsortptr_mergesort(mergesort_t * sort, uint8_t nrthread, size_t len, void * a[len], sort_compare_f cmp, void * cmpstate);
+
+/* function: parallelsortblob_mergesort
+ * Same as <sortblob_mergesort> but uses up to nrthread threads.
+ * See <parallelsortptr_mergesort> for a description of the algorithm. */
+int parallelsortblob_mergesort(mergesort_t * sort, uint8_t nrthread, uint8_t elemsize, size_t len, void * a/*uint8_t[len*elemsize]*/, sort_compare_f cmp, void * cmpstate);
+
+// group: generic
+
+/* function: ensuretemp_mergesort
+ * Ensures <mergesort_t.temp> can store tempsize bytes.
+ * If it is too small it is reallocated and the old content is lost.
+ * Used by the functions generated with <mergesort_IMPLEMENT>.
+ *
+ * Returns:
+ * 0      - Success. sort->tempsize >= tempsize.
+ * ENOMEM - Out of memory. */
+int ensuretemp_mergesort(mergesort_t * sort, size_t tempsize);
+
+/* define: mergesort_IMPLEMENT
+ * Generates a stable sort of pointers to object_t specialized for compare_f.
+ * The generated function is
+ * > static inline int sort##_fsuffix(mergesort_t * sort, size_t len, object_t * a[len])
+ * It sorts array a in ascending order like <sortptr_mergesort> but calls compare_f directly.
+ * The compiler can inline the comparison and the sort loops contain no indirect call.
+ *
+ * Algorithm:
+ * Slices of <mergesort_IMPLEMENT_SLICELEN> elements are sorted with insertsort.
+ * Then adjacent slices are merged bottom-up between array a and the temporary
+ * array of sort (len pointers, see <ensuretemp_mergesort>) until one slice remains.
+ * A merge of two slices is replaced by a copy if they are already in order.
+ * Presorted input is not detected as long runs as in <sortptr_mergesort>.
+ *
+ * Parameter:
+ * _fsuffix  - The suffix name of the generated function "sort##_fsuffix".
+ * object_t  - The type of object the sorted pointers point to.
+ * compare_f - Name of function or macro with signature
+ *             > int compare_f(const object_t * left, const object_t * right)
+ *             See <sort_compare_f> for the returned values.
+ *
+ * Returns of sort##_fsuffix:
+ * 0      - Success.
+ * ENOMEM - Out of memory. Array a is not sorted. */
+void mergesort_IMPLEMENT(IDNAME _fsuffix, TYPENAME object_t, IDNAME compare_f);
+
+/* define: mergesort_IMPLEMENT_SLICELEN
+ * Length of slices sorted with insertsort in functions generated by <mergesort_IMPLEMENT>. */
+#define mergesort_IMPLEMENT_SLICELEN 32
+
+
+// section: inline implementation
+
+/* define: mergesort_IMPLEMENT
+ * Implements <mergesort_t.mergesort_IMPLEMENT>. */
+#define mergesort_IMPLEMENT(_fsuffix, object_t, compare_f) \
+   static inline void insertsort##_fsuffix(size_t len, object_t * a[len]) { \
+      for (size_t i = 1; i < len; ++i) { \
+         object_t * next = a[i]; \
+         size_t j = i; \
+         for (; j > 0 && compare_f(a[j-1], next) > 0; --j) { \
+            a[j] = a[j-1]; \
+         } \
+         a[j] = next; \
+      } \
+   } \
+   static inline void merge##_fsuffix(object_t ** dest, object_t ** left, object_t ** right, object_t ** end) { \
+      object_t ** const lend = right; \
+      while (left < lend && right < end) { \
+         if (compare_f(*right, *left) < 0) { \
+            *dest++ = *right++; \
+         } else { \
+            *dest++ = *left++; \
+         } \
+      } \
+      while (left < lend) *dest++ = *left++; \
+      while (right < end) *dest++ = *right++; \
+   } \
+   static inline int sort##_fsuffix(mergesort_t * sort, size_t len, object_t * a[len]) { \
+      for (size_t i = 0; i < len; i += mergesort_IMPLEMENT_SLICELEN) { \
+         size_t slicelen = len - i < mergesort_IMPLEMENT_SLICELEN ? len - i : mergesort_IMPLEMENT_SLICELEN; \
+         insertsort##_fsuffix(slicelen, a + i); \
+      } \
+      if (len <= mergesort_IMPLEMENT_SLICELEN) return 0; \
+      int err = ensuretemp_mergesort(sort, len * sizeof(object_t*)); \
+      if (err) return err; \
+      object_t ** src = a; \
+      object_t ** dest = (object_t**) sort->temp; \
+      for (size_t width = mergesort_IMPLEMENT_SLICELEN; width < len; width *= 2) { \
+         for (size_t i = 0; i < len; i += 2*width) { \
+            size_t mid = len - i <= width ? len : i + width; \
+            size_t end = len - mid <= width ? len : mid + width; \
+            if (mid == end || compare_f(src[mid-1], src[mid]) <= 0) { \
+               memcpy(dest + i, src + i, (end - i) * sizeof(object_t*)); \
+            } else { \
+               merge##_fsuffix(dest + i, src + i, src + mid, src + end); \
+            } \
+         } \
+         object_t ** swap = src; \
+         src  = dest; \
+         dest = swap; \
+      } \
+      if (src != a) memcpy(a, src, len * sizeof(object_t*)); \
+      return 0; \
+   }
+
 
 #endif
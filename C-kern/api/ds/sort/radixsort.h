@@ -0,0 +1,156 @@
+/* title: RadixSort
+
+   Offers a stable radix sort for arrays of elements with fixed-width keys.
+
+   When to choose radixsort?:
+
+   If elements are sorted by an unsigned integer or a binary key of fixed size
+   stored at a fixed offset in every element. No compare function is called.
+   Sorting needs O(n * keysize) time.
+
+   Use <mergesort_t> if the sort order could only be described by a compare function.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/sort/radixsort.h
+    Header file <RadixSort>.
+
+   file: C-kern/ds/sort/radixsort.c
+    Implementation file <RadixSort impl>.
+*/
+#ifndef CKERN_DS_SORT_RADIXSORT_HEADER
+#define CKERN_DS_SORT_RADIXSORT_HEADER
+
+// forward
+struct perftest_info_t;
+
+/* typedef: struct radixsort_t
+ * Export <radixsort_t> into global namespace. */
+typedef struct radixsort_t radixsort_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_ds_sort_radixsort
+ * Test <radixsort_t> functionality. */
+int unittest_ds_sort_radixsort(void);
+#endif
+
+#ifdef KONFIG_PERFTEST
+/* function: perftest_ds_sort_radixsort
+ * Test sort performance of <sortuint_radixsort>. */
+int perftest_ds_sort_radixsort(/*out*/struct perftest_info_t* info);
+#endif
+
+
+/* struct: radixsort_t
+ * Implementation of a stable radix sort.
+ * Sorts the elements in ascending order of their keys.
+ *
+ * Complexity O(n * keysize).
+ *
+ * Every key is a sequence of keysize bytes (digits) stored at keyoffset in every element.
+ * The keys are compared either as unsigned integers in host byte order (<sortuint_radixsort>)
+ * or as byte strings like memcmp (<sortbinary_radixsort>).
+ *
+ * LSD:
+ * Keys of up to <radixsort_MAXLSDKEYSIZE> bytes are sorted from the least
+ * to the most significant digit. All histograms are computed in a single pass
+ * over the array. Every digit needs one counting sort pass which moves
+ * all elements between the array and the scratch buffer.
+ * A pass is skipped if all elements have the same digit.
+ *
+ * MSD:
+ * Longer keys are sorted from the most significant digit. Every bucket of elements
+ * which have the same prefix is sorted separately by the next digit. Buckets with
+ * less than <radixsort_INSERTSORTLEN> elements are sorted with insertion sort.
+ * Only the bytes of the key which are needed to differentiate elements are read.
+ *
+ * Scratch Memory:
+ * The sort needs a scratch buffer of <scratchsize_radixsort> bytes
+ * which is a little bit more than the size of the array.
+ * The buffer is either given by the caller in <initscratch_radixsort> or it is
+ * allocated during sorting. Allocated memory is reused by the next call to sort
+ * and freed in <free_radixsort>. */
+struct radixsort_t {
+   // group: private fields
+   /* variable: scratch
+    * Scratch memory provided by the caller. Could be 0. */
+   uint8_t * scratch;
+   /* variable: scratchsize
+    * Size in bytes of <scratch>. */
+   size_t    scratchsize;
+   /* variable: temp
+    * Allocated scratch memory. Used if <scratchsize> is too small. */
+   uint8_t * temp;
+   /* variable: tempsize
+    * Size in bytes of allocated memory <temp>. */
+   size_t    tempsize;
+};
+
+// group: configuration
+
+/* define: radixsort_MAXLSDKEYSIZE
+ * Keys with up to this number of bytes are sorted with the LSD algorithm.
+ * Longer keys are sorted with the MSD algorithm. */
+#define radixsort_MAXLSDKEYSIZE 8
+
+/* define: radixsort_INSERTSORTLEN
+ * Arrays (and MSD buckets) with less elements are sorted with insertion sort. */
+#define radixsort_INSERTSORTLEN 32
+
+// group: lifetime
+
+/* define: radixsort_FREE
+ * Static initializer. */
+#define radixsort_FREE \
+         { 0, 0, 0, 0 }
+
+/* function: init_radixsort
+ * Initializes sort. Scratch memory is allocated during sorting. */
+void init_radixsort(/*out*/radixsort_t * sort);
+
+/* function: initscratch_radixsort
+ * Initializes sort with scratch memory provided by the caller.
+ * The memory is used if it has at least <scratchsize_radixsort> bytes
+ * else memory is allocated during sorting.
+ * The caller owns scratch and must keep it valid until <free_radixsort> is called. */
+void initscratch_radixsort(/*out*/radixsort_t * sort, size_t scratchsize, void * scratch);
+
+/* function: free_radixsort
+ * Frees allocated scratch memory. Memory provided by the caller is not freed. */
+int free_radixsort(radixsort_t * sort);
+
+// group: query
+
+/* function: scratchsize_radixsort
+ * Returns the size in bytes of the scratch memory needed to sort len elements of size elemsize
+ * with keys of keysize bytes. Returns (size_t)-1 in case of overflow. */
+size_t scratchsize_radixsort(uint8_t elemsize, size_t len, uint8_t keysize);
+
+// group: sort
+
+/* function: sortuint_radixsort
+ * Sorts the array a which contains len elements of elemsize bytes each.
+ * Every element contains an unsigned integer key of keysize bytes stored in host byte order
+ * at offset keyoffset. The key needs no alignment and keysize could be any value,
+ * for example 3 or 16.
+ * The sorting is done in ascending order of the keys. The sort is stable.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - elemsize or keysize is 0 or keyoffset+keysize > elemsize or len*elemsize overflows.
+ * ENOMEM - No scratch memory. The array is not changed. */
+int sortuint_radixsort(radixsort_t * sort, uint8_t elemsize, size_t len, void * a/*uint8_t[len*elemsize]*/, uint8_t keyoffset, uint8_t keysize);
+
+/* function: sortbinary_radixsort
+ * Same as <sortuint_radixsort> except that keys are compared as byte strings (see memcmp).
+ * The first byte of a key is the most significant one. */
+int sortbinary_radixsort(radixsort_t * sort, uint8_t elemsize, size_t len, void * a/*uint8_t[len*elemsize]*/, uint8_t keyoffset, uint8_t keysize);
+
+
+#endif
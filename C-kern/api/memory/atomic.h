@@ -38,6 +38,11 @@
  * Alle Schreiboperation werden für andere Threads sichtbar gemacht. */
 void syncstore_memory(void);
 
+/* function: syncload_memory
+ * Acquire memory barrier. Leseoperationen nach dieser Barriere werden nicht
+ * vor Leseoperationen davor ausgeführt. Andere Threads sind nicht beteiligt. */
+void syncload_memory(void);
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -62,12 +67,26 @@ typedef int atomicint_t;
  * this thread will see the newest values written by other threads. */
 int read_atomicint(int* i);
 
+/* function: loadacquire_atomicint
+ * Liest den zuletzt geschriebenen Wert von *i, ohne *i zu beschreiben.
+ * Im Gegensatz zu <read_atomicint> wird die Cache-Line von i nicht exklusiv angefordert,
+ * so daß viele Threads denselben Wert abfragen können, ohne sich gegenseitig zu bremsen.
+ * Diese Operation beinhaltet auch eine acquire memory barrier. */
+int loadacquire_atomicint(int* i);
+
 /* function: write_atomicint
  * Writes newval into memory located at i.
  * This operation ensures also a release memory barrier. After this operation completes
  * other threads will see all write operations done by this thread before this atomic write operation. */
 void write_atomicint(int* i, int newval);
 
+/* function: storerelease_atomicint
+ * Schreibt newval nach *i, ohne den alten Wert zu lesen.
+ * Im Gegensatz zu <write_atomicint> wird keine compare and swap Schleife ausgeführt.
+ * Diese Operation beinhaltet auch eine release memory barrier. Ein anderer Thread, der den neuen Wert
+ * mit <loadacquire_atomicint> liest, sieht alle Schreiboperationen dieses Threads vor dieser Operation. */
+void storerelease_atomicint(int* i, int newval);
+
 /* function: clear_atomicint
  * Setzt *i auf 0 und gibt alten Wert von *i zurück als atomare Operation.
  * Diese Operation beinhaltet auch eine full memory barrier. */
@@ -125,6 +144,11 @@ void clear_atomicflag(uint8_t* flag);
 #define syncstore_memory() \
          __sync_synchronize()
 
+/* define: syncload_memory
+ * Implements <syncload_memory>. */
+#define syncload_memory() \
+         __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
 // group: atomicint_t
 
 /* define: add_atomicint
@@ -143,6 +167,16 @@ void clear_atomicflag(uint8_t* flag);
 #define read_atomicint(i) \
          (__sync_fetch_and_add((i), 0))
 
+/* define: loadacquire_atomicint
+ * Implements <atomicint_t.loadacquire_atomicint>. */
+#define loadacquire_atomicint(i) \
+         (__atomic_load_n((i), __ATOMIC_ACQUIRE))
+
+/* define: storerelease_atomicint
+ * Implements <atomicint_t.storerelease_atomicint>. */
+#define storerelease_atomicint(i, newval) \
+         (__atomic_store_n((i), (newval), __ATOMIC_RELEASE))
+
 /* define: sub_atomicint
  * Implements <atomicint_t.sub_atomicint>. */
 #define sub_atomicint(i, decrement) \
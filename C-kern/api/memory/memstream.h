@@ -25,6 +25,7 @@ struct string_t;
 // === exported types
 struct memstream_t;
 struct memstream_ro_t;
+struct memstream_byteset_t;
 
 
 // section: Functions
@@ -38,6 +39,43 @@ int unittest_memory_memstream(void);
 #endif
 
 
+/* define: memstream_byteset_MAXBYTE
+ * The maximum number of values a <memstream_byteset_t> could contain. */
+#define memstream_byteset_MAXBYTE 16
+
+/* struct: memstream_byteset_t
+ * A small set of byte values searched for by <findbyteset_memstream>.
+ * The bulk operations compare 16 bytes of the stream in one step with all bytes of the set
+ * if the target supports SSE2 and fall back to a byte by byte loop otherwise. */
+typedef struct memstream_byteset_t {
+   /* variable: nrbyte
+    * The number of valid entries in <byte>. nrbyte is always lower or equal to <memstream_byteset_MAXBYTE>. */
+   uint8_t nrbyte;
+   /* variable: byte
+    * The values contained in the set. */
+   uint8_t byte[memstream_byteset_MAXBYTE];
+} memstream_byteset_t;
+
+// group: lifetime
+
+/* define: memstream_byteset_INIT
+ * Static initializer. Initializes set with nrbyte values given as variable arguments.
+ *
+ * Example:
+ * > static const memstream_byteset_t s_space = memstream_byteset_INIT(3, ' ', '\t', '\r');
+ *
+ * Unchecked Precondition:
+ * - nrbyte <= memstream_byteset_MAXBYTE
+ * - nrbyte equals the number of arguments after nrbyte */
+#define memstream_byteset_INIT(nrbyte, ...) \
+         { (nrbyte), { __VA_ARGS__ } }
+
+/* function: init_memstreambyteset
+ * Initializes set with len values from array bytes.
+ * Returns EINVAL if len > <memstream_byteset_MAXBYTE>. */
+int init_memstreambyteset(/*out*/memstream_byteset_t * set, size_t len, const uint8_t bytes[len]);
+
+
 /* struct: memstream_ro_t
  * Wie <memstream_t>, erlaubt aber nur lesenden Zugriff auf den Speicher.
  * Zur Ansteuerung können dieselben Funktion, etwa <init_memstream>, Verwendung finden. */
@@ -66,6 +104,22 @@ void initPstr_memstreamro(/*out*/memstream_ro_t * memstr, const struct string_t
  * strukturkompatibel sind. */
 memstream_ro_t * cast_memstreamro(void * obj, IDNAME nameprefix);
 
+// group: query
+
+/* function: findbyteset_memstreamro
+ * Implements <findbyteset_memstream>. Returns the position of the first byte contained in set or 0. */
+const uint8_t * findbyteset_memstreamro(const memstream_ro_t * memstr, const memstream_byteset_t * set);
+
+/* function: findnotbyteset_memstreamro
+ * Implements <findnotbyteset_memstream>. Returns the position of the first byte not contained in set or 0. */
+const uint8_t * findnotbyteset_memstreamro(const memstream_ro_t * memstr, const memstream_byteset_t * set);
+
+// group: write
+
+/* function: copyuntil_memstreamro
+ * Implements <copyuntil_memstream>. */
+int copyuntil_memstreamro(struct memstream_t * dest, memstream_ro_t * src, uint8_t delimiter);
+
 
 /* struct: memstream_t
  * Wraps a memory block which points to start and end address.
@@ -135,6 +189,19 @@ size_t offset_memstream(const memstream_t * memstr, uint8_t * start);
  * The value 0 is returned if *memstr* does not contain the byte. */
 /*const*/ uint8_t * findbyte_memstream(const memstream_t * memstr, uint8_t byte);
 
+/* function: findbyteset_memstream
+ * Finds the first byte in memstr which is contained in set.
+ * The returned value points to the position of the found byte.
+ * The value 0 is returned if *memstr* contains no byte of set.
+ * 16 bytes are compared in one step (see <memstream_byteset_t>). */
+/*const*/ uint8_t * findbyteset_memstream(const memstream_t * memstr, const memstream_byteset_t * set);
+
+/* function: findnotbyteset_memstream
+ * Finds the first byte in memstr which is not contained in set.
+ * The returned value points to the position of the found byte.
+ * The value 0 is returned if all bytes of *memstr* are contained in set. */
+/*const*/ uint8_t * findnotbyteset_memstream(const memstream_t * memstr, const memstream_byteset_t * set);
+
 /* function: peek_memstream
  * Returns next to read byte in memstr without consuming it.
  * Several calls always return the same byte.
@@ -161,6 +228,11 @@ void skip_memstream(memstream_t * memstr, size_t len);
  * EINVAL - memstr wurde nicht verändert, da <size_memstream> < len. */
 int tryskip_memstream(memstream_t * memstr, size_t len);
 
+/* function: skipbyteset_memstream
+ * Increments memstr->next until it points to a byte not contained in set
+ * or until all bytes are read. Returns the number of skipped bytes. */
+size_t skipbyteset_memstream(memstream_t * memstr, const memstream_byteset_t * set);
+
 /* function: nextbyte_memstream
  * Gibt nächstes Byte von memstr zurück.
  * memstr->next wird um eins inkrementiert.
@@ -191,6 +263,17 @@ int printf_memstream(memstream_t * memstr, const char * format, ...);
  * len <= size_memstream(memstr) */
 void write_memstream(memstream_t * memstr, size_t len, const uint8_t src[len]);
 
+/* function: copyuntil_memstream
+ * Copies bytes from src to dest until delimiter is found in src.
+ * The delimiter is not copied. src->next and dest->next are incremented
+ * with the number of copied bytes. Parameter src could also be of type <memstream_ro_t>.
+ *
+ * Returns:
+ * 0       - The delimiter was found. src->next points to the delimiter.
+ * ENODATA - All bytes of src are copied and no delimiter was found.
+ * ENOBUFS - dest is full and the next byte of src is not the delimiter. */
+int copyuntil_memstream(memstream_t * dest, memstream_t * src, uint8_t delimiter);
+
 /* function: writebyte_memstream
  * Appends byte to memstr, memstr->next is incremented by one.
  *
@@ -275,6 +358,41 @@ memstream_t * cast_memstream(void * obj, IDNAME nameprefix);
                      size_memstream(_m));    \
          }))
 
+/* define: findbyteset_memstream
+ * Implements <memstream_t.findbyteset_memstream>. */
+#define findbyteset_memstream(memstr, set) \
+         ( __extension__ ({                              \
+            typeof(memstr) _m = (memstr);                \
+            memstream_ro_t _ro = memstream_INIT(         \
+                                    _m->next, _m->end);  \
+            (typeof(_m->next)) (uintptr_t)               \
+            findbyteset_memstreamro(&_ro, (set));        \
+         }))
+
+/* define: findnotbyteset_memstream
+ * Implements <memstream_t.findnotbyteset_memstream>. */
+#define findnotbyteset_memstream(memstr, set) \
+         ( __extension__ ({                              \
+            typeof(memstr) _m = (memstr);                \
+            memstream_ro_t _ro = memstream_INIT(         \
+                                    _m->next, _m->end);  \
+            (typeof(_m->next)) (uintptr_t)               \
+            findnotbyteset_memstreamro(&_ro, (set));     \
+         }))
+
+/* define: copyuntil_memstream
+ * Implements <memstream_t.copyuntil_memstream>. */
+#define copyuntil_memstream(dest, src, delimiter) \
+         ( __extension__ ({                              \
+            typeof(src) _s = (src);                      \
+            memstream_ro_t _ro = memstream_INIT(         \
+                                    _s->next, _s->end);  \
+            int _e = copyuntil_memstreamro(              \
+                        (dest), &_ro, (delimiter));      \
+            _s->next += (_ro.next - _s->next);           \
+            _e;                                          \
+         }))
+
 /* define: free_memstream
  * Implements <memstream_t.free_memstream>. */
 #define free_memstream(memstr) \
@@ -351,6 +469,21 @@ memstream_t * cast_memstream(void * obj, IDNAME nameprefix);
                       - _m2->next);       \
          }))
 
+/* define: skipbyteset_memstream
+ * Implements <memstream_t.skipbyteset_memstream>. */
+#define skipbyteset_memstream(memstr, set) \
+         ( __extension__ ({                              \
+            typeof(memstr) _m = (memstr);                \
+            memstream_ro_t _ro = memstream_INIT(         \
+                                    _m->next, _m->end);  \
+            const uint8_t * _f =                         \
+               findnotbyteset_memstreamro(&_ro, (set));  \
+            size_t _l = (size_t) ((_f ? _f : _ro.end)    \
+                                  - _ro.next);           \
+            _m->next += _l;                              \
+            _l;                                          \
+         }))
+
 /* define: skip_memstream
  * Implements <memstream_t.skip_memstream>. */
 #define skip_memstream(memstr, len) \
@@ -0,0 +1,184 @@
+/* title: ArenaMemoryManager
+
+   Implementation of <mm_it> which allocates memory blocks
+   by incrementing a pointer into a page of memory.
+   Freeing a single block does nothing. All blocks allocated
+   after a stored state are freed at once with <restore_mmarena>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/memory/mm/mm_arena.h
+    Header file <ArenaMemoryManager>.
+
+   file: C-kern/memory/mm/mm_arena.c
+    Implementation file <ArenaMemoryManager impl>.
+*/
+#ifndef CKERN_MEMORY_MM_MMARENA_HEADER
+#define CKERN_MEMORY_MM_MMARENA_HEADER
+
+// forward
+struct memblock_t;
+struct mm_arena_page_t;
+
+/* typedef: struct mm_arena_t
+ * Exports <mm_arena_t>. */
+typedef struct mm_arena_t mm_arena_t;
+
+/* typedef: struct mm_arena_state_t
+ * Exports <mm_arena_state_t>. */
+typedef struct mm_arena_state_t mm_arena_state_t;
+
+
+// section: Functions
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+/* function: unittest_memory_mm_mmarena
+ * Test arena memory manager <mm_arena_t>. */
+int unittest_memory_mm_mmarena(void);
+#endif
+
+
+/* struct: mm_arena_state_t
+ * Remembered allocation state of <mm_arena_t>.
+ * It is used to free all memory blocks allocated after
+ * the state was stored with a single call to <restore_mmarena>. */
+struct mm_arena_state_t {
+   struct mm_arena_page_t *page;
+   uint8_t                *next;
+   size_t                  allocated;
+};
+
+// group: lifetime
+
+/* define: mm_arena_state_FREE
+ * Static initializer. Describes the state of an empty <mm_arena_t>. */
+#define mm_arena_state_FREE { 0, 0, 0 }
+
+
+/* struct: mm_arena_t
+ * Arena memory manager for many short lived memory blocks which are freed together.
+ *
+ * Memory blocks are carved out of pages of size <mm_arena_PAGESIZE> allocated with <ALLOC_PAGECACHE>.
+ * A block which does not fit into such a page gets its own page of a larger size.
+ * Blocks are aligned to <KONFIG_MEMALIGN>.
+ *
+ * <mfree_mmarena> does not free anything. Call <storestate_mmarena> before the allocation
+ * of a group of blocks and <restore_mmarena> to free them all with one call.
+ * <reset_mmarena> frees all allocated blocks. Pages which become unused are kept in a cache
+ * for the next allocations. Only <free_mmarena> returns them to the <pagecache_t>.
+ *
+ * Use <interface_mmarena> to install an arena as memory manager of the current thread:
+ *
+ * > threadcontext_mm_t oldmm = tcontext_maincontext()->mm;
+ * > tcontext_maincontext()->mm = (threadcontext_mm_t) mm_INIT((struct mm_t*)&arena, interface_mmarena());
+ * > handle_request(); // ALLOC_MM allocates from arena
+ * > tcontext_maincontext()->mm = oldmm;
+ * > reset_mmarena(&arena);
+ *
+ * An arena must only be used from a single thread. */
+struct mm_arena_t {
+   /* variable: page
+    * The page memory is allocated from. Previous pages are linked with <mm_arena_page_t.prev>. */
+   struct mm_arena_page_t *page;
+   /* variable: freepage
+    * Cache of unused pages of size <mm_arena_PAGESIZE>. */
+   struct mm_arena_page_t *freepage;
+   /* variable: next
+    * Start address of the next allocated memory block. */
+   uint8_t                *next;
+   /* variable: end
+    * End address of <page>. Memory from <next> up to <end> is free. */
+   uint8_t                *end;
+   /* variable: allocated
+    * Sum of the sizes of all memory blocks allocated since the last reset. */
+   size_t                  allocated;
+};
+
+// group: config
+
+/* define: mm_arena_PAGESIZE
+ * Default size of a page memory blocks are allocated from.
+ * Equals the size of a page of type <pagesize_65536>. */
+#define mm_arena_PAGESIZE 65536
+
+// group: initthread
+
+/* function: interface_mmarena
+ * Returns interface of <mm_t> which allows to use <mm_arena_t> as <mm_t>. */
+struct mm_it * interface_mmarena(void);
+
+// group: lifetime
+
+/* define: mm_arena_FREE
+ * Static initializer. */
+#define mm_arena_FREE { 0, 0, 0, 0, 0 }
+
+/* function: init_mmarena
+ * Initializes a new arena memory manager. No memory is allocated. */
+int init_mmarena(/*out*/mm_arena_t * arena);
+
+/* function: free_mmarena
+ * Frees all memory blocks and returns all pages to the <pagecache_t>.
+ * Before freeing it make sure that every object allocated on
+ * this memory heap is no more reachable. */
+int free_mmarena(mm_arena_t * arena);
+
+// group: query
+
+/* function: sizeallocated_mmarena
+ * Returns the size in bytes of all memory blocks allocated since the last reset.
+ * Calling <mfree_mmarena> does not decrement this value. */
+size_t sizeallocated_mmarena(mm_arena_t * arena);
+
+// group: state
+
+/* function: storestate_mmarena
+ * Stores the current allocation state in state.
+ * Restoring it with <restore_mmarena> frees all memory blocks allocated in the meantime. */
+void storestate_mmarena(const mm_arena_t * arena, /*out*/mm_arena_state_t * state);
+
+/* function: restore_mmarena
+ * Frees all memory blocks allocated after state was stored.
+ * The time needed does not depend on the number of freed blocks only on the number of unused pages.
+ * Unused pages of size <mm_arena_PAGESIZE> are cached, larger ones are released.
+ *
+ * Example:
+ * > storestate_mmarena -> state0
+ * > ... allocate ...
+ * > storestate_mmarena -> state1
+ * > ... allocate ...
+ * > restore_mmarena(state1) -> arena reset to state1
+ * > restore_mmarena(state0) -> arena reset to state0
+ *
+ * Unchecked Precondition:
+ * - state was initialized by a previous call to storestate_mmarena or with <mm_arena_state_FREE>
+ * - no previous call to restore_mmarena was made with a state stored before state */
+int restore_mmarena(mm_arena_t * arena, const mm_arena_state_t * state);
+
+/* function: reset_mmarena
+ * Frees all allocated memory blocks. Same as calling <restore_mmarena> with <mm_arena_state_FREE>. */
+int reset_mmarena(mm_arena_t * arena);
+
+// group: allocate
+
+/* function: malloc_mmarena
+ * Allocates new memory block.
+ * The returned <memblock_t.size> is size rounded up to a multiple of <KONFIG_MEMALIGN>. */
+int malloc_mmarena(mm_arena_t * arena, size_t size, /*eout*/struct memblock_t * memblock);
+
+/* function: mresize_mmarena
+ * Allocates new memory or resizes already allocated memory.
+ * The last allocated memory block is resized in place if it fits into the current page.
+ * Every other block is copied into a newly allocated block. The memory of the old block is not freed. */
+int mresize_mmarena(mm_arena_t * arena, size_t newsize, struct memblock_t * memblock);
+
+/* function: mfree_mmarena
+ * Sets memblock to <memblock_FREE>. The memory is not freed until
+ * <restore_mmarena>, <reset_mmarena> or <free_mmarena> is called. */
+int mfree_mmarena(mm_arena_t * arena, struct memblock_t * memblock);
+
+
+#endif
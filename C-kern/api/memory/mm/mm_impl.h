@@ -19,11 +19,18 @@
 
 // forward
 struct memblock_t;
+struct perftest_info_t;
+struct mm_impl_object_t;
+struct mm_impl_state_t;
 
 /* typedef: struct mm_impl_t
  * Exports <mm_impl_t>. */
 typedef struct mm_impl_t mm_impl_t;
 
+/* typedef: struct mm_impl_stat_t
+ * Exports <mm_impl_stat_t>. */
+typedef struct mm_impl_stat_t mm_impl_stat_t;
+
 
 // section: Functions
 
@@ -35,13 +42,151 @@ typedef struct mm_impl_t mm_impl_t;
 int unittest_memory_mm_mmimpl(void);
 #endif
 
+#ifdef KONFIG_PERFTEST
+/* function: perftest_memory_mm_mmimpl
+ * Test allocation performance of <mm_impl_t>. */
+int perftest_memory_mm_mmimpl(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_memory_mm_mmimpl_remote
+ * Test allocation performance of <mm_impl_t> if memory is freed by another thread. */
+int perftest_memory_mm_mmimpl_remote(/*out*/struct perftest_info_t* info);
+
+/* function: perftest_memory_mm_mmimpl_malloc
+ * Test allocation performance of malloc from the C library for comparison. */
+int perftest_memory_mm_mmimpl_malloc(/*out*/struct perftest_info_t* info);
+#endif
+
+
+/* struct: mm_impl_stat_t
+ * Allocation statistics of one or more <mm_impl_t>.
+ * The counters are updated during every allocation and free operation
+ * and cost only a few increments so they are always turned on.
+ *
+ * Use <addstat_mmimpl> to read them and <logstat_mmimpl> to write them to a log channel.
+ * Use <collectstat_mmimpl> to read the statistics of the whole process.
+ *
+ * Counters of every size class and of medium and huge blocks:
+ * nralloc  - Number of allocated memory blocks.
+ * nrfree   - Number of freed memory blocks.
+ * nrused   - Number of memory blocks currently in use.
+ * peakused - Maximum value of nrused. If the counters of more than one <mm_impl_t> are added
+ *            this value is the largest peak of a single <mm_impl_t> and not the peak of the sum.
+ *
+ * Memory freed by another thread is counted by the owning <mm_impl_t> (same as <mm_impl_t.size_allocated>). */
+struct mm_impl_stat_t {
+   /* variable: sizeclass
+    * Counters for every size class of small objects.
+    * nrcached    - Number of free objects in slabs (length of free lists). Computed by <addstat_mmimpl>.
+    * nrslaballoc - Number of slabs allocated from the <pagecache_t>.
+    * nrslabfree  - Number of slabs returned to the <pagecache_t>. */
+   struct {
+      size_t   nralloc;
+      size_t   nrfree;
+      size_t   nrused;
+      size_t   peakused;
+      size_t   nrcached;
+      size_t   nrslaballoc;
+      size_t   nrslabfree;
+   }        sizeclass[24/*mm_impl_NRSIZECLASS*/];
+   /* variable: medium
+    * Counters of medium sized blocks (pages of the <pagecache_t>). */
+   struct {
+      size_t   nralloc;
+      size_t   nrfree;
+      size_t   nrused;
+      size_t   peakused;
+   }        medium;
+   /* variable: huge
+    * Counters of huge blocks which are mapped from and returned to the operating system. */
+   struct {
+      size_t   nralloc;
+      size_t   nrfree;
+      size_t   nrused;
+      size_t   peakused;
+   }        huge;
+   /* variable: nrremote
+    * Number of small objects and medium or huge blocks freed by other threads. */
+   size_t   nrremote;
+};
+
+// group: lifetime
+
+/* define: mm_impl_stat_FREE
+ * Static initializer. Sets all counters to 0. */
+#define mm_impl_stat_FREE { { { 0, 0, 0, 0, 0, 0, 0 } }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, 0 }
+
 
 /* struct: mm_impl_t
- * Default memory manager for allocating/freeing blocks of memory. */
+ * Default memory manager for allocating/freeing blocks of memory.
+ *
+ * Size Classes:
+ * The requested size determines which allocator serves the memory.
+ *
+ * small  - size <= <mm_impl_MAXSMALLSIZE>. Size is rounded up to one of <mm_impl_NRSIZECLASS> size classes.
+ *          Objects of the same class are carved out of a slab of size <mm_impl_SLABSIZE>.
+ *          A slab is a page allocated with <ALLOC_PAGECACHE>. Every <mm_impl_t> keeps its own lists
+ *          of slabs so it works as a per-thread cache without any locking.
+ * medium - size <= <mm_impl_MAXMEDIUMSIZE>-<mm_impl_BLOCKHEADERSIZE>. A single page of the next power of two size
+ *          of size+<mm_impl_BLOCKHEADERSIZE> is allocated with <ALLOC_PAGECACHE>.
+ * huge   - size > <mm_impl_MAXMEDIUMSIZE>-<mm_impl_BLOCKHEADERSIZE>. Memory is mapped with <init_vmpage>.
+ *
+ * Medium and huge blocks start with a header of size <mm_impl_BLOCKHEADERSIZE> which stores the owning
+ * <mm_impl_t>. The returned memory starts after the header.
+ *
+ * The size of a returned <memblock_t> is always the size of its size class which is also the value
+ * added to <size_allocated>. Freeing a memblock whose size was set back to the requested size
+ * is supported cause it maps to the same size class.
+ *
+ * Threads:
+ * A small object freed with the <mm_impl_t> of another thread is pushed onto the lock-free <remotelist>
+ * of the owning <mm_impl_t>. Medium and huge blocks are pushed onto <remoteblocklist>.
+ * The owner frees them during its next call to <malloc_mmimpl>, <mresize_mmimpl> or <mfree_mmimpl>.
+ * So the size is always subtracted from <size_allocated> of the owner.
+ *
+ * Static Size:
+ * Every thread stores an <mm_impl_t> in its static memory. Therefore the lists of slabs and blocks
+ * and the allocation counters are stored in <state> which is allocated from the <pagecache_t>
+ * during the first allocation. */
 struct mm_impl_t {
+   /* variable: size_allocated
+    * Sum of the sizes of all allocated memory blocks. */
    size_t size_allocated;
+   /* variable: remotelist
+    * Lock-free stack of small objects freed by other threads. */
+   struct mm_impl_object_t * volatile remotelist;
+   /* variable: remoteblocklist
+    * Lock-free stack of medium and huge blocks freed by other threads. */
+   struct mm_impl_object_t * volatile remoteblocklist;
+   /* variable: state
+    * Lists of slabs for every size class, list of medium and huge blocks and allocation counters.
+    * Allocated during first call to <malloc_mmimpl>. Read the counters with <addstat_mmimpl>. */
+   struct mm_impl_state_t  * state;
 };
 
+// group: config
+
+/* define: mm_impl_NRSIZECLASS
+ * Number of size classes for small objects. */
+#define mm_impl_NRSIZECLASS 24
+
+/* define: mm_impl_MAXSMALLSIZE
+ * Objects up to this size are allocated from slabs. */
+#define mm_impl_MAXSMALLSIZE 2048
+
+/* define: mm_impl_MAXMEDIUMSIZE
+ * Objects up to this size minus <mm_impl_BLOCKHEADERSIZE> (and greater than <mm_impl_MAXSMALLSIZE>)
+ * are allocated as a single page from the <pagecache_t>. */
+#define mm_impl_MAXMEDIUMSIZE (1024*1024)
+
+/* define: mm_impl_BLOCKHEADERSIZE
+ * Size of the header which precedes every medium and huge block. */
+#define mm_impl_BLOCKHEADERSIZE 64
+
+/* define: mm_impl_SLABSIZE
+ * Size of a slab which stores small objects of the same size class.
+ * Equals the size of a page of type <pagesize_65536>. */
+#define mm_impl_SLABSIZE 65536
+
 // group: initthread
 
 /* function: interface_mmimpl
@@ -53,7 +198,7 @@ struct mm_it * interface_mmimpl(void);
 
 /* define: mmimpl_FREE
  * Static initializer. */
-#define mmimpl_FREE { 0 }
+#define mmimpl_FREE { 0, 0, 0, 0 }
 
 /* function: init_mmimpl
  * Initializes a new memory manager. */
@@ -62,7 +207,12 @@ int init_mmimpl(/*out*/mm_impl_t * mman);
 /* function: free_mmimpl
  * Frees all memory managed by this manager.
  * Beofre freeing it make sure that every object allocated on
- * this memory heap is no more reachable or already freed. */
+ * this memory heap is no more reachable or already freed.
+ *
+ * Slabs which contain used objects and medium or huge blocks which are still in use
+ * are not released but become orphaned. They are released if the last object is freed
+ * with <mfree_mmimpl> of any <mm_impl_t> (possibly running in another thread).
+ * Objects which are never freed leak their slab until the <pagecache_t> is freed. */
 int free_mmimpl(mm_impl_t * mman);
 
 // group: query
@@ -72,6 +222,29 @@ int free_mmimpl(mm_impl_t * mman);
  * If this value is 0 no memory is allocated on this heap. */
 size_t sizeallocated_mmimpl(mm_impl_t * mman);
 
+// group: statistics
+
+/* function: addstat_mmimpl
+ * Adds the allocation counters of mman to stat. Peak values are not added, the larger one is kept.
+ * The number of free objects of every size class is computed from the number of slabs in use.
+ * Nothing is added if mman has never allocated memory or has been freed.
+ * Any thread could call this function. The counters are read atomically under a global lock
+ * which prevents the owner from freeing them meanwhile. The values of different counters
+ * could be off by the operations the owner executes during the read. */
+void addstat_mmimpl(mm_impl_t * mman, /*inout*/mm_impl_stat_t * stat);
+
+/* function: collectstat_mmimpl
+ * Adds the allocation counters of every <mm_impl_t> of the process to stat.
+ * Every <mm_impl_t> which has allocated memory and is not freed is visited the same way as <addstat_mmimpl> does.
+ * Initialize stat with <mm_impl_stat_FREE> before. */
+void collectstat_mmimpl(/*inout*/mm_impl_stat_t * stat);
+
+/* function: logstat_mmimpl
+ * Writes stat as human readable text to logchannel.
+ * Only size classes which were ever allocated are written.
+ * Parameter logchannel is of type <log_channel_e>. */
+void logstat_mmimpl(const mm_impl_stat_t * stat, uint8_t logchannel);
+
 // group: allocate
 
 /* function: malloc_mmimpl
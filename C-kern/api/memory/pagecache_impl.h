@@ -31,10 +31,16 @@
 // forward
 struct memblock_t;
 struct dlist_node_t;
+struct remotepage_t;
+struct pagecache_impl_counter_t;
 
 // export
 struct pagecache_impl_t;
 
+/* typedef: struct pagecache_impl_stat_t
+ * Export <pagecache_impl_stat_t> into global namespace. */
+typedef struct pagecache_impl_stat_t pagecache_impl_stat_t;
+
 
 // section: Functions
 
@@ -47,13 +53,62 @@ int unittest_memory_pagecacheimpl(void);
 #endif
 
 
+/* struct: pagecache_impl_stat_t
+ * Allocation statistics of one or more <pagecache_impl_t>.
+ * The counters are updated during every allocation and release of a page.
+ * This costs only a few increments so they are always turned on.
+ *
+ * Use <addstat_pagecacheimpl> to read them and <logstat_pagecacheimpl> to write them
+ * to a log channel. Use <collectstat_pagecacheimpl> to read the statistics of the whole process. */
+struct pagecache_impl_stat_t {
+   /* variable: pgsize
+    * Counters for every <pagesize_e>.
+    * nralloc  - Number of allocated pages.
+    * nrfree   - Number of released pages (including pages released by other threads).
+    * nrused   - Number of pages currently in use.
+    * peakused - Maximum value of nrused. If the counters of more than one <pagecache_impl_t> are added
+    *            this value is the largest peak of a single <pagecache_impl_t> and not the peak of the sum.
+    * nrcached - Number of free pages which could be allocated without using an unused sub-block
+    *            (length of free page list). This value is computed by <addstat_pagecacheimpl>. */
+   struct {
+      size_t   nralloc;
+      size_t   nrfree;
+      size_t   nrused;
+      size_t   peakused;
+      size_t   nrcached;
+   }        pgsize[pagesize__NROF];
+   /* variable: nrremote
+    * Number of pages released by other threads. */
+   size_t   nrremote;
+   /* variable: nrblockalloc
+    * Number of blocks of size <pagecache_impl_BLOCKSIZE> acquired from the operating system. */
+   size_t   nrblockalloc;
+   /* variable: nrblockfree
+    * Number of blocks returned to the operating system. */
+   size_t   nrblockfree;
+};
+
+// group: lifetime
+
+/* define: pagecache_impl_stat_FREE
+ * Static initializer. Sets all counters to 0. */
+#define pagecache_impl_stat_FREE \
+         { { { 0, 0, 0, 0, 0 } }, 0, 0, 0 }
+
+
 /* struct: pagecache_impl_t
  * Allocates and frees virtual memory pages and caches them exclusively for one thread.
  * This type is *not* thread safe. So you should use it only in a thread context.
+ * The only exception is releasing a page which was allocated by another thread.
+ * Such a page is pushed onto a lock-free list of the owning <pagecache_impl_t>
+ * (see <remotelist>) and the owner releases it later during its next call to
+ * <allocpage_pagecacheimpl>, <releasepage_pagecacheimpl> or <emptycache_pagecacheimpl>.
  * The <pagecache_impl_t> allocates always blocks of memory of size pagecache_impl_BLOCKSIZE.
  * Every <block_t> is divided into sub-blocks of size pagecache_impl_SUBBLOCKSIZE.
  * For every allocation of a page with size pagesize either a new unused sub-block is allocated
  * or one which contains free pages is used.
+ * Blocks are aligned to their own size and could be backed by huge pages to reduce TLB misses
+ * (see <sethugepage_pagecacheimpl>).
  *
  * TODO: To prevent fragmentation of large blocks introduce page lifetime (long, short lifetime, ...).
  *       This helps to place longer living pages on one big block and short living pages on another.
@@ -87,6 +142,29 @@ typedef struct pagecache_impl_t {
     * This number is incremented by every call to <allocpage_pagecacheimpl>
     * and decremented by every call to <releasepage_pagecacheimpl>. */
    size_t   sizeallocated;
+   /* variable: remotelist
+    * Lock-free stack of pages released by other threads.
+    * Other threads push with an atomic compare and swap operation.
+    * The owner removes all pages at once and releases them as one batch. */
+   struct remotepage_t * volatile remotelist;
+   /* variable: hugepage
+    * Strategy (value of <vmhuge_e>) used to back newly allocated blocks with huge pages.
+    * Default is vmhuge_NONE. Set it with <sethugepage_pagecacheimpl>. */
+   uint8_t  hugepage;
+   /* variable: prefault
+    * Strategy (value of <vmprefault_e>) used to map physical memory for a sub-block
+    * before the first page is allocated from it. Default is vmprefault_NONE.
+    * Set it with <setprefault_pagecacheimpl>. */
+   uint8_t  prefault;
+   /* variable: nrhugeblocks
+    * Number of allocated blocks which are backed by huge pages.
+    * Blocks backed by normal pages are not counted. */
+   size_t   nrhugeblocks;
+   /* variable: counter
+    * Allocation counters. They are mapped before the first block is allocated and unmapped
+    * by <free_pagecacheimpl>. Stored outside cause <pagecache_impl_t> is part of the static memory
+    * of every thread. Read the counters with <addstat_pagecacheimpl>. */
+   struct pagecache_impl_counter_t * counter;
 } pagecache_impl_t;
 
 // group: config
@@ -125,7 +203,7 @@ struct pagecache_it* interface_pagecacheimpl(void);
 /* define: pagecache_impl_FREE
  * Static initializer. */
 #define pagecache_impl_FREE \
-         { { 0 }, { 0 }, { { 0 } }, 0 }
+         { { 0 }, { 0 }, { { 0 } }, 0, 0, 0, 0, 0, 0 }
 
 /* function: init_pagecacheimpl
  * Preallocates at least 1MB of memory and initializes pgcache. */
@@ -148,22 +226,92 @@ int free_pagecacheimpl(pagecache_impl_t* pgcache);
  * Static memory is also allocated with help of <allocpage_pagecacheimpl>. */
 size_t sizeallocated_pagecacheimpl(const pagecache_impl_t* pgcache);
 
+/* function: nrhugeblocks_pagecacheimpl
+ * Returns the number of allocated blocks which are backed by huge pages.
+ * A block of size pagecache_impl_BLOCKSIZE is backed by huge pages either with
+ * reserved huge pages (vmhuge_HUGETLB) or with transparent huge pages (vmhuge_ADVISE).
+ * In case of vmhuge_ADVISE the OS decides at page fault time. */
+size_t nrhugeblocks_pagecacheimpl(const pagecache_impl_t* pgcache);
+
 /* function: isfree_pagecacheimpl
  * Returns true if pgcache equals <pagecache_impl_FREE>. */
 bool isfree_pagecacheimpl(const pagecache_impl_t* pgcache);
 
+// group: statistics
+
+/* function: addstat_pagecacheimpl
+ * Adds the allocation counters of pgcache to stat. Peak values are not added, the larger one is kept.
+ * The number of cached free pages is computed from the number of sub-blocks assigned to a page size.
+ * Nothing is added if pgcache has never allocated a block or has been freed.
+ * Any thread could call this function. The counters are read atomically under a global lock
+ * which prevents the owner from unmapping them meanwhile. The values of different counters
+ * could be off by the operations the owner executes during the read. */
+void addstat_pagecacheimpl(pagecache_impl_t* pgcache, /*inout*/pagecache_impl_stat_t* stat);
+
+/* function: collectstat_pagecacheimpl
+ * Adds the allocation counters of every <pagecache_impl_t> of the process to stat.
+ * Every <pagecache_impl_t> which has allocated a block and is not freed is visited the same way
+ * as <addstat_pagecacheimpl> does. Initialize stat with <pagecache_impl_stat_FREE> before. */
+void collectstat_pagecacheimpl(/*inout*/pagecache_impl_stat_t* stat);
+
+/* function: logstat_pagecacheimpl
+ * Writes stat as human readable text to logchannel.
+ * Only page sizes which were ever allocated are written.
+ * Parameter logchannel is of type <log_channel_e>. */
+void logstat_pagecacheimpl(const pagecache_impl_stat_t* stat, uint8_t logchannel);
+
+// group: config
+
+/* function: sethugepage_pagecacheimpl
+ * Sets the huge page strategy used for all blocks allocated after this call.
+ * Parameter hugepage must be a value of <vmhuge_e>. vmhuge_NONE (default) switches it off.
+ * vmhuge_ADVISE advises the OS to use transparent huge pages.
+ * vmhuge_HUGETLB tries to use reserved huge pages and falls back to vmhuge_ADVISE and then vmhuge_NONE.
+ * Already allocated blocks are not changed. */
+int sethugepage_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t hugepage);
+
+/* function: setprefault_pagecacheimpl
+ * Sets the prefault strategy used for sub-blocks which are used the first time after this call.
+ * Parameter prefault must be a value of <vmprefault_e>. vmprefault_NONE (default) switches it off.
+ * vmprefault_POPULATE maps physical memory for the whole sub-block (1MB) before the first page
+ * is allocated from it. Therefore allocated pages cause no page faults at first access.
+ * vmprefault_LOCK locks the sub-block into RAM in addition. If locking fails (RLIMIT_MEMLOCK)
+ * the error is logged and the page is allocated nevertheless.
+ * Already used sub-blocks are not changed. See also <warm_pagecacheimpl>. */
+int setprefault_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t prefault);
+
+// group: cache
+
+/* function: warm_pagecacheimpl
+ * Pre-sizes the cache so that nrpages pages of size pgsize could be allocated without acquiring
+ * a new block from the OS and without page faults at first access.
+ * Call this function during startup of a thread (e.g. in the main function
+ * given to <maincontext_t.initrun_maincontext>) with the expected load.
+ * The pages are allocated, prefaulted (see <prefault_vmpage>) and released.
+ * Blocks acquired during warming are kept even if they contain no more used pages.
+ * Only <emptycache_pagecacheimpl> returns them to the OS.
+ * Pages are locked into RAM if <setprefault_pagecacheimpl> was called with vmprefault_LOCK.
+ * The counters of <pagecache_impl_stat_t.pgsize> are not changed. */
+int warm_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t pgsize, size_t nrpages);
+
 // group: alloc
 
 /* function: allocpage_pagecacheimpl
  * Allocates a single memory page of size pgsize.
- * The page is aligned to its own size. */
+ * The page is aligned to its own size.
+ * Pages released by other threads are released before a new page is allocated. */
 int allocpage_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t pgsize, /*out*/struct memblock_t* page);
 
 /* function: releasepage_pagecacheimpl
  * Releases a single memory page. It is kept in the cache and only returned to
  * the operating system if a big chunk of memory is not in use.
  * After return page is set to <memblock_FREE>. Calling this function with
- * page set to <memblock_FREE> does nothing. */
+ * page set to <memblock_FREE> does nothing.
+ *
+ * Remote Release:
+ * If page was allocated by a <pagecache_impl_t> of another thread it is pushed
+ * onto <remotelist> of the owner. The owner must not have been freed.
+ * Pages pushed by other threads are released before this function returns. */
 int releasepage_pagecacheimpl(pagecache_impl_t* pgcache, struct memblock_t* page);
 
 // group: cache
@@ -22,6 +22,10 @@
  * Exports <vmpage_t> into global namespace. */
 typedef struct vmpage_t vmpage_t;
 
+/* typedef: struct vmreserve_t
+ * Exports <vmreserve_t>, a reserved address range whose pages are committed on demand. */
+typedef struct vmreserve_t vmreserve_t;
+
 /* typedef: struct vm_region_t
  * Exports <vm_region_t>, describes a single virtual memory region. */
 typedef struct vm_region_t vm_region_t;
@@ -34,6 +38,42 @@ typedef struct vm_mappedregions_t vm_mappedregions_t;
  * Internal type used by <vm_mappedregions_t>. */
 typedef struct vm_regionsarray_t vm_regionsarray_t;
 
+/* enums: vmhuge_e
+ * Describes how mapped memory is backed by huge pages.
+ *
+ * vmhuge_NONE    - Memory is backed by pages of size <pagesize_vm>.
+ * vmhuge_ADVISE  - The OS was advised to back memory with transparent huge pages.
+ *                  Linux uses madvise(MADV_HUGEPAGE). The OS decides at page fault time
+ *                  if a huge page is used or not.
+ * vmhuge_HUGETLB - Memory is backed by reserved huge pages of size <vm_HUGEPAGESIZE>.
+ *                  Linux uses mmap with flag MAP_HUGETLB.
+ * */
+typedef enum vmhuge_e {
+   vmhuge_NONE,
+   vmhuge_ADVISE,
+   vmhuge_HUGETLB
+} vmhuge_e;
+
+/* enums: vmprefault_e
+ * Describes how the physical pages of mapped memory are acquired.
+ *
+ * vmprefault_NONE     - The OS maps a physical page at the time of the first access (page fault).
+ * vmprefault_POPULATE - All pages are mapped in advance. Linux uses madvise(MADV_POPULATE_WRITE)
+ *                       and falls back to writing to every page.
+ * vmprefault_LOCK     - All pages are mapped in advance and locked into RAM (mlock).
+ *                       They are never swapped out. Unmapping the memory unlocks it.
+ * */
+typedef enum vmprefault_e {
+   vmprefault_NONE,
+   vmprefault_POPULATE,
+   vmprefault_LOCK
+} vmprefault_e;
+
+/* define: vm_HUGEPAGESIZE
+ * Size of a huge page in bytes. Memory mapped with <initalignedhuge_vmpage> must be a multiple of it
+ * else it is backed by normal pages. */
+#define vm_HUGEPAGESIZE (2u*1024u*1024u)
+
 
 // section: Functions
 
@@ -132,6 +172,29 @@ int init2_vmpage(/*out*/vmpage_t * vmpage, size_t size_in_bytes, const accessmod
  * EINVAL is returned in case powerof2_size_in_bytes < <pagesize_vm> or if it is not a power of 2. */
 int initaligned_vmpage(/*out*/vmpage_t * vmpage, size_t powerof2_size_in_bytes);
 
+/* function: initalignedhuge_vmpage
+ * Same as <initaligned_vmpage> but tries to back the new memory with huge pages.
+ * Parameter mode determines the strategy. <vmhuge_HUGETLB> tries reserved huge pages first
+ * and falls back to <vmhuge_ADVISE> which itself falls back to <vmhuge_NONE>.
+ * The strategy which succeeded is returned in huge. If powerof2_size_in_bytes is not a multiple
+ * of <vm_HUGEPAGESIZE> huge is always set to <vmhuge_NONE>.
+ * Falling back is not considered an error and is not logged. */
+int initalignedhuge_vmpage(/*out*/vmpage_t * vmpage, size_t powerof2_size_in_bytes, vmhuge_e mode, /*out*/vmhuge_e * huge);
+
+/* function: initfile_vmpage
+ * Maps the first size_in_bytes bytes of the file described by fd read-only into
+ * the virtual address space of the calling process.
+ * The mapped size is size_in_bytes rounded up to next multiple of <pagesize_vm>.
+ * Bytes of the last page beyond the end of the file read as 0. Do not access whole pages
+ * beyond the end of the file (memory exception). The mapping is private and independent
+ * of fd which could be closed after return. The mapping is removed with <free_vmpage>.
+ *
+ * Returns:
+ * 0      - Success.
+ * EINVAL - size_in_bytes is 0 or overflows if rounded up.
+ * EBADF  - fd is not an opened file. */
+int initfile_vmpage(/*out*/vmpage_t * vmpage, sys_iochannel_t fd, size_t size_in_bytes);
+
 /* function: free_vmpage
  * Invalidates virtual memory address range
  * > vmpage->addr[0 .. vmpage->size - 1 ]
@@ -154,6 +217,17 @@ bool isfree_vmpage(const vmpage_t* vmpage);
  * <accessmode_PRIVATE> and <accessmode_SHARED> can not be changed after creation. */
 int protect_vmpage(const vmpage_t* vmpage, const accessmode_e access_mode);
 
+/* function: prefault_vmpage
+ * Maps physical memory for all pages of vmpage to prevent page faults at first access.
+ * See <vmprefault_e> for the meaning of parameter mode. vmprefault_NONE does nothing.
+ * In case of vmprefault_LOCK the error ENOMEM or EPERM is returned if the limit of
+ * lockable memory (RLIMIT_MEMLOCK) is exceeded.
+ *
+ * Unchecked Precondition:
+ * - vmpage is mapped readable and writeable
+ * - no other thread writes concurrently to vmpage (the fallback of vmprefault_POPULATE rewrites the first byte of every page) */
+int prefault_vmpage(const vmpage_t * vmpage, vmprefault_e mode);
+
 /* function: tryexpand_vmpage
  * Tries to grow the upper bound of an already mapped address range.
  * The new memory size is size_in_bytes rounded up to next multiple of <pagesize_vm>.
@@ -193,6 +267,71 @@ int shrink_vmpage(vmpage_t * vmpage, size_t size_in_bytes);
 vmpage_t * cast_vmpage(void * obj, IDNAME nameprefix);
 
 
+/* struct: vmreserve_t
+ * Reserved virtual address range which is committed on demand.
+ * <init_vmreserve> reserves an address range of a fixed maximum size
+ * without any access rights (PROT_NONE). Only the first <size> bytes are read and writeable.
+ * <grow_vmreserve> commits more pages and <shrink_vmreserve> returns pages to the OS
+ * (madvise MADV_DONTNEED) and removes access rights.
+ *
+ * In contrast to <movexpand_vmpage> growing never moves the memory.
+ * Pointers into the committed range stay valid until the range is shrunk or freed.
+ * The fields <addr> and <size> are compatible with <vmpage_t> (see <cast_vmpage>). */
+struct vmreserve_t {
+   /* variable: addr
+    * Points to start (lowest) address of reserved memory. */
+   uint8_t *   addr;
+   /* variable: size
+    * Size of the committed, read and writeable memory in bytes.
+    * The committed memory region is
+    * > addr[ 0 .. size - 1 ] */
+   size_t      size;
+   /* variable: reserved
+    * Size of the reserved address range in bytes. Always >= <size>. */
+   size_t      reserved;
+};
+
+// group: lifetime
+
+/* define: vmreserve_FREE
+ * Static initializer. Freeing such a <vmreserve_t> is safe. */
+#define vmreserve_FREE { 0, 0, 0 }
+
+/* function: init_vmreserve
+ * Reserves reserve_in_bytes bytes of address space and commits the first size_in_bytes bytes.
+ * Both values are rounded up to the next multiple of <pagesize_vm>.
+ * The reserved address range is mapped without access rights and does not consume any memory.
+ * EINVAL is returned if reserve_in_bytes is 0 or size_in_bytes > reserve_in_bytes. */
+int init_vmreserve(/*out*/vmreserve_t * vmres, size_t size_in_bytes, size_t reserve_in_bytes);
+
+/* function: free_vmreserve
+ * Unmaps the whole reserved address range. vmres is set to <vmreserve_FREE>.
+ * Freeing an already freed <vmreserve_t> does nothing. */
+int free_vmreserve(vmreserve_t * vmres);
+
+// group: query
+
+/* function: isfree_vmreserve
+ * Returns true if vmres equals <vmreserve_FREE>. */
+bool isfree_vmreserve(const vmreserve_t * vmres);
+
+// group: change
+
+/* function: grow_vmreserve
+ * Commits the memory up to size_in_bytes rounded up to next multiple of <pagesize_vm>.
+ * The start address is never changed.
+ * Returns EINVAL if size_in_bytes rounded up is lower than vmres->size and ENOMEM
+ * if it is greater than vmres->reserved. In case of an error nothing is changed. */
+int grow_vmreserve(vmreserve_t * vmres, size_t size_in_bytes);
+
+/* function: shrink_vmreserve
+ * Returns memory beyond size_in_bytes (rounded up to next multiple of <pagesize_vm>) to the OS.
+ * The pages are still reserved but any access generates a memory exception until
+ * they are committed again with <grow_vmreserve>. Their content is lost.
+ * Returns EINVAL if size_in_bytes is greater than vmres->size. */
+int shrink_vmreserve(vmreserve_t * vmres, size_t size_in_bytes);
+
+
 /* struct: vm_region_t
  * Returns information about a mapped memory region and its access permissions. */
 struct vm_region_t
@@ -330,6 +469,11 @@ const vm_region_t * next_vmmappedregions(vm_mappedregions_t * iterator);
 #define isfree_vmpage(vmpage)  \
          (0 == (vmpage)->addr && 0 == (vmpage)->size)
 
+/* define: isfree_vmreserve
+ * Implements <vmreserve_t.isfree_vmreserve>. */
+#define isfree_vmreserve(vmres)  \
+         (0 == (vmres)->addr && 0 == (vmres)->reserved)
+
 /* define: log2pagesize_vm
  * Uses cached value from <maincontext_t.sysinfo_maincontext>. */
 #define log2pagesize_vm()                       (sysinfo_maincontext().log2pagesize_vm)
@@ -22,11 +22,17 @@
 
 // forward
 struct memstream_t;
+struct memvec_t;
+struct wbuffer_page_t;
 
 /* typedef: struct wbuffer_t
  * Export <wbuffer_t>. */
 typedef struct wbuffer_t wbuffer_t;
 
+/* typedef: struct wbuffer_chain_t
+ * Export <wbuffer_chain_t>. */
+typedef struct wbuffer_chain_t wbuffer_chain_t;
+
 /* typedef: struct wbuffer_it
  * Export interface <wbuffer_it>.*/
 typedef struct wbuffer_it wbuffer_it;
@@ -43,6 +49,14 @@ extern wbuffer_it g_wbuffer_memblock;
  * Adapt <wbuffer_t> to a static buffer. */
 extern wbuffer_it g_wbuffer_static;
 
+/* variable: g_wbuffer_vmreserve
+ * Adapt <wbuffer_t> to use <vmreserve_t> as buffer. */
+extern wbuffer_it g_wbuffer_vmreserve;
+
+/* variable: g_wbuffer_chain
+ * Adapt <wbuffer_t> to use <wbuffer_chain_t> as segmented buffer. */
+extern wbuffer_it g_wbuffer_chain;
+
 
 // section: Functions
 
@@ -83,11 +97,11 @@ struct wbuffer_it {
 
 /* struct: wbuffer_t
  * Supports construction of return values of unknown size.
- * The data is stored in an object of type <cstring_t>, <memblock_t>
+ * The data is stored in an object of type <cstring_t>, <memblock_t>, <vmreserve_t>, <wbuffer_chain_t>
  * or static allocated memory.
  *
- * Use <wbuffer_INIT_CSTRING>, <wbuffer_INIT_MEMBLOCK> or <wbuffer_INIT_STATIC>
- * to initialize a <wbuffer_t>. After initialization of wbuffer_t you are not
+ * Use <wbuffer_INIT_CSTRING>, <wbuffer_INIT_MEMBLOCK>, <wbuffer_INIT_VMRESERVE>, <wbuffer_INIT_CHAIN>
+ * or <wbuffer_INIT_STATIC> to initialize a <wbuffer_t>. After initialization of wbuffer_t you are not
  * allowed to change the wrapped object until after the result is written into
  * the buffer. wbuffer_t caches some values so if you change <cstring_t> or a <memblock_t>
  * after having it wrapped into a wbuffer_t the behaviour is undefined.
@@ -98,6 +112,13 @@ struct wbuffer_it {
  * wbuffer_t does not allocate memory for itself so you do not need to free an initialized object.
  * But you have to free the wrapped object.
  *
+ * Segmented Buffer:
+ * All wrapped objects except <wbuffer_chain_t> store the content in a single contiguous block
+ * of memory which is copied if it must grow. <wbuffer_chain_t> never moves already written bytes,
+ * it appends a new page to its chain instead. Use <getmemvec_wbuffer> to get the content
+ * as a list of memory blocks which could be written with a single call to writev.
+ * Every value returned from <appendbytes_wbuffer> is contiguous in all modes.
+ *
  * TODO: support temporary allocator with wbuffer_INIT_TEMPMEM
  *
  * */
@@ -135,6 +156,27 @@ struct wbuffer_t {
 #define wbuffer_INIT_MEMBLOCK(memblock) \
          wbuffer_INIT_OTHER(size_memblock(memblock), addr_memblock(memblock), memblock, &g_wbuffer_memblock)
 
+/* define: wbuffer_INIT_VMRESERVE
+ * Static initializer which wraps a <vmreserve_t> object into a <wbuffer_t>.
+ * If the committed memory is not big enough <grow_vmreserve> is called.
+ * The buffer is never moved in memory so growing it never copies the written data.
+ * Reserving memory beyond <vmreserve_t.reserved> results in ENOMEM.
+ *
+ * Parameter:
+ * vmres - Pointer to <vmreserve_t> initialized with <init_vmreserve>. */
+#define wbuffer_INIT_VMRESERVE(vmres) \
+         wbuffer_INIT_OTHER((vmres)->size, (vmres)->addr, vmres, &g_wbuffer_vmreserve)
+
+/* define: wbuffer_INIT_CHAIN
+ * Static initializer which wraps a <wbuffer_chain_t> object into a <wbuffer_t>.
+ * If the last page of the chain is full a new page is allocated and appended.
+ *
+ * Parameter:
+ * chain - Pointer to <wbuffer_chain_t> initialized with <init_wbufferchain>.
+ *         It must not contain any pages (no pages are allocated before the first append). */
+#define wbuffer_INIT_CHAIN(chain) \
+         wbuffer_INIT_OTHER(0, (uint8_t*)0, chain, &g_wbuffer_chain)
+
 /* define: wbuffer_INIT_STATIC
  * Static initializer which wraps static memory into a <wbuffer_t>.
  * Reserving additional memory beyond buffer_size always results in ENOMEM.
@@ -175,6 +217,21 @@ size_t sizefree_wbuffer(const wbuffer_t* wbuf);
  * only the buffer of the wrapped object is used. */
 size_t size_wbuffer(const wbuffer_t* wbuf);
 
+/* function: getmemvec_wbuffer
+ * Returns the appended bytes as list of contiguous memory blocks in memvec.
+ * A <wbuffer_t> initialized with <wbuffer_INIT_CHAIN> returns one block for every non empty page.
+ * All other types return a single block (or none if size_wbuffer returns 0).
+ *
+ * Parameter:
+ * wbuf     - The buffer whose content is returned.
+ * startseg - The index of the first returned block. Use it to return more blocks than fit into memvec.
+ * memvec   - On input memvec->size is the capacity of memvec->vec. On return it is set to the number
+ *            of stored blocks.
+ *
+ * Returns:
+ * The total number of blocks. All blocks are returned if startseg + memvec->size equals the return value. */
+size_t getmemvec_wbuffer(const wbuffer_t* wbuf, size_t startseg, /*inout*/struct memvec_t* memvec);
+
 // group: change
 
 /* function: clear_wbuffer
@@ -207,6 +264,46 @@ int appendcopy_wbuffer(wbuffer_t* wbuf, size_t buffer_size, const uint8_t* buffe
 
 
 
+/* struct: wbuffer_chain_t
+ * Chain of memory pages which is used by <wbuffer_t> as segmented buffer.
+ * Pages are allocated with <ALLOC_PAGECACHE>. If the free part of the last page is too small
+ * a new page is appended to the chain. Already written bytes are never moved in memory.
+ * A single append which does not fit into a page of size <pgsize> allocates a larger page
+ * (see <pagesize_e>). Appends larger than a page of size <pagesize_1MB> fail with ENOMEM.
+ * Every page stores a small header of type <wbuffer_page_t> at its start. */
+struct wbuffer_chain_t {
+   /* variable: first
+    * First page of chain. */
+   struct wbuffer_page_t * first;
+   /* variable: last
+    * Last page of chain. New bytes are appended to this page. */
+   struct wbuffer_page_t * last;
+   /* variable: size
+    * Number of written bytes stored in all pages except <last>. */
+   size_t                  size;
+   /* variable: pgsize
+    * Default size of an allocated page. Value of type <pagesize_e>. */
+   uint8_t                 pgsize;
+};
+
+// group: lifetime
+
+/* define: wbuffer_chain_FREE
+ * Static initializer. */
+#define wbuffer_chain_FREE \
+         { 0, 0, 0, 0 }
+
+/* function: init_wbufferchain
+ * Initializes an empty chain. No memory is allocated.
+ * Parameter pgsize of type <pagesize_e> determines the default size of an allocated page. */
+int init_wbufferchain(/*out*/wbuffer_chain_t* chain, uint8_t pgsize);
+
+/* function: free_wbufferchain
+ * Releases all pages of the chain. A <wbuffer_t> which wraps chain is invalid after return. */
+int free_wbufferchain(wbuffer_chain_t* chain);
+
+
+
 // section: inline implementation
 
 // group: wbuffer_t
@@ -107,6 +107,16 @@ struct memblock_t signalstack_threadstack(thread_stack_t* st);
  * If st is in a freed state stackmem is set to <memblock_FREE>. */
 struct memblock_t threadstack_threadstack(thread_stack_t* st);
 
+// group: prefault
+
+/* function: prefault_threadstack
+ * Maps physical memory for the thread local variables (including the static memory of <allocstatic_threadstack>),
+ * the signal stack and the thread stack. Therefore the first access causes no page faults.
+ * Parameter prefault is a value of <vmprefault_e> (see <prefault_vmpage>).
+ * Call it from a latency critical thread at start or after <new_threadstack> from the creating thread.
+ * The memory stays locked (vmprefault_LOCK) until <delete_threadstack> is called. */
+int prefault_threadstack(thread_stack_t* st, uint8_t prefault);
+
 // group: static-memory
 
 /* function: allocstatic_threadstack
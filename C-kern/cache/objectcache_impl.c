@@ -19,15 +19,226 @@
 #include "C-kern/api/cache/objectcache_impl.h"
 #include "C-kern/api/err.h"
 #include "C-kern/api/cache/objectcache.h"
+#include "C-kern/api/ds/typeadapt.h"
+#include "C-kern/api/memory/atomic.h"
 #include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
 #include "C-kern/api/memory/pagecache_macros.h"
 #include "C-kern/api/memory/vm.h"
+#include "C-kern/api/platform/task/thread.h"
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/io/filesystem/file.h"
 #include "C-kern/api/platform/task/process.h"
 #endif
 
+/* struct: objectcache_magazine_t
+ * Stack of cached objects of one <objectcache_type_t>.
+ * Magazines are owned by a <objectcache_impl_t> or are stored in the depot of <objectcache_type_t>. */
+typedef struct objectcache_magazine_t {
+   /* variable: next
+    * Next magazine in list <objectcache_type_t.depotfull> or <objectcache_type_t.depotempty>. */
+   struct objectcache_magazine_t * next;
+   /* variable: nrobject
+    * Number of objects stored in <object>. */
+   size_t                          nrobject;
+   /* variable: object
+    * Stack of cached objects. The top of stack is object[nrobject-1]. */
+   typeadapt_object_t            * object[objectcache_impl_MAGAZINESIZE];
+} objectcache_magazine_t;
+
+// group: lifetime
+
+/* function: new_objectcachemagazine
+ * Allocates an empty magazine. */
+static int new_objectcachemagazine(/*out*/objectcache_magazine_t ** magazine)
+{
+   int err;
+   memblock_t mblock = memblock_FREE;
+
+   err = ALLOC_MM(sizeof(objectcache_magazine_t), &mblock);
+   if (err) return err;
+
+   objectcache_magazine_t * newmag = (objectcache_magazine_t*) mblock.addr;
+   newmag->next     = 0;
+   newmag->nrobject = 0;
+
+   *magazine = newmag;
+
+   return 0;
+}
+
+/* function: delete_objectcachemagazine
+ * Deletes all contained objects with <typeadapt_lifetime_it.delete_object> and frees the magazine. */
+static int delete_objectcachemagazine(objectcache_magazine_t ** magazine, typeadapt_t * typeadp)
+{
+   int err = 0;
+   int err2;
+   objectcache_magazine_t * delmag = *magazine;
+
+   if (delmag) {
+      *magazine = 0;
+
+      for (size_t i = delmag->nrobject; i > 0; ) {
+         --i;
+         err2 = calldelete_typeadapt(typeadp, &delmag->object[i]);
+         if (err2) err = err2;
+      }
+
+      memblock_t mblock = memblock_INIT(sizeof(objectcache_magazine_t), (uint8_t*)delmag);
+      err2 = FREE_MM(&mblock);
+      if (err2) err = err2;
+
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+
+// section: objectcache_type_t
+
+// group: static variables
+
+/* variable: s_objectcachetype_registered
+ * Registered types indexed by <objectcache_type_t.typeid>. */
+static objectcache_type_t *   s_objectcachetype_registered[objectcache_impl_NROFTYPE] = { 0 };
+
+/* variable: s_objectcachetype_lock
+ * Lock flag protecting <s_objectcachetype_registered>. */
+static uint8_t                s_objectcachetype_lock = 0;
+
+// group: synchronization
+
+static inline void lockdepot_objectcachetype(objectcache_type_t * type)
+{
+   while (0 != set_atomicflag(&type->depotlock)) {
+      yield_thread();
+   }
+}
+
+static inline void unlockdepot_objectcachetype(objectcache_type_t * type)
+{
+   clear_atomicflag(&type->depotlock);
+}
+
+// group: lifetime
+
+int init_objectcachetype(/*out*/objectcache_type_t * type, struct typeadapt_t * typeadp, const struct typeadapt_object_t * prototype)
+{
+   int err;
+   unsigned typeid;
+
+   VALIDATE_INPARAM_TEST(typeadp != 0, ONERR, );
+
+   while (0 != set_atomicflag(&s_objectcachetype_lock)) {
+      yield_thread();
+   }
+
+   for (typeid = 0; typeid < objectcache_impl_NROFTYPE; ++typeid) {
+      if (! s_objectcachetype_registered[typeid]) {
+         s_objectcachetype_registered[typeid] = type;
+         break;
+      }
+   }
+
+   clear_atomicflag(&s_objectcachetype_lock);
+
+   if (typeid == objectcache_impl_NROFTYPE) {
+      err = ENOSPC;
+      goto ONERR;
+   }
+
+   type->typeadp    = typeadp;
+   type->prototype  = prototype;
+   type->depotfull  = 0;
+   type->depotempty = 0;
+   type->typeid     = (uint16_t) typeid;
+   type->depotlock  = 0;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_objectcachetype(objectcache_type_t * type)
+{
+   int err = 0;
+   int err2;
+
+   if (type->typeadp) {
+      lockdepot_objectcachetype(type);
+      objectcache_magazine_t * depotfull  = type->depotfull;
+      objectcache_magazine_t * depotempty = type->depotempty;
+      type->depotfull  = 0;
+      type->depotempty = 0;
+      unlockdepot_objectcachetype(type);
+
+      while (depotfull) {
+         objectcache_magazine_t * delmag = depotfull;
+         depotfull = delmag->next;
+         err2 = delete_objectcachemagazine(&delmag, type->typeadp);
+         if (err2) err = err2;
+      }
+
+      while (depotempty) {
+         objectcache_magazine_t * delmag = depotempty;
+         depotempty = delmag->next;
+         err2 = delete_objectcachemagazine(&delmag, type->typeadp);
+         if (err2) err = err2;
+      }
+
+      while (0 != set_atomicflag(&s_objectcachetype_lock)) {
+         yield_thread();
+      }
+      if (type->typeid < objectcache_impl_NROFTYPE
+          && s_objectcachetype_registered[type->typeid] == type) {
+         s_objectcachetype_registered[type->typeid] = 0;
+      }
+      clear_atomicflag(&s_objectcachetype_lock);
+
+      type->typeadp   = 0;
+      type->prototype = 0;
+      type->typeid    = 0;
+
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+
+// section: objectcache_slot_t
+
+/* struct: objectcache_slot_t
+ * Entry of table <objectcache_impl_t.magazine>.
+ * Stores the magazines of one registered <objectcache_type_t> owned by a single thread. */
+typedef struct objectcache_slot_t {
+   /* variable: type
+    * The type the magazines belong to. The value 0 marks an unused entry. */
+   objectcache_type_t     * type;
+   /* variable: loaded
+    * Objects are popped from and pushed onto this magazine. */
+   objectcache_magazine_t * loaded;
+   /* variable: previous
+    * Exchanged with <loaded> if it runs empty or full. */
+   objectcache_magazine_t * previous;
+} objectcache_slot_t;
+
+// group: config
+
+/* define: objectcache_slot_TABLEPGSIZE
+ * Value of <pagesize_e> of the page which stores all <objectcache_impl_NROFTYPE> entries of <objectcache_impl_t.magazine>. */
+#define objectcache_slot_TABLEPGSIZE pagesize_512
+
+
 // section: objectcacheimpl
 
 // group: static variables
@@ -38,7 +249,9 @@ objectcache_it_DECLARE(objectcache_impl_it, objectcache_impl_t) ;
  * Contains single instance of interface <objectcache_it>. */
 static objectcache_impl_it  s_objectcacheimpl_interface = {
    &lockiobuffer_objectcacheimpl,
-   &unlockiobuffer_objectcacheimpl
+   &unlockiobuffer_objectcacheimpl,
+   &allocobject_objectcacheimpl,
+   &freeobject_objectcacheimpl
 };
 
 // group: initthread
@@ -54,25 +267,80 @@ int init_objectcacheimpl(/*out*/objectcache_impl_t * cache)
 {
    int err ;
    memblock_t  iobuffer = memblock_FREE ;
+   memblock_t  table    = memblock_FREE ;
+
+   static_assert(objectcache_impl_NROFTYPE * sizeof(objectcache_slot_t) <= 512, "table fits into page of size objectcache_slot_TABLEPGSIZE");
 
    err = ALLOC_PAGECACHE(pagesize_4096, &iobuffer) ;
    if (err) goto ONERR;
 
-   static_assert(sizeof(*cache) == sizeof(iobuffer), "only one cached object") ;
+   err = ALLOC_PAGECACHE(objectcache_slot_TABLEPGSIZE, &table) ;
+   if (err) goto ONERR;
+
    *cast_memblock(&cache->iobuffer, ) = iobuffer;
+   cache->magazine = (objectcache_slot_t*) table.addr;
+
+   for (unsigned i = 0; i < objectcache_impl_NROFTYPE; ++i) {
+      cache->magazine[i].type     = 0;
+      cache->magazine[i].loaded   = 0;
+      cache->magazine[i].previous = 0;
+   }
 
    return 0;
 ONERR:
+   (void) RELEASE_PAGECACHE(&table);
    (void) RELEASE_PAGECACHE(&iobuffer);
    TRACEEXIT_ERRLOG(err);
    return err;
 }
 
+/* function: flushmagazine_objectcacheimpl
+ * Moves both magazines of cache->magazine[typeid] into the depot of the registered type.
+ * Empty magazines are stored in <objectcache_type_t.depotempty> all others in <objectcache_type_t.depotfull>. */
+static void flushmagazine_objectcacheimpl(objectcache_impl_t * cache, unsigned typeid)
+{
+   objectcache_type_t     * type = cache->magazine[typeid].type;
+   objectcache_magazine_t * mag[2] = { cache->magazine[typeid].loaded, cache->magazine[typeid].previous };
+
+   cache->magazine[typeid].type     = 0;
+   cache->magazine[typeid].loaded   = 0;
+   cache->magazine[typeid].previous = 0;
+
+   lockdepot_objectcachetype(type);
+   for (unsigned i = 0; i < lengthof(mag); ++i) {
+      if (!mag[i]) continue;
+      if (mag[i]->nrobject) {
+         mag[i]->next = type->depotfull;
+         type->depotfull = mag[i];
+      } else {
+         mag[i]->next = type->depotempty;
+         type->depotempty = mag[i];
+      }
+   }
+   unlockdepot_objectcachetype(type);
+}
+
 int free_objectcacheimpl(objectcache_impl_t * cache)
 {
    int err ;
+   int err2 ;
+
+   if (cache->magazine) {
+      for (unsigned i = 0; i < objectcache_impl_NROFTYPE; ++i) {
+         if (cache->magazine[i].type) {
+            flushmagazine_objectcacheimpl(cache, i);
+         }
+      }
+
+      memblock_t table = memblock_INIT(pagesizeinbytes_pagecache(objectcache_slot_TABLEPGSIZE), (uint8_t*)cache->magazine);
+      cache->magazine = 0;
+      err = RELEASE_PAGECACHE(&table) ;
+   } else {
+      err = 0 ;
+   }
 
-   err = RELEASE_PAGECACHE(cast_memblock(&cache->iobuffer, )) ;
+   err2 = RELEASE_PAGECACHE(cast_memblock(&cache->iobuffer, )) ;
+   if (err2) err = err2;
 
    if (err) goto ONERR;
 
@@ -131,6 +399,135 @@ void unlockiobuffer_objectcacheimpl(objectcache_impl_t * objectcache, memblock_t
    assert(!err && "unlockiobuffer2_objectcacheimpl") ;
 }
 
+// group: object
+
+int allocobject_objectcacheimpl(objectcache_impl_t * cache, objectcache_type_t * type, /*out*/struct typeadapt_object_t ** object)
+{
+   int err;
+   unsigned typeid = type->typeid;
+
+   VALIDATE_INPARAM_TEST(typeid < objectcache_impl_NROFTYPE && s_objectcachetype_registered[typeid] == type, ONERR, );
+
+   if (cache->magazine[typeid].type != type) {
+      VALIDATE_INPARAM_TEST(0 == cache->magazine[typeid].type, ONERR, );
+      cache->magazine[typeid].type = type;
+   }
+
+   objectcache_magazine_t * loaded = cache->magazine[typeid].loaded;
+
+   if (!loaded || 0 == loaded->nrobject) {
+      objectcache_magazine_t * previous = cache->magazine[typeid].previous;
+
+      if (previous && previous->nrobject) {
+         // exchange loaded and previous
+         cache->magazine[typeid].previous = loaded;
+         cache->magazine[typeid].loaded   = previous;
+         loaded = previous;
+
+      } else {
+         // exchange empty previous with full magazine from depot
+         lockdepot_objectcachetype(type);
+         objectcache_magazine_t * full = type->depotfull;
+         if (full) {
+            type->depotfull = full->next;
+            if (previous) {
+               previous->next   = type->depotempty;
+               type->depotempty = previous;
+            }
+         }
+         unlockdepot_objectcachetype(type);
+
+         if (!full) {
+            // depot is empty ==> construct new object
+            err = callnewcopy_typeadapt(type->typeadp, object, type->prototype);
+            if (err) goto ONERR;
+            return 0;
+         }
+
+         cache->magazine[typeid].previous = loaded;
+         cache->magazine[typeid].loaded   = full;
+         loaded = full;
+      }
+   }
+
+   *object = loaded->object[-- loaded->nrobject];
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int freeobject_objectcacheimpl(objectcache_impl_t * cache, objectcache_type_t * type, struct typeadapt_object_t ** object)
+{
+   int err;
+   unsigned typeid = type->typeid;
+   typeadapt_object_t * freeobj = *object;
+
+   if (!freeobj) return 0;
+
+   VALIDATE_INPARAM_TEST(typeid < objectcache_impl_NROFTYPE && s_objectcachetype_registered[typeid] == type, ONERR, );
+
+   if (cache->magazine[typeid].type != type) {
+      VALIDATE_INPARAM_TEST(0 == cache->magazine[typeid].type, ONERR, );
+      cache->magazine[typeid].type = type;
+   }
+
+   objectcache_magazine_t * loaded = cache->magazine[typeid].loaded;
+
+   if (!loaded || objectcache_impl_MAGAZINESIZE == loaded->nrobject) {
+      objectcache_magazine_t * previous = cache->magazine[typeid].previous;
+
+      if (previous && 0 == previous->nrobject) {
+         // exchange loaded and previous
+         cache->magazine[typeid].previous = loaded;
+         cache->magazine[typeid].loaded   = previous;
+         loaded = previous;
+
+      } else {
+         // exchange full previous with empty magazine from depot
+         lockdepot_objectcachetype(type);
+         objectcache_magazine_t * empty = type->depotempty;
+         if (empty) {
+            type->depotempty = empty->next;
+            if (previous) {
+               previous->next  = type->depotfull;
+               type->depotfull = previous;
+            }
+         }
+         unlockdepot_objectcachetype(type);
+
+         if (!empty) {
+            err = new_objectcachemagazine(&empty);
+            if (err) {
+               // no magazine ==> delete object
+               err = calldelete_typeadapt(type->typeadp, object);
+               if (err) goto ONERR;
+               return 0;
+            }
+            if (previous) {
+               lockdepot_objectcachetype(type);
+               previous->next  = type->depotfull;
+               type->depotfull = previous;
+               unlockdepot_objectcachetype(type);
+            }
+         }
+
+         cache->magazine[typeid].previous = loaded;
+         cache->magazine[typeid].loaded   = empty;
+         loaded = empty;
+      }
+   }
+
+   loaded->object[loaded->nrobject ++] = freeobj;
+   *object = 0;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
 
 // group: test
 
@@ -143,17 +540,29 @@ static int test_initfree(void)
    // TEST objectcache_impl_FREE
    TEST(0 == cache.iobuffer.addr) ;
    TEST(0 == cache.iobuffer.size) ;
+   TEST(0 == cache.magazine) ;
 
    // TEST init_objectcacheimpl, free_objectcacheimpl
+   size_t sizepgcache = SIZEALLOCATED_PAGECACHE() ;
    TEST(0 == init_objectcacheimpl(&cache)) ;
    TEST(0 != cache.iobuffer.addr) ;
    TEST(4096 == cache.iobuffer.size) ;
+   TEST(0 != cache.magazine) ;
+   TEST(sizepgcache + 4096 + pagesizeinbytes_pagecache(objectcache_slot_TABLEPGSIZE) == SIZEALLOCATED_PAGECACHE()) ;
+   for (unsigned i = 0; i < objectcache_impl_NROFTYPE; ++i) {
+      TEST(0 == cache.magazine[i].type) ;
+      TEST(0 == cache.magazine[i].loaded) ;
+      TEST(0 == cache.magazine[i].previous) ;
+   }
    TEST(0 == free_objectcacheimpl(&cache)) ;
    TEST(0 == cache.iobuffer.addr) ;
    TEST(0 == cache.iobuffer.size) ;
+   TEST(0 == cache.magazine) ;
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE()) ;
    TEST(0 == free_objectcacheimpl(&cache)) ;
    TEST(0 == cache.iobuffer.addr) ;
    TEST(0 == cache.iobuffer.size) ;
+   TEST(0 == cache.magazine) ;
 
    return 0 ;
 ONERR:
@@ -169,6 +578,8 @@ static int test_initthread(void)
    // TEST s_objectcacheimpl_interface
    TEST(s_objectcacheimpl_interface.lock_iobuffer   == &lockiobuffer_objectcacheimpl) ;
    TEST(s_objectcacheimpl_interface.unlock_iobuffer == &unlockiobuffer_objectcacheimpl) ;
+   TEST(s_objectcacheimpl_interface.alloc_object    == &allocobject_objectcacheimpl) ;
+   TEST(s_objectcacheimpl_interface.free_object     == &freeobject_objectcacheimpl) ;
 
    // TEST interface_objectcacheimpl
    TEST(interface_objectcacheimpl() == (objectcache_it*)&s_objectcacheimpl_interface) ;
@@ -287,11 +698,340 @@ ONERR:
    return EINVAL ;
 }
 
+typedef struct testobject_t {
+   int value ;
+} testobject_t ;
+
+/* variable: s_testobject_nrnewcopy
+ * Counts the calls to <newcopy_testobject>. */
+static unsigned s_testobject_nrnewcopy = 0 ;
+
+/* variable: s_testobject_nrdelete
+ * Counts the calls to <delete_testobject>. */
+static unsigned s_testobject_nrdelete  = 0 ;
+
+/* variable: s_testobject_err
+ * Error returned from <newcopy_testobject> and <delete_testobject>. */
+static int      s_testobject_err       = 0 ;
+
+static int newcopy_testobject(typeadapt_t * typeadp, /*out*/typeadapt_object_t ** destobject, const typeadapt_object_t * srcobject)
+{
+   int err ;
+   memblock_t mblock = memblock_FREE ;
+   (void) typeadp ;
+
+   if (s_testobject_err) return s_testobject_err ;
+
+   err = ALLOC_MM(sizeof(testobject_t), &mblock) ;
+   if (err) return err ;
+
+   ((testobject_t*)mblock.addr)->value = ((const testobject_t*)srcobject)->value ;
+   *destobject = (typeadapt_object_t*) mblock.addr ;
+   ++ s_testobject_nrnewcopy ;
+
+   return 0 ;
+}
+
+static int delete_testobject(typeadapt_t * typeadp, typeadapt_object_t ** object)
+{
+   int err ;
+   (void) typeadp ;
+
+   if (s_testobject_err) return s_testobject_err ;
+
+   if (*object) {
+      memblock_t mblock = memblock_INIT(sizeof(testobject_t), (uint8_t*)*object) ;
+      *object = 0 ;
+      err = FREE_MM(&mblock) ;
+      if (err) return err ;
+      ++ s_testobject_nrdelete ;
+   }
+
+   return 0 ;
+}
+
+static int test_objecttype(void)
+{
+   objectcache_type_t   type     = objectcache_type_FREE ;
+   objectcache_type_t   types[objectcache_impl_NROFTYPE+1] ;
+   typeadapt_t          typeadp  = typeadapt_INIT_LIFETIME(&newcopy_testobject, &delete_testobject) ;
+   testobject_t         proto    = { 1 } ;
+
+   // prepare
+   for (unsigned i = 0; i < lengthof(types); ++i) {
+      types[i] = (objectcache_type_t) objectcache_type_FREE ;
+   }
+
+   // TEST objectcache_type_FREE
+   TEST(0 == type.typeadp) ;
+   TEST(0 == type.prototype) ;
+   TEST(0 == type.depotfull) ;
+   TEST(0 == type.depotempty) ;
+   TEST(0 == type.typeid) ;
+   TEST(0 == type.depotlock) ;
+
+   // TEST init_objectcachetype
+   memset(&type, 255, sizeof(type)) ;
+   TEST(0 == init_objectcachetype(&type, &typeadp, (typeadapt_object_t*)&proto)) ;
+   TEST(&typeadp == type.typeadp) ;
+   TEST((void*)&proto == type.prototype) ;
+   TEST(0 == type.depotfull) ;
+   TEST(0 == type.depotempty) ;
+   TEST(type.typeid < objectcache_impl_NROFTYPE) ;
+   TEST(0 == type.depotlock) ;
+   TEST(&type == s_objectcachetype_registered[type.typeid]) ;
+
+   // TEST free_objectcachetype
+   unsigned typeid = type.typeid ;
+   TEST(0 == free_objectcachetype(&type)) ;
+   TEST(0 == type.typeadp) ;
+   TEST(0 == type.prototype) ;
+   TEST(0 == type.typeid) ;
+   TEST(0 == s_objectcachetype_registered[typeid]) ;
+   TEST(0 == free_objectcachetype(&type)) ;
+   TEST(0 == type.typeadp) ;
+
+   // TEST init_objectcachetype: every type gets another typeid
+   for (unsigned i = 0; i < objectcache_impl_NROFTYPE; ++i) {
+      TEST(0 == init_objectcachetype(&types[i], &typeadp, 0)) ;
+      TEST(&types[i] == s_objectcachetype_registered[types[i].typeid]) ;
+      for (unsigned i2 = 0; i2 < i; ++i2) {
+         TEST(types[i2].typeid != types[i].typeid) ;
+      }
+   }
+
+   // TEST init_objectcachetype: ENOSPC
+   TEST(ENOSPC == init_objectcachetype(&types[objectcache_impl_NROFTYPE], &typeadp, 0)) ;
+   TEST(0 == types[objectcache_impl_NROFTYPE].typeadp) ;
+
+   // TEST free_objectcachetype: typeid is reused
+   typeid = types[3].typeid ;
+   TEST(0 == free_objectcachetype(&types[3])) ;
+   TEST(0 == init_objectcachetype(&types[objectcache_impl_NROFTYPE], &typeadp, 0)) ;
+   TEST(typeid == types[objectcache_impl_NROFTYPE].typeid) ;
+   for (unsigned i = 0; i < lengthof(types); ++i) {
+      TEST(0 == free_objectcachetype(&types[i])) ;
+   }
+   for (unsigned i = 0; i < objectcache_impl_NROFTYPE; ++i) {
+      TEST(0 == s_objectcachetype_registered[i]) ;
+   }
+
+   // TEST init_objectcachetype: EINVAL
+   TEST(EINVAL == init_objectcachetype(&type, 0, 0)) ;
+   TEST(0 == type.typeadp) ;
+
+   return 0 ;
+ONERR:
+   for (unsigned i = 0; i < lengthof(types); ++i) {
+      (void) free_objectcachetype(&types[i]) ;
+   }
+   (void) free_objectcachetype(&type) ;
+   return EINVAL ;
+}
+
+static int test_allocfree(void)
+{
+   objectcache_impl_t   cache    = objectcache_impl_FREE ;
+   objectcache_type_t   type     = objectcache_type_FREE ;
+   typeadapt_t          typeadp  = typeadapt_INIT_LIFETIME(&newcopy_testobject, &delete_testobject) ;
+   testobject_t         proto    = { 1234 } ;
+   typeadapt_object_t * object[3*objectcache_impl_MAGAZINESIZE] = { 0 } ;
+   size_t               oldsize  = SIZEALLOCATED_MM() ;
+
+   // prepare
+   s_testobject_nrnewcopy = 0 ;
+   s_testobject_nrdelete  = 0 ;
+   s_testobject_err       = 0 ;
+   TEST(0 == init_objectcacheimpl(&cache)) ;
+   TEST(0 == init_objectcachetype(&type, &typeadp, (typeadapt_object_t*)&proto)) ;
+   unsigned typeid = type.typeid ;
+
+   // TEST allocobject_objectcacheimpl: construct new object
+   TEST(0 == allocobject_objectcacheimpl(&cache, &type, &object[0])) ;
+   TEST(0 != object[0]) ;
+   TEST(1234 == ((testobject_t*)object[0])->value) ;
+   TEST(1 == s_testobject_nrnewcopy) ;
+   TEST(&type == cache.magazine[typeid].type) ;
+   TEST(0 == cache.magazine[typeid].loaded) ;
+   TEST(0 == cache.magazine[typeid].previous) ;
+
+   // TEST freeobject_objectcacheimpl: object is cached not deleted
+   typeadapt_object_t * first = object[0] ;
+   TEST(0 == freeobject_objectcacheimpl(&cache, &type, &object[0])) ;
+   TEST(0 == object[0]) ;
+   TEST(0 == s_testobject_nrdelete) ;
+   TEST(0 != cache.magazine[typeid].loaded) ;
+   TEST(1 == cache.magazine[typeid].loaded->nrobject) ;
+   TEST(0 == cache.magazine[typeid].previous) ;
+
+   // TEST freeobject_objectcacheimpl: free of NULL is a no op
+   TEST(0 == freeobject_objectcacheimpl(&cache, &type, &object[0])) ;
+   TEST(1 == cache.magazine[typeid].loaded->nrobject) ;
+
+   // TEST allocobject_objectcacheimpl: cached object is returned
+   TEST(0 == allocobject_objectcacheimpl(&cache, &type, &object[0])) ;
+   TEST(first == object[0]) ;
+   TEST(1 == s_testobject_nrnewcopy) ;
+   TEST(0 == cache.magazine[typeid].loaded->nrobject) ;
+
+   // TEST allocobject_objectcacheimpl: magazines are empty ==> construct new objects
+   for (unsigned i = 1; i < lengthof(object); ++i) {
+      TEST(0 == allocobject_objectcacheimpl(&cache, &type, &object[i])) ;
+      TEST(1+i == s_testobject_nrnewcopy) ;
+   }
+
+   // TEST freeobject_objectcacheimpl: full previous magazine is moved to depot
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      TEST(0 == freeobject_objectcacheimpl(&cache, &type, &object[i])) ;
+      TEST(0 == object[i]) ;
+      TEST(1+i == (i < objectcache_impl_MAGAZINESIZE ? 0 : objectcache_impl_MAGAZINESIZE) + cache.magazine[typeid].loaded->nrobject
+                  + (i < 2*objectcache_impl_MAGAZINESIZE ? 0 : objectcache_impl_MAGAZINESIZE)) ;
+   }
+   TEST(0 == s_testobject_nrdelete) ;
+   TEST(objectcache_impl_MAGAZINESIZE == cache.magazine[typeid].loaded->nrobject) ;
+   TEST(objectcache_impl_MAGAZINESIZE == cache.magazine[typeid].previous->nrobject) ;
+   TEST(0 != type.depotfull) ;
+   TEST(0 == type.depotfull->next) ;
+   TEST(objectcache_impl_MAGAZINESIZE == type.depotfull->nrobject) ;
+   TEST(0 == type.depotempty) ;
+
+   // TEST allocobject_objectcacheimpl: full magazine is taken from depot
+   objectcache_magazine_t * depotmag = type.depotfull ;
+   objectcache_magazine_t * loaded   = cache.magazine[typeid].loaded ;
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      TEST(0 == allocobject_objectcacheimpl(&cache, &type, &object[i])) ;
+      TEST(0 != object[i]) ;
+      TEST(1234 == ((testobject_t*)object[i])->value) ;
+   }
+   TEST(lengthof(object) == s_testobject_nrnewcopy) ;
+   TEST(0 == type.depotfull) ;
+   TEST(loaded == type.depotempty) ;
+   TEST(0 == type.depotempty->next) ;
+   TEST(depotmag == cache.magazine[typeid].loaded) ;
+   TEST(0 == cache.magazine[typeid].loaded->nrobject) ;
+   TEST(0 == cache.magazine[typeid].previous->nrobject) ;
+
+   // TEST free_objectcacheimpl: magazines are moved to depot
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      TEST(0 == freeobject_objectcacheimpl(&cache, &type, &object[i])) ;
+   }
+   TEST(0 == free_objectcacheimpl(&cache)) ;
+   TEST(0 == cache.magazine) ;
+   unsigned nrmag = 0 ;
+   for (objectcache_magazine_t * mag = type.depotfull; mag; mag = mag->next) {
+      TEST(objectcache_impl_MAGAZINESIZE == mag->nrobject) ;
+      ++ nrmag ;
+   }
+   TEST(3 == nrmag) ;
+   TEST(0 == type.depotempty) ;
+
+   // TEST free_objectcachetype: all objects in depot are deleted
+   TEST(0 == free_objectcachetype(&type)) ;
+   TEST(0 == type.depotfull) ;
+   TEST(0 == type.depotempty) ;
+   TEST(lengthof(object) == s_testobject_nrdelete) ;
+   TEST(oldsize == SIZEALLOCATED_MM()) ;
+
+   // TEST allocobject_objectcacheimpl: error of newcopy_object
+   TEST(0 == init_objectcacheimpl(&cache)) ;
+   TEST(0 == init_objectcachetype(&type, &typeadp, (typeadapt_object_t*)&proto)) ;
+   s_testobject_err = ENOMEM ;
+   TEST(ENOMEM == allocobject_objectcacheimpl(&cache, &type, &object[0])) ;
+   TEST(0 == object[0]) ;
+   s_testobject_err = 0 ;
+
+   // TEST allocobject_objectcacheimpl, freeobject_objectcacheimpl: EINVAL
+   TEST(0 == free_objectcachetype(&type)) ;
+   TEST(EINVAL == allocobject_objectcacheimpl(&cache, &type, &object[0])) ;
+   object[0] = (typeadapt_object_t*) &proto ;
+   TEST(EINVAL == freeobject_objectcacheimpl(&cache, &type, &object[0])) ;
+   TEST((typeadapt_object_t*) &proto == object[0]) ;
+   object[0] = 0 ;
+   TEST(0 == free_objectcacheimpl(&cache)) ;
+   TEST(oldsize == SIZEALLOCATED_MM()) ;
+
+   return 0 ;
+ONERR:
+   s_testobject_err = 0 ;
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      (void) delete_testobject(&typeadp, &object[i]) ;
+   }
+   (void) free_objectcacheimpl(&cache) ;
+   (void) free_objectcachetype(&type) ;
+   return EINVAL ;
+}
+
+static int test_depot(void)
+{
+   objectcache_impl_t   cache[2] = { objectcache_impl_FREE, objectcache_impl_FREE } ;
+   objectcache_type_t   type     = objectcache_type_FREE ;
+   typeadapt_t          typeadp  = typeadapt_INIT_LIFETIME(&newcopy_testobject, &delete_testobject) ;
+   testobject_t         proto    = { 1 } ;
+   typeadapt_object_t * object[4*objectcache_impl_MAGAZINESIZE] = { 0 } ;
+   size_t               oldsize  = SIZEALLOCATED_MM() ;
+
+   // prepare
+   s_testobject_nrnewcopy = 0 ;
+   s_testobject_nrdelete  = 0 ;
+   TEST(0 == init_objectcacheimpl(&cache[0])) ;
+   TEST(0 == init_objectcacheimpl(&cache[1])) ;
+   TEST(0 == init_objectcachetype(&type, &typeadp, (typeadapt_object_t*)&proto)) ;
+
+   // TEST freeobject_objectcacheimpl: objects allocated by one cache are freed by another
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      TEST(0 == allocobject_objectcacheimpl(&cache[0], &type, &object[i])) ;
+   }
+   TEST(lengthof(object) == s_testobject_nrnewcopy) ;
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      TEST(0 == freeobject_objectcacheimpl(&cache[1], &type, &object[i])) ;
+   }
+   TEST(0 == s_testobject_nrdelete) ;
+   TEST(0 != type.depotfull) ;
+
+   // TEST allocobject_objectcacheimpl: depot rebalances objects to the first cache
+   for (unsigned i = 0; i < 2*objectcache_impl_MAGAZINESIZE; ++i) {
+      TEST(0 == allocobject_objectcacheimpl(&cache[0], &type, &object[i])) ;
+   }
+   TEST(lengthof(object) == s_testobject_nrnewcopy) ;
+   TEST(0 == type.depotfull) ;
+
+   // TEST free_objectcacheimpl: magazines of exited thread are used by other
+   TEST(0 == free_objectcacheimpl(&cache[1])) ;
+   TEST(0 != type.depotfull) ;
+   for (unsigned i = 2*objectcache_impl_MAGAZINESIZE; i < lengthof(object); ++i) {
+      TEST(0 == allocobject_objectcacheimpl(&cache[0], &type, &object[i])) ;
+   }
+   TEST(lengthof(object) == s_testobject_nrnewcopy) ;
+   TEST(0 == type.depotfull) ;
+
+   // unprepare
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      TEST(0 == freeobject_objectcacheimpl(&cache[0], &type, &object[i])) ;
+   }
+   TEST(0 == free_objectcacheimpl(&cache[0])) ;
+   TEST(0 == free_objectcachetype(&type)) ;
+   TEST(lengthof(object) == s_testobject_nrdelete) ;
+   TEST(oldsize == SIZEALLOCATED_MM()) ;
+
+   return 0 ;
+ONERR:
+   for (unsigned i = 0; i < lengthof(object); ++i) {
+      (void) delete_testobject(&typeadp, &object[i]) ;
+   }
+   (void) free_objectcacheimpl(&cache[0]) ;
+   (void) free_objectcacheimpl(&cache[1]) ;
+   (void) free_objectcachetype(&type) ;
+   return EINVAL ;
+}
+
 int unittest_cache_objectcacheimpl()
 {
    if (test_initfree())       goto ONERR;
    if (test_initthread())     goto ONERR;
    if (test_iobuffer())       goto ONERR;
+   if (test_objecttype())     goto ONERR;
+   if (test_allocfree())      goto ONERR;
+   if (test_depot())          goto ONERR;
 
    return 0 ;
 ONERR:
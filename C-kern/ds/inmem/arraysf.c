@@ -23,11 +23,15 @@
 #include "C-kern/api/math/int/log2.h"
 #include "C-kern/api/math/int/power2.h"
 #include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/test/errortimer.h"
 #include "C-kern/api/test/mm/err_macros.h"
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/memory/pagecache_macros.h"
-#include "C-kern/api/test/errortimer.h"
+#endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/perftest.h"
 #endif
 
 
@@ -592,6 +596,173 @@ ONERR:
    return false ;
 }
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRKEYS
+ * Number of keys inserted, searched, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRKEYS       (1024*1024)
+
+/* define: PT_NRKEYS_SMALL
+ * Number of keys stored at the same time in <perftest_ds_inmem_arraysf_small>.
+ * The keys are inserted and removed <PT_NRKEYS>/<PT_NRKEYS_SMALL> times. */
+#define PT_NRKEYS_SMALL 1024
+
+typedef struct pt_object_t {
+   arraysf_node_EMBED(pos);
+} pt_object_t;
+
+arraysf_IMPLEMENT(_ptarray, pt_object_t, pos)
+
+/* struct: pt_lifecycle_t
+ * Array and nodes used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   arraysf_t    * array;
+   size_t         nrkeys;
+   size_t         nrloop;
+   size_t         keysum;
+   pt_object_t    object[/*nrkeys*/];
+} pt_lifecycle_t;
+
+/* function: pt_randomkey
+ * Returns a pseudo random key computed from i. Different values of i result in different keys. */
+static inline size_t pt_randomkey(size_t i)
+{
+   size_t key = i * (size_t) 0x9e3779b97f4a7c15;
+   return key ^ (key >> 29);
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrkeys, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrkeys * sizeof(pt_object_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage = vmpage;
+   plc->array  = 0;
+   err = new_ptarray(&plc->array, 256, 0);
+   if (err) goto ONERR;
+   plc->nrkeys = nrkeys;
+   plc->nrloop = PT_NRKEYS / nrkeys;
+   plc->keysum = 0;
+
+   for (size_t i = 0; i < nrkeys; ++i) {
+      plc->object[i].pos = israndom ? pt_randomkey(i) : i;
+      plc->keysum += plc->object[i].pos;
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+ONERR:
+   (void) free_vmpage(&vmpage);
+   return err;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   // nodes are part of vmpage
+   err = delete_ptarray(&plc->array, 0);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   pt_object_t    * node;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = insert_ptarray(plc->array, &plc->object[i], 0, 0);
+         if (err) return err;
+      }
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         node = at_ptarray(plc->array, plc->object[i].pos);
+         if (node != &plc->object[i]) return EINVAL;
+      }
+
+      size_t keysum = 0;
+      foreach (_ptarray, next, plc->array) {
+         keysum += next->pos;
+      }
+      if (keysum != plc->keysum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = remove_ptarray(plc->array, plc->object[i].pos, &node);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_arraysf_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M sequential keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_arraysf_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_arraysf_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1K random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
 
 // group: test
 
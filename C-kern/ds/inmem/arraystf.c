@@ -30,6 +30,10 @@
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/memory/pagecache_macros.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: arraystf_node_t
@@ -752,6 +756,182 @@ ONERR:
    return false ;
 }
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRKEYS
+ * Number of keys inserted, searched, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRKEYS       (1024*1024)
+
+/* define: PT_NRKEYS_SMALL
+ * Number of keys stored at the same time in <perftest_ds_inmem_arraystf_small>.
+ * The keys are inserted and removed <PT_NRKEYS>/<PT_NRKEYS_SMALL> times. */
+#define PT_NRKEYS_SMALL 1024
+
+/* struct: pt_object_t
+ * Stores value as 8 byte big endian key. */
+typedef struct pt_object_t {
+   arraystf_node_t   node;
+   uint64_t          value;
+   uint8_t           key[8];
+} pt_object_t;
+
+arraystf_IMPLEMENT(_ptarray, pt_object_t, node)
+
+/* struct: pt_lifecycle_t
+ * Array and nodes used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   arraystf_t   * array;
+   size_t         nrkeys;
+   size_t         nrloop;
+   uint64_t       keysum;
+   pt_object_t    object[/*nrkeys*/];
+} pt_lifecycle_t;
+
+/* function: pt_randomkey
+ * Returns a pseudo random key computed from i. Different values of i result in different keys. */
+static inline uint64_t pt_randomkey(uint64_t i)
+{
+   uint64_t key = i * UINT64_C(0x9e3779b97f4a7c15);
+   return key ^ (key >> 29);
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrkeys, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrkeys * sizeof(pt_object_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage = vmpage;
+   plc->array  = 0;
+   err = new_ptarray(&plc->array, 256);
+   if (err) goto ONERR;
+   plc->nrkeys = nrkeys;
+   plc->nrloop = PT_NRKEYS / nrkeys;
+   plc->keysum = 0;
+
+   for (size_t i = 0; i < nrkeys; ++i) {
+      pt_object_t * object = &plc->object[i];
+      object->value = israndom ? pt_randomkey(i) : i;
+      for (unsigned b = 0; b < sizeof(object->key); ++b) {
+         object->key[b] = (uint8_t) (object->value >> (8 * (sizeof(object->key)-1-b)));
+      }
+      object->node = (arraystf_node_t) arraystf_node_INIT(sizeof(object->key), object->key);
+      plc->keysum += object->value;
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+ONERR:
+   (void) free_vmpage(&vmpage);
+   return err;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   // nodes are part of vmpage
+   err = delete_ptarray(&plc->array, 0);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   pt_object_t    * node;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = insert_ptarray(plc->array, &plc->object[i], 0, 0);
+         if (err) return err;
+      }
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         node = at_ptarray(plc->array, sizeof(plc->object[i].key), plc->object[i].key);
+         if (node != &plc->object[i]) return EINVAL;
+      }
+
+      uint64_t keysum = 0;
+      foreach (_ptarray, next, plc->array) {
+         keysum += next->value;
+      }
+      if (keysum != plc->keysum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = remove_ptarray(plc->array, sizeof(plc->object[i].key), plc->object[i].key, &node);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_arraystf_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M sequential keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_arraystf_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_arraystf_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1K random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
 
 // group: test
 
@@ -0,0 +1,527 @@
+/* title: BloomFilter impl
+
+   Implements <BloomFilter>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/bloomfilter.h
+    Header file <BloomFilter>.
+
+   file: C-kern/ds/inmem/bloomfilter.c
+    Implementation file <BloomFilter impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/ds/inmem/bloomfilter.h"
+#include "C-kern/api/ds/typeadapt.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/errortimer.h"
+#include "C-kern/api/test/validate.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/test/perftest.h"
+#endif
+
+
+// section: bloomfilter_t
+
+// group: static variables
+
+#ifdef KONFIG_UNITTEST
+/* variable: s_bloomfilter_errtimer
+ * Simulates an error in <init_bloomfilter> and <free_bloomfilter>. */
+static test_errortimer_t   s_bloomfilter_errtimer = test_errortimer_FREE;
+#endif
+
+/* variable: s_bloomfilter_salt
+ * Odd multipliers which select one bit in every word of a block.
+ * Values are taken from the split block Bloom filter of Apache Parquet. */
+static const uint32_t s_bloomfilter_salt[bloomfilter_BLOCKSIZE/sizeof(uint32_t)] = {
+   0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d,
+   0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31
+};
+
+// group: helper
+
+/* function: mixhash_bloomfilter
+ * Mixes the bits of hashvalue. Hash values returned from <typeadapt_gethash_it>
+ * could be the key itself. The finalizer of MurmurHash3 is used. */
+static inline uint64_t mixhash_bloomfilter(size_t hashvalue)
+{
+   uint64_t h = hashvalue;
+   h ^= h >> 33;
+   h *= UINT64_C(0xff51afd7ed558ccd);
+   h ^= h >> 33;
+   h *= UINT64_C(0xc4ceb9fe1a85ec53);
+   h ^= h >> 33;
+   return h;
+}
+
+/* function: block_bloomfilter
+ * Returns the block selected by the high 32 bits of the mixed hash value h.
+ * The multiplication maps h uniformly to [0..nrblocks-1] without division. */
+static inline uint32_t * block_bloomfilter(const bloomfilter_t * filter, uint64_t h)
+{
+   size_t index = (size_t) (((h >> 32) * filter->nrblocks) >> 32);
+   return filter->blocks + index * (bloomfilter_BLOCKSIZE/sizeof(uint32_t));
+}
+
+// group: lifetime
+
+int init_bloomfilter(/*out*/bloomfilter_t * filter, size_t nrkeys, uint8_t bitsperkey, struct typeadapt_t * typeadp)
+{
+   int err;
+   vmpage_t mblock;
+
+   VALIDATE_INPARAM_TEST(typeadp && bitsperkey, ONERR, );
+   VALIDATE_INPARAM_TEST(nrkeys <= ((size_t)-1 - 8*bloomfilter_BLOCKSIZE) / bitsperkey, ONERR, PRINTSIZE_ERRLOG(nrkeys));
+
+   size_t nrblocks = (nrkeys * bitsperkey + 8*bloomfilter_BLOCKSIZE-1) / (8*bloomfilter_BLOCKSIZE);
+   if (! nrblocks) nrblocks = 1;
+
+   // block_bloomfilter supports at most 2^32 blocks
+   VALIDATE_INPARAM_TEST(nrblocks <= UINT32_MAX, ONERR, PRINTSIZE_ERRLOG(nrblocks));
+
+   if (! PROCESS_testerrortimer(&s_bloomfilter_errtimer, &err)) {
+      err = init_vmpage(&mblock, nrblocks * bloomfilter_BLOCKSIZE);
+   }
+   if (err) goto ONERR;
+
+   filter->blocks   = (uint32_t*) mblock.addr;
+   filter->nrblocks = nrblocks;
+   filter->memsize  = mblock.size;
+   filter->typeadp  = typeadp;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_bloomfilter(bloomfilter_t * filter)
+{
+   int err;
+   vmpage_t mblock = vmpage_INIT(filter->memsize, (uint8_t*)filter->blocks);
+
+   err = free_vmpage(&mblock);
+   (void) PROCESS_testerrortimer(&s_bloomfilter_errtimer, &err);
+
+   *filter = (bloomfilter_t) bloomfilter_FREE;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+bool maycontainhash_bloomfilter(const bloomfilter_t * filter, size_t hashvalue)
+{
+   uint64_t         h     = mixhash_bloomfilter(hashvalue);
+   const uint32_t * block = block_bloomfilter(filter, h);
+   uint32_t         key   = (uint32_t) h;
+   uint32_t         miss  = 0;
+
+   for (unsigned i = 0; i < lengthof(s_bloomfilter_salt); ++i) {
+      miss |= ~block[i] & (UINT32_C(1) << ((key * s_bloomfilter_salt[i]) >> 27));
+   }
+
+   return 0 == miss;
+}
+
+bool maycontain_bloomfilter(const bloomfilter_t * filter, const void * key)
+{
+   return maycontainhash_bloomfilter(filter, callhashkey_typeadapt(filter->typeadp, key));
+}
+
+// group: update
+
+void inserthash_bloomfilter(bloomfilter_t * filter, size_t hashvalue)
+{
+   uint64_t   h     = mixhash_bloomfilter(hashvalue);
+   uint32_t * block = block_bloomfilter(filter, h);
+   uint32_t   key   = (uint32_t) h;
+
+   for (unsigned i = 0; i < lengthof(s_bloomfilter_salt); ++i) {
+      block[i] |= UINT32_C(1) << ((key * s_bloomfilter_salt[i]) >> 27);
+   }
+}
+
+void insert_bloomfilter(bloomfilter_t * filter, const struct typeadapt_object_t * object)
+{
+   inserthash_bloomfilter(filter, callhashobject_typeadapt(filter->typeadp, object));
+}
+
+void insertkey_bloomfilter(bloomfilter_t * filter, const void * key)
+{
+   inserthash_bloomfilter(filter, callhashkey_typeadapt(filter->typeadp, key));
+}
+
+void clear_bloomfilter(bloomfilter_t * filter)
+{
+   memset(filter->blocks, 0, filter->nrblocks * bloomfilter_BLOCKSIZE);
+}
+
+
+
+// section: Functions
+
+// group: test-helper
+
+#if defined(KONFIG_UNITTEST) || defined(KONFIG_PERFTEST)
+
+typedef struct testobject_t testobject_t;
+
+typeadapt_DECLARE(testadapt_t, testobject_t, uintptr_t);
+
+struct testobject_t {
+   uintptr_t key;
+};
+
+static size_t impl_hashobj_testadapt(testadapt_t * typeadp, const struct testobject_t * object)
+{
+   (void) typeadp;
+   return object->key;
+}
+
+static size_t impl_hashkey_testadapt(testadapt_t * typeadp, const uintptr_t key)
+{
+   (void) typeadp;
+   return (size_t) key;
+}
+
+/* function: falsepositive_testfilter
+ * Returns the number of false positives of querying nrkeys keys which were not inserted.
+ * Keys 2*i are inserted and keys 2*i+1 are queried. */
+static int falsepositive_testfilter(size_t nrkeys, uint8_t bitsperkey, /*out*/size_t * nrfalse)
+{
+   int err;
+   bloomfilter_t filter    = bloomfilter_FREE;
+   testadapt_t   typeadapt = typeadapt_INIT_LIFECMPHASH(0, 0, 0, 0, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+
+   err = init_bloomfilter(&filter, nrkeys, bitsperkey, cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t));
+   if (err) return err;
+
+   for (uintptr_t i = 0; i < nrkeys; ++i) {
+      insertkey_bloomfilter(&filter, (const void*) (2*i));
+   }
+
+   size_t count = 0;
+   for (uintptr_t i = 0; i < nrkeys; ++i) {
+      count += maycontain_bloomfilter(&filter, (const void*) (2*i+1));
+   }
+   *nrfalse = count;
+
+   return free_bloomfilter(&filter);
+}
+
+#endif
+
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRKEYS
+ * Number of keys inserted into the filter and number of queries per test run. */
+#define PT_NRKEYS (1024*1024)
+
+/* struct: pt_filter_t
+ * Filter and type adapter of a single perftest instance. */
+typedef struct pt_filter_t {
+   vmpage_t      vmpage;
+   testadapt_t   typeadapt;
+   bloomfilter_t filter;
+   size_t        nrfound;
+} pt_filter_t;
+
+static int pt_prepare(perftest_instance_t* tinst, uint8_t bitsperkey)
+{
+   int err;
+   vmpage_t      vmpage;
+   pt_filter_t * pfilter;
+
+   err = init_vmpage(&vmpage, sizeof(pt_filter_t));
+   if (err) return err;
+
+   pfilter = (pt_filter_t*) vmpage.addr;
+   pfilter->vmpage    = vmpage;
+   pfilter->typeadapt = (testadapt_t) typeadapt_INIT_LIFECMPHASH(0, 0, 0, 0, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   pfilter->nrfound   = 0;
+
+   err = init_bloomfilter(&pfilter->filter, PT_NRKEYS, bitsperkey, cast_typeadapt(&pfilter->typeadapt, testadapt_t, testobject_t, uintptr_t));
+   if (err) {
+      free_vmpage(&vmpage);
+      return err;
+   }
+
+   for (uintptr_t i = 0; i < PT_NRKEYS; ++i) {
+      insertkey_bloomfilter(&pfilter->filter, (const void*) (2*i));
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = pfilter;
+   tinst->size  = sizeof(pt_filter_t);
+
+   return 0;
+}
+
+static int pt_prepare_8(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, 8);
+}
+
+static int pt_prepare_12(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, 12);
+}
+
+static int pt_prepare_16(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, 16);
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   int err;
+   pt_filter_t * pfilter = (pt_filter_t*) tinst->addr;
+   vmpage_t      vmpage  = pfilter->vmpage;
+
+   err = free_bloomfilter(&pfilter->filter);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run(perftest_instance_t* tinst)
+{
+   pt_filter_t * pfilter = (pt_filter_t*) tinst->addr;
+   size_t        nrfound = 0;
+
+   // query keys which are not contained
+   for (uintptr_t i = 0; i < PT_NRKEYS; ++i) {
+      nrfound += maycontain_bloomfilter(&pfilter->filter, (const void*) (2*i+1));
+   }
+   pfilter->nrfound = nrfound;
+
+   return 0;
+}
+
+/* function: pt_info
+ * Measures the false positive rate and writes it into the description of the test. */
+static int pt_info(/*out*/perftest_info_t* info, perftest_it iimpl, uint8_t bitsperkey, size_t descsize, char * desc)
+{
+   int err;
+   size_t nrfalse;
+
+   err = falsepositive_testfilter(PT_NRKEYS, bitsperkey, &nrfalse);
+   if (err) return err;
+
+   snprintf(desc, descsize, "Query 1M absent keys in bloomfilter_t with %u bits/key (false positive rate %.3f%%)",
+            (unsigned) bitsperkey, 100.0 * (double)nrfalse / PT_NRKEYS);
+
+   *info = (perftest_info_t) perftest_info_INIT(iimpl, desc, 0, 0, 0);
+
+   return 0;
+}
+
+int perftest_ds_inmem_bloomfilter_8(/*out*/perftest_info_t* info)
+{
+   static char desc[100];
+   return pt_info(info, (perftest_it) perftest_INIT(&pt_prepare_8, &pt_run, &pt_unprepare), 8, sizeof(desc), desc);
+}
+
+int perftest_ds_inmem_bloomfilter_12(/*out*/perftest_info_t* info)
+{
+   static char desc[100];
+   return pt_info(info, (perftest_it) perftest_INIT(&pt_prepare_12, &pt_run, &pt_unprepare), 12, sizeof(desc), desc);
+}
+
+int perftest_ds_inmem_bloomfilter_16(/*out*/perftest_info_t* info)
+{
+   static char desc[100];
+   return pt_info(info, (perftest_it) perftest_INIT(&pt_prepare_16, &pt_run, &pt_unprepare), 16, sizeof(desc), desc);
+}
+
+#endif
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+static int test_initfree(void)
+{
+   bloomfilter_t filter    = bloomfilter_FREE;
+   testadapt_t   typeadapt = typeadapt_INIT_LIFECMPHASH(0, 0, 0, 0, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_t * typeadp   = cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t);
+
+   // TEST bloomfilter_FREE
+   TEST(0 == filter.blocks);
+   TEST(0 == filter.nrblocks);
+   TEST(0 == filter.memsize);
+   TEST(0 == filter.typeadp);
+
+   // TEST init_bloomfilter: size is rounded up to a multiple of block size
+   for (unsigned bitsperkey = 1; bitsperkey <= 255; bitsperkey += 7) {
+      for (size_t nrkeys = 0; nrkeys <= 1000; nrkeys += 111) {
+         size_t nrbits = nrkeys * bitsperkey;
+         TEST(0 == init_bloomfilter(&filter, nrkeys, (uint8_t)bitsperkey, typeadp));
+         TEST(0 != filter.blocks);
+         TEST(0 == (uintptr_t)filter.blocks % bloomfilter_BLOCKSIZE);
+         TEST(filter.nrblocks == (nrbits ? (nrbits + 255) / 256 : 1));
+         TEST(filter.memsize  >= size_bloomfilter(&filter));
+         TEST(filter.typeadp  == typeadp);
+         TEST(size_bloomfilter(&filter) == 32 * filter.nrblocks);
+         for (size_t i = 0; i < size_bloomfilter(&filter) / sizeof(uint32_t); ++i) {
+            TEST(0 == filter.blocks[i]);
+         }
+         // TEST free_bloomfilter
+         TEST(0 == free_bloomfilter(&filter));
+         TEST(0 == filter.blocks);
+         TEST(0 == filter.nrblocks);
+         TEST(0 == filter.memsize);
+         TEST(0 == filter.typeadp);
+         TEST(0 == free_bloomfilter(&filter));
+         TEST(0 == filter.blocks);
+      }
+   }
+
+   // TEST init_bloomfilter: EINVAL
+   TEST(EINVAL == init_bloomfilter(&filter, 1, 8, 0));
+   TEST(EINVAL == init_bloomfilter(&filter, 1, 0, typeadp));
+   TEST(EINVAL == init_bloomfilter(&filter, (size_t)-1 / 8, 8, typeadp));
+#if (SIZE_MAX > UINT32_MAX)
+   TEST(EINVAL == init_bloomfilter(&filter, ((size_t)UINT32_MAX+1) * 32, 8, typeadp));
+#endif
+   TEST(0 == filter.blocks);
+
+   // TEST init_bloomfilter: ENOMEM
+   init_testerrortimer(&s_bloomfilter_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == init_bloomfilter(&filter, 1, 8, typeadp));
+   TEST(0 == filter.blocks);
+
+   // TEST free_bloomfilter: ENOMEM
+   TEST(0 == init_bloomfilter(&filter, 1, 8, typeadp));
+   init_testerrortimer(&s_bloomfilter_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == free_bloomfilter(&filter));
+   TEST(0 == filter.blocks);
+   TEST(0 == filter.nrblocks);
+
+   return 0;
+ONERR:
+   free_bloomfilter(&filter);
+   return EINVAL;
+}
+
+static int test_update(void)
+{
+   bloomfilter_t filter    = bloomfilter_FREE;
+   testadapt_t   typeadapt = typeadapt_INIT_LIFECMPHASH(0, 0, 0, 0, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_t * typeadp   = cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t);
+   const size_t  nrkeys    = 100000;
+   size_t        nrfound;
+
+   // prepare
+   TEST(0 == init_bloomfilter(&filter, nrkeys, 8, typeadp));
+
+   // TEST maycontain_bloomfilter: empty filter
+   for (uintptr_t key = 0; key < nrkeys; ++key) {
+      TEST(! maycontain_bloomfilter(&filter, (const void*)key));
+   }
+
+   // TEST insertkey_bloomfilter: no false negatives
+   for (uintptr_t key = 0; key < nrkeys; ++key) {
+      insertkey_bloomfilter(&filter, (const void*)(3*key));
+      TEST(maycontain_bloomfilter(&filter, (const void*)(3*key)));
+   }
+   for (uintptr_t key = 0; key < nrkeys; ++key) {
+      TEST(maycontain_bloomfilter(&filter, (const void*)(3*key)));
+      TEST(maycontainhash_bloomfilter(&filter, 3*key));
+   }
+
+   // TEST maycontain_bloomfilter: some false positives
+   nrfound = 0;
+   for (uintptr_t key = 0; key < nrkeys; ++key) {
+      nrfound += maycontain_bloomfilter(&filter, (const void*)(3*key+1));
+   }
+   TEST(0 < nrfound && nrfound < nrkeys / 20);
+
+   // TEST clear_bloomfilter
+   clear_bloomfilter(&filter);
+   for (uintptr_t key = 0; key < nrkeys; ++key) {
+      TEST(! maycontain_bloomfilter(&filter, (const void*)(3*key)));
+   }
+
+   // TEST insert_bloomfilter: uses hashobject
+   for (uintptr_t key = 0; key < nrkeys; ++key) {
+      testobject_t object = { .key = key };
+      insert_bloomfilter(&filter, (const struct typeadapt_object_t*)&object);
+   }
+   for (uintptr_t key = 0; key < nrkeys; ++key) {
+      TEST(maycontain_bloomfilter(&filter, (const void*)key));
+   }
+
+   // TEST inserthash_bloomfilter
+   clear_bloomfilter(&filter);
+   for (size_t hash = 0; hash < nrkeys; ++hash) {
+      inserthash_bloomfilter(&filter, hash << 20);
+   }
+   for (size_t hash = 0; hash < nrkeys; ++hash) {
+      TEST(maycontainhash_bloomfilter(&filter, hash << 20));
+      TEST(maycontain_bloomfilter(&filter, (const void*)(hash << 20)));
+   }
+
+   // unprepare
+   TEST(0 == free_bloomfilter(&filter));
+
+   return 0;
+ONERR:
+   free_bloomfilter(&filter);
+   return EINVAL;
+}
+
+static int test_falsepositive(void)
+{
+   const size_t nrkeys = 100000;
+   size_t nrfalse;
+   size_t prevfalse = nrkeys;
+
+   // TEST false positive rate decreases with more bits per key
+   for (uint8_t bitsperkey = 4; bitsperkey <= 24; bitsperkey = (uint8_t) (bitsperkey + 4)) {
+      TEST(0 == falsepositive_testfilter(nrkeys, bitsperkey, &nrfalse));
+      TEST(nrfalse < prevfalse);
+      prevfalse = nrfalse;
+   }
+
+   // TEST expected false positive rates
+   TEST(0 == falsepositive_testfilter(nrkeys, 8, &nrfalse));
+   TEST(nrfalse < nrkeys * 40 / 1000);
+   TEST(0 == falsepositive_testfilter(nrkeys, 12, &nrfalse));
+   TEST(nrfalse < nrkeys * 7 / 1000);
+   TEST(0 == falsepositive_testfilter(nrkeys, 16, &nrfalse));
+   TEST(nrfalse < nrkeys * 2 / 1000);
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+int unittest_ds_inmem_bloomfilter()
+{
+   if (test_initfree())       goto ONERR;
+   if (test_update())         goto ONERR;
+   if (test_falsepositive())  goto ONERR;
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+#endif
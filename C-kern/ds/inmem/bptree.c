@@ -0,0 +1,1437 @@
+/* title: BPlustree-Index impl
+
+   Implement <BPlustree-Index>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/bptree.h
+    Header file of <BPlustree-Index>.
+
+   file: C-kern/ds/inmem/bptree.c
+    Implementation file of <BPlustree-Index impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/ds/typeadapt.h"
+#include "C-kern/api/ds/inmem/bptree.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/pagecache_macros.h"
+#include "C-kern/api/test/errortimer.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#endif
+
+
+/* struct: bptree_leaf_t
+ * A leaf page of <bptree_t>. The rest of the page after the header
+ * is used to store pointers to <bptree_node_t> in ascending order. */
+typedef struct bptree_leaf_t {
+   /* variable: size
+    * Number of valid entries in <entry>. */
+   size_t                  size;
+   /* variable: prev
+    * Left neighbour in the list of leaves. */
+   struct bptree_leaf_t  * prev;
+   /* variable: next
+    * Right neighbour in the list of leaves. */
+   struct bptree_leaf_t  * next;
+   /* variable: entry
+    * Stored nodes sorted in ascending order. */
+   bptree_node_t         * entry[];
+} bptree_leaf_t;
+
+/* struct: bptree_inner_t
+ * An inner page of <bptree_t>. The rest of the page after the header
+ * is split into an array of innermax separators followed by an array of innermax+1 child pointers.
+ * The value innermax is computed by <innermax_bptree>. Use <child_bptreeinner> to access the children.
+ * Separator key[i] points to the smallest node stored in subtree child[i+1]. */
+typedef struct bptree_inner_t {
+   /* variable: size
+    * Number of valid separators in <key>. The number of children is size+1. */
+   size_t                  size;
+   /* variable: key
+    * Separators sorted in ascending order. */
+   bptree_node_t         * key[];
+} bptree_inner_t;
+
+
+// section: bptree_t
+
+// group: static variables
+
+#ifdef KONFIG_UNITTEST
+/* variable: s_bptree_errtimer
+ * Simulates an error in <newpage_bptree>. */
+static test_errortimer_t   s_bptree_errtimer = test_errortimer_FREE;
+#endif
+
+// group: helper
+
+static inline void compiletime_assert(void)
+{
+   static_assert(offsetof(bptree_leaf_t, size) == 0 && offsetof(bptree_inner_t, size) == 0, "sizeofpage_bptree works for both types");
+   static_assert(0 == (sizeof(bptree_leaf_t) % sizeof(void*)), "entry is aligned");
+   static_assert(0 == (sizeof(bptree_inner_t) % sizeof(void*)), "key is aligned");
+}
+
+/* function: sizeofpage_bptree
+ * Returns the number of entries of a leaf or the number of separators of an inner page. */
+static inline size_t sizeofpage_bptree(const void * page)
+{
+   return *(const size_t*) page;
+}
+
+/* function: leafmax_bptree
+ * Returns the maximum number of entries stored in a leaf. */
+static inline size_t leafmax_bptree(const bptree_t * tree)
+{
+   return (pagesizeinbytes_pagecache(tree->pgsize) - sizeof(bptree_leaf_t)) / sizeof(bptree_node_t*);
+}
+
+/* function: leafmin_bptree
+ * Returns the minimum number of entries stored in a leaf which is not the root. */
+static inline size_t leafmin_bptree(const bptree_t * tree)
+{
+   return leafmax_bptree(tree) / 2;
+}
+
+/* function: innermax_bptree
+ * Returns the maximum number of separators stored in an inner page. */
+static inline size_t innermax_bptree(const bptree_t * tree)
+{
+   return ((pagesizeinbytes_pagecache(tree->pgsize) - sizeof(bptree_inner_t)) / sizeof(void*) - 1) / 2;
+}
+
+/* function: innermin_bptree
+ * Returns the minimum number of separators stored in an inner page which is not the root.
+ * Merging two inner pages of minimum size together with their separator must fit into a single page. */
+static inline size_t innermin_bptree(const bptree_t * tree)
+{
+   return (innermax_bptree(tree) - 1) / 2;
+}
+
+/* function: child_bptreeinner
+ * Returns the array of child pointers of an inner page. */
+static inline void ** child_bptreeinner(bptree_inner_t * inner, size_t innermax)
+{
+   return (void**) &inner->key[innermax];
+}
+
+/* function: compare_bptree
+ * Compares a key (iskey == true) or an object (iskey == false) with the object of node. */
+static inline int compare_bptree(bptree_t * tree, bool iskey, const void * keyobj, bptree_node_t * node)
+{
+   typeadapt_object_t * object = cast2object_typeadaptmember(&tree->nodeadp, node);
+   return iskey ? callcmpkeyobj_typeadaptmember(&tree->nodeadp, keyobj, object)
+                : callcmpobj_typeadaptmember(&tree->nodeadp, (const typeadapt_object_t*)keyobj, object);
+}
+
+/* function: searchinner_bptree
+ * Returns the index of the child which contains keyobj.
+ * The index is the number of separators less or equal than keyobj. */
+static inline size_t searchinner_bptree(bptree_t * tree, bool iskey, const void * keyobj, const bptree_inner_t * inner)
+{
+   size_t low  = 0;
+   size_t high = inner->size;
+
+   while (low < high) {
+      size_t mid = (low + high) / 2;
+      if (compare_bptree(tree, iskey, keyobj, inner->key[mid]) < 0) {
+         high = mid;
+      } else {
+         low = mid + 1;
+      }
+   }
+
+   return low;
+}
+
+/* function: searchleaf_bptree
+ * Returns true and the index of the entry equal to keyobj.
+ * If no such entry exists false is returned and index is set to the position where keyobj would be inserted. */
+static inline bool searchleaf_bptree(bptree_t * tree, bool iskey, const void * keyobj, const bptree_leaf_t * leaf, /*out*/size_t * index)
+{
+   size_t low  = 0;
+   size_t high = leaf->size;
+
+   while (low < high) {
+      size_t mid = (low + high) / 2;
+      int    cmp = compare_bptree(tree, iskey, keyobj, leaf->entry[mid]);
+      if (cmp == 0) {
+         *index = mid;
+         return true;
+      }
+      if (cmp < 0) {
+         high = mid;
+      } else {
+         low = mid + 1;
+      }
+   }
+
+   *index = low;
+   return false;
+}
+
+/* function: findleaf_bptree
+ * Returns the leaf which contains keyobj. The tree must not be empty. */
+static bptree_leaf_t * findleaf_bptree(bptree_t * tree, bool iskey, const void * keyobj)
+{
+   const size_t innermax = innermax_bptree(tree);
+   void *       page     = tree->root;
+
+   for (unsigned level = tree->height; level; --level) {
+      bptree_inner_t * inner = page;
+      page = child_bptreeinner(inner, innermax)[searchinner_bptree(tree, iskey, keyobj, inner)];
+   }
+
+   return page;
+}
+
+// group: memory
+
+/* function: newpage_bptree
+ * Allocates a single page of size <bptree_t.pgsize> with <ALLOC_PAGECACHE>. */
+static int newpage_bptree(bptree_t * tree, /*out*/void ** page)
+{
+   int err;
+   memblock_t mblock;
+
+   if (! PROCESS_testerrortimer(&s_bptree_errtimer, &err)) {
+      err = ALLOC_PAGECACHE(tree->pgsize, &mblock);
+   }
+   if (err) goto ONERR;
+
+   *page = mblock.addr;
+
+   return 0;
+ONERR:
+   return err;
+}
+
+/* function: deletepage_bptree
+ * Frees a single page with <RELEASE_PAGECACHE>. */
+static int deletepage_bptree(bptree_t * tree, void * page)
+{
+   memblock_t mblock = memblock_INIT(pagesizeinbytes_pagecache(tree->pgsize), (uint8_t*)page);
+
+   return RELEASE_PAGECACHE(&mblock);
+}
+
+/* function: deletesubtree_bptree
+ * Frees page and all pages of its subtree. The pages are not unlinked from the tree. */
+static int deletesubtree_bptree(bptree_t * tree, void * page, unsigned level)
+{
+   int err = 0;
+
+   if (level) {
+      bptree_inner_t * inner = page;
+      void **          child = child_bptreeinner(inner, innermax_bptree(tree));
+      for (size_t i = 0; i <= inner->size; ++i) {
+         int err2 = deletesubtree_bptree(tree, child[i], level-1);
+         if (err2) err = err2;
+      }
+   }
+
+   int err2 = deletepage_bptree(tree, page);
+   if (err2) err = err2;
+
+   return err;
+}
+
+// group: lifetime
+
+int free_bptree(bptree_t * tree)
+{
+   int err;
+
+   err = removenodes_bptree(tree);
+
+   tree->nodeadp = (typeadapt_member_t) typeadapt_member_FREE;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: search
+
+int find_bptree(bptree_t * tree, const void * key, /*out*/bptree_node_t ** found_node)
+{
+   if (tree->root) {
+      size_t          index;
+      bptree_leaf_t * leaf = findleaf_bptree(tree, true, key);
+
+      if (searchleaf_bptree(tree, true, key, leaf, &index)) {
+         *found_node = leaf->entry[index];
+         return 0;
+      }
+   }
+
+   return ESRCH;
+}
+
+// group: change
+
+/* function: splitchild_bptree
+ * Splits the full page child[c] of parent into two pages.
+ * The upper half is moved into a new page which is inserted as child[c+1] into parent.
+ * The separator of the two pages is inserted into parent at index c.
+ * Parameter parent must not be full. If the new page could not be allocated nothing is changed. */
+static int splitchild_bptree(bptree_t * tree, bptree_inner_t * parent, size_t c, bool isleaf)
+{
+   int err;
+   const size_t    innermax = innermax_bptree(tree);
+   void **         pchild   = child_bptreeinner(parent, innermax);
+   void *          newpage;
+   bptree_node_t * separator;
+
+   err = newpage_bptree(tree, &newpage);
+   if (err) return err;
+
+   if (isleaf) {
+      bptree_leaf_t * left   = pchild[c];
+      bptree_leaf_t * right  = newpage;
+      size_t          nrleft = left->size / 2;
+      right->size = left->size - nrleft;
+      memcpy(right->entry, left->entry + nrleft, right->size * sizeof(right->entry[0]));
+      left->size  = nrleft;
+      right->prev = left;
+      right->next = left->next;
+      if (left->next) {
+         left->next->prev = right;
+      } else {
+         tree->last = right;
+      }
+      left->next = right;
+      separator  = right->entry[0];
+   } else {
+      bptree_inner_t * left   = pchild[c];
+      bptree_inner_t * right  = newpage;
+      size_t           nrleft = left->size / 2;
+      separator   = left->key[nrleft];
+      right->size = left->size - nrleft - 1;
+      memcpy(right->key, left->key + nrleft + 1, right->size * sizeof(right->key[0]));
+      memcpy(child_bptreeinner(right, innermax), child_bptreeinner(left, innermax) + nrleft + 1, (right->size + 1) * sizeof(void*));
+      left->size  = nrleft;
+   }
+
+   memmove(parent->key + c + 1, parent->key + c, (parent->size - c) * sizeof(parent->key[0]));
+   memmove(pchild + c + 2, pchild + c + 1, (parent->size - c) * sizeof(void*));
+   parent->key[c] = separator;
+   pchild[c+1]    = newpage;
+   ++ parent->size;
+   ++ tree->changecount;
+
+   return 0;
+}
+
+/* function: borrowleft_bptree
+ * Moves the biggest entry of child[c-1] into child[c]. */
+static void borrowleft_bptree(bptree_t * tree, bptree_inner_t * parent, size_t c, bool isleaf)
+{
+   const size_t innermax = innermax_bptree(tree);
+   void **      pchild   = child_bptreeinner(parent, innermax);
+
+   if (isleaf) {
+      bptree_leaf_t * left = pchild[c-1];
+      bptree_leaf_t * leaf = pchild[c];
+      memmove(leaf->entry + 1, leaf->entry, leaf->size * sizeof(leaf->entry[0]));
+      leaf->entry[0] = left->entry[-- left->size];
+      ++ leaf->size;
+      parent->key[c-1] = leaf->entry[0];
+   } else {
+      bptree_inner_t * left   = pchild[c-1];
+      bptree_inner_t * inner  = pchild[c];
+      void **          lchild = child_bptreeinner(left, innermax);
+      void **          ichild = child_bptreeinner(inner, innermax);
+      memmove(inner->key + 1, inner->key, inner->size * sizeof(inner->key[0]));
+      memmove(ichild + 1, ichild, (inner->size + 1) * sizeof(void*));
+      inner->key[0]    = parent->key[c-1];
+      ichild[0]        = lchild[left->size];
+      parent->key[c-1] = left->key[left->size-1];
+      -- left->size;
+      ++ inner->size;
+   }
+
+   ++ tree->changecount;
+}
+
+/* function: borrowright_bptree
+ * Moves the smallest entry of child[c+1] into child[c]. */
+static void borrowright_bptree(bptree_t * tree, bptree_inner_t * parent, size_t c, bool isleaf)
+{
+   const size_t innermax = innermax_bptree(tree);
+   void **      pchild   = child_bptreeinner(parent, innermax);
+
+   if (isleaf) {
+      bptree_leaf_t * leaf  = pchild[c];
+      bptree_leaf_t * right = pchild[c+1];
+      leaf->entry[leaf->size ++] = right->entry[0];
+      -- right->size;
+      memmove(right->entry, right->entry + 1, right->size * sizeof(right->entry[0]));
+      parent->key[c] = right->entry[0];
+   } else {
+      bptree_inner_t * inner  = pchild[c];
+      bptree_inner_t * right  = pchild[c+1];
+      void **          ichild = child_bptreeinner(inner, innermax);
+      void **          rchild = child_bptreeinner(right, innermax);
+      inner->key[inner->size] = parent->key[c];
+      ichild[inner->size + 1] = rchild[0];
+      ++ inner->size;
+      parent->key[c] = right->key[0];
+      memmove(right->key, right->key + 1, (right->size - 1) * sizeof(right->key[0]));
+      memmove(rchild, rchild + 1, right->size * sizeof(void*));
+      -- right->size;
+   }
+
+   ++ tree->changecount;
+}
+
+/* function: mergechild_bptree
+ * Moves all entries of child[c+1] into child[c] and frees child[c+1].
+ * The separator at index c and child[c+1] are removed from parent.
+ * The returned error code is the result of freeing the page. The tree is valid in any case. */
+static int mergechild_bptree(bptree_t * tree, bptree_inner_t * parent, size_t c, bool isleaf)
+{
+   const size_t innermax = innermax_bptree(tree);
+   void **      pchild   = child_bptreeinner(parent, innermax);
+   void *       delpage  = pchild[c+1];
+
+   if (isleaf) {
+      bptree_leaf_t * left  = pchild[c];
+      bptree_leaf_t * right = delpage;
+      memcpy(left->entry + left->size, right->entry, right->size * sizeof(right->entry[0]));
+      left->size += right->size;
+      left->next  = right->next;
+      if (right->next) {
+         right->next->prev = left;
+      } else {
+         tree->last = left;
+      }
+   } else {
+      bptree_inner_t * left  = pchild[c];
+      bptree_inner_t * right = delpage;
+      left->key[left->size] = parent->key[c];
+      memcpy(left->key + left->size + 1, right->key, right->size * sizeof(right->key[0]));
+      memcpy(child_bptreeinner(left, innermax) + left->size + 1, child_bptreeinner(right, innermax), (right->size + 1) * sizeof(void*));
+      left->size += right->size + 1;
+   }
+
+   memmove(parent->key + c, parent->key + c + 1, (parent->size - c - 1) * sizeof(parent->key[0]));
+   memmove(pchild + c + 1, pchild + c + 2, (parent->size - c - 1) * sizeof(void*));
+   -- parent->size;
+   ++ tree->changecount;
+
+   return deletepage_bptree(tree, delpage);
+}
+
+/* function: fillchild_bptree
+ * Makes sure child[*c] of parent contains more than the minimum number of entries.
+ * An entry is borrowed from a sibling or the child is merged with a sibling.
+ * Parameter c is set to the index of the child which contains all entries of the former child[*c]. */
+static int fillchild_bptree(bptree_t * tree, bptree_inner_t * parent, /*inout*/size_t * c, bool isleaf)
+{
+   const size_t minsize = isleaf ? leafmin_bptree(tree) : innermin_bptree(tree);
+   void **      pchild  = child_bptreeinner(parent, innermax_bptree(tree));
+
+   if (*c > 0 && sizeofpage_bptree(pchild[*c-1]) > minsize) {
+      borrowleft_bptree(tree, parent, *c, isleaf);
+      return 0;
+   }
+
+   if (*c < parent->size && sizeofpage_bptree(pchild[*c+1]) > minsize) {
+      borrowright_bptree(tree, parent, *c, isleaf);
+      return 0;
+   }
+
+   if (*c > 0) {
+      -- *c;
+   }
+
+   return mergechild_bptree(tree, parent, *c, isleaf);
+}
+
+int insert_bptree(bptree_t * tree, bptree_node_t * new_node)
+{
+   int err;
+   const size_t         innermax = innermax_bptree(tree);
+   const size_t         leafmax  = leafmax_bptree(tree);
+   typeadapt_object_t * newobj   = cast2object_typeadaptmember(&tree->nodeadp, new_node);
+   void *               page;
+
+   if (! tree->root) {
+      err = newpage_bptree(tree, &page);
+      if (err) goto ONERR;
+      bptree_leaf_t * leaf = page;
+      leaf->size     = 1;
+      leaf->prev     = 0;
+      leaf->next     = 0;
+      leaf->entry[0] = new_node;
+      tree->root   = leaf;
+      tree->first  = leaf;
+      tree->last   = leaf;
+      tree->height = 0;
+      ++ tree->changecount;
+      return 0;
+   }
+
+   if (sizeofpage_bptree(tree->root) == (tree->height ? innermax : leafmax)) {
+      err = newpage_bptree(tree, &page);
+      if (err) goto ONERR;
+      bptree_inner_t * newroot = page;
+      newroot->size = 0;
+      child_bptreeinner(newroot, innermax)[0] = tree->root;
+      err = splitchild_bptree(tree, newroot, 0, 0 == tree->height);
+      if (err) {
+         (void) deletepage_bptree(tree, page);
+         goto ONERR;
+      }
+      tree->root = newroot;
+      ++ tree->height;
+   }
+
+   page = tree->root;
+   for (unsigned level = tree->height; level; --level) {
+      bptree_inner_t * inner = page;
+      void **          child = child_bptreeinner(inner, innermax);
+      size_t           c     = searchinner_bptree(tree, false, newobj, inner);
+
+      if (sizeofpage_bptree(child[c]) == (level == 1 ? leafmax : innermax)) {
+         err = splitchild_bptree(tree, inner, c, level == 1);
+         if (err) goto ONERR;
+         if (compare_bptree(tree, false, newobj, inner->key[c]) >= 0) ++ c;
+      }
+
+      page = child[c];
+   }
+
+   bptree_leaf_t * leaf = page;
+   size_t          index;
+
+   if (searchleaf_bptree(tree, false, newobj, leaf, &index)) return EEXIST;
+
+   memmove(leaf->entry + index + 1, leaf->entry + index, (leaf->size - index) * sizeof(leaf->entry[0]));
+   leaf->entry[index] = new_node;
+   ++ leaf->size;
+   ++ tree->changecount;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int remove_bptree(bptree_t * tree, bptree_node_t * node)
+{
+   int err = 0;
+   const size_t         innermax  = innermax_bptree(tree);
+   const size_t         innermin  = innermin_bptree(tree);
+   const size_t         leafmin   = leafmin_bptree(tree);
+   typeadapt_object_t * object    = cast2object_typeadaptmember(&tree->nodeadp, node);
+   bptree_node_t **     separator = 0;
+   void *               page      = tree->root;
+
+   if (! page) {
+      err = ESRCH;
+      goto ONERR;
+   }
+
+   for (unsigned level = tree->height; level; --level) {
+      bptree_inner_t * inner = page;
+      void **          child = child_bptreeinner(inner, innermax);
+      size_t           c     = searchinner_bptree(tree, false, object, inner);
+
+      if (sizeofpage_bptree(child[c]) <= (level == 1 ? leafmin : innermin)) {
+         int err2 = fillchild_bptree(tree, inner, &c, level == 1);
+         if (err2) err = err2;
+
+         if (0 == inner->size) {
+            // root has lost its last separator
+            tree->root = child[0];
+            -- tree->height;
+            page = child[0];
+            err2 = deletepage_bptree(tree, inner);
+            if (err2) err = err2;
+            continue;
+         }
+      }
+
+      // node is separator of a subtree of exactly one inner page on the path
+      if (c && inner->key[c-1] == node) separator = &inner->key[c-1];
+
+      page = child[c];
+   }
+
+   bptree_leaf_t * leaf = page;
+   size_t          index;
+
+   if (  ! searchleaf_bptree(tree, false, object, leaf, &index)
+         || leaf->entry[index] != node) {
+      err = ESRCH;
+      goto ONERR;
+   }
+
+   -- leaf->size;
+   memmove(leaf->entry + index, leaf->entry + index + 1, (leaf->size - index) * sizeof(leaf->entry[0]));
+   ++ tree->changecount;
+
+   if (separator) {
+      // node was the smallest entry of leaf which is never the root
+      *separator = leaf->entry[0];
+   }
+
+   if (0 == leaf->size) {
+      // leaf is the root
+      tree->root  = 0;
+      tree->first = 0;
+      tree->last  = 0;
+      int err2 = deletepage_bptree(tree, leaf);
+      if (err2) err = err2;
+   }
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   if (err != ESRCH) {
+      TRACEEXIT_ERRLOG(err);
+   }
+   return err;
+}
+
+int removenodes_bptree(bptree_t * tree)
+{
+   int err = 0;
+
+   if (tree->root) {
+      const bool isDeleteObject = iscalldelete_typeadapt(tree->nodeadp.typeadp);
+
+      if (isDeleteObject) {
+         for (bptree_leaf_t * leaf = tree->first; leaf; leaf = leaf->next) {
+            for (size_t i = 0; i < leaf->size; ++i) {
+               typeadapt_object_t * object = cast2object_typeadaptmember(&tree->nodeadp, leaf->entry[i]);
+               int err2 = calldelete_typeadaptmember(&tree->nodeadp, &object);
+               if (err2) err = err2;
+            }
+         }
+      }
+
+      int err2 = deletesubtree_bptree(tree, tree->root, tree->height);
+      if (err2) err = err2;
+
+      tree->root   = 0;
+      tree->first  = 0;
+      tree->last   = 0;
+      tree->height = 0;
+      ++ tree->changecount;
+   }
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: test
+
+/* function: invariantpage_bptree
+ * Checks page and all pages of its subtree.
+ * The leaves are checked in ascending order. Parameter prevleaf and prevnode
+ * are set to the last visited leaf and the last visited node.
+ * Parameter minnode is the expected smallest node of the subtree or 0 if unknown. */
+static int invariantpage_bptree(bptree_t * tree, void * page, unsigned level, bool isroot, bptree_node_t * minnode, bptree_leaf_t ** prevleaf, bptree_node_t ** prevnode)
+{
+   int err;
+
+   if (0 == level) {
+      bptree_leaf_t * leaf = page;
+
+      if (  leaf->size > leafmax_bptree(tree)
+            || leaf->size < (isroot ? 1 : leafmin_bptree(tree))
+            || leaf->prev != *prevleaf
+            || (minnode && leaf->entry[0] != minnode)) {
+         return EINVAL;
+      }
+
+      if (*prevleaf ? (*prevleaf)->next != leaf : tree->first != leaf) {
+         return EINVAL;
+      }
+
+      for (size_t i = 0; i < leaf->size; ++i) {
+         if (*prevnode) {
+            typeadapt_object_t * object = cast2object_typeadaptmember(&tree->nodeadp, *prevnode);
+            if (compare_bptree(tree, false, object, leaf->entry[i]) >= 0) return EINVAL;
+         }
+         *prevnode = leaf->entry[i];
+      }
+
+      *prevleaf = leaf;
+
+   } else {
+      bptree_inner_t * inner = page;
+      void **          child = child_bptreeinner(inner, innermax_bptree(tree));
+
+      if (  inner->size > innermax_bptree(tree)
+            || inner->size < (isroot ? 1 : innermin_bptree(tree))) {
+         return EINVAL;
+      }
+
+      for (size_t i = 0; i <= inner->size; ++i) {
+         err = invariantpage_bptree(tree, child[i], level-1, false, i ? inner->key[i-1] : minnode, prevleaf, prevnode);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int invariant_bptree(bptree_t * tree)
+{
+   int err;
+
+   if (! tree->root) {
+      if (tree->first || tree->last || tree->height) {
+         err = EINVAL;
+         goto ONERR;
+      }
+
+   } else {
+      bptree_leaf_t * prevleaf = 0;
+      bptree_node_t * prevnode = 0;
+
+      if (tree->pgsize >= pagesize__NROF) {
+         err = EINVAL;
+         goto ONERR;
+      }
+
+      err = invariantpage_bptree(tree, tree->root, tree->height, true, 0, &prevleaf, &prevnode);
+      if (err) goto ONERR;
+
+      if (prevleaf != tree->last || tree->last->next) {
+         err = EINVAL;
+         goto ONERR;
+      }
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
+// section: bptree_iterator_t
+
+// group: helper
+
+/* function: relocate_bptreeiterator
+ * Searches <bptree_iterator_t.next> in the tree and updates leaf and index. */
+static void relocate_bptreeiterator(bptree_iterator_t * iter)
+{
+   bptree_t *           tree   = iter->tree;
+   typeadapt_object_t * object = cast2object_typeadaptmember(&tree->nodeadp, iter->next);
+
+   iter->leaf = findleaf_bptree(tree, false, object);
+   (void) searchleaf_bptree(tree, false, object, iter->leaf, &iter->index);
+   iter->changecount = tree->changecount;
+}
+
+// group: lifetime
+
+int initfirst_bptreeiterator(/*out*/bptree_iterator_t * iter, bptree_t * tree)
+{
+   iter->tree  = tree;
+   iter->leaf  = tree->first;
+   iter->index = 0;
+   iter->next  = tree->first ? tree->first->entry[0] : 0;
+   iter->changecount = tree->changecount;
+   return 0;
+}
+
+int initlast_bptreeiterator(/*out*/bptree_iterator_t * iter, bptree_t * tree)
+{
+   iter->tree  = tree;
+   iter->leaf  = tree->last;
+   iter->index = tree->last ? tree->last->size - 1 : 0;
+   iter->next  = tree->last ? tree->last->entry[iter->index] : 0;
+   iter->changecount = tree->changecount;
+   return 0;
+}
+
+int initfrom_bptreeiterator(/*out*/bptree_iterator_t * iter, bptree_t * tree, const void * key)
+{
+   bptree_leaf_t * leaf  = 0;
+   size_t          index = 0;
+
+   if (tree->root) {
+      leaf = findleaf_bptree(tree, true, key);
+      (void) searchleaf_bptree(tree, true, key, leaf, &index);
+      if (index == leaf->size) {
+         leaf  = leaf->next;
+         index = 0;
+      }
+   }
+
+   iter->tree  = tree;
+   iter->leaf  = leaf;
+   iter->index = index;
+   iter->next  = leaf ? leaf->entry[index] : 0;
+   iter->changecount = tree->changecount;
+   return 0;
+}
+
+// group: iterate
+
+bool next_bptreeiterator(bptree_iterator_t * iter, /*out*/bptree_node_t ** node)
+{
+   if (! iter->next) return false;
+
+   if (iter->changecount != iter->tree->changecount) {
+      relocate_bptreeiterator(iter);
+   }
+
+   *node = iter->next;
+
+   if (++ iter->index == iter->leaf->size) {
+      iter->leaf  = iter->leaf->next;
+      iter->index = 0;
+   }
+
+   iter->next = iter->leaf ? iter->leaf->entry[iter->index] : 0;
+
+   return true;
+}
+
+bool prev_bptreeiterator(bptree_iterator_t * iter, /*out*/bptree_node_t ** node)
+{
+   if (! iter->next) return false;
+
+   if (iter->changecount != iter->tree->changecount) {
+      relocate_bptreeiterator(iter);
+   }
+
+   *node = iter->next;
+
+   if (iter->index) {
+      -- iter->index;
+   } else {
+      iter->leaf  = iter->leaf->prev;
+      iter->index = iter->leaf ? iter->leaf->size - 1 : 0;
+   }
+
+   iter->next = iter->leaf ? iter->leaf->entry[iter->index] : 0;
+
+   return true;
+}
+
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+typedef struct testnode_t {
+   uintptr_t      key;
+   bptree_node_t  node;
+   int            is_freed;
+} testnode_t;
+
+typedef struct testadapt_t {
+   struct {
+      typeadapt_EMBED(struct testadapt_t, testnode_t, uintptr_t);
+   };
+   test_errortimer_t    errcounter;
+   unsigned             freenode_count;
+} testadapt_t;
+
+static int impl_deletenode_testadapt(testadapt_t * testadp, testnode_t ** node)
+{
+   int err = 0;
+
+   if (! process_testerrortimer(&testadp->errcounter, &err)) {
+      ++ testadp->freenode_count;
+      ++ (*node)->is_freed;
+   }
+
+   *node = 0;
+
+   return err;
+}
+
+static int impl_cmpkeyobj_testadapt(testadapt_t * testadp, const uintptr_t lkey, const testnode_t * rnode)
+{
+   (void) testadp;
+   uintptr_t rkey = rnode->key;
+   return lkey < rkey ? -1 : (lkey > rkey ? +1 : 0);
+}
+
+static int impl_cmpobj_testadapt(testadapt_t * testadp, const testnode_t * lnode, const testnode_t * rnode)
+{
+   (void) testadp;
+   uintptr_t lkey = lnode->key;
+   uintptr_t rkey = rnode->key;
+   return lkey < rkey ? -1 : (lkey > rkey ? +1 : 0);
+}
+
+static int test_initfree(void)
+{
+   testnode_t           nodes[2000];
+   testadapt_t          typeadapt = {
+                           typeadapt_INIT_LIFECMP(0, &impl_deletenode_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt),
+                           test_errortimer_FREE, 0
+                        };
+   typeadapt_member_t   nodeadapt  = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testnode_t, uintptr_t), offsetof(testnode_t, node));
+   typeadapt_member_t   emptyadapt = typeadapt_member_FREE;
+   bptree_t             tree       = bptree_FREE;
+   bptree_node_t        emptynode  = bptree_node_INIT;
+   bptree_iterator_t    iter       = bptree_iterator_FREE;
+   size_t               oldsize;
+
+   // prepare
+   MEMSET0(&nodes);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].key = i;
+   }
+
+   // TEST bptree_node_INIT
+   TEST(0 == emptynode.unused);
+
+   // TEST bptree_iterator_FREE
+   TEST(0 == iter.tree);
+   TEST(0 == iter.leaf);
+   TEST(0 == iter.index);
+   TEST(0 == iter.next);
+   TEST(0 == iter.changecount);
+
+   // TEST bptree_FREE
+   TEST(0 == tree.root);
+   TEST(0 == tree.first);
+   TEST(0 == tree.last);
+   TEST(0 == tree.changecount);
+   TEST(0 == tree.height);
+   TEST(pagesize_4096 == tree.pgsize);
+   TEST(isequal_typeadaptmember(&emptyadapt, &tree.nodeadp));
+
+   // TEST bptree_INIT
+   for (pagesize_e pgsize = pagesize_256; pgsize < pagesize__NROF; ++pgsize) {
+      tree = (bptree_t) bptree_INIT(pgsize, nodeadapt);
+      TEST(0 == tree.root);
+      TEST(0 == tree.first);
+      TEST(0 == tree.last);
+      TEST(0 == tree.changecount);
+      TEST(0 == tree.height);
+      TEST(pgsize == tree.pgsize);
+      TEST(isequal_typeadaptmember(&nodeadapt, &tree.nodeadp));
+   }
+
+   // TEST init_bptree, double free_bptree
+   tree.root = (void*)1;
+   init_bptree(&tree, &nodeadapt);
+   TEST(0 == tree.root);
+   TEST(pagesize_4096 == tree.pgsize);
+   TEST(isequal_typeadaptmember(&nodeadapt, &tree.nodeadp));
+   TEST(0 == free_bptree(&tree));
+   TEST(0 == tree.root);
+   TEST(isequal_typeadaptmember(&emptyadapt, &tree.nodeadp));
+   TEST(0 == free_bptree(&tree));
+   TEST(0 == tree.root);
+   TEST(isequal_typeadaptmember(&emptyadapt, &tree.nodeadp));
+
+   // TEST leafmax_bptree, leafmin_bptree, innermax_bptree, innermin_bptree
+   tree = (bptree_t) bptree_INIT(pagesize_4096, nodeadapt);
+   TEST(509 == leafmax_bptree(&tree));
+   TEST(254 == leafmin_bptree(&tree));
+   TEST(255 == innermax_bptree(&tree));
+   TEST(127 == innermin_bptree(&tree));
+   tree = (bptree_t) bptree_INIT(pagesize_256, nodeadapt);
+   TEST(29 == leafmax_bptree(&tree));
+   TEST(14 == leafmin_bptree(&tree));
+   TEST(15 == innermax_bptree(&tree));
+   TEST(7  == innermin_bptree(&tree));
+   for (pagesize_e pgsize = pagesize_256; pgsize < pagesize__NROF; ++pgsize) {
+      tree.pgsize = pgsize;
+      size_t pgbytes = pagesizeinbytes_pagecache(pgsize);
+      TEST(sizeof(bptree_leaf_t) + leafmax_bptree(&tree) * sizeof(void*) <= pgbytes);
+      TEST(sizeof(bptree_leaf_t) + (leafmax_bptree(&tree)+1) * sizeof(void*) > pgbytes);
+      TEST(sizeof(bptree_inner_t) + (2*innermax_bptree(&tree)+1) * sizeof(void*) <= pgbytes);
+      TEST(2*innermin_bptree(&tree) + 1 <= innermax_bptree(&tree));
+      TEST(2*leafmin_bptree(&tree) <= leafmax_bptree(&tree));
+   }
+
+   // TEST free_bptree: frees nodes and pages
+   oldsize = SIZEALLOCATED_PAGECACHE();
+   tree = (bptree_t) bptree_INIT(pagesize_256, nodeadapt);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_bptree(&tree, &nodes[i].node));
+   }
+   TEST(2 <= tree.height);
+   TEST(oldsize < SIZEALLOCATED_PAGECACHE());
+   TEST(0 == free_bptree(&tree));
+   TEST(0 == tree.root);
+   TEST(0 == tree.first);
+   TEST(0 == tree.last);
+   TEST(0 == tree.height);
+   TEST(isequal_typeadaptmember(&emptyadapt, &tree.nodeadp));
+   TEST(oldsize == SIZEALLOCATED_PAGECACHE());
+   TEST(lengthof(nodes) == typeadapt.freenode_count);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(1 == nodes[i].is_freed);
+      nodes[i].is_freed = 0;
+   }
+
+   // TEST free_bptree: ERROR
+   typeadapt.freenode_count = 0;
+   tree = (bptree_t) bptree_INIT(pagesize_256, nodeadapt);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_bptree(&tree, &nodes[i].node));
+   }
+   init_testerrortimer(&typeadapt.errcounter, 5, EINVAL);
+   TEST(EINVAL == free_bptree(&tree));
+   TEST(0 == tree.root);
+   TEST(oldsize == SIZEALLOCATED_PAGECACHE());
+   TEST(lengthof(nodes)-1 == typeadapt.freenode_count);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST((i != 4) == nodes[i].is_freed);
+      nodes[i].is_freed = 0;
+   }
+
+   // TEST isempty_bptree
+   tree = (bptree_t) bptree_INIT(pagesize_256, nodeadapt);
+   TEST(1 == isempty_bptree(&tree));
+   TEST(0 == insert_bptree(&tree, &nodes[0].node));
+   TEST(0 == isempty_bptree(&tree));
+   TEST(0 == remove_bptree(&tree, &nodes[0].node));
+   TEST(1 == isempty_bptree(&tree));
+   TEST(oldsize == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_bptree(&tree);
+   return EINVAL;
+}
+
+static int test_insertremove(void)
+{
+   testadapt_t          typeadapt = {
+                           typeadapt_INIT_LIFECMP(0, &impl_deletenode_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt),
+                           test_errortimer_FREE, 0
+                        };
+   typeadapt_member_t   nodeadapt = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testnode_t, uintptr_t), offsetof(testnode_t, node));
+   bptree_t             tree      = bptree_INIT(pagesize_256, nodeadapt);
+   memblock_t           memblock  = memblock_FREE;
+   const size_t         nrnodes   = 20000;
+   testnode_t *         nodes;
+   bptree_node_t *      found;
+   size_t               oldsize   = SIZEALLOCATED_PAGECACHE();
+
+   // prepare
+   TEST(0 == ALLOC_MM(nrnodes * sizeof(testnode_t), &memblock));
+   nodes = (testnode_t*) memblock.addr;
+   memset(nodes, 0, nrnodes * sizeof(testnode_t));
+   for (unsigned i = 0; i < nrnodes; ++i) {
+      nodes[i].key = i;
+   }
+
+   // TEST find_bptree: empty tree
+   TEST(ESRCH == find_bptree(&tree, (void*)0, &found));
+
+   // TEST remove_bptree: empty tree
+   TEST(ESRCH == remove_bptree(&tree, &nodes[0].node));
+
+   for (unsigned testcase = 0; testcase < 4; ++testcase) {
+
+      // TEST insert_bptree: ascending, descending, interleaved, random
+      srand(testcase);
+      for (size_t i = 0; i < nrnodes; ++i) {
+         size_t k = testcase == 0 ? i
+                  : testcase == 1 ? nrnodes-1-i
+                  : testcase == 2 ? (i & 1 ? nrnodes-1-i/2 : i/2)
+                  : i;
+         if (testcase == 3) {
+            // swap with random unused node
+            size_t r = i + (size_t)rand() % (nrnodes - i);
+            uintptr_t key = nodes[r].key;
+            nodes[r].key = nodes[i].key;
+            nodes[i].key = key;
+         }
+         size_t changecount = tree.changecount;
+         TEST(0 == insert_bptree(&tree, &nodes[k].node));
+         TEST(changecount < tree.changecount);
+         TEST(EEXIST == insert_bptree(&tree, &nodes[k].node));
+         if (0 == (i % 1000)) {
+            TEST(0 == invariant_bptree(&tree));
+         }
+      }
+      TEST(0 == invariant_bptree(&tree));
+      TEST(3 <= tree.height && tree.height <= 4);
+
+      // TEST find_bptree
+      for (size_t i = 0; i < nrnodes; ++i) {
+         TEST(0 == find_bptree(&tree, (void*)nodes[i].key, &found));
+         TEST(found == &nodes[i].node);
+      }
+      TEST(ESRCH == find_bptree(&tree, (void*)nrnodes, &found));
+
+      // TEST remove_bptree: ESRCH
+      nodes[0].key += nrnodes;
+      TEST(ESRCH == remove_bptree(&tree, &nodes[0].node));
+      nodes[0].key -= nrnodes;
+      TEST(0 == invariant_bptree(&tree));
+
+      // TEST remove_bptree: ascending, descending, interleaved, random
+      for (size_t i = 0; i < nrnodes; ++i) {
+         size_t k = testcase == 0 ? i
+                  : testcase == 1 ? nrnodes-1-i
+                  : testcase == 2 ? (i & 1 ? nrnodes-1-i/2 : i/2)
+                  : (i * 7919) % nrnodes;
+         size_t changecount = tree.changecount;
+         TEST(0 == remove_bptree(&tree, &nodes[k].node));
+         TEST(changecount < tree.changecount);
+         TEST(ESRCH == find_bptree(&tree, (void*)nodes[k].key, &found));
+         if (0 == (i % 1000)) {
+            TEST(0 == invariant_bptree(&tree));
+         }
+      }
+      TEST(0 == invariant_bptree(&tree));
+      TEST(1 == isempty_bptree(&tree));
+      TEST(0 == tree.height);
+      TEST(oldsize == SIZEALLOCATED_PAGECACHE());
+      TEST(0 == typeadapt.freenode_count);
+
+      // reset keys
+      for (unsigned i = 0; i < nrnodes; ++i) {
+         nodes[i].key = i;
+      }
+   }
+
+   // TEST insert_bptree, remove_bptree: separator replaced if smallest node of leaf is removed
+   for (size_t i = 0; i < nrnodes; ++i) {
+      TEST(0 == insert_bptree(&tree, &nodes[i].node));
+   }
+   for (size_t i = 0; i < nrnodes/2; ++i) {
+      // remove smallest node of every second leaf
+      TEST(0 == remove_bptree(&tree, &nodes[(i * 29) % nrnodes].node));
+      TEST(0 == insert_bptree(&tree, &nodes[(i * 29) % nrnodes].node));
+   }
+   TEST(0 == invariant_bptree(&tree));
+   for (size_t i = 0; i < nrnodes; ++i) {
+      TEST(0 == find_bptree(&tree, (void*)i, &found));
+      TEST(found == &nodes[i].node);
+   }
+
+   // TEST removenodes_bptree
+   TEST(0 == removenodes_bptree(&tree));
+   TEST(1 == isempty_bptree(&tree));
+   TEST(0 == invariant_bptree(&tree));
+   TEST(nrnodes == typeadapt.freenode_count);
+   TEST(oldsize == SIZEALLOCATED_PAGECACHE());
+   for (size_t i = 0; i < nrnodes; ++i) {
+      TEST(1 == nodes[i].is_freed);
+      nodes[i].is_freed = 0;
+   }
+   typeadapt.freenode_count = 0;
+
+   // TEST insert_bptree: ENOMEM
+   for (unsigned errcount = 1; ; ++errcount) {
+      init_testerrortimer(&s_bptree_errtimer, errcount, ENOMEM);
+      size_t i;
+      int    err = 0;
+      for (i = 0; i < 1000; ++i) {
+         err = insert_bptree(&tree, &nodes[i].node);
+         if (err) break;
+      }
+      TEST(0 == invariant_bptree(&tree));
+      if (! err) {
+         free_testerrortimer(&s_bptree_errtimer);
+         TEST(errcount > 30);
+         break;
+      }
+      TEST(ENOMEM == err);
+      TEST(ESRCH == find_bptree(&tree, (void*)i, &found));
+      for (size_t i2 = 0; i2 < i; ++i2) {
+         TEST(0 == find_bptree(&tree, (void*)i2, &found));
+      }
+      TEST(0 == removenodes_bptree(&tree));
+      TEST(oldsize == SIZEALLOCATED_PAGECACHE());
+   }
+   TEST(0 == removenodes_bptree(&tree));
+   for (size_t i = 0; i < nrnodes; ++i) {
+      nodes[i].is_freed = 0;
+   }
+
+   // TEST insert_bptree: pagesize_4096
+   tree.pgsize = pagesize_4096;
+   for (size_t i = 0; i < nrnodes; ++i) {
+      TEST(0 == insert_bptree(&tree, &nodes[i].node));
+   }
+   TEST(1 == tree.height);
+   TEST(0 == invariant_bptree(&tree));
+   for (size_t i = 0; i < nrnodes; ++i) {
+      TEST(0 == remove_bptree(&tree, &nodes[i].node));
+   }
+   TEST(1 == isempty_bptree(&tree));
+   TEST(oldsize == SIZEALLOCATED_PAGECACHE());
+
+   // unprepare
+   TEST(0 == FREE_MM(&memblock));
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_bptree_errtimer);
+   tree.nodeadp = (typeadapt_member_t) typeadapt_member_FREE;
+   free_bptree(&tree);
+   FREE_MM(&memblock);
+   return EINVAL;
+}
+
+static int test_iterator(void)
+{
+   testnode_t           nodes[3000];
+   testadapt_t          typeadapt = {
+                           typeadapt_INIT_LIFECMP(0, &impl_deletenode_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt),
+                           test_errortimer_FREE, 0
+                        };
+   typeadapt_member_t   nodeadapt = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testnode_t, uintptr_t), offsetof(testnode_t, node));
+   bptree_t             tree      = bptree_INIT(pagesize_256, nodeadapt);
+   bptree_iterator_t    iter      = bptree_iterator_FREE;
+   bptree_node_t *      node;
+   size_t               count;
+
+   // prepare
+   MEMSET0(&nodes);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].key = 2*i;
+   }
+
+   // TEST initfirst_bptreeiterator: empty tree
+   TEST(0 == initfirst_bptreeiterator(&iter, &tree));
+   TEST(iter.tree == &tree);
+   TEST(iter.next == 0);
+   TEST(0 == next_bptreeiterator(&iter, &node));
+   TEST(0 == prev_bptreeiterator(&iter, &node));
+
+   // TEST initlast_bptreeiterator: empty tree
+   TEST(0 == initlast_bptreeiterator(&iter, &tree));
+   TEST(iter.tree == &tree);
+   TEST(iter.next == 0);
+   TEST(0 == prev_bptreeiterator(&iter, &node));
+
+   // TEST initfrom_bptreeiterator: empty tree
+   TEST(0 == initfrom_bptreeiterator(&iter, &tree, (void*)0));
+   TEST(iter.tree == &tree);
+   TEST(iter.next == 0);
+   TEST(0 == next_bptreeiterator(&iter, &node));
+
+   // TEST free_bptreeiterator
+   iter.next = &nodes[0].node;
+   TEST(0 == free_bptreeiterator(&iter));
+   TEST(0 == iter.next);
+
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_bptree(&tree, &nodes[i].node));
+   }
+
+   // TEST initfirst_bptreeiterator, next_bptreeiterator
+   TEST(0 == initfirst_bptreeiterator(&iter, &tree));
+   TEST(iter.tree  == &tree);
+   TEST(iter.leaf  == tree.first);
+   TEST(iter.index == 0);
+   TEST(iter.next  == &nodes[0].node);
+   TEST(iter.changecount == tree.changecount);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(1 == next_bptreeiterator(&iter, &node));
+      TEST(node == &nodes[i].node);
+   }
+   TEST(0 == next_bptreeiterator(&iter, &node));
+   TEST(node == &nodes[lengthof(nodes)-1].node);
+   TEST(0 == free_bptreeiterator(&iter));
+
+   // TEST initlast_bptreeiterator, prev_bptreeiterator
+   TEST(0 == initlast_bptreeiterator(&iter, &tree));
+   TEST(iter.leaf  == tree.last);
+   TEST(iter.index == tree.last->size-1);
+   TEST(iter.next  == &nodes[lengthof(nodes)-1].node);
+   for (unsigned i = lengthof(nodes); i-- > 0; ) {
+      TEST(1 == prev_bptreeiterator(&iter, &node));
+      TEST(node == &nodes[i].node);
+   }
+   TEST(0 == prev_bptreeiterator(&iter, &node));
+   TEST(node == &nodes[0].node);
+   TEST(0 == free_bptreeiterator(&iter));
+
+   // TEST initfrom_bptreeiterator: range scan
+   for (uintptr_t key = 0; key <= 2*lengthof(nodes); ++key) {
+      TEST(0 == initfrom_bptreeiterator(&iter, &tree, (void*)key));
+      if (key >= 2*lengthof(nodes)-1) {
+         TEST(0 == iter.next);
+         TEST(0 == next_bptreeiterator(&iter, &node));
+         continue;
+      }
+      for (unsigned i = (unsigned) (key+1)/2, n = 0; i < lengthof(nodes) && n < 40; ++i, ++n) {
+         TEST(1 == next_bptreeiterator(&iter, &node));
+         TEST(node == &nodes[i].node);
+      }
+   }
+   TEST(0 == initfrom_bptreeiterator(&iter, &tree, (void*)101));
+   TEST(1 == prev_bptreeiterator(&iter, &node));
+   TEST(node == &nodes[51].node);
+   TEST(1 == prev_bptreeiterator(&iter, &node));
+   TEST(node == &nodes[50].node);
+
+   // TEST foreach: remove current node
+   count = 0;
+   foreach (_bptree, node2, &tree) {
+      TEST(node2 == &nodes[count].node);
+      if (count % 3) {
+         TEST(0 == remove_bptree(&tree, node2));
+      }
+      ++ count;
+   }
+   TEST(lengthof(nodes) == count);
+   TEST(0 == invariant_bptree(&tree));
+   count = 0;
+   foreach (_bptree, node2, &tree) {
+      TEST(node2 == &nodes[3*count].node);
+      ++ count;
+   }
+   TEST((lengthof(nodes)+2)/3 == count);
+
+   // TEST foreachReverse: remove current node
+   foreachReverse (_bptree, node2, &tree) {
+      -- count;
+      TEST(node2 == &nodes[3*count].node);
+      TEST(0 == remove_bptree(&tree, node2));
+   }
+   TEST(0 == count);
+   TEST(1 == isempty_bptree(&tree));
+
+   // TEST next_bptreeiterator: insert during iteration
+   for (unsigned i = 0; i < lengthof(nodes); i += 2) {
+      TEST(0 == insert_bptree(&tree, &nodes[i].node));
+   }
+   // nodes inserted between the current and the next node are skipped
+   count = 0;
+   unsigned expect = 0;
+   foreach (_bptree, node2, &tree) {
+      TEST(node2 == &nodes[expect].node);
+      if (0 == (expect % 2) && expect + 3 < lengthof(nodes)) {
+         TEST(0 == insert_bptree(&tree, &nodes[expect+3].node));
+      }
+      expect = expect ? expect + 1 : 2;
+      ++ count;
+   }
+   TEST(lengthof(nodes)-1 == count);
+   TEST(0 == invariant_bptree(&tree));
+
+   // unprepare
+   TEST(0 == free_bptree(&tree));
+
+   return 0;
+ONERR:
+   free_bptree(&tree);
+   return EINVAL;
+}
+
+bptree_IMPLEMENT(_testtree, testnode_t, uintptr_t, node)
+
+static int test_generic(void)
+{
+   testnode_t           nodes[1000];
+   testadapt_t          typeadapt = {
+                           typeadapt_INIT_LIFECMP(0, &impl_deletenode_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt),
+                           test_errortimer_FREE, 0
+                        };
+   typeadapt_member_t   nodeadapt = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testnode_t, uintptr_t), offsetof(testnode_t, node));
+   bptree_t             tree      = bptree_FREE;
+   testnode_t *         found;
+   size_t               count;
+
+   // prepare
+   MEMSET0(&nodes);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].key = i;
+   }
+
+   // TEST init_testtree
+   init_testtree(&tree, &nodeadapt);
+   TEST(0 == tree.root);
+   TEST(isequal_typeadaptmember(&nodeadapt, &tree.nodeadp));
+   TEST(1 == isempty_testtree(&tree));
+
+   // TEST insert_testtree, find_testtree
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_testtree(&tree, &nodes[i]));
+      TEST(0 == isempty_testtree(&tree));
+   }
+   TEST(0 == invariant_testtree(&tree));
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == find_testtree(&tree, i, &found));
+      TEST(found == &nodes[i]);
+   }
+
+   // TEST foreach, foreachReverse
+   count = 0;
+   foreach (_testtree, node, &tree) {
+      TEST(node == &nodes[count]);
+      ++ count;
+   }
+   TEST(lengthof(nodes) == count);
+   foreachReverse (_testtree, node, &tree) {
+      -- count;
+      TEST(node == &nodes[count]);
+   }
+   TEST(0 == count);
+
+   // TEST initfrom_testtreeiterator
+   bptree_iterator_t iter;
+   TEST(0 == initfrom_testtreeiterator(&iter, &tree, 500));
+   TEST(1 == next_testtreeiterator(&iter, &found));
+   TEST(found == &nodes[500]);
+   TEST(1 == next_testtreeiterator(&iter, &found));
+   TEST(found == &nodes[501]);
+
+   // TEST remove_testtree
+   for (unsigned i = 0; i < lengthof(nodes); i += 2) {
+      TEST(0 == remove_testtree(&tree, &nodes[i]));
+      TEST(ESRCH == find_testtree(&tree, i, &found));
+   }
+   TEST(0 == invariant_testtree(&tree));
+
+   // TEST removenodes_testtree
+   TEST(0 == removenodes_testtree(&tree));
+   TEST(1 == isempty_testtree(&tree));
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST((i % 2) == (unsigned) nodes[i].is_freed);
+   }
+
+   // TEST free_testtree
+   TEST(0 == free_testtree(&tree));
+   TEST(0 == tree.root);
+
+   return 0;
+ONERR:
+   free_bptree(&tree);
+   return EINVAL;
+}
+
+int unittest_ds_inmem_bptree()
+{
+   if (test_initfree())       goto ONERR;
+   if (test_insertremove())   goto ONERR;
+   if (test_iterator())       goto ONERR;
+   if (test_generic())        goto ONERR;
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+#endif
@@ -0,0 +1,1338 @@
+/* title: Concurrent-Extendible-Hashing impl
+
+   Implements <Concurrent-Extendible-Hashing>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/cexthash.h
+    Header file <Concurrent-Extendible-Hashing>.
+
+   file: C-kern/ds/inmem/cexthash.c
+    Implementation file <Concurrent-Extendible-Hashing impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/ds/typeadapt.h"
+#include "C-kern/api/ds/inmem/cexthash.h"
+#include "C-kern/api/ds/inmem/redblacktree.h"
+#include "C-kern/api/math/int/log2.h"
+#include "C-kern/api/memory/atomic.h"
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/platform/task/thread.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#endif
+
+
+// section: cexthash_t
+
+// group: description
+
+/* about: Algorithm
+ *
+ * Hashing:
+ * The hashing and the lazy splitting of shared buckets is the same as in <exthash_t>.
+ * See <Extendible-Hashing impl> for a description.
+ *
+ * Directory:
+ * The table of <exthash_t> is a single array which is reallocated if the table size doubles.
+ * A reader could access the freed memory of the old table. Therefore the directory of
+ * <cexthash_t> is split into segments which are never moved.
+ * > ----------------
+ * > | segment[0]   | --> [0 .. pow(2,initlevel)-1]
+ * > ----------------
+ * > | segment[1]   | --> [pow(2,initlevel) .. pow(2,initlevel+1)-1]
+ * > ----------------
+ * > | segment[2]   | --> [pow(2,initlevel+1) .. pow(2,initlevel+2)-1]
+ * > ----------------
+ * Table index i >= pow(2,initlevel) is located in segment log2(i)-initlevel+1 at offset i-pow(2,log2(i)).
+ * The table size is doubled by allocating the next segment, setting all its entries to (uintptr_t)-1
+ * (shared) and incrementing <cexthash_t.level> afterwards. The entries of a new segment share their
+ * buckets with the entries of the lower level. Therefore the bucket of any key does not change.
+ *
+ * Locking:
+ * The index of the bucket of a key is computed without holding any lock. Then the lock protecting
+ * the bucket is acquired and the bucket index is computed again. If it has changed the bucket has
+ * been split in the meantime and the process is repeated with the new index.
+ * Splitting a bucket is done while holding its writer lock. So after the index has been validated
+ * the bucket could not be split until its lock is released.
+ *
+ * A bucket is split into itself and a bucket with a higher index which shared its content before.
+ * The entry of the new bucket is set after all nodes are moved. Any thread which wants to access
+ * the new bucket before waits for the lock of the split bucket and detects the change afterwards.
+ *
+ * Deadlock:
+ * Every thread holds at most one bucket lock. Growing the directory is done by at most one thread
+ * (see <cexthash_t.growlock>) and does not acquire any bucket lock.
+ * */
+
+// group: helper
+
+static inline size_t lengthoftable_cexthash(uint8_t level)
+{
+   return ((size_t)1 << level);
+}
+
+/* function: lengthofsegment_cexthash
+ * Returns the number of entries contained in segment segidx. */
+static inline size_t lengthofsegment_cexthash(uint8_t initlevel, unsigned segidx)
+{
+   return lengthoftable_cexthash((uint8_t) (segidx ? initlevel + segidx - 1 : initlevel));
+}
+
+/* function: sizeofsegment_cexthash
+ * Returns the size in bytes of segment segidx rounded up to a multiple of <pagesize_vm>. */
+static inline size_t sizeofsegment_cexthash(uint8_t initlevel, unsigned segidx)
+{
+   size_t size = lengthofsegment_cexthash(initlevel, segidx) * sizeof(cexthash_node_t*);
+   return (size + pagesize_vm() - 1) & ~(pagesize_vm() - 1);
+}
+
+/* function: entry_cexthash
+ * Returns the address of the table entry with index tabidx.
+ * The segment containing the entry must be allocated. */
+static inline cexthash_node_t ** entry_cexthash(const cexthash_t * htable, size_t tabidx)
+{
+   if (tabidx < lengthoftable_cexthash(htable->initlevel)) {
+      return &htable->segment[0][tabidx];
+   }
+
+   unsigned lg = log2_int(tabidx);
+
+   return &htable->segment[lg + 1u - htable->initlevel][tabidx ^ ((size_t)1 << lg)];
+}
+
+/* function: isshared_cexthash
+ * Returns true if the entry is marked with (uintptr_t)-1. */
+static inline bool isshared_cexthash(cexthash_node_t * entry)
+{
+   return (0 == ~(uintptr_t)entry);
+}
+
+/* function: newsegment_cexthash
+ * Maps memory for segment segidx. The memory is initialized to 0. */
+static int newsegment_cexthash(uint8_t initlevel, unsigned segidx, /*out*/cexthash_node_t *** segment)
+{
+   int err;
+   vmpage_t page;
+
+   err = init_vmpage(&page, sizeofsegment_cexthash(initlevel, segidx));
+   if (err) goto ONERR;
+
+   *segment = (cexthash_node_t**) page.addr;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: deletesegment_cexthash
+ * Unmaps memory of segment segidx. */
+static int deletesegment_cexthash(uint8_t initlevel, unsigned segidx, cexthash_node_t *** segment)
+{
+   int err;
+
+   if (*segment) {
+      vmpage_t page = vmpage_INIT(sizeofsegment_cexthash(initlevel, segidx), (uint8_t*)*segment);
+
+      err = free_vmpage(&page);
+      *segment = 0;
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: synchronization
+
+static inline void lockreader_cexthash(int * lock)
+{
+   int readers = 0;
+   for (;;) {
+      int old = cmpxchg_atomicint(lock, readers, readers+1);
+      if (old == readers) break;
+      if (old < 0) {
+         // writer holds lock
+         yield_thread();
+         readers = 0;
+      } else {
+         readers = old;
+      }
+   }
+}
+
+static inline void unlockreader_cexthash(int * lock)
+{
+   sub_atomicint(lock, 1);
+}
+
+static inline void lockwriter_cexthash(int * lock)
+{
+   while (0 != cmpxchg_atomicint(lock, 0, INT_MIN)) {
+      yield_thread();
+   }
+}
+
+static inline void unlockwriter_cexthash(int * lock)
+{
+   clear_atomicint(lock);
+}
+
+static inline int * lockof_cexthash(cexthash_t * htable, size_t tabidx)
+{
+   return &htable->lock[tabidx % cexthash_NRLOCK];
+}
+
+// group: lifetime
+
+int init_cexthash(/*out*/cexthash_t * htable, size_t initial_size, size_t max_size, const typeadapt_member_t * nodeadp)
+{
+   int err;
+   uint8_t     level;
+   uint8_t     maxlevel;
+   cexthash_node_t ** segment;
+
+   VALIDATE_INPARAM_TEST(initial_size <= max_size && max_size < ((size_t)-1)/sizeof(void*), ONERR, );
+
+   static_assert(sizeof(size_t) <= 8, "uint8_t supports 128 bits");
+   level    = (uint8_t) (initial_size ? log2_int(initial_size) : 0);
+   maxlevel = (uint8_t) (max_size ? log2_int(max_size) : 0);
+
+   err = newsegment_cexthash(level, 0, &segment);  // no sharing of entries
+   if (err) goto ONERR;
+
+   *htable = (cexthash_t) cexthash_FREE;
+   htable->segment[0] = segment;
+   htable->nodeadp    = *nodeadp;
+   htable->level      = level;
+   htable->initlevel  = level;
+   htable->maxlevel   = maxlevel;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_cexthash(cexthash_t * htable)
+{
+   int err = 0;
+
+   if (htable->segment[0]) {
+
+      err = removenodes_cexthash(htable);
+
+      for (unsigned segidx = 0; segidx < lengthof(htable->segment); ++segidx) {
+         int err2 = deletesegment_cexthash(htable->initlevel, segidx, &htable->segment[segidx]);
+         if (err2) err = err2;
+      }
+
+      htable->nodeadp   = (typeadapt_member_t) typeadapt_member_FREE;
+      htable->level     = 0;
+      htable->initlevel = 0;
+      htable->maxlevel  = 0;
+
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: search
+
+static inline size_t hashobject_cexthash(cexthash_t * htable, const cexthash_node_t * node)
+{
+   size_t hashvalue;
+
+   hashvalue = callhashobject_typeadaptmember(&htable->nodeadp, cast2object_typeadaptmember(&htable->nodeadp, node));
+
+   return hashvalue;
+}
+
+static inline size_t hashkey_cexthash(cexthash_t * htable, const void * key)
+{
+   size_t hashvalue;
+
+   hashvalue = callhashkey_typeadaptmember(&htable->nodeadp, key);
+
+   return hashvalue;
+}
+
+/* function: unsharedtableindex_cexthash
+ * Returns index of the unshared bucket hashvalue belongs to.
+ * Parameter sharedidx is set to the last shared table entry visited before the unshared one.
+ * It is set to 0 if the table entry of hashvalue is not shared. */
+static inline size_t unsharedtableindex_cexthash(cexthash_t * htable, size_t hashvalue, /*out*/size_t * sharedidx)
+{
+   uint8_t level  = read_atomicint(&htable->level);
+   size_t  tabidx = hashvalue & (lengthoftable_cexthash(level) - 1);
+   size_t  shridx = 0;
+
+   while (isshared_cexthash(read_atomicint(entry_cexthash(htable, tabidx)))) {
+      // see unsharedtableindex_exthash
+      shridx  = tabidx;
+      tabidx ^= ((size_t)1 << log2_int(tabidx));
+   }
+
+   *sharedidx = shridx;
+
+   return tabidx;
+}
+
+/* function: lockbucket_cexthash
+ * Locks the bucket hashvalue belongs to and returns its index.
+ * If iswriter is true a writer lock is acquired else a reader lock.
+ * Parameter sharedidx is set as in <unsharedtableindex_cexthash>. */
+static inline size_t lockbucket_cexthash(cexthash_t * htable, size_t hashvalue, bool iswriter, /*out*/size_t * sharedidx)
+{
+   size_t tabidx = unsharedtableindex_cexthash(htable, hashvalue, sharedidx);
+
+   for (;;) {
+      int * lock = lockof_cexthash(htable, tabidx);
+      if (iswriter) {
+         lockwriter_cexthash(lock);
+      } else {
+         lockreader_cexthash(lock);
+      }
+
+      size_t tabidx2 = unsharedtableindex_cexthash(htable, hashvalue, sharedidx);
+      if (tabidx2 == tabidx) break;
+
+      // bucket was split before lock was acquired
+      if (iswriter) {
+         unlockwriter_cexthash(lock);
+      } else {
+         unlockreader_cexthash(lock);
+      }
+      tabidx = tabidx2;
+   }
+
+   return tabidx;
+}
+
+static inline void unlockbucket_cexthash(cexthash_t * htable, size_t tabidx, bool iswriter)
+{
+   int * lock = lockof_cexthash(htable, tabidx);
+   if (iswriter) {
+      unlockwriter_cexthash(lock);
+   } else {
+      unlockreader_cexthash(lock);
+   }
+}
+
+int find_cexthash(cexthash_t * htable, const void * key, /*out*/cexthash_node_t ** found_node)
+{
+   int err;
+   size_t tabidx;
+   size_t sharedidx;
+
+   tabidx = lockbucket_cexthash(htable, hashkey_cexthash(htable, key), false, &sharedidx);
+
+   redblacktree_t tree = redblacktree_INIT(*entry_cexthash(htable, tabidx), htable->nodeadp);
+   err = find_redblacktree(&tree, key, found_node);
+
+   unlockbucket_cexthash(htable, tabidx, false);
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   if (err != ESRCH) {
+      TRACEEXIT_ERRLOG(err);
+   }
+   return err;
+}
+
+// group: change
+
+/* function: growtable_cexthash
+ * Doubles the size of the table by adding a new segment.
+ * If another thread grows the table nothing is done.
+ * If <cexthash_t.level> equals <cexthash_t.maxlevel> nothing is done. */
+static int growtable_cexthash(cexthash_t * htable)
+{
+   int err;
+
+   if (0 != set_atomicflag(&htable->growlock)) {
+      // another thread grows the table
+      return 0;
+   }
+
+   // only the thread holding growlock changes level
+   uint8_t level = htable->level;
+
+   if (level < htable->maxlevel) {
+      unsigned          segidx = level + 1u - htable->initlevel;
+      cexthash_node_t ** segment;
+
+      err = newsegment_cexthash(htable->initlevel, segidx, &segment);
+      if (err) goto ONERR;
+
+      // set new table entries to special value (uintptr_t)-1 which indicates that
+      // these entries share the same root node with corresponding table entries at level-1
+      memset(segment, 0xFF, lengthofsegment_cexthash(htable->initlevel, segidx) * sizeof(cexthash_node_t*));
+
+      htable->segment[segidx] = segment;
+      // publish segment before new level
+      write_atomicint(&htable->level, (uint8_t)(level+1));
+   }
+
+   clear_atomicflag(&htable->growlock);
+
+   return 0;
+ONERR:
+   clear_atomicflag(&htable->growlock);
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: unsharebucket_cexthash
+ * Makes a shared bucket unshared.
+ * Same as <unsharebucket_exthash> except that the caller must hold the writer lock of bucket tabidx.
+ * The table entry of the newly unshared bucket is set after all nodes are moved into it. */
+static int unsharebucket_cexthash(cexthash_t * htable, size_t tabidx)
+{
+   int err;
+   size_t highbit  = tabidx ? ((size_t)2 << (log2_int(tabidx))) : 1;
+   size_t splitidx;
+
+   do {
+      // see unsharebucket_exthash
+      splitidx  = tabidx | highbit;
+      highbit <<= 1;
+   } while (! isshared_cexthash(*entry_cexthash(htable, splitidx)));
+   highbit >>= 1;
+
+   // distribute keys to the two buckets !!
+   redblacktree_t tree  = redblacktree_INIT(*entry_cexthash(htable, tabidx), htable->nodeadp);
+   redblacktree_t tree2 = redblacktree_INIT(0/*empty tree*/, htable->nodeadp);
+   err = 0;
+   foreach (_redblacktree, node, &tree) {
+      size_t hashvalue = hashobject_cexthash(htable, node);
+
+      if ((hashvalue & highbit)) {
+         int err2;
+         err2 = remove_redblacktree(&tree, node);
+         if (!err2) err2 = insert_redblacktree(&tree2, node);
+         if (err2) err = err2;
+      }
+   }
+
+   // make splitidx entry unshared
+   write_atomicint(entry_cexthash(htable, tabidx), tree.root);
+   write_atomicint(entry_cexthash(htable, splitidx), tree2.root);
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int insert_cexthash(cexthash_t * htable, cexthash_node_t * new_node)
+{
+   int err;
+   size_t tabidx;
+   size_t sharedidx;
+   bool   issplit = false;
+   const size_t hashvalue = hashobject_cexthash(htable, new_node);
+
+   for (;;) {
+      tabidx = lockbucket_cexthash(htable, hashvalue, true, &sharedidx);
+
+      if (sharedidx == 0 || issplit) break;
+
+      // split shared bucket only once (see insert_exthash)
+      // the new bucket is protected by another lock therefore compute tabidx again
+      err = unsharebucket_cexthash(htable, tabidx);
+      unlockbucket_cexthash(htable, tabidx, true);
+      if (err) goto ONERR;
+      issplit = true;
+   }
+
+   cexthash_node_t ** entry = entry_cexthash(htable, tabidx);
+   redblacktree_t     tree  = redblacktree_INIT(*entry, htable->nodeadp);
+
+   err = 0;
+   if (sharedidx == 0 && tree.root && tree.root->left && tree.root->right/*>= 3 elements*/) {
+      err = growtable_cexthash(htable);
+   }
+
+   if (!err) {
+      err = insert_redblacktree(&tree, new_node);
+      if (!err) write_atomicint(entry, tree.root);
+   }
+
+   unlockbucket_cexthash(htable, tabidx, true);
+
+   if (err) goto ONERR;
+
+   add_atomicint(&htable->nr_nodes, 1);
+
+   return 0;
+ONERR:
+   if (err != EEXIST) {
+      TRACEEXIT_ERRLOG(err);
+   }
+   return err;
+}
+
+int remove_cexthash(cexthash_t * htable, cexthash_node_t * node)
+{
+   int err;
+   size_t tabidx;
+   size_t sharedidx;
+
+   tabidx = lockbucket_cexthash(htable, hashobject_cexthash(htable, node), true, &sharedidx);
+
+   cexthash_node_t ** entry = entry_cexthash(htable, tabidx);
+   redblacktree_t     tree  = redblacktree_INIT(*entry, htable->nodeadp);
+
+   err = remove_redblacktree(&tree, node);
+   if (!err) write_atomicint(entry, tree.root);
+
+   unlockbucket_cexthash(htable, tabidx, true);
+
+   if (err) goto ONERR;
+
+   sub_atomicint(&htable->nr_nodes, 1);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int removenodes_cexthash(cexthash_t * htable)
+{
+   int err = 0;
+
+   size_t endindex = lengthoftable_cexthash(htable->level);
+
+   for (size_t i = 0; i < endindex; ++i) {
+      cexthash_node_t ** entry = entry_cexthash(htable, i);
+      if (*entry) {
+         if (! isshared_cexthash(*entry)) {
+            redblacktree_t tree = redblacktree_INIT(*entry, htable->nodeadp);
+            int err2 = free_redblacktree(&tree);
+            if (err2) err = err2;
+         }
+         *entry = 0;
+      }
+   }
+
+   htable->nr_nodes = 0;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: test
+
+int invariant_cexthash(const cexthash_t * htable)
+{
+   int err = 0;
+
+   size_t         endindex = lengthoftable_cexthash(htable->level);
+   redblacktree_t tree = redblacktree_INIT(0, htable->nodeadp);
+
+   for (size_t i = 0; i < endindex; ++i) {
+      cexthash_node_t * root = *entry_cexthash(htable, i);
+      if (root && ! isshared_cexthash(root)) {
+         tree.root = root;
+         err = invariant_redblacktree(&tree);
+         if (err) goto ONERR;
+      }
+   }
+
+   for (size_t i = 0; i < cexthash_NRLOCK; ++i) {
+      if (htable->lock[i]) {
+         err = EINVAL;
+         goto ONERR;
+      }
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
+
+// section: cexthash_iterator_t
+
+// group: lifetime
+
+int initfirst_cexthashiterator(/*out*/cexthash_iterator_t * iter, cexthash_t * htable)
+{
+   size_t endindex = lengthoftable_cexthash(htable->level);
+
+   static_assert( sizeof(void*) == sizeof(redblacktree_iterator_t)
+                  && sizeof(void*) == sizeof(iter->next)
+                  && 0 == offsetof(redblacktree_iterator_t, next)
+                  && 0 == offsetof(cexthash_iterator_t, next)
+                  , "(redblacktree_iterator_t*)iter works");
+
+   for (size_t i = 0; i < endindex; ++i) {
+      cexthash_node_t * root = *entry_cexthash(htable, i);
+      if (root && ! isshared_cexthash(root)) {
+         redblacktree_t tree = redblacktree_INIT(root, htable->nodeadp);
+         int err = initfirst_redblacktreeiterator((redblacktree_iterator_t*)iter, &tree);
+         if (err) return err;
+
+         iter->htable     = htable;
+         iter->tableindex = i;
+         break;
+      }
+   }
+
+   return 0;
+}
+
+// group: iterate
+
+bool next_cexthashiterator(cexthash_iterator_t * iter, /*out*/cexthash_node_t ** node)
+{
+   if (!next_redblacktreeiterator((redblacktree_iterator_t*)iter, node)) {
+      return false;
+   }
+
+   if (!iter->next) {
+      size_t endindex = lengthoftable_cexthash(iter->htable->level);
+
+      for (size_t i = iter->tableindex+1; i < endindex; ++i) {
+         cexthash_node_t * root = *entry_cexthash(iter->htable, i);
+         if (root && ! isshared_cexthash(root)) {
+            redblacktree_t tree = redblacktree_INIT(root, iter->htable->nodeadp);
+            (void) initfirst_redblacktreeiterator((redblacktree_iterator_t*)iter, &tree);
+            iter->tableindex = i;
+            break;
+         }
+      }
+   }
+
+   return true;
+}
+
+
+// section: cexthash_t
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+typedef struct testobject_t testobject_t;
+
+typeadapt_DECLARE(testadapt_t, testobject_t, uintptr_t);
+
+struct testobject_t {
+   size_t          deletecount;
+   size_t          key;
+   cexthash_node_t node;
+};
+
+static int impl_cmpkeyobj_testadapt(testadapt_t * typeadp, const uintptr_t lkey, const struct testobject_t * robject)
+{
+   assert(typeadp);
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+static int impl_cmpobj_testadapt(testadapt_t * typeadp, const struct testobject_t * lobject, const struct testobject_t * robject)
+{
+   assert(typeadp);
+   return lobject->key == robject->key ? 0 : lobject->key < robject->key ? -1 : +1;
+}
+
+static size_t impl_hashobj_testadapt(testadapt_t * typeadp, const struct testobject_t * object)
+{
+   assert(typeadp);
+   return object->key;
+}
+
+static size_t impl_hashkey_testadapt(testadapt_t * typeadp, const uintptr_t key)
+{
+   assert(typeadp);
+   return (size_t) key;
+}
+
+static int impl_delete_testadapt(testadapt_t * typeadp, struct testobject_t ** object)
+{
+   int err = 0;
+   assert(*object && typeadp);
+   if ((*object)->deletecount == (size_t)-1) {
+      err = EINVAL;
+   } else {
+      ++ (*object)->deletecount;
+   }
+   (*object) = 0;
+   return err;
+}
+
+static int test_initfree(void)
+{
+   cexthash_t           htable    = cexthash_FREE;
+   typeadapt_member_t   emptyadp  = typeadapt_member_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   cexthash_node_t      node      = cexthash_node_INIT;
+   cexthash_iterator_t  iter      = cexthash_iterator_FREE;
+   testobject_t         nodes[256];
+
+   // prepare
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].deletecount = 0;
+      nodes[i].key  = i;
+      nodes[i].node = (cexthash_node_t) cexthash_node_INIT;
+   }
+
+   // TEST cexthash_iterator_FREE
+   TEST(0 == iter.next);
+   TEST(0 == iter.htable);
+   TEST(0 == iter.tableindex);
+
+   // TEST cexthash_node_INIT
+   TEST(0 == node.parent);
+   TEST(0 == node.left);
+   TEST(0 == node.right);
+
+   // TEST cexthash_FREE
+   for (unsigned i = 0; i < lengthof(htable.segment); ++i) {
+      TEST(0 == htable.segment[i]);
+   }
+   for (unsigned i = 0; i < lengthof(htable.lock); ++i) {
+      TEST(0 == htable.lock[i]);
+   }
+   TEST(0 == htable.nr_nodes);
+   TEST(1 == isequal_typeadaptmember(&htable.nodeadp, &emptyadp));
+   TEST(0 == htable.level);
+   TEST(0 == htable.initlevel);
+   TEST(0 == htable.maxlevel);
+   TEST(0 == htable.growlock);
+
+   // TEST init_cexthash, free_cexthash
+   for (unsigned i = 0, level=0; i < 1024; level+=(i!=0), i*=2, i+=(i==0)) {
+      TEST(0 == init_cexthash(&htable, i, 4*(i+(i==0)), &nodeadp));
+      TEST(0 != htable.segment[0]);
+      for (unsigned si = 1; si < lengthof(htable.segment); ++si) {
+         TEST(0 == htable.segment[si]);
+      }
+      TEST(0 == htable.nr_nodes);
+      TEST(1 == isequal_typeadaptmember(&htable.nodeadp, &nodeadp));
+      TEST(level   == htable.level);
+      TEST(level   == htable.initlevel);
+      TEST(level+2 == htable.maxlevel);
+      for (size_t ti = 0; ti < lengthoftable_cexthash((uint8_t)level); ++ti) {
+         TEST(0 == htable.segment[0][ti]);
+      }
+      TEST(0 == free_cexthash(&htable));
+      TEST(0 == htable.segment[0]);
+      TEST(0 == htable.nr_nodes);
+      TEST(1 == isequal_typeadaptmember(&htable.nodeadp, &emptyadp));
+      TEST(0 == htable.level);
+      TEST(0 == htable.initlevel);
+      TEST(0 == htable.maxlevel);
+      TEST(0 == free_cexthash(&htable));
+      TEST(0 == htable.segment[0]);
+   }
+
+   // TEST init_cexthash: initial_size == 0 && max_size == 0
+   TEST(0 == init_cexthash(&htable, 0, 0, &nodeadp));
+   TEST(0 != htable.segment[0]);
+   TEST(0 == htable.level);
+   TEST(0 == htable.initlevel);
+   TEST(0 == htable.maxlevel);
+   TEST(0 == free_cexthash(&htable));
+
+   // TEST free_cexthash: free all nodes in tree and all segments
+   TEST(0 == init_cexthash(&htable, 1, 4, &nodeadp));
+   TEST(0 == growtable_cexthash(&htable));
+   TEST(0 == growtable_cexthash(&htable));
+   TEST(0 != htable.segment[1]);
+   TEST(0 != htable.segment[2]);
+   htable.segment[0][0] = 0;
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      redblacktree_t tree = redblacktree_INIT(htable.segment[0][0], nodeadp);
+      TEST(0 == insert_redblacktree(&tree, &nodes[i].node));
+      getinistate_redblacktree(&tree, &htable.segment[0][0], 0);
+   }
+   htable.nr_nodes = lengthof(nodes);
+   TEST(0 == free_cexthash(&htable));
+   TEST(0 == htable.segment[0]);
+   TEST(0 == htable.segment[1]);
+   TEST(0 == htable.segment[2]);
+   TEST(0 == htable.nr_nodes);
+   TEST(1 == isequal_typeadaptmember(&htable.nodeadp, &emptyadp));
+   TEST(0 == htable.level);
+   TEST(0 == htable.maxlevel);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(1 == nodes[i].deletecount);
+      nodes[i].deletecount = 0;
+   }
+
+   // TEST init_cexthash: EINVAL
+   TEST(EINVAL == init_cexthash(&htable, 2, 1, &nodeadp));
+   TEST(EINVAL == init_cexthash(&htable, 1, 1u+((size_t)-1)/sizeof(void*), &nodeadp));
+   TEST(0 == htable.segment[0]);
+   TEST(0 == htable.nr_nodes);
+   TEST(0 == htable.level);
+   TEST(0 == htable.maxlevel);
+
+   // TEST nrelements_cexthash, isempty_cexthash
+   for (unsigned i = 0; i < 256; ++i) {
+      htable.nr_nodes = i;
+      TEST(i == nrelements_cexthash(&htable));
+      TEST((i == 0) == isempty_cexthash(&htable));
+   }
+
+   return 0;
+ONERR:
+   free_cexthash(&htable);
+   return EINVAL;
+}
+
+static int test_privquery(void)
+{
+   cexthash_t           htable    = cexthash_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   testobject_t         node      = { 0, 0, cexthash_node_INIT };
+   size_t               sharedidx;
+
+   // TEST lengthofsegment_cexthash
+   for (uint8_t initlevel = 0; initlevel < 16; ++initlevel) {
+      TEST(lengthoftable_cexthash(initlevel) == lengthofsegment_cexthash(initlevel, 0));
+      for (unsigned segidx = 1; segidx < 16; ++segidx) {
+         TEST(lengthoftable_cexthash((uint8_t)(initlevel+segidx-1)) == lengthofsegment_cexthash(initlevel, segidx));
+      }
+   }
+
+   // TEST sizeofsegment_cexthash
+   TEST(pagesize_vm() == sizeofsegment_cexthash(0, 0));
+   TEST(pagesize_vm() == sizeofsegment_cexthash(0, 1));
+   TEST(65536*sizeof(void*) == sizeofsegment_cexthash(16, 0));
+   TEST(65536*sizeof(void*) == sizeofsegment_cexthash(16, 1));
+   TEST(65536*sizeof(void*) == sizeofsegment_cexthash(15, 2));
+
+   // TEST entry_cexthash
+   for (uint8_t initlevel = 0; initlevel <= 4; ++initlevel) {
+      TEST(0 == init_cexthash(&htable, lengthoftable_cexthash(initlevel), 65536, &nodeadp));
+      while (htable.level < 16) {
+         TEST(0 == growtable_cexthash(&htable));
+      }
+      for (size_t i = 0; i < lengthoftable_cexthash(initlevel); ++i) {
+         TEST(entry_cexthash(&htable, i) == &htable.segment[0][i]);
+      }
+      for (unsigned segidx = 1; segidx <= 16u-initlevel; ++segidx) {
+         size_t first = lengthoftable_cexthash((uint8_t)(initlevel+segidx-1));
+         for (size_t i = 0; i < lengthofsegment_cexthash(initlevel, segidx); ++i) {
+            TEST(entry_cexthash(&htable, first+i) == &htable.segment[segidx][i]);
+         }
+      }
+      TEST(0 == free_cexthash(&htable));
+   }
+
+   // TEST hashobject_cexthash, hashkey_cexthash
+   TEST(0 == init_cexthash(&htable, 65536, 65536, &nodeadp));
+   for (unsigned i = 0; i < 65535; ++i) {
+      node.key = i;
+      TEST(node.key == hashobject_cexthash(&htable, &node.node));
+      TEST(node.key == hashkey_cexthash(&htable, (void*)node.key));
+      node.key = ((size_t)-1) - i;
+      TEST(node.key == hashobject_cexthash(&htable, &node.node));
+      TEST(node.key == hashkey_cexthash(&htable, (void*)node.key));
+   }
+
+   // TEST unsharedtableindex_cexthash: index 0 is where it all ends + unshared buckets grow
+   memset(htable.segment[0], 255, lengthoftable_cexthash(htable.level) * sizeof(void*));
+   for (unsigned unshared = 1; unshared <= 256; unshared *= 2) {
+      memset(htable.segment[0], 0, unshared * sizeof(void*));
+      for (unsigned i = 0; i < 65536; ++i) {
+         sharedidx = 65536;
+         TEST((i & (unshared-1)) == unsharedtableindex_cexthash(&htable, i, &sharedidx));
+         size_t expect = 0;
+         if (i >= unshared) {
+            expect = unshared;
+            while (!(i & expect)) {
+               expect <<= 1;
+            }
+            expect |= (i & (unshared-1));
+         }
+         TEST(expect == sharedidx);
+      }
+   }
+
+   // TEST lockbucket_cexthash, unlockbucket_cexthash
+   for (unsigned i = 0; i < 256; ++i) {
+      TEST(i == lockbucket_cexthash(&htable, i, false, &sharedidx));
+      TEST(1 == htable.lock[i % cexthash_NRLOCK]);
+      TEST(i == lockbucket_cexthash(&htable, i, false, &sharedidx));
+      TEST(2 == htable.lock[i % cexthash_NRLOCK]);
+      unlockbucket_cexthash(&htable, i, false);
+      unlockbucket_cexthash(&htable, i, false);
+      TEST(0 == htable.lock[i % cexthash_NRLOCK]);
+      TEST(i == lockbucket_cexthash(&htable, i, true, &sharedidx));
+      TEST(0 >  htable.lock[i % cexthash_NRLOCK]);
+      unlockbucket_cexthash(&htable, i, true);
+      TEST(0 == htable.lock[i % cexthash_NRLOCK]);
+   }
+   memset(htable.segment[0], 0, lengthoftable_cexthash(htable.level) * sizeof(void*));
+
+   // unprepare
+   TEST(0 == free_cexthash(&htable));
+
+   return 0;
+ONERR:
+   free_cexthash(&htable);
+   return EINVAL;
+}
+
+static int test_privchange(void)
+{
+   cexthash_t           htable     = cexthash_FREE;
+   testadapt_t          typeadapt  = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp    = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   testobject_t         nodes[256] = { { 0, 0, cexthash_node_INIT } };
+
+   // prepare
+   TEST(0 == init_cexthash(&htable, 1, 65536, &nodeadp));
+
+   // TEST growtable_cexthash
+   for (uint8_t level = 0; level < 16; ++level) {
+      TEST(level == htable.level);
+      for (size_t ti = 0; ti < lengthoftable_cexthash(level); ++ti) {
+         *entry_cexthash(&htable, ti) = (cexthash_node_t*) ti;
+      }
+      TEST(0 == growtable_cexthash(&htable));
+      TEST(level+1 == htable.level);
+      TEST(0       == htable.initlevel);
+      TEST(16      == htable.maxlevel);
+      TEST(0       == htable.growlock);
+      for (size_t ti = 0; ti < lengthoftable_cexthash(level); ++ti) {
+         TEST(*entry_cexthash(&htable, ti) == (cexthash_node_t*)ti);
+      }
+      for (size_t ti = lengthoftable_cexthash(level); ti < lengthoftable_cexthash((uint8_t)(level+1)); ++ti) {
+         TEST(*entry_cexthash(&htable, ti) == (cexthash_node_t*)(uintptr_t)-1);
+      }
+   }
+
+   // TEST growtable_cexthash: maxlevel reached
+   TEST(0 == growtable_cexthash(&htable));
+   TEST(16 == htable.level);
+   TEST(0  == htable.segment[17]);
+
+   // TEST growtable_cexthash: another thread grows the table
+   htable.maxlevel = 17;
+   htable.growlock = 1;
+   TEST(0 == growtable_cexthash(&htable));
+   TEST(16 == htable.level);
+   TEST(0  == htable.segment[17]);
+   TEST(1  == htable.growlock);
+   htable.growlock = 0;
+   htable.maxlevel = 16;
+
+   // TEST unsharebucket_cexthash: finds shared bucket with higher index
+   for (size_t ti = 0; ti < lengthoftable_cexthash(htable.level); ++ti) {
+      *entry_cexthash(&htable, ti) = (cexthash_node_t*)(uintptr_t)-1;
+   }
+   *entry_cexthash(&htable, 0) = 0; // this value is always unshared
+   for (unsigned level = 0; level < 15; ++level) {
+      for (unsigned i = 0; i < (1u << level); ++i) {
+         size_t nexti = i | (1u << level);
+         TEST(nexti < 65536);
+         TEST(isshared_cexthash(*entry_cexthash(&htable, nexti)));
+         TEST(0 == unsharebucket_cexthash(&htable, i));
+         TEST(0 == *entry_cexthash(&htable, i));
+         TEST(0 == *entry_cexthash(&htable, nexti));
+      }
+   }
+
+   // TEST unsharebucket_cexthash: distributes all nodes between bucket [0] and shared bucket [1]
+   redblacktree_t tree = redblacktree_INIT(0, nodeadp);
+   for (unsigned i = 0; i < 256; ++i) {
+      nodes[i].key = (i << 8) | (i&1);
+      TEST(0 == insert_redblacktree(&tree, &nodes[i].node));
+   }
+   *entry_cexthash(&htable, 0) = tree.root;
+   *entry_cexthash(&htable, 1) = (void*) (uintptr_t)-1;
+   TEST(0 == unsharebucket_cexthash(&htable, 0));
+   tree.root = *entry_cexthash(&htable, 0);
+   unsigned count = 0;
+   foreach (_redblacktree, node, &tree) {
+      TEST((count << 8) == ((testobject_t*)cast2object_typeadaptmember(&nodeadp, node))->key);
+      count += 2;
+   }
+   TEST(count == 256);
+   tree.root = *entry_cexthash(&htable, 1);
+   count = 1;
+   foreach (_redblacktree, node, &tree) {
+      TEST(((count << 8)+1) == ((testobject_t*)cast2object_typeadaptmember(&nodeadp, node))->key);
+      count += 2;
+   }
+   TEST(count == 257);
+   *entry_cexthash(&htable, 0) = 0;
+   *entry_cexthash(&htable, 1) = 0;
+
+   // unprepare
+   TEST(0 == free_cexthash(&htable));
+
+   return 0;
+ONERR:
+   free_cexthash(&htable);
+   return EINVAL;
+}
+
+static int test_findinsertremove(void)
+{
+   cexthash_t           htable    = cexthash_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   const size_t         MAXNODES  = 65536;
+   memblock_t           mem       = memblock_FREE;
+   testobject_t       * nodes;
+   cexthash_node_t    * found_node;
+
+   // prepare
+   TEST(0 == RESIZE_MM(MAXNODES * sizeof(testobject_t), &mem));
+   nodes = (testobject_t*) mem.addr;
+   clear_memblock(&mem);
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      nodes[i].key = i;
+   }
+
+   // TEST insert_cexthash
+   TEST(0 == init_cexthash(&htable, MAXNODES, MAXNODES, &nodeadp));
+   TEST(0 == invariant_cexthash(&htable));
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0      == insert_cexthash(&htable, &nodes[i].node));
+      TEST(EEXIST == insert_cexthash(&htable, &nodes[i].node));
+      TEST(i+1 == nrelements_cexthash(&htable));
+   }
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0 == find_cexthash(&htable, (const void*)(uintptr_t)i, &found_node));
+      TEST(found_node == &nodes[i].node);
+   }
+   TEST(0 == invariant_cexthash(&htable));
+
+   // TEST remove_cexthash
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0     == remove_cexthash(&htable, &nodes[i].node));
+      TEST(0     == nodes[i].deletecount);
+      TEST(MAXNODES-1-i == nrelements_cexthash(&htable));
+   }
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(ESRCH == find_cexthash(&htable, (const void*)(uintptr_t)i, &found_node));
+   }
+   TEST(0 == invariant_cexthash(&htable));
+   TEST(0 == free_cexthash(&htable));
+
+   // TEST insert_cexthash: table grows until max level
+   TEST(0 == init_cexthash(&htable, 1, MAXNODES/8, &nodeadp));
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0      == insert_cexthash(&htable, &nodes[i].node));
+      TEST(EEXIST == insert_cexthash(&htable, &nodes[i].node));
+      TEST(i+1 == nrelements_cexthash(&htable));
+   }
+   TEST(MAXNODES/8 == lengthoftable_cexthash(htable.level));
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0 == find_cexthash(&htable, (const void*)(uintptr_t)i, &found_node));
+      TEST(found_node == &nodes[i].node);
+   }
+   TEST(0 == invariant_cexthash(&htable));
+
+   // TEST removenodes_cexthash
+   TEST(0 == removenodes_cexthash(&htable));
+   TEST(0 == nrelements_cexthash(&htable));
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(ESRCH == find_cexthash(&htable, (const void*)(uintptr_t)i, &found_node));
+      TEST(1 == nodes[i].deletecount);
+      nodes[i].deletecount = 0;
+   }
+
+   // TEST removenodes_cexthash: ERROR
+   for (size_t i = 0; i < 256; ++i) {
+      TEST(0 == insert_cexthash(&htable, &nodes[i].node));
+   }
+   nodes[0].deletecount = (size_t)-1;
+   TEST(EINVAL == removenodes_cexthash(&htable));
+   TEST(0 == nrelements_cexthash(&htable));
+   nodes[0].deletecount = 0;
+   for (size_t i = 1; i < 256; ++i) {
+      TEST(1 == nodes[i].deletecount);
+      nodes[i].deletecount = 0;
+   }
+   TEST(0 == free_cexthash(&htable));
+
+   // TEST insert_cexthash, remove_cexthash: random
+   TEST(0 == init_cexthash(&htable, 1, 1024, &nodeadp));
+   srand(123);
+   for (size_t i = 0; i < 64*1024; ++i) {
+      size_t id = (size_t)rand() % (16*1024);
+      if (0 == find_cexthash(&htable, (const void*)id, &found_node)) {
+         TEST(found_node == &nodes[id].node);
+         TEST(0 == remove_cexthash(&htable, found_node));
+      } else {
+         TEST(0 == insert_cexthash(&htable, &nodes[id].node));
+      }
+   }
+   TEST(0 == invariant_cexthash(&htable));
+   TEST(0 == free_cexthash(&htable));
+
+   // TEST foreach
+   TEST(0 == init_cexthash(&htable, 512, 512, &nodeadp));
+   for (size_t i = 0; i < 1024; ++i) {
+      TEST(0 == insert_cexthash(&htable, &nodes[i].node));
+   }
+   for (size_t i = 0; i == 0; i = 1) {
+      foreach (_cexthash, node, &htable) {
+         TEST(node == &nodes[i/2 + 512*(i&1)].node)
+         ++ i;
+      }
+      TEST(i == 1024);
+   }
+
+   // TEST initfirst_cexthashiterator, next_cexthashiterator
+   cexthash_iterator_t iter = cexthash_iterator_FREE;
+   cexthash_node_t * old = htable.segment[0][0];
+   htable.segment[0][0] = 0;
+   TEST(0 == initfirst_cexthashiterator(&iter, &htable));
+   TEST(iter.next   != 0);
+   TEST(iter.htable == &htable);
+   TEST(iter.tableindex == 1);
+   htable.segment[0][0] = old;
+   iter = (cexthash_iterator_t) cexthash_iterator_FREE;
+   TEST(0 == initfirst_cexthashiterator(&iter, &htable));
+   TEST(iter.tableindex == 0);
+   for (size_t i = 0; i == 0; i = 1) {
+      while (next_cexthashiterator(&iter, &found_node)) {
+         TEST(found_node == &nodes[i/2 + 512*(i&1)].node)
+         ++ i;
+      }
+      TEST(i == 1024);
+      TEST(0 == iter.next);
+      TEST(511 == iter.tableindex);
+   }
+   TEST(0 == free_cexthashiterator(&iter));
+   TEST(0 == iter.next);
+
+   // unprepare
+   TEST(0 == free_cexthash(&htable));
+   TEST(0 == FREE_MM(&mem));
+
+   return 0;
+ONERR:
+   free_cexthash(&htable);
+   FREE_MM(&mem);
+   return EINVAL;
+}
+
+typedef struct thread_param_t {
+   cexthash_t    * htable;
+   testobject_t  * nodes;
+   size_t          nrnodes;
+   size_t          nrthreads;
+   size_t          threadidx;
+} thread_param_t;
+
+static int thread_insertfindremove(thread_param_t * param)
+{
+   cexthash_node_t * found_node;
+   const size_t      first = param->threadidx * param->nrnodes;
+
+   for (size_t i = first; i < first + param->nrnodes; ++i) {
+      if (insert_cexthash(param->htable, &param->nodes[i].node)) return EINVAL;
+      // read nodes inserted by other threads
+      size_t other = (i + param->nrnodes) % (param->nrthreads * param->nrnodes);
+      if (0 == find_cexthash(param->htable, (const void*)other, &found_node)) {
+         if (found_node != &param->nodes[other].node) return EINVAL;
+      }
+   }
+
+   for (size_t i = first; i < first + param->nrnodes; ++i) {
+      if (find_cexthash(param->htable, (const void*)i, &found_node)) return EINVAL;
+      if (found_node != &param->nodes[i].node) return EINVAL;
+   }
+
+   // remove every second node
+   for (size_t i = first; i < first + param->nrnodes; i += 2) {
+      if (remove_cexthash(param->htable, &param->nodes[i].node)) return EINVAL;
+      if (ESRCH != find_cexthash(param->htable, (const void*)i, &found_node)) return EINVAL;
+   }
+
+   return 0;
+}
+
+static int test_concurrent(void)
+{
+   cexthash_t           htable    = cexthash_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   thread_t           * thread[4] = { 0 };
+   thread_param_t       param[lengthof(thread)];
+   const size_t         NRTHREAD  = lengthof(thread);
+   const size_t         NRNODES   = 16384;
+   memblock_t           mem       = memblock_FREE;
+   testobject_t       * nodes;
+   cexthash_node_t    * found_node;
+
+   // prepare
+   TEST(0 == RESIZE_MM(NRTHREAD * NRNODES * sizeof(testobject_t), &mem));
+   nodes = (testobject_t*) mem.addr;
+   clear_memblock(&mem);
+   for (size_t i = 0; i < NRTHREAD * NRNODES; ++i) {
+      nodes[i].key = i;
+   }
+
+   // TEST insert_cexthash, find_cexthash, remove_cexthash: table grows while accessed by all threads
+   TEST(0 == init_cexthash(&htable, 1, NRTHREAD * NRNODES, &nodeadp));
+   for (size_t t = 0; t < NRTHREAD; ++t) {
+      param[t] = (thread_param_t) { &htable, nodes, NRNODES, NRTHREAD, t };
+      TEST(0 == newgeneric_thread(&thread[t], &thread_insertfindremove, &param[t]));
+   }
+   for (size_t t = 0; t < NRTHREAD; ++t) {
+      TEST(0 == join_thread(thread[t]));
+      TEST(0 == returncode_thread(thread[t]));
+      TEST(0 == delete_thread(&thread[t]));
+   }
+   TEST(0 == invariant_cexthash(&htable));
+   TEST(0 <  htable.level);
+   TEST(0 == htable.growlock);
+   TEST(NRTHREAD * NRNODES / 2 == nrelements_cexthash(&htable));
+   for (size_t i = 0; i < NRTHREAD * NRNODES; ++i) {
+      int err = find_cexthash(&htable, (const void*)i, &found_node);
+      if (i % 2) {
+         TEST(0 == err);
+         TEST(found_node == &nodes[i].node);
+      } else {
+         TEST(ESRCH == err);
+      }
+   }
+
+   // unprepare
+   TEST(0 == free_cexthash(&htable));
+   for (size_t i = 0; i < NRTHREAD * NRNODES; ++i) {
+      TEST((i % 2) == nodes[i].deletecount);
+   }
+   TEST(0 == FREE_MM(&mem));
+
+   return 0;
+ONERR:
+   for (size_t t = 0; t < NRTHREAD; ++t) {
+      delete_thread(&thread[t]);
+   }
+   free_cexthash(&htable);
+   FREE_MM(&mem);
+   return EINVAL;
+}
+
+cexthash_IMPLEMENT(_testhash, testobject_t, uintptr_t, node)
+
+static int test_generic(void)
+{
+   cexthash_t           htable    = cexthash_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   testobject_t         nodes[256];
+
+   // prepare
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].deletecount = 0;
+      nodes[i].key  = i;
+      nodes[i].node = (cexthash_node_t) cexthash_node_INIT;
+   }
+
+   // TEST init_cexthash
+   TEST(0 == init_testhash(&htable, 1, lengthof(nodes), &nodeadp));
+   TEST(0 != htable.segment[0]);
+   TEST(0 == htable.level);
+   TEST(8 == htable.maxlevel);
+   TEST(0 == nrelements_testhash(&htable));
+   TEST(1 == isempty_testhash(&htable));
+
+   // TEST insert_cexthash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_testhash(&htable, &nodes[i]));
+      TEST(i+1 == nrelements_testhash(&htable));
+      TEST(0 == isempty_testhash(&htable));
+   }
+   TEST(0 == invariant_testhash(&htable));
+
+   // TEST foreach
+   for (unsigned i = 0; !i; i = 1) {
+      foreach (_testhash, node, &htable) {
+         TEST(node->key < lengthof(nodes));
+         TEST(node == &nodes[node->key]);
+         ++ i;
+      }
+      TEST(lengthof(nodes) == i);
+   }
+
+   // TEST find_cexthash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      testobject_t * found_node;
+      TEST(0 == find_testhash(&htable, i, &found_node));
+      TEST(found_node == &nodes[i]);
+   }
+
+   // TEST remove_cexthash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      testobject_t * found_node;
+      TEST(0 == isempty_testhash(&htable));
+      TEST(0 == remove_testhash(&htable, &nodes[i]));
+      TEST(ESRCH == find_testhash(&htable, i, &found_node));
+      TEST(lengthof(nodes)-1-i == nrelements_testhash(&htable));
+   }
+   TEST(1 == isempty_testhash(&htable));
+
+   // TEST removenodes_cexthash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_testhash(&htable, &nodes[i]));
+   }
+   TEST(0 == removenodes_testhash(&htable));
+   TEST(1 == isempty_testhash(&htable));
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(1 == nodes[i].deletecount);
+   }
+
+   // TEST free_cexthash
+   TEST(0 == free_testhash(&htable));
+   TEST(0 == htable.segment[0]);
+
+   return 0;
+ONERR:
+   free_cexthash(&htable);
+   return EINVAL;
+}
+
+int unittest_ds_inmem_cexthash()
+{
+   if (test_initfree())          goto ONERR;
+   if (test_privquery())         goto ONERR;
+   if (test_privchange())        goto ONERR;
+   if (test_findinsertremove())  goto ONERR;
+   if (test_concurrent())        goto ONERR;
+   if (test_generic())           goto ONERR;
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+#endif
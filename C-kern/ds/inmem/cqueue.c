@@ -0,0 +1,1399 @@
+/* title: Concurrent-Queue impl
+
+   Implements <Concurrent-Queue>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/cqueue.h
+    Header file <Concurrent-Queue>.
+
+   file: C-kern/ds/inmem/cqueue.c
+    Implementation file <Concurrent-Queue impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/ds/inmem/cqueue.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/math/int/log2.h"
+#include "C-kern/api/math/int/power2.h"
+#include "C-kern/api/memory/atomic.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/pagecache_macros.h"
+#include "C-kern/api/test/errortimer.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#include "C-kern/api/platform/task/thread.h"
+#endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/memory/mm/mm_macros.h"
+#include "C-kern/api/test/perftest.h"
+#include "C-kern/api/platform/task/thread.h"
+#endif
+
+
+// section: queue_page_t
+
+// group: static variables
+
+#ifdef KONFIG_UNITTEST
+/* variable: s_cqueue_errtimer
+ * Simulates an error in <new_cqueuepage> and <delete_cqueuepage>. */
+static test_errortimer_t   s_cqueue_errtimer = test_errortimer_FREE;
+#endif
+
+// group: constants
+
+/* define: RECORDHEADERSIZE
+ * Size in bytes of the header of a record stored in <mpscqueue_t>.
+ * It is also the alignment of every record. */
+#define RECORDHEADERSIZE 8
+
+/* define: RECORD_ENDMARK
+ * Value of <record_t.committed> which marks the end of the records on a closed page. */
+#define RECORD_ENDMARK  ((uint32_t)-1)
+
+/* define: PAGE_CLOSED
+ * Value of <queue_page_t.end_offset> of a page of <mpscqueue_t> which does not accept new records. */
+#define PAGE_CLOSED     ((uint16_t)0xFFFF)
+
+// group: types
+
+/* struct: record_t
+ * Header of a record stored in <mpscqueue_t>. */
+typedef struct record_t {
+   /* variable: committed
+    * 0 if not committed yet. Size in bytes of the record after it has been committed
+    * or <RECORD_ENDMARK> if the page is closed. */
+   uint32_t committed;
+   /* variable: size
+    * Size in bytes of the record. Set during <insert_mpscqueue>. */
+   uint32_t size;
+} record_t;
+
+// group: helper
+
+static inline void compiletime_assert(void)
+{
+   static_assert(sizeof(record_t) == RECORDHEADERSIZE, "header size matches alignment");
+   static_assert(0 == sizeof(queue_page_t) % RECORDHEADERSIZE, "first record is aligned");
+   static_assert(offsetof(spscqueue_t, last) >= cqueue_CACHELINESIZE, "consumer and producer use different cache lines");
+   static_assert(offsetof(spscqueue_t, spare) >= 2*cqueue_CACHELINESIZE, "shared fields use a separate cache line");
+   static_assert(offsetof(mpscqueue_t, last) >= cqueue_CACHELINESIZE, "consumer and producer use different cache lines");
+   static_assert(offsetof(mpscqueue_t, spare) >= 2*cqueue_CACHELINESIZE, "shared fields use a separate cache line");
+}
+
+/* function: issupported_cqueue
+ * Returns true if pagesize_in_bytes is supported. */
+static inline bool issupported_cqueue(size_t pagesize_in_bytes)
+{
+   return   256 <= pagesize_in_bytes && pagesize_in_bytes <= 16384
+            && ispowerof2_int(pagesize_in_bytes);
+}
+
+/* function: alignrecord_cqueue
+ * Returns nodesize aligned to <RECORDHEADERSIZE>. */
+static inline uint32_t alignrecord_cqueue(uint32_t nodesize)
+{
+   return (nodesize + (RECORDHEADERSIZE-1)) & ~(uint32_t)(RECORDHEADERSIZE-1);
+}
+
+// group: lifetime
+
+/* function: new_cqueuepage
+ * Returns the spare page or allocates a new page with <ALLOC_PAGECACHE>.
+ * The header of the page is initialized to an empty page with no links. */
+static int new_cqueuepage(/*out*/queue_page_t ** qpage, queue_page_t ** spare, uint8_t pagesize)
+{
+   int err;
+   queue_page_t * page = loadacquire_atomicint(spare);
+
+   if (page && page == cmpxchg_atomicint(spare, page, (queue_page_t*)0)) {
+      // reuse spare
+   } else {
+      memblock_t mblock;
+      if (! PROCESS_testerrortimer(&s_cqueue_errtimer, &err)) {
+         err = ALLOC_PAGECACHE(pagesize, &mblock);
+      }
+      if (err) goto ONERR;
+      page = (queue_page_t*) mblock.addr;
+   }
+
+   page->next  = 0;
+   page->prev  = 0;
+   page->queue = 0;
+   page->end_offset   = sizeof(queue_page_t);
+   page->start_offset = sizeof(queue_page_t);
+
+   *qpage = page;
+
+   return 0;
+ONERR:
+   return err;
+}
+
+/* function: delete_cqueuepage
+ * Frees single memory page with <RELEASE_PAGECACHE>. */
+static int delete_cqueuepage(queue_page_t * qpage, uint8_t pagesize)
+{
+   int err;
+   memblock_t mblock = memblock_INIT(pagesizeinbytes_pagecache(pagesize), (uint8_t*)qpage);
+
+   err = RELEASE_PAGECACHE(&mblock);
+   (void) PROCESS_testerrortimer(&s_cqueue_errtimer, &err);
+
+   return err;
+}
+
+/* function: release_cqueuepage
+ * Stores qpage as spare page if there is none or releases it with <delete_cqueuepage>. */
+static int release_cqueuepage(queue_page_t * qpage, queue_page_t ** spare, uint8_t pagesize)
+{
+   if (0 == cmpxchg_atomicint(spare, (queue_page_t*)0, qpage)) return 0;
+
+   return delete_cqueuepage(qpage, pagesize);
+}
+
+
+// section: spscqueue_t
+
+// group: lifetime
+
+int init_spscqueue(/*out*/spscqueue_t * queue, size_t pagesize)
+{
+   int err;
+   queue_page_t * page;
+
+   if (!issupported_cqueue(pagesize)) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   uint8_t pgsize = (uint8_t) pagesizefrombytes_pagecache(pagesize);
+   queue_page_t * spare = 0;
+
+   err = new_cqueuepage(&page, &spare, pgsize);
+   if (err) goto ONERR;
+
+   *queue = (spscqueue_t) spscqueue_FREE;
+   queue->first     = page;
+   queue->readoff   = sizeof(queue_page_t);
+   queue->readend   = sizeof(queue_page_t);
+   queue->last      = page;
+   queue->published = page;
+   queue->lastend   = sizeof(queue_page_t);
+   queue->publishedend = sizeof(queue_page_t);
+   queue->pagesize  = pgsize;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_spscqueue(spscqueue_t * queue)
+{
+   int err = 0;
+   int err2;
+
+   if (queue->last) {
+      // all pages are linked by prev from last to first
+      queue_page_t * page = queue->last;
+      for (;;) {
+         queue_page_t * prev = (queue_page_t*) page->prev;
+         bool islast = (page == queue->first);
+         err2 = delete_cqueuepage(page, queue->pagesize);
+         if (err2) err = err2;
+         if (islast) break;
+         page = prev;
+      }
+   }
+
+   if (queue->spare) {
+      err2 = delete_cqueuepage(queue->spare, queue->pagesize);
+      if (err2) err = err2;
+   }
+
+   *queue = (spscqueue_t) spscqueue_FREE;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: producer
+
+int insert_spscqueue(spscqueue_t * queue, uint16_t nodesize, /*out*/void ** nodeaddr)
+{
+   int err;
+   const uint32_t pagesize = pagesize_spscqueue(queue);
+
+   VALIDATE_INPARAM_TEST(0 < nodesize && nodesize <= maxelemsize_queue((uint16_t)pagesize), ONERR, );
+
+   uint32_t newend = (uint32_t)queue->lastend + nodesize;
+
+   if (newend > pagesize) {
+      queue_page_t * page;
+      err = new_cqueuepage(&page, &queue->spare, queue->pagesize);
+      if (err) goto ONERR;
+
+      queue_page_t * last = queue->last;
+      page->prev = (struct dlist_node_t*) last;
+      if (last == queue->published) {
+         // consumer reads end_offset of published page ==> publish in commit_spscqueue
+         queue->publishedend = queue->lastend;
+      } else {
+         // last is not reachable by consumer
+         last->end_offset = queue->lastend;
+      }
+
+      queue->last    = page;
+      queue->lastend = sizeof(queue_page_t);
+      newend = sizeof(queue_page_t) + (uint32_t)nodesize;
+   }
+
+   *nodeaddr = (uint8_t*)queue->last + queue->lastend;
+   queue->lastend = (uint16_t) newend;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+void commit_spscqueue(spscqueue_t * queue)
+{
+   queue_page_t * page = queue->last;
+
+   storerelease_atomicint(&page->end_offset, queue->lastend);
+
+   if (page != queue->published) {
+      // link new pages from last to published
+      // ==> consumer could reach a page only after all its nodes are published
+      queue_page_t * published = queue->published;
+      for (;;) {
+         queue_page_t * prev = (queue_page_t*) page->prev;
+         if (prev == published) break;
+         storerelease_atomicint(&prev->next, (struct dlist_node_t*) page);
+         page = prev;
+      }
+      storerelease_atomicint(&published->end_offset, queue->publishedend);
+      storerelease_atomicint(&published->next, (struct dlist_node_t*) page);
+      queue->published = queue->last;
+   }
+}
+
+// group: consumer
+
+int firstbatch_spscqueue(spscqueue_t * queue, /*out*/void ** nodes, /*out*/size_t * size)
+{
+   int err;
+   queue_page_t * page = queue->first;
+
+   while (queue->readoff == queue->readend) {
+      uint16_t end = loadacquire_atomicint(&page->end_offset);
+      if (queue->readoff == end) {
+         queue_page_t * next = (queue_page_t*) loadacquire_atomicint(&page->next);
+         if (!next) return ENODATA;
+         // end_offset is published before next ==> read it again
+         end = loadacquire_atomicint(&page->end_offset);
+         if (queue->readoff == end) {
+            // page is read completely
+            queue->first   = next;
+            queue->readoff = sizeof(queue_page_t);
+            queue->readend = sizeof(queue_page_t);
+            err = release_cqueuepage(page, &queue->spare, queue->pagesize);
+            if (err) goto ONERR;
+            page = next;
+            continue;
+         }
+      }
+      queue->readend = end;
+   }
+
+   *nodes = (uint8_t*)page + queue->readoff;
+   *size  = (size_t) (queue->readend - queue->readoff);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int first_spscqueue(spscqueue_t * queue, uint16_t nodesize, /*out*/void ** node)
+{
+   int err;
+   size_t size;
+
+   err = firstbatch_spscqueue(queue, node, &size);
+   if (err) return err;
+
+   if (size < nodesize) return ENODATA;
+
+   return 0;
+}
+
+int removefirst_spscqueue(spscqueue_t * queue, size_t size)
+{
+   if ((size_t) (queue->readend - queue->readoff) < size) return EOVERFLOW;
+
+   queue->readoff = (uint16_t) (queue->readoff + size);
+
+   return 0;
+}
+
+
+// section: mpscqueue_t
+
+// group: helper
+
+/* function: releaseretired_mpscqueue
+ * Releases all retired pages if no producer could access them.
+ * A page is retired if the consumer has read it completely. A producer could access
+ * a retired page only if it is <mpscqueue_t.last> or if the producer has read
+ * <mpscqueue_t.last> before the consumer has retired the page.
+ *
+ * Ordering:
+ * A producer increments <mpscqueue_t.nrproducer> before it reads <mpscqueue_t.last>.
+ * The consumer reads <mpscqueue_t.last> before <mpscqueue_t.nrproducer>.
+ * If the consumer reads 0 then every producer which starts later
+ * reads the same or a newer value of <mpscqueue_t.last>. */
+static int releaseretired_mpscqueue(mpscqueue_t * queue)
+{
+   int err = 0;
+   queue_page_t * last = loadacquire_atomicint(&queue->last);
+
+   for (queue_page_t * page = queue->retired; page; page = (queue_page_t*) page->prev) {
+      if (page == last) return 0;
+   }
+
+   if (0 != read_atomicint(&queue->nrproducer)) return 0;
+
+   queue_page_t * page = queue->retired;
+   queue->retired = 0;
+   while (page) {
+      queue_page_t * prev = (queue_page_t*) page->prev;
+      int err2 = release_cqueuepage(page, &queue->spare, queue->pagesize);
+      if (err2) err = err2;
+      page = prev;
+   }
+
+   return err;
+}
+
+/* function: newpage_mpscqueue
+ * Allocates a new page and clears all bytes after the header to 0. */
+static int newpage_mpscqueue(mpscqueue_t * queue, /*out*/queue_page_t ** qpage)
+{
+   int err;
+   queue_page_t * page;
+
+   err = new_cqueuepage(&page, &queue->spare, queue->pagesize);
+   if (err) return err;
+
+   memset(page + 1, 0, pagesize_mpscqueue(queue) - sizeof(queue_page_t));
+
+   *qpage = page;
+
+   return 0;
+}
+
+// group: lifetime
+
+int init_mpscqueue(/*out*/mpscqueue_t * queue, size_t pagesize)
+{
+   int err;
+   queue_page_t * page;
+
+   if (!issupported_cqueue(pagesize)) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   mpscqueue_t newqueue = mpscqueue_FREE;
+   newqueue.pagesize = (uint8_t) pagesizefrombytes_pagecache(pagesize);
+
+   err = newpage_mpscqueue(&newqueue, &page);
+   if (err) goto ONERR;
+
+   newqueue.first   = page;
+   newqueue.readoff = sizeof(queue_page_t);
+   newqueue.last    = page;
+
+   *queue = newqueue;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_mpscqueue(mpscqueue_t * queue)
+{
+   int err = 0;
+   int err2;
+
+   for (queue_page_t * page = queue->first; page; ) {
+      queue_page_t * next = (queue_page_t*) page->next;
+      err2 = delete_cqueuepage(page, queue->pagesize);
+      if (err2) err = err2;
+      page = next;
+   }
+
+   for (queue_page_t * page = queue->retired; page; ) {
+      queue_page_t * prev = (queue_page_t*) page->prev;
+      err2 = delete_cqueuepage(page, queue->pagesize);
+      if (err2) err = err2;
+      page = prev;
+   }
+
+   if (queue->spare) {
+      err2 = delete_cqueuepage(queue->spare, queue->pagesize);
+      if (err2) err = err2;
+   }
+
+   *queue = (mpscqueue_t) mpscqueue_FREE;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: producer
+
+int insert_mpscqueue(mpscqueue_t * queue, uint16_t nodesize, /*out*/void ** nodeaddr)
+{
+   int err;
+   const uint32_t pagesize = pagesize_mpscqueue(queue);
+
+   VALIDATE_INPARAM_TEST(0 < nodesize && nodesize <= maxnodesize_mpscqueue(queue), ONERR, );
+
+   const uint32_t recordsize = RECORDHEADERSIZE + alignrecord_cqueue(nodesize);
+
+   add_atomicint(&queue->nrproducer, 1);
+
+   for (;;) {
+      queue_page_t * page = loadacquire_atomicint(&queue->last);
+      uint16_t       off  = loadacquire_atomicint(&page->end_offset);
+
+      if ((uint32_t)off + recordsize <= pagesize) {
+         // PAGE_CLOSED + recordsize > pagesize
+         if (off != cmpxchg_atomicint(&page->end_offset, off, (uint16_t) (off + recordsize))) continue;
+
+         record_t * record = (record_t*) ((uint8_t*)page + off);
+         record->size = nodesize;
+         *nodeaddr = record + 1;
+         break;
+      }
+
+      if (  off != PAGE_CLOSED
+            && off == cmpxchg_atomicint(&page->end_offset, off, PAGE_CLOSED)
+            && (uint32_t)off + RECORDHEADERSIZE <= pagesize) {
+         // this thread closed the page ==> mark end of records
+         record_t * record = (record_t*) ((uint8_t*)page + off);
+         storerelease_atomicint(&record->committed, RECORD_ENDMARK);
+      }
+
+      queue_page_t * next = (queue_page_t*) loadacquire_atomicint(&page->next);
+      if (!next) {
+         err = newpage_mpscqueue(queue, &next);
+         if (err) {
+            sub_atomicint(&queue->nrproducer, 1);
+            goto ONERR;
+         }
+         queue_page_t * other = (queue_page_t*) cmpxchg_atomicint(&page->next, (struct dlist_node_t*)0, (struct dlist_node_t*)next);
+         if (other) {
+            // another producer was faster
+            (void) release_cqueuepage(next, &queue->spare, queue->pagesize);
+            next = other;
+         }
+      }
+
+      (void) cmpxchg_atomicint(&queue->last, page, next);
+   }
+
+   // the consumer does not release the page before the record is committed
+   sub_atomicint(&queue->nrproducer, 1);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+void commit_mpscqueue(mpscqueue_t * queue, void * nodeaddr)
+{
+   (void) queue;
+   record_t * record = (record_t*) nodeaddr - 1;
+
+   storerelease_atomicint(&record->committed, record->size);
+}
+
+// group: consumer
+
+int first_mpscqueue(mpscqueue_t * queue, /*out*/void ** node, /*out*/uint16_t * nodesize)
+{
+   int err;
+   const uint32_t pagesize = pagesize_mpscqueue(queue);
+
+   for (;;) {
+      queue_page_t * page = queue->first;
+
+      if ((uint32_t)queue->readoff + RECORDHEADERSIZE <= pagesize) {
+         record_t * record = (record_t*) ((uint8_t*)page + queue->readoff);
+         uint32_t committed = loadacquire_atomicint(&record->committed);
+         if (0 == committed) return ENODATA;
+         if (RECORD_ENDMARK != committed) {
+            *node = record + 1;
+            *nodesize = (uint16_t) committed;
+            return 0;
+         }
+      }
+
+      // page is read completely
+      queue_page_t * next = (queue_page_t*) loadacquire_atomicint(&page->next);
+      if (!next) return ENODATA;
+
+      queue->first   = next;
+      queue->readoff = sizeof(queue_page_t);
+      page->prev     = (struct dlist_node_t*) queue->retired;
+      queue->retired = page;
+
+      err = releaseretired_mpscqueue(queue);
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int removefirst_mpscqueue(mpscqueue_t * queue)
+{
+   const uint32_t pagesize = pagesize_mpscqueue(queue);
+
+   if ((uint32_t)queue->readoff + RECORDHEADERSIZE > pagesize) return ENODATA;
+
+   record_t * record = (record_t*) ((uint8_t*)queue->first + queue->readoff);
+   uint32_t committed = loadacquire_atomicint(&record->committed);
+   if (0 == committed || RECORD_ENDMARK == committed) return ENODATA;
+
+   queue->readoff = (uint16_t) (queue->readoff + RECORDHEADERSIZE + alignrecord_cqueue(committed));
+
+   return 0;
+}
+
+
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NROPS
+ * Number of nodes transfered by every perftest instance. */
+#define PT_NROPS     1000000
+
+/* define: PT_BATCH
+ * Number of nodes inserted before they are committed. */
+#define PT_BATCH     16
+
+/* define: PT_NRPRODUCER
+ * Number of producer threads of <mpscqueue_t> of every perftest instance. */
+#define PT_NRPRODUCER 2
+
+/* struct: pt_queue_t
+ * Queue and threads used by a single perftest instance. */
+typedef struct pt_queue_t {
+   spscqueue_t    spsc;
+   mpscqueue_t    mpsc;
+   thread_t *     thread[PT_NRPRODUCER];
+   uint64_t       nrops;
+   int            isstart;
+   int            isstop;
+   int            err;
+} pt_queue_t;
+
+static int pt_consumer_spsc(pt_queue_t * pqueue)
+{
+   uint64_t expect = 0;
+
+   while (! loadacquire_atomicint(&pqueue->isstart)) {
+      yield_thread();
+   }
+
+   while (expect < pqueue->nrops) {
+      void * nodes;
+      size_t size;
+      if (firstbatch_spscqueue(&pqueue->spsc, &nodes, &size)) {
+         yield_thread();
+         continue;
+      }
+      for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+         if (expect++ != ((uint64_t*)nodes)[i/sizeof(uint64_t)]) {
+            pqueue->err = EINVAL;
+         }
+      }
+      (void) removefirst_spscqueue(&pqueue->spsc, size);
+   }
+
+   return 0;
+}
+
+static int pt_producer_mpsc(pt_queue_t * pqueue)
+{
+   const uint64_t nrops = pqueue->nrops / PT_NRPRODUCER;
+
+   while (! loadacquire_atomicint(&pqueue->isstart)) {
+      yield_thread();
+   }
+
+   for (uint64_t i = 0; i < nrops; i += PT_BATCH) {
+      void * node;
+      if (insert_mpscqueue(&pqueue->mpsc, PT_BATCH * sizeof(uint64_t), &node)) {
+         pqueue->err = ENOMEM;
+         break;
+      }
+      for (unsigned b = 0; b < PT_BATCH; ++b) {
+         ((uint64_t*)node)[b] = i + b;
+      }
+      commit_mpscqueue(&pqueue->mpsc, node);
+   }
+
+   // pages allocated by this thread are released by consumer
+   while (! loadacquire_atomicint(&pqueue->isstop)) {
+      yield_thread();
+   }
+
+   return 0;
+}
+
+static int pt_prepare(perftest_instance_t* tinst, bool isspsc)
+{
+   int err;
+   memblock_t  mblock = memblock_FREE;
+   pt_queue_t* pqueue = 0;
+   unsigned    nrthread = 0;
+
+   err = ALLOC_MM(sizeof(pt_queue_t), &mblock);
+   if (err) goto ONERR;
+
+   pqueue = (pt_queue_t*) mblock.addr;
+   memset(pqueue, 0, sizeof(*pqueue));
+   pqueue->spsc  = (spscqueue_t) spscqueue_FREE;
+   pqueue->mpsc  = (mpscqueue_t) mpscqueue_FREE;
+   pqueue->nrops = PT_NROPS;
+
+   if (isspsc) {
+      err = init_spscqueue(&pqueue->spsc, 4096);
+      if (err) goto ONERR;
+      err = newgeneric_thread(&pqueue->thread[0], &pt_consumer_spsc, pqueue);
+      if (err) goto ONERR;
+      nrthread = 1;
+   } else {
+      err = init_mpscqueue(&pqueue->mpsc, 4096);
+      if (err) goto ONERR;
+      for (; nrthread < PT_NRPRODUCER; ++nrthread) {
+         err = newgeneric_thread(&pqueue->thread[nrthread], &pt_producer_mpsc, pqueue);
+         if (err) goto ONERR;
+      }
+   }
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   if (pqueue) {
+      write_atomicint(&pqueue->isstart, 1);
+      write_atomicint(&pqueue->isstop, 1);
+      pqueue->nrops = 0;
+      for (unsigned i = 0; i < nrthread; ++i) {
+         (void) delete_thread(&pqueue->thread[i]);
+      }
+      (void) free_spscqueue(&pqueue->spsc);
+      (void) free_mpscqueue(&pqueue->mpsc);
+      (void) FREE_MM(&mblock);
+   }
+   return err;
+}
+
+static int pt_prepare_spsc(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, true);
+}
+
+static int pt_prepare_mpsc(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, false);
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t  mblock = memblock_INIT(tinst->size, tinst->addr);
+   pt_queue_t* pqueue = (pt_queue_t*) tinst->addr;
+
+   // free queue before producer threads exit (pages are owned by producers)
+   err = free_spscqueue(&pqueue->spsc);
+   int err2 = free_mpscqueue(&pqueue->mpsc);
+   if (err2) err = err2;
+   write_atomicint(&pqueue->isstart, 1);
+   write_atomicint(&pqueue->isstop, 1);
+   for (unsigned i = 0; i < lengthof(pqueue->thread); ++i) {
+      err2 = delete_thread(&pqueue->thread[i]);
+      if (err2) err = err2;
+   }
+   if (pqueue->err) err = pqueue->err;
+   err2 = FREE_MM(&mblock);
+   if (err2) err = err2;
+
+   return err;
+}
+
+/* function: pt_run_spsc
+ * Producer inserts nodes in batches of <PT_BATCH> and waits for the consumer thread. */
+static int pt_run_spsc(perftest_instance_t* tinst)
+{
+   pt_queue_t* pqueue = (pt_queue_t*) tinst->addr;
+
+   write_atomicint(&pqueue->isstart, 1);
+
+   for (uint64_t i = 0; i < tinst->nrops; ) {
+      for (unsigned b = 0; b < PT_BATCH; ++b, ++i) {
+         void * node;
+         if (insert_spscqueue(&pqueue->spsc, sizeof(uint64_t), &node)) return ENOMEM;
+         *(uint64_t*)node = i;
+      }
+      commit_spscqueue(&pqueue->spsc);
+   }
+
+   if (join_thread(pqueue->thread[0])) return EINVAL;
+
+   return pqueue->err;
+}
+
+/* function: pt_run_mpsc
+ * Consumer reads all nodes inserted by <PT_NRPRODUCER> producer threads. */
+static int pt_run_mpsc(perftest_instance_t* tinst)
+{
+   pt_queue_t* pqueue = (pt_queue_t*) tinst->addr;
+   uint64_t    nrnodes = 0;
+   uint64_t    expect[PT_NRPRODUCER] = { 0 };
+
+   write_atomicint(&pqueue->isstart, 1);
+
+   while (nrnodes < tinst->nrops) {
+      void *   node;
+      uint16_t size;
+      if (first_mpscqueue(&pqueue->mpsc, &node, &size)) {
+         if (pqueue->err) return pqueue->err;
+         yield_thread();
+         continue;
+      }
+      uint64_t first = ((uint64_t*)node)[0];
+      unsigned p = 0;
+      while (p < PT_NRPRODUCER-1 && expect[p] != first) ++p;
+      if (expect[p] != first) return EINVAL;
+      expect[p] += size / sizeof(uint64_t);
+      nrnodes   += size / sizeof(uint64_t);
+      (void) removefirst_mpscqueue(&pqueue->mpsc);
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_cqueue_spsc(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_spsc, &pt_run_spsc, &pt_unprepare),
+               "Transfer a node of 8 bytes from 1 producer to 1 consumer (batches of 16)",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_cqueue_mpsc(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_mpsc, &pt_run_mpsc, &pt_unprepare),
+               "Transfer a node of 8 bytes from 2 producers to 1 consumer (batches of 16)",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+static int test_spsc_initfree(void)
+{
+   spscqueue_t queue = spscqueue_FREE;
+   size_t      size  = SIZEALLOCATED_PAGECACHE();
+
+   // TEST spscqueue_FREE
+   TEST(0 == queue.first);
+   TEST(0 == queue.readoff);
+   TEST(0 == queue.readend);
+   TEST(0 == queue.last);
+   TEST(0 == queue.published);
+   TEST(0 == queue.lastend);
+   TEST(0 == queue.publishedend);
+   TEST(0 == queue.spare);
+   TEST(0 == queue.pagesize);
+   TEST(isfree_spscqueue(&queue));
+
+   // TEST init_spscqueue
+   for (unsigned pgsize = 256; pgsize <= 16384; pgsize *= 2) {
+      TEST(0 == init_spscqueue(&queue, pgsize));
+      TEST(0 != queue.first);
+      TEST(sizeof(queue_page_t) == queue.readoff);
+      TEST(sizeof(queue_page_t) == queue.readend);
+      TEST(queue.first == queue.last);
+      TEST(queue.first == queue.published);
+      TEST(sizeof(queue_page_t) == queue.lastend);
+      TEST(sizeof(queue_page_t) == queue.publishedend);
+      TEST(0 == queue.spare);
+      TEST(pgsize == pagesize_spscqueue(&queue));
+      TEST(0 == queue.first->next);
+      TEST(0 == queue.first->prev);
+      TEST(0 == queue.first->queue);
+      TEST(sizeof(queue_page_t) == queue.first->end_offset);
+      TEST(sizeof(queue_page_t) == queue.first->start_offset);
+      TEST(! isfree_spscqueue(&queue));
+      TEST(size + pgsize == SIZEALLOCATED_PAGECACHE());
+
+      // TEST free_spscqueue
+      TEST(0 == free_spscqueue(&queue));
+      TEST(isfree_spscqueue(&queue));
+      TEST(size == SIZEALLOCATED_PAGECACHE());
+      TEST(0 == free_spscqueue(&queue));
+      TEST(isfree_spscqueue(&queue));
+   }
+
+   // TEST init_spscqueue: EINVAL
+   TEST(EINVAL == init_spscqueue(&queue, 0));
+   TEST(EINVAL == init_spscqueue(&queue, 128));
+   TEST(EINVAL == init_spscqueue(&queue, 1000));
+   TEST(EINVAL == init_spscqueue(&queue, 32768));
+   TEST(isfree_spscqueue(&queue));
+
+   // TEST init_spscqueue: ENOMEM
+   init_testerrortimer(&s_cqueue_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == init_spscqueue(&queue, 4096));
+   TEST(isfree_spscqueue(&queue));
+
+   // TEST free_spscqueue: ENOMEM
+   TEST(0 == init_spscqueue(&queue, 4096));
+   init_testerrortimer(&s_cqueue_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == free_spscqueue(&queue));
+   TEST(isfree_spscqueue(&queue));
+   TEST(size == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_cqueue_errtimer);
+   free_spscqueue(&queue);
+   return EINVAL;
+}
+
+static int test_spsc_update(void)
+{
+   spscqueue_t queue = spscqueue_FREE;
+   size_t      size  = SIZEALLOCATED_PAGECACHE();
+   void *      node;
+   void *      nodes;
+   size_t      nodessize;
+
+   // prepare
+   TEST(0 == init_spscqueue(&queue, 256));
+
+   // TEST firstbatch_spscqueue: ENODATA
+   TEST(ENODATA == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+   TEST(ENODATA == first_spscqueue(&queue, 1, &node));
+
+   // TEST insert_spscqueue: invisible before commit
+   for (unsigned i = 0; i < 10; ++i) {
+      TEST(0 == insert_spscqueue(&queue, 16, &node));
+      TEST(node == (uint8_t*)queue.last + sizeof(queue_page_t) + 16*i);
+      memset(node, (int)i, 16);
+      TEST(sizeof(queue_page_t) + 16*(i+1) == queue.lastend);
+      TEST(sizeof(queue_page_t) == queue.first->end_offset);
+      TEST(ENODATA == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+   }
+
+   // TEST commit_spscqueue: single page
+   commit_spscqueue(&queue);
+   TEST(sizeof(queue_page_t) + 160 == queue.first->end_offset);
+   TEST(0 == queue.first->next);
+
+   // TEST firstbatch_spscqueue: single page
+   TEST(0 == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+   TEST(nodes == (uint8_t*)queue.first + sizeof(queue_page_t));
+   TEST(160 == nodessize);
+   TEST(queue.readend == sizeof(queue_page_t) + 160);
+
+   // TEST first_spscqueue
+   TEST(0 == first_spscqueue(&queue, 160, &node));
+   TEST(node == nodes);
+   TEST(ENODATA == first_spscqueue(&queue, 161, &node));
+
+   // TEST removefirst_spscqueue
+   for (unsigned i = 0; i < 10; ++i) {
+      TEST(0 == first_spscqueue(&queue, 16, &node));
+      TEST(i == *(uint8_t*)node);
+      TEST(EOVERFLOW == removefirst_spscqueue(&queue, 160 - 16*i + 1));
+      TEST(0 == removefirst_spscqueue(&queue, 16));
+      TEST(sizeof(queue_page_t) + 16*(i+1) == queue.readoff);
+   }
+   TEST(ENODATA == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+   TEST(0 == removefirst_spscqueue(&queue, 0));
+   TEST(EOVERFLOW == removefirst_spscqueue(&queue, 1));
+
+   // TEST insert_spscqueue: new pages are linked after commit
+   queue_page_t * page[4] = { queue.first, 0, 0, 0 };
+   TEST(0 == insert_spscqueue(&queue, 256 - sizeof(queue_page_t) - 160, &node));
+   memset(node, 10, 256 - sizeof(queue_page_t) - 160);
+   for (unsigned i = 1; i < lengthof(page); ++i) {
+      TEST(0 == insert_spscqueue(&queue, 150, &node));
+      page[i] = queue.last;
+      TEST(page[i] != page[i-1]);
+      TEST(node == (uint8_t*)page[i] + sizeof(queue_page_t));
+      memset(node, (int)(10+i), 150);
+      TEST(page[i-1] == (queue_page_t*)page[i]->prev);
+      TEST(0 == page[i]->next);
+      TEST(0 == page[i-1]->next);
+      TEST(page[0] == queue.published);
+      TEST(sizeof(queue_page_t) + 150 == queue.lastend);
+   }
+   // only first page is visible and its end_offset is not published
+   TEST(256 == queue.publishedend);
+   TEST(sizeof(queue_page_t) + 160 == page[0]->end_offset);
+   TEST(ENODATA == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+
+   // TEST commit_spscqueue: multiple pages
+   commit_spscqueue(&queue);
+   TEST(page[3] == queue.published);
+   TEST(256 == page[0]->end_offset);
+   for (unsigned i = 1; i < lengthof(page); ++i) {
+      TEST(page[i] == (queue_page_t*)page[i-1]->next);
+      TEST(sizeof(queue_page_t) + 150 == page[i]->end_offset);
+   }
+   TEST(0 == page[3]->next);
+
+   // TEST firstbatch_spscqueue: releases read page into spare
+   TEST(0 == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+   TEST(256 - sizeof(queue_page_t) - 160 == nodessize);
+   TEST(10 == *(uint8_t*)nodes);
+   TEST(0 == removefirst_spscqueue(&queue, nodessize));
+   for (unsigned i = 1; i < lengthof(page); ++i) {
+      TEST(0 == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+      TEST(queue.first == page[i]);
+      TEST(150 == nodessize);
+      TEST(10+i == *(uint8_t*)nodes);
+      TEST(page[0] == queue.spare);
+      TEST(0 == removefirst_spscqueue(&queue, nodessize));
+   }
+   TEST(ENODATA == firstbatch_spscqueue(&queue, &nodes, &nodessize));
+   TEST(size + 2*256 == SIZEALLOCATED_PAGECACHE());
+
+   // TEST insert_spscqueue: reuses spare page
+   TEST(0 == insert_spscqueue(&queue, 200, &node));
+   TEST(queue.last == page[0]);
+   TEST(0 == queue.spare);
+   TEST(size + 2*256 == SIZEALLOCATED_PAGECACHE());
+   commit_spscqueue(&queue);
+
+   // TEST insert_spscqueue: EINVAL
+   TEST(EINVAL == insert_spscqueue(&queue, 0, &node));
+   TEST(EINVAL == insert_spscqueue(&queue, (uint16_t) (256 - sizeof(queue_page_t) + 1), &node));
+
+   // TEST insert_spscqueue: ENOMEM
+   init_testerrortimer(&s_cqueue_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == insert_spscqueue(&queue, 200, &node));
+   TEST(queue.last == page[0]);
+
+   // TEST free_spscqueue: frees unpublished pages
+   TEST(0 == insert_spscqueue(&queue, 200, &node));
+   TEST(0 == insert_spscqueue(&queue, 200, &node));
+   TEST(size + 4*256 == SIZEALLOCATED_PAGECACHE());
+   TEST(0 == free_spscqueue(&queue));
+   TEST(size == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_cqueue_errtimer);
+   free_spscqueue(&queue);
+   return EINVAL;
+}
+
+static int test_mpsc_initfree(void)
+{
+   mpscqueue_t queue = mpscqueue_FREE;
+   size_t      size  = SIZEALLOCATED_PAGECACHE();
+
+   // TEST mpscqueue_FREE
+   TEST(0 == queue.first);
+   TEST(0 == queue.retired);
+   TEST(0 == queue.readoff);
+   TEST(0 == queue.last);
+   TEST(0 == queue.nrproducer);
+   TEST(0 == queue.spare);
+   TEST(0 == queue.pagesize);
+   TEST(isfree_mpscqueue(&queue));
+
+   // TEST init_mpscqueue
+   for (unsigned pgsize = 256; pgsize <= 16384; pgsize *= 2) {
+      TEST(0 == init_mpscqueue(&queue, pgsize));
+      TEST(0 != queue.first);
+      TEST(0 == queue.retired);
+      TEST(sizeof(queue_page_t) == queue.readoff);
+      TEST(queue.first == queue.last);
+      TEST(0 == queue.nrproducer);
+      TEST(0 == queue.spare);
+      TEST(pgsize == pagesize_mpscqueue(&queue));
+      TEST(pgsize - sizeof(queue_page_t) - RECORDHEADERSIZE == maxnodesize_mpscqueue(&queue));
+      TEST(0 == queue.first->next);
+      TEST(0 == queue.first->prev);
+      TEST(0 == queue.first->queue);
+      TEST(sizeof(queue_page_t) == queue.first->end_offset);
+      for (unsigned i = sizeof(queue_page_t); i < pgsize; ++i) {
+         TEST(0 == ((uint8_t*)queue.first)[i]);
+      }
+      TEST(! isfree_mpscqueue(&queue));
+      TEST(size + pgsize == SIZEALLOCATED_PAGECACHE());
+
+      // TEST free_mpscqueue
+      TEST(0 == free_mpscqueue(&queue));
+      TEST(isfree_mpscqueue(&queue));
+      TEST(size == SIZEALLOCATED_PAGECACHE());
+      TEST(0 == free_mpscqueue(&queue));
+      TEST(isfree_mpscqueue(&queue));
+   }
+
+   // TEST init_mpscqueue: EINVAL
+   TEST(EINVAL == init_mpscqueue(&queue, 0));
+   TEST(EINVAL == init_mpscqueue(&queue, 128));
+   TEST(EINVAL == init_mpscqueue(&queue, 1000));
+   TEST(EINVAL == init_mpscqueue(&queue, 32768));
+   TEST(isfree_mpscqueue(&queue));
+
+   // TEST init_mpscqueue: ENOMEM
+   init_testerrortimer(&s_cqueue_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == init_mpscqueue(&queue, 4096));
+   TEST(isfree_mpscqueue(&queue));
+
+   // TEST free_mpscqueue: ENOMEM
+   TEST(0 == init_mpscqueue(&queue, 4096));
+   init_testerrortimer(&s_cqueue_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == free_mpscqueue(&queue));
+   TEST(isfree_mpscqueue(&queue));
+   TEST(size == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_cqueue_errtimer);
+   free_mpscqueue(&queue);
+   return EINVAL;
+}
+
+static int test_mpsc_update(void)
+{
+   mpscqueue_t queue = mpscqueue_FREE;
+   size_t      size  = SIZEALLOCATED_PAGECACHE();
+   void *      node[30];
+   void *      rnode;
+   uint16_t    rsize;
+
+   // prepare
+   TEST(0 == init_mpscqueue(&queue, 256));
+   queue_page_t * page = queue.first;
+
+   // TEST first_mpscqueue: ENODATA
+   TEST(ENODATA == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(ENODATA == removefirst_mpscqueue(&queue));
+
+   // TEST insert_mpscqueue: reserves aligned records
+   for (unsigned i = 0; i < 5; ++i) {
+      TEST(0 == insert_mpscqueue(&queue, (uint16_t)(1+i), &node[i]));
+      TEST(node[i] == (uint8_t*)page + sizeof(queue_page_t) + 16*i + RECORDHEADERSIZE);
+      TEST(sizeof(queue_page_t) + 16*(i+1) == page->end_offset);
+      TEST(0 == ((record_t*)node[i])[-1].committed);
+      TEST(1+i == ((record_t*)node[i])[-1].size);
+      TEST(0 == queue.nrproducer);
+      memset(node[i], (int)i, 1+i);
+   }
+
+   // TEST first_mpscqueue: waits for uncommitted record
+   commit_mpscqueue(&queue, node[1]);
+   TEST(ENODATA == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(ENODATA == removefirst_mpscqueue(&queue));
+
+   // TEST commit_mpscqueue
+   commit_mpscqueue(&queue, node[0]);
+   TEST(1 == ((record_t*)node[0])[-1].committed);
+
+   // TEST first_mpscqueue, removefirst_mpscqueue
+   for (unsigned i = 0; i < 5; ++i) {
+      if (i >= 2) {
+         TEST(ENODATA == first_mpscqueue(&queue, &rnode, &rsize));
+         commit_mpscqueue(&queue, node[i]);
+      }
+      TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+      TEST(rnode == node[i]);
+      TEST(rsize == 1+i);
+      TEST(0 == removefirst_mpscqueue(&queue));
+      TEST(sizeof(queue_page_t) + 16*(i+1) == queue.readoff);
+   }
+   TEST(ENODATA == first_mpscqueue(&queue, &rnode, &rsize));
+
+   // TEST insert_mpscqueue: closes full page and allocates new page
+   // free space is 256 - 32 - 80 == 144 bytes
+   TEST(0 == insert_mpscqueue(&queue, 100, &node[0]));
+   TEST(0 == insert_mpscqueue(&queue, 12, &node[1]));
+   TEST(page == queue.last);
+   TEST(256 - 8 == page->end_offset);
+   TEST(0 == insert_mpscqueue(&queue, 1, &node[2]));
+   TEST(page != queue.last);
+   TEST(PAGE_CLOSED == page->end_offset);
+   TEST(queue.last == (queue_page_t*)page->next);
+   TEST(RECORD_ENDMARK == ((record_t*)((uint8_t*)page + 256 - 8))->committed);
+   TEST(node[2] == (uint8_t*)queue.last + sizeof(queue_page_t) + RECORDHEADERSIZE);
+   commit_mpscqueue(&queue, node[0]);
+   commit_mpscqueue(&queue, node[1]);
+   commit_mpscqueue(&queue, node[2]);
+
+   // TEST first_mpscqueue: changes page and retires read page
+   TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(rnode == node[0] && 100 == rsize);
+   TEST(0 == removefirst_mpscqueue(&queue));
+   TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(rnode == node[1] && 12 == rsize);
+   TEST(0 == removefirst_mpscqueue(&queue));
+   TEST(256 - 8 == queue.readoff);
+   TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(rnode == node[2] && 1 == rsize);
+   TEST(queue.first == queue.last);
+   TEST(0 == queue.retired);
+   TEST(page == queue.spare);
+   TEST(0 == removefirst_mpscqueue(&queue));
+
+   // TEST first_mpscqueue: retires page if a producer is active
+   TEST(0 == insert_mpscqueue(&queue, maxnodesize_mpscqueue(&queue), &node[0]));
+   page = queue.last;
+   TEST(page != queue.first);
+   TEST(0 == queue.spare/*reused*/);
+   TEST(0 == insert_mpscqueue(&queue, 8, &node[1]));
+   TEST(page != queue.last);
+   commit_mpscqueue(&queue, node[0]);
+   commit_mpscqueue(&queue, node[1]);
+   TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(rnode == node[0]);
+   TEST(0 == removefirst_mpscqueue(&queue));
+   queue.nrproducer = 1;
+   TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(rnode == node[1]);
+   TEST(page == queue.retired);
+   TEST(0 == page->prev);
+   // TEST first_mpscqueue: releases retired pages
+   TEST(0 == removefirst_mpscqueue(&queue));
+   queue.nrproducer = 0;
+   TEST(0 == insert_mpscqueue(&queue, maxnodesize_mpscqueue(&queue), &node[0]));
+   TEST(0 == insert_mpscqueue(&queue, maxnodesize_mpscqueue(&queue), &node[1]));
+   commit_mpscqueue(&queue, node[0]);
+   commit_mpscqueue(&queue, node[1]);
+   TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(rnode == node[0]);
+   TEST(0 == removefirst_mpscqueue(&queue));
+   TEST(0 == first_mpscqueue(&queue, &rnode, &rsize));
+   TEST(rnode == node[1]);
+   TEST(0 == queue.retired);
+   TEST(0 == removefirst_mpscqueue(&queue));
+
+   // TEST insert_mpscqueue: EINVAL
+   TEST(EINVAL == insert_mpscqueue(&queue, 0, &node[0]));
+   TEST(EINVAL == insert_mpscqueue(&queue, (uint16_t) (maxnodesize_mpscqueue(&queue)+1), &node[0]));
+   TEST(0 == queue.nrproducer);
+
+   // TEST insert_mpscqueue: ENOMEM
+   TEST(0 == queue.spare || 0 == delete_cqueuepage(queue.spare, queue.pagesize));
+   queue.spare = 0;
+   init_testerrortimer(&s_cqueue_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == insert_mpscqueue(&queue, maxnodesize_mpscqueue(&queue), &node[0]));
+   TEST(0 == queue.nrproducer);
+
+   // TEST free_mpscqueue: frees all pages
+   TEST(0 == free_mpscqueue(&queue));
+   TEST(size == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_cqueue_errtimer);
+   free_mpscqueue(&queue);
+   return EINVAL;
+}
+
+/* define: TEST_NROPS
+ * Number of nodes transfered by every producer thread. */
+#define TEST_NROPS 100000
+
+/* struct: testthread_t
+ * Parameter of producer threads. */
+typedef struct testthread_t {
+   spscqueue_t *  spsc;
+   mpscqueue_t *  mpsc;
+   uint32_t       id;
+   int            isstop;
+} testthread_t;
+
+static int thread_spscproducer(testthread_t * param)
+{
+   for (uint32_t i = 0; i < TEST_NROPS; ) {
+      unsigned batch = 1 + i % 7;
+      for (unsigned b = 0; b < batch && i < TEST_NROPS; ++b, ++i) {
+         void * node;
+         uint16_t nodesize = (uint16_t) (sizeof(uint32_t) * (1 + i % 3));
+         if (insert_spscqueue(param->spsc, nodesize, &node)) return EINVAL;
+         for (unsigned s = 0; s < nodesize / sizeof(uint32_t); ++s) {
+            ((uint32_t*)node)[s] = i;
+         }
+      }
+      commit_spscqueue(param->spsc);
+   }
+
+   while (! loadacquire_atomicint(&param->isstop)) {
+      yield_thread();
+   }
+
+   return 0;
+}
+
+static int thread_mpscproducer(testthread_t * param)
+{
+   for (uint32_t i = 0; i < TEST_NROPS; ) {
+      void * node;
+      uint32_t batch = 1 + i % 5;
+      if (batch > TEST_NROPS - i) batch = TEST_NROPS - i;
+      if (insert_mpscqueue(param->mpsc, (uint16_t) (sizeof(uint32_t) * (1 + batch)), &node)) return EINVAL;
+      ((uint32_t*)node)[0] = param->id;
+      for (unsigned b = 0; b < batch; ++b, ++i) {
+         ((uint32_t*)node)[1+b] = i;
+      }
+      commit_mpscqueue(param->mpsc, node);
+   }
+
+   while (! loadacquire_atomicint(&param->isstop)) {
+      yield_thread();
+   }
+
+   return 0;
+}
+
+static int test_concurrent(void)
+{
+   spscqueue_t    spsc = spscqueue_FREE;
+   mpscqueue_t    mpsc = mpscqueue_FREE;
+   testthread_t   param[4];
+   thread_t *     thread[lengthof(param)] = { 0 };
+   size_t         size = SIZEALLOCATED_PAGECACHE();
+
+   // TEST spscqueue_t: single producer thread
+   TEST(0 == init_spscqueue(&spsc, 256));
+   param[0] = (testthread_t) { &spsc, 0, 0, 0 };
+   TEST(0 == newgeneric_thread(&thread[0], &thread_spscproducer, &param[0]));
+   for (uint32_t i = 0; i < TEST_NROPS; ) {
+      void * nodes;
+      size_t nodessize;
+      if (firstbatch_spscqueue(&spsc, &nodes, &nodessize)) {
+         yield_thread();
+         continue;
+      }
+      // consume nodes one by one
+      uint32_t nodesize = (uint32_t) (sizeof(uint32_t) * (1 + i % 3));
+      TEST(nodesize <= nodessize);
+      for (unsigned s = 0; s < nodesize / sizeof(uint32_t); ++s) {
+         TEST(i == ((uint32_t*)nodes)[s]);
+      }
+      TEST(0 == removefirst_spscqueue(&spsc, nodesize));
+      ++ i;
+   }
+   TEST(0 == free_spscqueue(&spsc));
+   write_atomicint(&param[0].isstop, 1);
+   TEST(0 == join_thread(thread[0]));
+   TEST(0 == returncode_thread(thread[0]));
+   TEST(0 == delete_thread(&thread[0]));
+
+   // TEST mpscqueue_t: multiple producer threads
+   TEST(0 == init_mpscqueue(&mpsc, 256));
+   for (uint32_t t = 0; t < lengthof(param); ++t) {
+      param[t] = (testthread_t) { 0, &mpsc, t, 0 };
+      TEST(0 == newgeneric_thread(&thread[t], &thread_mpscproducer, &param[t]));
+   }
+   uint32_t expect[lengthof(param)] = { 0 };
+   for (uint32_t nrnodes = 0; nrnodes < lengthof(param) * TEST_NROPS; ) {
+      void *   node;
+      uint16_t nodesize;
+      if (first_mpscqueue(&mpsc, &node, &nodesize)) {
+         yield_thread();
+         continue;
+      }
+      uint32_t id = ((uint32_t*)node)[0];
+      TEST(id < lengthof(param));
+      // nodes of the same producer are received in FIFO order
+      for (unsigned b = 1; b < nodesize / sizeof(uint32_t); ++b) {
+         TEST(expect[id] == ((uint32_t*)node)[b]);
+         ++ expect[id];
+         ++ nrnodes;
+      }
+      TEST(0 == removefirst_mpscqueue(&mpsc));
+   }
+   for (uint32_t t = 0; t < lengthof(param); ++t) {
+      TEST(TEST_NROPS == expect[t]);
+   }
+   TEST(0 == mpsc.nrproducer);
+   TEST(0 == free_mpscqueue(&mpsc));
+   for (uint32_t t = 0; t < lengthof(param); ++t) {
+      write_atomicint(&param[t].isstop, 1);
+      TEST(0 == join_thread(thread[t]));
+      TEST(0 == returncode_thread(thread[t]));
+      TEST(0 == delete_thread(&thread[t]));
+   }
+   TEST(size == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_spscqueue(&spsc);
+   free_mpscqueue(&mpsc);
+   for (uint32_t t = 0; t < lengthof(param); ++t) {
+      if (thread[t]) write_atomicint(&param[t].isstop, 1);
+      delete_thread(&thread[t]);
+   }
+   return EINVAL;
+}
+
+int unittest_ds_inmem_cqueue()
+{
+   if (test_spsc_initfree())     goto ONERR;
+   if (test_spsc_update())       goto ONERR;
+   if (test_mpsc_initfree())     goto ONERR;
+   if (test_mpsc_update())       goto ONERR;
+   if (test_concurrent())        goto ONERR;
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+#endif
@@ -0,0 +1,944 @@
+/* title: DHeap impl
+
+   Implements <DHeap>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/dheap.h
+    Header file <DHeap>.
+
+   file: C-kern/ds/inmem/dheap.c
+    Implementation file <DHeap impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/ds/inmem/dheap.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#include "C-kern/api/test/errortimer.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/ds/inmem/heap.h"
+#include "C-kern/api/test/perftest.h"
+#endif
+
+
+// section: dheap_t
+
+// group: static variables
+
+#ifdef KONFIG_UNITTEST
+/* variable: s_dheap_errtimer
+ * Simulates an error in <allocarray_dheap>. */
+static test_errortimer_t   s_dheap_errtimer = test_errortimer_FREE;
+#endif
+
+// group: constants
+
+/* define: CACHELINESIZE
+ * The size of a cache line in bytes. <dheap_t.array> is aligned to this size. */
+#define CACHELINESIZE 64
+
+/* define: NRALIGNSLOTS
+ * The number of additional array slots allocated to align <dheap_t.array>. */
+#define NRALIGNSLOTS (CACHELINESIZE / sizeof(dheap_node_t*))
+
+// group: macros
+
+/* define: PARENT
+ * Returns the index of the parent of the node at index i (i > 0). */
+#define PARENT(i) \
+         (((i) - 1) / dheap_ARITY)
+
+/* define: FIRSTCHILD
+ * Returns the index of the first child of the node at index i. */
+#define FIRSTCHILD(i) \
+         (dheap_ARITY * (i) + 1)
+
+/* define: ISLESS
+ * Returns true if the node left has a lower priority than node right. */
+#define ISLESS(left, right) \
+         (heap->cmp(heap->cmpstate, left, right) < 0)
+
+// group: helper
+
+/* function: alignedarray_dheap
+ * Returns the start address of the array contained in mem.
+ * The address of the second slot (index 1) is aligned to <CACHELINESIZE>.
+ * The first child of every node has therefore an index which is a multiple
+ * of <dheap_ARITY> counted from index 1 and all children share one cache line. */
+static inline dheap_node_t ** alignedarray_dheap(void * mem)
+{
+   uintptr_t start = (uintptr_t) mem + sizeof(dheap_node_t*);
+   start = (start + (CACHELINESIZE-1)) & ~(uintptr_t)(CACHELINESIZE-1);
+   return (dheap_node_t**) start - 1;
+}
+
+/* function: allocarray_dheap
+ * Resizes the allocated array to hold capacity nodes.
+ * The first <dheap_t.nrofelem> nodes are preserved.
+ * The heap is not changed in case of an error. */
+static int allocarray_dheap(dheap_t * heap, size_t capacity)
+{
+   int err;
+   memblock_t mblock = memblock_INIT(heap->memsize, heap->mem);
+   size_t     offset = heap->mem ? (size_t) (heap->array - (dheap_node_t**) heap->mem) : 0;
+
+   if (capacity > SIZE_MAX / sizeof(dheap_node_t*) - NRALIGNSLOTS) {
+      err = ENOMEM;
+      goto ONERR;
+   }
+
+   if (! PROCESS_testerrortimer(&s_dheap_errtimer, &err)) {
+      err = RESIZE_MM((capacity + NRALIGNSLOTS) * sizeof(dheap_node_t*), &mblock);
+   }
+   if (err) goto ONERR;
+
+   dheap_node_t ** array = alignedarray_dheap(mblock.addr);
+   if ((dheap_node_t**) mblock.addr + offset != array) {
+      // alignment changed
+      memmove(array, (dheap_node_t**) mblock.addr + offset, heap->nrofelem * sizeof(dheap_node_t*));
+   }
+
+   heap->array    = array;
+   heap->capacity = capacity;
+   heap->mem      = mblock.addr;
+   heap->memsize  = mblock.size;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: siftup_dheap
+ * Moves node from index i in direction of the top until its parent has a higher or equal priority.
+ * Every node which is moved to a new position is stored together with its new index. */
+static inline void siftup_dheap(dheap_t * heap, dheap_node_t * node, size_t i)
+{
+   while (i > 0) {
+      size_t parent = PARENT(i);
+      dheap_node_t * pnode = heap->array[parent];
+      if (! ISLESS(pnode, node)) break;
+      heap->array[i] = pnode;
+      pnode->index   = i;
+      i = parent;
+   }
+
+   heap->array[i] = node;
+   node->index    = i;
+}
+
+/* function: siftdown_dheap
+ * Moves node from index i in direction of the leaves until all its children have a lower or equal priority.
+ * Every node which is moved to a new position is stored together with its new index. */
+static inline void siftdown_dheap(dheap_t * heap, dheap_node_t * node, size_t i)
+{
+   const size_t nrofelem = heap->nrofelem;
+
+   for (;;) {
+      size_t child = FIRSTCHILD(i);
+      if (child >= nrofelem) break;
+
+      size_t end = child + dheap_ARITY;
+      if (end > nrofelem) end = nrofelem;
+
+      size_t         maxchild = child;
+      dheap_node_t * maxnode  = heap->array[child];
+      while (++child < end) {
+         if (ISLESS(maxnode, heap->array[child])) {
+            maxchild = child;
+            maxnode  = heap->array[child];
+         }
+      }
+
+      if (! ISLESS(node, maxnode)) break;
+      heap->array[i] = maxnode;
+      maxnode->index = i;
+      i = maxchild;
+   }
+
+   heap->array[i] = node;
+   node->index    = i;
+}
+
+/* function: isstored_dheap
+ * Returns true if node is stored in heap. */
+static inline bool isstored_dheap(const dheap_t * heap, const dheap_node_t * node)
+{
+   return node->index < heap->nrofelem && heap->array[node->index] == node;
+}
+
+// group: lifetime
+
+int init_dheap(/*out*/dheap_t * heap, size_t capacity, dheap_compare_f cmp, void * cmpstate)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(cmp != 0, ONERR, );
+
+   dheap_t newheap = { cmp, cmpstate, 0, 0, 0, 0, 0 };
+
+   if (capacity) {
+      err = allocarray_dheap(&newheap, capacity);
+      if (err) goto ONERR;
+   }
+
+   *heap = newheap;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_dheap(dheap_t * heap)
+{
+   int err;
+   memblock_t mblock = memblock_INIT(heap->memsize, heap->mem);
+
+   err = FREE_MM(&mblock);
+   (void) PROCESS_testerrortimer(&s_dheap_errtimer, &err);
+
+   heap->array    = 0;
+   heap->nrofelem = 0;
+   heap->capacity = 0;
+   heap->mem      = 0;
+   heap->memsize  = 0;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+int invariant_dheap(const dheap_t * heap)
+{
+   if (heap->nrofelem > heap->capacity) goto ONERR;
+
+   for (size_t i = 0; i < heap->nrofelem; ++i) {
+      if (heap->array[i]->index != i) goto ONERR;
+      if (i > 0 && ISLESS(heap->array[PARENT(i)], heap->array[i])) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(EINVARIANT);
+   return EINVARIANT;
+}
+
+// group: update
+
+int insert_dheap(dheap_t * heap, dheap_node_t * node)
+{
+   int err;
+
+   if (heap->nrofelem == heap->capacity) {
+      if (heap->capacity > SIZE_MAX / 2) {
+         err = ENOMEM;
+         goto ONERR;
+      }
+      err = allocarray_dheap(heap, heap->capacity ? 2 * heap->capacity : 4 * dheap_ARITY);
+      if (err) goto ONERR;
+   }
+
+   size_t i = heap->nrofelem ++;
+   siftup_dheap(heap, node, i);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int remove_dheap(dheap_t * heap, /*out*/dheap_node_t ** node)
+{
+   if (0 == heap->nrofelem) return ENODATA;
+
+   *node = heap->array[0];
+
+   size_t last = -- heap->nrofelem;
+   if (last) {
+      siftdown_dheap(heap, heap->array[last], 0);
+   }
+
+   return 0;
+}
+
+int removenode_dheap(dheap_t * heap, dheap_node_t * node)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(isstored_dheap(heap, node), ONERR, );
+
+   size_t last = -- heap->nrofelem;
+   if (node->index != last) {
+      size_t i = node->index;
+      dheap_node_t * lastnode = heap->array[last];
+      if (i > 0 && ISLESS(heap->array[PARENT(i)], lastnode)) {
+         siftup_dheap(heap, lastnode, i);
+      } else {
+         siftdown_dheap(heap, lastnode, i);
+      }
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int increasekey_dheap(dheap_t * heap, dheap_node_t * node)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(isstored_dheap(heap, node), ONERR, );
+
+   siftup_dheap(heap, node, node->index);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int decreasekey_dheap(dheap_t * heap, dheap_node_t * node)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(isstored_dheap(heap, node), ONERR, );
+
+   siftdown_dheap(heap, node, node->index);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int update_dheap(dheap_t * heap, dheap_node_t * node)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(isstored_dheap(heap, node), ONERR, );
+
+   size_t i = node->index;
+   if (i > 0 && ISLESS(heap->array[PARENT(i)], node)) {
+      siftup_dheap(heap, node, i);
+   } else {
+      siftdown_dheap(heap, node, i);
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NROPS
+ * Number of remove and insert operations executed by every perftest instance. */
+#define PT_NROPS     1000000
+
+/* define: PT_NRNODES
+ * Number of nodes stored in the heap of every perftest instance. */
+#define PT_NRNODES   65536
+
+/* struct: pt_node_t
+ * Node stored in <dheap_t> during the perftest. */
+typedef struct pt_node_t {
+   dheap_node_t   node;
+   uint64_t       key;
+} pt_node_t;
+
+/* struct: pt_heap_t
+ * Heaps and nodes used by a single perftest instance. */
+typedef struct pt_heap_t {
+   dheap_t        dheap;
+   heap_t         heap;
+   pt_node_t      node[PT_NRNODES];
+   uint64_t       elem[PT_NRNODES];
+} pt_heap_t;
+
+static int pt_cmpnode(void * cmpstate, const dheap_node_t * left, const dheap_node_t * right)
+{
+   (void) cmpstate;
+   uint64_t l = ((const pt_node_t*)left)->key;
+   uint64_t r = ((const pt_node_t*)right)->key;
+   return (l < r) ? -1 : (l > r) ? +1 : 0;
+}
+
+static int pt_cmpelem(void * cmpstate, const void * left, const void * right)
+{
+   (void) cmpstate;
+   uint64_t l = *(const uint64_t*)left;
+   uint64_t r = *(const uint64_t*)right;
+   return (l < r) ? -1 : (l > r) ? +1 : 0;
+}
+
+/* function: pt_nextdelta
+ * Returns a pseudo random value in range [1..1024]. */
+static inline uint64_t pt_nextdelta(uint32_t * seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return 1 + ((*seed >> 8) % 1024);
+}
+
+static int pt_prepare(perftest_instance_t* tinst, bool isdheap)
+{
+   int err;
+   memblock_t  mblock = memblock_FREE;
+   pt_heap_t*  pheap  = 0;
+   uint32_t    seed   = tinst->tid;
+
+   err = ALLOC_MM(sizeof(pt_heap_t), &mblock);
+   if (err) goto ONERR;
+
+   pheap = (pt_heap_t*) mblock.addr;
+   pheap->dheap = (dheap_t) dheap_FREE;
+   pheap->heap  = (heap_t) heap_FREE;
+
+   for (size_t i = 0; i < PT_NRNODES; ++i) {
+      uint64_t key = ((uint64_t)1 << 40) + 1024 * pt_nextdelta(&seed);
+      pheap->node[i].node = (dheap_node_t) dheap_node_INIT;
+      pheap->node[i].key  = key;
+      pheap->elem[i]      = key;
+   }
+
+   if (isdheap) {
+      err = init_dheap(&pheap->dheap, PT_NRNODES, &pt_cmpnode, 0);
+      if (err) goto ONERR;
+      for (size_t i = 0; i < PT_NRNODES; ++i) {
+         err = insert_dheap(&pheap->dheap, &pheap->node[i].node);
+         if (err) goto ONERR;
+      }
+   } else {
+      err = init_heap(&pheap->heap, sizeof(uint64_t), PT_NRNODES, PT_NRNODES, pheap->elem, &pt_cmpelem, 0);
+      if (err) goto ONERR;
+   }
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   if (pheap) {
+      (void) free_dheap(&pheap->dheap);
+      (void) FREE_MM(&mblock);
+   }
+   return err;
+}
+
+static int pt_prepare_dheap(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, true);
+}
+
+static int pt_prepare_heap(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, false);
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t  mblock = memblock_INIT(tinst->size, tinst->addr);
+   pt_heap_t*  pheap  = (pt_heap_t*) tinst->addr;
+
+   err = free_dheap(&pheap->dheap);
+   int err2 = free_heap(&pheap->heap);
+   if (err2) err = err2;
+   err2 = FREE_MM(&mblock);
+   if (err2) err = err2;
+
+   return err;
+}
+
+/* function: pt_run_dheap
+ * Hold model: removes the node with the highest key
+ * and inserts it again with a lower key. */
+static int pt_run_dheap(perftest_instance_t* tinst)
+{
+   int err;
+   pt_heap_t*     pheap = (pt_heap_t*) tinst->addr;
+   dheap_node_t * node;
+   uint32_t       seed  = tinst->tid;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      err = remove_dheap(&pheap->dheap, &node);
+      if (err) return err;
+      ((pt_node_t*)node)->key -= pt_nextdelta(&seed);
+      err = insert_dheap(&pheap->dheap, node);
+      if (err) return err;
+   }
+
+   return 0;
+}
+
+/* function: pt_run_heap
+ * Same as <pt_run_dheap> but uses <heap_t>. */
+static int pt_run_heap(perftest_instance_t* tinst)
+{
+   int err;
+   pt_heap_t*     pheap = (pt_heap_t*) tinst->addr;
+   uint64_t       elem;
+   uint32_t       seed  = tinst->tid;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      err = remove_heap(&pheap->heap, &elem);
+      if (err) return err;
+      elem -= pt_nextdelta(&seed);
+      err = insert_heap(&pheap->heap, &elem);
+      if (err) return err;
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_dheap(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_dheap, &pt_run_dheap, &pt_unprepare),
+               "Remove top and reinsert in a heap of 65536 nodes",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_dheap_heap(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_heap, &pt_run_heap, &pt_unprepare),
+               "Remove top and reinsert in a heap of 65536 nodes",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+typedef struct testnode_t {
+   dheap_node_t   node;
+   int            key;
+} testnode_t;
+
+static int compare_node(void * cmpstate, const dheap_node_t * left, const dheap_node_t * right)
+{
+   if (cmpstate) ++ *(size_t*)cmpstate;
+   int l = ((const testnode_t*)left)->key;
+   int r = ((const testnode_t*)right)->key;
+   return (l < r) ? -1 : (l > r) ? +1 : 0;
+}
+
+static int compare_node_revert(void * cmpstate, const dheap_node_t * left, const dheap_node_t * right)
+{
+   return compare_node(cmpstate, right, left);
+}
+
+static inline uint32_t nextrandom(uint32_t * seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return *seed >> 8;
+}
+
+static int test_initfree(void)
+{
+   dheap_t     heap = dheap_FREE;
+   testnode_t  node = { dheap_node_INIT, 0 };
+   size_t      cmpcount = 0;
+
+   // TEST dheap_node_INIT
+   TEST(0 == node.node.index);
+
+   // TEST dheap_FREE
+   TEST(0 == heap.cmp);
+   TEST(0 == heap.cmpstate);
+   TEST(0 == heap.array);
+   TEST(0 == heap.nrofelem);
+   TEST(0 == heap.capacity);
+   TEST(0 == heap.mem);
+   TEST(0 == heap.memsize);
+
+   // TEST init_dheap: capacity == 0
+   TEST(0 == init_dheap(&heap, 0, &compare_node, &cmpcount));
+   TEST(heap.cmp      == &compare_node);
+   TEST(heap.cmpstate == &cmpcount);
+   TEST(heap.array    == 0);
+   TEST(heap.nrofelem == 0);
+   TEST(heap.capacity == 0);
+   TEST(heap.mem      == 0);
+   TEST(heap.memsize  == 0);
+
+   // TEST free_dheap
+   TEST(0 == free_dheap(&heap));
+   TEST(heap.array    == 0);
+   TEST(heap.nrofelem == 0);
+   TEST(heap.capacity == 0);
+   TEST(heap.mem      == 0);
+   TEST(heap.memsize  == 0);
+
+   // TEST init_dheap: capacity > 0
+   for (size_t capacity = 1; capacity <= 1000; capacity = 3*capacity+1) {
+      TEST(0 == init_dheap(&heap, capacity, &compare_node_revert, 0));
+      TEST(heap.cmp      == &compare_node_revert);
+      TEST(heap.cmpstate == 0);
+      TEST(heap.array    != 0);
+      TEST(heap.nrofelem == 0);
+      TEST(heap.capacity == capacity);
+      TEST(heap.mem      != 0);
+      TEST(heap.memsize  >= (capacity + NRALIGNSLOTS) * sizeof(dheap_node_t*));
+      // array[1] is aligned to a cache line
+      TEST(0 == (uintptr_t)&heap.array[1] % CACHELINESIZE);
+      TEST((void*)heap.array >= heap.mem);
+      TEST((uint8_t*)&heap.array[capacity] <= (uint8_t*)heap.mem + heap.memsize);
+
+      // TEST free_dheap: double free
+      TEST(0 == free_dheap(&heap));
+      TEST(heap.array    == 0);
+      TEST(heap.capacity == 0);
+      TEST(heap.mem      == 0);
+      TEST(heap.memsize  == 0);
+      TEST(0 == free_dheap(&heap));
+      TEST(heap.mem      == 0);
+   }
+
+   // TEST init_dheap: EINVAL
+   TEST(EINVAL == init_dheap(&heap, 0, 0, 0));
+
+   // TEST init_dheap: ENOMEM
+   init_testerrortimer(&s_dheap_errtimer, 1, ENOMEM);
+   memset(&heap, 0, sizeof(heap));
+   TEST(ENOMEM == init_dheap(&heap, 1, &compare_node, 0));
+   TEST(0 == heap.cmp);
+   TEST(0 == heap.mem);
+   TEST(ENOMEM == init_dheap(&heap, SIZE_MAX, &compare_node, 0));
+   TEST(0 == heap.cmp);
+   TEST(0 == heap.mem);
+
+   // TEST free_dheap: ENOMEM
+   TEST(0 == init_dheap(&heap, 1, &compare_node, 0));
+   init_testerrortimer(&s_dheap_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == free_dheap(&heap));
+   TEST(heap.array    == 0);
+   TEST(heap.capacity == 0);
+   TEST(heap.mem      == 0);
+   TEST(heap.memsize  == 0);
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_dheap_errtimer);
+   free_dheap(&heap);
+   return EINVAL;
+}
+
+static int test_query(void)
+{
+   dheap_t        heap = dheap_FREE;
+   testnode_t     node[10];
+   dheap_node_t * array[10];
+
+   // prepare
+   for (unsigned i = 0; i < lengthof(node); ++i) {
+      node[i].node.index = i;
+      node[i].key  = (int) (lengthof(node) - i);
+      array[i]     = &node[i].node;
+   }
+   heap.cmp   = &compare_node;
+   heap.array = array;
+
+   // TEST nrofelem_dheap
+   for (size_t i = 1; i; i <<= 1) {
+      heap.nrofelem = i;
+      TEST(i == nrofelem_dheap(&heap));
+   }
+   heap.nrofelem = 0;
+   TEST(0 == nrofelem_dheap(&heap));
+
+   // TEST capacity_dheap
+   for (size_t i = 1; i; i <<= 1) {
+      heap.capacity = i;
+      TEST(i == capacity_dheap(&heap));
+   }
+   heap.capacity = 0;
+   TEST(0 == capacity_dheap(&heap));
+
+   // TEST top_dheap
+   TEST(0 == top_dheap(&heap));
+   for (unsigned i = 0; i < lengthof(node); ++i) {
+      heap.array = &array[i];
+      heap.nrofelem = 1;
+      TEST(&node[i].node == top_dheap(&heap));
+   }
+   heap.array = array;
+
+   // TEST invariant_dheap
+   heap.nrofelem = lengthof(node);
+   heap.capacity = lengthof(node);
+   TEST(0 == invariant_dheap(&heap));
+   heap.nrofelem = 0;
+   TEST(0 == invariant_dheap(&heap));
+
+   // TEST invariant_dheap: nrofelem > capacity
+   heap.nrofelem = lengthof(node) + 1;
+   TEST(EINVARIANT == invariant_dheap(&heap));
+   heap.nrofelem = lengthof(node);
+
+   // TEST invariant_dheap: wrong index
+   for (unsigned i = 0; i < lengthof(node); ++i) {
+      node[i].node.index = i + 1;
+      TEST(EINVARIANT == invariant_dheap(&heap));
+      node[i].node.index = i;
+   }
+   TEST(0 == invariant_dheap(&heap));
+
+   // TEST invariant_dheap: child > parent
+   for (unsigned i = 1; i < lengthof(node); ++i) {
+      node[i].key += (int) lengthof(node);
+      TEST(EINVARIANT == invariant_dheap(&heap));
+      node[i].key -= (int) lengthof(node);
+   }
+   TEST(0 == invariant_dheap(&heap));
+
+   // TEST invariant_dheap: child == parent
+   for (unsigned i = 1; i < lengthof(node); ++i) {
+      node[i].key = node[0].key;
+   }
+   TEST(0 == invariant_dheap(&heap));
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_update(void)
+{
+   dheap_t        heap = dheap_FREE;
+   memblock_t     mem  = memblock_FREE;
+   const unsigned NRNODES = 1000;
+   testnode_t   * node;
+   dheap_node_t * removed;
+   uint32_t       seed = 1;
+
+   // prepare
+   TEST(0 == ALLOC_MM(NRNODES * sizeof(testnode_t), &mem));
+   node = (testnode_t*) mem.addr;
+
+   // TEST insert_dheap: ascending, descending, random order
+   for (unsigned ismin = 0; ismin <= 1; ++ismin) {
+      for (unsigned order = 0; order < 3; ++order) {
+         TEST(0 == init_dheap(&heap, 0, ismin ? &compare_node_revert : &compare_node, 0));
+         for (unsigned i = 0; i < NRNODES; ++i) {
+            node[i].node = (dheap_node_t) dheap_node_INIT;
+            node[i].key  = order == 0 ? (int)i : order == 1 ? (int)(NRNODES-1-i) : (int)(nextrandom(&seed) % NRNODES);
+         }
+         int topkey = node[0].key;
+         for (unsigned i = 0; i < NRNODES; ++i) {
+            TEST(0 == insert_dheap(&heap, &node[i].node));
+            TEST(i+1 == nrofelem_dheap(&heap));
+            TEST(i+1 <= capacity_dheap(&heap));
+            TEST(0 == (uintptr_t)&heap.array[1] % CACHELINESIZE);
+            if (ismin ? node[i].key < topkey : node[i].key > topkey) topkey = node[i].key;
+            TEST(topkey == ((testnode_t*)top_dheap(&heap))->key);
+         }
+         TEST(0 == invariant_dheap(&heap));
+
+         // TEST remove_dheap: returns nodes in sorted order
+         int lastkey = ((testnode_t*)top_dheap(&heap))->key;
+         for (unsigned i = NRNODES; i > 0; --i) {
+            dheap_node_t * top = top_dheap(&heap);
+            TEST(0 == remove_dheap(&heap, &removed));
+            TEST(top == removed);
+            TEST(i-1 == nrofelem_dheap(&heap));
+            int key = ((testnode_t*)removed)->key;
+            TEST(ismin ? key >= lastkey : key <= lastkey);
+            lastkey = key;
+            if (i % 64 == 0) {
+               TEST(0 == invariant_dheap(&heap));
+            }
+         }
+
+         // TEST remove_dheap: ENODATA
+         removed = 0;
+         TEST(ENODATA == remove_dheap(&heap, &removed));
+         TEST(0 == removed);
+         TEST(0 == top_dheap(&heap));
+
+         TEST(0 == free_dheap(&heap));
+      }
+   }
+
+   // prepare
+   TEST(0 == init_dheap(&heap, NRNODES, &compare_node, 0));
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      node[i].node = (dheap_node_t) dheap_node_INIT;
+      node[i].key  = (int) (nextrandom(&seed) % NRNODES);
+      TEST(0 == insert_dheap(&heap, &node[i].node));
+   }
+   TEST(NRNODES == capacity_dheap(&heap));
+
+   // TEST increasekey_dheap
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      unsigned n = nextrandom(&seed) % NRNODES;
+      node[n].key += (int) (nextrandom(&seed) % NRNODES);
+      TEST(0 == increasekey_dheap(&heap, &node[n].node));
+      TEST(&node[n].node == heap.array[node[n].node.index]);
+      if (i % 64 == 0) {
+         TEST(0 == invariant_dheap(&heap));
+      }
+   }
+   TEST(0 == invariant_dheap(&heap));
+
+   // TEST decreasekey_dheap
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      unsigned n = nextrandom(&seed) % NRNODES;
+      node[n].key -= (int) (nextrandom(&seed) % NRNODES);
+      TEST(0 == decreasekey_dheap(&heap, &node[n].node));
+      TEST(&node[n].node == heap.array[node[n].node.index]);
+      if (i % 64 == 0) {
+         TEST(0 == invariant_dheap(&heap));
+      }
+   }
+   TEST(0 == invariant_dheap(&heap));
+
+   // TEST update_dheap
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      unsigned n = nextrandom(&seed) % NRNODES;
+      node[n].key = (int) (nextrandom(&seed) % NRNODES);
+      TEST(0 == update_dheap(&heap, &node[n].node));
+      if (i % 64 == 0) {
+         TEST(0 == invariant_dheap(&heap));
+      }
+   }
+   TEST(0 == invariant_dheap(&heap));
+
+   // TEST removenode_dheap
+   for (unsigned i = NRNODES; i > 0; --i) {
+      unsigned n = nextrandom(&seed) % NRNODES;
+      while (! isstored_dheap(&heap, &node[n].node)) {
+         n = (n + 1) % NRNODES;
+      }
+      TEST(0 == removenode_dheap(&heap, &node[n].node));
+      TEST(i-1 == nrofelem_dheap(&heap));
+      TEST(! isstored_dheap(&heap, &node[n].node));
+      if (i % 64 == 0) {
+         TEST(0 == invariant_dheap(&heap));
+      }
+   }
+   TEST(0 == top_dheap(&heap));
+
+   // TEST removenode_dheap, increasekey_dheap, decreasekey_dheap, update_dheap: EINVAL
+   node[0].node.index = 0;
+   TEST(EINVAL == removenode_dheap(&heap, &node[0].node));
+   TEST(EINVAL == increasekey_dheap(&heap, &node[0].node));
+   TEST(EINVAL == decreasekey_dheap(&heap, &node[0].node));
+   TEST(EINVAL == update_dheap(&heap, &node[0].node));
+   TEST(0 == insert_dheap(&heap, &node[1].node));
+   TEST(0 == node[1].node.index);
+   TEST(EINVAL == removenode_dheap(&heap, &node[0].node));
+   TEST(EINVAL == increasekey_dheap(&heap, &node[0].node));
+   TEST(EINVAL == decreasekey_dheap(&heap, &node[0].node));
+   TEST(EINVAL == update_dheap(&heap, &node[0].node));
+   TEST(0 == removenode_dheap(&heap, &node[1].node));
+   TEST(0 == nrofelem_dheap(&heap));
+   TEST(0 == free_dheap(&heap));
+
+   // TEST insert_dheap: ENOMEM
+   TEST(0 == init_dheap(&heap, 1, &compare_node, 0));
+   TEST(0 == insert_dheap(&heap, &node[0].node));
+   init_testerrortimer(&s_dheap_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == insert_dheap(&heap, &node[1].node));
+   TEST(1 == nrofelem_dheap(&heap));
+   TEST(1 == capacity_dheap(&heap));
+   TEST(&node[0].node == top_dheap(&heap));
+   // growth doubles capacity and preserves content
+   TEST(0 == insert_dheap(&heap, &node[1].node));
+   TEST(2 == nrofelem_dheap(&heap));
+   TEST(2 == capacity_dheap(&heap));
+   TEST(0 == invariant_dheap(&heap));
+   TEST(0 == free_dheap(&heap));
+
+   // unprepare
+   TEST(0 == FREE_MM(&mem));
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_dheap_errtimer);
+   free_dheap(&heap);
+   FREE_MM(&mem);
+   return EINVAL;
+}
+
+static int test_comparecount(void)
+{
+   dheap_t        heap = dheap_FREE;
+   testnode_t     node[1024];
+   dheap_node_t * removed;
+   size_t         cmpcount = 0;
+   uint32_t       seed = 3;
+
+   // TEST remove_dheap: uses at most ARITY comparisons per level
+   TEST(0 == init_dheap(&heap, lengthof(node), &compare_node, &cmpcount));
+   for (unsigned i = 0; i < lengthof(node); ++i) {
+      node[i].node = (dheap_node_t) dheap_node_INIT;
+      node[i].key  = (int) (nextrandom(&seed) % lengthof(node));
+      TEST(0 == insert_dheap(&heap, &node[i].node));
+   }
+   // height of tree with 1024 nodes is 5 (1+4+16+64+256+1024 > 1024)
+   cmpcount = 0;
+   TEST(0 == remove_dheap(&heap, &removed));
+   TEST(cmpcount <= 5 * dheap_ARITY);
+
+   // TEST increasekey_dheap: uses at most 1 comparison per level
+   for (unsigned i = 0; i < lengthof(node); ++i) {
+      if (node[i].node.index == nrofelem_dheap(&heap)-1) {
+         node[i].key = INT32_MAX;
+         cmpcount = 0;
+         TEST(0 == increasekey_dheap(&heap, &node[i].node));
+         TEST(cmpcount <= 5);
+         TEST(&node[i].node == top_dheap(&heap));
+         break;
+      }
+   }
+
+   TEST(0 == invariant_dheap(&heap));
+   TEST(0 == free_dheap(&heap));
+
+   return 0;
+ONERR:
+   free_dheap(&heap);
+   return EINVAL;
+}
+
+int unittest_ds_inmem_dheap()
+{
+   if (test_initfree())       goto ONERR;
+   if (test_query())          goto ONERR;
+   if (test_update())         goto ONERR;
+   if (test_comparecount())   goto ONERR;
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+#endif
@@ -24,6 +24,10 @@
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/test/errortimer.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: dlist_t
@@ -200,6 +204,166 @@ void insertlastPlist_dlist(dlist_t * list, dlist_t * nodes)
 
 // section: Functions
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRELEM
+ * Number of nodes inserted, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRELEM       (1024*1024)
+
+/* define: PT_NRELEM_SMALL
+ * Number of nodes stored at the same time in <perftest_ds_inmem_dlist_small>.
+ * The nodes are inserted and removed <PT_NRELEM>/<PT_NRELEM_SMALL> times. */
+#define PT_NRELEM_SMALL 1024
+
+typedef struct pt_object_t {
+   dlist_node_t   node;
+   uint64_t       value;
+} pt_object_t;
+
+dlist_IMPLEMENT(_ptlist, pt_object_t, node.)
+
+/* struct: pt_lifecycle_t
+ * List and nodes used by a single instance of a lifecycle perftest.
+ * Nodes are removed in the order given by array remove. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   dlist_t        list;
+   size_t         nrelem;
+   size_t         nrloop;
+   uint64_t       valuesum;
+   pt_object_t ** remove;
+   pt_object_t    object[/*nrelem*/];
+} pt_lifecycle_t;
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrelem, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+   uint32_t         seed = 1;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrelem * (sizeof(pt_object_t) + sizeof(pt_object_t*)));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage   = vmpage;
+   init_ptlist(&plc->list);
+   plc->nrelem   = nrelem;
+   plc->nrloop   = PT_NRELEM / nrelem;
+   plc->valuesum = 0;
+   plc->remove   = (pt_object_t**) &plc->object[nrelem];
+
+   for (size_t i = 0; i < nrelem; ++i) {
+      plc->object[i].node  = (dlist_node_t) dlist_node_INIT;
+      plc->object[i].value = i;
+      plc->valuesum += i;
+      plc->remove[i] = &plc->object[i];
+   }
+
+   if (israndom) {
+      // shuffle remove order
+      for (size_t i = nrelem-1; i > 0; --i) {
+         seed = seed * 1103515245 + 12345;
+         size_t j = (seed >> 8) % (i+1);
+         pt_object_t * node = plc->remove[i];
+         plc->remove[i] = plc->remove[j];
+         plc->remove[j] = node;
+      }
+   }
+
+   tinst->nrops = PT_NRELEM;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   // list and nodes are part of vmpage
+   return free_vmpage(&vmpage);
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrelem; ++i) {
+         insertlast_ptlist(&plc->list, &plc->object[i]);
+      }
+
+      uint64_t valuesum = 0;
+      foreach (_ptlist, next, &plc->list) {
+         valuesum += next->value;
+      }
+      if (valuesum != plc->valuesum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrelem; ++i) {
+         remove_ptlist(&plc->list, plc->remove[i]);
+      }
+      if (!isempty_ptlist(&plc->list)) return EINVAL;
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_dlist_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single node of 1M nodes in FIFO order",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_dlist_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single node of 1M nodes in random order",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_dlist_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single node of 1K nodes in random order",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -27,6 +27,10 @@
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/unittest.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: exthash_t
@@ -534,6 +538,351 @@ bool next_exthashiterator(exthash_iterator_t * iter, /*out*/exthash_node_t ** no
 
 // section: exthash_t
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NROPS
+ * Number of lookups executed by every perftest instance. */
+#define PT_NROPS     1000000
+
+/* define: PT_NRNODES
+ * Number of nodes stored in the table of every perftest instance. */
+#define PT_NRNODES   65536
+
+typedef struct pt_object_t pt_object_t;
+
+typeadapt_DECLARE(pt_adapt_t, pt_object_t, uintptr_t);
+
+struct pt_object_t {
+   size_t         key;
+   exthash_node_t node;
+};
+
+/* struct: pt_table_t
+ * Table and nodes used by a single perftest instance. */
+typedef struct pt_table_t {
+   pt_adapt_t     typeadapt;
+   exthash_t      htable;
+   pt_object_t    object[PT_NRNODES];
+} pt_table_t;
+
+static int pt_cmpkeyobj(pt_adapt_t * typeadp, const uintptr_t lkey, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+static int pt_cmpobj(pt_adapt_t * typeadp, const pt_object_t * lobject, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lobject->key == robject->key ? 0 : lobject->key < robject->key ? -1 : +1;
+}
+
+static size_t pt_hashobj(pt_adapt_t * typeadp, const pt_object_t * object)
+{
+   (void) typeadp;
+   return object->key;
+}
+
+static size_t pt_hashkey(pt_adapt_t * typeadp, const uintptr_t key)
+{
+   (void) typeadp;
+   return key;
+}
+
+static inline int pt_cmpkeyobj_inline(const uintptr_t lkey, const pt_object_t * robject)
+{
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+static inline size_t pt_hashkey_inline(const uintptr_t key)
+{
+   return key;
+}
+
+exthash_IMPLEMENT(_pthash, pt_object_t, uintptr_t, node)
+
+exthash_IMPLEMENTCMP(_pthashcmp, pt_object_t, uintptr_t, node, pt_cmpkeyobj_inline, pt_hashkey_inline)
+
+/* function: pt_nextkey
+ * Returns a pseudo random key. Keys in range [0..<PT_NRNODES>-1] are stored in the table.
+ * About 90% of all returned keys are found. */
+static inline uintptr_t pt_nextkey(uint32_t * seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return (*seed >> 8) % (PT_NRNODES + PT_NRNODES/9);
+}
+
+static int pt_prepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t   mblock = memblock_FREE;
+   pt_table_t * table  = 0;
+
+   err = ALLOC_MM(sizeof(pt_table_t), &mblock);
+   if (err) goto ONERR;
+
+   table = (pt_table_t*) mblock.addr;
+   table->typeadapt = (pt_adapt_t) typeadapt_INIT_LIFECMPHASH(0, 0, &pt_cmpkeyobj, &pt_cmpobj, &pt_hashobj, &pt_hashkey);
+   table->htable    = (exthash_t) exthash_FREE;
+
+   typeadapt_member_t nodeadp = typeadapt_member_INIT(cast_typeadapt(&table->typeadapt, pt_adapt_t, pt_object_t, uintptr_t), offsetof(pt_object_t, node));
+   err = init_pthash(&table->htable, PT_NRNODES, PT_NRNODES, &nodeadp);
+   if (err) goto ONERR;
+
+   for (size_t i = 0; i < PT_NRNODES; ++i) {
+      table->object[i].key  = i;
+      table->object[i].node = (exthash_node_t) exthash_node_INIT;
+      err = insert_pthash(&table->htable, &table->object[i]);
+      if (err) goto ONERR;
+   }
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   if (table) {
+      (void) free_pthash(&table->htable);
+      (void) FREE_MM(&mblock);
+   }
+   return err;
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t   mblock = memblock_INIT(tinst->size, tinst->addr);
+   pt_table_t * table  = (pt_table_t*) tinst->addr;
+
+   // nodes are not deleted (delete_object == 0)
+   err = free_pthash(&table->htable);
+   int err2 = FREE_MM(&mblock);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run(perftest_instance_t* tinst)
+{
+   pt_table_t  * table   = (pt_table_t*) tinst->addr;
+   pt_object_t * node;
+   uint32_t      seed    = tinst->tid;
+   size_t        nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      uintptr_t key = pt_nextkey(&seed);
+      if (0 == find_pthash(&table->htable, key, &node)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+static int pt_run_cmp(perftest_instance_t* tinst)
+{
+   pt_table_t  * table   = (pt_table_t*) tinst->addr;
+   pt_object_t * node;
+   uint32_t      seed    = tinst->tid;
+   size_t        nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      uintptr_t key = pt_nextkey(&seed);
+      if (0 == find_pthashcmp(&table->htable, key, &node)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+int perftest_ds_inmem_exthash(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run, &pt_unprepare),
+               "Searching a key in a table of 65536 nodes (90% hits) with exthash_IMPLEMENT",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_exthash_cmp(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run_cmp, &pt_unprepare),
+               "Searching a key in a table of 65536 nodes (90% hits) with exthash_IMPLEMENTCMP",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+/* define: PT_NRKEYS
+ * Number of keys inserted, searched, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRKEYS       (1024*1024)
+
+/* define: PT_NRKEYS_SMALL
+ * Number of keys stored at the same time in <perftest_ds_inmem_exthash_small>.
+ * The keys are inserted and removed <PT_NRKEYS>/<PT_NRKEYS_SMALL> times. */
+#define PT_NRKEYS_SMALL 1024
+
+/* struct: pt_lifecycle_t
+ * Table and nodes used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   pt_adapt_t     typeadapt;
+   exthash_t      htable;
+   size_t         nrkeys;
+   size_t         nrloop;
+   uintptr_t      keysum;
+   pt_object_t    object[/*nrkeys*/];
+} pt_lifecycle_t;
+
+/* function: pt_randomkey
+ * Returns a pseudo random key computed from i. Different values of i result in different keys. */
+static inline uintptr_t pt_randomkey(uintptr_t i)
+{
+   uintptr_t key = i * (uintptr_t) 0x9e3779b97f4a7c15;
+   return key ^ (key >> 29);
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrkeys, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrkeys * sizeof(pt_object_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage    = vmpage;
+   plc->typeadapt = (pt_adapt_t) typeadapt_INIT_LIFECMPHASH(0, 0, &pt_cmpkeyobj, &pt_cmpobj, &pt_hashobj, &pt_hashkey);
+   typeadapt_member_t nodeadp = typeadapt_member_INIT(cast_typeadapt(&plc->typeadapt, pt_adapt_t, pt_object_t, uintptr_t), offsetof(pt_object_t, node));
+   err = init_pthash(&plc->htable, nrkeys, nrkeys, &nodeadp);
+   if (err) goto ONERR;
+   plc->nrkeys = nrkeys;
+   plc->nrloop = PT_NRKEYS / nrkeys;
+   plc->keysum = 0;
+
+   for (size_t i = 0; i < nrkeys; ++i) {
+      plc->object[i].key  = israndom ? pt_randomkey(i) : i;
+      plc->object[i].node = (exthash_node_t) exthash_node_INIT;
+      plc->keysum += plc->object[i].key;
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+ONERR:
+   (void) free_vmpage(&vmpage);
+   return err;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   // nodes are not deleted (delete_object == 0)
+   err = free_pthash(&plc->htable);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   pt_object_t    * node;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = insert_pthash(&plc->htable, &plc->object[i]);
+         if (err) return err;
+      }
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = find_pthash(&plc->htable, plc->object[i].key, &node);
+         if (err) return err;
+         if (node != &plc->object[i]) return EINVAL;
+      }
+
+      uintptr_t keysum = 0;
+      foreach (_pthash, next, &plc->htable) {
+         keysum += next->key;
+      }
+      if (keysum != plc->keysum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = remove_pthash(&plc->htable, &plc->object[i]);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_exthash_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M sequential keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_exthash_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_exthash_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1K random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -1118,6 +1467,78 @@ ONERR:
    return EINVAL ;
 }
 
+static inline int test_cmpkeyobj_inline(const uintptr_t lkey, const testobject_t * robject)
+{
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1 ;
+}
+
+static inline size_t test_hashkey_inline(const uintptr_t key)
+{
+   return (size_t) key ;
+}
+
+exthash_IMPLEMENTCMP(_testhashcmp, testobject_t, uintptr_t, node, test_cmpkeyobj_inline, test_hashkey_inline)
+
+static int test_genericcmp(void)
+{
+   exthash_t            htable    = exthash_FREE ;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt) ;
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node)) ;
+   testobject_t         nodes[1024] ;
+   testobject_t       * found_node ;
+   testobject_t       * found_node2 ;
+
+   // prepare
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].deletecount = 0 ;
+      nodes[i].key  = 3*i ;
+      nodes[i].node = (exthash_node_t) exthash_node_INIT ;
+   }
+
+   // TEST find_testhashcmp: empty table
+   TEST(0 == init_testhashcmp(&htable, 1, 4*lengthof(nodes), &nodeadp)) ;
+   TEST(ESRCH == find_testhashcmp(&htable, 0, &found_node)) ;
+
+   // TEST find_testhashcmp: same result as find_exthash (table grows and contains shared entries)
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_testhashcmp(&htable, &nodes[i])) ;
+      for (uintptr_t key = 0; key <= 3*i+1; key += (i < 64 ? 1 : 7)) {
+         found_node  = 0 ;
+         found_node2 = 0 ;
+         int err = find_testhashcmp(&htable, key, &found_node) ;
+         TEST(err == (key % 3 ? ESRCH : 0)) ;
+         TEST(err == find_testhash(&htable, key, &found_node2)) ;
+         TEST(found_node == found_node2) ;
+         if (!err) TEST(found_node == &nodes[key/3]) ;
+      }
+   }
+   TEST(0 == invariant_testhashcmp(&htable)) ;
+
+   // TEST find_testhashcmp: removed nodes are not found
+   for (unsigned i = 0; i < lengthof(nodes); i += 2) {
+      TEST(0 == remove_testhashcmp(&htable, &nodes[i])) ;
+   }
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      found_node = 0 ;
+      if (i % 2) {
+         TEST(0 == find_testhashcmp(&htable, nodes[i].key, &found_node)) ;
+         TEST(found_node == &nodes[i]) ;
+      } else {
+         TEST(ESRCH == find_testhashcmp(&htable, nodes[i].key, &found_node)) ;
+         TEST(0 == found_node) ;
+      }
+   }
+
+   // unprepare
+   TEST(0 == removenodes_testhashcmp(&htable)) ;
+   TEST(0 == free_testhashcmp(&htable)) ;
+
+   return 0 ;
+ONERR:
+   free_exthash(&htable) ;
+   return EINVAL ;
+}
+
 int unittest_ds_inmem_exthash()
 {
    if (test_initfree())          goto ONERR;
@@ -1125,6 +1546,7 @@ int unittest_ds_inmem_exthash()
    if (test_privchange())        goto ONERR;
    if (test_findinsertremove())  goto ONERR;
    if (test_generic())           goto ONERR;
+   if (test_genericcmp())        goto ONERR;
 
    return 0 ;
 ONERR:
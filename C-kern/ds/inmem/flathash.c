@@ -0,0 +1,1316 @@
+/* title: Flat-Hashing impl
+
+   Implements <Flat-Hashing>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/flathash.h
+    Header file <Flat-Hashing>.
+
+   file: C-kern/ds/inmem/flathash.c
+    Implementation file <Flat-Hashing impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/ds/typeadapt.h"
+#include "C-kern/api/ds/inmem/flathash.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/ds/inmem/exthash.h"
+#include "C-kern/api/test/perftest.h"
+#endif
+
+
+// section: flathash_t
+
+// group: description
+
+/* about: Algorithm
+ *
+ * Layout:
+ * The table consists of an array of slots and an array of control bytes.
+ * > slot: | node* | node* |  0    | node* | ... | node* |
+ * > ctrl: |  h2   |  h2   | EMPTY |  h2   | ... |  h2   | mirror of ctrl[0..15] |
+ * A slot is in use if the highest bit of its control byte is cleared.
+ *
+ * Probing:
+ * The hash value computed by <typeadapt_gethash_it> is mixed with <mixhash_flathash>.
+ * The bits above the lowest 7 bits (h1) determine the first probed position.
+ * The 16 control bytes beginning at this position are compared with the lowest 7 bits (h2).
+ * Every match is compared with the searched key. If the group contains no match and at least one
+ * <flathash_EMPTY> byte the search ends. Otherwise the next group is probed at position
+ * pos + 16, pos + 16 + 32, pos + 16 + 32 + 48, ... (triangular probing) modulo capacity.
+ * Cause capacity / 16 is a power of two every group is probed before the sequence repeats.
+ *
+ * Removing:
+ * A removed slot is marked with <flathash_DELETED> so that other nodes probed past the slot are
+ * still found. If no group which contains the slot could have been full the slot is marked with
+ * <flathash_EMPTY> instead.
+ *
+ * Growing:
+ * At most 7/8 of all slots could be used or deleted. If no <flathash_EMPTY> slot is left
+ * (see <flathash_t.growthleft>) all nodes are moved into a new table. The new table has
+ * the same capacity if less than half of the slots are used else double the capacity.
+ * */
+
+// group: helper
+
+/* define: KEYCOMPARE
+ * Compares key with the object containing node. */
+#define KEYCOMPARE(key, node)    callcmpkeyobj_typeadaptmember(&htable->nodeadp, key, cast2object_typeadaptmember(&htable->nodeadp, node))
+
+/* define: OBJCOMPARE
+ * Compares the two objects containing lnode and rnode. */
+#define OBJCOMPARE(lnode, rnode) callcmpobj_typeadaptmember(&htable->nodeadp, cast2object_typeadaptmember(&htable->nodeadp, lnode), cast2object_typeadaptmember(&htable->nodeadp, rnode))
+
+/* function: mixhash_flathash
+ * Mixes the bits of hashvalue. Hash functions of integer keys are often the identity function.
+ * Their low bits are not distributed well enough to be used as h2 and the
+ * bits of h1 would select the same groups for neighbouring keys.
+ * The finalizer of MurmurHash3 is used. */
+static inline size_t mixhash_flathash(size_t hashvalue)
+{
+#if (SIZE_MAX > UINT32_MAX)
+   uint64_t h = hashvalue;
+   h ^= h >> 33;
+   h *= UINT64_C(0xff51afd7ed558ccd);
+   h ^= h >> 33;
+   h *= UINT64_C(0xc4ceb9fe1a85ec53);
+   h ^= h >> 33;
+#else
+   uint32_t h = hashvalue;
+   h ^= h >> 16;
+   h *= UINT32_C(0x85ebca6b);
+   h ^= h >> 13;
+   h *= UINT32_C(0xc2b2ae35);
+   h ^= h >> 16;
+#endif
+   return (size_t) h;
+}
+
+/* function: h1_flathash
+ * Returns the part of the mixed hash value which selects the first probed position. */
+static inline size_t h1_flathash(size_t mixed)
+{
+   return mixed >> 7;
+}
+
+/* function: h2_flathash
+ * Returns the part of the mixed hash value which is stored as control byte. */
+static inline uint8_t h2_flathash(size_t mixed)
+{
+   return (uint8_t) (mixed & 0x7f);
+}
+
+/* function: isused_flathash
+ * Returns true if the control byte marks a used slot. */
+static inline bool isused_flathash(uint8_t ctrl)
+{
+   return 0 == (ctrl & 0x80);
+}
+
+/* function: maxload_flathash
+ * Returns the number of slots which could be used or deleted before the table must grow. */
+static inline size_t maxload_flathash(size_t capacity)
+{
+   return capacity - capacity / 8;
+}
+
+/* function: sizeoftable_flathash
+ * Returns the size in bytes of the memory block which contains slots and control bytes. */
+static inline size_t sizeoftable_flathash(size_t capacity)
+{
+   return capacity * (sizeof(flathash_node_t*) + 1) + flathash_GROUPSIZE;
+}
+
+// group: group-matching
+
+/* function: matchbyte_flathash
+ * Returns bitmask of all control bytes in group which are equal to byte.
+ * Bit i (value 1<<i) is set if group[i] == byte.
+ * If the target supports SSE2 all 16 bytes are compared with a single instruction. */
+static inline uint32_t matchbyte_flathash(const uint8_t * group, uint8_t byte)
+{
+#ifdef __SSE2__
+   __m128i ctrl = _mm_loadu_si128((const __m128i*) group);
+   return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) byte)));
+#else
+   uint32_t mask = 0;
+   for (unsigned i = 0; i < flathash_GROUPSIZE; ++i) {
+      mask |= (uint32_t) (group[i] == byte) << i;
+   }
+   return mask;
+#endif
+}
+
+/* function: matchempty_flathash
+ * Returns bitmask of all control bytes in group equal to <flathash_EMPTY>. */
+static inline uint32_t matchempty_flathash(const uint8_t * group)
+{
+   return matchbyte_flathash(group, flathash_EMPTY);
+}
+
+/* function: matchunused_flathash
+ * Returns bitmask of all control bytes in group equal to <flathash_EMPTY> or <flathash_DELETED>.
+ * Both values have the highest bit set. */
+static inline uint32_t matchunused_flathash(const uint8_t * group)
+{
+#ifdef __SSE2__
+   __m128i ctrl = _mm_loadu_si128((const __m128i*) group);
+   return (uint32_t) _mm_movemask_epi8(ctrl);
+#else
+   uint32_t mask = 0;
+   for (unsigned i = 0; i < flathash_GROUPSIZE; ++i) {
+      mask |= (uint32_t) (group[i] >> 7) << i;
+   }
+   return mask;
+#endif
+}
+
+// group: probing
+
+/* function: setctrl_flathash
+ * Sets control byte at index and its mirror if index < <flathash_GROUPSIZE>. */
+static inline void setctrl_flathash(uint8_t * ctrl, size_t capacity, size_t index, uint8_t value)
+{
+   ctrl[index] = value;
+   if (index < flathash_GROUPSIZE) {
+      ctrl[capacity + index] = value;
+   }
+}
+
+/* function: findunused_flathash
+ * Returns index of first <flathash_EMPTY> or <flathash_DELETED> slot in the probe sequence of mixed. */
+static inline size_t findunused_flathash(const uint8_t * ctrl, size_t capacity, size_t mixed)
+{
+   const size_t mask = capacity - 1;
+   size_t       pos  = h1_flathash(mixed) & mask;
+
+   for (size_t step = flathash_GROUPSIZE; ; step += flathash_GROUPSIZE) {
+      uint32_t match = matchunused_flathash(ctrl + pos);
+      if (match) return (pos + (unsigned) __builtin_ctz(match)) & mask;
+      pos = (pos + step) & mask;
+   }
+}
+
+/* function: findnode_flathash
+ * Returns true and index of slot which contains node. The control byte of the slot must match
+ * the mixed hash value stored in node. */
+static inline bool findnode_flathash(const flathash_t * htable, const flathash_node_t * node, /*out*/size_t * index)
+{
+   const size_t  mixed = mixhash_flathash(node->hashvalue);
+   const uint8_t h2    = h2_flathash(mixed);
+   const size_t  mask  = htable->capacity - 1;
+   size_t        pos   = h1_flathash(mixed) & mask;
+
+   if (!htable->capacity) return false;
+
+   for (size_t step = flathash_GROUPSIZE; ; step += flathash_GROUPSIZE) {
+      const uint8_t * group = htable->ctrl + pos;
+      for (uint32_t match = matchbyte_flathash(group, h2); match; match &= match-1) {
+         size_t idx = (pos + (unsigned) __builtin_ctz(match)) & mask;
+         if (htable->slot[idx] == node) {
+            *index = idx;
+            return true;
+         }
+      }
+      if (matchempty_flathash(group)) return false;
+      pos = (pos + step) & mask;
+   }
+}
+
+// group: lifetime
+
+/* function: alloctable_flathash
+ * Allocates slots and control bytes for capacity slots. All slots are marked as <flathash_EMPTY>. */
+static int alloctable_flathash(size_t capacity, /*out*/flathash_node_t *** slot, /*out*/uint8_t ** ctrl)
+{
+   int err;
+   memblock_t mem = memblock_FREE;
+
+   if (capacity > ((size_t)-1 - flathash_GROUPSIZE) / (sizeof(flathash_node_t*) + 1)) {
+      err = ENOMEM;
+      goto ONERR;
+   }
+
+   err = ALLOC_MM(sizeoftable_flathash(capacity), &mem);
+   if (err) goto ONERR;
+
+   *slot = (flathash_node_t**) mem.addr;
+   *ctrl = mem.addr + capacity * sizeof(flathash_node_t*);
+   memset(*slot, 0, capacity * sizeof(flathash_node_t*));
+   memset(*ctrl, flathash_EMPTY, capacity + flathash_GROUPSIZE);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+static int freetable_flathash(flathash_t * htable)
+{
+   int err;
+
+   if (htable->slot) {
+      memblock_t mem = memblock_INIT(sizeoftable_flathash(htable->capacity), (uint8_t*)htable->slot);
+
+      err = FREE_MM(&mem);
+      htable->slot = 0;
+      htable->ctrl = 0;
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+int init_flathash(/*out*/flathash_t * htable, size_t initial_size, const typeadapt_member_t * nodeadp)
+{
+   int err;
+   size_t           capacity = flathash_GROUPSIZE;
+   flathash_node_t ** slot;
+   uint8_t         * ctrl;
+
+   VALIDATE_INPARAM_TEST(initial_size <= ((size_t)-1)/(2*sizeof(void*)), ONERR, );
+
+   while (maxload_flathash(capacity) < initial_size) {
+      capacity *= 2;
+   }
+
+   err = alloctable_flathash(capacity, &slot, &ctrl);
+   if (err) goto ONERR;
+
+   htable->slot       = slot;
+   htable->ctrl       = ctrl;
+   htable->capacity   = capacity;
+   htable->nr_nodes   = 0;
+   htable->growthleft = maxload_flathash(capacity);
+   htable->nodeadp    = *nodeadp;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_flathash(flathash_t * htable)
+{
+   int err;
+
+   if (htable->slot) {
+
+      err = removenodes_flathash(htable);
+
+      int err2 = freetable_flathash(htable);
+      if (err2) err = err2;
+
+      htable->capacity   = 0;
+      htable->growthleft = 0;
+      htable->nodeadp    = (typeadapt_member_t) typeadapt_member_FREE;
+
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: search
+
+int find_flathash(flathash_t * htable, const void * key, /*out*/flathash_node_t ** found_node)
+{
+   if (htable->capacity) {
+      const size_t  hashvalue = callhashkey_typeadaptmember(&htable->nodeadp, key);
+      const size_t  mixed     = mixhash_flathash(hashvalue);
+      const uint8_t h2        = h2_flathash(mixed);
+      const size_t  mask      = htable->capacity - 1;
+      size_t        pos       = h1_flathash(mixed) & mask;
+
+      for (size_t step = flathash_GROUPSIZE; ; step += flathash_GROUPSIZE) {
+         const uint8_t * group = htable->ctrl + pos;
+         for (uint32_t match = matchbyte_flathash(group, h2); match; match &= match-1) {
+            flathash_node_t * node = htable->slot[(pos + (unsigned) __builtin_ctz(match)) & mask];
+            if (node->hashvalue == hashvalue && 0 == KEYCOMPARE(key, node)) {
+               *found_node = node;
+               return 0;
+            }
+         }
+         if (matchempty_flathash(group)) break;
+         pos = (pos + step) & mask;
+      }
+   }
+
+   return ESRCH;
+}
+
+// group: change
+
+/* function: rehash_flathash
+ * Moves all nodes into a new table with capacity slots.
+ * All <flathash_DELETED> slots are removed. */
+static int rehash_flathash(flathash_t * htable, size_t capacity)
+{
+   int err;
+   flathash_node_t ** slot;
+   uint8_t         * ctrl;
+
+   err = alloctable_flathash(capacity, &slot, &ctrl);
+   if (err) goto ONERR;
+
+   for (size_t i = 0; i < htable->capacity; ++i) {
+      if (isused_flathash(htable->ctrl[i])) {
+         flathash_node_t * node  = htable->slot[i];
+         size_t            mixed = mixhash_flathash(node->hashvalue);
+         size_t            idx   = findunused_flathash(ctrl, capacity, mixed);
+         setctrl_flathash(ctrl, capacity, idx, h2_flathash(mixed));
+         slot[idx] = node;
+      }
+   }
+
+   err = freetable_flathash(htable);
+   (void) err; // memory is freed in any case
+
+   htable->slot       = slot;
+   htable->ctrl       = ctrl;
+   htable->capacity   = capacity;
+   htable->growthleft = maxload_flathash(capacity) - htable->nr_nodes;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: growtable_flathash
+ * Removes all <flathash_DELETED> slots or doubles the size of the table.
+ * The capacity is doubled if at least half of the slots are in use. */
+static int growtable_flathash(flathash_t * htable)
+{
+   int err;
+   size_t capacity = htable->capacity;
+
+   if (!capacity) {
+      capacity = flathash_GROUPSIZE;
+   } else if (htable->nr_nodes >= capacity / 2) {
+      if (capacity > ((size_t)-1)/(4*sizeof(void*))) {
+         err = ENOMEM;
+         goto ONERR;
+      }
+      capacity *= 2;
+   }
+
+   err = rehash_flathash(htable, capacity);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int insert_flathash(flathash_t * htable, flathash_node_t * new_node)
+{
+   int err;
+   const size_t hashvalue = callhashobject_typeadaptmember(&htable->nodeadp, cast2object_typeadaptmember(&htable->nodeadp, new_node));
+   const size_t mixed     = mixhash_flathash(hashvalue);
+
+   if (htable->capacity) {
+      const uint8_t h2   = h2_flathash(mixed);
+      const size_t  mask = htable->capacity - 1;
+      size_t        pos  = h1_flathash(mixed) & mask;
+
+      for (size_t step = flathash_GROUPSIZE; ; step += flathash_GROUPSIZE) {
+         const uint8_t * group = htable->ctrl + pos;
+         for (uint32_t match = matchbyte_flathash(group, h2); match; match &= match-1) {
+            flathash_node_t * node = htable->slot[(pos + (unsigned) __builtin_ctz(match)) & mask];
+            if (node->hashvalue == hashvalue && 0 == OBJCOMPARE(new_node, node)) {
+               return EEXIST;
+            }
+         }
+         if (matchempty_flathash(group)) break;
+         pos = (pos + step) & mask;
+      }
+   }
+
+   size_t idx = 0;
+   if (htable->capacity) {
+      idx = findunused_flathash(htable->ctrl, htable->capacity, mixed);
+   }
+
+   if (!htable->capacity || (htable->growthleft == 0 && htable->ctrl[idx] == flathash_EMPTY)) {
+      err = growtable_flathash(htable);
+      if (err) goto ONERR;
+      idx = findunused_flathash(htable->ctrl, htable->capacity, mixed);
+   }
+
+   if (htable->ctrl[idx] == flathash_EMPTY) {
+      -- htable->growthleft;
+   }
+   setctrl_flathash(htable->ctrl, htable->capacity, idx, h2_flathash(mixed));
+   htable->slot[idx]   = new_node;
+   new_node->hashvalue = hashvalue;
+   ++ htable->nr_nodes;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int remove_flathash(flathash_t * htable, flathash_node_t * node)
+{
+   int err;
+   size_t idx;
+
+   if (! findnode_flathash(htable, node, &idx)) {
+      err = ESRCH;
+      goto ONERR;
+   }
+
+   // if no group containing idx could have been full no probe sequence went past idx
+   const size_t   mask        = htable->capacity - 1;
+   const uint32_t emptyafter  = matchempty_flathash(htable->ctrl + idx);
+   const uint32_t emptybefore = matchempty_flathash(htable->ctrl + ((idx - flathash_GROUPSIZE) & mask));
+   const bool     isneverfull = emptyafter && emptybefore
+                                && ((unsigned) __builtin_ctz(emptyafter) + (unsigned) (__builtin_clz(emptybefore) - 16)) < flathash_GROUPSIZE;
+
+   if (isneverfull) {
+      setctrl_flathash(htable->ctrl, htable->capacity, idx, flathash_EMPTY);
+      ++ htable->growthleft;
+   } else {
+      setctrl_flathash(htable->ctrl, htable->capacity, idx, flathash_DELETED);
+   }
+   htable->slot[idx] = 0;
+   -- htable->nr_nodes;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int removenodes_flathash(flathash_t * htable)
+{
+   int err = 0;
+
+   if (htable->capacity) {
+      const bool isDeleteObject = iscalldelete_typeadapt(htable->nodeadp.typeadp);
+
+      for (size_t i = 0; i < htable->capacity; ++i) {
+         if (isused_flathash(htable->ctrl[i])) {
+            flathash_node_t * node = htable->slot[i];
+            htable->slot[i] = 0;
+            if (isDeleteObject) {
+               typeadapt_object_t * object = cast2object_typeadaptmember(&htable->nodeadp, node);
+               int err2 = calldelete_typeadaptmember(&htable->nodeadp, &object);
+               if (err2) err = err2;
+            }
+         }
+      }
+
+      memset(htable->ctrl, flathash_EMPTY, htable->capacity + flathash_GROUPSIZE);
+      htable->nr_nodes   = 0;
+      htable->growthleft = maxload_flathash(htable->capacity);
+   }
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: test
+
+int invariant_flathash(flathash_t * htable)
+{
+   int err;
+   size_t nrused    = 0;
+   size_t nrdeleted = 0;
+
+   if (htable->capacity) {
+      if (  htable->capacity < flathash_GROUPSIZE
+            || (htable->capacity & (htable->capacity-1))) {
+         err = EINVAL;
+         goto ONERR;
+      }
+
+      // mirrored control bytes
+      if (memcmp(htable->ctrl, htable->ctrl + htable->capacity, flathash_GROUPSIZE)) {
+         err = EINVAL;
+         goto ONERR;
+      }
+
+      for (size_t i = 0; i < htable->capacity; ++i) {
+         const uint8_t ctrl = htable->ctrl[i];
+         if (isused_flathash(ctrl)) {
+            size_t idx;
+            flathash_node_t * node = htable->slot[i];
+            ++ nrused;
+            if (  ctrl != h2_flathash(mixhash_flathash(node->hashvalue))
+                  || ! findnode_flathash(htable, node, &idx)
+                  || idx != i) {
+               err = EINVAL;
+               goto ONERR;
+            }
+         } else if (ctrl == flathash_DELETED) {
+            ++ nrdeleted;
+         } else if (ctrl != flathash_EMPTY) {
+            err = EINVAL;
+            goto ONERR;
+         }
+      }
+   }
+
+   if (  nrused != htable->nr_nodes
+         || (htable->capacity && maxload_flathash(htable->capacity) != nrused + nrdeleted + htable->growthleft)) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
+// section: flathash_iterator_t
+
+// group: lifetime
+
+int initfirst_flathashiterator(/*out*/flathash_iterator_t * iter, flathash_t * htable)
+{
+   iter->htable = htable;
+   iter->index  = 0;
+   return 0;
+}
+
+// group: iterate
+
+bool next_flathashiterator(flathash_iterator_t * iter, /*out*/flathash_node_t ** node)
+{
+   flathash_t * htable = iter->htable;
+
+   if (htable) {
+      for (size_t i = iter->index; i < htable->capacity; ++i) {
+         if (isused_flathash(htable->ctrl[i])) {
+            *node = htable->slot[i];
+            iter->index = i + 1;
+            return true;
+         }
+      }
+      iter->index = htable->capacity;
+   }
+
+   return false;
+}
+
+
+// section: flathash_t
+
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NROPS
+ * Number of lookups executed by every perftest instance. */
+#define PT_NROPS     1000000
+
+/* define: PT_NRNODES
+ * Number of nodes stored in the table of every perftest instance. */
+#define PT_NRNODES   65536
+
+typedef struct pt_object_t pt_object_t;
+
+typeadapt_DECLARE(pt_adapt_t, pt_object_t, uintptr_t);
+
+struct pt_object_t {
+   size_t            key;
+   flathash_node_t   flatnode;
+   exthash_node_t    extnode;
+};
+
+/* struct: pt_table_t
+ * Tables and nodes used by a single perftest instance. */
+typedef struct pt_table_t {
+   pt_adapt_t     typeadapt;
+   flathash_t     flathash;
+   exthash_t      exthash;
+   pt_object_t    object[PT_NRNODES];
+} pt_table_t;
+
+static int pt_cmpkeyobj(pt_adapt_t * typeadp, const uintptr_t lkey, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+static int pt_cmpobj(pt_adapt_t * typeadp, const pt_object_t * lobject, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lobject->key == robject->key ? 0 : lobject->key < robject->key ? -1 : +1;
+}
+
+static size_t pt_hashobj(pt_adapt_t * typeadp, const pt_object_t * object)
+{
+   (void) typeadp;
+   return object->key;
+}
+
+static size_t pt_hashkey(pt_adapt_t * typeadp, const uintptr_t key)
+{
+   (void) typeadp;
+   return key;
+}
+
+/* function: pt_nextkey
+ * Returns a pseudo random key. Keys in range [0..<PT_NRNODES>-1] are stored in the table.
+ * About 90% of all returned keys are found. */
+static inline uintptr_t pt_nextkey(uint32_t * seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return (*seed >> 8) % (PT_NRNODES + PT_NRNODES/9);
+}
+
+static int pt_prepare(perftest_instance_t* tinst, bool isflat)
+{
+   int err;
+   memblock_t  mblock = memblock_FREE;
+   pt_table_t* table  = 0;
+
+   err = ALLOC_MM(sizeof(pt_table_t), &mblock);
+   if (err) goto ONERR;
+
+   table = (pt_table_t*) mblock.addr;
+   table->typeadapt = (pt_adapt_t) typeadapt_INIT_LIFECMPHASH(0, 0, &pt_cmpkeyobj, &pt_cmpobj, &pt_hashobj, &pt_hashkey);
+   table->flathash  = (flathash_t) flathash_FREE;
+   table->exthash   = (exthash_t) exthash_FREE;
+
+   if (isflat) {
+      typeadapt_member_t nodeadp = typeadapt_member_INIT(cast_typeadapt(&table->typeadapt, pt_adapt_t, pt_object_t, uintptr_t), offsetof(pt_object_t, flatnode));
+      err = init_flathash(&table->flathash, PT_NRNODES, &nodeadp);
+   } else {
+      typeadapt_member_t nodeadp = typeadapt_member_INIT(cast_typeadapt(&table->typeadapt, pt_adapt_t, pt_object_t, uintptr_t), offsetof(pt_object_t, extnode));
+      err = init_exthash(&table->exthash, PT_NRNODES, PT_NRNODES, &nodeadp);
+   }
+   if (err) goto ONERR;
+
+   for (size_t i = 0; i < PT_NRNODES; ++i) {
+      table->object[i].key      = i;
+      table->object[i].flatnode = (flathash_node_t) flathash_node_INIT;
+      table->object[i].extnode  = (exthash_node_t) exthash_node_INIT;
+      if (isflat) {
+         err = insert_flathash(&table->flathash, &table->object[i].flatnode);
+      } else {
+         err = insert_exthash(&table->exthash, &table->object[i].extnode);
+      }
+      if (err) goto ONERR;
+   }
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   if (table) {
+      (void) free_flathash(&table->flathash);
+      (void) free_exthash(&table->exthash);
+      (void) FREE_MM(&mblock);
+   }
+   return err;
+}
+
+static int pt_prepare_flathash(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, true);
+}
+
+static int pt_prepare_exthash(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, false);
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t  mblock = memblock_INIT(tinst->size, tinst->addr);
+   pt_table_t* table  = (pt_table_t*) tinst->addr;
+
+   // nodes are not deleted (delete_object == 0)
+   err = free_flathash(&table->flathash);
+   int err2 = free_exthash(&table->exthash);
+   if (err2) err = err2;
+   err2 = FREE_MM(&mblock);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_flathash(perftest_instance_t* tinst)
+{
+   pt_table_t*       table = (pt_table_t*) tinst->addr;
+   flathash_node_t * node;
+   uint32_t          seed  = tinst->tid;
+   size_t            nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      uintptr_t key = pt_nextkey(&seed);
+      if (0 == find_flathash(&table->flathash, (const void*)key, &node)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+static int pt_run_exthash(perftest_instance_t* tinst)
+{
+   pt_table_t*       table = (pt_table_t*) tinst->addr;
+   exthash_node_t  * node;
+   uint32_t          seed  = tinst->tid;
+   size_t            nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      uintptr_t key = pt_nextkey(&seed);
+      if (0 == find_exthash(&table->exthash, (const void*)key, &node)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+int perftest_ds_inmem_flathash(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_flathash, &pt_run_flathash, &pt_unprepare),
+               "Searching a key in a table of 65536 nodes (90% hits)",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_flathash_exthash(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_exthash, &pt_run_exthash, &pt_unprepare),
+               "Searching a key in a table of 65536 nodes (90% hits)",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+typedef struct testobject_t testobject_t;
+
+typeadapt_DECLARE(testadapt_t, testobject_t, uintptr_t);
+
+struct testobject_t {
+   size_t            deletecount;
+   size_t            key;
+   flathash_node_t   node;
+};
+
+static int impl_cmpkeyobj_testadapt(testadapt_t * typeadp, const uintptr_t lkey, const struct testobject_t * robject)
+{
+   assert(typeadp);
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+static int impl_cmpobj_testadapt(testadapt_t * typeadp, const struct testobject_t * lobject, const struct testobject_t * robject)
+{
+   assert(typeadp);
+   return lobject->key == robject->key ? 0 : lobject->key < robject->key ? -1 : +1;
+}
+
+static size_t impl_hashobj_testadapt(testadapt_t * typeadp, const struct testobject_t * object)
+{
+   assert(typeadp);
+   return object->key;
+}
+
+static size_t impl_hashkey_testadapt(testadapt_t * typeadp, const uintptr_t key)
+{
+   assert(typeadp);
+   return (size_t) key;
+}
+
+/* function: impl_hashobjconst_testadapt
+ * Returns the same hash value for all objects. */
+static size_t impl_hashobjconst_testadapt(testadapt_t * typeadp, const struct testobject_t * object)
+{
+   assert(typeadp && object);
+   return 0;
+}
+
+/* function: impl_hashkeyconst_testadapt
+ * Returns the same hash value for all keys. */
+static size_t impl_hashkeyconst_testadapt(testadapt_t * typeadp, const uintptr_t key)
+{
+   assert(typeadp);
+   (void) key;
+   return 0;
+}
+
+static int impl_delete_testadapt(testadapt_t * typeadp, struct testobject_t ** object)
+{
+   int err = 0;
+   assert(*object && typeadp);
+   if ((*object)->deletecount == (size_t)-1) {
+      err = EINVAL;
+   } else {
+      ++ (*object)->deletecount;
+   }
+   (*object) = 0;
+   return err;
+}
+
+static int test_initfree(void)
+{
+   flathash_t           htable    = flathash_FREE;
+   typeadapt_member_t   emptyadp  = typeadapt_member_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   flathash_node_t      node      = flathash_node_INIT;
+   flathash_iterator_t  iter      = flathash_iterator_FREE;
+   testobject_t         nodes[256];
+
+   // prepare
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].deletecount = 0;
+      nodes[i].key  = i;
+      nodes[i].node = (flathash_node_t) flathash_node_INIT;
+   }
+
+   // TEST flathash_iterator_FREE
+   TEST(0 == iter.htable);
+   TEST(0 == iter.index);
+
+   // TEST flathash_node_INIT
+   TEST(0 == node.hashvalue);
+
+   // TEST flathash_FREE
+   TEST(0 == htable.slot);
+   TEST(0 == htable.ctrl);
+   TEST(0 == htable.capacity);
+   TEST(0 == htable.nr_nodes);
+   TEST(0 == htable.growthleft);
+   TEST(1 == isequal_typeadaptmember(&htable.nodeadp, &emptyadp));
+
+   // TEST init_flathash, free_flathash
+   for (size_t i = 0, capacity = 16; i < 4096; i = 2*i + 1) {
+      while (maxload_flathash(capacity) < i) capacity *= 2;
+      TEST(0 == init_flathash(&htable, i, &nodeadp));
+      TEST(0 != htable.slot);
+      TEST(htable.ctrl == (uint8_t*) (htable.slot + capacity));
+      TEST(capacity == htable.capacity);
+      TEST(0 == htable.nr_nodes);
+      TEST(maxload_flathash(capacity) == htable.growthleft);
+      TEST(1 == isequal_typeadaptmember(&htable.nodeadp, &nodeadp));
+      for (size_t si = 0; si < capacity; ++si) {
+         TEST(0 == htable.slot[si]);
+      }
+      for (size_t ci = 0; ci < capacity + flathash_GROUPSIZE; ++ci) {
+         TEST(flathash_EMPTY == htable.ctrl[ci]);
+      }
+      TEST(0 == invariant_flathash(&htable));
+      TEST(0 == free_flathash(&htable));
+      TEST(0 == htable.slot);
+      TEST(0 == htable.ctrl);
+      TEST(0 == htable.capacity);
+      TEST(0 == htable.nr_nodes);
+      TEST(0 == htable.growthleft);
+      TEST(1 == isequal_typeadaptmember(&htable.nodeadp, &emptyadp));
+      TEST(0 == free_flathash(&htable));
+      TEST(0 == htable.slot);
+   }
+
+   // TEST free_flathash: free all nodes
+   TEST(0 == init_flathash(&htable, 0, &nodeadp));
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_flathash(&htable, &nodes[i].node));
+   }
+   TEST(0 == free_flathash(&htable));
+   TEST(0 == htable.slot);
+   TEST(0 == htable.nr_nodes);
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(1 == nodes[i].deletecount);
+      nodes[i].deletecount = 0;
+   }
+
+   // TEST init_flathash: EINVAL
+   TEST(EINVAL == init_flathash(&htable, 1+((size_t)-1)/(2*sizeof(void*)), &nodeadp));
+   TEST(0 == htable.slot);
+   TEST(0 == htable.capacity);
+
+   // TEST nrelements_flathash, isempty_flathash
+   for (unsigned i = 0; i < 256; ++i) {
+      htable.nr_nodes = i;
+      TEST(i == nrelements_flathash(&htable));
+      TEST((i == 0) == isempty_flathash(&htable));
+   }
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_privhelper(void)
+{
+   uint8_t group[flathash_GROUPSIZE];
+
+   // TEST mixhash_flathash: neighbouring values differ in h1 and h2
+   for (size_t i = 0; i < 1000; ++i) {
+      TEST(mixhash_flathash(i) != mixhash_flathash(i+1));
+      TEST(h1_flathash(mixhash_flathash(i)) != h1_flathash(mixhash_flathash(i+1)));
+   }
+   TEST(0 == mixhash_flathash(0));
+
+   // TEST h1_flathash, h2_flathash
+   TEST(0    == h2_flathash(0));
+   TEST(0x7f == h2_flathash((size_t)-1));
+   TEST(0x7f == h2_flathash(0xff));
+   TEST(0x01 == h2_flathash(0x81));
+   TEST(0    == h1_flathash(0x7f));
+   TEST(1    == h1_flathash(0x80));
+   TEST(((size_t)-1 >> 7) == h1_flathash((size_t)-1));
+
+   // TEST isused_flathash
+   for (unsigned i = 0; i < 256; ++i) {
+      TEST((i < 128) == isused_flathash((uint8_t)i));
+   }
+   TEST(0 == isused_flathash(flathash_EMPTY));
+   TEST(0 == isused_flathash(flathash_DELETED));
+
+   // TEST maxload_flathash
+   TEST(14 == maxload_flathash(16));
+   TEST(28 == maxload_flathash(32));
+   TEST(7*1024 == maxload_flathash(8*1024));
+
+   // TEST matchbyte_flathash, matchempty_flathash, matchunused_flathash
+   for (unsigned b = 0; b < 256; ++b) {
+      for (unsigned i = 0; i < flathash_GROUPSIZE; ++i) {
+         group[i] = (uint8_t) (b + i);
+      }
+      for (unsigned i = 0; i < flathash_GROUPSIZE; ++i) {
+         TEST((1u << i) == matchbyte_flathash(group, (uint8_t)(b + i)));
+      }
+      uint32_t empty  = 0;
+      uint32_t unused = 0;
+      for (unsigned i = 0; i < flathash_GROUPSIZE; ++i) {
+         empty  |= (uint32_t) (group[i] == flathash_EMPTY) << i;
+         unused |= (uint32_t) (group[i] >= 128) << i;
+      }
+      TEST(empty  == matchempty_flathash(group));
+      TEST(unused == matchunused_flathash(group));
+   }
+   memset(group, flathash_EMPTY, sizeof(group));
+   TEST(0xffff == matchempty_flathash(group));
+   TEST(0xffff == matchunused_flathash(group));
+   TEST(0xffff == matchbyte_flathash(group, flathash_EMPTY));
+   TEST(0      == matchbyte_flathash(group, 0));
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_findinsertremove(void)
+{
+   flathash_t           htable    = flathash_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   const size_t         MAXNODES  = 65536;
+   memblock_t           mem       = memblock_FREE;
+   testobject_t       * nodes;
+   flathash_node_t    * found_node;
+
+   // prepare
+   TEST(0 == ALLOC_MM(MAXNODES * sizeof(testobject_t), &mem));
+   nodes = (testobject_t*) mem.addr;
+   clear_memblock(&mem);
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      nodes[i].key = i;
+   }
+
+   // TEST insert_flathash: no grow
+   TEST(0 == init_flathash(&htable, MAXNODES, &nodeadp));
+   const size_t capacity = htable.capacity;
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0      == insert_flathash(&htable, &nodes[i].node));
+      TEST(i      == nodes[i].node.hashvalue);
+      TEST(EEXIST == insert_flathash(&htable, &nodes[i].node));
+      TEST(i+1    == nrelements_flathash(&htable));
+   }
+   TEST(capacity == htable.capacity);
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0 == find_flathash(&htable, (const void*)(uintptr_t)i, &found_node));
+      TEST(found_node == &nodes[i].node);
+   }
+   TEST(ESRCH == find_flathash(&htable, (const void*)(uintptr_t)MAXNODES, &found_node));
+   TEST(0 == invariant_flathash(&htable));
+
+   // TEST remove_flathash
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0 == remove_flathash(&htable, &nodes[i].node));
+      TEST(0 == nodes[i].deletecount);
+      TEST(MAXNODES-1-i == nrelements_flathash(&htable));
+   }
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(ESRCH == find_flathash(&htable, (const void*)(uintptr_t)i, &found_node));
+   }
+   TEST(0 == invariant_flathash(&htable));
+
+   // TEST remove_flathash: ESRCH
+   TEST(ESRCH == remove_flathash(&htable, &nodes[0].node));
+   TEST(0 == free_flathash(&htable));
+
+   // TEST insert_flathash: table grows
+   TEST(0 == init_flathash(&htable, 1, &nodeadp));
+   TEST(16 == htable.capacity);
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0      == insert_flathash(&htable, &nodes[i].node));
+      TEST(EEXIST == insert_flathash(&htable, &nodes[i].node));
+      TEST(i+1 == nrelements_flathash(&htable));
+   }
+   TEST(capacity == htable.capacity);
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(0 == find_flathash(&htable, (const void*)(uintptr_t)i, &found_node));
+      TEST(found_node == &nodes[i].node);
+   }
+   TEST(0 == invariant_flathash(&htable));
+
+   // TEST removenodes_flathash
+   TEST(0 == removenodes_flathash(&htable));
+   TEST(0 == nrelements_flathash(&htable));
+   TEST(maxload_flathash(capacity) == htable.growthleft);
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      TEST(ESRCH == find_flathash(&htable, (const void*)(uintptr_t)i, &found_node));
+      TEST(1 == nodes[i].deletecount);
+      nodes[i].deletecount = 0;
+   }
+   TEST(0 == invariant_flathash(&htable));
+
+   // TEST removenodes_flathash: ERROR
+   for (size_t i = 0; i < 256; ++i) {
+      TEST(0 == insert_flathash(&htable, &nodes[i].node));
+   }
+   nodes[0].deletecount = (size_t)-1;
+   TEST(EINVAL == removenodes_flathash(&htable));
+   TEST(0 == nrelements_flathash(&htable));
+   nodes[0].deletecount = 0;
+   for (size_t i = 1; i < 256; ++i) {
+      TEST(1 == nodes[i].deletecount);
+      nodes[i].deletecount = 0;
+   }
+   TEST(0 == free_flathash(&htable));
+
+   // TEST insert_flathash, remove_flathash: random (deleted slots are reused or removed by rehash)
+   TEST(0 == init_flathash(&htable, 1, &nodeadp));
+   srand(123);
+   for (size_t i = 0; i < 256*1024; ++i) {
+      size_t id = (size_t)rand() % (16*1024);
+      if (0 == find_flathash(&htable, (const void*)id, &found_node)) {
+         TEST(found_node == &nodes[id].node);
+         TEST(0 == remove_flathash(&htable, found_node));
+      } else {
+         TEST(0 == insert_flathash(&htable, &nodes[id].node));
+      }
+   }
+   TEST(0 == invariant_flathash(&htable));
+   TEST(htable.capacity <= 32*1024);
+   TEST(0 == free_flathash(&htable));
+   for (size_t i = 0; i < MAXNODES; ++i) {
+      nodes[i].deletecount = 0;
+   }
+
+   // TEST insert_flathash, remove_flathash: all nodes have same hash value
+   typeadapt.gethash.hashobject = &impl_hashobjconst_testadapt;
+   typeadapt.gethash.hashkey    = &impl_hashkeyconst_testadapt;
+   TEST(0 == init_flathash(&htable, 1, &nodeadp));
+   for (size_t i = 0; i < 1000; ++i) {
+      TEST(0      == insert_flathash(&htable, &nodes[i].node));
+      TEST(EEXIST == insert_flathash(&htable, &nodes[i].node));
+   }
+   for (size_t i = 0; i < 1000; ++i) {
+      TEST(0 == find_flathash(&htable, (const void*)(uintptr_t)i, &found_node));
+      TEST(found_node == &nodes[i].node);
+   }
+   TEST(0 == invariant_flathash(&htable));
+   for (size_t i = 0; i < 1000; i += 2) {
+      TEST(0 == remove_flathash(&htable, &nodes[i].node));
+   }
+   for (size_t i = 0; i < 1000; ++i) {
+      int err = find_flathash(&htable, (const void*)(uintptr_t)i, &found_node);
+      TEST((i % 2 ? 0 : ESRCH) == err);
+   }
+   TEST(0 == invariant_flathash(&htable));
+   for (size_t i = 1; i < 1000; i += 2) {
+      TEST(0 == remove_flathash(&htable, &nodes[i].node));
+   }
+   TEST(0 == invariant_flathash(&htable));
+   TEST(0 == free_flathash(&htable));
+   typeadapt.gethash.hashobject = &impl_hashobj_testadapt;
+   typeadapt.gethash.hashkey    = &impl_hashkey_testadapt;
+
+   // TEST foreach
+   TEST(0 == init_flathash(&htable, 1024, &nodeadp));
+   for (size_t i = 0; i < 1024; ++i) {
+      TEST(0 == insert_flathash(&htable, &nodes[i].node));
+   }
+   size_t count = 0;
+   foreach (_flathash, node, &htable) {
+      testobject_t * object = (testobject_t*) cast2object_typeadaptmember(&nodeadp, node);
+      TEST(object->key < 1024);
+      TEST(0 == object->deletecount);
+      object->deletecount = 1;
+      ++ count;
+   }
+   TEST(1024 == count);
+   for (size_t i = 0; i < 1024; ++i) {
+      TEST(1 == nodes[i].deletecount);
+      nodes[i].deletecount = 0;
+   }
+
+   // TEST foreach: remove current node
+   foreach (_flathash, node, &htable) {
+      TEST(0 == remove_flathash(&htable, node));
+   }
+   TEST(0 == nrelements_flathash(&htable));
+   TEST(0 == invariant_flathash(&htable));
+
+   // TEST next_flathashiterator: empty table
+   flathash_iterator_t iter = flathash_iterator_FREE;
+   TEST(0 == initfirst_flathashiterator(&iter, &htable));
+   TEST(iter.htable == &htable);
+   TEST(iter.index  == 0);
+   TEST(0 == next_flathashiterator(&iter, &found_node));
+   TEST(iter.index  == htable.capacity);
+   TEST(0 == free_flathashiterator(&iter));
+   TEST(0 == iter.htable);
+
+   // unprepare
+   TEST(0 == free_flathash(&htable));
+   TEST(0 == FREE_MM(&mem));
+
+   return 0;
+ONERR:
+   free_flathash(&htable);
+   FREE_MM(&mem);
+   return EINVAL;
+}
+
+flathash_IMPLEMENT(_testhash, testobject_t, uintptr_t, node)
+
+static int test_generic(void)
+{
+   flathash_t           htable    = flathash_FREE;
+   testadapt_t          typeadapt = typeadapt_INIT_LIFECMPHASH(0, &impl_delete_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt, &impl_hashobj_testadapt, &impl_hashkey_testadapt);
+   typeadapt_member_t   nodeadp   = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testobject_t, uintptr_t), offsetof(testobject_t, node));
+   testobject_t         nodes[256];
+
+   // prepare
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].deletecount = 0;
+      nodes[i].key  = i;
+      nodes[i].node = (flathash_node_t) flathash_node_INIT;
+   }
+
+   // TEST init_flathash
+   TEST(0 == init_testhash(&htable, lengthof(nodes), &nodeadp));
+   TEST(0 != htable.slot);
+   TEST(0 == nrelements_testhash(&htable));
+   TEST(1 == isempty_testhash(&htable));
+
+   // TEST insert_flathash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_testhash(&htable, &nodes[i]));
+      TEST(i+1 == nrelements_testhash(&htable));
+      TEST(0 == isempty_testhash(&htable));
+   }
+   TEST(0 == invariant_testhash(&htable));
+
+   // TEST foreach
+   size_t count = 0;
+   foreach (_testhash, node, &htable) {
+      TEST(node->key < lengthof(nodes));
+      TEST(node == &nodes[node->key]);
+      ++ count;
+   }
+   TEST(lengthof(nodes) == count);
+
+   // TEST find_flathash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      testobject_t * found_node;
+      TEST(0 == find_testhash(&htable, i, &found_node));
+      TEST(found_node == &nodes[i]);
+   }
+
+   // TEST remove_flathash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      testobject_t * found_node;
+      TEST(0 == isempty_testhash(&htable));
+      TEST(0 == remove_testhash(&htable, &nodes[i]));
+      TEST(ESRCH == find_testhash(&htable, i, &found_node));
+      TEST(lengthof(nodes)-1-i == nrelements_testhash(&htable));
+   }
+   TEST(1 == isempty_testhash(&htable));
+
+   // TEST removenodes_flathash
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_testhash(&htable, &nodes[i]));
+   }
+   TEST(0 == removenodes_testhash(&htable));
+   TEST(1 == isempty_testhash(&htable));
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(1 == nodes[i].deletecount);
+   }
+
+   // TEST free_flathash
+   TEST(0 == free_testhash(&htable));
+   TEST(0 == htable.slot);
+
+   return 0;
+ONERR:
+   free_flathash(&htable);
+   return EINVAL;
+}
+
+int unittest_ds_inmem_flathash()
+{
+   if (test_initfree())          goto ONERR;
+   if (test_privhelper())        goto ONERR;
+   if (test_findinsertremove())  goto ONERR;
+   if (test_generic())           goto ONERR;
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+#endif
@@ -25,6 +25,10 @@
 #include "C-kern/api/time/timevalue.h"
 #include "C-kern/api/time/systimer.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: heap_t
@@ -335,6 +339,174 @@ ONERR:
 
 // section: Functions
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRELEM
+ * Number of elements inserted, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRELEM       (1024*1024)
+
+/* define: PT_NRELEM_SMALL
+ * Number of elements stored at the same time in <perftest_ds_inmem_heap_small>.
+ * The elements are inserted and removed <PT_NRELEM>/<PT_NRELEM_SMALL> times. */
+#define PT_NRELEM_SMALL 1024
+
+/* struct: pt_lifecycle_t
+ * Heap, heap memory and inserted values used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   vmpage_t    vmpage;
+   heap_t      heap;
+   size_t      nrelem;
+   size_t      nrloop;
+   uint64_t    valuesum;
+   uint64_t  * array;
+   uint64_t    value[/*nrelem*/];
+} pt_lifecycle_t;
+
+static int pt_compare(void * cmpstate, const void * left, const void * right)
+{
+   (void) cmpstate;
+   uint64_t l = *(const uint64_t*)left;
+   uint64_t r = *(const uint64_t*)right;
+   return (l < r) ? -1 : (l > r) ? +1 : 0;
+}
+
+/* function: pt_randomvalue
+ * Returns a pseudo random value computed from i. Different values of i result in different values. */
+static inline uint64_t pt_randomvalue(uint64_t i)
+{
+   uint64_t value = i * UINT64_C(0x9e3779b97f4a7c15);
+   return value ^ (value >> 29);
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrelem, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + 2 * nrelem * sizeof(uint64_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage   = vmpage;
+   plc->nrelem   = nrelem;
+   plc->nrloop   = PT_NRELEM / nrelem;
+   plc->valuesum = 0;
+   plc->array    = plc->value + nrelem;
+   err = init_heap(&plc->heap, sizeof(uint64_t), 0, nrelem, plc->array, &pt_compare, 0);
+   if (err) goto ONERR;
+
+   for (size_t i = 0; i < nrelem; ++i) {
+      plc->value[i] = israndom ? pt_randomvalue(i) : i;
+      plc->valuesum += plc->value[i];
+   }
+
+   tinst->nrops = PT_NRELEM;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+ONERR:
+   (void) free_vmpage(&vmpage);
+   return err;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   err = free_heap(&plc->heap);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   uint64_t         value;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrelem; ++i) {
+         err = insert_heap(&plc->heap, &plc->value[i]);
+         if (err) return err;
+      }
+
+      uint64_t valuesum = 0;
+      foreach_heap(&plc->heap, next) {
+         valuesum += *(uint64_t*)next;
+      }
+      if (valuesum != plc->valuesum) return EINVAL;
+
+      uint64_t prev = UINT64_MAX;
+      for (size_t i = 0; i < plc->nrelem; ++i) {
+         err = remove_heap(&plc->heap, &value);
+         if (err) return err;
+         if (value > prev) return EINVAL;
+         prev = value;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_heap_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single value of 1M ascending values",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_heap_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single value of 1M random values",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_heap_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single value of 1K random values",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
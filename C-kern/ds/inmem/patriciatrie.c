@@ -17,12 +17,32 @@
 #include "C-kern/konfig.h"
 #include "C-kern/api/err.h"
 #include "C-kern/api/ds/inmem/patriciatrie.h"
-#ifdef KONFIG_UNITTEST
-#include "C-kern/api/test/unittest.h"
-#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/io/accessmode.h"
+#include "C-kern/api/io/iochannel.h"
+#include "C-kern/api/io/filesystem/file.h"
+#include "C-kern/api/math/hash/crc32.h"
+#include "C-kern/api/memory/atomic.h"
 #include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/vm.h"
 #include "C-kern/api/memory/mm/mm_macros.h"
+#include "C-kern/api/platform/task/thread.h"
 #include "C-kern/api/test/errortimer.h"
+#include "C-kern/api/test/mm/err_macros.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/io/filesystem/directory.h"
+#include "C-kern/api/io/filesystem/fileutil.h"
+#include "C-kern/api/memory/wbuffer.h"
+#endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/test/perftest.h"
+#endif
+
+// forward
+#ifdef KONFIG_UNITTEST
+static test_errortimer_t   s_patriciatrie_errtimer;
 #endif
 
 
@@ -52,6 +72,59 @@ static inline void * cast_object(patriciatrie_node_t *node, patriciatrie_t *tree
    return ((uint8_t*)node - tree->keyadapt.nodeoffset);
 }
 
+// group: concurrency-helper
+
+/* function: startread_patriciatrie
+ * Returns the current value of <patriciatrie_t.seqnr>.
+ * If a change is in progress the function waits until it has ended. */
+static inline uint32_t startread_patriciatrie(patriciatrie_t *tree)
+{
+   uint32_t seqnr;
+   while (1 & (seqnr = loadacquire_atomicint(&tree->seqnr))) {
+      yield_thread();
+   }
+   return seqnr;
+}
+
+/* function: isvalidread_patriciatrie
+ * Returns true if tree has not been changed since <startread_patriciatrie> returned seqnr.
+ * If false is returned all values read in between must be discarded. */
+static inline bool isvalidread_patriciatrie(patriciatrie_t *tree, uint32_t seqnr)
+{
+   syncload_memory();
+   return seqnr == loadacquire_atomicint(&tree->seqnr);
+}
+
+/* function: startwrite_patriciatrie
+ * Marks the start of a change. All previous writes are visible before the change starts. */
+static inline void startwrite_patriciatrie(patriciatrie_t *tree)
+{
+   (void) add_atomicint(&tree->seqnr, 1);
+}
+
+/* function: endwrite_patriciatrie
+ * Marks the end of a change. All writes of the change are visible before the end is marked. */
+static inline void endwrite_patriciatrie(patriciatrie_t *tree)
+{
+   (void) add_atomicint(&tree->seqnr, 1);
+}
+
+/* function: lockreaders_patriciatrie
+ * Acquires <patriciatrie_t.readerlock>. */
+static inline void lockreaders_patriciatrie(patriciatrie_t *tree)
+{
+   while (0 != set_atomicflag(&tree->readerlock)) {
+      yield_thread();
+   }
+}
+
+/* function: unlockreaders_patriciatrie
+ * Releases <patriciatrie_t.readerlock>. */
+static inline void unlockreaders_patriciatrie(patriciatrie_t *tree)
+{
+   clear_atomicflag(&tree->readerlock);
+}
+
 // group: search
 
 /* function: getbitinit
@@ -276,19 +349,23 @@ static inline int is_key_equal(
 /* function: findnode
  * Returns found_parent and found_node, both !=0.
  * In case of a single node *found_node == *found_parent.
- * In case of an empty trie ESRCH is returned else 0.
+ * In case of an empty trie false is returned else true.
  * Either (*found_node)->bit_offset < (*found_parent)->bit_offset),
  * or (*found_node)->bit_offset == (*found_parent)->bit_offset) in case of a single node.
  *
+ * A concurrent reader could encounter a removed node with cleared child pointers.
+ * In this case false is returned and the tree has been changed.
+ *
  * Unchecked Precondition:
- * - tree->root  != 0
  * - key->offset == 0
  * */
-static void findnode(patriciatrie_t *tree, getkey_data_t *key, patriciatrie_node_t ** found_parent, patriciatrie_node_t ** found_node)
+static bool findnode(patriciatrie_t *tree, getkey_data_t *key, patriciatrie_node_t ** found_parent, patriciatrie_node_t ** found_node)
 {
    patriciatrie_node_t *parent;
    patriciatrie_node_t *node = tree->root;
 
+   if (!node) return false;
+
    do {
       parent = node;
       if (getbit(tree, key, node->bit_offset)) {
@@ -296,10 +373,12 @@ static void findnode(patriciatrie_t *tree, getkey_data_t *key, patriciatrie_node
       } else {
          node = node->left;
       }
+      if (!node) return false; // removed concurrently
    } while (node->bit_offset > parent->bit_offset);
 
    *found_node   = node;
    *found_parent = parent;
+   return true;
 }
 
 int find_patriciatrie(patriciatrie_t *tree, size_t len, const uint8_t key[len], /*out*/patriciatrie_node_t ** found_node)
@@ -307,16 +386,23 @@ int find_patriciatrie(patriciatrie_t *tree, size_t len, const uint8_t key[len],
    int err;
    patriciatrie_node_t *node;
    patriciatrie_node_t *parent;
+   bool                 isfound;
 
    VALIDATE_INPARAM_TEST((key != 0 || len == 0) && len < (((size_t)-1)/8), ONERR, );
 
-   if (!tree->root) return ESRCH;
+   for (;;) {
+      uint32_t seqnr = startread_patriciatrie(tree);
 
-   getkey_data_t fullkey;
-   initfullkey_getkeydata(&fullkey, len, key);
-   findnode(tree, &fullkey, &parent, &node);
+      getkey_data_t fullkey;
+      initfullkey_getkeydata(&fullkey, len, key);
+      isfound = findnode(tree, &fullkey, &parent, &node)
+                && is_key_equal(tree, node, &fullkey);
+
+      if (isvalidread_patriciatrie(tree, seqnr)) break;
+      // tree changed by writer ==> repeat search
+   }
 
-   if (! is_key_equal(tree, node, &fullkey)) {
+   if (! isfound) {
       return ESRCH;
    }
 
@@ -339,17 +425,19 @@ int insert_patriciatrie(patriciatrie_t *tree, patriciatrie_node_t * newnode, /*e
    VALIDATE_INPARAM_TEST((newkey.addr != 0 || newkey.streamsize == 0) && newkey.streamsize < (((size_t)-1)/8), ONERR, );
 
    if (!tree->root) {
-      tree->root = newnode;
       newnode->bit_offset = 0;
       newnode->right = newnode;
       newnode->left  = newnode;
+      startwrite_patriciatrie(tree);
+      tree->root = newnode;
+      endwrite_patriciatrie(tree);
       return 0;
    }
 
    // search node
    patriciatrie_node_t *parent;
    patriciatrie_node_t *node;
-   findnode(tree, &newkey, &parent, &node);
+   (void) findnode(tree, &newkey, &parent, &node);
 
    size_t  new_bitoffset;
    uint8_t new_bitvalue;
@@ -386,6 +474,8 @@ int insert_patriciatrie(patriciatrie_t *tree, patriciatrie_node_t * newnode, /*e
       newnode->bit_offset = 0;
       newnode->right = newnode;
       newnode->left  = newnode;
+      // newnode is initialized before it is reachable by readers
+      startwrite_patriciatrie(tree);
       node->bit_offset = new_bitoffset;
       if (new_bitvalue) {
          node->right = newnode;
@@ -401,6 +491,8 @@ int insert_patriciatrie(patriciatrie_t *tree, patriciatrie_node_t * newnode, /*e
          newnode->right = node;
          newnode->left  = newnode;
       }
+      // newnode is initialized before it is reachable by readers
+      startwrite_patriciatrie(tree);
       if (parent) {
          // == (tree->root == node) is possible therefore check for parent != 0 ==
          if (parent->right == node) {
@@ -414,6 +506,8 @@ int insert_patriciatrie(patriciatrie_t *tree, patriciatrie_node_t * newnode, /*e
       }
    }
 
+   endwrite_patriciatrie(tree);
+
    return 0;
 ONERR:
    if (existing_node) *existing_node = 0; // err param
@@ -429,16 +523,15 @@ int remove_patriciatrie(patriciatrie_t *tree, size_t len, const uint8_t key[len]
 
    VALIDATE_INPARAM_TEST((key != 0 || len == 0) && len < (((size_t)-1)/8), ONERR, );
 
-   if (!tree->root) return ESRCH;
-
    getkey_data_t fullkey;
    initfullkey_getkeydata(&fullkey, len, key);
-   findnode(tree, &fullkey, &parent, &node);
-
-   if (! is_key_equal(tree, node, &fullkey)) {
+   if (  ! findnode(tree, &fullkey, &parent, &node)
+         || ! is_key_equal(tree, node, &fullkey)) {
       return ESRCH;
    }
 
+   startwrite_patriciatrie(tree);
+
    patriciatrie_node_t * const delnode = node;
    patriciatrie_node_t * replacednode = 0;
    patriciatrie_node_t * replacedwith;
@@ -523,6 +616,8 @@ int remove_patriciatrie(patriciatrie_t *tree, size_t len, const uint8_t key[len]
    delnode->left       = 0;
    delnode->right      = 0;
 
+   endwrite_patriciatrie(tree);
+
    *removed_node = delnode;
 
    return 0;
@@ -537,7 +632,9 @@ int removenodes_patriciatrie(patriciatrie_t *tree, delete_adapter_f delete_f)
    patriciatrie_node_t * parent = 0;
    patriciatrie_node_t * node   = tree->root;
 
+   startwrite_patriciatrie(tree);
    tree->root = 0;
+   endwrite_patriciatrie(tree);
 
    if (node) {
 
@@ -587,6 +684,26 @@ ONERR:
    return err;
 }
 
+// group: concurrency
+
+void synchronize_patriciatrie(patriciatrie_t *tree)
+{
+   // readers which enter after the increment store the new epoch
+   uint32_t epoch  = 1 + (uint32_t) add_atomicint(&tree->epoch, 1);
+   uint32_t active = (epoch << 1) | 1;
+
+   lockreaders_patriciatrie(tree);
+   for (patriciatrie_reader_t * reader = tree->readers; reader; reader = reader->next) {
+      for (;;) {
+         uint32_t state = loadacquire_atomicint(&reader->state);
+         if (0 == state || active == state) break;
+         // reader entered before the increment
+         yield_thread();
+      }
+   }
+   unlockreaders_patriciatrie(tree);
+}
+
 
 // section: patriciatrie_iterator_t
 
@@ -650,7 +767,7 @@ bool next_patriciatrieiterator(patriciatrie_iterator_t *iter, /*out*/patriciatri
       }
    } while (next->bit_offset > parent->bit_offset);
 
-   if (higher_branch_parent) {
+   if (higher_branch_parent && higher_branch_parent->left != higher_branch_parent->right/*not single node*/) {
       parent = higher_branch_parent;
       next = parent->right;
       while (next->bit_offset > parent->bit_offset) {
@@ -687,7 +804,7 @@ bool prev_patriciatrieiterator(patriciatrie_iterator_t *iter, /*out*/patriciatri
       }
    } while (next->bit_offset > parent->bit_offset);
 
-   if (lower_branch_parent) {
+   if (lower_branch_parent && lower_branch_parent->left != lower_branch_parent->right/*not single node*/) {
       parent = lower_branch_parent;
       next = parent->left;
       while (next->bit_offset > parent->bit_offset) {
@@ -704,73 +821,78 @@ bool prev_patriciatrieiterator(patriciatrie_iterator_t *iter, /*out*/patriciatri
 
 // section: patriciatrie_prefixiter_t
 
-// group: lifetime
+// group: helper
 
-int initfirst_patriciatrieprefixiter(/*out*/patriciatrie_prefixiter_t *iter, patriciatrie_t *tree, size_t len, const uint8_t prefixkey[len])
+/* function: findprefix
+ * Returns the node with the lowest key which starts with prefixkey.
+ * The value 0 is returned if there is no such node.
+ * A value of 0 is also returned if a concurrent reader encounters a removed node. */
+static patriciatrie_node_t * findprefix(patriciatrie_t *tree, size_t len, const uint8_t prefixkey[len])
 {
    patriciatrie_node_t * parent;
    patriciatrie_node_t * node = tree->root;
    size_t         prefix_bits = 8 * len;
 
-   if (  (prefixkey || !len)
-         && len < (((size_t)-1)/8)
-         && node) {
-      getkey_data_t prefk;
-      initfullkey_getkeydata(&prefk, len, prefixkey);
-      if (node->bit_offset < prefix_bits) {
-         do {
-            parent = node;
-            if (getbit(tree, &prefk, node->bit_offset)) {
-               node = node->right;
-            } else {
-               node = node->left;
-            }
-         } while (node->bit_offset > parent->bit_offset && node->bit_offset < prefix_bits);
-      } else {
-         parent = node;
-         node = node->left;
-      }
-      while (node->bit_offset > parent->bit_offset) {
+   if (!node) return 0;
+
+   getkey_data_t prefk;
+   initfullkey_getkeydata(&prefk, len, prefixkey);
+   if (node->bit_offset < prefix_bits) {
+      do {
          parent = node;
-         node = node->left;
-      }
-      getkey_data_t key;
-      init1_getkeydata(&key, tree->keyadapt.getkey, cast_object(node, tree));
-      if (key.streamsize >= prefk.streamsize) {
-         uint8_t const *key2 = key.addr;
-         for (size_t offset = 0; offset < len; ++offset) {
-            if (offset == key.endoffset) {
-               tree->keyadapt.getkey(&key, offset);
-               key2 = key.addr;
-            }
-            if (prefixkey[offset] != *key2++) goto NO_PREFIX;
+         if (getbit(tree, &prefk, node->bit_offset)) {
+            node = node->right;
+         } else {
+            node = node->left;
          }
-
-      } else { NO_PREFIX:
-         node = 0;
+         if (!node) return 0; // removed concurrently
+      } while (node->bit_offset > parent->bit_offset && node->bit_offset < prefix_bits);
+   } else {
+      parent = node;
+      node = node->left;
+      if (!node) return 0; // removed concurrently
+   }
+   while (node->bit_offset > parent->bit_offset) {
+      parent = node;
+      node = node->left;
+      if (!node) return 0; // removed concurrently
+   }
+   getkey_data_t key;
+   init1_getkeydata(&key, tree->keyadapt.getkey, cast_object(node, tree));
+   if (key.streamsize < prefk.streamsize) return 0;
+   uint8_t const *key2 = key.addr;
+   for (size_t offset = 0; offset < len; ++offset) {
+      if (offset == key.endoffset) {
+         tree->keyadapt.getkey(&key, offset);
+         key2 = key.addr;
       }
+      if (prefixkey[offset] != *key2++) return 0;
    }
 
-   iter->next        = node;
-   iter->tree        = tree;
-   iter->prefix_bits = prefix_bits;
-   return 0;
+   return node;
 }
 
-// group: iterate
-
-bool next_patriciatrieprefixiter(patriciatrie_prefixiter_t *iter, /*out*/patriciatrie_node_t ** node)
+/* function: findnextprefix
+ * Returns the node following node which has the same prefix of iter->prefix_bits bits.
+ * The value 0 is returned if there is no such node.
+ * A value of 0 is also returned if a concurrent reader encounters a removed node.
+ *
+ * Removed node:
+ * If node has been removed concurrently the search by its key ends in another node.
+ * The first bit which differs between both keys determines the subtree where node
+ * would be stored. If node is less than all keys of the subtree its first node is returned
+ * else the first node of the next subtree. */
+static patriciatrie_node_t * findnextprefix(patriciatrie_prefixiter_t *iter, patriciatrie_node_t * node)
 {
-   if (!iter->next) return false;
-
-   *node = iter->next;
-
    getkey_data_t nextk;
-   init1_getkeydata(&nextk, iter->tree->keyadapt.getkey, cast_object(iter->next, iter->tree));
+   init1_getkeydata(&nextk, iter->tree->keyadapt.getkey, cast_object(node, iter->tree));
 
    patriciatrie_node_t * next = iter->tree->root;
    patriciatrie_node_t * parent;
    patriciatrie_node_t * higher_branch_parent = 0;
+
+   if (!next) return 0;
+
    do {
       parent = next;
       if (getbit(iter->tree, &nextk, next->bit_offset)) {
@@ -779,27 +901,732 @@ bool next_patriciatrieprefixiter(patriciatrie_prefixiter_t *iter, /*out*/patrici
          higher_branch_parent = parent;
          next = next->left;
       }
+      if (!next) return 0; // removed concurrently
    } while (next->bit_offset > parent->bit_offset);
 
+   if (next != node) {
+      // node has been removed concurrently
+      getkey_data_t foundk;
+      size_t        diff_bitoffset;
+      uint8_t       diff_bitvalue;
+      init1_getkeydata(&foundk, iter->tree->keyadapt.getkey, cast_object(next, iter->tree));
+      if (0 == get_first_different_bit(iter->tree, &foundk, &nextk, &diff_bitoffset, &diff_bitvalue)) {
+         // search root of subtree whose keys differ from node at diff_bitoffset
+         parent = 0;
+         next   = iter->tree->root;
+         higher_branch_parent = 0;
+         getbitinit(iter->tree, &nextk, next->bit_offset);
+         while (  next->bit_offset < diff_bitoffset
+                  && (!parent || next->bit_offset > parent->bit_offset)) {
+            parent = next;
+            if (getbit(iter->tree, &nextk, next->bit_offset)) {
+               next = next->right;
+            } else {
+               higher_branch_parent = parent;
+               next = next->left;
+            }
+            if (!next) return 0; // removed concurrently
+         }
+
+         if (0 == diff_bitvalue) {
+            // node is less than all keys of subtree ==> return first node of subtree
+            if (diff_bitoffset < iter->prefix_bits) return 0;
+            if (!parent || next->bit_offset > parent->bit_offset) {
+               do {
+                  parent = next;
+                  next = next->left;
+                  if (!next) return 0; // removed concurrently
+               } while (next->bit_offset > parent->bit_offset);
+            }
+            return next;
+         }
+         // node is greater than all keys of subtree ==> return first node of next subtree
+      }
+   }
+
    if (  higher_branch_parent
          && higher_branch_parent->bit_offset >= iter->prefix_bits) {
       parent = higher_branch_parent;
       next = parent->right;
+      if (!next) return 0; // removed concurrently
       while (next->bit_offset > parent->bit_offset) {
          parent = next;
          next = next->left;
+         if (!next) return 0; // removed concurrently
       }
-      iter->next = next;
-   } else {
-      iter->next = 0;
+      return next;
+   }
+
+   return 0;
+}
+
+// group: lifetime
+
+int initfirst_patriciatrieprefixiter(/*out*/patriciatrie_prefixiter_t *iter, patriciatrie_t *tree, size_t len, const uint8_t prefixkey[len])
+{
+   patriciatrie_node_t * node = 0;
+
+   if (  (prefixkey || !len)
+         && len < (((size_t)-1)/8)) {
+      for (;;) {
+         uint32_t seqnr = startread_patriciatrie(tree);
+         node = findprefix(tree, len, prefixkey);
+         if (isvalidread_patriciatrie(tree, seqnr)) break;
+         // tree changed by writer ==> repeat search
+      }
+   }
+
+   iter->next        = node;
+   iter->tree        = tree;
+   iter->prefix_bits = 8 * len;
+   return 0;
+}
+
+// group: iterate
+
+bool next_patriciatrieprefixiter(patriciatrie_prefixiter_t *iter, /*out*/patriciatrie_node_t ** node)
+{
+   if (!iter->next) return false;
+
+   *node = iter->next;
+
+   for (;;) {
+      uint32_t seqnr = startread_patriciatrie(iter->tree);
+      patriciatrie_node_t * next = findnextprefix(iter, *node);
+      if (isvalidread_patriciatrie(iter->tree, seqnr)) {
+         iter->next = next;
+         break;
+      }
+      // tree changed by writer ==> repeat search
    }
 
    return true;
 }
 
 
+// section: patriciatrie_reader_t
+
+// group: lifetime
+
+int init_patriciatriereader(/*out*/patriciatrie_reader_t *reader, patriciatrie_t *tree)
+{
+   reader->tree  = tree;
+   reader->state = 0;
+
+   lockreaders_patriciatrie(tree);
+   reader->next  = tree->readers;
+   tree->readers = reader;
+   unlockreaders_patriciatrie(tree);
+
+   return 0;
+}
+
+int free_patriciatriereader(patriciatrie_reader_t *reader)
+{
+   patriciatrie_t * tree = reader->tree;
+
+   if (tree) {
+      lockreaders_patriciatrie(tree);
+      for (patriciatrie_reader_t ** prev = &tree->readers; *prev; prev = &(*prev)->next) {
+         if (*prev == reader) {
+            *prev = reader->next;
+            break;
+         }
+      }
+      unlockreaders_patriciatrie(tree);
+
+      reader->next  = 0;
+      reader->tree  = 0;
+      reader->state = 0;
+   }
+
+   return 0;
+}
+
+// group: synchronize
+
+void enter_patriciatriereader(patriciatrie_reader_t *reader)
+{
+   uint32_t epoch = loadacquire_atomicint(&reader->tree->epoch);
+   // full barrier: state is visible before any node is read
+   write_atomicint(&reader->state, (epoch << 1) | 1);
+}
+
+void leave_patriciatriereader(patriciatrie_reader_t *reader)
+{
+   write_atomicint(&reader->state, 0);
+}
+
+
+// section: frozenpatriciatrie_t
+
+/* struct: patriciatrie_frozennode_t
+ * Describes the layout of a node stored in <frozenpatriciatrie_t>.
+ * The fixed part is followed by the key and padding bytes set to 0.
+ * Every node starts at an offset aligned to <patriciatrie_frozennode_ALIGN>.
+ *
+ * The offsets left and right reference the same nodes as <patriciatrie_node_t.left>
+ * and <patriciatrie_node_t.right>. A referenced node with a bit_offset not greater
+ * than the bit_offset of the referencing node ends a search. */
+typedef struct patriciatrie_frozennode_t {
+   /* variable: bit_offset
+    * Copy of <patriciatrie_node_t.bit_offset>. */
+   uint64_t bit_offset;
+   /* variable: left
+    * Offset relative to <frozenpatriciatrie_t.mem> of the node followed if the tested bit is 0. */
+   uint32_t left;
+   /* variable: right
+    * Offset relative to <frozenpatriciatrie_t.mem> of the node followed if the tested bit is 1. */
+   uint32_t right;
+   /* variable: keylen
+    * Length of key[]. */
+   uint64_t keylen;
+   /* variable: value
+    * Value returned from <getvalue_adapter_f>. */
+   void *   value;
+   /* variable: key
+    * The full key of the node. */
+   uint8_t  key[];
+} patriciatrie_frozennode_t;
+
+/* define: patriciatrie_frozennode_ALIGN
+ * Alignment of every <patriciatrie_frozennode_t>. */
+#define patriciatrie_frozennode_ALIGN 8u
+
+/* struct: patriciatrie_nodeindex_t
+ * Maps address of a <patriciatrie_node_t> to the offset of its frozen copy.
+ * Used only during <init_frozenpatriciatrie>. */
+typedef struct patriciatrie_nodeindex_t {
+   /* variable: node
+    * The node of the <patriciatrie_t>. */
+   const patriciatrie_node_t * node;
+   /* variable: off
+    * Offset of the frozen copy of node. UINT32_MAX if not reserved. */
+   uint32_t                    off;
+} patriciatrie_nodeindex_t;
+
+/* struct: patriciatrie_snapshotheader_t
+ * Header of a snapshot file written by <save_frozenpatriciatrie>.
+ * Its size is a multiple of <patriciatrie_frozennode_ALIGN>. */
+typedef struct patriciatrie_snapshotheader_t {
+   /* variable: magic
+    * Contains "CKPATRIE". */
+   uint8_t  magic[8];
+   /* variable: version
+    * Contains <frozenpatriciatrie_SNAPSHOTVERSION>. */
+   uint32_t version;
+   /* variable: byteorder
+    * Contains 0x0102 in the byte order of the writing system. */
+   uint16_t byteorder;
+   /* variable: ptrsize
+    * Contains sizeof(void*) of the writing system. */
+   uint8_t  ptrsize;
+   /* variable: reserved1
+    * Set to 0. */
+   uint8_t  reserved1;
+   /* variable: size
+    * Size in bytes of the memory block following the header. */
+   uint64_t size;
+   /* variable: crc
+    * The crc32 checksum of the memory block. */
+   uint32_t crc;
+   /* variable: reserved2
+    * Set to 0. */
+   uint32_t reserved2;
+} patriciatrie_snapshotheader_t;
+
+// group: helper
+
+/* function: size_patriciatriefrozennode
+ * Returns the size of a frozen node which stores a key of size keylen. */
+static inline size_t size_patriciatriefrozennode(size_t keylen)
+{
+   return (offsetof(patriciatrie_frozennode_t, key) + keylen + (patriciatrie_frozennode_ALIGN-1))
+          & ~(size_t)(patriciatrie_frozennode_ALIGN-1);
+}
+
+/* function: compare_nodeindex
+ * Compares the node addresses of two <patriciatrie_nodeindex_t>. Used to sort and search the index. */
+static int compare_nodeindex(const void * left, const void * right)
+{
+   uintptr_t l = (uintptr_t) ((const patriciatrie_nodeindex_t*)left)->node;
+   uintptr_t r = (uintptr_t) ((const patriciatrie_nodeindex_t*)right)->node;
+   return l < r ? -1 : l > r;
+}
+
+/* function: reserve_frozenpatriciatrie
+ * Reserves memory at offset *end for the frozen copy of entry->node and stores its address in it.
+ * The reserved offset is returned in entry->off and *end is incremented by the size of the frozen node. */
+static void reserve_frozenpatriciatrie(patriciatrie_t * tree, uint8_t * mem, /*inout*/size_t * end, patriciatrie_nodeindex_t * entry)
+{
+   getkey_data_t key;
+   init1_getkeydata(&key, tree->keyadapt.getkey, cast_object(CONST_CAST(patriciatrie_node_t, entry->node), tree));
+
+   // node is read back by init_frozenpatriciatrie when the reserved node is processed
+   memcpy(mem + *end, &entry->node, sizeof(entry->node));
+
+   entry->off = (uint32_t) *end;
+   *end      += size_patriciatriefrozennode(key.streamsize);
+}
+
+/* function: init_patriciatriesnapshotheader
+ * Initializes header which describes the memory block of frozen. */
+static void init_patriciatriesnapshotheader(/*out*/patriciatrie_snapshotheader_t * header, const frozenpatriciatrie_t * frozen)
+{
+   static_assert(sizeof(patriciatrie_snapshotheader_t) == 32, "file format is fixed");
+   static_assert(0 == sizeof(patriciatrie_snapshotheader_t) % patriciatrie_frozennode_ALIGN, "keeps alignment of nodes");
+   memcpy(header->magic, "CKPATRIE", sizeof(header->magic));
+   header->version   = frozenpatriciatrie_SNAPSHOTVERSION;
+   header->byteorder = 0x0102;
+   header->ptrsize   = (uint8_t) sizeof(void*);
+   header->reserved1 = 0;
+   header->size      = frozen->size;
+   header->crc       = calculate_crc32(frozen->size, frozen->mem);
+   header->reserved2 = 0;
+}
+
+/* function: check_patriciatriesnapshotheader
+ * Returns EINVAL if header does not describe a valid memory block of size bytes following it. */
+static int check_patriciatriesnapshotheader(const patriciatrie_snapshotheader_t * header, size_t size)
+{
+   if (  0 != memcmp(header->magic, "CKPATRIE", sizeof(header->magic))
+         || frozenpatriciatrie_SNAPSHOTVERSION != header->version
+         || 0x0102 != header->byteorder
+         || sizeof(void*) != header->ptrsize
+         || size != header->size
+         || size > UINT32_MAX
+         || 0 != size % patriciatrie_frozennode_ALIGN) {
+      return EINVAL;
+   }
+
+   if (header->crc != calculate_crc32(size, (const uint8_t*) header + sizeof(*header))) {
+      return EINVAL;
+   }
+
+   return 0;
+}
+
+// group: lifetime
+
+int init_frozenpatriciatrie(/*out*/frozenpatriciatrie_t * frozen, patriciatrie_t * tree, getvalue_adapter_f getvalue)
+{
+   int err;
+   memblock_t mblock = memblock_FREE;
+   memblock_t index  = memblock_FREE;
+   size_t     nrnode = 0;
+   size_t     next   = 0; // offset of next reserved node which is not yet written
+   size_t     end    = 0; // offset of end of reserved memory
+
+   if (tree->root) {
+      patriciatrie_iterator_t iter;
+      patriciatrie_node_t   * node;
+      getkey_data_t           key;
+
+      // compute size of memory block
+      (void) initfirst_patriciatrieiterator(&iter, tree);
+      while (next_patriciatrieiterator(&iter, &node)) {
+         init1_getkeydata(&key, tree->keyadapt.getkey, cast_object(node, tree));
+         end += size_patriciatriefrozennode(key.streamsize);
+         ++ nrnode;
+         if (end > UINT32_MAX) {
+            err = EOVERFLOW;
+            goto ONERR;
+         }
+      }
+
+      err = ALLOC_ERR_MM(&s_patriciatrie_errtimer, nrnode * sizeof(patriciatrie_nodeindex_t), &index);
+      if (err) goto ONERR;
+      err = ALLOC_ERR_MM(&s_patriciatrie_errtimer, end, &mblock);
+      if (err) goto ONERR;
+      memset(mblock.addr, 0, end);
+
+      // sorted index maps node addresses to offsets
+      patriciatrie_nodeindex_t * entries = (patriciatrie_nodeindex_t*) index.addr;
+      (void) initfirst_patriciatrieiterator(&iter, tree);
+      for (size_t i = 0; next_patriciatrieiterator(&iter, &node); ++i) {
+         entries[i].node = node;
+         entries[i].off  = UINT32_MAX;
+      }
+      qsort(entries, nrnode, sizeof(entries[0]), &compare_nodeindex);
+
+      // the reserved but unwritten nodes between next and end
+      // serve as queue of a breadth first traversal
+      patriciatrie_nodeindex_t rootkey = { tree->root, 0 };
+      end = 0;
+      reserve_frozenpatriciatrie(tree, mblock.addr, &end, bsearch(&rootkey, entries, nrnode, sizeof(entries[0]), &compare_nodeindex));
+      while (next < end) {
+         memcpy(&node, mblock.addr + next, sizeof(node));
+
+         uint32_t childoff[2];
+         patriciatrie_nodeindex_t childkey[2] = { { node->left, 0 }, { node->right, 0 } };
+         for (unsigned i = 0; i < 2; ++i) {
+            patriciatrie_nodeindex_t * entry = bsearch(&childkey[i], entries, nrnode, sizeof(entries[0]), &compare_nodeindex);
+            if (entry->off == UINT32_MAX) {
+               reserve_frozenpatriciatrie(tree, mblock.addr, &end, entry);
+            }
+            childoff[i] = entry->off;
+         }
+
+         void * object = cast_object(node, tree);
+         init1_getkeydata(&key, tree->keyadapt.getkey, object);
+         patriciatrie_frozennode_t * fnode = (patriciatrie_frozennode_t*) (mblock.addr + next);
+         fnode->bit_offset = node->bit_offset;
+         fnode->left   = childoff[0];
+         fnode->right  = childoff[1];
+         fnode->keylen = key.streamsize;
+         fnode->value  = getvalue ? getvalue(object) : object;
+         for (size_t off = 0; off < key.streamsize; ) {
+            if (off >= key.endoffset) tree->keyadapt.getkey(&key, off);
+            size_t size = key.endoffset - off;
+            memcpy(fnode->key + off, key.addr + (off - key.offset), size);
+            off += size;
+         }
+
+         next += size_patriciatriefrozennode(key.streamsize);
+      }
+
+      err = FREE_ERR_MM(&s_patriciatrie_errtimer, &index);
+      if (err) goto ONERR;
+   }
+
+   // set out param
+   frozen->mem     = mblock.addr;
+   frozen->size    = end;
+   frozen->mapaddr = 0;
+   frozen->mapsize = 0;
+
+   return 0;
+ONERR:
+   FREE_MM(&index);
+   FREE_MM(&mblock);
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int initload_frozenpatriciatrie(/*out*/frozenpatriciatrie_t * frozen, const char * filepath, const struct directory_t * relative_to)
+{
+   int err;
+   file_t   file   = file_FREE;
+   vmpage_t vmpage = vmpage_FREE;
+   off_t    filesize;
+
+   err = init_file(&file, filepath, accessmode_READ, relative_to);
+   if (err) goto ONERR;
+   err = size_file(file, &filesize);
+   if (err) goto ONERR;
+
+   if (  filesize < (off_t) sizeof(patriciatrie_snapshotheader_t)
+         || (uint64_t) filesize > SIZE_MAX) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   err = initfile_vmpage(&vmpage, io_file(file), (size_t) filesize);
+   if (err) goto ONERR;
+   err = free_file(&file);
+   if (err) goto ONERR;
+
+   size_t size = (size_t) filesize - sizeof(patriciatrie_snapshotheader_t);
+   err = check_patriciatriesnapshotheader((const patriciatrie_snapshotheader_t*) vmpage.addr, size);
+   if (err) goto ONERR;
+
+   // set out param
+   frozen->mem     = size ? vmpage.addr + sizeof(patriciatrie_snapshotheader_t) : 0;
+   frozen->size    = size;
+   frozen->mapaddr = vmpage.addr;
+   frozen->mapsize = vmpage.size;
+
+   return 0;
+ONERR:
+   free_vmpage(&vmpage);
+   free_file(&file);
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_frozenpatriciatrie(frozenpatriciatrie_t * frozen)
+{
+   int err;
+
+   if (frozen->mapaddr) {
+      vmpage_t vmpage = vmpage_INIT(frozen->mapsize, frozen->mapaddr);
+      frozen->mem     = 0;
+      frozen->size    = 0;
+      frozen->mapaddr = 0;
+      frozen->mapsize = 0;
+
+      err = free_vmpage(&vmpage);
+      (void) PROCESS_testerrortimer(&s_patriciatrie_errtimer, &err);
+      if (err) goto ONERR;
+
+   } else if (frozen->mem) {
+      memblock_t mblock = memblock_INIT(frozen->size, frozen->mem);
+      frozen->mem  = 0;
+      frozen->size = 0;
+
+      err = FREE_ERR_MM(&s_patriciatrie_errtimer, &mblock);
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+void * const * at_frozenpatriciatrie(const frozenpatriciatrie_t * frozen, size_t len, const uint8_t key[len])
+{
+   const uint8_t * mem = frozen->mem;
+   const patriciatrie_frozennode_t * parent;
+   const patriciatrie_frozennode_t * node = (const patriciatrie_frozennode_t*) mem;
+
+   if (!mem) return 0; // EMPTY TRIE
+
+   // same bit semantics as getbit
+   do {
+      parent = node;
+      size_t byteoffset = (size_t) (parent->bit_offset / 8);
+      int    bit = byteoffset < len ? (key[byteoffset] & (0x80 >> (parent->bit_offset % 8)))
+                                    : (byteoffset == len);
+      node = (const patriciatrie_frozennode_t*) (mem + (bit ? parent->right : parent->left));
+   } while (node->bit_offset > parent->bit_offset);
+
+   if (node->keylen != len || 0 != memcmp(node->key, key, len)) {
+      return 0;
+   }
+
+   return &node->value;
+}
+
+// group: persistence
+
+int save_frozenpatriciatrie(const frozenpatriciatrie_t * frozen, const char * filepath, struct directory_t * relative_to)
+{
+   int err;
+   file_t   file = file_FREE;
+   bool     is_created = false;
+   size_t   bytes_written;
+   patriciatrie_snapshotheader_t header;
+
+   init_patriciatriesnapshotheader(&header, frozen);
+
+   err = initcreate_file(&file, filepath, relative_to);
+   if (err) goto ONERR;
+   is_created = true;
+
+   err = write_file(file, sizeof(header), &header, &bytes_written);
+   if (err) goto ONERR;
+   if (bytes_written != sizeof(header)) {
+      err = EIO;
+      goto ONERR;
+   }
+
+   if (frozen->size) {
+      err = write_file(file, frozen->size, frozen->mem, &bytes_written);
+      if (err) goto ONERR;
+      if (bytes_written != frozen->size) {
+         err = EIO;
+         goto ONERR;
+      }
+   }
+
+   err = free_file(&file);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   if (is_created) {
+      (void) remove_file(filepath, relative_to);
+      (void) free_file(&file);
+   }
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
 // section: Functions
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRKEYS
+ * Number of keys inserted, searched, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRKEYS       (1024*1024)
+
+/* define: PT_NRKEYS_SMALL
+ * Number of keys stored at the same time in <perftest_ds_inmem_patriciatrie_small>.
+ * The keys are inserted and removed <PT_NRKEYS>/<PT_NRKEYS_SMALL> times. */
+#define PT_NRKEYS_SMALL 1024
+
+/* struct: pt_object_t
+ * Stores value as 8 byte big endian key. */
+typedef struct pt_object_t {
+   uint64_t             value;
+   uint8_t              key[8];
+   patriciatrie_node_t  node;
+} pt_object_t;
+
+static void pt_getkey(/*inout*/getkey_data_t* key, size_t offset)
+{
+   (void) offset;
+   pt_object_t * object = key->object;
+   init2_getkeydata(key, sizeof(object->key), sizeof(object->key), object->key);
+}
+
+patriciatrie_IMPLEMENT(_pttrie, pt_object_t, node, &pt_getkey)
+
+/* struct: pt_lifecycle_t
+ * Trie and nodes used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   patriciatrie_t tree;
+   size_t         nrkeys;
+   size_t         nrloop;
+   uint64_t       keysum;
+   pt_object_t    object[/*nrkeys*/];
+} pt_lifecycle_t;
+
+/* function: pt_randomkey
+ * Returns a pseudo random key computed from i. Different values of i result in different keys. */
+static inline uint64_t pt_randomkey(uint64_t i)
+{
+   uint64_t key = i * UINT64_C(0x9e3779b97f4a7c15);
+   return key ^ (key >> 29);
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrkeys, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrkeys * sizeof(pt_object_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage = vmpage;
+   init_pttrie(&plc->tree);
+   plc->nrkeys = nrkeys;
+   plc->nrloop = PT_NRKEYS / nrkeys;
+   plc->keysum = 0;
+
+   for (size_t i = 0; i < nrkeys; ++i) {
+      pt_object_t * object = &plc->object[i];
+      object->value = israndom ? pt_randomkey(i) : i;
+      for (unsigned b = 0; b < sizeof(object->key); ++b) {
+         object->key[b] = (uint8_t) (object->value >> (8 * (sizeof(object->key)-1-b)));
+      }
+      plc->keysum += object->value;
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   // nodes are part of vmpage
+   err = free_pttrie(&plc->tree, 0);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   pt_object_t    * node;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = insert_pttrie(&plc->tree, &plc->object[i], 0);
+         if (err) return err;
+      }
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = find_pttrie(&plc->tree, sizeof(plc->object[i].key), plc->object[i].key, &node);
+         if (err) return err;
+         if (node != &plc->object[i]) return EINVAL;
+      }
+
+      uint64_t keysum = 0;
+      foreach (_pttrie, next, &plc->tree) {
+         keysum += next->value;
+      }
+      if (keysum != plc->keysum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = remove_pttrie(&plc->tree, sizeof(plc->object[i].key), plc->object[i].key, &node);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_patriciatrie_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M sequential keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_patriciatrie_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_patriciatrie_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1K random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -1167,6 +1994,10 @@ static int test_initfree(void)
    TEST(0 == tree.root);
    TEST(0 == tree.keyadapt.nodeoffset);
    TEST(0 == tree.keyadapt.getkey);
+   TEST(0 == tree.seqnr);
+   TEST(0 == tree.epoch);
+   TEST(0 == tree.readers);
+   TEST(0 == tree.readerlock);
 
    // TEST patriciatrie_INIT
    tree = (patriciatrie_t) patriciatrie_INIT((void*)7, keyadapt);
@@ -1887,6 +2718,18 @@ static int test_iterator(void)
    TEST(0 != preiter.tree);
    TEST(0 != preiter.prefix_bits);
 
+   // TEST next_patriciatrieiterator, prev_patriciatrieiterator: single node
+   TEST(0 == insert_patriciatrie(&tree, &nodes[0].node, 0));
+   TEST(0 == initfirst_patriciatrieiterator(&iter, &tree));
+   TEST(1 == next_patriciatrieiterator(&iter, &found_node));
+   TEST(&nodes[0].node == found_node);
+   TEST(0 == next_patriciatrieiterator(&iter, &found_node));
+   TEST(0 == initlast_patriciatrieiterator(&iter, &tree));
+   TEST(1 == prev_patriciatrieiterator(&iter, &found_node));
+   TEST(&nodes[0].node == found_node);
+   TEST(0 == prev_patriciatrieiterator(&iter, &found_node));
+   TEST(0 == removenodes_patriciatrie(&tree, 0));
+
    // TEST both iterator
    srand(400);
    for (unsigned test = 0; test < 20; ++test) {
@@ -2110,6 +2953,444 @@ ONERR:
    return EINVAL;
 }
 
+typedef struct concnode_t {
+   patriciatrie_node_t  node;
+   uint8_t              key[2];
+} concnode_t;
+
+typedef struct concparam_t {
+   patriciatrie_t *  tree;
+   concnode_t     *  nodes;
+   unsigned          nrnodes;
+   uint32_t          isstop;
+   uint32_t          nrsearch;
+} concparam_t;
+
+static void impl_getconckey(/*inout*/getkey_data_t* key, size_t offset)
+{
+   concnode_t * node = key->object;
+   (void) offset;
+   init2_getkeydata(key, sizeof(node->key), sizeof(node->key), node->key);
+}
+
+/* function: thread_concreader
+ * Searches all nodes until isstop is set.
+ * Nodes with an even index are never removed. Odd nodes are inserted and removed concurrently. */
+static int thread_concreader(concparam_t * param)
+{
+   patriciatrie_reader_t reader = patriciatrie_reader_FREE;
+   patriciatrie_node_t * found;
+
+   TEST(0 == init_patriciatriereader(&reader, param->tree));
+
+   while (! loadacquire_atomicint(&param->isstop)) {
+      enter_patriciatriereader(&reader);
+      for (unsigned i = 0; i < param->nrnodes; ++i) {
+         concnode_t * node = &param->nodes[i];
+         int err = find_patriciatrie(param->tree, sizeof(node->key), node->key, &found);
+         if (i % 2) {
+            TEST(0 == err || ESRCH == err);
+            TEST(0 != err || &node->node == found);
+         } else {
+            TEST(0 == err);
+            TEST(&node->node == found);
+         }
+      }
+      // all even nodes with prefix key[0] == 1 are returned in ascending order
+      patriciatrie_prefixiter_t iter;
+      unsigned next = 256;
+      TEST(0 == initfirst_patriciatrieprefixiter(&iter, param->tree, 1, (const uint8_t*)"\x01"));
+      while (next_patriciatrieprefixiter(&iter, &found)) {
+         concnode_t * node = (concnode_t*) ((uint8_t*)found - offsetof(concnode_t, node));
+         unsigned i = (unsigned) (node - param->nodes);
+         TEST(1 == node->key[0]);
+         TEST(next <= i);
+         TEST(next == i || (next+1 == i && 1 == next % 2));
+         next = i + 1;
+      }
+      TEST(512 == next || 511 == next);
+      leave_patriciatriereader(&reader);
+      add_atomicint(&param->nrsearch, 1);
+   }
+
+   TEST(0 == free_patriciatriereader(&reader));
+
+   return 0;
+ONERR:
+   leave_patriciatriereader(&reader);
+   free_patriciatriereader(&reader);
+   return EINVAL;
+}
+
+static int thread_synchronize(concparam_t * param)
+{
+   synchronize_patriciatrie(param->tree);
+   write_atomicint(&param->isstop, 1);
+   return 0;
+}
+
+static int test_concurrent(void)
+{
+   patriciatrie_t          tree   = patriciatrie_FREE;
+   patriciatrie_reader_t   reader[2] = { patriciatrie_reader_FREE, patriciatrie_reader_FREE };
+   thread_t              * thread[3] = { 0 };
+   concparam_t             param;
+   concnode_t              nodes[512];
+   patriciatrie_node_t   * removed;
+
+   // prepare
+   init_patriciatrie(&tree, (getkey_adapter_t) getkey_adapter_INIT(offsetof(concnode_t, node), &impl_getconckey));
+   memset(nodes, 0, sizeof(nodes));
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].key[0] = (uint8_t) (i >> 8);
+      nodes[i].key[1] = (uint8_t) i;
+   }
+
+   // TEST patriciatrie_reader_FREE
+   TEST(0 == reader[0].next);
+   TEST(0 == reader[0].tree);
+   TEST(0 == reader[0].state);
+
+   // TEST init_patriciatriereader
+   for (unsigned i = 0; i < lengthof(reader); ++i) {
+      TEST(0 == init_patriciatriereader(&reader[i], &tree));
+      TEST(reader[i].next == (i ? &reader[i-1] : 0));
+      TEST(reader[i].tree == &tree);
+      TEST(reader[i].state == 0);
+      TEST(tree.readers == &reader[i]);
+      TEST(0 == tree.readerlock);
+   }
+
+   // TEST enter_patriciatriereader, leave_patriciatriereader
+   tree.epoch = 0x12345;
+   enter_patriciatriereader(&reader[0]);
+   TEST(reader[0].state == ((0x12345u << 1) | 1));
+   leave_patriciatriereader(&reader[0]);
+   TEST(reader[0].state == 0);
+
+   // TEST synchronize_patriciatrie: no reader entered
+   synchronize_patriciatrie(&tree);
+   TEST(tree.epoch == 0x12346);
+   TEST(0 == tree.readerlock);
+
+   // TEST synchronize_patriciatrie: waits for entered reader
+   param = (concparam_t) { &tree, nodes, lengthof(nodes), 0, 0 };
+   enter_patriciatriereader(&reader[0]);
+   TEST(0 == newgeneric_thread(&thread[0], &thread_synchronize, &param));
+   sleepms_thread(20);
+   TEST(0 == loadacquire_atomicint(&param.isstop));
+   leave_patriciatriereader(&reader[0]);
+   TEST(0 == join_thread(thread[0]));
+   TEST(1 == loadacquire_atomicint(&param.isstop));
+   TEST(0 == delete_thread(&thread[0]));
+
+   // TEST free_patriciatriereader
+   for (unsigned i = 0; i < lengthof(reader); ++i) {
+      TEST(0 == free_patriciatriereader(&reader[i]));
+      TEST(0 == reader[i].next);
+      TEST(0 == reader[i].tree);
+      TEST(0 == reader[i].state);
+      TEST(tree.readers == (i ? 0 : &reader[1]));
+      TEST(0 == free_patriciatriereader(&reader[i]));
+   }
+
+   // TEST insert_patriciatrie, remove_patriciatrie: seqnr is incremented by 2
+   uint32_t seqnr = tree.seqnr;
+   TEST(0 == insert_patriciatrie(&tree, &nodes[0].node, 0));
+   TEST(seqnr+2 == tree.seqnr);
+   TEST(0 == insert_patriciatrie(&tree, &nodes[1].node, 0));
+   TEST(seqnr+4 == tree.seqnr);
+   TEST(EEXIST == insert_patriciatrie(&tree, &nodes[1].node, 0));
+   TEST(seqnr+4 == tree.seqnr);
+   TEST(0 == remove_patriciatrie(&tree, sizeof(nodes[1].key), nodes[1].key, &removed));
+   TEST(seqnr+6 == tree.seqnr);
+   TEST(ESRCH == remove_patriciatrie(&tree, sizeof(nodes[1].key), nodes[1].key, &removed));
+   TEST(seqnr+6 == tree.seqnr);
+   TEST(0 == remove_patriciatrie(&tree, sizeof(nodes[0].key), nodes[0].key, &removed));
+   TEST(seqnr+8 == tree.seqnr);
+
+   // TEST find_patriciatrie, next_patriciatrieprefixiter: concurrent readers and single writer
+   for (unsigned i = 0; i < lengthof(nodes); i += 2) {
+      TEST(0 == insert_patriciatrie(&tree, &nodes[i].node, 0));
+   }
+   param = (concparam_t) { &tree, nodes, lengthof(nodes), 0, 0 };
+   for (unsigned t = 0; t < lengthof(thread); ++t) {
+      TEST(0 == newgeneric_thread(&thread[t], &thread_concreader, &param));
+   }
+   for (unsigned r = 0; r < 20 || loadacquire_atomicint(&param.nrsearch) < 3*lengthof(thread); ++r) {
+      for (unsigned i = 1; i < lengthof(nodes); i += 2) {
+         TEST(0 == insert_patriciatrie(&tree, &nodes[i].node, 0));
+      }
+      for (unsigned i = 1; i < lengthof(nodes); i += 2) {
+         TEST(0 == remove_patriciatrie(&tree, sizeof(nodes[i].key), nodes[i].key, &removed));
+         TEST(&nodes[i].node == removed);
+      }
+      // removed nodes are reused in next round
+      synchronize_patriciatrie(&tree);
+   }
+   write_atomicint(&param.isstop, 1);
+   for (unsigned t = 0; t < lengthof(thread); ++t) {
+      TEST(0 == join_thread(thread[t]));
+      TEST(0 == returncode_thread(thread[t]));
+      TEST(0 == delete_thread(&thread[t]));
+   }
+   TEST(0 == tree.readers);
+
+   // unprepare
+   TEST(0 == free_patriciatrie(&tree, 0));
+
+   return 0;
+ONERR:
+   write_atomicint(&param.isstop, 1);
+   for (unsigned t = 0; t < lengthof(thread); ++t) {
+      delete_thread(&thread[t]);
+   }
+   for (unsigned i = 0; i < lengthof(reader); ++i) {
+      leave_patriciatriereader(&reader[i]);
+      free_patriciatriereader(&reader[i]);
+   }
+   free_patriciatrie(&tree, 0);
+   return EINVAL;
+}
+
+static void * impl_gettestvalue(void * obj)
+{
+   testnode_t * node = obj;
+   uintptr_t    value = 1 + 100000 * node->key_len;
+   for (size_t i = 0; i < node->key_len; ++i) {
+      value = value * 10 + node->key[i];
+   }
+   return (void*) value;
+}
+
+static int test_frozen(void)
+{
+   size_t const            NODEOFFSET = offsetof(testnode_t, node);
+   getkey_adapter_t        keyadapt = getkey_adapter_INIT(NODEOFFSET, &impl_gettestkey);
+   patriciatrie_t          tree     = patriciatrie_FREE;
+   frozenpatriciatrie_t    frozen   = frozenpatriciatrie_FREE;
+   frozenpatriciatrie_t    loaded   = frozenpatriciatrie_FREE;
+   memblock_t              memblock = memblock_FREE;
+   memblock_t              content  = memblock_FREE;
+   directory_t           * tempdir  = 0;
+   char                    tmppath[128];
+   const unsigned          NRNODES  = 1+10+100+1000+10000;
+   testnode_t            * nodes;
+   patriciatrie_node_t   * found_node;
+   void * const          * addr;
+   int                     err;
+
+   // prepare: all keys of length 0..4 with digits 0..9 (keys are prefixes of each other)
+   free_testerrortimer(&s_errcounter);
+   TEST(0 == newtemp_directory(&tempdir, "patriciatest", &(wbuffer_t) wbuffer_INIT_STATIC(sizeof(tmppath), (uint8_t*)tmppath)));
+   TEST(0 == RESIZE_MM(sizeof(testnode_t) * NRNODES, &memblock));
+   nodes = (testnode_t*)memblock.addr;
+   memset(nodes, 0, sizeof(testnode_t) * NRNODES);
+   for (unsigned i = 0, len = 0, nr = 1; len <= 4; ++len, nr *= 10) {
+      for (unsigned k = 0; k < nr; ++k, ++i) {
+         nodes[i].key_len = len;
+         for (unsigned d = len, v = k; d > 0; --d, v /= 10) {
+            nodes[i].key[d-1] = (uint8_t) (v % 10);
+         }
+      }
+   }
+   init_patriciatrie(&tree, keyadapt);
+
+   // TEST frozenpatriciatrie_FREE
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+   TEST(0 == frozen.mapaddr);
+   TEST(0 == frozen.mapsize);
+
+   // TEST init_frozenpatriciatrie: empty tree
+   TEST(0 == init_frozenpatriciatrie(&frozen, &tree, 0));
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+   TEST(0 == sizeinbytes_frozenpatriciatrie(&frozen));
+   TEST(0 == at_frozenpatriciatrie(&frozen, 0, 0));
+   TEST(0 == at_frozenpatriciatrie(&frozen, 4, nodes[0].key));
+   TEST(0 == free_frozenpatriciatrie(&frozen));
+
+   // TEST init_frozenpatriciatrie: single node
+   TEST(0 == insert_patriciatrie(&tree, &nodes[NRNODES-1].node, 0));
+   TEST(0 == init_frozenpatriciatrie(&frozen, &tree, 0));
+   TEST(0 != frozen.mem);
+   TEST(0 == frozen.size % patriciatrie_frozennode_ALIGN);
+   TEST(frozen.size == size_patriciatriefrozennode(4));
+   addr = at_frozenpatriciatrie(&frozen, 4, nodes[NRNODES-1].key);
+   TEST(0 != addr);
+   TEST(&nodes[NRNODES-1] == *addr);
+   TEST(0 == at_frozenpatriciatrie(&frozen, 3, nodes[NRNODES-1].key));
+   TEST(0 == at_frozenpatriciatrie(&frozen, 4, nodes[NRNODES-2].key));
+   TEST(0 == free_frozenpatriciatrie(&frozen));
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+   TEST(0 == removenodes_patriciatrie(&tree, 0));
+
+   for (unsigned isremove = 0; isremove <= 1; ++isremove) {
+      // prepare
+      for (unsigned i = 0; i < NRNODES; ++i) {
+         TEST(0 == insert_patriciatrie(&tree, &nodes[i].node, 0));
+      }
+      for (unsigned i = 0; isremove && i < NRNODES; i += 3) {
+         TEST(0 == remove_patriciatrie(&tree, nodes[i].key_len, nodes[i].key, &found_node));
+      }
+
+      // TEST init_frozenpatriciatrie: getvalue == 0 stores address of object
+      TEST(0 == init_frozenpatriciatrie(&frozen, &tree, 0));
+      TEST(0 != frozen.mem);
+      TEST(0 == frozen.size % patriciatrie_frozennode_ALIGN);
+      TEST(frozen.size == sizeinbytes_frozenpatriciatrie(&frozen));
+      for (unsigned i = 0; i < NRNODES; ++i) {
+         addr = at_frozenpatriciatrie(&frozen, nodes[i].key_len, nodes[i].key);
+         err  = find_patriciatrie(&tree, nodes[i].key_len, nodes[i].key, &found_node);
+         TEST((0 == addr) == (ESRCH == err));
+         TEST((0 == addr) == (isremove && 0 == i % 3));
+         if (addr) {
+            TEST(&nodes[i] == *addr);
+         }
+      }
+      TEST(0 == free_frozenpatriciatrie(&frozen));
+
+      // TEST init_frozenpatriciatrie: getvalue
+      TEST(0 == init_frozenpatriciatrie(&frozen, &tree, &impl_gettestvalue));
+      TEST(0 == removenodes_patriciatrie(&tree, 0));
+      for (unsigned i = 0; i < NRNODES; ++i) {
+         addr = at_frozenpatriciatrie(&frozen, nodes[i].key_len, nodes[i].key);
+         TEST((0 == addr) == (isremove && 0 == i % 3));
+         if (addr) {
+            TEST(impl_gettestvalue(&nodes[i]) == *addr);
+         }
+      }
+
+      // TEST at_frozenpatriciatrie: key not stored
+      static const uint8_t notstored[6] = { 0, 0, 0, 0, 0, 10 };
+      for (unsigned i = 0; i < 6; ++i) {
+         TEST(0 == at_frozenpatriciatrie(&frozen, 5, notstored));
+         TEST(0 == at_frozenpatriciatrie(&frozen, 1+i, notstored+5-i));
+      }
+
+      if (isremove) break;
+      TEST(0 == free_frozenpatriciatrie(&frozen));
+   }
+
+   // TEST save_frozenpatriciatrie
+   TEST(0 == save_frozenpatriciatrie(&frozen, "snapshot", tempdir));
+   off_t filesize;
+   TEST(0 == filesize_directory(tempdir, "snapshot", &filesize));
+   TEST(filesize == (off_t) (sizeof(patriciatrie_snapshotheader_t) + frozen.size));
+
+   // TEST save_frozenpatriciatrie: EEXIST
+   TEST(EEXIST == save_frozenpatriciatrie(&frozen, "snapshot", tempdir));
+
+   // TEST initload_frozenpatriciatrie
+   TEST(0 == initload_frozenpatriciatrie(&loaded, "snapshot", tempdir));
+   TEST(loaded.mem  == loaded.mapaddr + sizeof(patriciatrie_snapshotheader_t));
+   TEST(loaded.size == frozen.size);
+   TEST(loaded.mapsize >= sizeof(patriciatrie_snapshotheader_t) + frozen.size);
+   TEST(0 == memcmp(loaded.mem, frozen.mem, frozen.size));
+   TEST(0 == removefile_directory(tempdir, "snapshot"));
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      addr = at_frozenpatriciatrie(&loaded, nodes[i].key_len, nodes[i].key);
+      TEST((0 == addr) == (0 == i % 3));
+      if (addr) {
+         TEST(impl_gettestvalue(&nodes[i]) == *addr);
+      }
+   }
+
+   // prepare: copy of file content
+   TEST(0 == ALLOC_MM(sizeof(patriciatrie_snapshotheader_t) + loaded.size, &content));
+   memcpy(content.addr, loaded.mapaddr, content.size);
+
+   // TEST free_frozenpatriciatrie: mapped snapshot
+   TEST(0 == free_frozenpatriciatrie(&loaded));
+   TEST(0 == loaded.mem);
+   TEST(0 == loaded.size);
+   TEST(0 == loaded.mapaddr);
+   TEST(0 == loaded.mapsize);
+   TEST(0 == free_frozenpatriciatrie(&loaded));
+
+   // TEST free_frozenpatriciatrie: mapped snapshot, simulated error
+   TEST(0 == save_file("snapshot", content.size, content.addr, tempdir));
+   TEST(0 == initload_frozenpatriciatrie(&loaded, "snapshot", tempdir));
+   init_testerrortimer(&s_patriciatrie_errtimer, 1, EINVAL);
+   TEST(EINVAL == free_frozenpatriciatrie(&loaded));
+   TEST(0 == loaded.mem);
+   TEST(0 == loaded.mapaddr);
+   TEST(0 == removefile_directory(tempdir, "snapshot"));
+
+   // TEST initload_frozenpatriciatrie: ENOENT
+   TEST(ENOENT == initload_frozenpatriciatrie(&loaded, "snapshot", tempdir));
+   TEST(0 == loaded.mapaddr);
+
+   // TEST initload_frozenpatriciatrie: EINVAL (truncated file, changed header or memory block)
+   size_t truncsize[] = { 0, sizeof(patriciatrie_snapshotheader_t)-1, content.size-1 };
+   for (unsigned i = 0; i < lengthof(truncsize); ++i) {
+      TEST(0 == save_file("snapshot", truncsize[i], content.addr, tempdir));
+      TEST(EINVAL == initload_frozenpatriciatrie(&loaded, "snapshot", tempdir));
+      TEST(0 == loaded.mapaddr);
+      TEST(0 == removefile_directory(tempdir, "snapshot"));
+   }
+   size_t changed[] = {
+      offsetof(patriciatrie_snapshotheader_t, magic), offsetof(patriciatrie_snapshotheader_t, version),
+      offsetof(patriciatrie_snapshotheader_t, byteorder), offsetof(patriciatrie_snapshotheader_t, ptrsize),
+      offsetof(patriciatrie_snapshotheader_t, size), offsetof(patriciatrie_snapshotheader_t, crc),
+      sizeof(patriciatrie_snapshotheader_t), content.size - 1
+   };
+   for (unsigned i = 0; i < lengthof(changed); ++i) {
+      content.addr[changed[i]] ^= 0x01;
+      TEST(0 == save_file("snapshot", content.size, content.addr, tempdir));
+      content.addr[changed[i]] ^= 0x01;
+      TEST(EINVAL == initload_frozenpatriciatrie(&loaded, "snapshot", tempdir));
+      TEST(0 == loaded.mapaddr);
+      TEST(0 == removefile_directory(tempdir, "snapshot"));
+   }
+
+   // TEST init_frozenpatriciatrie: simulated ENOMEM
+   TEST(0 == free_frozenpatriciatrie(&frozen));
+   for (unsigned i = 0; i < 100; ++i) {
+      TEST(0 == insert_patriciatrie(&tree, &nodes[i].node, 0));
+   }
+   for (unsigned errcount = 1; errcount <= 3; ++errcount) {
+      init_testerrortimer(&s_patriciatrie_errtimer, errcount, ENOMEM);
+      TEST(ENOMEM == init_frozenpatriciatrie(&frozen, &tree, 0));
+      TEST(0 == frozen.mem);
+      TEST(0 == frozen.size);
+   }
+   free_testerrortimer(&s_patriciatrie_errtimer);
+
+   // adapt log
+   uint8_t* logbuffer;
+   size_t   logsize;
+   GETBUFFER_ERRLOG(&logbuffer, &logsize);
+   while (strstr((char*)logbuffer, "/patriciatest.")) {
+      logbuffer = (uint8_t*)strstr((char*)logbuffer, "/patriciatest.")+14;
+      memcpy(logbuffer, "XXXXXX", 6);
+   }
+
+   // unprepare
+   TEST(0 == free_patriciatrie(&tree, 0));
+   TEST(0 == FREE_MM(&content));
+   TEST(0 == FREE_MM(&memblock));
+   TEST(0 == removedirectory_directory(0, tmppath));
+   TEST(0 == delete_directory(&tempdir));
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_patriciatrie_errtimer);
+   free_patriciatrie(&tree, 0);
+   free_frozenpatriciatrie(&frozen);
+   free_frozenpatriciatrie(&loaded);
+   FREE_MM(&content);
+   FREE_MM(&memblock);
+   if (tempdir) {
+      (void) removefile_directory(tempdir, "snapshot");
+      (void) removedirectory_directory(0, tmppath);
+      (void) delete_directory(&tempdir);
+   }
+   return EINVAL;
+}
+
 int unittest_ds_inmem_patriciatrie()
 {
    if (test_searchhelper())      goto ONERR;
@@ -2117,6 +3398,8 @@ int unittest_ds_inmem_patriciatrie()
    if (test_insertremove())      goto ONERR;
    if (test_iterator())          goto ONERR;
    if (test_generic())           goto ONERR;
+   if (test_concurrent())        goto ONERR;
+   if (test_frozen())            goto ONERR;
 
    return 0;
 ONERR:
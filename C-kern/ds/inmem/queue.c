@@ -28,6 +28,11 @@
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/ds/foreach.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: queue_page_t
@@ -461,6 +466,140 @@ ONERR:
 
 
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRELEM
+ * Number of elements inserted, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRELEM       (1024*1024)
+
+/* define: PT_NRELEM_SMALL
+ * Number of elements stored at the same time in <perftest_ds_inmem_queue_small>.
+ * The elements are inserted and removed <PT_NRELEM>/<PT_NRELEM_SMALL> times. */
+#define PT_NRELEM_SMALL 1024
+
+typedef struct pt_object_t {
+   uint64_t value;
+   uint64_t data;
+} pt_object_t;
+
+queue_IMPLEMENT(_ptqueue, pt_object_t)
+
+/* struct: pt_lifecycle_t
+ * Queue used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   queue_t     queue;
+   size_t      nrelem;
+   size_t      nrloop;
+   uint64_t    valuesum;
+} pt_lifecycle_t;
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrelem)
+{
+   int err;
+   memblock_t       mblock = memblock_FREE;
+   pt_lifecycle_t * plc;
+
+   err = ALLOC_MM(sizeof(pt_lifecycle_t), &mblock);
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) mblock.addr;
+   err = init_ptqueue(&plc->queue, 16384);
+   if (err) goto ONERR;
+   plc->nrelem   = nrelem;
+   plc->nrloop   = PT_NRELEM / nrelem;
+   plc->valuesum = (uint64_t)nrelem * (nrelem-1) / 2;
+
+   tinst->nrops = PT_NRELEM;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   (void) FREE_MM(&mblock);
+   return err;
+}
+
+static int pt_prepare_large(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRELEM_SMALL);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t       mblock = memblock_INIT(tinst->size, tinst->addr);
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+
+   err = free_ptqueue(&plc->queue);
+   int err2 = FREE_MM(&mblock);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   pt_object_t    * node;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrelem; ++i) {
+         err = insertlast_ptqueue(&plc->queue, &node);
+         if (err) return err;
+         node->value = i;
+         node->data  = loop;
+      }
+
+      uint64_t valuesum = 0;
+      foreach (_ptqueue, next, &plc->queue) {
+         valuesum += next->value;
+      }
+      if (valuesum != plc->valuesum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrelem; ++i) {
+         node = first_ptqueue(&plc->queue);
+         if (!node || node->value != i) return EINVAL;
+         err = removefirst_ptqueue(&plc->queue);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_queue(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_large, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single element of 1M elements in FIFO order",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_queue_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, iterate and remove a single element of 1K elements in FIFO order",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -19,6 +19,7 @@
 #include "C-kern/api/err.h"
 #include "C-kern/api/ds/typeadapt.h"
 #include "C-kern/api/ds/inmem/redblacktree.h"
+#include "C-kern/api/math/int/log2.h"
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/ds/foreach.h"
@@ -26,6 +27,13 @@
 #include "C-kern/api/memory/mm/mm_macros.h"
 #include "C-kern/api/test/errortimer.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: redblacktree_t
@@ -700,6 +708,196 @@ ONERR:
    return err ;
 }
 
+// group: bulk
+
+/* function: reddepth_redblacktree
+ * Returns the depth of the nodes colored red in a tree built by <buildsubtree_redblacktree>.
+ * The balanced tree has depth log2(nr_nodes). The deepest level could be incomplete.
+ * Coloring it red and all other levels black gives every path the same number of black nodes. */
+static inline unsigned reddepth_redblacktree(size_t nr_nodes)
+{
+   return nr_nodes > 1 ? log2_int(nr_nodes) : 1 ;
+}
+
+/* function: buildsubtree_redblacktree
+ * Builds a balanced tree from the first nr_nodes nodes of list and returns its root.
+ * The list is linked with the right pointer of the nodes. After return *list points
+ * to the first node not consumed. A node at depth reddepth is colored red, all others black.
+ * The parent pointer of the returned root is set to 0. */
+static redblacktree_node_t * buildsubtree_redblacktree(size_t nr_nodes, redblacktree_node_t ** list, unsigned depth, unsigned reddepth)
+{
+   if (! nr_nodes) return 0 ;
+
+   const size_t nr_left = nr_nodes / 2 ;
+   redblacktree_node_t * left = buildsubtree_redblacktree(nr_left, list, depth+1, reddepth) ;
+   redblacktree_node_t * root = *list ;
+   *list = root->right ;
+   redblacktree_node_t * right = buildsubtree_redblacktree(nr_nodes-nr_left-1, list, depth+1, reddepth) ;
+
+   root->left  = left ;
+   root->right = right ;
+   if (left)  SETPARENT(left, root) ;
+   if (right) SETPARENT(right, root) ;
+   if (depth == reddepth) {
+      SETPARENTRED(root, 0) ;
+   } else {
+      SETPARENTBLACK(root, 0) ;
+   }
+
+   return root ;
+}
+
+/* function: buildroot_redblacktree
+ * Sets tree->root to the tree built from nr_nodes nodes of list. */
+static void buildroot_redblacktree(redblacktree_t * tree, size_t nr_nodes, redblacktree_node_t * list)
+{
+   tree->root = buildsubtree_redblacktree(nr_nodes, &list, 0, reddepth_redblacktree(nr_nodes)) ;
+   if (tree->root) SETPARENTBLACK(tree->root, 0) ;
+}
+
+/* function: tolist_redblacktree
+ * Converts the tree with the given root into a list of nodes sorted in ascending order.
+ * The list is linked with the right pointer of the nodes. The left and parent pointers are not changed.
+ * The tree is traversed from the biggest to the smallest node. The predecessor of a node
+ * is computed before its right pointer is overwritten. */
+static redblacktree_node_t * tolist_redblacktree(redblacktree_node_t * root, /*out*/size_t * nr_nodes)
+{
+   redblacktree_node_t * list  = 0 ;
+   redblacktree_node_t * node  = root ;
+   size_t                count = 0 ;
+
+   if (node) {
+      while (node->right) node = node->right ;
+   }
+
+   while (node) {
+      redblacktree_node_t * prev ;
+      if (node->left) {
+         prev = node->left ;
+         while (prev->right) prev = prev->right ;
+      } else {
+         redblacktree_node_t * child = node ;
+         prev = PARENT(node) ;
+         while (prev && prev->left == child) {
+            child = prev ;
+            prev  = PARENT(prev) ;
+         }
+      }
+      node->right = list ;
+      list = node ;
+      ++ count ;
+      node = prev ;
+   }
+
+   *nr_nodes = count ;
+   return list ;
+}
+
+int build_redblacktree(redblacktree_t * tree, size_t nr_nodes, redblacktree_node_t * nodes[])
+{
+   int err ;
+
+   VALIDATE_INPARAM_TEST(0 == tree->root, ONERR, ) ;
+
+   for (size_t i = 0; i < nr_nodes; ++i) {
+      VALIDATE_INPARAM_TEST(EVENADDRESS(nodes[i]), ONERR, ) ;
+      VALIDATE_INPARAM_TEST(i == 0 || NODECOMPARE(nodes[i-1], nodes[i]) < 0, ONERR, ) ;
+   }
+
+   for (size_t i = 1; i < nr_nodes; ++i) {
+      nodes[i-1]->right = nodes[i] ;
+   }
+
+   buildroot_redblacktree(tree, nr_nodes, nr_nodes ? nodes[0] : 0) ;
+
+   return 0 ;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err ;
+}
+
+int buildlist_redblacktree(redblacktree_t * tree, redblacktree_node_t * first)
+{
+   int err ;
+   size_t nr_nodes = 0 ;
+
+   VALIDATE_INPARAM_TEST(0 == tree->root, ONERR, ) ;
+
+   for (redblacktree_node_t * node = first; node; node = node->right) {
+      VALIDATE_INPARAM_TEST(EVENADDRESS(node), ONERR, ) ;
+      VALIDATE_INPARAM_TEST(node->right == 0 || EVENADDRESS(node->right), ONERR, ) ;
+      VALIDATE_INPARAM_TEST(node->right == 0 || NODECOMPARE(node, node->right) < 0, ONERR, ) ;
+      ++ nr_nodes ;
+   }
+
+   buildroot_redblacktree(tree, nr_nodes, first) ;
+
+   return 0 ;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err ;
+}
+
+int merge_redblacktree(redblacktree_t * tree, redblacktree_t * fromtree)
+{
+   if (! fromtree->root) return 0 ;
+
+   if (! tree->root) {
+      tree->root = fromtree->root ;
+      fromtree->root = 0 ;
+      return 0 ;
+   }
+
+   // check for equal keys before any node is changed
+
+   {
+      redblacktree_iterator_t iter1 ;
+      redblacktree_iterator_t iter2 ;
+      redblacktree_node_t   * node1 ;
+      redblacktree_node_t   * node2 ;
+      (void) initfirst_redblacktreeiterator(&iter1, tree) ;
+      (void) initfirst_redblacktreeiterator(&iter2, fromtree) ;
+      bool isNext1 = next_redblacktreeiterator(&iter1, &node1) ;
+      bool isNext2 = next_redblacktreeiterator(&iter2, &node2) ;
+      while (isNext1 && isNext2) {
+         int cmp = NODECOMPARE(node1, node2) ;
+         if (cmp == 0) return EEXIST ;
+         if (cmp < 0) {
+            isNext1 = next_redblacktreeiterator(&iter1, &node1) ;
+         } else {
+            isNext2 = next_redblacktreeiterator(&iter2, &node2) ;
+         }
+      }
+   }
+
+   // merge sorted lists
+
+   size_t nr_nodes1 ;
+   size_t nr_nodes2 ;
+   redblacktree_node_t * list1 = tolist_redblacktree(tree->root, &nr_nodes1) ;
+   redblacktree_node_t * list2 = tolist_redblacktree(fromtree->root, &nr_nodes2) ;
+   redblacktree_node_t * first ;
+   redblacktree_node_t ** last = &first ;
+
+   while (list1 && list2) {
+      if (NODECOMPARE(list1, list2) < 0) {
+         *last = list1 ;
+         last  = &list1->right ;
+         list1 = list1->right ;
+      } else {
+         *last = list2 ;
+         last  = &list2->right ;
+         list2 = list2->right ;
+      }
+   }
+   *last = list1 ? list1 : list2 ;
+
+   fromtree->root = 0 ;
+   buildroot_redblacktree(tree, nr_nodes1 + nr_nodes2, first) ;
+
+   return 0 ;
+}
+
 // group: iterate
 
 int initfirst_redblacktreeiterator(/*out*/redblacktree_iterator_t * iter, redblacktree_t * tree)
@@ -791,6 +989,309 @@ bool prev_redblacktreeiterator(redblacktree_iterator_t * iter, /*out*/redblacktr
 
 // section: Functions
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NROPS
+ * Number of lookups executed by every perftest instance. */
+#define PT_NROPS     1000000
+
+/* define: PT_NRNODES
+ * Number of nodes stored in the tree of every perftest instance. */
+#define PT_NRNODES   65536
+
+typedef struct pt_object_t {
+   uintptr_t            key;
+   redblacktree_node_t  node;
+} pt_object_t;
+
+typeadapt_DECLARE(pt_adapt_t, pt_object_t, uintptr_t);
+
+/* struct: pt_tree_t
+ * Tree and nodes used by a single perftest instance. */
+typedef struct pt_tree_t {
+   pt_adapt_t     typeadapt;
+   redblacktree_t tree;
+   pt_object_t    object[PT_NRNODES];
+} pt_tree_t;
+
+static int pt_cmpkeyobj(pt_adapt_t * typeadp, const uintptr_t lkey, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+static int pt_cmpobj(pt_adapt_t * typeadp, const pt_object_t * lobject, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lobject->key == robject->key ? 0 : lobject->key < robject->key ? -1 : +1;
+}
+
+static inline int pt_cmpkeyobj_inline(const uintptr_t lkey, const pt_object_t * robject)
+{
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+redblacktree_IMPLEMENT(_pttree, pt_object_t, uintptr_t, node)
+
+redblacktree_IMPLEMENTCMP(_pttreecmp, pt_object_t, uintptr_t, node, pt_cmpkeyobj_inline)
+
+/* function: pt_nextkey
+ * Returns a pseudo random key. Keys in range [0..<PT_NRNODES>-1] are stored in the tree.
+ * About 90% of all returned keys are found. */
+static inline uintptr_t pt_nextkey(uint32_t * seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return (*seed >> 8) % (PT_NRNODES + PT_NRNODES/9);
+}
+
+static int pt_prepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t  mblock = memblock_FREE;
+   pt_tree_t * ptree;
+
+   err = ALLOC_MM(sizeof(pt_tree_t), &mblock);
+   if (err) return err;
+
+   ptree = (pt_tree_t*) mblock.addr;
+   ptree->typeadapt = (pt_adapt_t) typeadapt_INIT_LIFECMP(0, 0, &pt_cmpkeyobj, &pt_cmpobj);
+   typeadapt_member_t nodeadp = typeadapt_member_INIT(cast_typeadapt(&ptree->typeadapt, pt_adapt_t, pt_object_t, uintptr_t), offsetof(pt_object_t, node));
+   init_pttree(&ptree->tree, &nodeadp);
+
+   for (size_t i = 0; i < PT_NRNODES; ++i) {
+      ptree->object[i].key = i;
+      err = insert_pttree(&ptree->tree, &ptree->object[i]);
+      if (err) goto ONERR;
+   }
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   (void) FREE_MM(&mblock);
+   return err;
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   memblock_t mblock = memblock_INIT(tinst->size, tinst->addr);
+
+   // tree and nodes are part of mblock
+   return FREE_MM(&mblock);
+}
+
+static int pt_run(perftest_instance_t* tinst)
+{
+   pt_tree_t   * ptree = (pt_tree_t*) tinst->addr;
+   pt_object_t * node;
+   uint32_t      seed  = tinst->tid;
+   size_t        nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      uintptr_t key = pt_nextkey(&seed);
+      if (0 == find_pttree(&ptree->tree, key, &node)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+static int pt_run_cmp(perftest_instance_t* tinst)
+{
+   pt_tree_t   * ptree = (pt_tree_t*) tinst->addr;
+   pt_object_t * node;
+   uint32_t      seed  = tinst->tid;
+   size_t        nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      uintptr_t key = pt_nextkey(&seed);
+      if (0 == find_pttreecmp(&ptree->tree, key, &node)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+int perftest_ds_inmem_redblacktree(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run, &pt_unprepare),
+               "Searching a key in a tree of 65536 nodes (90% hits) with redblacktree_IMPLEMENT",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_redblacktree_cmp(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run_cmp, &pt_unprepare),
+               "Searching a key in a tree of 65536 nodes (90% hits) with redblacktree_IMPLEMENTCMP",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+/* define: PT_NRKEYS
+ * Number of keys inserted, searched, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRKEYS       (1024*1024)
+
+/* define: PT_NRKEYS_SMALL
+ * Number of keys stored at the same time in <perftest_ds_inmem_redblacktree_small>.
+ * The keys are inserted and removed <PT_NRKEYS>/<PT_NRKEYS_SMALL> times. */
+#define PT_NRKEYS_SMALL 1024
+
+/* struct: pt_lifecycle_t
+ * Tree and nodes used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   pt_adapt_t     typeadapt;
+   redblacktree_t tree;
+   size_t         nrkeys;
+   size_t         nrloop;
+   uintptr_t      keysum;
+   pt_object_t    object[/*nrkeys*/];
+} pt_lifecycle_t;
+
+/* function: pt_randomkey
+ * Returns a pseudo random key computed from i. Different values of i result in different keys. */
+static inline uintptr_t pt_randomkey(uintptr_t i)
+{
+   uintptr_t key = i * (uintptr_t) 0x9e3779b97f4a7c15;
+   return key ^ (key >> 29);
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrkeys, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrkeys * sizeof(pt_object_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage    = vmpage;
+   plc->typeadapt = (pt_adapt_t) typeadapt_INIT_LIFECMP(0, 0, &pt_cmpkeyobj, &pt_cmpobj);
+   typeadapt_member_t nodeadp = typeadapt_member_INIT(cast_typeadapt(&plc->typeadapt, pt_adapt_t, pt_object_t, uintptr_t), offsetof(pt_object_t, node));
+   init_pttree(&plc->tree, &nodeadp);
+   plc->nrkeys = nrkeys;
+   plc->nrloop = PT_NRKEYS / nrkeys;
+   plc->keysum = 0;
+
+   for (size_t i = 0; i < nrkeys; ++i) {
+      plc->object[i].key = israndom ? pt_randomkey(i) : i;
+      plc->keysum += plc->object[i].key;
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   // tree and nodes are part of vmpage
+   return free_vmpage(&vmpage);
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   pt_object_t    * node;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = insert_pttree(&plc->tree, &plc->object[i]);
+         if (err) return err;
+      }
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = find_pttree(&plc->tree, plc->object[i].key, &node);
+         if (err) return err;
+         if (node != &plc->object[i]) return EINVAL;
+      }
+
+      uintptr_t keysum = 0;
+      foreach (_pttree, next, &plc->tree) {
+         keysum += next->key;
+      }
+      if (keysum != plc->keysum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = remove_pttree(&plc->tree, &plc->object[i]);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_redblacktree_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M sequential keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_redblacktree_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_redblacktree_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1K random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -1681,6 +2182,212 @@ ONERR:
    return EINVAL ;
 }
 
+static int test_bulk(void)
+{
+   testadapt_t          typeadapt = {
+                           typeadapt_INIT_LIFECMP(0, &impl_deletenode_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt),
+                           test_errortimer_FREE, 0
+                        } ;
+   typeadapt_member_t   nodeadapt = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testnode_t, uintptr_t), offsetof(testnode_t, node)) ;
+   redblacktree_t       tree      = redblacktree_INIT(0, nodeadapt) ;
+   redblacktree_t       tree2     = redblacktree_INIT(0, nodeadapt) ;
+   const size_t         nrnodes   = 10000 ;
+   memblock_t           memblock  = memblock_FREE ;
+   testnode_t         * nodes ;
+   redblacktree_node_t** nodeptr ;
+   redblacktree_node_t* found ;
+   size_t               nr ;
+
+   // prepare
+   TEST(0 == ALLOC_MM(nrnodes * (sizeof(testnode_t) + sizeof(redblacktree_node_t*)), &memblock)) ;
+   nodes   = (testnode_t*) memblock.addr ;
+   nodeptr = (redblacktree_node_t**) (memblock.addr + nrnodes * sizeof(testnode_t)) ;
+   memset(nodes, 0, nrnodes * sizeof(testnode_t)) ;
+   for (size_t i = 0; i < nrnodes; ++i) {
+      nodes[i].key = i ;
+      nodeptr[i]   = &nodes[i].node ;
+   }
+
+   // TEST reddepth_redblacktree
+   TEST(1 == reddepth_redblacktree(0)) ;
+   TEST(1 == reddepth_redblacktree(1)) ;
+   TEST(1 == reddepth_redblacktree(2)) ;
+   TEST(1 == reddepth_redblacktree(3)) ;
+   TEST(2 == reddepth_redblacktree(4)) ;
+   TEST(2 == reddepth_redblacktree(7)) ;
+   TEST(3 == reddepth_redblacktree(8)) ;
+
+   // TEST build_redblacktree: all sizes
+   for (size_t size = 0; size <= nrnodes; size = (size < 600 ? size + 1 : 2*size + 1)) {
+      if (size > nrnodes) size = nrnodes ;
+      tree.root = 0 ;
+      TEST(0 == build_redblacktree(&tree, size, nodeptr)) ;
+      TEST(0 == invariant_redblacktree(&tree)) ;
+      TEST((size == 0) == (tree.root == 0)) ;
+      nr = 0 ;
+      foreach (_redblacktree, node, &tree) {
+         TEST(node == nodeptr[nr]) ;
+         ++ nr ;
+      }
+      TEST(size == nr) ;
+      for (size_t i = 0; i < size; i += 1 + size / 100) {
+         TEST(0 == find_redblacktree(&tree, (void*)i, &found)) ;
+         TEST(found == nodeptr[i]) ;
+      }
+      TEST(ESRCH == find_redblacktree(&tree, (void*)size, &found)) ;
+      if (size == nrnodes) break ;
+   }
+
+   // TEST build_redblacktree: tree could be changed after build
+   for (size_t i = 0; i < nrnodes; i += 2) {
+      TEST(0 == remove_redblacktree(&tree, nodeptr[i])) ;
+   }
+   TEST(0 == invariant_redblacktree(&tree)) ;
+   for (size_t i = 0; i < nrnodes; i += 2) {
+      TEST(0 == insert_redblacktree(&tree, nodeptr[i])) ;
+   }
+   TEST(0 == invariant_redblacktree(&tree)) ;
+
+   // TEST build_redblacktree: EINVAL (tree not empty)
+   redblacktree_node_t * root = tree.root ;
+   TEST(EINVAL == build_redblacktree(&tree, 1, nodeptr)) ;
+   TEST(root == tree.root) ;
+
+   // TEST build_redblacktree: EINVAL (nodes not sorted)
+   for (size_t i = 0; i < 2; ++i) {
+      tree.root = 0 ;
+      redblacktree_node_t * node = nodeptr[50] ;
+      nodeptr[50] = i ? nodeptr[49] : nodeptr[51] ;
+      TEST(EINVAL == build_redblacktree(&tree, 100, nodeptr)) ;
+      TEST(0 == tree.root) ;
+      nodeptr[50] = node ;
+   }
+
+   // TEST build_redblacktree: EINVAL (odd address)
+   nodeptr[10] = (redblacktree_node_t*) (1 + (uintptr_t)nodeptr[10]) ;
+   TEST(EINVAL == build_redblacktree(&tree, 100, nodeptr)) ;
+   TEST(0 == tree.root) ;
+   nodeptr[10] = (redblacktree_node_t*) ((uintptr_t)nodeptr[10] - 1) ;
+
+   // TEST buildlist_redblacktree: all sizes
+   for (size_t size = 0; size <= 600; ++size) {
+      for (size_t i = 0; i < size; ++i) {
+         nodeptr[i]->right = (i + 1 < size) ? nodeptr[i+1] : 0 ;
+      }
+      tree.root = 0 ;
+      TEST(0 == buildlist_redblacktree(&tree, size ? nodeptr[0] : 0)) ;
+      TEST(0 == invariant_redblacktree(&tree)) ;
+      nr = 0 ;
+      foreach (_redblacktree, node, &tree) {
+         TEST(node == nodeptr[nr]) ;
+         ++ nr ;
+      }
+      TEST(size == nr) ;
+   }
+
+   // TEST buildlist_redblacktree: EINVAL (tree not empty)
+   root = tree.root ;
+   TEST(EINVAL == buildlist_redblacktree(&tree, nodeptr[0])) ;
+   TEST(root == tree.root) ;
+
+   // TEST buildlist_redblacktree: EINVAL (nodes not sorted)
+   for (size_t i = 0; i < 100; ++i) {
+      nodeptr[i]->right = (i + 1 < 100) ? nodeptr[i+1] : 0 ;
+   }
+   nodeptr[49]->right = nodeptr[51] ;
+   nodeptr[51]->right = nodeptr[50] ;
+   nodeptr[50]->right = nodeptr[52] ;
+   tree.root = 0 ;
+   TEST(EINVAL == buildlist_redblacktree(&tree, nodeptr[0])) ;
+   TEST(0 == tree.root) ;
+
+   // TEST tolist_redblacktree
+   for (size_t i = 0; i < nrnodes; i += 3) {
+      TEST(0 == insert_redblacktree(&tree, nodeptr[i])) ;
+   }
+   found = tolist_redblacktree(tree.root, &nr) ;
+   TEST(nr == (nrnodes+2)/3) ;
+   for (size_t i = 0; i < nrnodes; i += 3, found = found->right) {
+      TEST(found == nodeptr[i]) ;
+   }
+   TEST(0 == found) ;
+   tree.root = 0 ;
+   found = tolist_redblacktree(tree.root, &nr) ;
+   TEST(0 == found) ;
+   TEST(0 == nr) ;
+
+   // TEST merge_redblacktree: interleaved keys
+   for (size_t i = 0; i < nrnodes; ++i) {
+      TEST(0 == insert_redblacktree((i % 3) ? &tree : &tree2, nodeptr[i])) ;
+   }
+   TEST(0 == merge_redblacktree(&tree, &tree2)) ;
+   TEST(0 == tree2.root) ;
+   TEST(0 == invariant_redblacktree(&tree)) ;
+   nr = 0 ;
+   foreach (_redblacktree, node, &tree) {
+      TEST(node == nodeptr[nr]) ;
+      ++ nr ;
+   }
+   TEST(nrnodes == nr) ;
+
+   // TEST merge_redblacktree: empty fromtree
+   root = tree.root ;
+   TEST(0 == merge_redblacktree(&tree, &tree2)) ;
+   TEST(root == tree.root) ;
+   TEST(0 == tree2.root) ;
+
+   // TEST merge_redblacktree: empty tree
+   TEST(0 == merge_redblacktree(&tree2, &tree)) ;
+   TEST(root == tree2.root) ;
+   TEST(0 == tree.root) ;
+   TEST(0 == invariant_redblacktree(&tree2)) ;
+
+   // TEST merge_redblacktree: disjoint ranges
+   tree.root  = 0 ;
+   tree2.root = 0 ;
+   TEST(0 == build_redblacktree(&tree, nrnodes/2, nodeptr + nrnodes/2)) ;
+   TEST(0 == build_redblacktree(&tree2, nrnodes/2, nodeptr)) ;
+   TEST(0 == merge_redblacktree(&tree, &tree2)) ;
+   TEST(0 == tree2.root) ;
+   TEST(0 == invariant_redblacktree(&tree)) ;
+   nr = 0 ;
+   foreach (_redblacktree, node, &tree) {
+      TEST(node == nodeptr[nr]) ;
+      ++ nr ;
+   }
+   TEST(nrnodes == nr) ;
+
+   // TEST merge_redblacktree: EEXIST
+   for (size_t i = 0; i < nrnodes; i += 2) {
+      TEST(0 == remove_redblacktree(&tree, nodeptr[i])) ;
+   }
+   testnode_t dupnodes[3] = { { .key = 0 }, { .key = 2 }, { .key = nrnodes-1 } } ;
+   TEST(0 == build_redblacktree(&tree2, 3, (redblacktree_node_t*[]) { &dupnodes[0].node, &dupnodes[1].node, &dupnodes[2].node })) ;
+   root = tree.root ;
+   redblacktree_node_t * root2 = tree2.root ;
+   TEST(EEXIST == merge_redblacktree(&tree, &tree2)) ;
+   TEST(root  == tree.root) ;
+   TEST(root2 == tree2.root) ;
+   TEST(0 == invariant_redblacktree(&tree)) ;
+   TEST(0 == invariant_redblacktree(&tree2)) ;
+   TEST(0 == remove_redblacktree(&tree2, &dupnodes[2].node)) ;
+   TEST(0 == merge_redblacktree(&tree, &tree2)) ;
+   TEST(0 == tree2.root) ;
+   TEST(0 == invariant_redblacktree(&tree)) ;
+   TEST(0 == find_redblacktree(&tree, (void*)2, &found)) ;
+   TEST(found == &dupnodes[1].node) ;
+   TEST(0 == find_redblacktree(&tree, (void*)(nrnodes-1), &found)) ;
+   TEST(found == nodeptr[nrnodes-1]) ;
+
+   // unprepare
+   TEST(0 == FREE_MM(&memblock)) ;
+
+   return 0 ;
+ONERR:
+   FREE_MM(&memblock) ;
+   return EINVAL ;
+}
+
 redblacktree_IMPLEMENT(_testtree, testnode_t, uintptr_t, node)
 
 static int test_generic(void)
@@ -1790,6 +2497,71 @@ ONERR:
    return EINVAL ;
 }
 
+static inline int test_cmpkeyobj_inline(const uintptr_t lkey, const testnode_t * rnode)
+{
+   uintptr_t rkey = rnode->key;
+   return lkey < rkey ? -1 : (lkey > rkey ? +1 : 0);
+}
+
+redblacktree_IMPLEMENTCMP(_testtreecmp, testnode_t, uintptr_t, node, test_cmpkeyobj_inline)
+
+static int test_genericcmp(void)
+{
+   testnode_t           nodes[100] ;
+   testadapt_t          typeadapt = {
+                           typeadapt_INIT_LIFECMP(0, &impl_deletenode_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt),
+                           test_errortimer_FREE, 0
+                        } ;
+   typeadapt_member_t   nodeadapt = typeadapt_member_INIT(cast_typeadapt(&typeadapt, testadapt_t, testnode_t, uintptr_t), offsetof(testnode_t, node)) ;
+   redblacktree_t       tree      = redblacktree_INIT(0, nodeadapt) ;
+   testnode_t           * found_node = 0 ;
+
+   // prepare
+   MEMSET0(&nodes) ;
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      nodes[i].key = 2*i+1 ;
+   }
+
+   // TEST find_testtreecmp: empty tree
+   init_testtreecmp(&tree, &nodeadapt) ;
+   TEST(ESRCH == find_testtreecmp(&tree, 1, &found_node)) ;
+
+   // TEST find_testtreecmp: same result as find_redblacktree
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      TEST(0 == insert_testtreecmp(&tree, &nodes[(i*7) % lengthof(nodes)])) ;
+   }
+   TEST(0 == invariant_testtreecmp(&tree)) ;
+   for (uintptr_t key = 0; key <= 2*lengthof(nodes)+1; ++key) {
+      testnode_t * found_node2 = 0 ;
+      found_node = 0 ;
+      int err = find_testtreecmp(&tree, key, &found_node) ;
+      TEST(err == ((key&1) && key < 2*lengthof(nodes) ? 0 : ESRCH)) ;
+      TEST(err == find_testtree(&tree, key, &found_node2)) ;
+      TEST(found_node == found_node2) ;
+      if (!err) TEST(found_node == &nodes[key/2]) ;
+   }
+
+   // TEST find_testtreecmp: removed nodes are not found
+   for (unsigned i = 0; i < lengthof(nodes); i += 2) {
+      TEST(0 == remove_testtreecmp(&tree, &nodes[i])) ;
+   }
+   for (unsigned i = 0; i < lengthof(nodes); ++i) {
+      found_node = 0 ;
+      if (i % 2) {
+         TEST(0 == find_testtreecmp(&tree, nodes[i].key, &found_node)) ;
+         TEST(found_node == &nodes[i]) ;
+      } else {
+         TEST(ESRCH == find_testtreecmp(&tree, nodes[i].key, &found_node)) ;
+         TEST(0 == found_node) ;
+      }
+   }
+   TEST(0 == free_testtreecmp(&tree)) ;
+
+   return 0 ;
+ONERR:
+   return EINVAL ;
+}
+
 int unittest_ds_inmem_redblacktree()
 {
    if (test_initfree())          goto ONERR;
@@ -1797,7 +2569,9 @@ int unittest_ds_inmem_redblacktree()
    if (test_removeconditions())  goto ONERR;
    if (test_insertremove())      goto ONERR;
    if (test_iterator())          goto ONERR;
+   if (test_bulk())              goto ONERR;
    if (test_generic())           goto ONERR;
+   if (test_genericcmp())        goto ONERR;
 
    return 0 ;
 ONERR:
@@ -29,6 +29,13 @@
 #include "C-kern/api/memory/mm/mm_macros.h"
 #include "C-kern/api/test/errortimer.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: splaytree_t
@@ -631,6 +638,310 @@ bool prev_splaytreeiterator(splaytree_iterator_t * iter, /*out*/splaytree_node_t
 }
 
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NROPS
+ * Number of lookups executed by every perftest instance. */
+#define PT_NROPS     1000000
+
+/* define: PT_NRNODES
+ * Number of nodes stored in the tree of every perftest instance. */
+#define PT_NRNODES   65536
+
+typedef struct pt_object_t {
+   intptr_t          key;
+   splaytree_node_t  node;
+} pt_object_t;
+
+typeadapt_DECLARE(pt_adapt_t, pt_object_t, intptr_t);
+
+/* struct: pt_tree_t
+ * Tree and nodes used by a single perftest instance. */
+typedef struct pt_tree_t {
+   pt_adapt_t     typeadapt;
+   splaytree_t    tree;
+   pt_object_t    object[PT_NRNODES];
+} pt_tree_t;
+
+static int pt_cmpkeyobj(pt_adapt_t * typeadp, const intptr_t lkey, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+static int pt_cmpobj(pt_adapt_t * typeadp, const pt_object_t * lobject, const pt_object_t * robject)
+{
+   (void) typeadp;
+   return lobject->key == robject->key ? 0 : lobject->key < robject->key ? -1 : +1;
+}
+
+static inline int pt_cmpkeyobj_inline(const intptr_t lkey, const pt_object_t * robject)
+{
+   return lkey == robject->key ? 0 : lkey < robject->key ? -1 : +1;
+}
+
+splaytree_IMPLEMENT(_pttree, pt_object_t, intptr_t, node)
+
+splaytree_IMPLEMENTCMP(_pttreecmp, pt_object_t, intptr_t, node, pt_cmpkeyobj_inline)
+
+/* function: pt_nextkey
+ * Returns a pseudo random key. Keys in range [0..<PT_NRNODES>-1] are stored in the tree.
+ * About 90% of all returned keys are found. */
+static inline intptr_t pt_nextkey(uint32_t * seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   return (intptr_t) ((*seed >> 8) % (PT_NRNODES + PT_NRNODES/9));
+}
+
+static int pt_prepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t  mblock = memblock_FREE;
+   pt_tree_t * ptree;
+
+   err = ALLOC_MM(sizeof(pt_tree_t), &mblock);
+   if (err) return err;
+
+   ptree = (pt_tree_t*) mblock.addr;
+   ptree->typeadapt = (pt_adapt_t) typeadapt_INIT_LIFECMP(0, 0, &pt_cmpkeyobj, &pt_cmpobj);
+   init_pttree(&ptree->tree);
+
+   typeadapt_t * typeadp = cast_typeadapt(&ptree->typeadapt, pt_adapt_t, pt_object_t, intptr_t);
+   for (size_t i = 0; i < PT_NRNODES; ++i) {
+      ptree->object[i].key = (intptr_t) i;
+      err = insert_pttree(&ptree->tree, &ptree->object[i], typeadp);
+      if (err) goto ONERR;
+   }
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   (void) FREE_MM(&mblock);
+   return err;
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   memblock_t mblock = memblock_INIT(tinst->size, tinst->addr);
+
+   // tree and nodes are part of mblock
+   return FREE_MM(&mblock);
+}
+
+static int pt_run(perftest_instance_t* tinst)
+{
+   pt_tree_t   * ptree   = (pt_tree_t*) tinst->addr;
+   typeadapt_t * typeadp = cast_typeadapt(&ptree->typeadapt, pt_adapt_t, pt_object_t, intptr_t);
+   pt_object_t * node;
+   uint32_t      seed    = tinst->tid;
+   size_t        nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      intptr_t key = pt_nextkey(&seed);
+      if (0 == find_pttree(&ptree->tree, key, &node, typeadp)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+static int pt_run_cmp(perftest_instance_t* tinst)
+{
+   pt_tree_t   * ptree   = (pt_tree_t*) tinst->addr;
+   pt_object_t * node;
+   uint32_t      seed    = tinst->tid;
+   size_t        nrfound = 0;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      intptr_t key = pt_nextkey(&seed);
+      if (0 == find_pttreecmp(&ptree->tree, key, &node, 0)) {
+         ++ nrfound;
+      }
+   }
+
+   return nrfound ? 0 : EINVAL;
+}
+
+int perftest_ds_inmem_splaytree(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run, &pt_unprepare),
+               "Searching a key in a tree of 65536 nodes (90% hits) with splaytree_IMPLEMENT",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_splaytree_cmp(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run_cmp, &pt_unprepare),
+               "Searching a key in a tree of 65536 nodes (90% hits) with splaytree_IMPLEMENTCMP",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+/* define: PT_NRKEYS
+ * Number of keys inserted, searched, iterated and removed by a lifecycle perftest instance. */
+#define PT_NRKEYS       (1024*1024)
+
+/* define: PT_NRKEYS_SMALL
+ * Number of keys stored at the same time in <perftest_ds_inmem_splaytree_small>.
+ * The keys are inserted and removed <PT_NRKEYS>/<PT_NRKEYS_SMALL> times. */
+#define PT_NRKEYS_SMALL 1024
+
+/* struct: pt_lifecycle_t
+ * Tree and nodes used by a single instance of a lifecycle perftest. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   pt_adapt_t     typeadapt;
+   splaytree_t    tree;
+   size_t         nrkeys;
+   size_t         nrloop;
+   uintptr_t      keysum;
+   pt_object_t    object[/*nrkeys*/];
+} pt_lifecycle_t;
+
+/* function: pt_randomkey
+ * Returns a pseudo random key computed from i. Different values of i result in different keys. */
+static inline intptr_t pt_randomkey(uintptr_t i)
+{
+   uintptr_t key = i * (uintptr_t) 0x9e3779b97f4a7c15;
+   return (intptr_t) (key ^ (key >> 29));
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrkeys, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrkeys * sizeof(pt_object_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage    = vmpage;
+   plc->typeadapt = (pt_adapt_t) typeadapt_INIT_LIFECMP(0, 0, &pt_cmpkeyobj, &pt_cmpobj);
+   init_pttree(&plc->tree);
+   plc->nrkeys = nrkeys;
+   plc->nrloop = PT_NRKEYS / nrkeys;
+   plc->keysum = 0;
+
+   for (size_t i = 0; i < nrkeys; ++i) {
+      plc->object[i].key = israndom ? pt_randomkey(i) : (intptr_t) i;
+      plc->keysum += (uintptr_t) plc->object[i].key;
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   // tree and nodes are part of vmpage
+   return free_vmpage(&vmpage);
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc     = (pt_lifecycle_t*) tinst->addr;
+   typeadapt_t    * typeadp = cast_typeadapt(&plc->typeadapt, pt_adapt_t, pt_object_t, intptr_t);
+   pt_object_t    * node;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = insert_pttree(&plc->tree, &plc->object[i], typeadp);
+         if (err) return err;
+      }
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = find_pttree(&plc->tree, plc->object[i].key, &node, typeadp);
+         if (err) return err;
+         if (node != &plc->object[i]) return EINVAL;
+      }
+
+      uintptr_t keysum = 0;
+      foreach (_pttree, next, &plc->tree, typeadp) {
+         keysum += (uintptr_t) next->key;
+      }
+      if (keysum != plc->keysum) return EINVAL;
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = remove_pttree(&plc->tree, &plc->object[i], typeadp);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_splaytree_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M sequential keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_splaytree_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1M random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_splaytree_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find, iterate and remove a single key of 1K random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -1327,12 +1638,115 @@ ONERR:
    return EINVAL ;
 }
 
+static inline int test_cmpkeyobj_inline(const intptr_t lkey, const testnode_t * rnode)
+{
+   intptr_t rkey = rnode->key;
+   return sign_int(lkey - rkey);
+}
+
+splaytree_IMPLEMENTCMP(_testtreecmp, testnode_t, intptr_t, index, test_cmpkeyobj_inline)
+
+/* function: isequalshape_testtree
+ * Returns true if both trees have the same shape and nodes at the same position have the same index. */
+static bool isequalshape_testtree(splaytree_node_t * node1, testnode_t * nodes1, splaytree_node_t * node2, testnode_t * nodes2)
+{
+   if (!node1 || !node2) return node1 == node2;
+   if (  (testnode_t*)((uintptr_t)node1 - offsetof(testnode_t, index)) - nodes1
+         != (testnode_t*)((uintptr_t)node2 - offsetof(testnode_t, index)) - nodes2) {
+      return false;
+   }
+   return isequalshape_testtree(node1->left, nodes1, node2->left, nodes2)
+          && isequalshape_testtree(node1->right, nodes1, node2->right, nodes2);
+}
+
+static int test_genericcmp(void)
+{
+   testadapt_t                typeadapt = {
+      typeadapt_INIT_LIFECMP(0, &impl_deletenode_testadapt, &impl_cmpkeyobj_testadapt, &impl_cmpobj_testadapt),
+      test_errortimer_FREE, 0
+   } ;
+   typeadapt_t *              typeadp   = cast_typeadapt(&typeadapt, testadapt_t, testnode_t, intptr_t) ;
+   memblock_t                 memblock1 = memblock_FREE ;
+   splaytree_t                tree1     = splaytree_FREE ;
+   splaytree_t                tree2     = splaytree_FREE ;
+   const unsigned             NRNODES   = 1000 ;
+   testnode_t                 * nodes1 ;
+   testnode_t                 * nodes2 ;
+   testnode_t                 * found_node ;
+
+   // prepare
+   TEST(0 == RESIZE_MM(2 * NRNODES * sizeof(testnode_t), &memblock1)) ;
+   nodes1 = (testnode_t*)memblock1.addr ;
+   nodes2 = nodes1 + NRNODES ;
+   memset(nodes1, 0, 2 * NRNODES * sizeof(testnode_t)) ;
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      nodes1[i].key = 2*(int)i+1 ;
+      nodes2[i].key = 2*(int)i+1 ;
+   }
+
+   // TEST find_testtreecmp: empty tree
+   init_testtreecmp(&tree2) ;
+   TEST(ESRCH == find_testtreecmp(&tree2, 1, &found_node, 0)) ;
+   TEST(0 == tree2.root) ;
+
+   // TEST find_testtreecmp: splays the same as find_splaytree
+   init_testtree(&tree1) ;
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      unsigned n = (i * 337) % NRNODES ;
+      TEST(0 == insert_testtree(&tree1, &nodes1[n], typeadp)) ;
+      TEST(0 == insert_testtreecmp(&tree2, &nodes2[n], typeadp)) ;
+   }
+   TEST(isequalshape_testtree(tree1.root, nodes1, tree2.root, nodes2)) ;
+   srandom(123) ;
+   for (unsigned i = 0; i < 10*NRNODES; ++i) {
+      intptr_t     key = random() % (2*(intptr_t)NRNODES+2) ;
+      testnode_t * found_node1 = 0 ;
+      found_node = 0 ;
+      int err = find_testtreecmp(&tree2, key, &found_node, 0) ;
+      TEST(err == ((key&1) && key < 2*(intptr_t)NRNODES ? 0 : ESRCH)) ;
+      TEST(err == find_testtree(&tree1, key, &found_node1, typeadp)) ;
+      if (err) {
+         TEST(0 == found_node) ;
+      } else {
+         TEST(found_node == &nodes2[key/2]) ;
+         TEST(found_node1 == &nodes1[key/2]) ;
+      }
+      TEST(isequalshape_testtree(tree1.root, nodes1, tree2.root, nodes2)) ;
+   }
+   TEST(0 == invariant_testtreecmp(&tree2, typeadp)) ;
+
+   // TEST find_testtreecmp: removed nodes are not found
+   for (unsigned i = 0; i < NRNODES; i += 2) {
+      TEST(0 == remove_testtreecmp(&tree2, &nodes2[i], typeadp)) ;
+   }
+   for (unsigned i = 0; i < NRNODES; ++i) {
+      found_node = 0 ;
+      if (i % 2) {
+         TEST(0 == find_testtreecmp(&tree2, nodes2[i].key, &found_node, 0)) ;
+         TEST(found_node == &nodes2[i]) ;
+      } else {
+         TEST(ESRCH == find_testtreecmp(&tree2, nodes2[i].key, &found_node, 0)) ;
+         TEST(0 == found_node) ;
+      }
+   }
+   TEST(0 == invariant_testtreecmp(&tree2, typeadp)) ;
+
+   // unprepare
+   TEST(0 == FREE_MM(&memblock1)) ;
+
+   return 0 ;
+ONERR:
+   FREE_MM(&memblock1) ;
+   return EINVAL ;
+}
+
 int unittest_ds_inmem_splaytree()
 {
    if (test_initfree())       goto ONERR;
    if (test_insertremove())   goto ONERR;
    if (test_iterator())       goto ONERR;
    if (test_generic())        goto ONERR;
+   if (test_genericcmp())     goto ONERR;
 
    return 0 ;
 ONERR:
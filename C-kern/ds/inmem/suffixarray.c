@@ -0,0 +1,859 @@
+/* title: Suffix-Array impl
+
+   Implements <Suffix-Array>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/inmem/suffixarray.h
+    Header file of <Suffix-Array>.
+
+   file: C-kern/ds/inmem/suffixarray.c
+    Implementation file of <Suffix-Array impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/ds/inmem/suffixarray.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/errortimer.h"
+#include "C-kern/api/test/validate.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/resourceusage.h"
+#include "C-kern/api/test/unittest.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/wbuffer.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#include "C-kern/api/io/filesystem/fileutil.h"
+#endif
+
+
+// section: suffixarray_t
+
+// group: static variables
+
+#ifdef KONFIG_UNITTEST
+/* variable: s_suffixarray_errtimer
+ * Simulates an error in <build_suffixarray>. */
+static test_errortimer_t   s_suffixarray_errtimer = test_errortimer_FREE;
+#endif
+
+// group: types
+
+/* define: EMPTY
+ * Marks an unused entry of the suffix array during construction. */
+#define EMPTY UINT32_MAX
+
+/* define: WORKSPACE_RESERVE
+ * Number of bytes allocated in addition to the suffix and LCP array.
+ * Makes sure that the workspace of SA-IS is large enough for very short input strings. */
+#define WORKSPACE_RESERVE 2048
+
+/* struct: sais_text_t
+ * The string whose suffixes are sorted by <sais_suffixarray>.
+ * The last character is the unique smallest character (sentinel).
+ * On the first level the string is the input text and the sentinel is virtual.
+ * Every byte of the input text is shifted by one so that 0 is only used by the sentinel.
+ * On deeper levels the string is an array of uint32_t which contains the sentinel. */
+typedef struct sais_text_t {
+   /* variable: s8
+    * Input text without sentinel. Set to 0 on deeper levels. */
+   const uint8_t  * s8;
+   /* variable: s32
+    * Reduced string of names (with sentinel 0). Only valid if <s8> is 0. */
+   const uint32_t * s32;
+   /* variable: n
+    * Length of the string including the sentinel. */
+   uint32_t         n;
+} sais_text_t;
+
+/* struct: sais_workspace_t
+ * Stack allocator of temporary memory used by <sais_suffixarray>.
+ * The memory is located where the LCP array is computed later. */
+typedef struct sais_workspace_t {
+   /* variable: next
+    * Start address of unused memory. Always aligned to uint32_t. */
+   uint8_t * next;
+   /* variable: end
+    * End address of the workspace memory. */
+   uint8_t * end;
+} sais_workspace_t;
+
+// group: sais-helper
+
+/* function: chr_sais
+ * Returns character at position i of text. */
+static inline uint32_t chr_sais(const sais_text_t * text, uint32_t i)
+{
+   if (text->s8) return i + 1 < text->n ? (uint32_t)text->s8[i] + 1 : 0;
+   return text->s32[i];
+}
+
+/* function: istypeS_sais
+ * Returns true if suffix i is of type S (smaller than suffix i+1). */
+static inline bool istypeS_sais(const uint8_t * type, uint32_t i)
+{
+   return (type[i/8] >> (i%8)) & 1;
+}
+
+/* function: settype_sais
+ * Sets type of suffix i to S (isS == true) or L (isS == false). */
+static inline void settype_sais(uint8_t * type, uint32_t i, bool isS)
+{
+   type[i/8] = (uint8_t) ((type[i/8] & ~(1u << (i%8))) | ((unsigned)isS << (i%8)));
+}
+
+/* function: isLMS_sais
+ * Returns true if suffix i is a leftmost S suffix (S type and predecessor is L type). */
+static inline bool isLMS_sais(const uint8_t * type, uint32_t i)
+{
+   return i > 0 && istypeS_sais(type, i) && ! istypeS_sais(type, i-1);
+}
+
+/* function: alloc_saisworkspace
+ * Returns size bytes of memory from the workspace or 0 if there is not enough memory. */
+static inline void * alloc_saisworkspace(sais_workspace_t * ws, size_t size)
+{
+   size = (size + sizeof(uint32_t)-1) & ~(sizeof(uint32_t)-1);
+   if (size > (size_t) (ws->end - ws->next)) return 0;
+   void * mem = ws->next;
+   ws->next += size;
+   return mem;
+}
+
+/* function: getbuckets_sais
+ * Computes start (isend == false) or end (isend == true) index of every bucket.
+ * A bucket contains all suffixes which begin with the same character. */
+static void getbuckets_sais(const sais_text_t * text, uint32_t * bkt, uint32_t K, bool isend)
+{
+   uint32_t sum = 0;
+
+   memset(bkt, 0, (K+1) * sizeof(uint32_t));
+   for (uint32_t i = 0; i < text->n; ++i) {
+      ++ bkt[chr_sais(text, i)];
+   }
+   for (uint32_t i = 0; i <= K; ++i) {
+      sum += bkt[i];
+      bkt[i] = isend ? sum : sum - bkt[i];
+   }
+}
+
+/* function: induceL_sais
+ * Induces the order of L type suffixes from the sorted LMS suffixes. */
+static void induceL_sais(const sais_text_t * text, const uint8_t * type, uint32_t * SA, uint32_t * bkt, uint32_t K)
+{
+   getbuckets_sais(text, bkt, K, false);
+   for (uint32_t i = 0; i < text->n; ++i) {
+      if (SA[i] != EMPTY && SA[i] > 0) {
+         uint32_t j = SA[i] - 1;
+         if (! istypeS_sais(type, j)) SA[bkt[chr_sais(text, j)]++] = j;
+      }
+   }
+}
+
+/* function: induceS_sais
+ * Induces the order of S type suffixes from the sorted L type suffixes. */
+static void induceS_sais(const sais_text_t * text, const uint8_t * type, uint32_t * SA, uint32_t * bkt, uint32_t K)
+{
+   getbuckets_sais(text, bkt, K, true);
+   for (uint32_t i = text->n; (i--) > 0; ) {
+      if (SA[i] != EMPTY && SA[i] > 0) {
+         uint32_t j = SA[i] - 1;
+         if (istypeS_sais(type, j)) SA[--bkt[chr_sais(text, j)]] = j;
+      }
+   }
+}
+
+/* function: sais_suffixarray
+ * Computes the suffix array SA of text with SA-IS.
+ * All characters of text are in range [0..K]. The array SA must have text->n entries.
+ * SA[0] is always the position of the sentinel.
+ * The LMS substrings are sorted and named. If not all names are unique
+ * the suffix array of the reduced string of names is computed recursively.
+ * The reduced string has at most half the length of text. */
+static int sais_suffixarray(const sais_text_t * text, uint32_t * SA, uint32_t K, sais_workspace_t * ws)
+{
+   const uint32_t n = text->n;
+   uint8_t      * type;
+   uint32_t     * bkt;
+
+   type = alloc_saisworkspace(ws, n/8 + 1);
+   if (!type) return ENOMEM;
+   bkt  = alloc_saisworkspace(ws, (K+1) * sizeof(uint32_t));
+   if (!bkt) return ENOMEM;
+
+   // classify suffixes; sentinel is S type and its predecessor L type
+   settype_sais(type, n-1, true);
+   settype_sais(type, n-2, false);
+   for (uint32_t i = n-2; (i--) > 0; ) {
+      uint32_t c0 = chr_sais(text, i);
+      uint32_t c1 = chr_sais(text, i+1);
+      settype_sais(type, i, c0 < c1 || (c0 == c1 && istypeS_sais(type, i+1)));
+   }
+
+   // stage 1: sort LMS substrings
+   getbuckets_sais(text, bkt, K, true);
+   memset(SA, 255, n * sizeof(uint32_t));
+   for (uint32_t i = 1; i < n; ++i) {
+      if (isLMS_sais(type, i)) SA[--bkt[chr_sais(text, i)]] = i;
+   }
+   induceL_sais(text, type, SA, bkt, K);
+   induceS_sais(text, type, SA, bkt, K);
+   ws->next = (uint8_t*) bkt;
+
+   // compact sorted LMS substrings into first n1 entries (2*n1 <= n)
+   uint32_t n1 = 0;
+   for (uint32_t i = 0; i < n; ++i) {
+      if (isLMS_sais(type, SA[i])) SA[n1++] = SA[i];
+   }
+
+   // name LMS substrings; equal substrings get the same name
+   memset(SA + n1, 255, (n - n1) * sizeof(uint32_t));
+   uint32_t name = 0;
+   uint32_t prev = EMPTY;
+   for (uint32_t i = 0; i < n1; ++i) {
+      uint32_t pos  = SA[i];
+      bool     diff = false;
+      for (uint32_t d = 0; d < n; ++d) {
+         if (  prev == EMPTY
+               || chr_sais(text, pos+d) != chr_sais(text, prev+d)
+               || istypeS_sais(type, pos+d) != istypeS_sais(type, prev+d)) {
+            diff = true;
+            break;
+         } else if (d > 0 && (isLMS_sais(type, pos+d) || isLMS_sais(type, prev+d))) {
+            break;
+         }
+      }
+      if (diff) {
+         ++ name;
+         prev = pos;
+      }
+      SA[n1 + pos/2] = name - 1;
+   }
+   for (uint32_t i = n, j = n; (i--) > n1; ) {
+      if (SA[i] != EMPTY) SA[--j] = SA[i];
+   }
+
+   // stage 2: sort reduced string s1
+   uint32_t * SA1 = SA;
+   uint32_t * s1  = SA + n - n1;
+   if (name < n1) {
+      sais_text_t text1 = { 0, s1, n1 };
+      int err = sais_suffixarray(&text1, SA1, name - 1, ws);
+      if (err) return err;
+   } else {
+      for (uint32_t i = 0; i < n1; ++i) SA1[s1[i]] = i;
+   }
+
+   // stage 3: induce suffix array from sorted LMS suffixes
+   bkt = alloc_saisworkspace(ws, (K+1) * sizeof(uint32_t));
+   if (!bkt) return ENOMEM;
+   getbuckets_sais(text, bkt, K, true);
+   for (uint32_t i = 1, j = 0; i < n; ++i) {
+      if (isLMS_sais(type, i)) s1[j++] = i;
+   }
+   for (uint32_t i = 0; i < n1; ++i) {
+      SA1[i] = s1[SA1[i]];
+   }
+   memset(SA + n1, 255, (n - n1) * sizeof(uint32_t));
+   for (uint32_t i = n1; (i--) > 0; ) {
+      uint32_t j = SA[i];
+      SA[i] = EMPTY;
+      SA[--bkt[chr_sais(text, j)]] = j;
+   }
+   induceL_sais(text, type, SA, bkt, K);
+   induceS_sais(text, type, SA, bkt, K);
+
+   ws->next = type;
+
+   return 0;
+}
+
+// group: helper
+
+/* function: computelcp_suffixarray
+ * Computes the LCP array with the Φ algorithm.
+ * First lcp[SA[i]] is set to SA[i-1] (Φ array). Then the permuted LCP array is computed in place
+ * which is indexed by text position. PLCP[i+1] >= PLCP[i]-1 makes it run in time O(n).
+ * At last PLCP is copied into temp and permuted into suffix array order. */
+static int computelcp_suffixarray(size_t length, const uint8_t text[length], const uint32_t * SA, /*out*/uint32_t * lcp)
+{
+   int err;
+   vmpage_t temp;
+
+   lcp[SA[0]] = EMPTY;
+   for (size_t i = 1; i < length; ++i) {
+      lcp[SA[i]] = SA[i-1];
+   }
+
+   size_t l = 0;
+   for (size_t i = 0; i < length; ++i) {
+      uint32_t prev = lcp[i];
+      if (prev == EMPTY) {
+         lcp[i] = 0;
+         l = 0;
+         continue;
+      }
+      size_t maxl = length - (i > prev ? i : prev);
+      while (l < maxl && text[i+l] == text[prev+l]) ++l;
+      lcp[i] = (uint32_t) l;
+      if (l) --l;
+   }
+
+   if (! PROCESS_testerrortimer(&s_suffixarray_errtimer, &err)) {
+      err = init_vmpage(&temp, length * sizeof(uint32_t));
+   }
+   if (err) return err;
+
+   uint32_t * plcp = (uint32_t*) temp.addr;
+   memcpy(plcp, lcp, length * sizeof(uint32_t));
+   for (size_t i = 0; i < length; ++i) {
+      lcp[i] = plcp[SA[i]];
+   }
+
+   err = free_vmpage(&temp);
+   (void) PROCESS_testerrortimer(&s_suffixarray_errtimer, &err);
+
+   return err;
+}
+
+/* function: lowerbound_suffixarray
+ * Returns index of the smallest suffix which is greater or equal to str
+ * or which begins with str. Returns length of sarray if no such suffix exists. */
+static size_t lowerbound_suffixarray(const suffixarray_t * sarray, size_t length, const uint8_t str[length])
+{
+   size_t low  = 0;
+   size_t high = sarray->length;
+
+   while (low < high) {
+      size_t mid       = low + (high - low) / 2;
+      size_t pos       = sarray->sa[mid];
+      size_t suffixlen = sarray->length - pos;
+      int    cmp       = memcmp(sarray->text + pos, str, suffixlen < length ? suffixlen : length);
+      if (cmp < 0 || (cmp == 0 && suffixlen < length)) {
+         low = mid + 1;
+      } else {
+         high = mid;
+      }
+   }
+
+   return low;
+}
+
+/* function: findrange_suffixarray
+ * Returns the range [first, end) of all suffixes which begin with str.
+ * The end of the range is found by scanning the LCP array.
+ *
+ * Returns:
+ * 0     - At least one suffix begins with str.
+ * ESRCH - str is empty or no suffix begins with str. */
+static int findrange_suffixarray(const suffixarray_t * sarray, size_t length, const uint8_t str[length], /*out*/size_t * first, /*out*/size_t * end)
+{
+   if (0 == length || length > sarray->length) return ESRCH;
+
+   size_t i = lowerbound_suffixarray(sarray, length, str);
+
+   if (  i == sarray->length
+         || sarray->length - sarray->sa[i] < length
+         || 0 != memcmp(sarray->text + sarray->sa[i], str, length)) {
+      return ESRCH;
+   }
+
+   *first = i;
+   while (++i < sarray->length && sarray->lcp[i] >= length) ;
+   *end = i;
+
+   return 0;
+}
+
+// group: lifetime
+
+int free_suffixarray(suffixarray_t * sarray)
+{
+   int err;
+
+   err = clear_suffixarray(sarray);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+bool isstring_suffixarray(const suffixarray_t * sarray, size_t length, const uint8_t searchstr[length])
+{
+   size_t first;
+   size_t end;
+
+   return 0 == findrange_suffixarray(sarray, length, searchstr, &first, &end);
+}
+
+int matchall_suffixarray(
+   const suffixarray_t * sarray,
+   size_t         length,
+   const uint8_t  searchstr[length],
+   size_t         skip_count,
+   /*out*/size_t  * matched_count,
+   size_t         maxmatchcount,
+   /*out*/const uint8_t * matchedpos[maxmatchcount])
+{
+   int err;
+   size_t first;
+   size_t end;
+
+   err = findrange_suffixarray(sarray, length, searchstr, &first, &end);
+   if (err) return err;
+
+   *matched_count = end - first;
+
+   if (skip_count < end - first) {
+      size_t count = end - first - skip_count;
+      if (count > maxmatchcount) count = maxmatchcount;
+      first += skip_count;
+      for (size_t i = 0; i < count; ++i) {
+         matchedpos[i] = sarray->text + sarray->sa[first + i];
+      }
+   }
+
+   return 0;
+}
+
+// group: build
+
+int build_suffixarray(suffixarray_t * sarray, size_t length, const uint8_t input_string[length])
+{
+   int err;
+   vmpage_t mem = vmpage_FREE;
+
+   VALIDATE_INPARAM_TEST(length <= suffixarray_MAXLENGTH, ONERR, PRINTSIZE_ERRLOG(length));
+
+   err = clear_suffixarray(sarray);
+   if (err) goto ONERR;
+
+   if (length) {
+      if (! PROCESS_testerrortimer(&s_suffixarray_errtimer, &err)) {
+         err = init_vmpage(&mem, (2*length + 1) * sizeof(uint32_t) + WORKSPACE_RESERVE);
+      }
+      if (err) goto ONERR;
+
+      // SA contains the sentinel at SA[0]
+      uint32_t       * SA   = (uint32_t*) mem.addr;
+      uint32_t       * lcp  = SA + length + 1;
+      sais_text_t      text = { input_string, 0, (uint32_t) (length + 1) };
+      sais_workspace_t ws   = { (uint8_t*) lcp, mem.addr + mem.size };
+
+      err = sais_suffixarray(&text, SA, 256, &ws);
+      (void) PROCESS_testerrortimer(&s_suffixarray_errtimer, &err);
+      if (err) goto ONERR;
+
+      err = computelcp_suffixarray(length, input_string, SA + 1, lcp);
+      if (err) goto ONERR;
+
+      sarray->sa      = SA + 1;
+      sarray->lcp     = lcp;
+      sarray->mem     = mem.addr;
+      sarray->memsize = mem.size;
+   }
+
+   sarray->text   = input_string;
+   sarray->length = length;
+
+   return 0;
+ONERR:
+   free_vmpage(&mem);
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int clear_suffixarray(suffixarray_t * sarray)
+{
+   int err;
+   vmpage_t mem = vmpage_INIT(sarray->memsize, sarray->mem);
+
+   *sarray = (suffixarray_t) suffixarray_FREE;
+
+   err = free_vmpage(&mem);
+   (void) PROCESS_testerrortimer(&s_suffixarray_errtimer, &err);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+static int test_initfree(void)
+{
+   suffixarray_t sarray = suffixarray_FREE;
+   const uint8_t * text = (const uint8_t*) "ABABC";
+   const uint32_t sa[5]  = { 0, 2, 1, 3, 4 };
+   const uint32_t lcp[5] = { 0, 2, 0, 1, 0 };
+
+   // TEST suffixarray_FREE
+   TEST(0 == sarray.text);
+   TEST(0 == sarray.length);
+   TEST(0 == sarray.sa);
+   TEST(0 == sarray.lcp);
+   TEST(0 == sarray.mem);
+   TEST(0 == sarray.memsize);
+
+   // TEST init_suffixarray
+   memset(&sarray, 255, sizeof(sarray));
+   init_suffixarray(&sarray);
+   TEST(0 == sarray.text);
+   TEST(0 == sarray.length);
+   TEST(0 == sarray.sa);
+   TEST(0 == sarray.lcp);
+   TEST(0 == sarray.mem);
+   TEST(0 == sarray.memsize);
+
+   // TEST build_suffixarray: empty string
+   TEST(0 == build_suffixarray(&sarray, 0, text));
+   TEST(text == sarray.text);
+   TEST(0 == sarray.length);
+   TEST(0 == sarray.sa);
+   TEST(0 == sarray.mem);
+   TEST(0 == length_suffixarray(&sarray));
+
+   // TEST build_suffixarray
+   TEST(0 == build_suffixarray(&sarray, 5, text));
+   TEST(text == sarray.text);
+   TEST(5 == sarray.length);
+   TEST(0 != sarray.mem);
+   TEST(0 <  sarray.memsize);
+   TEST(sarray.sa  == (uint32_t*)sarray.mem + 1);
+   TEST(sarray.lcp == sarray.sa + 5);
+   TEST(5 == length_suffixarray(&sarray));
+   for (unsigned i = 0; i < 5; ++i) {
+      TEST(sa[i]  == suffix_suffixarray(&sarray, i));
+      TEST(lcp[i] == lcp_suffixarray(&sarray, i));
+   }
+
+   // TEST free_suffixarray
+   TEST(0 == free_suffixarray(&sarray));
+   TEST(0 == sarray.text);
+   TEST(0 == sarray.length);
+   TEST(0 == sarray.sa);
+   TEST(0 == sarray.lcp);
+   TEST(0 == sarray.mem);
+   TEST(0 == sarray.memsize);
+   TEST(0 == free_suffixarray(&sarray));
+   TEST(0 == sarray.mem);
+
+   // TEST clear_suffixarray
+   TEST(0 == build_suffixarray(&sarray, 5, text));
+   TEST(0 != sarray.mem);
+   TEST(0 == clear_suffixarray(&sarray));
+   TEST(0 == sarray.text);
+   TEST(0 == sarray.length);
+   TEST(0 == sarray.mem);
+
+   // TEST build_suffixarray: EINVAL
+   const uint8_t * volatile bigtext = text; // text is not read
+   TEST(EINVAL == build_suffixarray(&sarray, suffixarray_MAXLENGTH+1, bigtext));
+   TEST(0 == sarray.mem);
+
+   // TEST build_suffixarray: ENOMEM
+   for (unsigned i = 1; i <= 5; ++i) {
+      init_testerrortimer(&s_suffixarray_errtimer, i, ENOMEM);
+      TEST(ENOMEM == build_suffixarray(&sarray, 5, text));
+      TEST(0 == sarray.text);
+      TEST(0 == sarray.length);
+      TEST(0 == sarray.mem);
+   }
+   free_testerrortimer(&s_suffixarray_errtimer);
+
+   // TEST free_suffixarray: ENOMEM
+   TEST(0 == build_suffixarray(&sarray, 5, text));
+   init_testerrortimer(&s_suffixarray_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == free_suffixarray(&sarray));
+   TEST(0 == sarray.text);
+   TEST(0 == sarray.mem);
+
+   return 0;
+ONERR:
+   free_suffixarray(&sarray);
+   return EINVAL;
+}
+
+/* function: compare_suffix
+ * Compares suffix at pos1 with suffix at pos2. Returns also the length of the common prefix. */
+static int compare_suffix(size_t length, const uint8_t * text, size_t pos1, size_t pos2, /*out*/size_t * prefixlen)
+{
+   size_t l = 0;
+   while (pos1 + l < length && pos2 + l < length && text[pos1+l] == text[pos2+l]) ++l;
+   *prefixlen = l;
+   if (pos1 + l == length) return -1;
+   if (pos2 + l == length) return +1;
+   return text[pos1+l] < text[pos2+l] ? -1 : +1;
+}
+
+/* function: check_suffixarray
+ * Checks that sarray contains all suffixes in sorted order and a correct LCP array. */
+static int check_suffixarray(const suffixarray_t * sarray, size_t length, const uint8_t * text, uint8_t * seen)
+{
+   TEST(text   == sarray->text);
+   TEST(length == sarray->length);
+
+   memset(seen, 0, length);
+   for (size_t i = 0; i < length; ++i) {
+      size_t pos = suffix_suffixarray(sarray, i);
+      TEST(pos < length);
+      TEST(0 == seen[pos]);
+      seen[pos] = 1;
+      if (i) {
+         size_t prefixlen;
+         TEST(0 > compare_suffix(length, text, suffix_suffixarray(sarray, i-1), pos, &prefixlen));
+         TEST(prefixlen == lcp_suffixarray(sarray, i));
+      } else {
+         TEST(0 == lcp_suffixarray(sarray, i));
+      }
+   }
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_build(void)
+{
+   suffixarray_t sarray = suffixarray_FREE;
+   memblock_t    mem    = memblock_FREE;
+   const size_t  maxlen = 200000;
+   const size_t  lens[] = { 1, 2, 3, 4, 5, 10, 31, 100, 1000, 5000 };
+   const unsigned alphabet[] = { 1, 2, 3, 4, 26, 256 };
+   uint8_t     * text;
+   uint8_t     * seen;
+
+   // prepare
+   TEST(0 == ALLOC_MM(2*maxlen, &mem));
+   text = mem.addr;
+   seen = mem.addr + maxlen;
+
+   // TEST build_suffixarray: random text
+   for (unsigned ai = 0; ai < lengthof(alphabet); ++ai) {
+      for (unsigned li = 0; li < lengthof(lens); ++li) {
+         for (size_t i = 0; i < lens[li]; ++i) {
+            text[i] = (uint8_t) ('a' + (unsigned)random() % alphabet[ai]);
+         }
+         TEST(0 == build_suffixarray(&sarray, lens[li], text));
+         TEST(0 == check_suffixarray(&sarray, lens[li], text, seen));
+      }
+   }
+
+   // TEST build_suffixarray: long random text
+   for (unsigned ai = 2; ai < lengthof(alphabet); ++ai) {
+      for (size_t i = 0; i < maxlen; ++i) {
+         text[i] = (uint8_t) ((unsigned)random() % alphabet[ai]);
+      }
+      TEST(0 == build_suffixarray(&sarray, maxlen, text));
+      TEST(0 == check_suffixarray(&sarray, maxlen, text, seen));
+   }
+
+   // TEST build_suffixarray: periodic text (deep recursion)
+   for (unsigned period = 1; period <= 7; ++period) {
+      for (size_t i = 0; i < 5000; ++i) {
+         text[i] = (uint8_t) (i % period);
+      }
+      TEST(0 == build_suffixarray(&sarray, 5000, text));
+      TEST(0 == check_suffixarray(&sarray, 5000, text, seen));
+   }
+
+   // TEST build_suffixarray: fibonacci string S(n) = S(n-1) S(n-2)
+   {
+      size_t len1 = 1; // length of S(n-2) which is prefix of S(n-1)
+      size_t len2 = 2; // length of S(n-1)
+      memcpy(text, "ab", 2);
+      while (len1 + len2 <= 20000) {
+         memcpy(text + len2, text, len1);
+         len2 += len1;
+         len1  = len2 - len1;
+      }
+      TEST(0 == build_suffixarray(&sarray, len2, text));
+      TEST(0 == check_suffixarray(&sarray, len2, text, seen));
+   }
+
+   // unprepare
+   TEST(0 == free_suffixarray(&sarray));
+   TEST(0 == FREE_MM(&mem));
+
+   return 0;
+ONERR:
+   free_suffixarray(&sarray);
+   FREE_MM(&mem);
+   return EINVAL;
+}
+
+static int compare_ptr_f(const void * ptr1, const void * ptr2)
+{
+   const uint8_t * p1 = *(const uint8_t * const *)ptr1;
+   const uint8_t * p2 = *(const uint8_t * const *)ptr2;
+   return p1 < p2 ? -1 : p1 > p2 ? +1 : 0;
+}
+
+static int test_query(void)
+{
+   suffixarray_t sarray = suffixarray_FREE;
+   const uint8_t * text = (const uint8_t*) "ABABABCABCXABCABCABABC";
+   const size_t    text_len = strlen((const char*)text);
+   const uint8_t * matched_pos[30];
+   const uint8_t * matched_pos2[30];
+   size_t          matched_count;
+
+   // prepare
+   TEST(0 == build_suffixarray(&sarray, text_len, text));
+
+   // TEST isstring_suffixarray: every substring is found
+   for (size_t start = 0; start < text_len; ++start) {
+      for (size_t len = 1; start + len <= text_len; ++len) {
+         TEST(true == isstring_suffixarray(&sarray, len, text + start));
+      }
+   }
+
+   // TEST isstring_suffixarray: not found
+   TEST(false == isstring_suffixarray(&sarray, 0, text));
+   TEST(false == isstring_suffixarray(&sarray, text_len+1, text));
+   TEST(false == isstring_suffixarray(&sarray, 1, (const uint8_t*)"D"));
+   TEST(false == isstring_suffixarray(&sarray, 1, (const uint8_t*)"0"));
+   TEST(false == isstring_suffixarray(&sarray, 4, (const uint8_t*)"ABCD"));
+   TEST(false == isstring_suffixarray(&sarray, 4, (const uint8_t*)"BCAA"));
+   TEST(false == isstring_suffixarray(&sarray, 4, (const uint8_t*)"ABC\0"));
+
+   // TEST matchall_suffixarray: compare with linear search
+   for (size_t start = 0; start < text_len; ++start) {
+      for (size_t len = 1; start + len <= text_len; ++len) {
+         size_t count = 0;
+         for (size_t i = 0; i + len <= text_len; ++i) {
+            if (0 == memcmp(text + i, text + start, len)) matched_pos2[count++] = text + i;
+         }
+         TEST(0 == matchall_suffixarray(&sarray, len, text + start, 0, &matched_count, lengthof(matched_pos), matched_pos));
+         TEST(count == matched_count);
+         qsort(matched_pos, matched_count, sizeof(matched_pos[0]), &compare_ptr_f);
+         for (size_t i = 0; i < count; ++i) {
+            TEST(matched_pos2[i] == matched_pos[i]);
+         }
+      }
+   }
+
+   // TEST matchall_suffixarray: skip_count and maxmatchcount
+   TEST(0 == matchall_suffixarray(&sarray, 1, (const uint8_t*)"A", 0, &matched_count, lengthof(matched_pos2), matched_pos2));
+   TEST(8 == matched_count);
+   for (size_t skip = 0; skip <= 9; ++skip) {
+      for (size_t max = 0; max <= 9; ++max) {
+         memset(matched_pos, 0, sizeof(matched_pos));
+         TEST(0 == matchall_suffixarray(&sarray, 1, (const uint8_t*)"A", skip, &matched_count, max, matched_pos));
+         TEST(8 == matched_count);
+         size_t valid = skip < 8 ? 8 - skip : 0;
+         if (valid > max) valid = max;
+         for (size_t i = 0; i < lengthof(matched_pos); ++i) {
+            TEST((i < valid ? matched_pos2[skip+i] : 0) == matched_pos[i]);
+         }
+      }
+   }
+
+   // TEST matchall_suffixarray: ESRCH
+   matched_count = 1;
+   TEST(ESRCH == matchall_suffixarray(&sarray, 0, text, 0, &matched_count, 10, matched_pos));
+   TEST(ESRCH == matchall_suffixarray(&sarray, text_len+1, text, 0, &matched_count, 10, matched_pos));
+   TEST(ESRCH == matchall_suffixarray(&sarray, 3, (const uint8_t*)"ABD", 0, &matched_count, 10, matched_pos));
+   TEST(ESRCH == matchall_suffixarray(&sarray, 3, (const uint8_t*)"XX", 0, &matched_count, 10, matched_pos));
+   TEST(1 == matched_count); // not changed
+
+   // TEST matchall_suffixarray: whole text
+   TEST(0 == matchall_suffixarray(&sarray, text_len, text, 0, &matched_count, 10, matched_pos));
+   TEST(1 == matched_count);
+   TEST(text == matched_pos[0]);
+
+   // TEST isstring_suffixarray, matchall_suffixarray: empty suffix array
+   TEST(0 == build_suffixarray(&sarray, 0, text));
+   TEST(false == isstring_suffixarray(&sarray, 1, text));
+   TEST(ESRCH == matchall_suffixarray(&sarray, 1, text, 0, &matched_count, 10, matched_pos));
+
+   // unprepare
+   TEST(0 == free_suffixarray(&sarray));
+
+   return 0;
+ONERR:
+   free_suffixarray(&sarray);
+   return EINVAL;
+}
+
+static int test_matchfile(void)
+{
+   suffixarray_t  sarray     = suffixarray_FREE;
+   memblock_t     file_data  = memblock_FREE;
+   memblock_t     seen       = memblock_FREE;
+   size_t         file_size  = 0;
+   const uint8_t* teststring = (const uint8_t*) "suffixarray_t";
+   const size_t   testlen    = strlen((const char*)teststring);
+   const uint8_t* matched_pos[200];
+   size_t         matched_count;
+   size_t         count = 0;
+
+   // prepare
+   // open and read this source file
+   {
+      wbuffer_t wbuf = wbuffer_INIT_MEMBLOCK(&file_data);
+      TEST(0 == load_file(__FILE__, &wbuf, 0));
+      file_size = size_wbuffer(&wbuf);
+   }
+   TEST(0 == ALLOC_MM(file_size, &seen));
+
+   // TEST matchall_suffixarray with source file
+   TEST(0 == build_suffixarray(&sarray, file_size, file_data.addr));
+   TEST(0 == check_suffixarray(&sarray, file_size, file_data.addr, seen.addr));
+   TEST(0 == matchall_suffixarray(&sarray, testlen, teststring, 0, &matched_count, lengthof(matched_pos), matched_pos));
+   TEST(10 < matched_count && matched_count < lengthof(matched_pos));
+   qsort(matched_pos, matched_count, sizeof(matched_pos[0]), &compare_ptr_f);
+   for (size_t i = 0; i + testlen <= file_size; ++i) {
+      if (0 == memcmp(file_data.addr + i, teststring, testlen)) {
+         TEST(count < matched_count);
+         TEST(file_data.addr + i == matched_pos[count]);
+         ++ count;
+      }
+   }
+   TEST(count == matched_count);
+
+   // unprepare
+   TEST(0 == free_suffixarray(&sarray));
+   TEST(0 == FREE_MM(&file_data));
+   TEST(0 == FREE_MM(&seen));
+
+   return 0;
+ONERR:
+   free_suffixarray(&sarray);
+   FREE_MM(&file_data);
+   FREE_MM(&seen);
+   return EINVAL;
+}
+
+int unittest_ds_inmem_suffixarray()
+{
+   resourceusage_t usage = resourceusage_FREE;
+
+   TEST(0 == init_resourceusage(&usage));
+
+   if (test_initfree())    goto ONERR;
+   if (test_build())       goto ONERR;
+   if (test_query())       goto ONERR;
+   if (test_matchfile())   goto ONERR;
+
+   TEST(0 == same_resourceusage(&usage));
+   TEST(0 == free_resourceusage(&usage));
+
+   return 0;
+ONERR:
+   (void) free_resourceusage(&usage);
+   return EINVAL;
+}
+
+#endif
@@ -18,13 +18,27 @@
 #include "C-kern/konfig.h"
 #include "C-kern/api/ds/inmem/trie.h"
 #include "C-kern/api/err.h"
+#include "C-kern/api/io/accessmode.h"
+#include "C-kern/api/io/iochannel.h"
+#include "C-kern/api/io/filesystem/file.h"
+#include "C-kern/api/math/hash/crc32.h"
 #include "C-kern/api/math/int/power2.h"
 #include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/vm.h"
 #include "C-kern/api/test/errortimer.h"
 #include "C-kern/api/test/mm/err_macros.h"
 #ifdef KONFIG_UNITTEST
+#include "C-kern/api/io/filesystem/directory.h"
+#include "C-kern/api/io/filesystem/fileutil.h"
+#include "C-kern/api/memory/wbuffer.h"
 #include "C-kern/api/test/unittest.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/test/perftest.h"
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // forward
 #ifdef KONFIG_UNITTEST
@@ -531,9 +545,47 @@ static inline unsigned childoff4_trienode(const trie_node_t * node)
  * The found index is returned in childidx.
  * A return value of true indicates that digit is found
  * else the digit is not found and childidx contains the index
- * where digit should be inserted. */
+ * where digit should be inserted.
+ *
+ * If the target supports SSE2 16 digits are compared at once.
+ * Cause digits is sorted the number of digits less than digit
+ * is the insert position if digit is not found. */
 static inline int findchild_trienode(uint8_t digit, uint8_t nrchild, const uint8_t digits[nrchild], /*out*/uint8_t * childidx)
 {
+#ifdef __SSE2__
+   const __m128i key = _mm_set1_epi8((char) digit);
+   unsigned      i   = 0;
+
+   for (; i < nrchild; i += 16) {
+      __m128i  chunk;
+      uint32_t valid = 0xffff;
+      if (i + 16 <= nrchild) {
+         chunk = _mm_loadu_si128((const __m128i*) (digits + i));
+      } else {
+         // never read beyond end of digits
+         uint8_t tail[16] = { 0 };
+         memcpy(tail, digits + i, nrchild - i);
+         chunk = _mm_loadu_si128((const __m128i*) tail);
+         valid = (1u << (nrchild - i)) - 1;
+      }
+
+      uint32_t equal = valid & (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, key));
+      if (equal) {
+         *childidx = (uint8_t) (i + (unsigned) __builtin_ctz(equal));
+         return true;
+      }
+
+      // max(digits[x], digit) == digit <==> digits[x] <= digit (unsigned)
+      uint32_t less = valid & (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, key), key));
+      if (less != 0xffff) {
+         *childidx = (uint8_t) (i + (unsigned) __builtin_popcount(less));
+         return false;
+      }
+   }
+
+   *childidx = nrchild;
+   return false;
+#else
    unsigned high   = nrchild;
    unsigned low    = 0;
    unsigned middle = high >> 1;
@@ -551,6 +603,7 @@ static inline int findchild_trienode(uint8_t digit, uint8_t nrchild, const uint8
 
    *childidx = (uint8_t) high;
    return false;
+#endif
 }
 
 // group: change-helper
@@ -1918,8 +1971,605 @@ void ** at_trie(const trie_t * trie, uint16_t keylen, const uint8_t key[keylen])
 
 
 
+
+// section: frozentrie_t
+
+/* struct: trie_frozennode_t
+ * Describes the layout of a node stored in <frozentrie_t>.
+ * The fixed header is followed by the child offsets, the key,
+ * the digit array and an optional value.
+ *
+ * The child array contains 256 entries if header_SUBNODE is set
+ * (the digit is used as index) else nrchild entries and a digit array
+ * with nrchild sorted digits which is searched with <findchild_trienode>.
+ * A child offset of 0 means there is no child (the root is stored at offset 0).
+ *
+ * Memory Layout:
+ * > header | keylen | nrchild | child[nrchild or 256] | key[keylen] | digit[nrchild] | align | value
+ * Every node starts at an offset aligned to <PTRALIGN>. */
+typedef struct trie_frozennode_t {
+   /* variable: header
+    * Only <header_VALUE> and <header_SUBNODE> are used. */
+   header_t header;
+   /* variable: keylen
+    * Length of key[] following the child array. */
+   uint8_t  keylen;
+   /* variable: nrchild
+    * Number of digits and child offsets. In case of header_SUBNODE
+    * it counts the number of child offsets not 0. */
+   uint16_t nrchild;
+   /* variable: child
+    * Offsets of child nodes relative to <frozentrie_t.mem>. */
+   uint32_t child[];
+} trie_frozennode_t;
+
+// group: helper
+
+/* function: nrslot_triefrozennode
+ * Returns the size of the child array. */
+static inline unsigned nrslot_triefrozennode(const int issubnode, const unsigned nrchild)
+{
+   return issubnode ? 256u : nrchild;
+}
+
+/* function: offkey_triefrozennode
+ * Returns the offset of the key following the child array. */
+static inline unsigned offkey_triefrozennode(const unsigned nrslot)
+{
+   return (unsigned) offsetof(trie_frozennode_t, child) + nrslot * (unsigned) sizeof(uint32_t);
+}
+
+/* function: offvalue_triefrozennode
+ * Returns the offset of the value following the key and digit array. */
+static inline unsigned offvalue_triefrozennode(const unsigned offkey, const unsigned keylen, const unsigned digitsize)
+{
+   return alignoffset_trienode(offkey + keylen + digitsize);
+}
+
+/* function: size_triefrozennode
+ * Returns the size of the frozen node. It is big enough to store a pointer to
+ * the unfrozen node it is built from (see <init_frozentrie>). */
+static inline unsigned size_triefrozennode(const unsigned offvalue, const int isvalue)
+{
+   unsigned size = offvalue + valuesize_trienode(isvalue);
+   return size < sizeof(trie_node_t*) ? (unsigned) sizeof(trie_node_t*) : size;
+}
+
+/* function: frozensize_trienode
+ * Returns the size of the frozen copy of node. */
+static inline unsigned frozensize_trienode(const trie_node_t * node)
+{
+   int      issubnode = issubnode_trienode(node);
+   unsigned nrslot    = nrslot_triefrozennode(issubnode, nrchild_trienode(node));
+   unsigned offkey    = offkey_triefrozennode(nrslot);
+   unsigned offvalue  = offvalue_triefrozennode(offkey, keylen_trienode(node), digitsize_trienode(issubnode, nrchild_trienode(node)));
+   return size_triefrozennode(offvalue, isvalue_trienode(node));
+}
+
+/* function: reserve_frozentrie
+ * Reserves size bytes at offset *end and stores the address of node in it.
+ * The memory block is doubled in size if necessary.
+ * The reserved offset is returned in childoff and *end is incremented by size. */
+static int reserve_frozentrie(memblock_t * mblock, /*inout*/size_t * end, const trie_node_t * node, /*out*/uint32_t * childoff)
+{
+   int err;
+   unsigned size   = frozensize_trienode(node);
+   size_t   newend = *end + size;
+
+   if (newend > UINT32_MAX) return EOVERFLOW;
+
+   if (newend > mblock->size) {
+      size_t newsize = 2 * mblock->size;
+      while (newsize < newend) newsize *= 2;
+      err = RESIZE_ERR_MM(&s_trie_errtimer, newsize, mblock);
+      if (err) return err;
+   }
+
+   // node is read back by init_frozentrie when the reserved node is processed
+   memcpy(mblock->addr + *end, &node, sizeof(node));
+
+   *childoff = (uint32_t) *end;
+   *end      = newend;
+
+   return 0;
+}
+
+/* struct: trie_snapshotheader_t
+ * Header of a snapshot file written by <save_frozentrie>.
+ * It is followed by the memory block of <frozentrie_t>.
+ * Its size is a multiple of <PTRALIGN> so the mapped memory block
+ * keeps the alignment of its nodes. */
+typedef struct trie_snapshotheader_t {
+   /* variable: magic
+    * Contains "CKTRIE\0\0". */
+   uint8_t  magic[8];
+   /* variable: version
+    * Contains <frozentrie_SNAPSHOTVERSION>. */
+   uint32_t version;
+   /* variable: byteorder
+    * Contains 0x0102 in the byte order of the writing system. */
+   uint16_t byteorder;
+   /* variable: ptrsize
+    * Contains sizeof(void*) of the writing system. */
+   uint8_t  ptrsize;
+   /* variable: reserved1
+    * Set to 0. */
+   uint8_t  reserved1;
+   /* variable: size
+    * Size in bytes of the memory block following the header. */
+   uint64_t size;
+   /* variable: crc
+    * The crc32 checksum of the memory block following the header. */
+   uint32_t crc;
+   /* variable: reserved2
+    * Set to 0. */
+   uint32_t reserved2;
+} trie_snapshotheader_t;
+
+/* define: trie_snapshotheader_MAGIC
+ * The first 8 bytes of a snapshot file. */
+#define trie_snapshotheader_MAGIC "CKTRIE\0"
+
+/* function: init_triesnapshotheader
+ * Initializes header which describes the memory block of frozen. */
+static void init_triesnapshotheader(/*out*/trie_snapshotheader_t * header, const frozentrie_t * frozen)
+{
+   static_assert(sizeof(trie_snapshotheader_t) == 32, "file format is fixed");
+   static_assert(0 == sizeof(trie_snapshotheader_t) % PTRALIGN, "keeps alignment of nodes");
+   memcpy(header->magic, trie_snapshotheader_MAGIC, sizeof(header->magic));
+   header->version   = frozentrie_SNAPSHOTVERSION;
+   header->byteorder = 0x0102;
+   header->ptrsize   = (uint8_t) sizeof(void*);
+   header->reserved1 = 0;
+   header->size      = frozen->size;
+   header->crc       = calculate_crc32(frozen->size, frozen->mem);
+   header->reserved2 = 0;
+}
+
+/* function: check_triesnapshotheader
+ * Returns 0 if header describes a valid memory block of size bytes following the header.
+ * The memory block is checked against the stored crc32 checksum.
+ * EINVAL is returned in case of an invalid or corrupted snapshot. */
+static int check_triesnapshotheader(const trie_snapshotheader_t * header, size_t size)
+{
+   if (  0 != memcmp(header->magic, trie_snapshotheader_MAGIC, sizeof(header->magic))
+         || frozentrie_SNAPSHOTVERSION != header->version
+         || 0x0102 != header->byteorder
+         || sizeof(void*) != header->ptrsize
+         || size != header->size
+         || size > UINT32_MAX
+         || 0 != size % PTRALIGN) {
+      return EINVAL;
+   }
+
+   if (header->crc != calculate_crc32(size, (const uint8_t*) header + sizeof(*header))) {
+      return EINVAL;
+   }
+
+   return 0;
+}
+
+// group: lifetime
+
+int init_frozentrie(/*out*/frozentrie_t * frozen, const trie_t * trie)
+{
+   int err;
+   memblock_t mblock = memblock_FREE;
+   size_t     next   = 0; // offset of next reserved node which is not yet written
+   size_t     end    = 0; // offset of end of reserved memory
+   uint32_t   rootoff;
+
+   if (trie->root) {
+      err = ALLOC_ERR_MM(&s_trie_errtimer, 4096, &mblock);
+      if (err) goto ONERR;
+      err = reserve_frozentrie(&mblock, &end, trie->root, &rootoff);
+      if (err) goto ONERR;
+
+      // the reserved but unwritten nodes between next and end
+      // serve as queue of a breadth first traversal
+      while (next < end) {
+         trie_node_t * node;
+         memcpy(&node, mblock.addr + next, sizeof(node));
+
+         uint8_t  node_keylen = keylen_trienode(node);
+         unsigned off2_key    = off2_key_trienode(needkeylenbyte_header(node_keylen));
+         unsigned off3_digit  = off3_digit_trienode(off2_key, node_keylen);
+         int      issubnode   = issubnode_trienode(node);
+         unsigned nrchild     = nrchild_trienode(node);
+         unsigned digitsize   = digitsize_trienode(issubnode, (uint8_t) nrchild);
+         unsigned off4_child  = off4_child_trienode(off3_digit, digitsize);
+         unsigned nrslot      = nrslot_triefrozennode(issubnode, nrchild);
+         unsigned offkey      = offkey_triefrozennode(nrslot);
+         unsigned offvalue    = offvalue_triefrozennode(offkey, node_keylen, digitsize);
+         uint32_t childoff;
+
+         if (issubnode) {
+            trie_subnode_t * subnode = subnode_trienode(node, off4_child);
+            nrchild = 0;
+            for (unsigned i = 0; i < nrslot; ++i) {
+               trie_node_t * child = child_triesubnode(subnode, (uint8_t) i);
+               childoff = 0;
+               if (child) {
+                  ++ nrchild;
+                  err = reserve_frozentrie(&mblock, &end, child, &childoff);
+                  if (err) goto ONERR;
+               }
+               ((trie_frozennode_t*) (mblock.addr + next))->child[i] = childoff;
+            }
+
+         } else {
+            trie_node_t ** childs = childs_trienode(node, off4_child);
+            for (unsigned i = 0; i < nrslot; ++i) {
+               childoff = 0;
+               if (childs[i]) {
+                  err = reserve_frozentrie(&mblock, &end, childs[i], &childoff);
+                  if (err) goto ONERR;
+               }
+               ((trie_frozennode_t*) (mblock.addr + next))->child[i] = childoff;
+            }
+            memcpy(mblock.addr + next + offkey + node_keylen, digits_trienode(node, off3_digit), digitsize);
+         }
+
+         trie_frozennode_t * fnode = (trie_frozennode_t*) (mblock.addr + next);
+         fnode->header  = (header_t) (node->header & (header_VALUE|header_SUBNODE));
+         fnode->keylen  = node_keylen;
+         fnode->nrchild = (uint16_t) nrchild;
+         memcpy(mblock.addr + next + offkey, memaddr_trienode(node) + off2_key, node_keylen);
+         if (isvalue_trienode(node)) {
+            unsigned off5_value = off5_value_trienode(off4_child, childsize_trienode(issubnode, nrchild_trienode(node)));
+            *(void**) (mblock.addr + next + offvalue) = value_trienode(node, off5_value);
+         }
+
+         next += size_triefrozennode(offvalue, isvalue_trienode(node));
+      }
+
+      // release unused memory
+      if (end != mblock.size) {
+         err = RESIZE_ERR_MM(&s_trie_errtimer, end, &mblock);
+         if (err) goto ONERR;
+      }
+   }
+
+   // set out param
+   frozen->mem     = mblock.addr;
+   frozen->size    = mblock.size;
+   frozen->mapaddr = 0;
+   frozen->mapsize = 0;
+
+   return 0;
+ONERR:
+   FREE_MM(&mblock);
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int initload_frozentrie(/*out*/frozentrie_t * frozen, const char * filepath, const struct directory_t * relative_to)
+{
+   int err;
+   file_t   file   = file_FREE;
+   vmpage_t vmpage = vmpage_FREE;
+   off_t    filesize;
+
+   err = init_file(&file, filepath, accessmode_READ, relative_to);
+   if (err) goto ONERR;
+   err = size_file(file, &filesize);
+   if (err) goto ONERR;
+
+   if (  filesize < (off_t) sizeof(trie_snapshotheader_t)
+         || (uint64_t) filesize > SIZE_MAX) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   err = initfile_vmpage(&vmpage, io_file(file), (size_t) filesize);
+   if (err) goto ONERR;
+   err = free_file(&file);
+   if (err) goto ONERR;
+
+   size_t size = (size_t) filesize - sizeof(trie_snapshotheader_t);
+   err = check_triesnapshotheader((const trie_snapshotheader_t*) vmpage.addr, size);
+   if (err) goto ONERR;
+
+   // set out param
+   frozen->mem     = size ? vmpage.addr + sizeof(trie_snapshotheader_t) : 0;
+   frozen->size    = size;
+   frozen->mapaddr = vmpage.addr;
+   frozen->mapsize = vmpage.size;
+
+   return 0;
+ONERR:
+   free_vmpage(&vmpage);
+   free_file(&file);
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_frozentrie(frozentrie_t * frozen)
+{
+   int err;
+
+   if (frozen->mapaddr) {
+      vmpage_t vmpage = vmpage_INIT(frozen->mapsize, frozen->mapaddr);
+      frozen->mem     = 0;
+      frozen->size    = 0;
+      frozen->mapaddr = 0;
+      frozen->mapsize = 0;
+
+      err = free_vmpage(&vmpage);
+      (void) PROCESS_testerrortimer(&s_trie_errtimer, &err);
+      if (err) goto ONERR;
+
+   } else if (frozen->mem) {
+      memblock_t mblock = memblock_INIT(frozen->size, frozen->mem);
+      frozen->mem  = 0;
+      frozen->size = 0;
+
+      err = FREE_ERR_MM(&s_trie_errtimer, &mblock);
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+void * const * at_frozentrie(const frozentrie_t * frozen, uint16_t keylen, const uint8_t key[keylen])
+{
+   const uint8_t * mem = frozen->mem;
+   uint32_t        off = 0;
+   unsigned        matched_keylen = 0;
+
+   if (!mem) return 0; // EMPTY TRIE
+
+   for (;;) {  // follow node path from root to matching child
+
+      const trie_frozennode_t * node = (const trie_frozennode_t*) (mem + off);
+      int      issubnode = issubnode_header(node->header);
+      unsigned nrslot    = nrslot_triefrozennode(issubnode, node->nrchild);
+      unsigned offkey    = offkey_triefrozennode(nrslot);
+
+      // match key
+      if (  node->keylen + matched_keylen > keylen
+            || 0 != memcmp(key+matched_keylen, mem + off + offkey, node->keylen)) {
+         return 0; // partial match
+      }
+
+      matched_keylen += node->keylen;
+
+      if (matched_keylen == keylen) {
+         // found node which matches full key
+         if (! isvalue_header(node->header)) return 0; // NO VALUE
+
+         unsigned offvalue = offvalue_triefrozennode(offkey, node->keylen, issubnode ? 0u : nrslot);
+         return (void * const *) (mem + off + offvalue);
+      }
+
+      // follow path to next child
+
+      uint8_t digit = key[matched_keylen++];
+
+      if (issubnode) {
+         off = node->child[digit];
+
+      } else {
+         uint8_t childidx;
+         if (!findchild_trienode(digit, (uint8_t) nrslot, mem + off + offkey + node->keylen, &childidx)) return 0;
+         off = node->child[childidx];
+      }
+
+      if (!off) return 0; // NO CHILD NODE
+   }
+}
+
+// group: persistence
+
+int save_frozentrie(const frozentrie_t * frozen, const char * filepath, struct directory_t * relative_to)
+{
+   int err;
+   file_t   file = file_FREE;
+   bool     is_created = false;
+   size_t   bytes_written;
+   trie_snapshotheader_t header;
+
+   init_triesnapshotheader(&header, frozen);
+
+   err = initcreate_file(&file, filepath, relative_to);
+   if (err) goto ONERR;
+   is_created = true;
+
+   err = write_file(file, sizeof(header), &header, &bytes_written);
+   if (err) goto ONERR;
+   if (bytes_written != sizeof(header)) {
+      err = EIO;
+      goto ONERR;
+   }
+
+   if (frozen->size) {
+      err = write_file(file, frozen->size, frozen->mem, &bytes_written);
+      if (err) goto ONERR;
+      if (bytes_written != frozen->size) {
+         err = EIO;
+         goto ONERR;
+      }
+   }
+
+   err = free_file(&file);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   if (is_created) {
+      (void) remove_file(filepath, relative_to);
+      (void) free_file(&file);
+   }
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
 // section: Functions
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_NRKEYS
+ * Number of keys inserted, searched and removed by a lifecycle perftest instance. */
+#define PT_NRKEYS       (1024*1024)
+
+/* define: PT_NRKEYS_SMALL
+ * Number of keys stored at the same time in <perftest_ds_inmem_trie_small>.
+ * The keys are inserted and removed <PT_NRKEYS>/<PT_NRKEYS_SMALL> times. */
+#define PT_NRKEYS_SMALL 1024
+
+/* struct: pt_key_t
+ * Stores a 8 byte big endian key. */
+typedef struct pt_key_t {
+   uint8_t  key[8];
+} pt_key_t;
+
+/* struct: pt_lifecycle_t
+ * Trie and keys used by a single instance of a lifecycle perftest.
+ * The address of a key is stored as its value. */
+typedef struct pt_lifecycle_t {
+   vmpage_t       vmpage;
+   trie_t         trie;
+   size_t         nrkeys;
+   size_t         nrloop;
+   pt_key_t       keys[/*nrkeys*/];
+} pt_lifecycle_t;
+
+/* function: pt_randomkey
+ * Returns a pseudo random key computed from i. Different values of i result in different keys. */
+static inline uint64_t pt_randomkey(uint64_t i)
+{
+   uint64_t key = i * UINT64_C(0x9e3779b97f4a7c15);
+   return key ^ (key >> 29);
+}
+
+static int pt_prepare_lifecycle(perftest_instance_t* tinst, size_t nrkeys, bool israndom)
+{
+   int err;
+   vmpage_t         vmpage;
+   pt_lifecycle_t * plc;
+
+   err = init_vmpage(&vmpage, sizeof(pt_lifecycle_t) + nrkeys * sizeof(pt_key_t));
+   if (err) return err;
+
+   plc = (pt_lifecycle_t*) vmpage.addr;
+   plc->vmpage = vmpage;
+   plc->trie   = (trie_t) trie_INIT;
+   plc->nrkeys = nrkeys;
+   plc->nrloop = PT_NRKEYS / nrkeys;
+
+   for (size_t i = 0; i < nrkeys; ++i) {
+      uint64_t value = israndom ? pt_randomkey(i) : i;
+      for (unsigned b = 0; b < sizeof(plc->keys[i].key); ++b) {
+         plc->keys[i].key[b] = (uint8_t) (value >> (8 * (sizeof(plc->keys[i].key)-1-b)));
+      }
+   }
+
+   tinst->nrops = PT_NRKEYS;
+   tinst->addr  = plc;
+   tinst->size  = sizeof(pt_lifecycle_t);
+
+   return 0;
+}
+
+static int pt_prepare_sequential(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, false);
+}
+
+static int pt_prepare_random(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS, true);
+}
+
+static int pt_prepare_small(perftest_instance_t* tinst)
+{
+   return pt_prepare_lifecycle(tinst, PT_NRKEYS_SMALL, true);
+}
+
+static int pt_unprepare_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc    = (pt_lifecycle_t*) tinst->addr;
+   vmpage_t         vmpage = plc->vmpage;
+
+   err = free_trie(&plc->trie);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_lifecycle(perftest_instance_t* tinst)
+{
+   int err;
+   pt_lifecycle_t * plc = (pt_lifecycle_t*) tinst->addr;
+   void           * value;
+
+   for (size_t loop = 0; loop < plc->nrloop; ++loop) {
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = insert_trie(&plc->trie, sizeof(plc->keys[i].key), plc->keys[i].key, &plc->keys[i]);
+         if (err) return err;
+      }
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         void ** addr = at_trie(&plc->trie, sizeof(plc->keys[i].key), plc->keys[i].key);
+         if (!addr || *addr != &plc->keys[i]) return EINVAL;
+      }
+
+      // no iterator support => no iteration
+
+      for (size_t i = 0; i < plc->nrkeys; ++i) {
+         err = remove_trie(&plc->trie, sizeof(plc->keys[i].key), plc->keys[i].key, &value);
+         if (err) return err;
+      }
+   }
+
+   return 0;
+}
+
+int perftest_ds_inmem_trie_sequential(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sequential, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find and remove a single key of 1M sequential keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_trie_random(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_random, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find and remove a single key of 1M random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_inmem_trie_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_small, &pt_run_lifecycle, &pt_unprepare_lifecycle),
+               "Insert, find and remove a single key of 1K random keys",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -2454,8 +3104,8 @@ static int test_node_query(void)
    TEST(0 == findchild_trienode(0, 0, (const uint8_t*)buffer, &childidx));
    TEST(0 == childidx);
 
-   // TEST findchild_trienode: no empty digit array
-   for (uint8_t size = 1; size <= 16; ++size ) {
+   // TEST findchild_trienode: no empty digit array (more than one 16 byte chunk)
+   for (uint8_t size = 1; size <= 64; ++size ) {
       uint8_t * digit = (uint8_t*) buffer;
       for (uint8_t first = 0; first <= 16; ++first) {
          for (uint8_t i = 0; i < size; ++i) {
@@ -5018,6 +5668,326 @@ ONERR:
    return EINVAL;
 }
 
+static int test_freeze(void)
+{
+   trie_t         trie   = trie_INIT;
+   frozentrie_t   frozen = frozentrie_FREE;
+   memblock_t     key    = memblock_FREE;
+   void * const * addr;
+   void        ** addr2;
+   int            err;
+
+   // prepare
+   TEST(0 == ALLOC_MM(UINT16_MAX, &key));
+   memset(key.addr, 0, key.size);
+
+   // TEST frozentrie_FREE
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+
+   // TEST init_frozentrie: empty trie
+   TEST(0 == init_frozentrie(&frozen, &trie));
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+   TEST(0 == sizeinbytes_frozentrie(&frozen));
+   TEST(0 == at_frozentrie(&frozen, 0, 0));
+   TEST(0 == at_frozentrie(&frozen, 1, key.addr));
+
+   // TEST free_frozentrie: empty trie
+   TEST(0 == free_frozentrie(&frozen));
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+
+   // prepare: child arrays, a subnode ("x" + 256 digits), long keys and a value of 0
+   for (unsigned i = 0; i < 256; ++i) {
+      uint8_t k[3] = { (uint8_t) i, (uint8_t) (i * 7), (uint8_t) (i % 3) };
+      TEST(0 == insert_trie(&trie, (uint16_t) (1 + i % 3), k, (void*) (uintptr_t) (1+i)));
+      k[0] = 'x';
+      k[1] = (uint8_t) i;
+      (void) tryinsert_trie(&trie, 2, k, (void*) (uintptr_t) (1000+i));
+   }
+   for (unsigned i = 0; i < 10; ++i) {
+      key.addr[1000] = (uint8_t) i;
+      TEST(0 == insert_trie(&trie, (uint16_t) (1001 + 100*i), key.addr, (void*) (uintptr_t) (2000+i)));
+   }
+   TEST(0 == insert_trie(&trie, 0, key.addr, 0));
+
+   // TEST init_frozentrie: all values are found
+   TEST(0 == init_frozentrie(&frozen, &trie));
+   TEST(0 != frozen.mem);
+   TEST(0 != frozen.size);
+   TEST(0 == frozen.size % PTRALIGN);
+   TEST(frozen.size == sizeinbytes_frozentrie(&frozen));
+   addr = at_frozentrie(&frozen, 0, key.addr);
+   TEST(0 != addr);
+   TEST(0 == *addr);
+   for (unsigned i = 0; i < 10; ++i) {
+      key.addr[1000] = (uint8_t) i;
+      addr = at_frozentrie(&frozen, (uint16_t) (1001 + 100*i), key.addr);
+      TEST(0 != addr);
+      TEST((void*) (uintptr_t) (2000+i) == *addr);
+      TEST(0 == at_frozentrie(&frozen, (uint16_t) (1000 + 100*i), key.addr));
+      TEST(0 == at_frozentrie(&frozen, (uint16_t) (1002 + 100*i), key.addr));
+   }
+   key.addr[1000] = 0;
+
+   // TEST at_frozentrie: same result as at_trie for all keys of size 1 and 2 and some of size 3
+   for (unsigned keylen = 1; keylen <= 3; ++keylen) {
+      for (unsigned i = 0; i < 65536; ++i) {
+         uint8_t k[3] = { (uint8_t) i, (uint8_t) (i >> 8), (uint8_t) (i % 3) };
+         if (keylen == 3) k[1] = (uint8_t) (k[0] * 7);
+         if (keylen != 2 && i > 255) break;
+         addr  = at_frozentrie(&frozen, (uint16_t) keylen, k);
+         addr2 = at_trie(&trie, (uint16_t) keylen, k);
+         TEST((0 == addr) == (0 == addr2));
+         if (addr) {
+            TEST(*addr == *addr2);
+         }
+      }
+   }
+
+   // TEST at_frozentrie: independent of trie
+   TEST(0 == free_trie(&trie));
+   addr = at_frozentrie(&frozen, 2, (const uint8_t*) "x\x05");
+   TEST(0 != addr);
+   TEST((void*) (uintptr_t) 1005 == *addr);
+   addr = at_frozentrie(&frozen, 1, (const uint8_t*) "x");
+   TEST(0 != addr);
+   TEST((void*) (uintptr_t) (1+'x') == *addr);
+   TEST(0 == at_frozentrie(&frozen, 3, (const uint8_t*) "x\x05\x00"));
+
+   // TEST free_frozentrie
+   TEST(0 == free_frozentrie(&frozen));
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+   TEST(0 == free_frozentrie(&frozen));
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+
+   // TEST free_frozentrie: simulated error
+   for (unsigned i = 0; i < 256; ++i) {
+      key.addr[0] = (uint8_t) i;
+      TEST(0 == insert_trie(&trie, 300, key.addr, (void*) (uintptr_t) i));
+   }
+   TEST(0 == init_frozentrie(&frozen, &trie));
+   init_testerrortimer(&s_trie_errtimer, 1, EINVAL);
+   TEST(EINVAL == free_frozentrie(&frozen));
+   TEST(0 == frozen.mem);
+   TEST(0 == frozen.size);
+
+   // TEST init_frozentrie: simulated ENOMEM (alloc and resize)
+   for (unsigned errcount = 1; ; ++errcount) {
+      init_testerrortimer(&s_trie_errtimer, errcount, ENOMEM);
+      err = init_frozentrie(&frozen, &trie);
+      if (0 == err) break;
+      TEST(ENOMEM == err);
+      TEST(0 == frozen.mem);
+      TEST(0 == frozen.size);
+      TEST(errcount < 10);
+   }
+   free_testerrortimer(&s_trie_errtimer);
+   for (unsigned i = 0; i < 256; ++i) {
+      key.addr[0] = (uint8_t) i;
+      addr = at_frozentrie(&frozen, 300, key.addr);
+      TEST(0 != addr);
+      TEST((void*) (uintptr_t) i == *addr);
+   }
+   TEST(0 == free_frozentrie(&frozen));
+
+   // unprepare
+   TEST(0 == free_trie(&trie));
+   TEST(0 == FREE_MM(&key));
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_trie_errtimer);
+   free_trie(&trie);
+   free_frozentrie(&frozen);
+   FREE_MM(&key);
+   return EINVAL;
+}
+
+static int test_snapshot(void)
+{
+   trie_t         trie    = trie_INIT;
+   frozentrie_t   frozen  = frozentrie_FREE;
+   frozentrie_t   loaded  = frozentrie_FREE;
+   memblock_t     content = memblock_FREE;
+   directory_t  * tempdir = 0;
+   char           tmppath[128];
+   void * const * addr;
+   void * const * addr2;
+   uint8_t        key[300] = { 0 };
+
+   // prepare
+   TEST(0 == newtemp_directory(&tempdir, "trietest", &(wbuffer_t) wbuffer_INIT_STATIC(sizeof(tmppath), (uint8_t*)tmppath)));
+
+   // TEST save_frozentrie: empty trie
+   TEST(0 == init_frozentrie(&frozen, &trie));
+   TEST(0 == save_frozentrie(&frozen, "empty", tempdir));
+
+   // TEST initload_frozentrie: empty trie
+   TEST(0 == initload_frozentrie(&loaded, "empty", tempdir));
+   TEST(0 == loaded.mem);
+   TEST(0 == loaded.size);
+   TEST(0 != loaded.mapaddr);
+   TEST(0 != loaded.mapsize);
+   TEST(0 == at_frozentrie(&loaded, 0, key));
+   TEST(0 == at_frozentrie(&loaded, 1, key));
+
+   // TEST free_frozentrie: mapped empty trie
+   TEST(0 == free_frozentrie(&loaded));
+   TEST(0 == loaded.mem);
+   TEST(0 == loaded.size);
+   TEST(0 == loaded.mapaddr);
+   TEST(0 == loaded.mapsize);
+   TEST(0 == removefile_directory(tempdir, "empty"));
+
+   // prepare: values are integers which are valid in every process
+   for (unsigned i = 0; i < 256; ++i) {
+      uint8_t k[3] = { (uint8_t) i, (uint8_t) (i * 7), (uint8_t) (i % 3) };
+      TEST(0 == insert_trie(&trie, (uint16_t) (1 + i % 3), k, (void*) (uintptr_t) (1+i)));
+      k[0] = 'x';
+      k[1] = (uint8_t) i;
+      (void) tryinsert_trie(&trie, 2, k, (void*) (uintptr_t) (1000+i));
+      key[299] = (uint8_t) i;
+      TEST(0 == insert_trie(&trie, 300, key, (void*) (uintptr_t) (2000+i)));
+   }
+   TEST(0 == init_frozentrie(&frozen, &trie));
+   TEST(0 == free_trie(&trie));
+
+   // TEST save_frozentrie
+   TEST(0 == save_frozentrie(&frozen, "snapshot", tempdir));
+   off_t filesize;
+   TEST(0 == filesize_directory(tempdir, "snapshot", &filesize));
+   TEST(filesize == (off_t) (sizeof(trie_snapshotheader_t) + frozen.size));
+
+   // TEST save_frozentrie: EEXIST
+   TEST(EEXIST == save_frozentrie(&frozen, "snapshot", tempdir));
+
+   // TEST initload_frozentrie: memory block is mapped unchanged
+   TEST(0 == initload_frozentrie(&loaded, "snapshot", tempdir));
+   TEST(loaded.mem  == loaded.mapaddr + sizeof(trie_snapshotheader_t));
+   TEST(loaded.size == frozen.size);
+   TEST(loaded.mapsize >= sizeof(trie_snapshotheader_t) + frozen.size);
+   TEST(0 == loaded.mapsize % pagesize_vm());
+   TEST(0 == memcmp(loaded.mem, frozen.mem, frozen.size));
+   TEST(loaded.size == sizeinbytes_frozentrie(&loaded));
+
+   // TEST at_frozentrie: mapped snapshot returns same values
+   for (unsigned keylen = 1; keylen <= 3; ++keylen) {
+      for (unsigned i = 0; i < 65536; ++i) {
+         uint8_t k[3] = { (uint8_t) i, (uint8_t) (i >> 8), (uint8_t) (i % 3) };
+         if (keylen == 3) k[1] = (uint8_t) (k[0] * 7);
+         if (keylen != 2 && i > 255) break;
+         addr  = at_frozentrie(&loaded, (uint16_t) keylen, k);
+         addr2 = at_frozentrie(&frozen, (uint16_t) keylen, k);
+         TEST((0 == addr) == (0 == addr2));
+         if (addr) {
+            TEST(*addr == *addr2);
+         }
+      }
+   }
+   for (unsigned i = 0; i < 256; ++i) {
+      key[299] = (uint8_t) i;
+      addr = at_frozentrie(&loaded, 300, key);
+      TEST(0 != addr);
+      TEST((void*) (uintptr_t) (2000+i) == *addr);
+      TEST(0 == at_frozentrie(&loaded, 299, key));
+   }
+
+   // TEST initload_frozentrie: independent of file
+   TEST(0 == removefile_directory(tempdir, "snapshot"));
+   addr = at_frozentrie(&loaded, 2, (const uint8_t*) "x\x05");
+   TEST(0 != addr);
+   TEST((void*) (uintptr_t) 1005 == *addr);
+
+   // prepare: copy of file content
+   TEST(0 == ALLOC_MM(sizeof(trie_snapshotheader_t) + loaded.size, &content));
+   memcpy(content.addr, loaded.mapaddr, content.size);
+
+   // TEST free_frozentrie: mapped snapshot
+   TEST(0 == free_frozentrie(&loaded));
+   TEST(0 == loaded.mem);
+   TEST(0 == loaded.size);
+   TEST(0 == loaded.mapaddr);
+   TEST(0 == loaded.mapsize);
+   TEST(0 == free_frozentrie(&loaded));
+   TEST(0 == loaded.mapaddr);
+
+   // TEST free_frozentrie: mapped snapshot, simulated error
+   TEST(0 == save_file("snapshot", content.size, content.addr, tempdir));
+   TEST(0 == initload_frozentrie(&loaded, "snapshot", tempdir));
+   init_testerrortimer(&s_trie_errtimer, 1, EINVAL);
+   TEST(EINVAL == free_frozentrie(&loaded));
+   TEST(0 == loaded.mem);
+   TEST(0 == loaded.size);
+   TEST(0 == loaded.mapaddr);
+   TEST(0 == loaded.mapsize);
+   TEST(0 == removefile_directory(tempdir, "snapshot"));
+
+   // TEST initload_frozentrie: ENOENT
+   TEST(ENOENT == initload_frozentrie(&loaded, "snapshot", tempdir));
+   TEST(0 == loaded.mapaddr);
+
+   // TEST initload_frozentrie: EINVAL (file smaller than header, truncated memory block)
+   size_t truncsize[] = { 0, sizeof(trie_snapshotheader_t)-1, content.size - PTRALIGN, content.size - 1 };
+   for (unsigned i = 0; i < lengthof(truncsize); ++i) {
+      TEST(0 == save_file("snapshot", truncsize[i], content.addr, tempdir));
+      TEST(EINVAL == initload_frozentrie(&loaded, "snapshot", tempdir));
+      TEST(0 == loaded.mapaddr);
+      TEST(0 == removefile_directory(tempdir, "snapshot"));
+   }
+
+   // TEST initload_frozentrie: EINVAL (every changed header field and a corrupted memory block)
+   size_t changed[] = {
+      offsetof(trie_snapshotheader_t, magic), offsetof(trie_snapshotheader_t, magic) + 7,
+      offsetof(trie_snapshotheader_t, version), offsetof(trie_snapshotheader_t, byteorder),
+      offsetof(trie_snapshotheader_t, ptrsize), offsetof(trie_snapshotheader_t, size),
+      offsetof(trie_snapshotheader_t, crc), sizeof(trie_snapshotheader_t),
+      content.size / 2, content.size - 1
+   };
+   for (unsigned i = 0; i < lengthof(changed); ++i) {
+      content.addr[changed[i]] ^= 0x01;
+      TEST(0 == save_file("snapshot", content.size, content.addr, tempdir));
+      content.addr[changed[i]] ^= 0x01;
+      TEST(EINVAL == initload_frozentrie(&loaded, "snapshot", tempdir));
+      TEST(0 == loaded.mapaddr);
+      TEST(0 == removefile_directory(tempdir, "snapshot"));
+   }
+
+   // adapt log
+   uint8_t* logbuffer;
+   size_t   logsize;
+   GETBUFFER_ERRLOG(&logbuffer, &logsize);
+   while (strstr((char*)logbuffer, "/trietest.")) {
+      logbuffer = (uint8_t*)strstr((char*)logbuffer, "/trietest.")+10;
+      memcpy(logbuffer, "XXXXXX", 6);
+   }
+
+   // unprepare
+   free_testerrortimer(&s_trie_errtimer);
+   TEST(0 == FREE_MM(&content));
+   TEST(0 == free_frozentrie(&frozen));
+   TEST(0 == removedirectory_directory(0, tmppath));
+   TEST(0 == delete_directory(&tempdir));
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_trie_errtimer);
+   free_trie(&trie);
+   free_frozentrie(&frozen);
+   free_frozentrie(&loaded);
+   FREE_MM(&content);
+   if (tempdir) {
+      (void) removefile_directory(tempdir, "empty");
+      (void) removefile_directory(tempdir, "snapshot");
+      (void) removedirectory_directory(0, tmppath);
+      (void) delete_directory(&tempdir);
+   }
+   return EINVAL;
+}
+
 int unittest_ds_inmem_trie()
 {
    // header_t
@@ -5034,6 +6004,9 @@ int unittest_ds_inmem_trie()
    if (test_insert())         goto ONERR;
    if (test_remove())         goto ONERR;
    if (test_query())          goto ONERR;
+   // frozentrie_t
+   if (test_freeze())         goto ONERR;
+   if (test_snapshot())       goto ONERR;
 
    return 0;
 ONERR:
@@ -20,6 +20,7 @@
 #include "C-kern/api/err.h"
 #include "C-kern/api/test/errortimer.h"
 #include "C-kern/api/memory/vm.h"
+#include "C-kern/api/platform/task/thread.h"
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/time/timevalue.h"
@@ -27,6 +28,9 @@
 #include "C-kern/api/memory/memblock.h"
 #include "C-kern/api/memory/mm/mm_macros.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/test/perftest.h"
+#endif
 
 
 // section: mergesort_t
@@ -55,6 +59,11 @@ static test_errortimer_t   s_mergesort_errtimer = test_errortimer_FREE;
  * Every slice is described with <mergesort_sortedslice_t>. */
 #define MIN_SLICE_LEN 32
 
+/* define: MIN_PARALLEL_LEN
+ * The minimum number of elements sorted by a single thread.
+ * Used in <parallelsort_mergesort> to reduce the number of threads for small arrays. */
+#define MIN_PARALLEL_LEN 4096
+
 // group: memory-helper
 
 /* function: alloctemp_mergesort
@@ -225,8 +234,587 @@ int sortblob_mergesort(mergesort_t * sort, uint8_t elemsize, size_t len, void *
 }
 
 
+// section: mergesort_parallel_t
+
+// group: types
+
+/* struct: mergesort_parallel_t
+ * State shared by all threads of <parallelsort_mergesort>.
+ * The array is divided into <nrthread> slices of nearly equal size.
+ * Thread i sorts slice i and during every merge round it writes
+ * the merged output into the position of slice i. */
+typedef struct mergesort_parallel_t {
+   /* variable: compare
+    * The comparison function to compare two elements. See <sort_compare_f>. */
+   sort_compare_f compare;
+   /* variable: cmpstate
+    * Additional state given as first parameter to <compare>. */
+   void         * cmpstate;
+   /* variable: elemsize
+    * Size of an element stored in the array to be sorted. */
+   uint8_t        elemsize;
+   /* variable: isptr
+    * If true elements are pointers and <compare> is called with their values. */
+   bool           isptr;
+   /* variable: iscopyptr
+    * If true an element is copied as a single void pointer. */
+   bool           iscopyptr;
+   /* variable: nrthread
+    * Number of threads and number of slices. */
+   unsigned       nrthread;
+   /* variable: width
+    * Number of slices every sorted run consists of at the start of a merge round.
+    * The value 0 indicates the sort phase. A value >= <nrthread> indicates
+    * the copy phase which copies the sorted array from <src> back into <a>. */
+   unsigned       width;
+   /* variable: len
+    * Number of elements of the array to be sorted. */
+   size_t         len;
+   /* variable: a
+    * Start address of the array to be sorted. */
+   uint8_t      * a;
+   /* variable: src
+    * Array which contains sorted runs of <width> slices. Either <a> or temporary memory. */
+   uint8_t      * src;
+   /* variable: dest
+    * Array which receives the merged runs of 2*<width> slices. Either <a> or temporary memory. */
+   uint8_t      * dest;
+   /* variable: sort
+    * Sort state used by thread 0 during sort phase. */
+   mergesort_t  * sort;
+} mergesort_parallel_t;
+
+/* struct: mergesort_task_t
+ * Describes the work of a single thread of <parallelsort_mergesort>. */
+typedef struct mergesort_task_t {
+   /* variable: shared
+    * Points to state shared by all threads. */
+   mergesort_parallel_t * shared;
+   /* variable: thread
+    * Thread executing this task. 0 if the task is executed by the calling thread. */
+   thread_t *             thread;
+   /* variable: index
+    * Index of slice processed by this task. */
+   unsigned               index;
+   /* variable: err
+    * Error code of this task. */
+   int                    err;
+} mergesort_task_t;
+
+// group: helper
+
+/* define: KEY_PARALLEL
+ * Returns value given as argument to compare function for element stored at addr. */
+#define KEY_PARALLEL(par, addr) \
+         ((par)->isptr ? *(void**)(addr) : (void*)(addr))
+
+/* function: sliceoffset_parallel
+ * Returns the index of the first element of slice i.
+ * The index of the first element of slice <mergesort_parallel_t.nrthread> is len. */
+static inline size_t sliceoffset_parallel(const mergesort_parallel_t * par, unsigned i)
+{
+   // (len * i) / nrthread without overflow
+   return (par->len / par->nrthread) * i + ((par->len % par->nrthread) * i) / par->nrthread;
+}
+
+/* function: copyelem_parallel
+ * Copies a single element from src to dest. */
+static inline void copyelem_parallel(const mergesort_parallel_t * par, uint8_t * dest, uint8_t * src)
+{
+   if (par->iscopyptr) {
+      *(void**)dest = *(void**)src;
+   } else {
+      memcpy(dest, src, par->elemsize);
+   }
+}
+
+/* function: mergepath_parallel
+ * Returns the number of elements taken from left if the first diag elements
+ * of the stable merge of left and right are written into the output.
+ * The value diag - returned value is the number of elements taken from right.
+ *
+ * Merge Path:
+ * The returned value i is the smallest value with i == llen or left[i] > right[diag-i-1]
+ * (right[diag-i-1] is taken before left[i]).
+ *
+ * Unchecked Precondition:
+ * - diag <= llen + rlen
+ * - Both sub-arrays are sorted. */
+static size_t mergepath_parallel(const mergesort_parallel_t * par, uint8_t * left, size_t llen, uint8_t * right, size_t rlen, size_t diag)
+{
+   const size_t elemsize = par->elemsize;
+   size_t lo = diag > rlen ? diag - rlen : 0;
+   size_t hi = diag < llen ? diag : llen;
+
+   while (lo < hi) {
+      size_t mid = lo + ((hi - lo) >> 1);
+      if (par->compare(par->cmpstate, KEY_PARALLEL(par, left + mid * elemsize), KEY_PARALLEL(par, right + (diag-mid-1) * elemsize)) <= 0)
+         lo = mid + 1;  // left[mid] is taken before right[diag-mid-1]
+      else
+         hi = mid;
+   }
+
+   return lo;
+}
+
+/* function: merge_parallel
+ * Merges the llen elements starting at left with the rlen elements starting at right
+ * in a stable way and writes them to dest.
+ * In contrast to <merge_adjacent_slices> dest is a different array. */
+static void merge_parallel(const mergesort_parallel_t * par, uint8_t * dest, uint8_t * left, size_t llen, uint8_t * right, size_t rlen)
+{
+   const size_t elemsize = par->elemsize;
+
+   if (llen && rlen) {
+      for (;;) {
+         if (par->compare(par->cmpstate, KEY_PARALLEL(par, right), KEY_PARALLEL(par, left)) < 0) {
+            copyelem_parallel(par, dest, right);
+            dest  += elemsize;
+            right += elemsize;
+            if (! --rlen) break;
+         } else {
+            copyelem_parallel(par, dest, left);
+            dest += elemsize;
+            left += elemsize;
+            if (! --llen) break;
+         }
+      }
+   }
+
+   // one of llen or rlen is 0
+   memcpy(dest, left, llen * elemsize);
+   memcpy(dest, right, rlen * elemsize);
+}
+
+/* function: task_parallelsort
+ * Executes a single task of <parallelsort_mergesort>.
+ * During sort phase (width == 0) slice index is sorted in place.
+ * During a merge round the part of the merged output which corresponds
+ * to slice index is computed and written into dest.
+ * During copy phase (width >= nrthread) slice index is copied from src to a. */
+static int task_parallelsort(mergesort_task_t * task)
+{
+   int err;
+   mergesort_parallel_t * par = task->shared;
+   const size_t   elemsize = par->elemsize;
+   const unsigned t     = task->index;
+   const size_t   start = sliceoffset_parallel(par, t);
+   const size_t   end   = sliceoffset_parallel(par, t+1);
+
+   if (0 == par->width) {
+      mergesort_t   sort2;
+      mergesort_t * sort = par->sort;
+      uint8_t     * a    = par->a + start * elemsize;
+
+      if (t) {
+         init_mergesort(&sort2);
+         sort = &sort2;
+      }
+
+      if (par->isptr) {
+         err = sortptr_mergesort(sort, end - start, (void**)a, par->compare, par->cmpstate);
+      } else {
+         err = sortblob_mergesort(sort, par->elemsize, end - start, a, par->compare, par->cmpstate);
+      }
+
+      if (t) {
+         int err2 = free_mergesort(&sort2);
+         if (err2) err = err2;
+      }
+
+      task->err = err;
+      return 0;
+   }
+
+   if (par->width >= par->nrthread) {
+      memcpy(par->a + start * elemsize, par->src + start * elemsize, (end - start) * elemsize);
+      task->err = 0;
+      return 0;
+   }
+
+   // slice t lies within the pair of runs starting at slice first
+   const unsigned first  = t - t % (2*par->width);
+   const unsigned middle = first + par->width < par->nrthread ? first + par->width : par->nrthread;
+   const unsigned last   = first + 2*par->width < par->nrthread ? first + 2*par->width : par->nrthread;
+   const size_t   lstart = sliceoffset_parallel(par, first);
+   const size_t   rstart = sliceoffset_parallel(par, middle);
+   const size_t   rend   = sliceoffset_parallel(par, last);
+   uint8_t * left  = par->src + lstart * elemsize;
+   uint8_t * right = par->src + rstart * elemsize;
+   const size_t llen = rstart - lstart;
+   const size_t rlen = rend - rstart;
+
+   // output range [start, end) of the merged run
+   const size_t d0 = start - lstart;
+   const size_t d1 = end - lstart;
+   const size_t l0 = mergepath_parallel(par, left, llen, right, rlen, d0);
+   const size_t l1 = mergepath_parallel(par, left, llen, right, rlen, d1);
+
+   merge_parallel(par, par->dest + start * elemsize, left + l0 * elemsize, l1 - l0, right + (d0 - l0) * elemsize, (d1 - l1) - (d0 - l0));
+
+   task->err = 0;
+   return 0;
+}
+
+/* function: runtasks_parallel
+ * Starts <mergesort_parallel_t.nrthread>-1 threads which execute <task_parallelsort>.
+ * Task 0 is executed by the calling thread. The function returns after all threads have ended. */
+static int runtasks_parallel(mergesort_parallel_t * par, mergesort_task_t task[mergesort_MAXTHREAD])
+{
+   int err = 0;
+   unsigned nrstarted;
+
+   for (nrstarted = 1; nrstarted < par->nrthread; ++nrstarted) {
+      task[nrstarted] = (mergesort_task_t) { par, 0, nrstarted, 0 };
+      if (! PROCESS_testerrortimer(&s_mergesort_errtimer, &err)) {
+         err = newgeneric_thread(&task[nrstarted].thread, &task_parallelsort, &task[nrstarted]);
+      }
+      if (err) break;
+   }
+
+   if (! err) {
+      task[0] = (mergesort_task_t) { par, 0, 0, 0 };
+      (void) task_parallelsort(&task[0]);
+      err = task[0].err;
+   }
+
+   for (unsigned i = 1; i < nrstarted; ++i) {
+      int err2 = delete_thread(&task[i].thread);
+      if (! err2) err2 = task[i].err;
+      if (err2) err = err2;
+   }
+
+   return err;
+}
+
+// group: sort
+
+/* function: parallelsort_mergesort
+ * Implements <parallelsortptr_mergesort> and <parallelsortblob_mergesort>.
+ * Parameter isptr is true in case of <parallelsortptr_mergesort>. */
+static int parallelsort_mergesort(mergesort_t * sort, bool isptr, uint8_t nrthread, uint8_t elemsize, size_t len, uint8_t * a, sort_compare_f cmp, void * cmpstate)
+{
+   int err;
+   mergesort_parallel_t par;
+   mergesort_task_t     task[mergesort_MAXTHREAD];
+
+   if (0 == nrthread || nrthread > mergesort_MAXTHREAD) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   err = setsortstate(sort, cmp, cmpstate, elemsize, len);
+   if (err) goto ONERR;
+
+   unsigned nrslice = nrthread;
+   if (nrslice > len / MIN_PARALLEL_LEN) nrslice = (unsigned) (len / MIN_PARALLEL_LEN);
+
+   if (nrslice <= 1) {
+      // not worth the thread overhead
+      if (isptr) return sortptr_mergesort(sort, len, (void**)a, cmp, cmpstate);
+      return sortblob_mergesort(sort, elemsize, len, a, cmp, cmpstate);
+   }
+
+   par = (mergesort_parallel_t) {
+            .compare = cmp, .cmpstate = cmpstate, .elemsize = elemsize, .isptr = isptr,
+            .iscopyptr = (elemsize == sizeof(void*) && 0 == (uintptr_t)a % sizeof(void*)),
+            .nrthread = nrslice, .width = 0, .len = len, .a = a, .src = a, .dest = a, .sort = sort
+         };
+
+   // sort phase
+   err = runtasks_parallel(&par, task);
+   if (err) goto ONERR;
+
+   // merge phase
+   err = ensuretempsize(sort, len * elemsize);
+   if (err) goto ONERR;
+
+   par.dest = sort->temp;
+   for (par.width = 1; par.width < par.nrthread; par.width *= 2) {
+      err = runtasks_parallel(&par, task);
+      if (err) goto ONERR;
+      uint8_t * src = par.src;
+      par.src  = par.dest;
+      par.dest = src;
+   }
+
+   if (par.src != a) {
+      // copy phase (other threads could read a until the last merge round has ended)
+      err = runtasks_parallel(&par, task);
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int parallelsortptr_mergesort(mergesort_t * sort, uint8_t nrthread, size_t len, void * a[len], sort_compare_f cmp, void * cmpstate)
+{
+   return parallelsort_mergesort(sort, true, nrthread, sizeof(void*), len, (uint8_t*)a, cmp, cmpstate);
+}
+
+int parallelsortblob_mergesort(mergesort_t * sort, uint8_t nrthread, uint8_t elemsize, size_t len, void * a/*uint8_t[len*elemsize]*/, sort_compare_f cmp, void * cmpstate)
+{
+   return parallelsort_mergesort(sort, false, nrthread, elemsize, len, a, cmp, cmpstate);
+}
+
+// group: generic
+
+int ensuretemp_mergesort(mergesort_t * sort, size_t tempsize)
+{
+   int err;
+
+   err = ensuretempsize(sort, tempsize);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
 // section: Functions
 
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_LEN
+ * Number of elements sorted by every perftest instance. */
+#define PT_LEN (1024*1024)
+
+/* define: PT_LEN_SMALL
+ * Number of elements of a single sorted slice in <perftest_ds_sort_mergesort_small>. */
+#define PT_LEN_SMALL 1024
+
+/* struct: pt_sort_t
+ * Arrays and sort state of a single perftest instance. */
+typedef struct pt_sort_t {
+   vmpage_t    vmpage;
+   mergesort_t sort;
+   uint8_t     nrthread;
+   uint64_t  * data;
+   uint64_t  * a;
+   uint64_t ** pdata;
+   uint64_t ** pa;
+} pt_sort_t;
+
+static int pt_compare(void * cmpstate, const void * left, const void * right)
+{
+   (void) cmpstate;
+   uint64_t l = *(const uint64_t*)left;
+   uint64_t r = *(const uint64_t*)right;
+   return (l < r) ? -1 : (l > r) ? +1 : 0;
+}
+
+static inline int pt_compare_inline(const uint64_t * left, const uint64_t * right)
+{
+   return (*left < *right) ? -1 : (*left > *right) ? +1 : 0;
+}
+
+mergesort_IMPLEMENT(_ptsort, uint64_t, pt_compare_inline)
+
+static int pt_prepare(perftest_instance_t* tinst, uint8_t nrthread)
+{
+   int err;
+   vmpage_t    vmpage;
+   pt_sort_t * psort;
+   uint32_t    seed = tinst->tid;
+
+   err = init_vmpage(&vmpage, sizeof(pt_sort_t) + 2 * PT_LEN * (sizeof(uint64_t) + sizeof(uint64_t*)));
+   if (err) return err;
+
+   psort = (pt_sort_t*) vmpage.addr;
+   psort->vmpage   = vmpage;
+   psort->nrthread = nrthread;
+   psort->data     = (uint64_t*) (psort + 1);
+   psort->a        = psort->data + PT_LEN;
+   psort->pdata    = (uint64_t**) (psort->a + PT_LEN);
+   psort->pa       = psort->pdata + PT_LEN;
+   init_mergesort(&psort->sort);
+
+   for (size_t i = 0; i < PT_LEN; ++i) {
+      seed = seed * 1103515245 + 12345;
+      psort->data[i]  = ((uint64_t)seed << 16) + i;
+      psort->pdata[i] = &psort->data[i];
+   }
+
+   tinst->nrops = PT_LEN;
+   tinst->addr  = psort;
+   tinst->size  = sizeof(pt_sort_t);
+
+   return 0;
+}
+
+static int pt_prepare_1(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, 1);
+}
+
+static int pt_prepare_sorted(perftest_instance_t* tinst)
+{
+   int err = pt_prepare(tinst, 1);
+   if (err) return err;
+
+   pt_sort_t * psort = (pt_sort_t*) tinst->addr;
+   for (size_t i = 0; i < PT_LEN; ++i) {
+      psort->data[i] = i;
+   }
+
+   return 0;
+}
+
+static int pt_prepare_2(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, 2);
+}
+
+static int pt_prepare_4(perftest_instance_t* tinst)
+{
+   return pt_prepare(tinst, 4);
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   int err;
+   pt_sort_t * psort  = (pt_sort_t*) tinst->addr;
+   vmpage_t    vmpage = psort->vmpage;
+
+   err = free_mergesort(&psort->sort);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run_ptr(perftest_instance_t* tinst)
+{
+   pt_sort_t * psort = (pt_sort_t*) tinst->addr;
+
+   memcpy(psort->pa, psort->pdata, PT_LEN * sizeof(uint64_t*));
+
+   return sortptr_mergesort(&psort->sort, PT_LEN, (void**)psort->pa, &pt_compare, 0);
+}
+
+static int pt_run_implement(perftest_instance_t* tinst)
+{
+   pt_sort_t * psort = (pt_sort_t*) tinst->addr;
+
+   memcpy(psort->pa, psort->pdata, PT_LEN * sizeof(uint64_t*));
+
+   return sort_ptsort(&psort->sort, PT_LEN, psort->pa);
+}
+
+static int pt_run_small(perftest_instance_t* tinst)
+{
+   int err;
+   pt_sort_t * psort = (pt_sort_t*) tinst->addr;
+
+   memcpy(psort->a, psort->data, PT_LEN * sizeof(uint64_t));
+
+   for (size_t i = 0; i < PT_LEN; i += PT_LEN_SMALL) {
+      err = sortblob_mergesort(&psort->sort, sizeof(uint64_t), PT_LEN_SMALL, psort->a + i, &pt_compare, 0);
+      if (err) return err;
+   }
+
+   return 0;
+}
+
+static int pt_run(perftest_instance_t* tinst)
+{
+   pt_sort_t * psort = (pt_sort_t*) tinst->addr;
+
+   memcpy(psort->a, psort->data, PT_LEN * sizeof(uint64_t));
+
+   if (psort->nrthread == 1) {
+      return sortblob_mergesort(&psort->sort, sizeof(uint64_t), PT_LEN, psort->a, &pt_compare, 0);
+   } else {
+      return parallelsortblob_mergesort(&psort->sort, psort->nrthread, sizeof(uint64_t), PT_LEN, psort->a, &pt_compare, 0);
+   }
+}
+
+int perftest_ds_sort_mergesort(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_1, &pt_run, &pt_unprepare),
+               "Sort 1M random uint64_t values with sortblob_mergesort",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_sort_mergesort_ptr(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_1, &pt_run_ptr, &pt_unprepare),
+               "Sort 1M pointers to random uint64_t values with sortptr_mergesort",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_sort_mergesort_implement(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_1, &pt_run_implement, &pt_unprepare),
+               "Sort 1M pointers to random uint64_t values with mergesort_IMPLEMENT",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_sort_mergesort_parallel2(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_2, &pt_run, &pt_unprepare),
+               "Sort 1M random uint64_t values with parallelsortblob_mergesort (2 threads)",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_sort_mergesort_parallel4(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_4, &pt_run, &pt_unprepare),
+               "Sort 1M random uint64_t values with parallelsortblob_mergesort (4 threads)",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_sort_mergesort_sorted(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_sorted, &pt_run, &pt_unprepare),
+               "Sort 1M ascending uint64_t values with sortblob_mergesort",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_ds_sort_mergesort_small(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_1, &pt_run_small, &pt_unprepare),
+               "Sort 1K slices of 1M random uint64_t values with sortblob_mergesort",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
 // group: test
 
 #ifdef KONFIG_UNITTEST
@@ -1954,6 +2542,197 @@ ONERR:
    return EINVAL;
 }
 
+static int test_compare_key(void * cmpstate, const void * left, const void * right)
+{
+   (void) cmpstate;
+   uint32_t lk = ((const uint32_t*)left)[0];
+   uint32_t rk = ((const uint32_t*)right)[0];
+   return (lk < rk) ? -1 : (lk > rk) ? +1 : 0;
+}
+
+/* function: fill_parallelsort
+ * Every element of a consists of a key and a sequence number.
+ * The sequence number is used to check stability. */
+static void fill_parallelsort(uint8_t elemsize, size_t len, uint8_t * a, int type)
+{
+   for (size_t i = 0; i < len; ++i) {
+      uint32_t key;
+      switch (type) {
+      case 0:  key = (uint32_t) random() % 1000; break;
+      case 1:  key = (uint32_t) i / 8; break;
+      default: key = (uint32_t) (len - i) / 8; break;
+      }
+      ((uint32_t*)(a + i * elemsize))[0] = key;
+      ((uint32_t*)(a + i * elemsize))[1] = (uint32_t) i;
+   }
+}
+
+/* function: check_parallelsort
+ * Checks that elements are sorted by key and equal keys are sorted by sequence number.
+ * Elements are accessed indirectly with pointers if parray is not 0. */
+static int check_parallelsort(uint8_t elemsize, size_t len, uint8_t * a, void ** parray)
+{
+   uint64_t seqsum = 0;
+
+   for (size_t i = 0; i < len; ++i) {
+      const uint32_t * next = parray ? parray[i] : (uint32_t*) (a + i * elemsize);
+      seqsum += next[1];
+      if (i) {
+         const uint32_t * prev = parray ? parray[i-1] : (uint32_t*) (a + (i-1) * elemsize);
+         TEST(prev[0] <= next[0]);
+         TEST(prev[0] < next[0] || prev[1] < next[1]);
+      }
+   }
+
+   // every element is contained exactly once
+   TEST(seqsum == (uint64_t)len * (len-1) / 2);
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_parallelsort(mergesort_t * sort, memblock_t * mblock)
+{
+   const size_t len = 8 * MIN_PARALLEL_LEN + 13;
+   uint8_t    * a   = mblock->addr;
+   void      ** parray = (void**) (a + 12 * len + sizeof(void*) - (12 * len) % sizeof(void*));
+
+   // prepare
+   TEST(mblock->size >= 12*len + sizeof(void*) * (len+1));
+
+   // TEST sliceoffset_parallel
+   for (unsigned nrthread = 1; nrthread <= mergesort_MAXTHREAD; ++nrthread) {
+      for (size_t l = nrthread; l < 3*(size_t)nrthread; ++l) {
+         mergesort_parallel_t par = { .nrthread = nrthread, .len = l };
+         TEST(0 == sliceoffset_parallel(&par, 0));
+         TEST(l == sliceoffset_parallel(&par, nrthread));
+         for (unsigned i = 0; i < nrthread; ++i) {
+            size_t slen = sliceoffset_parallel(&par, i+1) - sliceoffset_parallel(&par, i);
+            TEST(l / nrthread <= slen && slen <= (l + nrthread - 1) / nrthread);
+         }
+      }
+   }
+   {
+      mergesort_parallel_t par = { .nrthread = 3, .len = (size_t)-1 };
+      TEST((size_t)-1 / 3 == sliceoffset_parallel(&par, 1));
+      TEST((size_t)-1 == sliceoffset_parallel(&par, 3));
+   }
+
+   // TEST parallelsortblob_mergesort: EINVAL
+   TEST(EINVAL == parallelsortblob_mergesort(sort, 0, 8, len, a, &test_compare_key, 0));
+   TEST(EINVAL == parallelsortblob_mergesort(sort, mergesort_MAXTHREAD+1, 8, len, a, &test_compare_key, 0));
+   TEST(EINVAL == parallelsortblob_mergesort(sort, 2, 0, len, a, &test_compare_key, 0));
+   TEST(EINVAL == parallelsortblob_mergesort(sort, 2, 8, len, a, 0, 0));
+   TEST(EINVAL == parallelsortblob_mergesort(sort, 2, 8, (size_t)-1, a, &test_compare_key, 0));
+
+   // TEST parallelsortptr_mergesort: EINVAL
+   TEST(EINVAL == parallelsortptr_mergesort(sort, 0, len, parray, &test_compare_key, 0));
+   TEST(EINVAL == parallelsortptr_mergesort(sort, 2, len, parray, 0, 0));
+
+   for (uint8_t nrthread = 1; nrthread <= 9; ++nrthread) {
+      for (int type = 0; type < 3; ++type) {
+         // TEST parallelsortblob_mergesort: copy as pointer, memcpy
+         for (uint8_t elemsize = 8; elemsize <= 12; elemsize = (uint8_t) (elemsize + 4)) {
+            fill_parallelsort(elemsize, len, a, type);
+            TEST(0 == parallelsortblob_mergesort(sort, nrthread, elemsize, len, a, &test_compare_key, 0));
+            TEST(0 == check_parallelsort(elemsize, len, a, 0));
+         }
+
+         // TEST parallelsortptr_mergesort
+         fill_parallelsort(8, len, a, type);
+         for (size_t i = 0; i < len; ++i) {
+            parray[i] = a + 8 * i;
+         }
+         TEST(0 == parallelsortptr_mergesort(sort, nrthread, len, parray, &test_compare_key, 0));
+         TEST(0 == check_parallelsort(8, len, 0, parray));
+      }
+   }
+
+   // TEST parallelsortblob_mergesort: small arrays are sorted by fewer threads
+   for (size_t l = 0; l <= 2*MIN_PARALLEL_LEN; l += MIN_PARALLEL_LEN/2 - 1) {
+      fill_parallelsort(8, l, a, 0);
+      TEST(0 == parallelsortblob_mergesort(sort, mergesort_MAXTHREAD, 8, l, a, &test_compare_key, 0));
+      TEST(0 == check_parallelsort(8, l, a, 0));
+   }
+
+   // TEST parallelsortblob_mergesort: ERROR
+   fill_parallelsort(8, len, a, 0);
+   init_testerrortimer(&s_mergesort_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == parallelsortblob_mergesort(sort, 4, 8, len, a, &test_compare_key, 0));
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_mergesort_errtimer);
+   return EINVAL;
+}
+
+static inline int test_compare_inline(const uint32_t * left, const uint32_t * right)
+{
+   return (left[0] < right[0]) ? -1 : (left[0] > right[0]) ? +1 : 0;
+}
+
+mergesort_IMPLEMENT(_testsort, uint32_t, test_compare_inline)
+
+static int test_implement(mergesort_t * sort, memblock_t * mblock)
+{
+   const size_t len = 8 * MIN_PARALLEL_LEN + 13;
+   uint8_t    * a   = mblock->addr;
+   uint32_t  ** parray = (uint32_t**) (a + 8 * len);
+
+   // prepare
+   TEST(mblock->size >= 8*len + sizeof(void*) * len);
+
+   // TEST ensuretemp_mergesort: no reallocation
+   TEST(0 == free_mergesort(sort));
+   init_mergesort(sort);
+   TEST(0 == ensuretemp_mergesort(sort, sizeof(sort->tempmem)));
+   TEST(sort->temp == sort->tempmem);
+
+   // TEST ensuretemp_mergesort: reallocation
+   TEST(0 == ensuretemp_mergesort(sort, sizeof(sort->tempmem)+1));
+   TEST(sort->temp != sort->tempmem);
+   TEST(sort->tempsize >= sizeof(sort->tempmem)+1);
+
+   // TEST sort_testsort: all slice lengths, stable
+   for (int type = 0; type < 3; ++type) {
+      for (size_t l = 0; l <= 4*mergesort_IMPLEMENT_SLICELEN+1; ++l) {
+         fill_parallelsort(8, l, a, type);
+         for (size_t i = 0; i < l; ++i) {
+            parray[i] = (uint32_t*) (a + 8 * i);
+         }
+         TEST(0 == sort_testsort(sort, l, parray));
+         TEST(0 == check_parallelsort(8, l, 0, (void**)parray));
+      }
+   }
+
+   // TEST sort_testsort: large array, stable
+   for (int type = 0; type < 3; ++type) {
+      fill_parallelsort(8, len, a, type);
+      for (size_t i = 0; i < len; ++i) {
+         parray[i] = (uint32_t*) (a + 8 * i);
+      }
+      TEST(0 == sort_testsort(sort, len, parray));
+      TEST(0 == check_parallelsort(8, len, 0, (void**)parray));
+   }
+
+   // TEST sort_testsort: ENOMEM
+   TEST(0 == free_mergesort(sort));
+   init_mergesort(sort);
+   fill_parallelsort(8, len, a, 0);
+   for (size_t i = 0; i < len; ++i) {
+      parray[i] = (uint32_t*) (a + 8 * i);
+   }
+   init_testerrortimer(&s_mergesort_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == sort_testsort(sort, len, parray));
+   TEST(sort->temp == sort->tempmem);
+
+   return 0;
+ONERR:
+   free_testerrortimer(&s_mergesort_errtimer);
+   return EINVAL;
+}
+
 #if 0
 /*
  * Algorithm to build slices from top to down
@@ -2063,6 +2842,8 @@ int unittest_ds_sort_mergesort()
    if (test_presort())        goto ONERR;
    if (test_sort(&sort, len/10, &mblock))       goto ONERR;
    if (test_measuretime(&sort, len, &mblock))   goto ONERR;
+   if (test_parallelsort(&sort, &mblock))       goto ONERR;
+   if (test_implement(&sort, &mblock))          goto ONERR;
 
    TEST(0 == free_mergesort(&sort));
    TEST(0 == FREE_MM(&mblock));
@@ -0,0 +1,824 @@
+/* title: RadixSort impl
+
+   Implements <RadixSort>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/ds/sort/radixsort.h
+    Header file <RadixSort>.
+
+   file: C-kern/ds/sort/radixsort.c
+    Implementation file <RadixSort impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/ds/sort/radixsort.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/math/int/byteorder.h"
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/test/errortimer.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/unittest.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/test/perftest.h"
+#endif
+
+
+// section: radixsort_t
+
+// group: static variables
+
+#ifdef KONFIG_UNITTEST
+/* variable: s_radixsort_errtimer
+ * Simulates an error in <alloctemp_radixsort>. */
+static test_errortimer_t   s_radixsort_errtimer = test_errortimer_FREE;
+#endif
+
+// group: types
+
+/* struct: radixsort_key_t
+ * Describes position and byte order of the key stored in every element.
+ * Digit d (d == 0 is the most significant) of an element e is stored at
+ * address e + first + d * step. */
+typedef struct radixsort_key_t {
+   /* variable: elemsize
+    * Size in bytes of an element. */
+   size_t    elemsize;
+   /* variable: keysize
+    * Number of bytes (digits) of the key. */
+   size_t    keysize;
+   /* variable: first
+    * Offset of the most significant byte of the key relative to the start of an element. */
+   ptrdiff_t first;
+   /* variable: step
+    * +1 or -1. Added to the offset of a digit to get the offset of the next less significant digit. */
+   ptrdiff_t step;
+} radixsort_key_t;
+
+/* struct: radixsort_bucket_t
+ * Describes a part of the array which is sorted by the MSD algorithm.
+ * All elements of a bucket have the same key prefix of depth digits. */
+typedef struct radixsort_bucket_t {
+   /* variable: start
+    * Index of the first element of the bucket. */
+   size_t start;
+   /* variable: len
+    * Number of elements of the bucket. */
+   size_t len;
+   /* variable: depth
+    * Index of the next digit used to sort the bucket. */
+   size_t depth;
+} radixsort_bucket_t;
+
+// group: helper
+
+/* function: islittleendian_radixsort
+ * Returns true if integers are stored with the least significant byte first. */
+static inline bool islittleendian_radixsort(void)
+{
+   return htobe_int((uint16_t)1) != 1;
+}
+
+/* function: countersoffset_radixsort
+ * Returns the offset of the counters in the scratch memory.
+ * The counters are stored after the elements and are aligned to size_t. */
+static inline size_t countersoffset_radixsort(const uint8_t * scratch, size_t arraysize)
+{
+   uintptr_t addr = (uintptr_t) (scratch + arraysize);
+   return arraysize + (size_t) ((sizeof(size_t) - addr % sizeof(size_t)) % sizeof(size_t));
+}
+
+/* function: copyelem_radixsort
+ * Copies a single element from src to dest. Common sizes are copied with a constant size memcpy. */
+static inline void copyelem_radixsort(uint8_t * dest, const uint8_t * src, size_t elemsize)
+{
+   switch (elemsize) {
+   case 4:  memcpy(dest, src, 4); break;
+   case 8:  memcpy(dest, src, 8); break;
+   case 16: memcpy(dest, src, 16); break;
+   default: memcpy(dest, src, elemsize); break;
+   }
+}
+
+/* function: comparekey_radixsort
+ * Compares keys of elements left and right starting from digit depth. */
+static inline int comparekey_radixsort(const radixsort_key_t * key, const uint8_t * left, const uint8_t * right, size_t depth)
+{
+   ptrdiff_t off = key->first + (ptrdiff_t)depth * key->step;
+
+   if (key->step == 1) {
+      return memcmp(left + off, right + off, key->keysize - depth);
+   }
+
+   for (size_t d = depth; d < key->keysize; ++d, off += key->step) {
+      if (left[off] != right[off]) return left[off] < right[off] ? -1 : +1;
+   }
+
+   return 0;
+}
+
+// group: memory-helper
+
+/* function: alloctemp_radixsort
+ * Reallocates <radixsort_t.temp> so it can store tempsize bytes.
+ * If tempsize is 0 allocated memory is freed. */
+static int alloctemp_radixsort(radixsort_t * sort, size_t tempsize)
+{
+   int err;
+   vmpage_t mblock;
+
+   if (sort->temp) {
+      mblock = (vmpage_t) vmpage_INIT(sort->tempsize, sort->temp);
+      err = free_vmpage(&mblock);
+      (void) PROCESS_testerrortimer(&s_radixsort_errtimer, &err);
+
+      sort->temp     = 0;
+      sort->tempsize = 0;
+
+      if (err) goto ONERR;
+   }
+
+   if (tempsize) {
+      if (! PROCESS_testerrortimer(&s_radixsort_errtimer, &err)) {
+         err = init_vmpage(&mblock, tempsize);
+      }
+      if (err) goto ONERR;
+      sort->temp     = mblock.addr;
+      sort->tempsize = mblock.size;
+   }
+
+   return 0;
+ONERR:
+   return err;
+}
+
+/* function: getscratch_radixsort
+ * Returns scratch memory of at least size bytes.
+ * The memory provided by the caller is preferred. */
+static inline int getscratch_radixsort(radixsort_t * sort, size_t size, /*out*/uint8_t ** scratch)
+{
+   int err;
+
+   if (size <= sort->scratchsize) {
+      *scratch = sort->scratch;
+
+   } else {
+      if (size > sort->tempsize) {
+         err = alloctemp_radixsort(sort, size);
+         if (err) return err;
+      }
+      *scratch = sort->temp;
+   }
+
+   return 0;
+}
+
+// group: lifetime
+
+void init_radixsort(/*out*/radixsort_t * sort)
+{
+   *sort = (radixsort_t) radixsort_FREE;
+}
+
+void initscratch_radixsort(/*out*/radixsort_t * sort, size_t scratchsize, void * scratch)
+{
+   *sort = (radixsort_t) radixsort_FREE;
+   if (scratch) {
+      sort->scratch     = scratch;
+      sort->scratchsize = scratchsize;
+   }
+}
+
+int free_radixsort(radixsort_t * sort)
+{
+   int err;
+
+   sort->scratch     = 0;
+   sort->scratchsize = 0;
+
+   err = alloctemp_radixsort(sort, 0);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+size_t scratchsize_radixsort(uint8_t elemsize, size_t len, uint8_t keysize)
+{
+   if (len < radixsort_INSERTSORTLEN) return 0;
+
+   if (elemsize == 0 || len > ((size_t)-1 - 65536*sizeof(radixsort_bucket_t)) / elemsize) return (size_t)-1;
+
+   size_t size = len * elemsize + sizeof(size_t)-1/*alignment*/;
+
+   if (keysize <= radixsort_MAXLSDKEYSIZE) {
+      size += (size_t)keysize * 256 * sizeof(size_t);
+   } else {
+      size += 256 * sizeof(size_t) + (size_t)keysize * 256 * sizeof(radixsort_bucket_t);
+   }
+
+   return size;
+}
+
+// group: sort-helper
+
+/* function: insertsort_radixsort
+ * Sorts array a of len elements with a stable insertion sort.
+ * The first depth digits of the keys of all elements must be equal and are not compared. */
+static void insertsort_radixsort(const radixsort_key_t * key, size_t len, uint8_t * a, size_t depth)
+{
+   const size_t elemsize = key->elemsize;
+   uint8_t      temp[256];
+
+   for (size_t i = 1; i < len; ++i) {
+      uint8_t * next = a + i * elemsize;
+      size_t    pos  = i;
+
+      while (pos > 0 && comparekey_radixsort(key, a + (pos-1) * elemsize, next, depth) > 0) {
+         -- pos;
+      }
+
+      if (pos != i) {
+         memcpy(temp, next, elemsize);
+         memmove(a + (pos+1) * elemsize, a + pos * elemsize, (i-pos) * elemsize);
+         memcpy(a + pos * elemsize, temp, elemsize);
+      }
+   }
+}
+
+/* function: lsdsort_radixsort
+ * Sorts array a from the least to the most significant digit.
+ * All digit histograms are computed in a single pass.
+ * Every digit which differs between elements needs one counting sort pass
+ * which moves the elements between a and scratch. */
+static void lsdsort_radixsort(const radixsort_key_t * key, size_t len, uint8_t * a, uint8_t * scratch)
+{
+   const size_t elemsize  = key->elemsize;
+   const size_t arraysize = len * elemsize;
+   size_t     * hist      = (size_t*) (scratch + countersoffset_radixsort(scratch, arraysize));
+
+   memset(hist, 0, key->keysize * 256 * sizeof(size_t));
+
+   for (uint8_t * elem = a, * end = a + arraysize; elem < end; elem += elemsize) {
+      const uint8_t * digit = elem + key->first;
+      for (size_t d = 0; d < key->keysize; ++d, digit += key->step) {
+         ++ hist[256*d + *digit];
+      }
+   }
+
+   uint8_t * src  = a;
+   uint8_t * dest = scratch;
+
+   for (size_t d = key->keysize; (d--) > 0; ) {
+      size_t  * offset = hist + 256*d;
+      ptrdiff_t digoff = key->first + (ptrdiff_t)d * key->step;
+
+      // all elements have same digit ==> order does not change
+      if (offset[src[digoff]] == len) continue;
+
+      size_t off = 0;
+      for (unsigned i = 0; i < 256; ++i) {
+         size_t count = offset[i];
+         offset[i] = off;
+         off += count * elemsize;
+      }
+
+      for (uint8_t * elem = src, * end = src + arraysize; elem < end; elem += elemsize) {
+         size_t * o = &offset[elem[digoff]];
+         copyelem_radixsort(dest + *o, elem, elemsize);
+         *o += elemsize;
+      }
+
+      uint8_t * temp = src;
+      src  = dest;
+      dest = temp;
+   }
+
+   if (src != a) {
+      memcpy(a, src, arraysize);
+   }
+}
+
+/* function: msdsort_radixsort
+ * Sorts array a from the most to the least significant digit.
+ * The array is divided into buckets of elements with the same digit.
+ * Every bucket is sorted separately by the next digit.
+ * Buckets are kept on an explicit stack stored in scratch.
+ * The stack never contains more than 256 buckets of the same depth. */
+static void msdsort_radixsort(const radixsort_key_t * key, size_t len, uint8_t * a, uint8_t * scratch)
+{
+   const size_t         elemsize = key->elemsize;
+   size_t             * count    = (size_t*) (scratch + countersoffset_radixsort(scratch, len * elemsize));
+   radixsort_bucket_t * stack    = (radixsort_bucket_t*) (count + 256);
+   size_t               stacksize = 0;
+
+   stack[stacksize++] = (radixsort_bucket_t) { 0, len, 0 };
+
+   while (stacksize) {
+      radixsort_bucket_t bucket = stack[--stacksize];
+      uint8_t          * base   = a + bucket.start * elemsize;
+      uint8_t          * end    = base + bucket.len * elemsize;
+      ptrdiff_t          digoff;
+
+      if (bucket.len < radixsort_INSERTSORTLEN) {
+         insertsort_radixsort(key, bucket.len, base, bucket.depth);
+         continue;
+      }
+
+      // skip digits which are equal in all elements
+      for (;;) {
+         digoff = key->first + (ptrdiff_t)bucket.depth * key->step;
+         memset(count, 0, 256 * sizeof(size_t));
+         for (uint8_t * elem = base; elem < end; elem += elemsize) {
+            ++ count[elem[digoff]];
+         }
+         if (count[base[digoff]] != bucket.len) break;
+         if (++ bucket.depth == key->keysize) break;
+      }
+      if (bucket.depth == key->keysize) continue; // all keys are equal
+
+      size_t off = 0;
+      for (unsigned i = 0; i < 256; ++i) {
+         size_t c = count[i];
+         count[i] = off;
+         off += c;
+      }
+
+      for (uint8_t * elem = base; elem < end; elem += elemsize) {
+         copyelem_radixsort(scratch + count[elem[digoff]]++ * elemsize, elem, elemsize);
+      }
+      memcpy(base, scratch, bucket.len * elemsize);
+
+      // count[i] is end index of bucket of digit i
+      if (bucket.depth + 1 < key->keysize) {
+         size_t start = 0;
+         for (unsigned i = 0; i < 256; ++i) {
+            if (count[i] - start > 1) {
+               stack[stacksize++] = (radixsort_bucket_t) { bucket.start + start, count[i] - start, bucket.depth + 1 };
+            }
+            start = count[i];
+         }
+      }
+   }
+}
+
+/* function: sort_radixsort
+ * Implements <sortuint_radixsort> and <sortbinary_radixsort>. */
+static int sort_radixsort(radixsort_t * sort, bool isuint, uint8_t elemsize, size_t len, uint8_t * a, uint8_t keyoffset, uint8_t keysize)
+{
+   int err;
+   radixsort_key_t key;
+   uint8_t       * scratch;
+
+   if (  0 == elemsize || 0 == keysize || (unsigned)keyoffset + keysize > elemsize
+         || len > (size_t)-1 / elemsize) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   key.elemsize = elemsize;
+   key.keysize  = keysize;
+   if (isuint && islittleendian_radixsort()) {
+      key.first = keyoffset + keysize - 1;
+      key.step  = -1;
+   } else {
+      key.first = keyoffset;
+      key.step  = 1;
+   }
+
+   if (len < radixsort_INSERTSORTLEN) {
+      insertsort_radixsort(&key, len, a, 0);
+      return 0;
+   }
+
+   size_t size = scratchsize_radixsort(elemsize, len, keysize);
+   if (size == (size_t)-1) {
+      err = ENOMEM;
+      goto ONERR;
+   }
+
+   err = getscratch_radixsort(sort, size, &scratch);
+   if (err) goto ONERR;
+
+   if (keysize <= radixsort_MAXLSDKEYSIZE) {
+      lsdsort_radixsort(&key, len, a, scratch);
+   } else {
+      msdsort_radixsort(&key, len, a, scratch);
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int sortuint_radixsort(radixsort_t * sort, uint8_t elemsize, size_t len, void * a/*uint8_t[len*elemsize]*/, uint8_t keyoffset, uint8_t keysize)
+{
+   return sort_radixsort(sort, true, elemsize, len, a, keyoffset, keysize);
+}
+
+int sortbinary_radixsort(radixsort_t * sort, uint8_t elemsize, size_t len, void * a/*uint8_t[len*elemsize]*/, uint8_t keyoffset, uint8_t keysize)
+{
+   return sort_radixsort(sort, false, elemsize, len, a, keyoffset, keysize);
+}
+
+
+// section: Functions
+
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
+
+/* define: PT_LEN
+ * Number of elements sorted by every perftest instance. */
+#define PT_LEN (1024*1024)
+
+/* struct: pt_sort_t
+ * Arrays and sort state of a single perftest instance. */
+typedef struct pt_sort_t {
+   vmpage_t    vmpage;
+   radixsort_t sort;
+   uint64_t  * data;
+   uint64_t  * a;
+} pt_sort_t;
+
+static int pt_prepare(perftest_instance_t* tinst)
+{
+   int err;
+   vmpage_t    vmpage;
+   pt_sort_t * psort;
+   uint32_t    seed = tinst->tid;
+
+   err = init_vmpage(&vmpage, sizeof(pt_sort_t) + 2 * PT_LEN * sizeof(uint64_t));
+   if (err) return err;
+
+   psort = (pt_sort_t*) vmpage.addr;
+   psort->vmpage = vmpage;
+   psort->data   = (uint64_t*) (psort + 1);
+   psort->a      = psort->data + PT_LEN;
+   init_radixsort(&psort->sort);
+
+   for (size_t i = 0; i < PT_LEN; ++i) {
+      seed = seed * 1103515245 + 12345;
+      psort->data[i] = ((uint64_t)seed << 16) + i;
+   }
+
+   tinst->nrops = PT_LEN;
+   tinst->addr  = psort;
+   tinst->size  = sizeof(pt_sort_t);
+
+   return 0;
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   int err;
+   pt_sort_t * psort  = (pt_sort_t*) tinst->addr;
+   vmpage_t    vmpage = psort->vmpage;
+
+   err = free_radixsort(&psort->sort);
+   int err2 = free_vmpage(&vmpage);
+   if (err2) err = err2;
+
+   return err;
+}
+
+static int pt_run(perftest_instance_t* tinst)
+{
+   pt_sort_t * psort = (pt_sort_t*) tinst->addr;
+
+   memcpy(psort->a, psort->data, PT_LEN * sizeof(uint64_t));
+
+   return sortuint_radixsort(&psort->sort, sizeof(uint64_t), PT_LEN, psort->a, 0, sizeof(uint64_t));
+}
+
+int perftest_ds_sort_radixsort(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run, &pt_unprepare),
+               "Sort 1M random uint64_t values with sortuint_radixsort",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+static int test_initfree(void)
+{
+   radixsort_t sort = radixsort_FREE;
+   uint8_t     buffer[100];
+
+   // TEST radixsort_FREE
+   TEST(0 == sort.scratch);
+   TEST(0 == sort.scratchsize);
+   TEST(0 == sort.temp);
+   TEST(0 == sort.tempsize);
+
+   // TEST init_radixsort
+   memset(&sort, 255, sizeof(sort));
+   init_radixsort(&sort);
+   TEST(0 == sort.scratch);
+   TEST(0 == sort.scratchsize);
+   TEST(0 == sort.temp);
+   TEST(0 == sort.tempsize);
+
+   // TEST initscratch_radixsort
+   memset(&sort, 255, sizeof(sort));
+   initscratch_radixsort(&sort, sizeof(buffer), buffer);
+   TEST(buffer == sort.scratch);
+   TEST(sizeof(buffer) == sort.scratchsize);
+   TEST(0 == sort.temp);
+   TEST(0 == sort.tempsize);
+
+   // TEST initscratch_radixsort: scratch == 0
+   initscratch_radixsort(&sort, sizeof(buffer), 0);
+   TEST(0 == sort.scratch);
+   TEST(0 == sort.scratchsize);
+
+   // TEST free_radixsort
+   initscratch_radixsort(&sort, sizeof(buffer), buffer);
+   TEST(0 == alloctemp_radixsort(&sort, 1));
+   TEST(0 != sort.temp);
+   TEST(pagesize_vm() == sort.tempsize);
+   TEST(0 == free_radixsort(&sort));
+   TEST(0 == sort.scratch);
+   TEST(0 == sort.scratchsize);
+   TEST(0 == sort.temp);
+   TEST(0 == sort.tempsize);
+   TEST(0 == free_radixsort(&sort));
+   TEST(0 == sort.temp);
+   TEST(0 == sort.tempsize);
+
+   // TEST free_radixsort: ERROR
+   TEST(0 == alloctemp_radixsort(&sort, 1));
+   init_testerrortimer(&s_radixsort_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == free_radixsort(&sort));
+   TEST(0 == sort.temp);
+   TEST(0 == sort.tempsize);
+
+   return 0;
+ONERR:
+   free_radixsort(&sort);
+   return EINVAL;
+}
+
+static int test_query(void)
+{
+   const size_t A = sizeof(size_t)-1;
+
+   // TEST scratchsize_radixsort: no scratch needed
+   for (size_t len = 0; len < radixsort_INSERTSORTLEN; ++len) {
+      TEST(0 == scratchsize_radixsort(1, len, 1));
+      TEST(0 == scratchsize_radixsort(255, len, 255));
+   }
+
+   // TEST scratchsize_radixsort: LSD
+   for (uint8_t keysize = 1; keysize <= radixsort_MAXLSDKEYSIZE; ++keysize) {
+      TEST(32*keysize + A + keysize*256*sizeof(size_t) == scratchsize_radixsort(keysize, 32, keysize));
+      TEST(10000*16 + A + keysize*256*sizeof(size_t) == scratchsize_radixsort(16, 10000, keysize));
+   }
+
+   // TEST scratchsize_radixsort: MSD
+   for (unsigned keysize = radixsort_MAXLSDKEYSIZE+1; keysize <= 255; keysize += 41) {
+      size_t expect = 1000*255 + A + 256*sizeof(size_t) + keysize*256*sizeof(radixsort_bucket_t);
+      TEST(expect == scratchsize_radixsort(255, 1000, (uint8_t)keysize));
+   }
+
+   // TEST scratchsize_radixsort: overflow
+   TEST((size_t)-1 == scratchsize_radixsort(0, 32, 1));
+   TEST((size_t)-1 == scratchsize_radixsort(1, (size_t)-1, 1));
+   TEST((size_t)-1 == scratchsize_radixsort(2, (size_t)-1/2, 1));
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+/* function: fill_testarray
+ * Fills len elements of elemsize bytes with random keys of keysize bytes at offset keyoffset.
+ * The other bytes of every element contain its index as sequence number.
+ * Keys use only 3 different values for every byte which generates many equal keys.
+ * In case of long keys the first half of the key is a common prefix. */
+static void fill_testarray(uint8_t elemsize, size_t len, uint8_t * a, uint8_t keyoffset, uint8_t keysize)
+{
+   for (size_t i = 0; i < len; ++i) {
+      uint8_t * elem = a + i * elemsize;
+      memset(elem, 0, elemsize);
+      for (unsigned k = 0; k < keysize; ++k) {
+         elem[keyoffset + k] = (uint8_t) (keysize > 8 && k < keysize/2 ? 0x55 : random() % 3);
+      }
+      uint32_t seq = (uint32_t) i;
+      if (keyoffset >= sizeof(seq)) {
+         memcpy(elem, &seq, sizeof(seq));
+      } else {
+         memcpy(elem + keyoffset + keysize, &seq, sizeof(seq));
+      }
+   }
+}
+
+static uint32_t seq_testarray(uint8_t elemsize, size_t i, const uint8_t * a, uint8_t keyoffset, uint8_t keysize)
+{
+   uint32_t seq;
+   const uint8_t * elem = a + i * elemsize;
+   if (keyoffset >= sizeof(seq)) {
+      memcpy(&seq, elem, sizeof(seq));
+   } else {
+      memcpy(&seq, elem + keyoffset + keysize, sizeof(seq));
+   }
+   return seq;
+}
+
+/* function: check_testarray
+ * Checks that a is sorted and stable. Keys are compared as unsigned integers
+ * in host byte order if isuint is true else as byte strings. */
+static int check_testarray(bool isuint, uint8_t elemsize, size_t len, const uint8_t * a, uint8_t keyoffset, uint8_t keysize)
+{
+   uint64_t seqsum = 0;
+
+   for (size_t i = 0; i < len; ++i) {
+      uint32_t seq = seq_testarray(elemsize, i, a, keyoffset, keysize);
+      seqsum += seq;
+      if (i) {
+         const uint8_t * prev = a + (i-1) * elemsize + keyoffset;
+         const uint8_t * next = a + i * elemsize + keyoffset;
+         int cmp = 0;
+         for (unsigned k = 0; k < keysize && !cmp; ++k) {
+            unsigned pos = isuint && islittleendian_radixsort() ? keysize-1u-k : k;
+            cmp = (prev[pos] > next[pos]) - (prev[pos] < next[pos]);
+         }
+         TEST(cmp <= 0);
+         TEST(cmp < 0 || seq_testarray(elemsize, i-1, a, keyoffset, keysize) < seq);
+      }
+   }
+
+   TEST(seqsum == (uint64_t)len * (len ? len-1 : 0) / 2);
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_sort(memblock_t * mblock)
+{
+   radixsort_t sort = radixsort_FREE;
+   uint8_t *   a    = mblock->addr;
+   const size_t lens[] = { 0, 1, 2, 31, 32, 33, 1000, 20000 };
+   const uint8_t keysizes[] = { 1, 2, 3, 4, 8, 9, 16, 40 };
+
+   // prepare
+   init_radixsort(&sort);
+   TEST(mblock->size >= 20000 * 48);
+
+   // TEST sortuint_radixsort, sortbinary_radixsort: LSD and MSD
+   for (unsigned ki = 0; ki < lengthof(keysizes); ++ki) {
+      const uint8_t keysize = keysizes[ki];
+      for (uint8_t keyoffset = 0; keyoffset <= 5; keyoffset = (uint8_t) (keyoffset + 5)) {
+         const uint8_t elemsize = (uint8_t) (keyoffset + keysize + 4);
+         for (unsigned li = 0; li < lengthof(lens); ++li) {
+            for (int isuint = 0; isuint <= 1; ++isuint) {
+               fill_testarray(elemsize, lens[li], a, keyoffset, keysize);
+               if (isuint) {
+                  TEST(0 == sortuint_radixsort(&sort, elemsize, lens[li], a, keyoffset, keysize));
+               } else {
+                  TEST(0 == sortbinary_radixsort(&sort, elemsize, lens[li], a, keyoffset, keysize));
+               }
+               TEST(0 == check_testarray(isuint, elemsize, lens[li], a, keyoffset, keysize));
+            }
+         }
+      }
+   }
+
+   // TEST sortuint_radixsort: integer values
+   for (unsigned shift = 0; shift < 64; shift += 7) {
+      uint64_t * values = (uint64_t*) a;
+      for (unsigned i = 0; i < 20000; ++i) {
+         values[i] = (((uint64_t)random() << 32) + (uint64_t)random()) >> shift;
+      }
+      TEST(0 == sortuint_radixsort(&sort, sizeof(uint64_t), 20000, values, 0, sizeof(uint64_t)));
+      for (unsigned i = 1; i < 20000; ++i) {
+         TEST(values[i-1] <= values[i]);
+      }
+   }
+   for (unsigned i = 0; i < 20000; ++i) {
+      ((uint32_t*)a)[i] = (uint32_t) random();
+   }
+   TEST(0 == sortuint_radixsort(&sort, sizeof(uint32_t), 20000, a, 0, sizeof(uint32_t)));
+   for (unsigned i = 1; i < 20000; ++i) {
+      TEST(((uint32_t*)a)[i-1] <= ((uint32_t*)a)[i]);
+   }
+
+   // TEST sortbinary_radixsort: all keys equal
+   fill_testarray(24, 20000, a, 0, 20);
+   for (unsigned i = 0; i < 20000; ++i) {
+      memset(a + 24*i, 7, 20);
+   }
+   TEST(0 == sortbinary_radixsort(&sort, 24, 20000, a, 0, 20));
+   for (unsigned i = 0; i < 20000; ++i) {
+      TEST(i == seq_testarray(24, i, a, 0, 20));
+   }
+
+   // TEST sortuint_radixsort: EINVAL
+   TEST(EINVAL == sortuint_radixsort(&sort, 0, 100, a, 0, 1));
+   TEST(EINVAL == sortuint_radixsort(&sort, 8, 100, a, 0, 0));
+   TEST(EINVAL == sortuint_radixsort(&sort, 8, 100, a, 1, 8));
+   TEST(EINVAL == sortuint_radixsort(&sort, 8, 100, a, 8, 1));
+   TEST(EINVAL == sortuint_radixsort(&sort, 2, (size_t)-1, a, 0, 1));
+   // TEST sortbinary_radixsort: EINVAL
+   TEST(EINVAL == sortbinary_radixsort(&sort, 0, 100, a, 0, 1));
+   TEST(EINVAL == sortbinary_radixsort(&sort, 255, 100, a, 255, 1));
+
+   // TEST sortuint_radixsort: ENOMEM (array not changed)
+   TEST(0 == free_radixsort(&sort));
+   fill_testarray(12, 1000, a, 4, 8);
+   memcpy(a + 12*1000, a, 12*1000);
+   init_testerrortimer(&s_radixsort_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == sortuint_radixsort(&sort, 12, 1000, a, 4, 8));
+   TEST(0 == memcmp(a, a + 12*1000, 12*1000));
+   TEST(0 == sort.temp);
+
+   // unprepare
+   TEST(0 == free_radixsort(&sort));
+
+   return 0;
+ONERR:
+   free_radixsort(&sort);
+   return EINVAL;
+}
+
+static int test_scratch(memblock_t * mblock)
+{
+   radixsort_t sort = radixsort_FREE;
+   uint8_t *   a    = mblock->addr;
+   const size_t len = 5000;
+   const size_t offset = 16 * len;
+
+   for (uint8_t keysize = 8; keysize <= 9; ++keysize) {
+      const size_t size = scratchsize_radixsort(16, len, keysize);
+      TEST(mblock->size >= offset + 1 + size);
+
+      // TEST initscratch_radixsort: scratch memory is used (unaligned)
+      for (unsigned unaligned = 0; unaligned <= 1; ++unaligned) {
+         initscratch_radixsort(&sort, size, a + offset + unaligned);
+         fill_testarray(16, len, a, 0, keysize);
+         TEST(0 == sortbinary_radixsort(&sort, 16, len, a, 0, keysize));
+         TEST(0 == check_testarray(false, 16, len, a, 0, keysize));
+         TEST(0 == sort.temp);
+         TEST(0 == free_radixsort(&sort));
+      }
+
+      // TEST initscratch_radixsort: scratch memory too small
+      initscratch_radixsort(&sort, size-1, a + offset);
+      fill_testarray(16, len, a, 0, keysize);
+      TEST(0 == sortbinary_radixsort(&sort, 16, len, a, 0, keysize));
+      TEST(0 == check_testarray(false, 16, len, a, 0, keysize));
+      TEST(0 != sort.temp);
+      TEST(size <= sort.tempsize);
+
+      // TEST sortbinary_radixsort: allocated memory is reused
+      uint8_t * temp = sort.temp;
+      fill_testarray(16, len, a, 0, keysize);
+      TEST(0 == sortbinary_radixsort(&sort, 16, len, a, 0, keysize));
+      TEST(temp == sort.temp);
+      TEST(0 == free_radixsort(&sort));
+   }
+
+   return 0;
+ONERR:
+   free_radixsort(&sort);
+   return EINVAL;
+}
+
+int unittest_ds_sort_radixsort()
+{
+   memblock_t mblock = memblock_FREE;
+
+   TEST(0 == ALLOC_MM(20000 * 48 * 2, &mblock));
+
+   if (test_initfree())       goto ONERR;
+   if (test_query())          goto ONERR;
+   if (test_sort(&mblock))    goto ONERR;
+   if (test_scratch(&mblock)) goto ONERR;
+
+   TEST(0 == FREE_MM(&mblock));
+
+   return 0;
+ONERR:
+   FREE_MM(&mblock);
+   return EINVAL;
+}
+
+#endif
@@ -21,6 +21,7 @@
 #include "C-kern/api/io/iochannel.h"
 #include "C-kern/api/io/filesystem/fileutil.h"
 #include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/memstream.h"
 #include "C-kern/api/memory/wbuffer.h"
 #include "C-kern/api/memory/mm/mm_macros.h"
 #include "C-kern/api/string/string.h"
@@ -159,22 +160,26 @@ ONERR:
  * Comments begins with a '#' and extends until end of line. */
 static void skipempty_csvparser(csvparser_t * state)
 {
-   while (state->offset < state->length) {
-      if (state->data[state->offset] == '\n') {
-         state->startofline = ++state->offset;
+   static const memstream_byteset_t s_space = memstream_byteset_INIT(3, ' ', '\t', '\r');
+   memstream_ro_t memstr = memstream_INIT(state->data + state->offset, state->data + state->length);
+
+   while (isnext_memstream(&memstr)) {
+      uint8_t c = peek_memstream(&memstr);
+      if (c == '\n') {
+         skip_memstream(&memstr, 1);
+         state->startofline = offset_memstream(&memstr, state->data);
          ++state->linenr;
-      } else if ( state->data[state->offset] == ' '
-                  || state->data[state->offset] == '\t'
-                  || state->data[state->offset] == '\r') {
-         ++state->offset;
-      } else if (state->data[state->offset] == '#') {
-         while ((++state->offset) < state->length) {
-            if (state->data[state->offset] == '\n') break;
-         }
+      } else if (c == ' ' || c == '\t' || c == '\r') {
+         skipbyteset_memstream(&memstr, &s_space);
+      } else if (c == '#') {
+         const uint8_t * eol = findbyte_memstream(&memstr, '\n');
+         memstr.next = eol ? eol : memstr.end;
       } else {
          break;
       }
    }
+
+   state->offset = offset_memstream(&memstr, state->data);
 }
 
 /* function: parsechar_csvparser
@@ -209,12 +214,12 @@ static int parsedatafield_csvparser(csvparser_t * state, /*out*/string_t * value
    err = parsechar_csvparser(state, (uint8_t)'"');
    if (err) goto ONERR;
 
+   static const memstream_byteset_t s_endofvalue = memstream_byteset_INIT(2, '"', '\n');
+   memstream_ro_t memstr = memstream_INIT(state->data + state->offset, state->data + state->length);
+   const uint8_t * found = findbyteset_memstream(&memstr, &s_endofvalue);
+
    size_t start = state->offset;
-   while (  state->offset < state->length
-            && state->data[state->offset] != '"'
-            && state->data[state->offset] != '\n') {
-      ++ state->offset;
-   }
+   state->offset = found ? (size_t) (found - state->data) : state->length;
    size_t end = state->offset;
 
    err = parsechar_csvparser(state, (uint8_t)'"');
@@ -1526,6 +1526,8 @@ static int parse_textdefinitions_textresourcereader(textresource_reader_t * read
       if (err) return err ;
 
       err = insert_arraytname(reader->txtres.textnames, &text, &textcopy, &g_textrestext_nodeadapter) ;
+      // copy allocates its own params
+      (void) delete_arrayparam(&text.params, 0) ;
       if (err) {
          if (EEXIST == err) {
             err = EINVAL ;
@@ -166,6 +166,20 @@ static int test_readwrite(void)
       TEST(i == read_atomicint(&i));
    }
 
+   // TEST loadacquire_atomicint
+   intargs.u32 = 0;
+   intargs.u64 = 0;
+   intargs.uptr = 0;
+   TEST(0 == loadacquire_atomicint(&intargs.u32));
+   TEST(0 == loadacquire_atomicint(&intargs.u64));
+   TEST(0 == loadacquire_atomicint(&intargs.uptr));
+   for (uint32_t i = 1; i; i <<= 1) {
+      TEST(i == loadacquire_atomicint(&i));
+   }
+   for (uint64_t i = 1; i; i <<= 1) {
+      TEST(i == loadacquire_atomicint(&i));
+   }
+
    // TEST write_atomicint
    write_atomicint(&intargs.u32, 0);
    write_atomicint(&intargs.u64, 0);
@@ -186,6 +200,26 @@ static int test_readwrite(void)
       TEST(i == intargs.uptr);
    }
 
+   // TEST storerelease_atomicint
+   storerelease_atomicint(&intargs.u32, 0);
+   storerelease_atomicint(&intargs.u64, 0);
+   storerelease_atomicint(&intargs.uptr, 0);
+   TEST(0 == read_atomicint(&intargs.u32));
+   TEST(0 == read_atomicint(&intargs.u64));
+   TEST(0 == read_atomicint(&intargs.uptr));
+   for (uint32_t i = 1; i; i <<= 1) {
+      storerelease_atomicint(&intargs.u32, i);
+      TEST(i == intargs.u32);
+   }
+   for (uint64_t i = 1; i; i <<= 1) {
+      storerelease_atomicint(&intargs.u64, i);
+      TEST(i == intargs.u64);
+   }
+   for (uintptr_t i = 1; i; i <<= 1) {
+      storerelease_atomicint(&intargs.uptr, i);
+      TEST(i == intargs.uptr);
+   }
+
    // TEST read_atomicint, write_atomicint: multi thread
    intargs.u32  = 0;
    intargs.u64  = 0;
@@ -18,12 +18,122 @@
 #include "C-kern/konfig.h"
 #include "C-kern/api/memory/memstream.h"
 #include "C-kern/api/err.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/unittest.h"
 #include "C-kern/api/string/string.h"
 #endif
 
 
+// section: memstream_byteset_t
+
+// group: lifetime
+
+int init_memstreambyteset(/*out*/memstream_byteset_t * set, size_t len, const uint8_t bytes[len])
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(len <= memstream_byteset_MAXBYTE, ONERR, PRINTSIZE_ERRLOG(len));
+
+   set->nrbyte = (uint8_t) len;
+   memcpy(set->byte, bytes, len);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+/* function: isbyte_memstreambyteset
+ * Returns true if byte is contained in set. */
+static inline bool isbyte_memstreambyteset(const memstream_byteset_t * set, uint8_t byte)
+{
+   for (unsigned i = 0; i < set->nrbyte; ++i) {
+      if (set->byte[i] == byte) return true;
+   }
+   return false;
+}
+
+
+// section: memstream_ro_t
+
+// group: query
+
+/* function: findbytesetmask_memstreamro
+ * Returns position of first byte b in [next, end) where (isbyte_memstreambyteset(set, b) != isnot).
+ * If the target supports SSE2 16 bytes are compared with all bytes of set in one step.
+ * The result of the comparison is converted into a bitmask which is xored with 0xffff
+ * in case of isnot. The lowest set bit gives the position of the found byte.
+ * The remaining (end-next)%16 bytes are compared one by one. */
+static inline const uint8_t * findbytesetmask_memstreamro(const uint8_t * next, const uint8_t * end, const memstream_byteset_t * set, bool isnot)
+{
+#ifdef __SSE2__
+   if (end - next >= 16) {
+      const unsigned notmask = isnot ? 0xffff : 0;
+      const unsigned nrbyte  = set->nrbyte;
+      __m128i setvec[memstream_byteset_MAXBYTE];
+
+      for (unsigned i = 0; i < nrbyte; ++i) {
+         setvec[i] = _mm_set1_epi8((char) set->byte[i]);
+      }
+
+      do {
+         __m128i data  = _mm_loadu_si128((const __m128i*) next);
+         __m128i match = _mm_setzero_si128();
+         for (unsigned i = 0; i < nrbyte; ++i) {
+            match = _mm_or_si128(match, _mm_cmpeq_epi8(data, setvec[i]));
+         }
+         unsigned mask = (unsigned) _mm_movemask_epi8(match) ^ notmask;
+         if (mask) return next + __builtin_ctz(mask);
+         next += 16;
+      } while (end - next >= 16);
+   }
+#endif
+
+   for (; next < end; ++next) {
+      if (isbyte_memstreambyteset(set, *next) != isnot) return next;
+   }
+
+   return 0;
+}
+
+const uint8_t * findbyteset_memstreamro(const memstream_ro_t * memstr, const memstream_byteset_t * set)
+{
+   return findbytesetmask_memstreamro(memstr->next, memstr->end, set, false);
+}
+
+const uint8_t * findnotbyteset_memstreamro(const memstream_ro_t * memstr, const memstream_byteset_t * set)
+{
+   return findbytesetmask_memstreamro(memstr->next, memstr->end, set, true);
+}
+
+// group: write
+
+int copyuntil_memstreamro(struct memstream_t * dest, memstream_ro_t * src, uint8_t delimiter)
+{
+   const size_t srcsize = size_memstream(src);
+   const size_t dstsize = size_memstream(dest);
+   size_t len = srcsize < dstsize ? srcsize : dstsize;
+
+   if (len) {
+      const uint8_t * found = memchr(src->next, delimiter, len);
+      if (found) len = (size_t) (found - src->next);
+
+      memcpy(dest->next, src->next, len);
+      dest->next += len;
+      src->next  += len;
+   }
+
+   if (src->next == src->end) return ENODATA;
+
+   return *src->next == delimiter ? 0 : ENOBUFS;
+}
+
+
 // section: memstream_t
 
 // group: lifetime
@@ -384,6 +494,163 @@ ONERR:
    return EINVAL;
 }
 
+static int test_byteset(void)
+{
+   memstream_t    memstr;
+   memstream_ro_t memstr_ro;
+   memstream_byteset_t set = memstream_byteset_INIT(3, ' ', '\t', '\r');
+   uint8_t        buffer[100];
+   uint8_t        buffer2[100];
+
+   // TEST memstream_byteset_INIT
+   TEST(3 == set.nrbyte);
+   TEST(' ' == set.byte[0]);
+   TEST('\t' == set.byte[1]);
+   TEST('\r' == set.byte[2]);
+
+   // TEST init_memstreambyteset
+   for (unsigned len = 0; len <= memstream_byteset_MAXBYTE; ++len) {
+      for (unsigned i = 0; i < len; ++i) {
+         buffer[i] = (uint8_t) (i + len);
+      }
+      memset(&set, 255, sizeof(set));
+      TEST(0 == init_memstreambyteset(&set, len, buffer));
+      TEST(len == set.nrbyte);
+      TEST(0 == memcmp(set.byte, buffer, len));
+   }
+
+   // TEST init_memstreambyteset: EINVAL
+   TEST(EINVAL == init_memstreambyteset(&set, memstream_byteset_MAXBYTE+1, buffer));
+   TEST(memstream_byteset_MAXBYTE == set.nrbyte);
+
+   // TEST findbyteset_memstream: size == 0
+   set = (memstream_byteset_t) memstream_byteset_INIT(1, 0);
+   memset(buffer, 0, sizeof(buffer));
+   for (unsigned i = 0; i <= sizeof(buffer); ++i) {
+      init_memstream(&memstr, buffer+i, buffer+i);
+      init_memstream(&memstr_ro, buffer+i, buffer+i);
+      TEST(0 == findbyteset_memstream(&memstr, &set));
+      TEST(0 == findbyteset_memstream(&memstr_ro, &set));
+      TEST(0 == findnotbyteset_memstream(&memstr, &set));
+      TEST(0 == findnotbyteset_memstream(&memstr_ro, &set));
+   }
+
+   // TEST findbyteset_memstream: empty set
+   set = (memstream_byteset_t) memstream_byteset_INIT(0, 0);
+   init_memstream(&memstr, buffer, buffer+sizeof(buffer));
+   TEST(0 == findbyteset_memstream(&memstr, &set));
+   TEST(buffer == findnotbyteset_memstream(&memstr, &set));
+
+   // TEST findbyteset_memstream, findnotbyteset_memstream: every position and every set size
+   for (unsigned nrbyte = 1; nrbyte <= memstream_byteset_MAXBYTE; ++nrbyte) {
+      for (unsigned i = 0; i < nrbyte; ++i) {
+         set.byte[i] = (uint8_t) (10*i + 1);
+      }
+      set.nrbyte = (uint8_t) nrbyte;
+      for (unsigned start = 0; start < 17; ++start) {
+         init_memstream(&memstr, buffer+start, buffer+sizeof(buffer));
+         init_memstream(&memstr_ro, buffer+start, buffer+sizeof(buffer));
+         for (unsigned off = start; off < sizeof(buffer); ++off) {
+            // find
+            memset(buffer, 0, sizeof(buffer));
+            buffer[off] = set.byte[off % nrbyte];
+            TEST(buffer+off == findbyteset_memstream(&memstr, &set));
+            TEST(buffer+off == findbyteset_memstream(&memstr_ro, &set));
+            // findnot
+            for (unsigned i = 0; i < sizeof(buffer); ++i) {
+               buffer[i] = set.byte[i % nrbyte];
+            }
+            buffer[off] = 2;
+            TEST(buffer+off == findnotbyteset_memstream(&memstr, &set));
+            TEST(buffer+off == findnotbyteset_memstream(&memstr_ro, &set));
+         }
+      }
+   }
+
+   // TEST findbyteset_memstream, findnotbyteset_memstream: not found
+   set = (memstream_byteset_t) memstream_byteset_INIT(2, 'a', 'b');
+   for (unsigned size = 0; size < sizeof(buffer); ++size) {
+      memset(buffer, 'c', sizeof(buffer));
+      buffer[size] = 'a';
+      init_memstream(&memstr, buffer, buffer+size);
+      TEST(0 == findbyteset_memstream(&memstr, &set));
+      memset(buffer, 'b', sizeof(buffer));
+      buffer[size] = 'c';
+      TEST(0 == findnotbyteset_memstream(&memstr, &set));
+   }
+
+   // TEST skipbyteset_memstream
+   set = (memstream_byteset_t) memstream_byteset_INIT(3, ' ', '\t', '\r');
+   for (unsigned size = 0; size <= sizeof(buffer); ++size) {
+      for (unsigned i = 0; i < sizeof(buffer); ++i) {
+         buffer[i] = set.byte[i % 3];
+      }
+      if (size < sizeof(buffer)) buffer[size] = 'x';
+      init_memstream(&memstr, buffer, buffer+sizeof(buffer));
+      TEST(size == skipbyteset_memstream(&memstr, &set));
+      TEST(buffer+size == memstr.next);
+      TEST(buffer+sizeof(buffer) == memstr.end);
+      // nothing to skip
+      TEST(0 == skipbyteset_memstream(&memstr, &set));
+      TEST(buffer+size == memstr.next);
+   }
+
+   // TEST copyuntil_memstream: delimiter found
+   for (unsigned i = 0; i < sizeof(buffer); ++i) {
+      buffer[i] = (uint8_t) ('a' + i % 26);
+   }
+   for (unsigned off = 0; off < sizeof(buffer); ++off) {
+      uint8_t delim = buffer[off];
+      buffer[off] = ';';
+      memset(buffer2, 0, sizeof(buffer2));
+      init_memstream(&memstr, buffer2, buffer2+sizeof(buffer2));
+      init_memstream(&memstr_ro, buffer, buffer+sizeof(buffer));
+      TEST(0 == copyuntil_memstream(&memstr, &memstr_ro, ';'));
+      TEST(buffer+off  == memstr_ro.next);
+      TEST(buffer2+off == memstr.next);
+      TEST(0 == memcmp(buffer, buffer2, off));
+      TEST(0 == buffer2[off]);
+      buffer[off] = delim;
+   }
+
+   // TEST copyuntil_memstream: ENODATA
+   memset(buffer2, 0, sizeof(buffer2));
+   init_memstream(&memstr, buffer2, buffer2+sizeof(buffer2));
+   init_memstream(&memstr_ro, buffer, buffer+sizeof(buffer)-1);
+   TEST(ENODATA == copyuntil_memstream(&memstr, &memstr_ro, ';'));
+   TEST(buffer+sizeof(buffer)-1  == memstr_ro.next);
+   TEST(buffer2+sizeof(buffer)-1 == memstr.next);
+   TEST(0 == memcmp(buffer, buffer2, sizeof(buffer)-1));
+
+   // TEST copyuntil_memstream: ENOBUFS
+   memset(buffer2, 0, sizeof(buffer2));
+   init_memstream(&memstr, buffer2, buffer2+10);
+   init_memstream(&memstr_ro, buffer, buffer+sizeof(buffer));
+   TEST(ENOBUFS == copyuntil_memstream(&memstr, &memstr_ro, ';'));
+   TEST(buffer+10  == memstr_ro.next);
+   TEST(buffer2+10 == memstr.next);
+   TEST(0 == memcmp(buffer, buffer2, 10));
+   TEST(0 == buffer2[10]);
+
+   // TEST copyuntil_memstream: dest is full but next byte is delimiter
+   buffer[10] = ';';
+   TEST(0 == copyuntil_memstream(&memstr, &memstr_ro, ';'));
+   TEST(buffer+10  == memstr_ro.next);
+   TEST(buffer2+10 == memstr.next);
+
+   // TEST copyuntil_memstream: src of type memstream_t
+   memstream_t src = memstream_INIT(buffer, buffer+sizeof(buffer));
+   buffer[5] = ';';
+   init_memstream(&memstr, buffer2, buffer2+sizeof(buffer2));
+   TEST(0 == copyuntil_memstream(&memstr, &src, ';'));
+   TEST(buffer+5  == src.next);
+   TEST(buffer2+5 == memstr.next);
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
 static int test_generic(void)
 {
    memstream_t    obj1;
@@ -437,6 +704,7 @@ int unittest_memory_memstream()
    if (test_query())          goto ONERR;
    if (test_update())         goto ONERR;
    if (test_write())          goto ONERR;
+   if (test_byteset())        goto ONERR;
    if (test_generic())        goto ONERR;
 
    return 0;
@@ -0,0 +1,800 @@
+/* title: ArenaMemoryManager impl
+
+   Implements <ArenaMemoryManager>.
+
+   Copyright:
+   This program is free software. See accompanying LICENSE file.
+
+   file: C-kern/api/memory/mm/mm_arena.h
+    Header file <ArenaMemoryManager>.
+
+   file: C-kern/memory/mm/mm_arena.c
+    Implementation file <ArenaMemoryManager impl>.
+*/
+
+#include "C-kern/konfig.h"
+#include "C-kern/api/memory/mm/mm_arena.h"
+#include "C-kern/api/err.h"
+#include "C-kern/api/math/int/log2.h"
+#include "C-kern/api/math/int/power2.h"
+#include "C-kern/api/memory/mm/mm.h"
+#include "C-kern/api/memory/memblock.h"
+#include "C-kern/api/memory/pagecache_macros.h"
+#include "C-kern/api/memory/vm.h"
+#ifdef KONFIG_UNITTEST
+#include "C-kern/api/test/resourceusage.h"
+#include "C-kern/api/test/unittest.h"
+#include "C-kern/api/memory/mm/mm_macros.h"
+#endif
+
+
+// section: mm_arena_page_t
+
+/* struct: mm_arena_page_t
+ * Header of a page memory blocks are allocated from.
+ * Memory blocks start at offset <mm_arena_page_HEADERSIZE>. */
+typedef struct mm_arena_page_t {
+   /* variable: prev
+    * Points to previously allocated page or to next page in <mm_arena_t.freepage>. */
+   struct mm_arena_page_t *prev;
+   /* variable: size
+    * Size of the whole page in bytes including header. */
+   size_t                  size;
+} mm_arena_page_t;
+
+// group: config
+
+/* define: mm_arena_page_HEADERSIZE
+ * Size of <mm_arena_page_t> rounded up to a multiple of <KONFIG_MEMALIGN>. */
+#define mm_arena_page_HEADERSIZE \
+         ((sizeof(mm_arena_page_t) + KONFIG_MEMALIGN-1) & ~(size_t)(KONFIG_MEMALIGN-1))
+
+/* define: mm_arena_page_MAXPAGECACHESIZE
+ * Pages up to this size are allocated with <ALLOC_PAGECACHE>.
+ * Larger pages are mapped with <init_vmpage>. */
+#define mm_arena_page_MAXPAGECACHESIZE (1024*1024)
+
+// group: lifetime
+
+/* function: new_arenapage
+ * Allocates a new page which can store a memory block of size minsize.
+ * The size of the page is <mm_arena_PAGESIZE> or the next power of two
+ * if minsize is too large. Pages larger than <mm_arena_page_MAXPAGECACHESIZE>
+ * are mapped with <init_vmpage>. */
+static int new_arenapage(/*out*/mm_arena_page_t ** page, size_t minsize)
+{
+   int err;
+   size_t pgsize = mm_arena_page_HEADERSIZE + minsize;
+
+   if (minsize > ((size_t)-1)/2) {
+      err = ENOMEM;
+      TRACEOUTOFMEM_ERRLOG(minsize, err);
+      goto ONERR;
+   }
+
+   if (pgsize <= mm_arena_page_MAXPAGECACHESIZE) {
+      memblock_t mblock;
+      if (pgsize < mm_arena_PAGESIZE) pgsize = mm_arena_PAGESIZE;
+      err = ALLOC_PAGECACHE(pagesizefrombytes_pagecache(makepowerof2_int(pgsize)), &mblock);
+      if (err) goto ONERR;
+      *page = (mm_arena_page_t*) mblock.addr;
+      (*page)->size = mblock.size;
+
+   } else {
+      vmpage_t vmpage;
+      err = init_vmpage(&vmpage, pgsize);
+      if (err) goto ONERR;
+      *page = (mm_arena_page_t*) vmpage.addr;
+      (*page)->size = vmpage.size;
+   }
+
+   (*page)->prev = 0;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: delete_arenapage
+ * Returns page either to <pagecache_t> or unmaps it. */
+static int delete_arenapage(mm_arena_page_t * page)
+{
+   int err;
+
+   if (page->size <= mm_arena_page_MAXPAGECACHESIZE) {
+      memblock_t mblock = memblock_INIT(page->size, (uint8_t*)page);
+      err = RELEASE_PAGECACHE(&mblock);
+   } else {
+      vmpage_t vmpage = vmpage_INIT(page->size, (uint8_t*)page);
+      err = free_vmpage(&vmpage);
+   }
+
+   return err;
+}
+
+
+// section: mm_arena_t
+
+// group: types
+
+/* typedef: mm_arena_it
+ * Adapts <mm_it> to <mm_arena_t>. See <mm_it_DECLARE>. */
+mm_it_DECLARE(mm_arena_it, mm_arena_t)
+
+// group: static variables
+
+/* variable: s_mmarena_interface
+ * Contains single instance of interface <mm_arena_it>. */
+static mm_arena_it   s_mmarena_interface = mm_it_INIT(
+                           &malloc_mmarena,
+                           &mresize_mmarena,
+                           &mfree_mmarena,
+                           &sizeallocated_mmarena
+                        ) ;
+
+// group: helper
+
+/* function: alignsize_mmarena
+ * Rounds size up to next multiple of <KONFIG_MEMALIGN>. */
+static inline size_t alignsize_mmarena(size_t size)
+{
+   static_assert(ispowerof2_int(KONFIG_MEMALIGN), "alignment is power of two");
+   return alignpower2_int(size, (size_t)KONFIG_MEMALIGN);
+}
+
+/* function: pushpage_mmarena
+ * Makes page the current page of arena. */
+static inline void pushpage_mmarena(mm_arena_t * arena, mm_arena_page_t * page)
+{
+   page->prev   = arena->page;
+   arena->page  = page;
+   arena->next  = (uint8_t*)page + mm_arena_page_HEADERSIZE;
+   arena->end   = (uint8_t*)page + page->size;
+}
+
+/* function: addpage_mmarena
+ * Makes a page with at least size bytes of free memory the current page of arena.
+ * A page from the cache of unused pages is reused if possible. */
+static int addpage_mmarena(mm_arena_t * arena, size_t size)
+{
+   int err;
+   mm_arena_page_t * page;
+
+   if (  arena->freepage
+         && size <= mm_arena_PAGESIZE - mm_arena_page_HEADERSIZE) {
+      page = arena->freepage;
+      arena->freepage = page->prev;
+
+   } else {
+      err = new_arenapage(&page, size);
+      if (err) return err;
+   }
+
+   pushpage_mmarena(arena, page);
+
+   return 0;
+}
+
+// group: initthread
+
+mm_it * interface_mmarena(void)
+{
+   return cast_mmit(&s_mmarena_interface, mm_arena_t);
+}
+
+// group: lifetime
+
+int init_mmarena(/*out*/mm_arena_t * arena)
+{
+   *arena = (mm_arena_t) mm_arena_FREE;
+   return 0;
+}
+
+int free_mmarena(mm_arena_t * arena)
+{
+   int err = 0;
+   int err2;
+
+   while (arena->page) {
+      mm_arena_page_t * page = arena->page;
+      arena->page = page->prev;
+      err2 = delete_arenapage(page);
+      if (err2) err = err2;
+   }
+
+   while (arena->freepage) {
+      mm_arena_page_t * page = arena->freepage;
+      arena->freepage = page->prev;
+      err2 = delete_arenapage(page);
+      if (err2) err = err2;
+   }
+
+   *arena = (mm_arena_t) mm_arena_FREE;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: query
+
+size_t sizeallocated_mmarena(mm_arena_t * arena)
+{
+   return arena->allocated;
+}
+
+// group: state
+
+void storestate_mmarena(const mm_arena_t * arena, /*out*/mm_arena_state_t * state)
+{
+   state->page      = arena->page;
+   state->next      = arena->next;
+   state->allocated = arena->allocated;
+}
+
+int restore_mmarena(mm_arena_t * arena, const mm_arena_state_t * state)
+{
+   int err = 0;
+
+   while (arena->page != state->page) {
+      mm_arena_page_t * page = arena->page;
+      arena->page = page->prev;
+      if (page->size == mm_arena_PAGESIZE) {
+         page->prev = arena->freepage;
+         arena->freepage = page;
+      } else {
+         int err2 = delete_arenapage(page);
+         if (err2) err = err2;
+      }
+   }
+
+   arena->next      = state->next;
+   arena->end       = state->page ? (uint8_t*)state->page + state->page->size : 0;
+   arena->allocated = state->allocated;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int reset_mmarena(mm_arena_t * arena)
+{
+   mm_arena_state_t state = mm_arena_state_FREE;
+   return restore_mmarena(arena, &state);
+}
+
+// group: allocate
+
+int malloc_mmarena(mm_arena_t * arena, size_t size, /*eout*/struct memblock_t * memblock)
+{
+   int err;
+   size_t alignedsize = alignsize_mmarena(size);
+
+   if (alignedsize < size) {
+      err = ENOMEM;
+      TRACEOUTOFMEM_ERRLOG(size, err);
+      goto ONERR;
+   }
+
+   if ((size_t)(arena->end - arena->next) < alignedsize) {
+      err = addpage_mmarena(arena, alignedsize);
+      if (err) goto ONERR;
+   }
+
+   *memblock = (memblock_t) memblock_INIT(alignedsize, arena->next);
+   arena->next      += alignedsize;
+   arena->allocated += alignedsize;
+
+   return 0;
+ONERR:
+   *memblock = (memblock_t) memblock_FREE;
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int mresize_mmarena(mm_arena_t * arena, size_t newsize, struct memblock_t * memblock)
+{
+   int err;
+
+   if (0 == newsize) {
+      return mfree_mmarena(arena, memblock);
+   }
+
+   VALIDATE_INPARAM_TEST(isfree_memblock(memblock) || isvalid_memblock(memblock), ONERR, );
+
+   if (isfree_memblock(memblock)) {
+      return malloc_mmarena(arena, newsize, memblock);
+   }
+
+   size_t alignedsize = alignsize_mmarena(newsize);
+
+   if (  memblock->addr + memblock->size == arena->next
+         && alignedsize >= newsize
+         && alignedsize <= (size_t) (arena->end - memblock->addr)) {
+      // last allocated block => resize in place
+      arena->next       = memblock->addr + alignedsize;
+      arena->allocated += alignedsize;
+      arena->allocated -= memblock->size;
+      memblock->size    = alignedsize;
+      return 0;
+   }
+
+   memblock_t newblock;
+   err = malloc_mmarena(arena, newsize, &newblock);
+   if (err) goto ONERR;
+   memcpy(newblock.addr, memblock->addr, memblock->size < newblock.size ? memblock->size : newblock.size);
+   *memblock = newblock;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int mfree_mmarena(mm_arena_t * arena, struct memblock_t * memblock)
+{
+   int err;
+
+   (void) arena;
+
+   if (memblock->addr) {
+      VALIDATE_INPARAM_TEST(isvalid_memblock(memblock), ONERR, );
+
+      *memblock = (memblock_t) memblock_FREE;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
+
+// group: test
+
+#ifdef KONFIG_UNITTEST
+
+static int test_arenapage(void)
+{
+   mm_arena_page_t * page = 0;
+   size_t            sizepgcache = SIZEALLOCATED_PAGECACHE();
+
+   // TEST mm_arena_page_HEADERSIZE
+   TEST(mm_arena_page_HEADERSIZE >= sizeof(mm_arena_page_t));
+   TEST(0 == mm_arena_page_HEADERSIZE % KONFIG_MEMALIGN);
+
+   // TEST new_arenapage: default size
+   for (size_t minsize = 0; minsize <= mm_arena_PAGESIZE - mm_arena_page_HEADERSIZE; minsize += 1024) {
+      TEST(0 == new_arenapage(&page, minsize));
+      TEST(0 != page);
+      TEST(0 == page->prev);
+      TEST(mm_arena_PAGESIZE == page->size);
+      TEST(0 == ((uintptr_t)page % mm_arena_PAGESIZE));
+      TEST(sizepgcache + mm_arena_PAGESIZE == SIZEALLOCATED_PAGECACHE());
+      // TEST delete_arenapage
+      TEST(0 == delete_arenapage(page));
+      TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+   }
+
+   // TEST new_arenapage: next power of two
+   for (size_t pgsize = 2*mm_arena_PAGESIZE; pgsize <= mm_arena_page_MAXPAGECACHESIZE; pgsize *= 2) {
+      TEST(0 == new_arenapage(&page, pgsize/2));
+      TEST(pgsize == page->size);
+      TEST(sizepgcache + pgsize == SIZEALLOCATED_PAGECACHE());
+      TEST(0 == delete_arenapage(page));
+      TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+      TEST(0 == new_arenapage(&page, pgsize - mm_arena_page_HEADERSIZE));
+      TEST(pgsize == page->size);
+      TEST(0 == delete_arenapage(page));
+   }
+
+   // TEST new_arenapage: mapped with init_vmpage
+   TEST(0 == new_arenapage(&page, mm_arena_page_MAXPAGECACHESIZE));
+   TEST(page->size >= mm_arena_page_MAXPAGECACHESIZE + mm_arena_page_HEADERSIZE);
+   TEST(0 == page->size % pagesize_vm());
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+   TEST(0 == delete_arenapage(page));
+
+   // TEST new_arenapage: ENOMEM
+   TEST(ENOMEM == new_arenapage(&page, (size_t)-1));
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_initfree(void)
+{
+   mm_arena_t arena = mm_arena_FREE;
+   memblock_t mblock;
+   size_t     sizepgcache = SIZEALLOCATED_PAGECACHE();
+
+   // TEST mm_arena_FREE
+   TEST(0 == arena.page);
+   TEST(0 == arena.freepage);
+   TEST(0 == arena.next);
+   TEST(0 == arena.end);
+   TEST(0 == arena.allocated);
+
+   // TEST init_mmarena
+   memset(&arena, 255, sizeof(arena));
+   TEST(0 == init_mmarena(&arena));
+   TEST(0 == arena.page);
+   TEST(0 == arena.freepage);
+   TEST(0 == arena.next);
+   TEST(0 == arena.end);
+   TEST(0 == arena.allocated);
+
+   // TEST free_mmarena: releases used and cached pages
+   TEST(0 == malloc_mmarena(&arena, mm_arena_PAGESIZE/2, &mblock));
+   TEST(0 == reset_mmarena(&arena));
+   TEST(0 == malloc_mmarena(&arena, 2*mm_arena_PAGESIZE, &mblock));
+   TEST(0 == malloc_mmarena(&arena, 1, &mblock));
+   TEST(0 != arena.page);
+   TEST(0 != arena.freepage);
+   TEST(sizepgcache < SIZEALLOCATED_PAGECACHE());
+   TEST(0 == free_mmarena(&arena));
+   TEST(0 == arena.page);
+   TEST(0 == arena.freepage);
+   TEST(0 == arena.next);
+   TEST(0 == arena.end);
+   TEST(0 == arena.allocated);
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+
+   // TEST free_mmarena: double free
+   TEST(0 == free_mmarena(&arena));
+   TEST(0 == arena.page);
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_mmarena(&arena);
+   return EINVAL;
+}
+
+static int test_initthread(void)
+{
+   // TEST s_mmarena_interface
+   TEST(s_mmarena_interface.malloc  == &malloc_mmarena);
+   TEST(s_mmarena_interface.mresize == &mresize_mmarena);
+   TEST(s_mmarena_interface.mfree   == &mfree_mmarena);
+   TEST(s_mmarena_interface.sizeallocated == &sizeallocated_mmarena);
+
+   // TEST interface_mmarena
+   TEST(interface_mmarena() == cast_mmit(&s_mmarena_interface, mm_arena_t));
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_query(void)
+{
+   mm_arena_t arena = mm_arena_FREE;
+
+   // TEST sizeallocated_mmarena
+   TEST(0 == sizeallocated_mmarena(&arena));
+   for (size_t i = 1; i; i <<= 1) {
+      arena.allocated = i;
+      TEST(i == sizeallocated_mmarena(&arena));
+   }
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_allocate(void)
+{
+   mm_arena_t        arena = mm_arena_FREE;
+   memblock_t        mblock;
+   memblock_t        mblock2;
+   mm_arena_page_t * page;
+   size_t            size = 0;
+
+   // prepare
+   TEST(0 == init_mmarena(&arena));
+
+   // TEST malloc_mmarena: first allocation adds page
+   TEST(0 == malloc_mmarena(&arena, 1, &mblock));
+   page = arena.page;
+   TEST(0 != page);
+   TEST(0 == page->prev);
+   TEST(mblock.addr == (uint8_t*)page + mm_arena_page_HEADERSIZE);
+   TEST(mblock.size == KONFIG_MEMALIGN);
+   TEST(arena.next  == mblock.addr + mblock.size);
+   TEST(arena.end   == (uint8_t*)page + mm_arena_PAGESIZE);
+   TEST(KONFIG_MEMALIGN == sizeallocated_mmarena(&arena));
+   size = KONFIG_MEMALIGN;
+
+   // TEST malloc_mmarena: increments pointer
+   for (size_t i = 0; i <= 4*KONFIG_MEMALIGN; ++i) {
+      uint8_t * next = arena.next;
+      TEST(0 == malloc_mmarena(&arena, i, &mblock));
+      TEST(mblock.addr == next);
+      TEST(mblock.size == alignsize_mmarena(i));
+      TEST(mblock.size >= i && mblock.size < i + KONFIG_MEMALIGN);
+      TEST(arena.next  == next + mblock.size);
+      size += mblock.size;
+      TEST(size == sizeallocated_mmarena(&arena));
+      TEST(page == arena.page);
+   }
+
+   // TEST malloc_mmarena: full page adds page
+   TEST(0 == malloc_mmarena(&arena, (size_t)(arena.end - arena.next), &mblock));
+   TEST(arena.next == arena.end);
+   TEST(page == arena.page);
+   size += mblock.size;
+   TEST(0 == malloc_mmarena(&arena, 1, &mblock));
+   TEST(page != arena.page);
+   TEST(page == arena.page->prev);
+   TEST(mblock.addr == (uint8_t*)arena.page + mm_arena_page_HEADERSIZE);
+   size += mblock.size;
+   TEST(size == sizeallocated_mmarena(&arena));
+
+   // TEST malloc_mmarena: large block gets own page
+   page = arena.page;
+   TEST(0 == malloc_mmarena(&arena, mm_arena_PAGESIZE, &mblock));
+   TEST(mblock.size == mm_arena_PAGESIZE);
+   TEST(page == arena.page->prev);
+   TEST(2*mm_arena_PAGESIZE == arena.page->size);
+   size += mblock.size;
+   TEST(size == sizeallocated_mmarena(&arena));
+
+   // TEST mfree_mmarena: does not free memory
+   for (unsigned i = 0; i < 2; ++i) {
+      TEST(0 == mfree_mmarena(&arena, &mblock));
+      TEST(isfree_memblock(&mblock));
+      TEST(size == sizeallocated_mmarena(&arena));
+   }
+
+   // TEST mresize_mmarena: free block
+   mblock = (memblock_t) memblock_FREE;
+   TEST(0 == mresize_mmarena(&arena, 100, &mblock));
+   TEST(mblock.size == alignsize_mmarena(100));
+   size += mblock.size;
+   TEST(size == sizeallocated_mmarena(&arena));
+
+   // TEST mresize_mmarena: last block is resized in place
+   memset(mblock.addr, 3, mblock.size);
+   for (size_t newsize = 1; newsize <= 1000; newsize += 37) {
+      void * oldaddr = mblock.addr;
+      size -= mblock.size;
+      TEST(0 == mresize_mmarena(&arena, newsize, &mblock));
+      TEST(oldaddr == mblock.addr);
+      TEST(mblock.size == alignsize_mmarena(newsize));
+      TEST(arena.next  == mblock.addr + mblock.size);
+      size += mblock.size;
+      TEST(size == sizeallocated_mmarena(&arena));
+   }
+   TEST(3 == mblock.addr[0]);
+
+   // TEST mresize_mmarena: other block is copied
+   mblock2 = mblock;
+   TEST(0 == malloc_mmarena(&arena, 1, &mblock));
+   size += mblock.size;
+   memset(mblock2.addr, 4, mblock2.size);
+   {
+      void * oldaddr = mblock2.addr;
+      size_t oldsize = mblock2.size;
+      TEST(0 == mresize_mmarena(&arena, oldsize + 1, &mblock2));
+      TEST(oldaddr != mblock2.addr);
+      TEST(mblock2.size == alignsize_mmarena(oldsize + 1));
+      for (size_t i = 0; i < oldsize; ++i) {
+         TEST(4 == mblock2.addr[i]);
+      }
+      size += mblock2.size;
+      TEST(size == sizeallocated_mmarena(&arena));
+   }
+
+   // TEST mresize_mmarena: 0 size frees block
+   TEST(0 == mresize_mmarena(&arena, 0, &mblock2));
+   TEST(isfree_memblock(&mblock2));
+   TEST(size == sizeallocated_mmarena(&arena));
+
+   // TEST malloc_mmarena: ENOMEM
+   memset(&mblock, 255, sizeof(mblock));
+   TEST(ENOMEM == malloc_mmarena(&arena, (size_t)-1, &mblock));
+   TEST(isfree_memblock(&mblock));
+   TEST(ENOMEM == malloc_mmarena(&arena, ((size_t)-1)/2+1, &mblock));
+   TEST(isfree_memblock(&mblock));
+   TEST(size == sizeallocated_mmarena(&arena));
+
+   // TEST mresize_mmarena: EINVAL
+   mblock = (memblock_t) memblock_FREE;
+   mblock.addr = (void*)1;
+   TEST(EINVAL == mresize_mmarena(&arena, 10, &mblock));
+   mblock = (memblock_t) memblock_FREE;
+   mblock.size = 1;
+   TEST(EINVAL == mresize_mmarena(&arena, 10, &mblock));
+
+   // TEST mfree_mmarena: EINVAL
+   mblock = (memblock_t) memblock_FREE;
+   mblock.addr = (void*)1;
+   TEST(EINVAL == mfree_mmarena(&arena, &mblock));
+
+   // unprepare
+   TEST(0 == free_mmarena(&arena));
+
+   return 0;
+ONERR:
+   free_mmarena(&arena);
+   return EINVAL;
+}
+
+static int test_state(void)
+{
+   mm_arena_t        arena = mm_arena_FREE;
+   mm_arena_state_t  state[4];
+   memblock_t        mblock;
+   size_t            sizepgcache = SIZEALLOCATED_PAGECACHE();
+
+   // prepare
+   TEST(0 == init_mmarena(&arena));
+
+   // TEST mm_arena_state_FREE
+   state[0] = (mm_arena_state_t) mm_arena_state_FREE;
+   TEST(0 == state[0].page);
+   TEST(0 == state[0].next);
+   TEST(0 == state[0].allocated);
+
+   // TEST storestate_mmarena: empty arena
+   memset(&state[0], 255, sizeof(state[0]));
+   storestate_mmarena(&arena, &state[0]);
+   TEST(0 == state[0].page);
+   TEST(0 == state[0].next);
+   TEST(0 == state[0].allocated);
+
+   // TEST storestate_mmarena
+   for (unsigned i = 1; i < lengthof(state); ++i) {
+      TEST(0 == malloc_mmarena(&arena, i * mm_arena_PAGESIZE / 2, &mblock));
+      storestate_mmarena(&arena, &state[i]);
+      TEST(state[i].page == arena.page);
+      TEST(state[i].next == arena.next);
+      TEST(state[i].allocated == arena.allocated);
+   }
+
+   // TEST restore_mmarena: same state
+   for (unsigned i = 0; i < 2; ++i) {
+      TEST(0 == restore_mmarena(&arena, &state[3]));
+      TEST(state[3].page == arena.page);
+      TEST(state[3].next == arena.next);
+      TEST(state[3].allocated == arena.allocated);
+      TEST(0 == arena.freepage);
+   }
+
+   // TEST restore_mmarena: on same page
+   for (size_t size = 1; size < 1000; size *= 3) {
+      TEST(0 == malloc_mmarena(&arena, size, &mblock));
+      TEST(state[3].page == arena.page);
+      TEST(0 == restore_mmarena(&arena, &state[3]));
+      TEST(state[3].page == arena.page);
+      TEST(state[3].next == arena.next);
+      TEST(state[3].allocated == arena.allocated);
+   }
+
+   // TEST restore_mmarena: multiple pages (pages of size mm_arena_PAGESIZE are cached)
+   for (int i = lengthof(state)-1; i >= 0; --i) {
+      TEST(0 == restore_mmarena(&arena, &state[i]));
+      TEST(state[i].page == arena.page);
+      TEST(state[i].next == arena.next);
+      TEST(state[i].allocated == arena.allocated);
+      TEST(arena.end == (arena.page ? (uint8_t*)arena.page + arena.page->size : 0));
+   }
+   TEST(0 == arena.page);
+   TEST(0 != arena.freepage);
+   TEST(0 == arena.freepage->prev);
+   TEST(sizepgcache + mm_arena_PAGESIZE == SIZEALLOCATED_PAGECACHE());
+
+   // TEST malloc_mmarena: reuses cached page
+   mm_arena_page_t * cached = arena.freepage;
+   TEST(0 == malloc_mmarena(&arena, 1, &mblock));
+   TEST(cached == arena.page);
+   TEST(0 == arena.page->prev);
+   TEST(0 == arena.freepage);
+   TEST(sizepgcache + mm_arena_PAGESIZE == SIZEALLOCATED_PAGECACHE());
+
+   // TEST reset_mmarena
+   TEST(0 == malloc_mmarena(&arena, 3*mm_arena_PAGESIZE, &mblock));
+   TEST(0 == reset_mmarena(&arena));
+   TEST(0 == arena.page);
+   TEST(0 == arena.next);
+   TEST(0 == arena.end);
+   TEST(0 == arena.allocated);
+   TEST(cached == arena.freepage);
+   TEST(sizepgcache + mm_arena_PAGESIZE == SIZEALLOCATED_PAGECACHE());
+
+   // unprepare
+   TEST(0 == free_mmarena(&arena));
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_mmarena(&arena);
+   return EINVAL;
+}
+
+static int test_threadcontext(void)
+{
+   // static: address of arena escapes only through tcontext_maincontext
+   //         which is computed from the stack address (compiler does not see it)
+   static mm_arena_t    arena;
+   threadcontext_mm_t   oldmm = tcontext_maincontext()->mm;
+   mm_arena_state_t     state;
+   memblock_t           mblock[10];
+
+   // prepare
+   arena = (mm_arena_t) mm_arena_FREE;
+   TEST(0 == init_mmarena(&arena));
+
+   // TEST interface_mmarena: install arena as memory manager of thread
+   tcontext_maincontext()->mm = (threadcontext_mm_t) mm_INIT((struct mm_t*)&arena, interface_mmarena());
+   storestate_mmarena(&arena, &state);
+   for (unsigned i = 0; i < lengthof(mblock); ++i) {
+      TEST(0 == ALLOC_MM(16 * (i+1), &mblock[i]));
+      TEST(mblock[i].addr >= (uint8_t*)arena.page && mblock[i].addr < arena.end);
+      TEST(SIZEALLOCATED_MM() == arena.allocated);
+   }
+   for (unsigned i = 0; i < lengthof(mblock); ++i) {
+      TEST(0 == FREE_MM(&mblock[i]));
+   }
+   TEST(0 != SIZEALLOCATED_MM());
+   TEST(0 == restore_mmarena(&arena, &state));
+   TEST(0 == SIZEALLOCATED_MM());
+   tcontext_maincontext()->mm = oldmm;
+
+   // unprepare
+   TEST(0 == free_mmarena(&arena));
+
+   return 0;
+ONERR:
+   tcontext_maincontext()->mm = oldmm;
+   free_mmarena(&arena);
+   return EINVAL;
+}
+
+static int childprocess_unittest(void)
+{
+   resourceusage_t usage = resourceusage_FREE;
+
+   if (test_allocate())       goto ONERR;
+
+   TEST(0 == init_resourceusage(&usage));
+
+   if (test_arenapage())      goto ONERR;
+   if (test_initfree())       goto ONERR;
+   if (test_initthread())     goto ONERR;
+   if (test_query())          goto ONERR;
+   if (test_allocate())       goto ONERR;
+   if (test_state())          goto ONERR;
+   if (test_threadcontext())  goto ONERR;
+
+   TEST(0 == same_resourceusage(&usage));
+   TEST(0 == free_resourceusage(&usage));
+
+   return 0;
+ONERR:
+   (void) free_resourceusage(&usage);
+   return EINVAL;
+}
+
+int unittest_memory_mm_mmarena()
+{
+   int err;
+
+   TEST(0 == execasprocess_unittest(&childprocess_unittest, &err));
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+#endif
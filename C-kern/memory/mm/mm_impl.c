@@ -18,14 +18,182 @@
 #include "C-kern/konfig.h"
 #include "C-kern/api/memory/mm/mm_impl.h"
 #include "C-kern/api/err.h"
+#include "C-kern/api/ds/foreach.h"
+#include "C-kern/api/ds/inmem/dlist.h"
+#include "C-kern/api/math/int/log2.h"
+#include "C-kern/api/memory/atomic.h"
 #include "C-kern/api/memory/mm/mm.h"
 #include "C-kern/api/memory/mm/mm_macros.h"
 #include "C-kern/api/memory/memblock.h"
-#include "C-kern/api/platform/malloc.h"
+#include "C-kern/api/memory/pagecache_macros.h"
+#include "C-kern/api/memory/vm.h"
+#include "C-kern/api/platform/task/thread.h"
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/resourceusage.h"
 #include "C-kern/api/test/unittest.h"
 #endif
+#ifdef KONFIG_PERFTEST
+#include "C-kern/api/test/perftest.h"
+#endif
+
+
+// section: mm_impl_object_t
+
+/* struct: mm_impl_object_t
+ * Header of a free small object.
+ * Used to link free objects of a slab or objects and blocks on the remote lists of <mm_impl_t>. */
+typedef struct mm_impl_object_t {
+   struct mm_impl_object_t *next;
+} mm_impl_object_t;
+
+// group: config
+
+/* define: mm_impl_REMOTECLOSED
+ * Value of <mm_impl_t.remotelist> and <mm_impl_t.remoteblocklist> after <free_mmimpl>.
+ * A thread which finds this value does not push and frees the orphaned memory itself. */
+#define mm_impl_REMOTECLOSED ((mm_impl_object_t*)1)
+
+
+// section: mm_impl_slab_t
+
+/* struct: mm_impl_slab_t
+ * Header of a slab located at the start of a page of size <mm_impl_SLABSIZE>.
+ * The slab stores objects of a single size class. Objects start at offset <mm_impl_SLABHEADERSIZE>.
+ * The page is aligned to its own size so the slab of an object is computed by masking its address. */
+typedef struct mm_impl_slab_t {
+   /* variable: owner
+    * The <mm_impl_t> which allocated the slab.
+    * The value 0 marks an orphaned slab. See <free_mmimpl>. */
+   mm_impl_t        *owner;
+   /* variable: slabnode
+    * Links slab into <mm_impl_state_t.slablist>. */
+   dlist_node_t      slabnode;
+   /* variable: freelist
+    * List of freed objects. */
+   mm_impl_object_t *freelist;
+   /* variable: nextfree
+    * Next never used object. Valid if <nrnextfree> > 0. */
+   uint8_t          *nextfree;
+   /* variable: nrnextfree
+    * Number of never used objects starting at <nextfree>. */
+   uint16_t          nrnextfree;
+   /* variable: nrused
+    * Number of allocated objects. Decremented atomically if the slab is orphaned. */
+   uint16_t          nrused;
+   /* variable: nrobjects
+    * Number of objects which fit into the slab. */
+   uint16_t          nrobjects;
+   /* variable: sizeclass
+    * Index of the size class. See <s_mmimpl_classsize>. */
+   uint8_t           sizeclass;
+} mm_impl_slab_t;
+
+// group: config
+
+/* define: mm_impl_SLABHEADERSIZE
+ * Offset of the first object of a slab. */
+#define mm_impl_SLABHEADERSIZE 64
+
+// group: helper
+
+/* define: INTERFACE_slablist
+ * Macro <dlist_IMPLEMENT> generates dlist interface for <mm_impl_slab_t>. */
+dlist_IMPLEMENT(_slablist, mm_impl_slab_t, slabnode.)
+
+
+// section: mm_impl_block_t
+
+/* struct: mm_impl_block_t
+ * Header of a medium or huge memory block located at the start of its page or mapping.
+ * The memory returned to the caller starts at offset <mm_impl_BLOCKHEADERSIZE>. */
+typedef struct mm_impl_block_t {
+   /* variable: remote
+    * Links block into <mm_impl_t.remoteblocklist>. Must be the first field. */
+   mm_impl_object_t  remote;
+   /* variable: owner
+    * The <mm_impl_t> which allocated the block.
+    * The value 0 marks an orphaned block. See <free_mmimpl>. */
+   mm_impl_t        *owner;
+   /* variable: blocknode
+    * Links block into <mm_impl_state_t.blocklist>. */
+   dlist_node_t      blocknode;
+   /* variable: size
+    * Size in bytes of the page or mapping (header included). */
+   size_t            size;
+} mm_impl_block_t;
+
+// group: helper
+
+/* define: INTERFACE_blocklist
+ * Macro <dlist_IMPLEMENT> generates dlist interface for <mm_impl_block_t>. */
+dlist_IMPLEMENT(_blocklist, mm_impl_block_t, blocknode.)
+
+
+// section: mm_impl_state_t
+
+/* struct: mm_impl_state_t
+ * Lists of slabs and blocks and allocation counters of a single <mm_impl_t>.
+ * The state is allocated as a single page from the <pagecache_t> during the first allocation.
+ * This keeps <mm_impl_t> small which is stored in the static memory of every thread.
+ * Every state is linked into <s_mmimpl_statlist> so <collectstat_mmimpl> could read its counters. */
+typedef struct mm_impl_state_t {
+   /* variable: slablist
+    * One list of slabs for every size class. Slabs which contain free objects are stored
+    * at the beginning of the list, slabs whose objects are all used at the end. */
+   struct {
+      dlist_node_t *last;
+   }        slablist[mm_impl_NRSIZECLASS];
+   /* variable: blocklist
+    * List of all medium and huge blocks in use. <free_mmimpl> marks them as orphaned. */
+   struct {
+      dlist_node_t *last;
+   }        blocklist;
+   /* variable: statnode
+    * Links state into <s_mmimpl_statlist>. */
+   dlist_node_t   statnode;
+   /* variable: stat
+    * Allocation counters. Only the owner of <mm_impl_t> writes them.
+    * The values of <mm_impl_stat_t.sizeclass>.nrcached are not maintained. */
+   mm_impl_stat_t stat;
+} mm_impl_state_t;
+
+// group: config
+
+/* define: mm_impl_STATEPGSIZE
+ * Value of <pagesize_e> of the page which stores <mm_impl_state_t>. */
+#define mm_impl_STATEPGSIZE pagesize_2048
+
+// group: static variables
+
+/* variable: s_mmimpl_statlist
+ * List of the <mm_impl_state_t> of all <mm_impl_t> which have allocated memory.
+ * Protected by <s_mmimpl_statlock>. */
+static struct {
+   dlist_node_t *last;
+}                    s_mmimpl_statlist = { 0 };
+
+/* variable: s_mmimpl_statlock
+ * Used as lock. Protects <s_mmimpl_statlist> and the write access to <mm_impl_t.state>.
+ * A state could not be released while another thread reads its counters. */
+static atomicflag_t  s_mmimpl_statlock = 0;
+
+// group: helper
+
+/* define: INTERFACE_statlist
+ * Macro <dlist_IMPLEMENT> generates dlist interface for <mm_impl_state_t>. */
+dlist_IMPLEMENT(_statlist, mm_impl_state_t, statnode.)
+
+static inline void lockstat_mmimpl(void)
+{
+   while (0 != set_atomicflag(&s_mmimpl_statlock)) {
+      yield_thread();
+   }
+}
+
+static inline void unlockstat_mmimpl(void)
+{
+   clear_atomicflag(&s_mmimpl_statlock);
+}
 
 
 // section: mm_impl_t
@@ -47,6 +215,370 @@ static mm_impl_it    s_mmimpl_interface = mm_it_INIT(
                            &sizeallocated_mmimpl
                         ) ;
 
+/* variable: s_mmimpl_classsize
+ * The size in bytes of every size class.
+ * Classes up to 128 bytes grow in steps of 16 bytes.
+ * Every following power of two range is divided into 4 classes. */
+static const uint16_t s_mmimpl_classsize[mm_impl_NRSIZECLASS] = {
+   16,   32,   48,   64,   80,   96,   112,  128,
+   160,  192,  224,  256,  320,  384,  448,  512,
+   640,  768,  896,  1024, 1280, 1536, 1792, 2048
+};
+
+// group: helper
+
+/* function: sizeclass_mmimpl
+ * Returns the index of the size class of size.
+ *
+ * Unchecked Precondition:
+ * - 0 < size && size <= mm_impl_MAXSMALLSIZE */
+static inline unsigned sizeclass_mmimpl(size_t size)
+{
+   if (size <= 128) {
+      return (unsigned) ((size+15) / 16) - 1;
+   }
+   unsigned lg2 = log2_int(size-1);
+   return 8 + 4*(lg2-7) + (unsigned) ((size-1) >> (lg2-2)) - 4;
+}
+
+/* function: pagesize_mmimpl
+ * Returns the <pagesize_e> of a page which stores size bytes.
+ *
+ * Unchecked Precondition:
+ * - mm_impl_MAXSMALLSIZE < size && size <= mm_impl_MAXMEDIUMSIZE */
+static inline pagesize_e pagesize_mmimpl(size_t size)
+{
+   static_assert(256 == (1 << (pagesize_256+8)), "pagesize_e is log2 of size minus 8");
+   return (pagesize_e) (log2_int(size-1) + 1 - 8);
+}
+
+/* function: blocksize_mmimpl
+ * Returns the size of the page or mapping which stores a medium or huge block of size bytes.
+ * The size of the header <mm_impl_block_t> is included.
+ *
+ * Unchecked Precondition:
+ * - mm_impl_MAXSMALLSIZE < size && size <= SSIZE_MAX */
+static inline size_t blocksize_mmimpl(size_t size)
+{
+   if (size <= mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE) {
+      return pagesizeinbytes_pagecache(pagesize_mmimpl(size + mm_impl_BLOCKHEADERSIZE));
+   }
+   return (size + mm_impl_BLOCKHEADERSIZE + pagesize_vm()-1) & ~(pagesize_vm()-1);
+}
+
+static inline mm_impl_slab_t* slab_mmimpl(void* addr)
+{
+   return (mm_impl_slab_t*) ((uintptr_t)addr & ~(uintptr_t)(mm_impl_SLABSIZE-1));
+}
+
+static inline mm_impl_block_t* block_mmimpl(void* addr)
+{
+   return (mm_impl_block_t*) ((uint8_t*)addr - mm_impl_BLOCKHEADERSIZE);
+}
+
+// group: state
+
+/* function: newstate_mmimpl
+ * Allocates <mm_impl_t.state> from the <pagecache_t> and inserts it into <s_mmimpl_statlist>. */
+static int newstate_mmimpl(mm_impl_t * mman)
+{
+   int err;
+   memblock_t page;
+
+   static_assert(sizeof(mm_impl_state_t) <= 2048, "state fits into page of size mm_impl_STATEPGSIZE");
+
+   err = ALLOC_PAGECACHE(mm_impl_STATEPGSIZE, &page);
+   if (err) return err;
+
+   mm_impl_state_t * state = (mm_impl_state_t*) page.addr;
+   *state = (mm_impl_state_t) { { { 0 } }, { 0 }, { 0, 0 }, mm_impl_stat_FREE };
+
+   lockstat_mmimpl();
+   insertlast_statlist(cast_dlist(&s_mmimpl_statlist), state);
+   mman->state = state;
+   unlockstat_mmimpl();
+
+   return 0;
+}
+
+/* function: deletestate_mmimpl
+ * Removes <mm_impl_t.state> from <s_mmimpl_statlist> and releases it. */
+static int deletestate_mmimpl(mm_impl_t * mman)
+{
+   mm_impl_state_t * state = mman->state;
+
+   if (state) {
+      lockstat_mmimpl();
+      remove_statlist(cast_dlist(&s_mmimpl_statlist), state);
+      mman->state = 0;
+      unlockstat_mmimpl();
+      memblock_t page = memblock_INIT(pagesizeinbytes_pagecache(mm_impl_STATEPGSIZE), (uint8_t*)state);
+      return RELEASE_PAGECACHE(&page);
+   }
+
+   return 0;
+}
+
+// group: slab
+
+/* function: newslab_mmimpl
+ * Allocates a new slab for size class sizeclass and inserts it as first into the slablist. */
+static int newslab_mmimpl(mm_impl_t * mman, unsigned sizeclass, /*out*/mm_impl_slab_t ** slab)
+{
+   int err;
+   memblock_t page;
+
+   static_assert(mm_impl_SLABSIZE == 65536, "size of pagesize_65536");
+   static_assert(sizeof(mm_impl_slab_t) <= mm_impl_SLABHEADERSIZE, "header fits");
+
+   err = ALLOC_PAGECACHE(pagesize_65536, &page);
+   if (err) return err;
+
+   mm_impl_slab_t * newslab = (mm_impl_slab_t*) page.addr;
+   unsigned nrobjects = (mm_impl_SLABSIZE-mm_impl_SLABHEADERSIZE) / s_mmimpl_classsize[sizeclass];
+   newslab->owner = mman;
+   newslab->freelist = 0;
+   newslab->nextfree = page.addr + mm_impl_SLABHEADERSIZE;
+   newslab->nrnextfree = (uint16_t) nrobjects;
+   newslab->nrused = 0;
+   newslab->nrobjects = (uint16_t) nrobjects;
+   newslab->sizeclass = (uint8_t) sizeclass;
+   ++ mman->state->stat.sizeclass[sizeclass].nrslaballoc;
+   insertfirst_slablist(cast_dlist(&mman->state->slablist[sizeclass]), newslab);
+
+   // set out
+   *slab = newslab;
+
+   return 0;
+}
+
+/* function: deleteslab_mmimpl
+ * Removes slab from slablist and releases its page. */
+static int deleteslab_mmimpl(mm_impl_t * mman, mm_impl_slab_t * slab)
+{
+   remove_slablist(cast_dlist(&mman->state->slablist[slab->sizeclass]), slab);
+   ++ mman->state->stat.sizeclass[slab->sizeclass].nrslabfree;
+   slab->owner = 0;
+   memblock_t page = memblock_INIT(mm_impl_SLABSIZE, (uint8_t*)slab);
+   return RELEASE_PAGECACHE(&page);
+}
+
+/* function: allocobject_mmimpl
+ * Allocates an object of size class sizeclass.
+ * Full slabs are moved to the end of the slablist. */
+static inline int allocobject_mmimpl(mm_impl_t * mman, unsigned sizeclass, /*out*/void ** object)
+{
+   int err;
+   mm_impl_slab_t * slab = first_slablist(cast_dlist(&mman->state->slablist[sizeclass]));
+   void           * obj;
+
+   if (!slab || slab->nrused == slab->nrobjects) {
+      err = newslab_mmimpl(mman, sizeclass, &slab);
+      if (err) return err;
+   }
+
+   if (slab->freelist) {
+      obj = slab->freelist;
+      slab->freelist = slab->freelist->next;
+   } else {
+      obj = slab->nextfree;
+      slab->nextfree += s_mmimpl_classsize[sizeclass];
+      -- slab->nrnextfree;
+   }
+
+   if (++ slab->nrused == slab->nrobjects) {
+      dlist_t * slablist = cast_dlist(&mman->state->slablist[sizeclass]);
+      if (slab != last_slablist(slablist)) {
+         remove_slablist(slablist, slab);
+         insertlast_slablist(slablist, slab);
+      }
+   }
+
+   *object = obj;
+   return 0;
+}
+
+/* function: freeobject_mmimpl
+ * Frees object located on slab. A full slab is moved to the start of the slablist.
+ * An unused slab is released.
+ *
+ * Unchecked Precondition:
+ * - slab->owner == mman */
+static inline int freeobject_mmimpl(mm_impl_t * mman, mm_impl_slab_t * slab, void * object)
+{
+   mm_impl_object_t * freeobj = object;
+
+   if (slab->nrused == slab->nrobjects) {
+      dlist_t * slablist = cast_dlist(&mman->state->slablist[slab->sizeclass]);
+      if (slab != first_slablist(slablist)) {
+         remove_slablist(slablist, slab);
+         insertfirst_slablist(slablist, slab);
+      }
+   }
+
+   freeobj->next = slab->freelist;
+   slab->freelist = freeobj;
+   ++ mman->state->stat.sizeclass[slab->sizeclass].nrfree;
+   -- mman->state->stat.sizeclass[slab->sizeclass].nrused;
+
+   if (0 == -- slab->nrused) {
+      return deleteslab_mmimpl(mman, slab);
+   }
+
+   return 0;
+}
+
+/* function: freeorphan_mmimpl
+ * Frees an object located on an orphaned slab.
+ * The slab is not contained in any list so only <mm_impl_slab_t.nrused> is decremented.
+ * The last freed object releases the slab.
+ *
+ * Unchecked Precondition:
+ * - slab->owner == 0 */
+static int freeorphan_mmimpl(mm_impl_slab_t * slab)
+{
+   if (1 == sub_atomicint(&slab->nrused, (uint16_t)1)) {
+      memblock_t page = memblock_INIT(mm_impl_SLABSIZE, (uint8_t*)slab);
+      return RELEASE_PAGECACHE(&page);
+   }
+
+   return 0;
+}
+
+// group: block
+
+/* function: releaseblock_mmimpl
+ * Returns the page of a medium block to the <pagecache_t> or unmaps the memory of a huge block. */
+static int releaseblock_mmimpl(mm_impl_block_t * block)
+{
+   if (block->size <= mm_impl_MAXMEDIUMSIZE) {
+      memblock_t page = memblock_INIT(block->size, (uint8_t*)block);
+      return RELEASE_PAGECACHE(&page);
+   }
+
+   vmpage_t vmpage = vmpage_INIT(block->size, (uint8_t*)block);
+   return free_vmpage(&vmpage);
+}
+
+/* function: freeblock_mmimpl
+ * Removes block from the list of blocks in use and releases it.
+ *
+ * Unchecked Precondition:
+ * - block->owner == mman */
+static int freeblock_mmimpl(mm_impl_t * mman, mm_impl_block_t * block)
+{
+   remove_blocklist(cast_dlist(&mman->state->blocklist), block);
+   mman->size_allocated -= block->size - mm_impl_BLOCKHEADERSIZE;
+   if (block->size <= mm_impl_MAXMEDIUMSIZE) {
+      ++ mman->state->stat.medium.nrfree;
+      -- mman->state->stat.medium.nrused;
+   } else {
+      ++ mman->state->stat.huge.nrfree;
+      -- mman->state->stat.huge.nrused;
+   }
+   return releaseblock_mmimpl(block);
+}
+
+// group: remote
+
+/* function: pushremote_mmimpl
+ * Pushes object onto the lock-free stack remotelist (<mm_impl_t.remotelist> or <mm_impl_t.remoteblocklist>).
+ * Draining removes always all objects at once therefore no ABA problem exists.
+ * The value false is returned if the owner has closed the list with <mm_impl_REMOTECLOSED>.
+ * In this case the slab or block of object has been orphaned. */
+static inline bool pushremote_mmimpl(mm_impl_object_t * volatile * remotelist, mm_impl_object_t * object)
+{
+   mm_impl_object_t * first = *remotelist;
+   for (;;) {
+      if (first == mm_impl_REMOTECLOSED) return false;
+      object->next = first;
+      mm_impl_object_t * old = cmpxchg_atomicint(remotelist, first, object);
+      if (old == first) return true;
+      first = old;
+   }
+}
+
+/* function: takeremote_mmimpl
+ * Removes all objects from remotelist and sets it to newvalue (0 or <mm_impl_REMOTECLOSED>).
+ * The removed objects are returned. A closed list is returned as empty list. */
+static inline mm_impl_object_t * takeremote_mmimpl(mm_impl_object_t * volatile * remotelist, mm_impl_object_t * newvalue)
+{
+   mm_impl_object_t * first = *remotelist;
+   for (;;) {
+      mm_impl_object_t * old = cmpxchg_atomicint(remotelist, first, newvalue);
+      if (old == first) break;
+      first = old;
+   }
+   return first == mm_impl_REMOTECLOSED ? 0 : first;
+}
+
+/* function: freeremote_mmimpl
+ * Frees the small objects object->next->...->next taken from <mm_impl_t.remotelist>.
+ * Objects of orphaned slabs are freed with <freeorphan_mmimpl>. */
+static int freeremote_mmimpl(mm_impl_t * mman, mm_impl_object_t * object)
+{
+   int err = 0;
+
+   while (object) {
+      int err2;
+      mm_impl_object_t * next  = object->next;
+      mm_impl_slab_t   * slab  = slab_mmimpl(object);
+      if (slab->owner == mman) {
+         mman->size_allocated -= s_mmimpl_classsize[slab->sizeclass];
+         ++ mman->state->stat.nrremote;
+         err2 = freeobject_mmimpl(mman, slab, object);
+      } else {
+         err2 = freeorphan_mmimpl(slab);
+      }
+      if (err2) err = err2;
+      object = next;
+   }
+
+   return err;
+}
+
+/* function: freeremoteblock_mmimpl
+ * Frees the medium and huge blocks object->next->...->next taken from <mm_impl_t.remoteblocklist>.
+ * Orphaned blocks are released without changing any counter. */
+static int freeremoteblock_mmimpl(mm_impl_t * mman, mm_impl_object_t * object)
+{
+   int err = 0;
+
+   while (object) {
+      int err2;
+      mm_impl_object_t * next  = object->next;
+      mm_impl_block_t  * block = (mm_impl_block_t*) object;
+      if (block->owner == mman) {
+         ++ mman->state->stat.nrremote;
+         err2 = freeblock_mmimpl(mman, block);
+      } else {
+         err2 = releaseblock_mmimpl(block);
+      }
+      if (err2) err = err2;
+      object = next;
+   }
+
+   return err;
+}
+
+/* function: drainremote_mmimpl
+ * Frees all objects and blocks other threads pushed onto <mm_impl_t.remotelist> and <mm_impl_t.remoteblocklist>.
+ * A list closed by <free_mmimpl> is opened again. */
+static int drainremote_mmimpl(mm_impl_t * mman)
+{
+   int err;
+
+   err = freeremote_mmimpl(mman, takeremote_mmimpl(&mman->remotelist, 0));
+   int err2 = freeremoteblock_mmimpl(mman, takeremote_mmimpl(&mman->remoteblocklist, 0));
+   if (err2) err = err2;
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
 // group: initthread
 
 mm_it * interface_mmimpl(void)
@@ -58,112 +590,610 @@ mm_it * interface_mmimpl(void)
 
 int init_mmimpl(/*out*/mm_impl_t * mman)
 {
-   mman->size_allocated = 0;
+   *mman = (mm_impl_t) mmimpl_FREE;
    return 0;
 }
 
 int free_mmimpl(mm_impl_t * mman)
 {
-   mman->size_allocated = 0 ;
-   return 0 ;
+   int err = 0;
+   int err2;
+
+   if (mman->remotelist || mman->remoteblocklist) {
+      err = drainremote_mmimpl(mman);
+   }
+
+   mm_impl_state_t * state = mman->state;
+   if (state) {
+      // slabs and blocks which are still in use become orphaned
+      for (unsigned i = 0; i < lengthof(state->slablist); ++i) {
+         dlist_t * slablist = cast_dlist(&state->slablist[i]);
+         while (!isempty_slablist(slablist)) {
+            mm_impl_slab_t * slab = removefirst_slablist(slablist);
+            storerelease_atomicint(&slab->owner, (mm_impl_t*)0);
+         }
+      }
+      dlist_t * blocklist = cast_dlist(&state->blocklist);
+      while (!isempty_blocklist(blocklist)) {
+         mm_impl_block_t * block = removefirst_blocklist(blocklist);
+         storerelease_atomicint(&block->owner, (mm_impl_t*)0);
+      }
+   }
+
+   // objects pushed after draining are located on orphaned slabs or blocks
+   err2 = freeremote_mmimpl(mman, takeremote_mmimpl(&mman->remotelist, mm_impl_REMOTECLOSED));
+   if (err2) err = err2;
+   err2 = freeremoteblock_mmimpl(mman, takeremote_mmimpl(&mman->remoteblocklist, mm_impl_REMOTECLOSED));
+   if (err2) err = err2;
+
+   err2 = deletestate_mmimpl(mman);
+   if (err2) err = err2;
+
+   mman->size_allocated = 0;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
 }
 
 // group: query
 
 size_t sizeallocated_mmimpl(mm_impl_t * mman)
 {
-   // TODO: implement without allocatedsize_malloc (remove malloc module from subsys/context-mini !)
    return mman->size_allocated ;
 }
 
+// group: statistics
+
+/* function: addcounters_mmimpl
+ * Adds the counters of state to stat.
+ * The counters are written by another thread therefore they are read atomically.
+ * Peak values are not added but the larger value is kept.
+ *
+ * Unchecked Precondition:
+ * - <s_mmimpl_statlock> is locked */
+static void addcounters_mmimpl(const mm_impl_state_t * state, /*inout*/mm_impl_stat_t * stat)
+{
+   const mm_impl_stat_t * counter = &state->stat;
+   size_t peak;
+
+   for (unsigned i = 0; i < mm_impl_NRSIZECLASS; ++i) {
+      size_t nrused      = loadacquire_atomicint(&counter->sizeclass[i].nrused);
+      size_t nrslaballoc = loadacquire_atomicint(&counter->sizeclass[i].nrslaballoc);
+      size_t nrslabfree  = loadacquire_atomicint(&counter->sizeclass[i].nrslabfree);
+      // every slab in use stores the same number of objects
+      size_t nrobjects   = (nrslaballoc - nrslabfree) * ((mm_impl_SLABSIZE-mm_impl_SLABHEADERSIZE) / s_mmimpl_classsize[i]);
+      stat->sizeclass[i].nralloc     += loadacquire_atomicint(&counter->sizeclass[i].nralloc);
+      stat->sizeclass[i].nrfree      += loadacquire_atomicint(&counter->sizeclass[i].nrfree);
+      stat->sizeclass[i].nrused      += nrused;
+      peak = loadacquire_atomicint(&counter->sizeclass[i].peakused);
+      if (peak > stat->sizeclass[i].peakused) stat->sizeclass[i].peakused = peak;
+      // counters are read one after the other (owner could change them in between)
+      stat->sizeclass[i].nrcached    += nrobjects > nrused ? nrobjects - nrused : 0;
+      stat->sizeclass[i].nrslaballoc += nrslaballoc;
+      stat->sizeclass[i].nrslabfree  += nrslabfree;
+   }
+
+   stat->medium.nralloc  += loadacquire_atomicint(&counter->medium.nralloc);
+   stat->medium.nrfree   += loadacquire_atomicint(&counter->medium.nrfree);
+   stat->medium.nrused   += loadacquire_atomicint(&counter->medium.nrused);
+   peak = loadacquire_atomicint(&counter->medium.peakused);
+   if (peak > stat->medium.peakused) stat->medium.peakused = peak;
+   stat->huge.nralloc    += loadacquire_atomicint(&counter->huge.nralloc);
+   stat->huge.nrfree     += loadacquire_atomicint(&counter->huge.nrfree);
+   stat->huge.nrused     += loadacquire_atomicint(&counter->huge.nrused);
+   peak = loadacquire_atomicint(&counter->huge.peakused);
+   if (peak > stat->huge.peakused) stat->huge.peakused = peak;
+   stat->nrremote        += loadacquire_atomicint(&counter->nrremote);
+}
+
+void addstat_mmimpl(mm_impl_t * mman, /*inout*/mm_impl_stat_t * stat)
+{
+   lockstat_mmimpl();
+   // the owner changes state only if it holds the lock
+   const mm_impl_state_t * state = mman->state;
+   if (state) {
+      addcounters_mmimpl(state, stat);
+   }
+   unlockstat_mmimpl();
+}
+
+void collectstat_mmimpl(/*inout*/mm_impl_stat_t * stat)
+{
+   lockstat_mmimpl();
+   foreach (_statlist, state, cast_dlist(&s_mmimpl_statlist)) {
+      addcounters_mmimpl(state, stat);
+   }
+   unlockstat_mmimpl();
+}
+
+void logstat_mmimpl(const mm_impl_stat_t * stat, uint8_t logchannel)
+{
+   PRINTF_LOG(, logchannel, log_flags_NONE, 0, "mm: medium alloc=%zu free=%zu used=%zu peak=%zu\n",
+               stat->medium.nralloc, stat->medium.nrfree, stat->medium.nrused, stat->medium.peakused);
+   PRINTF_LOG(, logchannel, log_flags_NONE, 0, "mm: huge alloc=%zu free=%zu used=%zu peak=%zu\n",
+               stat->huge.nralloc, stat->huge.nrfree, stat->huge.nrused, stat->huge.peakused);
+   PRINTF_LOG(, logchannel, log_flags_NONE, 0, "mm: remote=%zu\n", stat->nrremote);
+
+   for (unsigned i = 0; i < mm_impl_NRSIZECLASS; ++i) {
+      if (stat->sizeclass[i].nralloc || stat->sizeclass[i].nrcached) {
+         PRINTF_LOG(, logchannel, log_flags_NONE, 0, "sizeclass %u: alloc=%zu free=%zu used=%zu peak=%zu cached=%zu slaballoc=%zu slabfree=%zu\n",
+                     (unsigned) s_mmimpl_classsize[i],
+                     stat->sizeclass[i].nralloc, stat->sizeclass[i].nrfree,
+                     stat->sizeclass[i].nrused, stat->sizeclass[i].peakused,
+                     stat->sizeclass[i].nrcached,
+                     stat->sizeclass[i].nrslaballoc, stat->sizeclass[i].nrslabfree);
+      }
+   }
+}
+
 // group: allocate
 
 int malloc_mmimpl(mm_impl_t * mman, size_t size, /*eout*/struct memblock_t* memblock)
 {
-   (void) mman ;
-   int err ;
-   void * addr ;
+   int err;
 
-   // TODO: implement malloc_mmimpl without malloc
+   if (mman->remotelist || mman->remoteblocklist) {
+      // error already logged (and allocation does not depend on it)
+      (void) drainremote_mmimpl(mman);
+   }
 
-   if (  (ssize_t)size < 0
-      || !(addr = malloc(size))) {
-      err = ENOMEM ;
-      TRACEOUTOFMEM_ERRLOG(size, err) ;
-      goto ONERR;
+   if (!mman->state) {
+      err = newstate_mmimpl(mman);
+      if (err) goto ONERR;
    }
 
-   memblock->addr = addr ;
-   memblock->size = sizeusable_malloc(addr) ;
+   if (size <= mm_impl_MAXSMALLSIZE) {
+      unsigned sizeclass = sizeclass_mmimpl(size ? size : 1);
+      void   * object;
+      err = allocobject_mmimpl(mman, sizeclass, &object);
+      if (err) goto ONERR;
+      *memblock = (memblock_t) memblock_INIT(s_mmimpl_classsize[sizeclass], object);
+      ++ mman->state->stat.sizeclass[sizeclass].nralloc;
+      if (++ mman->state->stat.sizeclass[sizeclass].nrused > mman->state->stat.sizeclass[sizeclass].peakused) {
+         mman->state->stat.sizeclass[sizeclass].peakused = mman->state->stat.sizeclass[sizeclass].nrused;
+      }
+
+   } else {
+      mm_impl_block_t * block;
+
+      if (size <= mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE) {
+         memblock_t page;
+         err = ALLOC_PAGECACHE(pagesize_mmimpl(size + mm_impl_BLOCKHEADERSIZE), &page);
+         if (err) goto ONERR;
+         block = (mm_impl_block_t*) page.addr;
+         block->size = page.size;
+         ++ mman->state->stat.medium.nralloc;
+         if (++ mman->state->stat.medium.nrused > mman->state->stat.medium.peakused) {
+            mman->state->stat.medium.peakused = mman->state->stat.medium.nrused;
+         }
+
+      } else {
+         vmpage_t vmpage;
+         if ((ssize_t)size < 0) {
+            err = ENOMEM;
+            TRACEOUTOFMEM_ERRLOG(size, err);
+            goto ONERR;
+         }
+         err = init_vmpage(&vmpage, size + mm_impl_BLOCKHEADERSIZE);
+         if (err) goto ONERR;
+         block = (mm_impl_block_t*) vmpage.addr;
+         block->size = vmpage.size;
+         ++ mman->state->stat.huge.nralloc;
+         if (++ mman->state->stat.huge.nrused > mman->state->stat.huge.peakused) {
+            mman->state->stat.huge.peakused = mman->state->stat.huge.nrused;
+         }
+      }
+
+      block->owner = mman;
+      insertlast_blocklist(cast_dlist(&mman->state->blocklist), block);
+      *memblock = (memblock_t) memblock_INIT(block->size - mm_impl_BLOCKHEADERSIZE, (uint8_t*)block + mm_impl_BLOCKHEADERSIZE);
+   }
 
-   mman->size_allocated += memblock->size ;
+   mman->size_allocated += memblock->size;
 
-   return 0 ;
+   return 0;
 ONERR:
    *memblock = (memblock_t) memblock_FREE;
    TRACEEXIT_ERRLOG(err);
-   return err ;
+   return err;
 }
 
 int mresize_mmimpl(mm_impl_t * mman, size_t newsize, struct memblock_t * memblock)
 {
-   (void) mman ;
-   int err ;
-   void * addr ;
-
-   // TODO: implement mresize_mmimpl without realloc
+   int err;
 
    if (0 == newsize) {
-      return mfree_mmimpl(mman, memblock) ;
+      return mfree_mmimpl(mman, memblock);
    }
 
-   VALIDATE_INPARAM_TEST(isfree_memblock(memblock) || isvalid_memblock(memblock), ONERR, ) ;
-
-   mman->size_allocated -= sizeusable_malloc(memblock->addr) ;
+   VALIDATE_INPARAM_TEST(isfree_memblock(memblock) || isvalid_memblock(memblock), ONERR, );
 
-   if (  (ssize_t)newsize < 0
-      || !(addr = realloc(memblock->addr, newsize))) {
-      mman->size_allocated += sizeusable_malloc(memblock->addr) ;
-      err = ENOMEM ;
-      TRACEOUTOFMEM_ERRLOG(newsize, err) ;
-      goto ONERR;
+   if (isfree_memblock(memblock)) {
+      return malloc_mmimpl(mman, newsize, memblock);
    }
 
-   memblock->addr = addr ;
-   memblock->size = sizeusable_malloc(addr) ;
+   const size_t oldsize = memblock->size;
+
+   if (oldsize <= mm_impl_MAXSMALLSIZE) {
+      if (  newsize <= mm_impl_MAXSMALLSIZE
+            && sizeclass_mmimpl(newsize) == sizeclass_mmimpl(oldsize)) {
+         // same size class
+         memblock->size = s_mmimpl_classsize[sizeclass_mmimpl(oldsize)];
+         return 0;
+      }
+
+   } else if (oldsize <= mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE) {
+      if (  mm_impl_MAXSMALLSIZE < newsize && newsize <= mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE
+            && blocksize_mmimpl(newsize) == blocksize_mmimpl(oldsize)) {
+         // same page size
+         memblock->size = blocksize_mmimpl(oldsize) - mm_impl_BLOCKHEADERSIZE;
+         return 0;
+      }
+
+   } else if (  newsize > mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE
+                && block_mmimpl(memblock->addr)->owner == mman) {
+      // huge to huge: grow or shrink mapping without copying data if possible
+      if ((ssize_t)newsize < 0) {
+         err = ENOMEM;
+         TRACEOUTOFMEM_ERRLOG(newsize, err);
+         goto ONERR;
+      }
+      mm_impl_block_t * block    = block_mmimpl(memblock->addr);
+      const size_t      oldblock = block->size;
+      vmpage_t          vmpage   = vmpage_INIT(oldblock, (uint8_t*)block);
+      // mapping could be moved (blocknode is part of mapping)
+      remove_blocklist(cast_dlist(&mman->state->blocklist), block);
+      if (newsize + mm_impl_BLOCKHEADERSIZE > vmpage.size) {
+         err = movexpand_vmpage(&vmpage, newsize + mm_impl_BLOCKHEADERSIZE);
+      } else {
+         err = shrink_vmpage(&vmpage, newsize + mm_impl_BLOCKHEADERSIZE);
+      }
+      block = (mm_impl_block_t*) vmpage.addr;
+      insertlast_blocklist(cast_dlist(&mman->state->blocklist), block);
+      if (err) goto ONERR;
+      block->size = vmpage.size;
+      mman->size_allocated -= oldblock;
+      mman->size_allocated += vmpage.size;
+      *memblock = (memblock_t) memblock_INIT(vmpage.size - mm_impl_BLOCKHEADERSIZE, vmpage.addr + mm_impl_BLOCKHEADERSIZE);
+      return 0;
+   }
 
-   mman->size_allocated += memblock->size ;
+   // move content into block of other size class
+   memblock_t newblock;
+   err = malloc_mmimpl(mman, newsize, &newblock);
+   if (err) goto ONERR;
+   memcpy(newblock.addr, memblock->addr, oldsize < newsize ? oldsize : newsize);
+   err = mfree_mmimpl(mman, memblock);
+   if (err) {
+      (void) mfree_mmimpl(mman, &newblock);
+      goto ONERR;
+   }
+   *memblock = newblock;
 
-   return 0 ;
+   return 0;
 ONERR:
    TRACEEXIT_ERRLOG(err);
-   return err ;
+   return err;
 }
 
 int mfree_mmimpl(mm_impl_t * mman, struct memblock_t * memblock)
 {
-   int err ;
-   (void) mman ;
+   int err;
 
    if (memblock->addr) {
 
-      VALIDATE_INPARAM_TEST(isvalid_memblock(memblock), ONERR, ) ;
+      VALIDATE_INPARAM_TEST(isvalid_memblock(memblock), ONERR, );
+
+      const size_t size = memblock->size;
+
+      if (size <= mm_impl_MAXSMALLSIZE) {
+         mm_impl_slab_t * slab = slab_mmimpl(memblock->addr);
+         unsigned sizeclass = sizeclass_mmimpl(size);
+         VALIDATE_INPARAM_TEST(  memblock->addr >= (uint8_t*)slab + mm_impl_SLABHEADERSIZE
+                                 && slab->sizeclass == sizeclass, ONERR, );
+         void * object = memblock->addr;
+         *memblock = (memblock_t) memblock_FREE;
+         mm_impl_t * owner = loadacquire_atomicint(&slab->owner);
+         if (owner == mman) {
+            mman->size_allocated -= s_mmimpl_classsize[sizeclass];
+            err = freeobject_mmimpl(mman, slab, object);
+         } else if (owner && pushremote_mmimpl(&owner->remotelist, object)) {
+            err = 0;
+         } else {
+            err = freeorphan_mmimpl(slab);
+         }
+         if (err) goto ONERR;
+
+      } else {
+         mm_impl_block_t * block = block_mmimpl(memblock->addr);
+         VALIDATE_INPARAM_TEST(block->size == blocksize_mmimpl(size), ONERR, );
+         *memblock = (memblock_t) memblock_FREE;
+         mm_impl_t * owner = loadacquire_atomicint(&block->owner);
+         if (owner == mman) {
+            err = freeblock_mmimpl(mman, block);
+         } else if (owner && pushremote_mmimpl(&owner->remoteblocklist, &block->remote)) {
+            err = 0;
+         } else {
+            err = releaseblock_mmimpl(block);
+         }
+         if (err) goto ONERR;
+      }
+   }
+
+   if (mman->remotelist || mman->remoteblocklist) {
+      err = drainremote_mmimpl(mman);
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+// group: perftest
+
+#ifdef KONFIG_PERFTEST
 
-      mman->size_allocated -= sizeusable_malloc(memblock->addr) ;
+/* define: PT_NROPS
+ * Number of allocations (and frees) executed by every perftest instance. */
+#define PT_NROPS  1000000
 
-      // TODO: implement mfree_mmimpl without free
+/* define: PT_NRSLOTS
+ * Number of simultaneously allocated memory blocks of every perftest instance. */
+#define PT_NRSLOTS 1024
 
-      free(memblock->addr) ;
-      memblock->addr = 0 ;
-      memblock->size = 0 ;
+/* function: pt_nextsize
+ * Returns a pseudo random size in range [1..2*<mm_impl_MAXSMALLSIZE>].
+ * Small sizes are preferred. */
+static inline size_t pt_nextsize(uint32_t * seed)
+{
+   *seed = *seed * 1103515245 + 12345;
+   uint32_t rnd = *seed >> 16;
+   return 1 + ((rnd & 0x3ff) >> ((rnd >> 10) & 0x3)) * (2*mm_impl_MAXSMALLSIZE) / 0x400;
+}
+
+static int pt_prepare(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t mblock;
+
+   err = ALLOC_MM(PT_NRSLOTS * sizeof(memblock_t), &mblock);
+   if (err) return err;
+
+   memset(mblock.addr, 0, mblock.size);
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+}
+
+static int pt_unprepare(perftest_instance_t* tinst)
+{
+   memblock_t mblock = memblock_INIT(tinst->size, tinst->addr);
+   return FREE_MM(&mblock);
+}
+
+static int pt_run(perftest_instance_t* tinst)
+{
+   int err;
+   mm_impl_t    mman = mmimpl_FREE;
+   memblock_t * slot = tinst->addr;
+   uint32_t     seed = tinst->tid;
+
+   err = init_mmimpl(&mman);
+   if (err) return err;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      memblock_t * mblock = &slot[i % PT_NRSLOTS];
+      err = mfree_mmimpl(&mman, mblock);
+      if (err) goto ONERR;
+      err = malloc_mmimpl(&mman, pt_nextsize(&seed), mblock);
+      if (err) goto ONERR;
+      mblock->addr[0] = (uint8_t) i;
    }
 
-   return 0 ;
 ONERR:
-   TRACEEXIT_ERRLOG(err);
-   return err ;
+   for (unsigned i = 0; i < PT_NRSLOTS; ++i) {
+      (void) mfree_mmimpl(&mman, &slot[i]);
+   }
+   int err2 = free_mmimpl(&mman);
+   if (err2) err = err2;
+
+   return err;
 }
 
+static int pt_run_malloc(perftest_instance_t* tinst)
+{
+   memblock_t * slot = tinst->addr;
+   uint32_t     seed = tinst->tid;
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      memblock_t * mblock = &slot[i % PT_NRSLOTS];
+      free(mblock->addr);
+      mblock->addr = malloc(pt_nextsize(&seed));
+      if (!mblock->addr) return ENOMEM;
+      mblock->addr[0] = (uint8_t) i;
+   }
+
+   for (unsigned i = 0; i < PT_NRSLOTS; ++i) {
+      free(slot[i].addr);
+      slot[i].addr = 0;
+   }
+
+   return 0;
+}
+
+/* define: PT_RINGSIZE
+ * Number of memory blocks which could be handed over to the consumer thread before the producer waits. */
+#define PT_RINGSIZE 1024
+
+/* struct: pt_remote_t
+ * Memory blocks allocated by the perftest instance (producer) and freed by a consumer thread. */
+typedef struct pt_remote_t {
+   mm_impl_t      mman;
+   thread_t *     consumer;
+   uint64_t       nrops;
+   int            isstart;
+   int            isstop;
+   int            err;
+   uint32_t       writepos;
+   uint32_t       readpos;
+   memblock_t     ring[PT_RINGSIZE];
+} pt_remote_t;
+
+/* function: pt_consumer_remote
+ * Frees every memory block written into the ring by the producer with its own <mm_impl_t>.
+ * Therefore every block is pushed onto a remote list of the producer. */
+static int pt_consumer_remote(pt_remote_t * premote)
+{
+   mm_impl_t mman;
+   uint32_t  readpos = 0;
+
+   (void) init_mmimpl(&mman);
+
+   while (! loadacquire_atomicint(&premote->isstart)) {
+      yield_thread();
+   }
+
+   for (uint64_t i = 0; i < premote->nrops; ++i) {
+      while (readpos == loadacquire_atomicint(&premote->writepos)) {
+         if (loadacquire_atomicint(&premote->isstop)) goto ONABORT;
+         yield_thread();
+      }
+      if (mfree_mmimpl(&mman, &premote->ring[readpos % PT_RINGSIZE])) {
+         premote->err = EINVAL;
+      }
+      storerelease_atomicint(&premote->readpos, ++readpos);
+   }
+
+ONABORT:
+   if (free_mmimpl(&mman)) {
+      premote->err = EINVAL;
+   }
+
+   return 0;
+}
+
+static int pt_prepare_remote(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t    mblock;
+   pt_remote_t * premote;
+
+   err = ALLOC_MM(sizeof(pt_remote_t), &mblock);
+   if (err) return err;
+
+   premote = (pt_remote_t*) mblock.addr;
+   memset(premote, 0, sizeof(*premote));
+   premote->nrops = PT_NROPS;
+
+   err = init_mmimpl(&premote->mman);
+   if (err) goto ONERR;
+   err = newgeneric_thread(&premote->consumer, &pt_consumer_remote, premote);
+   if (err) goto ONERR;
+
+   tinst->nrops = PT_NROPS;
+   tinst->addr  = mblock.addr;
+   tinst->size  = mblock.size;
+
+   return 0;
+ONERR:
+   (void) free_mmimpl(&premote->mman);
+   (void) FREE_MM(&mblock);
+   return err;
+}
+
+static int pt_unprepare_remote(perftest_instance_t* tinst)
+{
+   int err;
+   memblock_t    mblock  = memblock_INIT(tinst->size, tinst->addr);
+   pt_remote_t * premote = (pt_remote_t*) tinst->addr;
+
+   write_atomicint(&premote->isstart, 1);
+   write_atomicint(&premote->isstop, 1);
+   err = delete_thread(&premote->consumer);
+   // frees blocks not freed by consumer in case of an error
+   for (uint32_t pos = premote->readpos; pos != premote->writepos; ++pos) {
+      (void) mfree_mmimpl(&premote->mman, &premote->ring[pos % PT_RINGSIZE]);
+   }
+   int err2 = free_mmimpl(&premote->mman);
+   if (err2) err = err2;
+   if (premote->err) err = premote->err;
+   err2 = FREE_MM(&mblock);
+   if (err2) err = err2;
+
+   return err;
+}
+
+/* function: pt_run_remote
+ * Allocates memory blocks and hands them over to the consumer thread.
+ * The memory freed by the consumer is reclaimed during the following calls to <malloc_mmimpl>. */
+static int pt_run_remote(perftest_instance_t* tinst)
+{
+   pt_remote_t * premote  = (pt_remote_t*) tinst->addr;
+   uint32_t      seed     = tinst->tid;
+   uint32_t      writepos = 0;
+
+   write_atomicint(&premote->isstart, 1);
+
+   for (uint64_t i = 0; i < tinst->nrops; ++i) {
+      while (writepos - loadacquire_atomicint(&premote->readpos) == PT_RINGSIZE) {
+         yield_thread();
+      }
+      memblock_t * mblock = &premote->ring[writepos % PT_RINGSIZE];
+      int err = malloc_mmimpl(&premote->mman, pt_nextsize(&seed), mblock);
+      if (err) return err;
+      mblock->addr[0] = (uint8_t) i;
+      storerelease_atomicint(&premote->writepos, ++writepos);
+   }
+
+   if (join_thread(premote->consumer)) return EINVAL;
+
+   return premote->err;
+}
+
+int perftest_memory_mm_mmimpl(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run, &pt_unprepare),
+               "Freeing and allocating a memory block",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_memory_mm_mmimpl_remote(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare_remote, &pt_run_remote, &pt_unprepare_remote),
+               "Allocating a memory block which is freed by another thread",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+int perftest_memory_mm_mmimpl_malloc(/*out*/perftest_info_t* info)
+{
+   *info = (perftest_info_t) perftest_info_INIT(
+               perftest_INIT(&pt_prepare, &pt_run_malloc, &pt_unprepare),
+               "Freeing and allocating a memory block",
+               0, 0, 0
+            );
+
+   return 0;
+}
+
+#endif
+
 
 // group: test
 
@@ -171,20 +1201,43 @@ ONERR:
 
 static int test_initfree(void)
 {
-   mm_impl_t mman = mmimpl_FREE ;
+   mm_impl_t  mman = mmimpl_FREE ;
+   memblock_t mblock ;
+   size_t     sizepgcache = SIZEALLOCATED_PAGECACHE() ;
 
    // TEST mmimpl_FREE
    TEST(0 == mman.size_allocated) ;
+   TEST(0 == mman.remotelist) ;
+   TEST(0 == mman.remoteblocklist) ;
+   TEST(0 == mman.state) ;
 
    // TEST init_mmimpl
+   memset(&mman, 255, sizeof(mman)) ;
    TEST(0 == init_mmimpl(&mman)) ;
    TEST(0 == mman.size_allocated) ;
-
-   // TEST free_mmimpl
+   TEST(0 == mman.remotelist) ;
+   TEST(0 == mman.remoteblocklist) ;
+   TEST(0 == mman.state) ;
+
+   // TEST malloc_mmimpl: allocates state
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock)) ;
+   TEST(0 != mman.state) ;
+   TEST(sizepgcache + pagesizeinbytes_pagecache(mm_impl_STATEPGSIZE) + mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE()) ;
+   TEST(0 == mfree_mmimpl(&mman, &mblock)) ;
+   TEST(0 != mman.state) ;
+
+   // TEST free_mmimpl: releases state and closes remote lists
    TEST(0 == free_mmimpl(&mman)) ;
    TEST(0 == mman.size_allocated) ;
+   TEST(mm_impl_REMOTECLOSED == mman.remotelist) ;
+   TEST(mm_impl_REMOTECLOSED == mman.remoteblocklist) ;
+   TEST(0 == mman.state) ;
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE()) ;
    TEST(0 == free_mmimpl(&mman)) ;
    TEST(0 == mman.size_allocated) ;
+   TEST(mm_impl_REMOTECLOSED == mman.remotelist) ;
+   TEST(mm_impl_REMOTECLOSED == mman.remoteblocklist) ;
+   TEST(0 == mman.state) ;
 
    return 0 ;
 ONERR:
@@ -227,6 +1280,333 @@ ONERR:
    return EINVAL ;
 }
 
+static int test_sizeclass(void)
+{
+   // TEST s_mmimpl_classsize: sorted and aligned to 16 bytes
+   TEST(mm_impl_MAXSMALLSIZE == s_mmimpl_classsize[mm_impl_NRSIZECLASS-1]);
+   for (unsigned i = 0; i < mm_impl_NRSIZECLASS; ++i) {
+      TEST(0 == s_mmimpl_classsize[i] % 16);
+      TEST(0 == i || s_mmimpl_classsize[i-1] < s_mmimpl_classsize[i]);
+   }
+
+   // TEST sizeclass_mmimpl: smallest class which fits
+   for (size_t size = 1, ci = 0; size <= mm_impl_MAXSMALLSIZE; ++size) {
+      if (size > s_mmimpl_classsize[ci]) ++ ci;
+      TEST(ci == sizeclass_mmimpl(size));
+   }
+
+   // TEST pagesize_mmimpl
+   TEST(pagesize_4096 == pagesize_mmimpl(mm_impl_MAXSMALLSIZE+1));
+   TEST(pagesize_4096 == pagesize_mmimpl(4096));
+   TEST(pagesize_8192 == pagesize_mmimpl(4097));
+   TEST(pagesize_1MB  == pagesize_mmimpl(mm_impl_MAXMEDIUMSIZE));
+
+   // TEST blocksize_mmimpl: medium size (header included)
+   TEST(4096 == blocksize_mmimpl(mm_impl_MAXSMALLSIZE+1));
+   TEST(4096 == blocksize_mmimpl(4096-mm_impl_BLOCKHEADERSIZE));
+   TEST(8192 == blocksize_mmimpl(4096-mm_impl_BLOCKHEADERSIZE+1));
+   TEST(mm_impl_MAXMEDIUMSIZE == blocksize_mmimpl(mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE));
+
+   // TEST blocksize_mmimpl: huge size (header included)
+   TEST(mm_impl_MAXMEDIUMSIZE+pagesize_vm() == blocksize_mmimpl(mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE+1));
+   TEST(mm_impl_MAXMEDIUMSIZE+pagesize_vm() == blocksize_mmimpl(mm_impl_MAXMEDIUMSIZE+pagesize_vm()-mm_impl_BLOCKHEADERSIZE));
+   TEST(mm_impl_MAXMEDIUMSIZE+2*pagesize_vm() == blocksize_mmimpl(mm_impl_MAXMEDIUMSIZE+pagesize_vm()-mm_impl_BLOCKHEADERSIZE+1));
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_slab(void)
+{
+   mm_impl_t         mman = mmimpl_FREE;
+   memblock_t        mblock[2];
+   mm_impl_slab_t  * slab[2];
+   size_t            sizepgcache = SIZEALLOCATED_PAGECACHE();
+   const size_t      statesize   = pagesizeinbytes_pagecache(mm_impl_STATEPGSIZE);
+
+   // prepare
+   TEST(0 == init_mmimpl(&mman));
+
+   for (unsigned ci = 0; ci < mm_impl_NRSIZECLASS; ++ci) {
+      const size_t objsize = s_mmimpl_classsize[ci];
+
+      // TEST malloc_mmimpl: first object allocates slab
+      TEST(0 == malloc_mmimpl(&mman, objsize-(ci > 0), &mblock[0]));
+      TEST(objsize == mblock[0].size);
+      slab[0] = slab_mmimpl(mblock[0].addr);
+      TEST(mblock[0].addr == (uint8_t*)slab[0] + mm_impl_SLABHEADERSIZE);
+      TEST(&mman == slab[0]->owner);
+      TEST(ci    == slab[0]->sizeclass);
+      TEST(1     == slab[0]->nrused);
+      TEST((mm_impl_SLABSIZE-mm_impl_SLABHEADERSIZE)/objsize == slab[0]->nrobjects);
+      TEST(slab[0] == first_slablist(cast_dlist(&mman.state->slablist[ci])));
+      TEST(sizepgcache + statesize + mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+      TEST(objsize == sizeallocated_mmimpl(&mman));
+
+      // TEST malloc_mmimpl: fill slab
+      for (unsigned i = 1; i < slab[0]->nrobjects; ++i) {
+         TEST(0 == malloc_mmimpl(&mman, objsize, &mblock[1]));
+         TEST(mblock[1].addr == mblock[0].addr + i * objsize);
+      }
+      TEST(slab[0]->nrused == slab[0]->nrobjects);
+
+      // TEST malloc_mmimpl: full slab allocates new slab which is inserted as first
+      TEST(0 == malloc_mmimpl(&mman, objsize, &mblock[1]));
+      slab[1] = slab_mmimpl(mblock[1].addr);
+      TEST(slab[1] != slab[0]);
+      TEST(slab[1] == first_slablist(cast_dlist(&mman.state->slablist[ci])));
+      TEST(slab[0] == last_slablist(cast_dlist(&mman.state->slablist[ci])));
+      TEST(sizepgcache + statesize + 2*mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+
+      // TEST mfree_mmimpl: full slab is moved to front
+      TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+      TEST(isfree_memblock(&mblock[0]));
+      TEST(slab[0] == first_slablist(cast_dlist(&mman.state->slablist[ci])));
+      TEST(slab[0]->nrused == slab[0]->nrobjects-1);
+
+      // TEST malloc_mmimpl: reuses freed object
+      TEST(0 == malloc_mmimpl(&mman, objsize, &mblock[0]));
+      TEST(mblock[0].addr == (uint8_t*)slab[0] + mm_impl_SLABHEADERSIZE);
+      TEST(slab[1] == first_slablist(cast_dlist(&mman.state->slablist[ci])));
+
+      // TEST mfree_mmimpl: unused slab is released
+      TEST(0 == mfree_mmimpl(&mman, &mblock[1]));
+      TEST(sizepgcache + statesize + mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+      TEST(slab[0] == first_slablist(cast_dlist(&mman.state->slablist[ci])));
+      TEST(slab[0] == last_slablist(cast_dlist(&mman.state->slablist[ci])));
+
+      // TEST free_mmimpl: slab with used objects becomes orphaned
+      const unsigned nrobjects = slab[0]->nrobjects;
+      TEST(0 == free_mmimpl(&mman));
+      TEST(0 == sizeallocated_mmimpl(&mman));
+      TEST(0 == mman.state);
+      TEST(0 == slab[0]->owner);
+      TEST(nrobjects == slab[0]->nrused);
+      TEST(sizepgcache + mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+
+      // TEST mfree_mmimpl: last freed object releases orphaned slab
+      TEST(0 == init_mmimpl(&mman));
+      for (unsigned i = nrobjects; i > 0; --i) {
+         TEST(sizepgcache + mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+         TEST(i == slab[0]->nrused);
+         mblock[1] = (memblock_t) memblock_INIT(objsize, (uint8_t*)slab[0] + mm_impl_SLABHEADERSIZE + (i-1) * objsize);
+         TEST(0 == mfree_mmimpl(&mman, &mblock[1]));
+         TEST(isfree_memblock(&mblock[1]));
+      }
+      TEST(0 == sizeallocated_mmimpl(&mman));
+      TEST(0 == mman.state);
+      TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+   }
+
+   // TEST malloc_mmimpl: medium size
+   for (size_t size = mm_impl_MAXSMALLSIZE+1; size <= mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE; size *= 2) {
+      TEST(0 == malloc_mmimpl(&mman, size, &mblock[0]));
+      TEST(mblock[0].size == blocksize_mmimpl(size) - mm_impl_BLOCKHEADERSIZE);
+      TEST(0 == ((uintptr_t)block_mmimpl(mblock[0].addr) & (blocksize_mmimpl(size)-1)));
+      TEST(&mman == block_mmimpl(mblock[0].addr)->owner);
+      TEST(blocksize_mmimpl(size) == block_mmimpl(mblock[0].addr)->size);
+      TEST(mblock[0].size == sizeallocated_mmimpl(&mman));
+      TEST(sizepgcache + statesize + blocksize_mmimpl(size) == SIZEALLOCATED_PAGECACHE());
+      // TEST mresize_mmimpl: same page size keeps address
+      void * oldaddr = mblock[0].addr;
+      TEST(0 == mresize_mmimpl(&mman, mblock[0].size, &mblock[0]));
+      TEST(oldaddr == mblock[0].addr);
+      TEST(mblock[0].size == sizeallocated_mmimpl(&mman));
+      TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+      TEST(0 == sizeallocated_mmimpl(&mman));
+      TEST(sizepgcache + statesize == SIZEALLOCATED_PAGECACHE());
+   }
+
+   // TEST malloc_mmimpl: huge size
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE+1, &mblock[0]));
+   TEST(mblock[0].size == mm_impl_MAXMEDIUMSIZE+pagesize_vm()-mm_impl_BLOCKHEADERSIZE);
+   TEST(0 == (uintptr_t)block_mmimpl(mblock[0].addr) % pagesize_vm());
+   TEST(&mman == block_mmimpl(mblock[0].addr)->owner);
+   TEST(mblock[0].size == sizeallocated_mmimpl(&mman));
+   TEST(sizepgcache + statesize == SIZEALLOCATED_PAGECACHE());
+   memset(mblock[0].addr, 1, mblock[0].size);
+
+   // TEST mresize_mmimpl: huge to huge keeps content
+   TEST(0 == mresize_mmimpl(&mman, 4*mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE, &mblock[0]));
+   TEST(mblock[0].size == 4*mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE);
+   TEST(mblock[0].size == sizeallocated_mmimpl(&mman));
+   TEST(&mman == block_mmimpl(mblock[0].addr)->owner);
+   TEST(1 == mblock[0].addr[mm_impl_MAXMEDIUMSIZE]);
+   TEST(0 == mresize_mmimpl(&mman, 2*mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE, &mblock[0]));
+   TEST(mblock[0].size == 2*mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE);
+   TEST(mblock[0].size == sizeallocated_mmimpl(&mman));
+   TEST(block_mmimpl(mblock[0].addr) == last_blocklist(cast_dlist(&mman.state->blocklist)));
+   TEST(block_mmimpl(mblock[0].addr) == first_blocklist(cast_dlist(&mman.state->blocklist)));
+   TEST(1 == mblock[0].addr[0]);
+
+   // TEST mresize_mmimpl: huge to small copies content
+   TEST(0 == mresize_mmimpl(&mman, 100, &mblock[0]));
+   TEST(112 == mblock[0].size);
+   TEST(112 == sizeallocated_mmimpl(&mman));
+   TEST(1 == mblock[0].addr[0] && 1 == mblock[0].addr[99]);
+
+   // TEST mresize_mmimpl: same size class keeps address
+   void * oldaddr = mblock[0].addr;
+   TEST(0 == mresize_mmimpl(&mman, 97, &mblock[0]));
+   TEST(oldaddr == mblock[0].addr);
+   TEST(112 == mblock[0].size);
+   TEST(112 == sizeallocated_mmimpl(&mman));
+
+   // TEST mfree_mmimpl: size set back to requested size
+   mblock[0].size = 100;
+   TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+   TEST(0 == sizeallocated_mmimpl(&mman));
+
+   // TEST mfree_mmimpl: EINVAL (wrong size class)
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock[0]));
+   mblock[0].size = 32;
+   TEST(EINVAL == mfree_mmimpl(&mman, &mblock[0]));
+   mblock[0].size = 16;
+   TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+
+   // unprepare
+   TEST(0 == free_mmimpl(&mman));
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_mmimpl(&mman);
+   return EINVAL;
+}
+
+struct child_mfree_t {
+   memblock_t* mblock;
+   unsigned    nrblocks;
+};
+
+static int child_mfree(void *_param)
+{
+   struct child_mfree_t * param = _param;
+   mm_impl_t mman = mmimpl_FREE;
+   for (unsigned i = 0; i < param->nrblocks; ++i) {
+      if (mfree_mmimpl(&mman, &param->mblock[i])) return EINVAL;
+   }
+   return 0;
+}
+
+static int mfreeinthread(memblock_t* mblock, unsigned nrblocks)
+{
+   struct child_mfree_t param = { mblock, nrblocks };
+   thread_t * thread = 0;
+   TEST(0 == new_thread(&thread, &child_mfree, &param));
+   TEST(0 == join_thread(thread));
+   TEST(0 == returncode_thread(thread));
+   TEST(0 == delete_thread(&thread));
+   return 0;
+ONERR:
+   delete_thread(&thread);
+   return EINVAL;
+}
+
+static size_t lengthremotelist(mm_impl_object_t* remotelist)
+{
+   size_t len = 0;
+   for (mm_impl_object_t* obj = remotelist; obj; obj = obj->next) {
+      ++ len;
+   }
+   return len;
+}
+
+static int test_remote(void)
+{
+   mm_impl_t   mman = mmimpl_FREE;
+   memblock_t  mblock[mm_impl_NRSIZECLASS];
+   size_t      sizepgcache = SIZEALLOCATED_PAGECACHE();
+   const size_t statesize  = pagesizeinbytes_pagecache(mm_impl_STATEPGSIZE);
+   size_t      size = 0;
+
+   // prepare
+   TEST(0 == init_mmimpl(&mman));
+
+   // TEST mfree_mmimpl: other thread pushes objects onto remotelist
+   for (unsigned ci = 0; ci < mm_impl_NRSIZECLASS; ++ci) {
+      TEST(0 == malloc_mmimpl(&mman, s_mmimpl_classsize[ci], &mblock[ci]));
+      size += mblock[ci].size;
+   }
+   TEST(0 == mfreeinthread(mblock, lengthof(mblock)));
+   for (unsigned ci = 0; ci < mm_impl_NRSIZECLASS; ++ci) {
+      TEST(isfree_memblock(&mblock[ci]));
+   }
+   // objects are not freed by other thread
+   TEST(mm_impl_NRSIZECLASS == lengthremotelist(mman.remotelist));
+   TEST(size == sizeallocated_mmimpl(&mman));
+   TEST(sizepgcache + statesize + mm_impl_NRSIZECLASS*mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+
+   // TEST malloc_mmimpl: drains remotelist
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock[0]));
+   TEST(0 == mman.remotelist);
+   TEST(16 == sizeallocated_mmimpl(&mman));
+   TEST(sizepgcache + statesize + mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+
+   // TEST mfree_mmimpl: drains remotelist
+   TEST(0 == malloc_mmimpl(&mman, 32, &mblock[1]));
+   TEST(0 == mfreeinthread(&mblock[1], 1));
+   TEST(1 == lengthremotelist(mman.remotelist));
+   TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+   TEST(0 == mman.remotelist);
+   TEST(0 == sizeallocated_mmimpl(&mman));
+   TEST(sizepgcache + statesize == SIZEALLOCATED_PAGECACHE());
+
+   // TEST mfree_mmimpl: other thread pushes medium and huge blocks onto remoteblocklist
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXSMALLSIZE+1, &mblock[0]));
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXMEDIUMSIZE, &mblock[1]));
+   size = mblock[0].size + mblock[1].size;
+   TEST(0 == mfreeinthread(mblock, 2));
+   TEST(isfree_memblock(&mblock[0]));
+   TEST(isfree_memblock(&mblock[1]));
+   // blocks are not freed by other thread
+   TEST(2 == lengthremotelist(mman.remoteblocklist));
+   TEST(size == sizeallocated_mmimpl(&mman));
+
+   // TEST malloc_mmimpl: drains remoteblocklist (size is subtracted from owner)
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock[0]));
+   TEST(0 == mman.remoteblocklist);
+   TEST(16 == sizeallocated_mmimpl(&mman));
+   TEST(sizepgcache + statesize + mm_impl_SLABSIZE == SIZEALLOCATED_PAGECACHE());
+   TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+
+   // TEST free_mmimpl: drains remotelist
+   TEST(0 == malloc_mmimpl(&mman, 64, &mblock[0]));
+   TEST(0 == mfreeinthread(&mblock[0], 1));
+   TEST(1 == lengthremotelist(mman.remotelist));
+   TEST(0 == free_mmimpl(&mman));
+   TEST(mm_impl_REMOTECLOSED == mman.remotelist);
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+
+   // TEST free_mmimpl: slab and blocks in use become orphaned
+   TEST(0 == init_mmimpl(&mman));
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock[0]));
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXSMALLSIZE+1, &mblock[1]));
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXMEDIUMSIZE, &mblock[2]));
+   TEST(0 == free_mmimpl(&mman));
+   TEST(0 == slab_mmimpl(mblock[0].addr)->owner);
+   TEST(0 == block_mmimpl(mblock[1].addr)->owner);
+   TEST(0 == block_mmimpl(mblock[2].addr)->owner);
+   TEST(sizepgcache + mm_impl_SLABSIZE + blocksize_mmimpl(mm_impl_MAXSMALLSIZE+1) == SIZEALLOCATED_PAGECACHE());
+
+   // TEST mfree_mmimpl: other thread releases orphaned slab and blocks
+   TEST(0 == mfreeinthread(mblock, 3));
+   TEST(mm_impl_REMOTECLOSED == mman.remotelist);
+   TEST(mm_impl_REMOTECLOSED == mman.remoteblocklist);
+   // pagecache of this thread drains pages released by other thread
+   TEST(0 == init_mmimpl(&mman));
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock[0]));
+   TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+   TEST(0 == free_mmimpl(&mman));
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+
+   return 0;
+ONERR:
+   free_mmimpl(&mman);
+   return EINVAL;
+}
+
 static int test_allocate(void)
 {
    mm_impl_t      mman = mmimpl_FREE ;
@@ -392,17 +1772,183 @@ ONERR:
    return EINVAL ;
 }
 
+static int test_statistics(void)
+{
+   mm_impl_t      mman = mmimpl_FREE;
+   mm_impl_t      mman2 = mmimpl_FREE;
+   mm_impl_stat_t stat = mm_impl_stat_FREE;
+   mm_impl_stat_t stat2;
+   memblock_t     mblock[3];
+   unsigned const nrobjects = (mm_impl_SLABSIZE-mm_impl_SLABHEADERSIZE) / 48;
+   uint8_t      * logbuffer;
+   size_t         logsize1;
+   size_t         logsize2;
+
+   // prepare
+   TEST(0 == init_mmimpl(&mman));
+
+   // TEST addstat_mmimpl: init_mmimpl clears counters
+   addstat_mmimpl(&mman, &stat);
+   for (unsigned ci = 0; ci < mm_impl_NRSIZECLASS; ++ci) {
+      TEST(0 == stat.sizeclass[ci].nralloc);
+      TEST(0 == stat.sizeclass[ci].nrfree);
+      TEST(0 == stat.sizeclass[ci].nrused);
+      TEST(0 == stat.sizeclass[ci].peakused);
+      TEST(0 == stat.sizeclass[ci].nrcached);
+      TEST(0 == stat.sizeclass[ci].nrslaballoc);
+      TEST(0 == stat.sizeclass[ci].nrslabfree);
+   }
+   TEST(0 == stat.medium.nralloc);
+   TEST(0 == stat.medium.nrfree);
+   TEST(0 == stat.medium.nrused);
+   TEST(0 == stat.medium.peakused);
+   TEST(0 == stat.huge.nralloc);
+   TEST(0 == stat.huge.nrfree);
+   TEST(0 == stat.huge.nrused);
+   TEST(0 == stat.huge.peakused);
+   TEST(0 == stat.nrremote);
+
+   // TEST addstat_mmimpl: small objects
+   for (unsigned i = 0; i < lengthof(mblock); ++i) {
+      TEST(0 == malloc_mmimpl(&mman, 48, &mblock[i]));
+   }
+   TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+   addstat_mmimpl(&mman, &stat);
+   TEST(3 == stat.sizeclass[2].nralloc);
+   TEST(1 == stat.sizeclass[2].nrfree);
+   TEST(2 == stat.sizeclass[2].nrused);
+   TEST(3 == stat.sizeclass[2].peakused);
+   TEST(nrobjects-2 == stat.sizeclass[2].nrcached);
+   TEST(1 == stat.sizeclass[2].nrslaballoc);
+   TEST(0 == stat.sizeclass[2].nrslabfree);
+   TEST(0 == stat.sizeclass[1].nralloc);
+   TEST(0 == stat.sizeclass[3].nralloc);
+
+   // TEST addstat_mmimpl: adds to values in stat (peak values are not added)
+   addstat_mmimpl(&mman, &stat);
+   TEST(6 == stat.sizeclass[2].nralloc);
+   TEST(2 == stat.sizeclass[2].nrfree);
+   TEST(4 == stat.sizeclass[2].nrused);
+   TEST(3 == stat.sizeclass[2].peakused);
+   TEST(2*(nrobjects-2) == stat.sizeclass[2].nrcached);
+   TEST(2 == stat.sizeclass[2].nrslaballoc);
+
+   // TEST addstat_mmimpl: unused slab is returned to pagecache
+   TEST(0 == mfree_mmimpl(&mman, &mblock[1]));
+   TEST(0 == mfree_mmimpl(&mman, &mblock[2]));
+   stat = (mm_impl_stat_t) mm_impl_stat_FREE;
+   addstat_mmimpl(&mman, &stat);
+   TEST(3 == stat.sizeclass[2].nralloc);
+   TEST(3 == stat.sizeclass[2].nrfree);
+   TEST(0 == stat.sizeclass[2].nrused);
+   TEST(3 == stat.sizeclass[2].peakused);
+   TEST(0 == stat.sizeclass[2].nrcached);
+   TEST(1 == stat.sizeclass[2].nrslaballoc);
+   TEST(1 == stat.sizeclass[2].nrslabfree);
+
+   // TEST addstat_mmimpl: medium and huge blocks
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXSMALLSIZE+1, &mblock[0]));
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE, &mblock[1]));
+   TEST(0 == malloc_mmimpl(&mman, mm_impl_MAXMEDIUMSIZE-mm_impl_BLOCKHEADERSIZE+1, &mblock[2]));
+   TEST(0 == mfree_mmimpl(&mman, &mblock[0]));
+   stat = (mm_impl_stat_t) mm_impl_stat_FREE;
+   addstat_mmimpl(&mman, &stat);
+   TEST(2 == stat.medium.nralloc);
+   TEST(1 == stat.medium.nrfree);
+   TEST(1 == stat.medium.nrused);
+   TEST(2 == stat.medium.peakused);
+   TEST(1 == stat.huge.nralloc);
+   TEST(0 == stat.huge.nrfree);
+   TEST(1 == stat.huge.nrused);
+   TEST(1 == stat.huge.peakused);
+   TEST(0 == mfree_mmimpl(&mman, &mblock[1]));
+   TEST(0 == mfree_mmimpl(&mman, &mblock[2]));
+   stat = (mm_impl_stat_t) mm_impl_stat_FREE;
+   addstat_mmimpl(&mman, &stat);
+   TEST(2 == stat.medium.nrfree);
+   TEST(0 == stat.medium.nrused);
+   TEST(2 == stat.medium.peakused);
+   TEST(1 == stat.huge.nrfree);
+   TEST(0 == stat.huge.nrused);
+   TEST(1 == stat.huge.peakused);
+
+   // TEST addstat_mmimpl: objects freed by other thread
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock[0]));
+   TEST(0 == malloc_mmimpl(&mman, 16, &mblock[1]));
+   TEST(0 == mfreeinthread(&mblock[0], 1));
+   TEST(0 == mfree_mmimpl(&mman, &mblock[1]));
+   stat = (mm_impl_stat_t) mm_impl_stat_FREE;
+   addstat_mmimpl(&mman, &stat);
+   TEST(1 == stat.nrremote);
+   TEST(2 == stat.sizeclass[0].nralloc);
+   TEST(2 == stat.sizeclass[0].nrfree);
+   TEST(0 == stat.sizeclass[0].nrused);
+
+   // TEST logstat_mmimpl
+   GETBUFFER_ERRLOG(&logbuffer, &logsize1);
+   logstat_mmimpl(&stat, log_channel_ERR);
+   GETBUFFER_ERRLOG(&logbuffer, &logsize2);
+   TEST(logsize2 > logsize1);
+   TEST(0 != strstr((char*)logbuffer+logsize1, "mm: medium alloc=2 free=2 used=0 peak=2\n"));
+   TEST(0 != strstr((char*)logbuffer+logsize1, "mm: huge alloc=1 free=1 used=0 peak=1\n"));
+   TEST(0 != strstr((char*)logbuffer+logsize1, "mm: remote=1\n"));
+   TEST(0 != strstr((char*)logbuffer+logsize1, "sizeclass 16: alloc=2 free=2 used=0 peak=2 cached=0 slaballoc=1 slabfree=1\n"));
+   TEST(0 != strstr((char*)logbuffer+logsize1, "sizeclass 48: alloc=3 free=3 used=0 peak=3 cached=0 slaballoc=1 slabfree=1\n"));
+   TEST(0 == strstr((char*)logbuffer+logsize1, "sizeclass 32:"));
+   TRUNCATEBUFFER_ERRLOG(logsize1);
+
+   // TEST collectstat_mmimpl: adds counters of every mm_impl_t
+   TEST(0 == init_mmimpl(&mman2));
+   stat = (mm_impl_stat_t) mm_impl_stat_FREE;
+   collectstat_mmimpl(&stat);
+   TEST(stat.sizeclass[0].nralloc >= 2);
+   TEST(0 == malloc_mmimpl(&mman2, 16, &mblock[0]));
+   TEST(0 == malloc_mmimpl(&mman2, 16, &mblock[1]));
+   stat2 = (mm_impl_stat_t) mm_impl_stat_FREE;
+   collectstat_mmimpl(&stat2);
+   TEST(stat2.sizeclass[0].nralloc == stat.sizeclass[0].nralloc + 2);
+   TEST(stat2.sizeclass[0].nrused  == stat.sizeclass[0].nrused + 2);
+   TEST(stat2.sizeclass[0].peakused >= 2);
+   TEST(stat2.sizeclass[0].nrslaballoc == stat.sizeclass[0].nrslaballoc + 1);
+   TEST(0 == mfree_mmimpl(&mman2, &mblock[0]));
+   TEST(0 == mfree_mmimpl(&mman2, &mblock[1]));
+
+   // TEST collectstat_mmimpl: free_mmimpl removes counters
+   TEST(0 == free_mmimpl(&mman2));
+   stat2 = (mm_impl_stat_t) mm_impl_stat_FREE;
+   collectstat_mmimpl(&stat2);
+   TEST(stat2.sizeclass[0].nralloc == stat.sizeclass[0].nralloc);
+   TEST(stat2.sizeclass[0].nrused  == stat.sizeclass[0].nrused);
+   TEST(stat2.sizeclass[0].nrslaballoc == stat.sizeclass[0].nrslaballoc);
+
+   // unprepare
+   TEST(0 == free_mmimpl(&mman));
+
+   return 0;
+ONERR:
+   free_mmimpl(&mman);
+   free_mmimpl(&mman2);
+   return EINVAL;
+}
+
 static int childprocess_unittest(void)
 {
    resourceusage_t usage = resourceusage_FREE ;
 
    if (test_allocate())    goto ONERR;
+   // the C library keeps memory allocated for the first started threads
+   if (test_remote())      goto ONERR;
+   if (test_remote())      goto ONERR;
 
    TEST(0 == init_resourceusage(&usage)) ;
 
    if (test_initfree())    goto ONERR;
    if (test_initthread())  goto ONERR;
    if (test_query())       goto ONERR;
+   if (test_sizeclass())   goto ONERR;
+   if (test_slab())        goto ONERR;
+   if (test_remote())      goto ONERR;
+   if (test_statistics())  goto ONERR;
    if (test_allocate())    goto ONERR;
    if (test_mm_macros())   goto ONERR;
 
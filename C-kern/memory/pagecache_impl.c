@@ -26,6 +26,7 @@
 #include "C-kern/api/memory/ptr.h"
 #include "C-kern/api/memory/memblock.h"
 #include "C-kern/api/memory/vm.h"
+#include "C-kern/api/platform/task/thread.h"
 #include "C-kern/api/test/errortimer.h"
 #ifdef KONFIG_UNITTEST
 #include "C-kern/api/test/unittest.h"
@@ -72,6 +73,18 @@ typedef struct freepage_t {
    dlist_node_t  *prev;
 } freepage_t;
 
+/* struct: remotepage_t
+ * Header of used page which was released by a thread other than the owner.
+ * It is stored on <pagecache_impl_t.remotelist> until the owner drains the list. */
+typedef struct remotepage_t {
+   /* variable: marker
+    * Same position as <freepage_t.marker>. Always 0 cause page is still counted as used. */
+   struct block_t      *marker;
+   /* variable: next
+    * Next page on <pagecache_impl_t.remotelist>. */
+   struct remotepage_t *next;
+} remotepage_t;
+
 // group: helper
 
 /* define: INTERFACE_freepagelist
@@ -124,6 +137,99 @@ typedef struct subheader_t {
 dlist_IMPLEMENT(_subheaderlist, subheader_t, freenode.)
 
 
+/* struct: pagecache_impl_counter_t
+ * Allocation counters of a single <pagecache_impl_t>.
+ * They are stored outside of <pagecache_impl_t> which is part of the static memory of every thread.
+ * The counters are mapped with <init_vmpage> before the first block is allocated
+ * and linked into <s_pagecacheimpl_statlist> so <collectstat_pagecacheimpl> could read them. */
+typedef struct pagecache_impl_counter_t {
+   /* variable: statnode
+    * Links counters into <s_pagecacheimpl_statlist>. */
+   dlist_node_t            statnode;
+   /* variable: nrsubblock
+    * Number of sub-blocks which are assigned to a certain <pagesize_e>.
+    * Used to compute <pagecache_impl_stat_t.pgsize>.nrcached. */
+   size_t                  nrsubblock[pagesize__NROF];
+   /* variable: stat
+    * Only the owner of <pagecache_impl_t> writes them.
+    * The values of <pagecache_impl_stat_t.pgsize>.nrcached are not maintained. */
+   pagecache_impl_stat_t   stat;
+} pagecache_impl_counter_t;
+
+// group: static variables
+
+/* variable: s_pagecacheimpl_statlist
+ * List of the <pagecache_impl_counter_t> of all <pagecache_impl_t> which have allocated memory.
+ * Protected by <s_pagecacheimpl_statlock>. */
+static struct {
+   dlist_node_t *last;
+}                    s_pagecacheimpl_statlist = { 0 };
+
+/* variable: s_pagecacheimpl_statlock
+ * Used as lock. Protects <s_pagecacheimpl_statlist> and the write access to <pagecache_impl_t.counter>.
+ * Counters could not be unmapped while another thread reads them. */
+static atomicflag_t  s_pagecacheimpl_statlock = 0;
+
+// group: helper
+
+/* define: INTERFACE_statlist
+ * Macro <dlist_IMPLEMENT> generates dlist interface for <pagecache_impl_counter_t>. */
+dlist_IMPLEMENT(_statlist, pagecache_impl_counter_t, statnode.)
+
+static inline void lockstat_pagecacheimpl(void)
+{
+   while (0 != set_atomicflag(&s_pagecacheimpl_statlock)) {
+      yield_thread();
+   }
+}
+
+static inline void unlockstat_pagecacheimpl(void)
+{
+   clear_atomicflag(&s_pagecacheimpl_statlock);
+}
+
+// group: lifetime
+
+/* function: newcounter_pagecacheimpl
+ * Maps <pagecache_impl_t.counter> and inserts it into <s_pagecacheimpl_statlist>. */
+static int newcounter_pagecacheimpl(pagecache_impl_t *pgcache)
+{
+   int err;
+   vmpage_t vmpage;
+
+   err = init_vmpage(&vmpage, sizeof(pagecache_impl_counter_t));
+   if (err) return err;
+
+   pagecache_impl_counter_t *counter = (pagecache_impl_counter_t*) vmpage.addr;
+   *counter = (pagecache_impl_counter_t) { { 0, 0 }, { 0 }, pagecache_impl_stat_FREE };
+
+   lockstat_pagecacheimpl();
+   insertlast_statlist(cast_dlist(&s_pagecacheimpl_statlist), counter);
+   pgcache->counter = counter;
+   unlockstat_pagecacheimpl();
+
+   return 0;
+}
+
+/* function: deletecounter_pagecacheimpl
+ * Removes <pagecache_impl_t.counter> from <s_pagecacheimpl_statlist> and unmaps it. */
+static int deletecounter_pagecacheimpl(pagecache_impl_t *pgcache)
+{
+   pagecache_impl_counter_t *counter = pgcache->counter;
+
+   if (counter) {
+      lockstat_pagecacheimpl();
+      remove_statlist(cast_dlist(&s_pagecacheimpl_statlist), counter);
+      pgcache->counter = 0;
+      unlockstat_pagecacheimpl();
+      vmpage_t vmpage = vmpage_INIT(sizeof(pagecache_impl_counter_t), (uint8_t*)counter);
+      return free_vmpage(&vmpage);
+   }
+
+   return 0;
+}
+
+
 /* struct: block_t
  * Manages a big chunk of aligned memory which is divided into a number of <subblock_t>.
  * Every subblock_t manages a set of allocatable memory pages of a certain <pagesize_e>.
@@ -136,6 +242,9 @@ typedef struct block_t {
    /* variable: threadcontext
     * Thread which allocated the memory block. */
    threadcontext_t  *threadcontext;
+   /* variable: hugepage
+    * Value of <vmhuge_e> which describes if this block is backed by huge pages. */
+   uint8_t           hugepage;
    /* variable: blocknode
     * Used to store all allocated <block_t> in a list. */
    dlist_node_t      blocknode;
@@ -344,6 +453,17 @@ static inline int freepage_subheader(block_t* block, subheader_t* header, freepa
 
 // group: lifetime
 
+/* function: prefault_subblock
+ * Maps physical memory for the sub-block with index subindex if <pagecache_impl_t.prefault> is set.
+ * An error is logged but ignored. The memory is usable without prefaulting. */
+static inline void prefault_subblock(block_t *block, pagecache_impl_t *outer, unsigned subindex)
+{
+   if (outer->prefault != vmprefault_NONE) {
+      vmpage_t subblock = vmpage_INIT(pagecache_impl_SUBBLOCKSIZE, (uint8_t*)block + subindex * pagecache_impl_SUBBLOCKSIZE);
+      (void) prefault_vmpage(&subblock, outer->prefault);
+   }
+}
+
 /* function: new_block
  * Allocates a big block of memory and returns its description in <pagecache_block_t>.
  * The returned <pagecache_block_t> is allocated on the heap. */
@@ -352,6 +472,7 @@ static int new_block(/*out*/block_t **block, pagecache_impl_t *outer)
    int err;
    vmpage_t    pageblock;
    block_t    *newblock;
+   vmhuge_e    huge;
 
    static_assert( pagecache_impl_SUBBLOCKSIZE >= (1024*1024)
                   && pagesize_1MB + 1u == pagesize__NROF,
@@ -359,14 +480,23 @@ static int new_block(/*out*/block_t **block, pagecache_impl_t *outer)
                   && ispowerof2_int(pagecache_impl_BLOCKSIZE)
                   "largest value of pagesize_e is supprted");
 
+   if (! outer->counter) {
+      err = newcounter_pagecacheimpl(outer);
+      if (err) goto ONERR;
+   }
+
    if (! PROCESS_testerrortimer(&s_block_errtimer, &err)) {
-      err = initaligned_vmpage(&pageblock, pagecache_impl_BLOCKSIZE);
+      err = initalignedhuge_vmpage(&pageblock, pagecache_impl_BLOCKSIZE, outer->hugepage, &huge);
    }
    if (err) goto ONERR;
 
    newblock = (block_t*) pageblock.addr;
    newblock->owner = outer;
    newblock->threadcontext = tcontext_maincontext();
+   newblock->hugepage = huge;
+   if (huge != vmhuge_NONE) ++ outer->nrhugeblocks;
+   ++ outer->counter->stat.nrblockalloc;
+   ++ outer->counter->nrsubblock[pagesize_4096];
    insertfirst_dlist(cast_dlist(&outer->blocklist), &newblock->blocknode);
    insertfirst_dlist(cast_dlist(&outer->unusedblocklist), &newblock->unusedblocknode);
    memset(newblock->freeblocknode, 0, sizeof(newblock->freeblocknode));
@@ -385,6 +515,7 @@ static int new_block(/*out*/block_t **block, pagecache_impl_t *outer)
    insertfirst_subheaderlist(&newblock->freesublist[pagesize_4096], header);
    insertfirst_dlist(cast_dlist(&outer->freeblocklist[pagesize_4096]), &newblock->freeblocknode[pagesize_4096]);
    // other subblocks need not be initialized, they are initialized on demand (allocunused_block)
+   prefault_subblock(newblock, outer, subindex);
 
    // set out values
    *block = newblock;
@@ -404,6 +535,11 @@ static int delete_block(block_t *block, pagecache_impl_t *outer)
 
    if (block && block->owner == outer) {
       block->owner = 0;
+      if (block->hugepage != vmhuge_NONE) -- outer->nrhugeblocks;
+      ++ outer->counter->stat.nrblockfree;
+      for (unsigned i = 0; i < block->nextunused; ++i) {
+         if (block->pgsize[i] < pagesize__NROF) -- outer->counter->nrsubblock[block->pgsize[i]];
+      }
 
       if (isinlist_dlistnode(&block->blocknode)) {
          remove_dlist(cast_dlist(&outer->blocklist), &block->blocknode);
@@ -448,6 +584,7 @@ static int releasepage_block(block_t *block, pagecache_impl_t *outer, uint16_t s
          // move header to first page
          header = align_subheader(header);
          initunused_subheader(block, subidx);
+         -- outer->counter->nrsubblock[pgsize];
          insertfirst_subheaderlist(&block->unusedsublist, header);
          if (!isinlist_dlist(&block->unusedblocknode))
             insertfirst_dlist(cast_dlist(&outer->unusedblocklist), &block->unusedblocknode);
@@ -465,6 +602,7 @@ static int releasepage_block(block_t *block, pagecache_impl_t *outer, uint16_t s
          insertfirst_subheaderlist(&block->freesublist[pgsize], (subheader_t*)page);
       } else {
          initunused_subheader(block, subidx);
+         -- outer->counter->nrsubblock[pgsize];
          insertfirst_subheaderlist(&block->unusedsublist, header);
          if (!isinlist_dlist(&block->unusedblocknode))
             insertfirst_dlist(cast_dlist(&outer->unusedblocklist), &block->unusedblocknode);
@@ -495,6 +633,8 @@ static void allocunused_block(block_t *block, pagecache_impl_t *outer, pagesize_
    if (isempty_subheaderlist(&block->unusedsublist)) {
       idx = block->nextunused++;
       header = (subheader_t*) ((uint8_t*)block + idx * pagecache_impl_SUBBLOCKSIZE);
+      // first use of sub-block
+      prefault_subblock(block, outer, idx);
    } else {
       header = removefirst_subheaderlist(&block->unusedsublist);
       idx = get_subindex(header);
@@ -507,6 +647,7 @@ static void allocunused_block(block_t *block, pagecache_impl_t *outer, pagesize_
    }
    NOT_EMPTY_LIST: ;
    initfree_subheader(block, header, idx, 0, pgsize);
+   ++ outer->counter->nrsubblock[pgsize];
    if (isempty_subheaderlist(&block->freesublist[pgsize])) {
       insertfirst_dlist(cast_dlist(&outer->freeblocklist[pgsize]), &block->freeblocknode[pgsize]);
    }
@@ -514,6 +655,82 @@ static void allocunused_block(block_t *block, pagecache_impl_t *outer, pagesize_
    allocpage_block(block, outer, pgsize, page);
 }
 
+// group: remote
+
+/* function: pushremote_pagecacheimpl
+ * Pushes page onto the lock-free stack <pagecache_impl_t.remotelist> of owner.
+ * This function is called from a thread which does not own page.
+ * Pushing concurrently with other threads and with <drainremote_pagecacheimpl> is safe.
+ * Draining removes always all pages at once therefore no ABA problem exists. */
+static inline void pushremote_pagecacheimpl(pagecache_impl_t *owner, remotepage_t *page)
+{
+   remotepage_t *first = owner->remotelist;
+   page->marker = 0;
+   for (;;) {
+      page->next = first;
+      remotepage_t *old = cmpxchg_atomicint(&owner->remotelist, first, page);
+      if (old == first) break;
+      first = old;
+   }
+}
+
+/* function: release_pagecacheimpl
+ * Releases page located in block and subblock subidx of size pgsize.
+ * The parameters are already validated. Frees block if it contains no more
+ * used pages and pgcache has still allocated pages in other blocks.
+ * If isKeepBlock is true the block is never freed (see <warm_pagecacheimpl>). */
+static inline int release_pagecacheimpl(pagecache_impl_t *pgcache, block_t *block, uint16_t subidx, pagesize_e pgsize, freepage_t *freepage, bool isKeepBlock)
+{
+   int err;
+
+   err = releasepage_block(block, pgcache, subidx, pgsize, freepage);
+   if (err) return err;
+   pgcache->sizeallocated -= pagesizeinbytes_pagecache(pgsize);
+   ++ pgcache->counter->stat.pgsize[pgsize].nrfree;
+   -- pgcache->counter->stat.pgsize[pgsize].nrused;
+
+   if (! block->nrusedpages && pgcache->sizeallocated && ! isKeepBlock) {
+      err = delete_block(block, pgcache);
+      if (err) return err;
+   }
+
+   return 0;
+}
+
+/* function: drainremote_pagecacheimpl
+ * Releases all pages other threads pushed onto <pagecache_impl_t.remotelist>.
+ * The whole list is removed with a single atomic operation and processed as one batch.
+ * If an error occurs the remaining pages are released nevertheless and the last error is returned. */
+static int drainremote_pagecacheimpl(pagecache_impl_t *pgcache)
+{
+   int err = 0;
+   remotepage_t *page = pgcache->remotelist;
+
+   if (page) {
+      for (;;) {
+         remotepage_t *old = cmpxchg_atomicint(&pgcache->remotelist, page, (remotepage_t*)0);
+         if (old == page) break;
+         page = old;
+      }
+
+      while (page) {
+         remotepage_t *next = page->next;
+         block_t *block  = align_block(page);
+         uint16_t subidx = index_subblock(page);
+         ++ pgcache->counter->stat.nrremote;
+         int err2 = release_pagecacheimpl(pgcache, block, subidx, block->pgsize[subidx], (freepage_t*)page, false);
+         if (err2) err = err2;
+         page = next;
+      }
+
+      if (err) goto ONERR;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
 
 
 // section: pagecache_impl_t
@@ -551,7 +768,7 @@ int init_pagecacheimpl(/*out*/pagecache_impl_t* pgcache)
 
 int free_pagecacheimpl(pagecache_impl_t* pgcache)
 {
-   int err = 0;
+   int err = drainremote_pagecacheimpl(pgcache);
 
    foreach (_dlist, node, cast_dlist(&pgcache->blocklist)) {
       block_t* block = align_block(node);
@@ -559,6 +776,9 @@ int free_pagecacheimpl(pagecache_impl_t* pgcache)
       if (err2) err = err2;
    }
 
+   int err2 = deletecounter_pagecacheimpl(pgcache);
+   if (err2) err = err2;
+
    if (0 != pgcache->sizeallocated) {
       pgcache->sizeallocated = 0;
       err = ENOTEMPTY;
@@ -584,6 +804,112 @@ size_t sizeallocated_pagecacheimpl(const pagecache_impl_t* pgcache)
    return pgcache->sizeallocated;
 }
 
+size_t nrhugeblocks_pagecacheimpl(const pagecache_impl_t* pgcache)
+{
+   return pgcache->nrhugeblocks;
+}
+
+// group: statistics
+
+/* function: addcounters_pagecacheimpl
+ * Adds counter to stat.
+ * The counters are written by another thread therefore they are read atomically.
+ * Peak values are not added but the larger value is kept.
+ *
+ * Unchecked Precondition:
+ * - <s_pagecacheimpl_statlock> is locked */
+static void addcounters_pagecacheimpl(const pagecache_impl_counter_t* counter, /*inout*/pagecache_impl_stat_t* stat)
+{
+   size_t nrblockalloc = loadacquire_atomicint(&counter->stat.nrblockalloc);
+   size_t nrblockfree  = loadacquire_atomicint(&counter->stat.nrblockfree);
+   // pages of first sub-block which store block_t
+   size_t nrheaderpages = (nrblockalloc - nrblockfree) * ((sizeof(block_t)+4095) / 4096);
+
+   for (unsigned pgsize = 0; pgsize < pagesize__NROF; ++pgsize) {
+      size_t nrpages = pagecache_impl_SUBBLOCKSIZE >> log2pagesizeinbytes_pagecache((pagesize_e)pgsize);
+      size_t nrused  = loadacquire_atomicint(&counter->stat.pgsize[pgsize].nrused);
+      size_t nrtotal = loadacquire_atomicint(&counter->nrsubblock[pgsize]) * nrpages;
+      if (pgsize == pagesize_4096) nrused += nrheaderpages;
+      stat->pgsize[pgsize].nralloc  += loadacquire_atomicint(&counter->stat.pgsize[pgsize].nralloc);
+      stat->pgsize[pgsize].nrfree   += loadacquire_atomicint(&counter->stat.pgsize[pgsize].nrfree);
+      stat->pgsize[pgsize].nrused   += loadacquire_atomicint(&counter->stat.pgsize[pgsize].nrused);
+      size_t peak = loadacquire_atomicint(&counter->stat.pgsize[pgsize].peakused);
+      if (peak > stat->pgsize[pgsize].peakused) stat->pgsize[pgsize].peakused = peak;
+      // counters are read one after the other (owner could change them in between)
+      stat->pgsize[pgsize].nrcached += nrtotal > nrused ? nrtotal - nrused : 0;
+   }
+
+   stat->nrremote     += loadacquire_atomicint(&counter->stat.nrremote);
+   stat->nrblockalloc += nrblockalloc;
+   stat->nrblockfree  += nrblockfree;
+}
+
+void addstat_pagecacheimpl(pagecache_impl_t* pgcache, /*inout*/pagecache_impl_stat_t* stat)
+{
+   lockstat_pagecacheimpl();
+   // the owner changes counter only if it holds the lock
+   const pagecache_impl_counter_t* counter = pgcache->counter;
+   if (counter) {
+      addcounters_pagecacheimpl(counter, stat);
+   }
+   unlockstat_pagecacheimpl();
+}
+
+void collectstat_pagecacheimpl(/*inout*/pagecache_impl_stat_t* stat)
+{
+   lockstat_pagecacheimpl();
+   foreach (_statlist, counter, cast_dlist(&s_pagecacheimpl_statlist)) {
+      addcounters_pagecacheimpl(counter, stat);
+   }
+   unlockstat_pagecacheimpl();
+}
+
+void logstat_pagecacheimpl(const pagecache_impl_stat_t* stat, uint8_t logchannel)
+{
+   PRINTF_LOG(, logchannel, log_flags_NONE, 0, "pagecache: blockalloc=%zu blockfree=%zu remote=%zu\n",
+               stat->nrblockalloc, stat->nrblockfree, stat->nrremote);
+
+   for (unsigned pgsize = 0; pgsize < pagesize__NROF; ++pgsize) {
+      if (stat->pgsize[pgsize].nralloc || stat->pgsize[pgsize].nrcached) {
+         PRINTF_LOG(, logchannel, log_flags_NONE, 0, "pagesize %zu: alloc=%zu free=%zu used=%zu peak=%zu cached=%zu\n",
+                     pagesizeinbytes_pagecache((pagesize_e)pgsize),
+                     stat->pgsize[pgsize].nralloc, stat->pgsize[pgsize].nrfree,
+                     stat->pgsize[pgsize].nrused, stat->pgsize[pgsize].peakused,
+                     stat->pgsize[pgsize].nrcached);
+      }
+   }
+}
+
+// group: config
+
+int sethugepage_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t hugepage)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(hugepage <= vmhuge_HUGETLB, ONERR, );
+
+   pgcache->hugepage = hugepage;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int setprefault_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t prefault)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(prefault <= vmprefault_LOCK, ONERR, );
+
+   pgcache->prefault = prefault;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
 // group: alloc
 
 int allocpage_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t pgsize, /*out*/struct memblock_t* page)
@@ -594,6 +920,11 @@ int allocpage_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t pgsize, /*out*/st
 
    VALIDATE_INPARAM_TEST(pgsize < pagesize__NROF, ONERR, );
 
+   if (pgcache->remotelist) {
+      // error already logged (and page allocation does not depend on it)
+      (void) drainremote_pagecacheimpl(pgcache);
+   }
+
    if (isempty_dlist(&pgcache->freeblocklist[pgsize])) {
       if (isempty_dlist(&pgcache->unusedblocklist)) {
          err = new_block(&block, pgcache);
@@ -611,6 +942,10 @@ int allocpage_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t pgsize, /*out*/st
 
    size_t pgsizeinbytes = pagesizeinbytes_pagecache(pgsize);
    pgcache->sizeallocated += pgsizeinbytes;
+   ++ pgcache->counter->stat.pgsize[pgsize].nralloc;
+   if (++ pgcache->counter->stat.pgsize[pgsize].nrused > pgcache->counter->stat.pgsize[pgsize].peakused) {
+      pgcache->counter->stat.pgsize[pgsize].peakused = pgcache->counter->stat.pgsize[pgsize].nrused;
+   }
 
    // set out param
    *page = (memblock_t) memblock_INIT(pgsizeinbytes, (uint8_t*)freepage);
@@ -630,25 +965,37 @@ int releasepage_pagecacheimpl(pagecache_impl_t *pgcache, struct memblock_t *page
       uint16_t subidx = index_subblock(page->addr);
       pagesize_e pgsize = block->pgsize[subidx];
       bool isBlockUnused = pgsize >= pagesize__NROF;
-      if (  isBlockUnused || block->owner != pgcache || page->size != pagesizeinbytes_pagecache(pgsize)
+      if (  isBlockUnused || page->size != pagesizeinbytes_pagecache(pgsize)
             || 0 != ((uintptr_t)page->addr & (page->size-1)) ) {
          err = EINVAL;
          goto ONERR;
       }
 
+      if (block->owner != pgcache) {
+         // only pages allocated by another thread could be released remotely
+         pagecache_impl_t *owner = block->owner;
+         if (!owner || block->threadcontext == tcontext_maincontext()) {
+            err = EINVAL;
+            goto ONERR;
+         }
+         // support page located on freepage
+         remotepage_t *remotepage = (remotepage_t*) page->addr;
+         *page = (memblock_t) memblock_FREE;
+         pushremote_pagecacheimpl(owner, remotepage);
+         return 0;
+      }
+
       // support page located on freepage
       freepage_t* freepage = (freepage_t*) page->addr;
-      size_t      pagesize = page->size;
       *page = (memblock_t) memblock_FREE;
 
-      err = releasepage_block(block, pgcache, subidx, pgsize, freepage);
+      err = release_pagecacheimpl(pgcache, block, subidx, pgsize, freepage, false);
       if (err) goto ONERR;
-      pgcache->sizeallocated -= pagesize;
+   }
 
-      if (! block->nrusedpages && pgcache->sizeallocated) {
-         err = delete_block(block, pgcache);
-         if (err) goto ONERR;
-      }
+   if (pgcache->remotelist) {
+      err = drainremote_pagecacheimpl(pgcache);
+      if (err) goto ONERR;
    }
 
    return 0;
@@ -664,6 +1011,9 @@ int emptycache_pagecacheimpl(pagecache_impl_t* pgcache)
    int err;
    uint8_t const nrbits = log2_int(pagecache_impl_BLOCKSIZE);
 
+   err = drainremote_pagecacheimpl(pgcache);
+   if (err) goto ONERR;
+
    foreach (_dlist, node, cast_dlist(&pgcache->blocklist)) {
       dlist_node_t *n = node;
       block_t* block = align_ptr((block_t*)n, nrbits);
@@ -679,6 +1029,60 @@ ONERR:
    return err;
 }
 
+int warm_pagecacheimpl(pagecache_impl_t* pgcache, uint8_t pgsize, size_t nrpages)
+{
+   int err;
+   int err2;
+   void       *pagelist = 0;   // allocated pages linked by their first pointer
+   size_t      nralloc  = 0;
+   size_t      nrfree   = 0;
+   size_t      peakused;
+   vmprefault_e prefault = pgcache->prefault == vmprefault_LOCK ? vmprefault_LOCK : vmprefault_POPULATE;
+
+   VALIDATE_INPARAM_TEST(pgsize < pagesize__NROF, ONERR, );
+
+   // counter is mapped during first allocation
+   peakused = pgcache->counter ? pgcache->counter->stat.pgsize[pgsize].peakused : 0;
+
+   err = 0;
+   for (; nralloc < nrpages; ++nralloc) {
+      memblock_t page;
+      err = allocpage_pagecacheimpl(pgcache, pgsize, &page);
+      if (err) break;
+      err = prefault_vmpage(cast_vmpage(&page, ), prefault);
+      *(void**)page.addr = pagelist;
+      pagelist = page.addr;
+      if (err) {
+         ++ nralloc;
+         break;
+      }
+   }
+
+   // pages are owned by pgcache ==> release them directly
+   // blocks which become empty are kept (else warming would be undone)
+   while (pagelist) {
+      freepage_t *freepage = pagelist;
+      pagelist = *(void**)pagelist;
+      err2 = release_pagecacheimpl(pgcache, align_block(freepage), index_subblock(freepage), (pagesize_e)pgsize, freepage, true);
+      if (err2) err = err2;
+      ++ nrfree;
+   }
+
+   // warming is not counted
+   if (pgcache->counter) {
+      pgcache->counter->stat.pgsize[pgsize].nralloc -= nralloc;
+      pgcache->counter->stat.pgsize[pgsize].nrfree  -= nrfree;
+      pgcache->counter->stat.pgsize[pgsize].peakused = peakused;
+   }
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
 
 // group: test
 
@@ -959,6 +1363,7 @@ static int check_new_block(pagecache_impl_t* pgcache, block_t* block)
    TEST(0 == ((uintptr_t)block & ((uintptr_t)pagecache_impl_BLOCKSIZE-1)));
    TEST(pgcache == block->owner);
    TEST(tcontext_maincontext() == block->threadcontext);
+   TEST(vmhuge_NONE == block->hugepage);
    TEST(isinlist_dlist(&block->blocknode));
    TEST(isinlist_dlist(&block->unusedblocknode));
    for (unsigned i=0; i<pagesize__NROF; ++i) {
@@ -1042,6 +1447,9 @@ static int check_isfree(pagecache_impl_t* pgcache)
       TEST( 0 == pgcache->freeblocklist[i].last);
    }
    TEST( 0 == pgcache->sizeallocated);
+   TEST( 0 == pgcache->remotelist);
+   TEST( 0 == pgcache->prefault);
+   TEST( 0 == pgcache->nrhugeblocks);
 
    return 0;
 ONERR:
@@ -1053,9 +1461,13 @@ static int test_block_lifetime(void)
    pagecache_impl_t pgcache = pagecache_impl_FREE;
    block_t        * block[11] = {0};
 
-   // TEST new_block
+   // TEST new_block: maps counter before first block
+   TEST( 0 == pgcache.counter);
    for (unsigned i=0; i<lengthof(block); ++i) {
       TEST( 0 == new_block(&block[i], &pgcache));
+      TEST( 0 != pgcache.counter);
+      TEST( i+1 == pgcache.counter->stat.nrblockalloc);
+      TEST( i+1 == pgcache.counter->nrsubblock[pagesize_4096]);
       TEST( 0 == check_new_block(&pgcache, block[i]));
       TEST( 0 == pgcache.sizeallocated);
       TEST( 0 == check_list(&pgcache, i+1, block));
@@ -1067,6 +1479,8 @@ static int test_block_lifetime(void)
    // TEST delete_block
    for (unsigned i=0; i<lengthof(block); ++i) {
       TEST( 0 == delete_block(block[i], &pgcache));
+      TEST( i+1 == pgcache.counter->stat.nrblockfree);
+      TEST( lengthof(block)-1-i == pgcache.counter->nrsubblock[pagesize_4096]);
       TEST( 0 == pgcache.sizeallocated);
       TEST( 0 == check_list(&pgcache, lengthof(block)-1-i, block+1+i));
       // check VM
@@ -1093,6 +1507,12 @@ static int test_block_lifetime(void)
       TEST( 0 == check_isfree(&pgcache));
    }
 
+   // TEST free_pagecacheimpl: unmaps counter
+   TEST( 0 != pgcache.counter);
+   TEST( 0 == free_pagecacheimpl(&pgcache));
+   TEST( 0 == pgcache.counter);
+   TEST( 0 == check_isfree(&pgcache));
+
    return 0;
 ONERR:
    free_pagecacheimpl(&pgcache);
@@ -1515,6 +1935,14 @@ static int test_query(void)
    pgcache.sizeallocated = 0;
    TEST(0 == sizeallocated_pagecacheimpl(&pgcache));
 
+   // TEST nrhugeblocks_pagecacheimpl
+   for (size_t i = 1; i; i <<= 1) {
+      pgcache.nrhugeblocks = i;
+      TEST(i == nrhugeblocks_pagecacheimpl(&pgcache));
+   }
+   pgcache.nrhugeblocks = 0;
+   TEST(0 == nrhugeblocks_pagecacheimpl(&pgcache));
+
    // reset
    TEST(0 == free_pagecacheimpl(&pgcache));
 
@@ -1816,6 +2244,437 @@ ONERR:
    return EINVAL;
 }
 
+struct child_releasepage_t {
+   memblock_t* page;
+   unsigned    nrpages;
+};
+static int child_releasepage(void *_param)
+{
+   struct child_releasepage_t * param = _param;
+   pagecache_impl_t pgcache = pagecache_impl_FREE;
+   for (unsigned i=0; i<param->nrpages; ++i) {
+      if (releasepage_pagecacheimpl(&pgcache, &param->page[i])) return EINVAL;
+   }
+   return isfree_pagecacheimpl(&pgcache) ? 0 : EINVAL;
+}
+
+static int releaseinthread(memblock_t* page, unsigned nrpages)
+{
+   struct child_releasepage_t param = { page, nrpages };
+   thread_t * thread = 0;
+   TEST(0 == new_thread(&thread, &child_releasepage, &param));
+   TEST(0 == join_thread(thread));
+   TEST(0 == returncode_thread(thread));
+   TEST(0 == delete_thread(&thread));
+   return 0;
+ONERR:
+   delete_thread(&thread);
+   return EINVAL;
+}
+
+static size_t lengthremotelist(pagecache_impl_t* pgcache)
+{
+   size_t len = 0;
+   for (remotepage_t* page = pgcache->remotelist; page; page = page->next) {
+      ++ len;
+   }
+   return len;
+}
+
+static int test_hugepage(void)
+{
+   pagecache_impl_t  pgcache = pagecache_impl_FREE;
+   memblock_t        page    = memblock_FREE;
+   block_t         * block;
+
+   // prepare
+   TEST(0 == init_pagecacheimpl(&pgcache));
+
+   // TEST sethugepage_pagecacheimpl
+   for (unsigned huge = vmhuge_NONE; huge <= vmhuge_HUGETLB; ++huge) {
+      TEST( 0 == sethugepage_pagecacheimpl(&pgcache, (uint8_t) huge));
+      TEST( huge == pgcache.hugepage);
+   }
+
+   // TEST sethugepage_pagecacheimpl: EINVAL
+   TEST( EINVAL == sethugepage_pagecacheimpl(&pgcache, vmhuge_HUGETLB+1));
+   TEST( vmhuge_HUGETLB == pgcache.hugepage);
+
+   // TEST new_block: counts blocks backed by huge pages
+   for (unsigned huge = vmhuge_NONE; huge <= vmhuge_HUGETLB; ++huge) {
+      TEST( 0 == sethugepage_pagecacheimpl(&pgcache, (uint8_t) huge));
+      TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_4096, &page));
+      block = align_block(page.addr);
+      TEST( block->hugepage <= huge);
+      TEST( (block->hugepage != vmhuge_NONE) == pgcache.nrhugeblocks);
+      if (block->hugepage == vmhuge_HUGETLB) {
+         vmpage_t pageblock = vmpage_INIT(pagecache_impl_BLOCKSIZE, (uint8_t*) block);
+         TEST( 1 == ismapped_vm(&pageblock, accessmode_RDWR));
+      }
+      // TEST delete_block: decrements nrhugeblocks
+      TEST( 0 == releasepage_pagecacheimpl(&pgcache, &page));
+      TEST( 0 == emptycache_pagecacheimpl(&pgcache));
+      TEST( 0 == pgcache.nrhugeblocks);
+   }
+
+   // unprepare
+   TEST(0 == free_pagecacheimpl(&pgcache));
+
+   return 0;
+ONERR:
+   free_pagecacheimpl(&pgcache);
+   return EINVAL;
+}
+
+/* function: nrresident_page
+ * Returns the number of pages of size <pagesize_vm> of the memory block which are mapped to physical memory. */
+static size_t nrresident_page(uint8_t* addr, size_t size)
+{
+   size_t        nrresident = 0;
+   unsigned char vec[256];
+   const size_t  nrpages = size / pagesize_vm();
+
+   if (nrpages > sizeof(vec) || mincore(addr, size, vec)) return SIZE_MAX;
+
+   for (size_t i = 0; i < nrpages; ++i) {
+      nrresident += (vec[i] & 1);
+   }
+
+   return nrresident;
+}
+
+static int test_prefault(void)
+{
+   pagecache_impl_t  pgcache = pagecache_impl_FREE;
+   memblock_t        page    = memblock_FREE;
+   memblock_t        pages[3*pagecache_impl_SUBBLOCKSIZE/16384];
+   memblock_t        fullblock[pagecache_impl_NRSUBBLOCKS-1];
+   size_t            nrblockalloc;
+   uint8_t         * subblock;
+   const size_t      nrvmpages = pagecache_impl_SUBBLOCKSIZE / pagesize_vm();
+
+   // prepare
+   TEST(0 == init_pagecacheimpl(&pgcache));
+
+   // TEST setprefault_pagecacheimpl
+   for (unsigned prefault = vmprefault_NONE; prefault <= vmprefault_LOCK; ++prefault) {
+      TEST( 0 == setprefault_pagecacheimpl(&pgcache, (uint8_t) prefault));
+      TEST( prefault == pgcache.prefault);
+   }
+   TEST( 0 == setprefault_pagecacheimpl(&pgcache, vmprefault_NONE));
+   TEST( vmprefault_NONE == pgcache.prefault);
+
+   // TEST setprefault_pagecacheimpl: EINVAL
+   TEST( EINVAL == setprefault_pagecacheimpl(&pgcache, vmprefault_LOCK+1));
+   TEST( vmprefault_NONE == pgcache.prefault);
+
+   // TEST allocpage_pagecacheimpl: vmprefault_NONE does not prefault a new sub-block
+   TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_65536, &page));
+   subblock = (uint8_t*) ((uintptr_t)page.addr & ~(uintptr_t)(pagecache_impl_SUBBLOCKSIZE-1));
+   TEST( subblock != (uint8_t*)align_block(page.addr));
+   TEST( nrvmpages > nrresident_page(subblock, pagecache_impl_SUBBLOCKSIZE));
+   TEST( 0 == releasepage_pagecacheimpl(&pgcache, &page));
+   TEST( 0 == emptycache_pagecacheimpl(&pgcache));
+
+   // TEST allocpage_pagecacheimpl: vmprefault_POPULATE, vmprefault_LOCK prefault new sub-blocks
+   for (unsigned prefault = vmprefault_POPULATE; prefault <= vmprefault_LOCK; ++prefault) {
+      TEST( 0 == setprefault_pagecacheimpl(&pgcache, (uint8_t) prefault));
+      TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_65536, &page));
+      subblock = (uint8_t*) ((uintptr_t)page.addr & ~(uintptr_t)(pagecache_impl_SUBBLOCKSIZE-1));
+      TEST( nrvmpages == nrresident_page(subblock, pagecache_impl_SUBBLOCKSIZE));
+      // sub-block 0 which contains the block header is also prefaulted
+      block_t * block = align_block(page.addr);
+      TEST( nrvmpages == nrresident_page((uint8_t*)block, pagecache_impl_SUBBLOCKSIZE));
+      TEST( 0 == releasepage_pagecacheimpl(&pgcache, &page));
+      TEST( 0 == emptycache_pagecacheimpl(&pgcache));
+   }
+   TEST( 0 == setprefault_pagecacheimpl(&pgcache, vmprefault_NONE));
+
+   // TEST warm_pagecacheimpl: pages are prefaulted and cached
+   TEST( 0 == warm_pagecacheimpl(&pgcache, pagesize_16384, lengthof(pages)));
+   TEST( 0 == sizeallocated_pagecacheimpl(&pgcache));
+   TEST( 1 == pgcache.counter->stat.nrblockalloc - pgcache.counter->stat.nrblockfree);
+   TEST( 0 == pgcache.counter->stat.pgsize[pagesize_16384].nralloc);
+   TEST( 0 == pgcache.counter->stat.pgsize[pagesize_16384].nrfree);
+   TEST( 0 == pgcache.counter->stat.pgsize[pagesize_16384].peakused);
+   for (unsigned i = 0; i < lengthof(pages); ++i) {
+      TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_16384, &pages[i]));
+      TEST( 16384/pagesize_vm() == nrresident_page(pages[i].addr, pages[i].size));
+   }
+   for (unsigned i = 0; i < lengthof(pages); ++i) {
+      TEST( 0 == releasepage_pagecacheimpl(&pgcache, &pages[i]));
+   }
+   TEST( 1 == pgcache.counter->stat.nrblockalloc - pgcache.counter->stat.nrblockfree);
+   TEST( 0 == emptycache_pagecacheimpl(&pgcache));
+
+   // TEST warm_pagecacheimpl: newly acquired block is kept if current block is full
+   for (unsigned i = 0; i < lengthof(fullblock); ++i) {
+      TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_1MB, &fullblock[i]));
+   }
+   nrblockalloc = pgcache.counter->stat.nrblockalloc;
+   TEST( 1 == nrblockalloc - pgcache.counter->stat.nrblockfree);
+   TEST( 0 == warm_pagecacheimpl(&pgcache, pagesize_16384, lengthof(pages)));
+   TEST( nrblockalloc+1 == pgcache.counter->stat.nrblockalloc);
+   TEST( 2 == pgcache.counter->stat.nrblockalloc - pgcache.counter->stat.nrblockfree);
+   TEST( lengthof(fullblock)*pagecache_impl_SUBBLOCKSIZE == sizeallocated_pagecacheimpl(&pgcache));
+   for (unsigned i = 0; i < lengthof(pages); ++i) {
+      TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_16384, &pages[i]));
+      TEST( 16384/pagesize_vm() == nrresident_page(pages[i].addr, pages[i].size));
+   }
+   TEST( nrblockalloc+1 == pgcache.counter->stat.nrblockalloc);
+   for (unsigned i = 0; i < lengthof(pages); ++i) {
+      TEST( 0 == releasepage_pagecacheimpl(&pgcache, &pages[i]));
+   }
+   for (unsigned i = 0; i < lengthof(fullblock); ++i) {
+      TEST( 0 == releasepage_pagecacheimpl(&pgcache, &fullblock[i]));
+   }
+   TEST( 0 == sizeallocated_pagecacheimpl(&pgcache));
+   TEST( 0 == emptycache_pagecacheimpl(&pgcache));
+
+   // TEST warm_pagecacheimpl: nrpages == 0
+   TEST( 0 == warm_pagecacheimpl(&pgcache, pagesize_4096, 0));
+   TEST( 0 == sizeallocated_pagecacheimpl(&pgcache));
+
+   // TEST warm_pagecacheimpl: EINVAL
+   TEST( EINVAL == warm_pagecacheimpl(&pgcache, pagesize__NROF, 1));
+
+   // unprepare
+   TEST(0 == free_pagecacheimpl(&pgcache));
+
+   return 0;
+ONERR:
+   free_pagecacheimpl(&pgcache);
+   return EINVAL;
+}
+
+static int test_remote(void)
+{
+   pagecache_impl_t  pgcache = pagecache_impl_FREE;
+   remotepage_t      rpage[4];
+   memblock_t        page[pagesize__NROF];
+   block_t         * block;
+   size_t            sizeallocated;
+
+   // prepare
+   TEST(0 == init_pagecacheimpl(&pgcache));
+
+   // TEST pushremote_pagecacheimpl
+   for (unsigned i=0; i<lengthof(rpage); ++i) {
+      rpage[i].marker = (void*)1;
+      pushremote_pagecacheimpl(&pgcache, &rpage[i]);
+      TEST( &rpage[i] == pgcache.remotelist);
+      TEST( 0 == rpage[i].marker);
+      TEST( (i ? &rpage[i-1] : 0) == rpage[i].next);
+      TEST( i+1 == lengthremotelist(&pgcache));
+   }
+   pgcache.remotelist = 0;
+
+   // TEST releasepage_pagecacheimpl: other thread pushes pages onto remotelist
+   sizeallocated = 0;
+   for (pagesize_e pgsize = 0; pgsize < pagesize__NROF; ++pgsize) {
+      TEST(0 == allocpage_pagecacheimpl(&pgcache, pgsize, &page[pgsize]));
+      sizeallocated += page[pgsize].size;
+   }
+   block = align_block(page[0].addr);
+   TEST( pagesize__NROF == block->nrusedpages);
+   TEST( 0 == releaseinthread(page, lengthof(page)));
+   for (pagesize_e pgsize = 0; pgsize < pagesize__NROF; ++pgsize) {
+      TEST( 1 == isfree_memblock(&page[pgsize]));
+   }
+   // pages are not released by other thread
+   TEST( pagesize__NROF == lengthremotelist(&pgcache));
+   TEST( sizeallocated  == pgcache.sizeallocated);
+   TEST( pagesize__NROF == block->nrusedpages);
+
+   // TEST allocpage_pagecacheimpl: drains remotelist
+   TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_4096, &page[0]));
+   TEST( 0 == pgcache.remotelist);
+   TEST( 4096 == pgcache.sizeallocated);
+   TEST( 1 == block->nrusedpages);
+
+   // TEST releasepage_pagecacheimpl: drains remotelist
+   TEST( 0 == releaseinthread(page, 1));
+   TEST( 1 == lengthremotelist(&pgcache));
+   TEST( 4096 == pgcache.sizeallocated);
+   TEST( 0 == releasepage_pagecacheimpl(&pgcache, &page[0]/*memblock_FREE*/));
+   TEST( 0 == pgcache.remotelist);
+   TEST( 0 == pgcache.sizeallocated);
+   TEST( 0 == block->nrusedpages);
+
+   // TEST emptycache_pagecacheimpl: drains remotelist
+   TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_65536, &page[0]));
+   TEST( 0 == releaseinthread(page, 1));
+   TEST( 1 == lengthremotelist(&pgcache));
+   TEST( 0 == emptycache_pagecacheimpl(&pgcache));
+   TEST( 0 == check_isfree(&pgcache));
+
+   // TEST free_pagecacheimpl: drains remotelist
+   TEST( 0 == allocpage_pagecacheimpl(&pgcache, pagesize_1MB, &page[0]));
+   TEST( 0 == releaseinthread(page, 1));
+   TEST( 1 == lengthremotelist(&pgcache));
+   TEST( 0 == free_pagecacheimpl(&pgcache));
+   TEST( 0 == check_isfree(&pgcache));
+
+   return 0;
+ONERR:
+   free_pagecacheimpl(&pgcache);
+   return EINVAL;
+}
+
+static int check_stat(const pagecache_impl_stat_t* stat, pagesize_e pgsize, size_t nralloc, size_t nrfree, size_t nrused, size_t peakused, size_t nrcached)
+{
+   for (unsigned i = 0; i < pagesize__NROF; ++i) {
+      if (i == pgsize) continue;
+      TEST(0 == stat->pgsize[i].nralloc);
+      TEST(0 == stat->pgsize[i].nrfree);
+      TEST(0 == stat->pgsize[i].nrused);
+      TEST(0 == stat->pgsize[i].peakused);
+      TEST(0 == stat->pgsize[i].nrcached);
+   }
+   TEST(nralloc  == stat->pgsize[pgsize].nralloc);
+   TEST(nrfree   == stat->pgsize[pgsize].nrfree);
+   TEST(nrused   == stat->pgsize[pgsize].nrused);
+   TEST(peakused == stat->pgsize[pgsize].peakused);
+   TEST(nrcached == stat->pgsize[pgsize].nrcached);
+
+   return 0;
+ONERR:
+   return EINVAL;
+}
+
+static int test_statistics(void)
+{
+   pagecache_impl_t      pgcache = pagecache_impl_FREE;
+   pagecache_impl_t      pgcache2 = pagecache_impl_FREE;
+   pagecache_impl_stat_t stat    = pagecache_impl_stat_FREE;
+   pagecache_impl_stat_t stat2;
+   memblock_t            page[8];
+   unsigned const        nrpages = pagecache_impl_SUBBLOCKSIZE / 4096;
+   unsigned const        nrheaderpages = (unsigned) ((sizeof(block_t)+4095) / 4096);
+   uint8_t             * logbuffer;
+   size_t                logsize1;
+   size_t                logsize2;
+
+   // prepare
+   TEST(0 == init_pagecacheimpl(&pgcache));
+
+   // TEST pagecache_impl_stat_FREE
+   TEST(0 == check_stat(&stat, pagesize_4096, 0, 0, 0, 0, 0));
+   TEST(0 == stat.nrremote);
+   TEST(0 == stat.nrblockalloc);
+   TEST(0 == stat.nrblockfree);
+
+   // TEST addstat_pagecacheimpl: init_pagecacheimpl clears counters
+   addstat_pagecacheimpl(&pgcache, &stat);
+   TEST(0 == check_stat(&stat, pagesize_4096, 0, 0, 0, 0, 0));
+   TEST(0 == stat.nrremote);
+   TEST(0 == stat.nrblockalloc);
+   TEST(0 == stat.nrblockfree);
+
+   // TEST addstat_pagecacheimpl: allocpage_pagecacheimpl is counted
+   for (unsigned i = 0; i < lengthof(page); ++i) {
+      TEST(0 == allocpage_pagecacheimpl(&pgcache, pagesize_4096, &page[i]));
+   }
+   addstat_pagecacheimpl(&pgcache, &stat);
+   TEST(0 == check_stat(&stat, pagesize_4096, 8, 0, 8, 8, nrpages-nrheaderpages-8));
+   TEST(0 == stat.nrremote);
+   TEST(1 == stat.nrblockalloc);
+   TEST(0 == stat.nrblockfree);
+
+   // TEST addstat_pagecacheimpl: releasepage_pagecacheimpl is counted
+   for (unsigned i = 0; i < 3; ++i) {
+      TEST(0 == releasepage_pagecacheimpl(&pgcache, &page[i]));
+   }
+   stat = (pagecache_impl_stat_t) pagecache_impl_stat_FREE;
+   addstat_pagecacheimpl(&pgcache, &stat);
+   TEST(0 == check_stat(&stat, pagesize_4096, 8, 3, 5, 8, nrpages-nrheaderpages-5));
+
+   // TEST addstat_pagecacheimpl: adds to values in stat (peak values are not added)
+   addstat_pagecacheimpl(&pgcache, &stat);
+   TEST(0 == check_stat(&stat, pagesize_4096, 16, 6, 10, 8, 2*(nrpages-nrheaderpages-5)));
+   TEST(0 == stat.nrremote);
+   TEST(2 == stat.nrblockalloc);
+   TEST(0 == stat.nrblockfree);
+
+   // TEST addstat_pagecacheimpl: pages released by other thread
+   TEST(0 == releaseinthread(&page[3], 2));
+   TEST(0 == allocpage_pagecacheimpl(&pgcache, pagesize_1MB, &page[0]));
+   stat = (pagecache_impl_stat_t) pagecache_impl_stat_FREE;
+   addstat_pagecacheimpl(&pgcache, &stat);
+   TEST(1 == stat.pgsize[pagesize_1MB].nralloc);
+   TEST(1 == stat.pgsize[pagesize_1MB].nrused);
+   TEST(1 == stat.pgsize[pagesize_1MB].peakused);
+   TEST(0 == stat.pgsize[pagesize_1MB].nrcached);
+   stat.pgsize[pagesize_1MB].nralloc  = 0;
+   stat.pgsize[pagesize_1MB].nrused   = 0;
+   stat.pgsize[pagesize_1MB].peakused = 0;
+   TEST(0 == check_stat(&stat, pagesize_4096, 8, 5, 3, 8, nrpages-nrheaderpages-3));
+   TEST(2 == stat.nrremote);
+   TEST(1 == stat.nrblockalloc);
+   TEST(0 == stat.nrblockfree);
+
+   // TEST addstat_pagecacheimpl: blocks returned to OS are counted
+   TEST(0 == releasepage_pagecacheimpl(&pgcache, &page[0]));
+   for (unsigned i = 5; i < lengthof(page); ++i) {
+      TEST(0 == releasepage_pagecacheimpl(&pgcache, &page[i]));
+   }
+   TEST(0 == emptycache_pagecacheimpl(&pgcache));
+   stat = (pagecache_impl_stat_t) pagecache_impl_stat_FREE;
+   addstat_pagecacheimpl(&pgcache, &stat);
+   TEST(1 == stat.pgsize[pagesize_1MB].nrfree);
+   TEST(0 == stat.pgsize[pagesize_1MB].nrused);
+   memset(&stat.pgsize[pagesize_1MB], 0, sizeof(stat.pgsize[pagesize_1MB]));
+   TEST(0 == check_stat(&stat, pagesize_4096, 8, 8, 0, 8, 0));
+   TEST(2 == stat.nrremote);
+   TEST(1 == stat.nrblockalloc);
+   TEST(1 == stat.nrblockfree);
+
+   // TEST logstat_pagecacheimpl
+   GETBUFFER_ERRLOG(&logbuffer, &logsize1);
+   logstat_pagecacheimpl(&stat, log_channel_ERR);
+   GETBUFFER_ERRLOG(&logbuffer, &logsize2);
+   TEST(logsize2 > logsize1);
+   TEST(0 != strstr((char*)logbuffer+logsize1, "pagecache: blockalloc=1 blockfree=1 remote=2\n"));
+   TEST(0 != strstr((char*)logbuffer+logsize1, "pagesize 4096: alloc=8 free=8 used=0 peak=8 cached=0\n"));
+   TEST(0 == strstr((char*)logbuffer+logsize1, "pagesize 256:"));
+   TRUNCATEBUFFER_ERRLOG(logsize1);
+
+   // TEST collectstat_pagecacheimpl: adds counters of every pagecache_impl_t
+   TEST(0 == init_pagecacheimpl(&pgcache2));
+   stat = (pagecache_impl_stat_t) pagecache_impl_stat_FREE;
+   collectstat_pagecacheimpl(&stat);
+   TEST(stat.pgsize[pagesize_4096].nralloc >= 8);
+   TEST(stat.nrblockalloc >= 1);
+   TEST(0 == allocpage_pagecacheimpl(&pgcache2, pagesize_4096, &page[0]));
+   TEST(0 == allocpage_pagecacheimpl(&pgcache2, pagesize_4096, &page[1]));
+   stat2 = (pagecache_impl_stat_t) pagecache_impl_stat_FREE;
+   collectstat_pagecacheimpl(&stat2);
+   TEST(stat2.pgsize[pagesize_4096].nralloc == stat.pgsize[pagesize_4096].nralloc + 2);
+   TEST(stat2.pgsize[pagesize_4096].nrused  == stat.pgsize[pagesize_4096].nrused + 2);
+   TEST(stat2.pgsize[pagesize_4096].nrcached == stat.pgsize[pagesize_4096].nrcached + nrpages-nrheaderpages-2);
+   TEST(stat2.pgsize[pagesize_4096].peakused >= 2);
+   TEST(stat2.nrblockalloc == stat.nrblockalloc + 1);
+   TEST(0 == releasepage_pagecacheimpl(&pgcache2, &page[0]));
+   TEST(0 == releasepage_pagecacheimpl(&pgcache2, &page[1]));
+
+   // TEST collectstat_pagecacheimpl: free_pagecacheimpl removes counters
+   TEST(0 == free_pagecacheimpl(&pgcache2));
+   stat2 = (pagecache_impl_stat_t) pagecache_impl_stat_FREE;
+   collectstat_pagecacheimpl(&stat2);
+   TEST(stat2.pgsize[pagesize_4096].nralloc == stat.pgsize[pagesize_4096].nralloc);
+   TEST(stat2.pgsize[pagesize_4096].nrused  == stat.pgsize[pagesize_4096].nrused);
+   TEST(stat2.nrblockalloc == stat.nrblockalloc);
+
+   // unprepare
+   TEST(0 == free_pagecacheimpl(&pgcache));
+
+   return 0;
+ONERR:
+   free_pagecacheimpl(&pgcache);
+   free_pagecacheimpl(&pgcache2);
+   return EINVAL;
+}
+
 int unittest_memory_pagecacheimpl()
 {
    if (test_block_llhelper())    goto ONERR;
@@ -1826,6 +2685,10 @@ int unittest_memory_pagecacheimpl()
    if (test_query())       goto ONERR;
    if (test_alloc())       goto ONERR;
    if (test_cache())       goto ONERR;
+   if (test_hugepage())    goto ONERR;
+   if (test_prefault())    goto ONERR;
+   if (test_remote())      goto ONERR;
+   if (test_statistics())  goto ONERR;
 
    return 0;
 ONERR:
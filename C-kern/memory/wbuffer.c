@@ -17,8 +17,13 @@
 #include "C-kern/konfig.h"
 #include "C-kern/api/memory/wbuffer.h"
 #include "C-kern/api/err.h"
+#include "C-kern/api/math/int/log2.h"
+#include "C-kern/api/math/int/power2.h"
 #include "C-kern/api/memory/memblock.h"
 #include "C-kern/api/memory/memstream.h"
+#include "C-kern/api/memory/memvec.h"
+#include "C-kern/api/memory/pagecache_macros.h"
+#include "C-kern/api/memory/vm.h"
 #include "C-kern/api/string/cstring.h"
 #include "C-kern/api/test/errortimer.h"
 #include "C-kern/api/test/mm/err_macros.h"
@@ -38,6 +43,148 @@
 static test_errortimer_t   s_wbuffer_errtimer = test_errortimer_FREE ;
 #endif
 
+
+// section: wbuffer_page_t
+
+/* struct: wbuffer_page_t
+ * Header of a page of <wbuffer_chain_t>.
+ * The written bytes start after the header and end at <used>. */
+typedef struct wbuffer_page_t {
+   /* variable: next
+    * Next page in chain. */
+   struct wbuffer_page_t * next;
+   /* variable: used
+    * Number of written bytes. Not valid for <wbuffer_chain_t.last>,
+    * its number is computed from <wbuffer_t.next>. */
+   size_t                  used;
+   /* variable: pgsize
+    * Size of this page. Value of type <pagesize_e>. */
+   uint8_t                 pgsize;
+} wbuffer_page_t;
+
+// group: config
+
+/* define: wbuffer_page_MAXDATASIZE
+ * Maximum number of bytes which can be stored in a single page. */
+#define wbuffer_page_MAXDATASIZE \
+         (pagesizeinbytes_pagecache(pagesize_1MB) - sizeof(wbuffer_page_t))
+
+// group: query
+
+/* function: data_wbufferpage
+ * Returns start address of written bytes. */
+static inline uint8_t* data_wbufferpage(wbuffer_page_t* page)
+{
+   return (uint8_t*)page + sizeof(wbuffer_page_t);
+}
+
+/* function: end_wbufferpage
+ * Returns end address of page. */
+static inline uint8_t* end_wbufferpage(wbuffer_page_t* page)
+{
+   return (uint8_t*)page + pagesizeinbytes_pagecache(page->pgsize);
+}
+
+/* function: used_wbufferpage
+ * Returns number of written bytes of page. The last page uses memstr->next to compute it. */
+static inline size_t used_wbufferpage(const wbuffer_chain_t* chain, wbuffer_page_t* page, const memstream_t* memstr)
+{
+   return page == chain->last ? (size_t) (memstr->next - data_wbufferpage(page)) : page->used;
+}
+
+// group: lifetime
+
+/* function: new_wbufferpage
+ * Allocates a page of size chain->pgsize or larger if freesize bytes do not fit. */
+static int new_wbufferpage(wbuffer_chain_t* chain, size_t freesize, /*out*/wbuffer_page_t** page)
+{
+   int err;
+   uint8_t    pgsize = chain->pgsize;
+   memblock_t mblock;
+
+   if (freesize > pagesizeinbytes_pagecache(pgsize) - sizeof(wbuffer_page_t)) {
+      if (freesize > wbuffer_page_MAXDATASIZE) {
+         err = ENOMEM;
+         TRACEOUTOFMEM_ERRLOG(freesize, err);
+         goto ONERR;
+      }
+      pgsize = pagesizefrombytes_pagecache(makepowerof2_int(freesize + sizeof(wbuffer_page_t)));
+   }
+
+   if (! PROCESS_testerrortimer(&s_wbuffer_errtimer, &err)) {
+      err = ALLOC_PAGECACHE(pgsize, &mblock);
+   }
+   if (err) goto ONERR;
+
+   wbuffer_page_t* newpage = (wbuffer_page_t*) mblock.addr;
+   newpage->next   = 0;
+   newpage->used   = 0;
+   newpage->pgsize = pgsize;
+
+   // set out
+   *page = newpage;
+
+   return 0;
+ONERR:
+   return err;
+}
+
+/* function: delete_wbufferpage
+ * Returns page to <pagecache_t>. */
+static int delete_wbufferpage(wbuffer_page_t* page)
+{
+   memblock_t mblock = memblock_INIT(pagesizeinbytes_pagecache(page->pgsize), (uint8_t*)page);
+   return RELEASE_PAGECACHE(&mblock);
+}
+
+
+// section: wbuffer_chain_t
+
+// group: lifetime
+
+int init_wbufferchain(/*out*/wbuffer_chain_t* chain, uint8_t pgsize)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(pgsize < pagesize__NROF
+                         && pagesizeinbytes_pagecache(pgsize) > 2*sizeof(wbuffer_page_t), ONERR, );
+
+   *chain = (wbuffer_chain_t) wbuffer_chain_FREE;
+   chain->pgsize = pgsize;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_wbufferchain(wbuffer_chain_t* chain)
+{
+   int err = 0;
+   wbuffer_page_t* next = chain->first;
+
+   while (next) {
+      wbuffer_page_t* page = next;
+      next = page->next;
+      int err2 = delete_wbufferpage(page);
+      if (err2) err = err2;
+   }
+
+   chain->first = 0;
+   chain->last  = 0;
+   chain->size  = 0;
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+
+// section: wbuffer_t
+
 // group: interface implementation
 
 /* function: alloc_cstring_wbuffer
@@ -177,6 +324,161 @@ static size_t size_static_wbuffer(void * impl, const memstream_t * memstr)
    return (size_t) (memstr->next - (uint8_t*)impl) ;
 }
 
+/* function: alloc_vmreserve_wbuffer
+ * Commits more memory of impl (<vmreserve_t>) and returns additional memory in memstr.
+ * The start address of the buffer never changes. */
+static int alloc_vmreserve_wbuffer(void * impl, size_t freesize, /*inout*/memstream_t * memstr)
+{
+   int err;
+   vmreserve_t* vmres = impl;
+
+   size_t   used    = (size_t) (memstr->next - vmres->addr);
+   size_t   memsize = vmres->size >= freesize
+                    ? 2 * vmres->size
+                    : vmres->size + freesize;
+
+   if (vmres->reserved - used < freesize) {
+      err = ENOMEM;
+      TRACEOUTOFMEM_ERRLOG(freesize, err);
+      goto ONERR;
+   }
+
+   if (memsize > vmres->reserved || memsize <= vmres->size) {
+      memsize = vmres->reserved;
+   }
+
+   if (! PROCESS_testerrortimer(&s_wbuffer_errtimer, &err)) {
+      err = grow_vmreserve(vmres, memsize);
+   }
+   if (err) goto ONERR;
+
+   *memstr = (memstream_t) memstream_INIT(vmres->addr + used, vmres->addr + vmres->size);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: shrink_vmreserve_wbuffer
+ * Sets memstr to whole committed memory of impl (<vmreserve_t>) except for the first keepsize bytes.
+ * Committed pages beyond keepsize are returned to the OS. */
+static int shrink_vmreserve_wbuffer(void * impl, size_t keepsize, /*inout*/memstream_t * memstr)
+{
+   int err;
+   vmreserve_t* vmres = impl;
+
+   if ((size_t)(memstr->next - vmres->addr) < keepsize) {
+      err = EINVAL;
+      goto ONERR;
+   }
+
+   err = shrink_vmreserve(vmres, keepsize);
+   if (err) goto ONERR;
+
+   *memstr = (memstream_t) memstream_INIT(vmres->addr + keepsize, vmres->addr + vmres->size);
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: size_vmreserve_wbuffer
+ * Returns number of appended bytes of impl (<vmreserve_t>). */
+static size_t size_vmreserve_wbuffer(void * impl, const memstream_t * memstr)
+{
+   vmreserve_t* vmres = impl;
+   return (size_t) (memstr->next - vmres->addr);
+}
+
+/* function: alloc_chain_wbuffer
+ * Appends a new page to impl (<wbuffer_chain_t>) and returns its free memory in memstr.
+ * The unused memory of the last page in memstr is not used anymore. */
+static int alloc_chain_wbuffer(void * impl, size_t freesize, /*inout*/memstream_t * memstr)
+{
+   int err;
+   wbuffer_chain_t* chain = impl;
+   wbuffer_page_t * page;
+
+   err = new_wbufferpage(chain, freesize, &page);
+   if (err) goto ONERR;
+
+   if (chain->last) {
+      chain->last->used = (size_t) (memstr->next - data_wbufferpage(chain->last));
+      chain->last->next = page;
+      chain->size += chain->last->used;
+   } else {
+      chain->first = page;
+   }
+   chain->last = page;
+
+   *memstr = (memstream_t) memstream_INIT(data_wbufferpage(page), end_wbufferpage(page));
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: shrink_chain_wbuffer
+ * Sets memstr to the free part of the page of impl (<wbuffer_chain_t>) which contains the last of the first keepsize bytes.
+ * All following pages are released. The first page is never released. */
+static int shrink_chain_wbuffer(void * impl, size_t keepsize, /*inout*/memstream_t * memstr)
+{
+   int err = 0;
+   wbuffer_chain_t* chain  = impl;
+   wbuffer_page_t * page   = chain->first;
+   size_t           offset = 0;
+
+   if (!page) {
+      if (keepsize) {
+         err = EINVAL;
+         goto ONERR;
+      }
+      return 0;
+   }
+
+   for (;;) {
+      size_t used = used_wbufferpage(chain, page, memstr);
+      if (keepsize - offset <= used) break;
+      if (page == chain->last) {
+         err = EINVAL;
+         goto ONERR;
+      }
+      offset += used;
+      page = page->next;
+   }
+
+   wbuffer_page_t* next = page->next;
+   page->next  = 0;
+   chain->last = page;
+   chain->size = offset;
+   *memstr = (memstream_t) memstream_INIT(data_wbufferpage(page) + (keepsize - offset), end_wbufferpage(page));
+
+   while (next) {
+      wbuffer_page_t* delpage = next;
+      next = delpage->next;
+      int err2 = delete_wbufferpage(delpage);
+      if (err2) err = err2;
+   }
+
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+/* function: size_chain_wbuffer
+ * Returns number of appended bytes of impl (<wbuffer_chain_t>). */
+static size_t size_chain_wbuffer(void * impl, const memstream_t * memstr)
+{
+   wbuffer_chain_t* chain = impl;
+   return chain->last ? chain->size + (size_t) (memstr->next - data_wbufferpage(chain->last)) : 0;
+}
+
 // group: global variables
 
 wbuffer_it  g_wbuffer_cstring  = { &alloc_cstring_wbuffer, &shrink_cstring_wbuffer, &size_cstring_wbuffer } ;
@@ -185,6 +487,43 @@ wbuffer_it  g_wbuffer_memblock = { &alloc_memblock_wbuffer, &shrink_memblock_wbu
 
 wbuffer_it  g_wbuffer_static   = { &alloc_static_wbuffer, &shrink_static_wbuffer, &size_static_wbuffer  } ;
 
+wbuffer_it  g_wbuffer_vmreserve = { &alloc_vmreserve_wbuffer, &shrink_vmreserve_wbuffer, &size_vmreserve_wbuffer  } ;
+
+wbuffer_it  g_wbuffer_chain    = { &alloc_chain_wbuffer, &shrink_chain_wbuffer, &size_chain_wbuffer  } ;
+
+// group: query
+
+size_t getmemvec_wbuffer(const wbuffer_t* wbuf, size_t startseg, /*inout*/struct memvec_t* memvec)
+{
+   size_t nrseg = 0;
+   size_t count = 0;
+
+   if (wbuf->iimpl == &g_wbuffer_chain) {
+      const wbuffer_chain_t* chain = wbuf->impl;
+      for (wbuffer_page_t* page = chain->first; page; page = page->next) {
+         size_t used = used_wbufferpage(chain, page, (const memstream_t*)wbuf);
+         if (!used) continue;
+         if (nrseg >= startseg && count < memvec->size) {
+            memvec->vec[count++] = (memblock_t) memblock_INIT(used, data_wbufferpage(page));
+         }
+         ++ nrseg;
+      }
+
+   } else {
+      size_t size = size_wbuffer(wbuf);
+      if (size) {
+         if (0 == startseg && memvec->size) {
+            memvec->vec[count++] = (memblock_t) memblock_INIT(size, wbuf->next - size);
+         }
+         ++ nrseg;
+      }
+   }
+
+   memvec->size = count;
+
+   return nrseg;
+}
+
 // group: change
 
 int appendcopy_wbuffer(wbuffer_t* wbuf, size_t buffer_size, const uint8_t* buffer)
@@ -201,7 +540,26 @@ int appendcopy_wbuffer(wbuffer_t* wbuf, size_t buffer_size, const uint8_t* buffe
          memcpy(wbuf->next, buffer, free);
          wbuf->next += free;
       }
-      const size_t missing = buffer_size - free;
+      size_t missing = buffer_size - free;
+      if (wbuf->iimpl == &g_wbuffer_chain && missing > wbuffer_page_MAXDATASIZE) {
+         // copy in chunks which fit into a single page
+         const size_t oldsize = size_wbuffer(wbuf) - free;
+         buffer  += free;
+         for (;;) {
+            size_t chunk = missing < wbuffer_page_MAXDATASIZE ? missing : wbuffer_page_MAXDATASIZE;
+            err = wbuf->iimpl->alloc(wbuf->impl, chunk, (memstream_t*)wbuf);
+            if (err) {
+               (void) wbuf->iimpl->shrink(wbuf->impl, oldsize, (memstream_t*)wbuf);
+               goto ONERR;
+            }
+            memcpy(wbuf->next, buffer, chunk);
+            wbuf->next += chunk;
+            buffer  += chunk;
+            missing -= chunk;
+            if (!missing) break;
+         }
+         return 0;
+      }
       err = wbuf->iimpl->alloc(wbuf->impl, missing, (memstream_t*)wbuf);
       if (err) {
          wbuf->next -= free; // remove partially copied content
@@ -241,6 +599,16 @@ static int test_variables(void)
    TEST(g_wbuffer_static.shrink == &shrink_static_wbuffer) ;
    TEST(g_wbuffer_static.size   == &size_static_wbuffer) ;
 
+   // TEST g_wbuffer_vmreserve
+   TEST(g_wbuffer_vmreserve.alloc  == &alloc_vmreserve_wbuffer) ;
+   TEST(g_wbuffer_vmreserve.shrink == &shrink_vmreserve_wbuffer) ;
+   TEST(g_wbuffer_vmreserve.size   == &size_vmreserve_wbuffer) ;
+
+   // TEST g_wbuffer_chain
+   TEST(g_wbuffer_chain.alloc  == &alloc_chain_wbuffer) ;
+   TEST(g_wbuffer_chain.shrink == &shrink_chain_wbuffer) ;
+   TEST(g_wbuffer_chain.size   == &size_chain_wbuffer) ;
+
    return 0 ;
 ONERR:
    return EINVAL ;
@@ -301,6 +669,22 @@ static int test_initfree(void)
       TEST(wbuf.iimpl == &g_wbuffer_static);
    }
 
+   // TEST wbuffer_INIT_VMRESERVE
+   vmreserve_t vmres = { buffer, 10, 100 };
+   wbuf = (wbuffer_t) wbuffer_INIT_VMRESERVE(&vmres);
+   TEST(wbuf.next  == buffer);
+   TEST(wbuf.end   == buffer + 10);
+   TEST(wbuf.impl  == &vmres);
+   TEST(wbuf.iimpl == &g_wbuffer_vmreserve);
+
+   // TEST wbuffer_INIT_CHAIN
+   wbuffer_chain_t chain = wbuffer_chain_FREE;
+   wbuf = (wbuffer_t) wbuffer_INIT_CHAIN(&chain);
+   TEST(wbuf.next  == 0);
+   TEST(wbuf.end   == 0);
+   TEST(wbuf.impl  == &chain);
+   TEST(wbuf.iimpl == &g_wbuffer_chain);
+
    // TEST wbuffer_INIT_OTHER
    wbuf = (wbuffer_t) wbuffer_INIT_OTHER(sizeof(buffer), buffer, (void*)88, (void*)99);
    TEST(wbuf.next == buffer);
@@ -516,6 +900,289 @@ ONERR:
    return EINVAL ;
 }
 
+static int test_vmreserve_adapter(void)
+{
+   vmreserve_t vmres  = vmreserve_FREE;
+   size_t      pgsize = pagesize_vm();
+   wbuffer_t   wbuf;
+
+   // prepare
+   TEST(0 == init_vmreserve(&vmres, pgsize, 16*pgsize));
+   wbuf = (wbuffer_t) wbuffer_INIT_VMRESERVE(&vmres);
+   uint8_t * const addr = vmres.addr;
+
+   // TEST size_vmreserve_wbuffer
+   for (size_t i = 0; i <= pgsize; i += pgsize/4) {
+      wbuf.next = addr + i;
+      TEST(i == size_vmreserve_wbuffer(wbuf.impl, cast_memstream(&wbuf,)));
+   }
+
+   // TEST alloc_vmreserve_wbuffer: doubles size, start address never changes
+   memset(addr, 1, pgsize);
+   wbuf.next = addr + pgsize;
+   for (size_t s = 2*pgsize; s <= 16*pgsize; s *= 2) {
+      TEST(0 == alloc_vmreserve_wbuffer(wbuf.impl, 1, cast_memstream(&wbuf,)));
+      TEST(vmres.addr == addr);
+      TEST(vmres.size == s);
+      TEST(wbuf.next  == addr + s/2);
+      TEST(wbuf.end   == addr + s);
+      memset(wbuf.next, 2, (size_t) (wbuf.end - wbuf.next));
+      wbuf.next = wbuf.end;
+      TEST(1 == addr[0]);
+      TEST(1 == addr[pgsize-1]);
+   }
+
+   // TEST alloc_vmreserve_wbuffer: ENOMEM (reserved range exhausted)
+   TEST(ENOMEM == alloc_vmreserve_wbuffer(wbuf.impl, 1, cast_memstream(&wbuf,)));
+   TEST(ENOMEM == alloc_vmreserve_wbuffer(wbuf.impl, SIZE_MAX, cast_memstream(&wbuf,)));
+   TEST(vmres.size == 16*pgsize);
+   TEST(wbuf.next  == addr + 16*pgsize);
+   TEST(wbuf.end   == addr + 16*pgsize);
+
+   // TEST shrink_vmreserve_wbuffer: returns memory to OS
+   TEST(0 == shrink_vmreserve_wbuffer(wbuf.impl, pgsize+1, cast_memstream(&wbuf,)));
+   TEST(vmres.addr == addr);
+   TEST(vmres.size == 2*pgsize);
+   TEST(wbuf.next  == addr + pgsize + 1);
+   TEST(wbuf.end   == addr + 2*pgsize);
+   TEST(1 == addr[0]);
+   TEST(2 == addr[pgsize]);
+
+   // TEST shrink_vmreserve_wbuffer: EINVAL
+   TEST(EINVAL == shrink_vmreserve_wbuffer(wbuf.impl, pgsize+2, cast_memstream(&wbuf,)));
+   TEST(vmres.size == 2*pgsize);
+   TEST(wbuf.next  == addr + pgsize + 1);
+   TEST(wbuf.end   == addr + 2*pgsize);
+
+   // TEST alloc_vmreserve_wbuffer: freesize > size
+   TEST(0 == alloc_vmreserve_wbuffer(wbuf.impl, 5*pgsize, cast_memstream(&wbuf,)));
+   TEST(vmres.size == 7*pgsize);
+   TEST(wbuf.next  == addr + pgsize + 1);
+   TEST(wbuf.end   == addr + 7*pgsize);
+
+   // TEST alloc_vmreserve_wbuffer: size is capped to reserved
+   wbuf.next = wbuf.end;
+   TEST(0 == alloc_vmreserve_wbuffer(wbuf.impl, 9*pgsize, cast_memstream(&wbuf,)));
+   TEST(vmres.size == 16*pgsize);
+   TEST(wbuf.next  == addr + 7*pgsize);
+   TEST(wbuf.end   == addr + 16*pgsize);
+
+   // TEST alloc_vmreserve_wbuffer: simulated ERROR
+   TEST(0 == shrink_vmreserve_wbuffer(wbuf.impl, 0, cast_memstream(&wbuf,)));
+   TEST(vmres.size == 0);
+   init_testerrortimer(&s_wbuffer_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == alloc_vmreserve_wbuffer(wbuf.impl, 1, cast_memstream(&wbuf,)));
+   TEST(vmres.size == 0);
+   TEST(wbuf.next  == addr);
+   TEST(wbuf.end   == addr);
+
+   // unprepare
+   TEST(0 == free_vmreserve(&vmres));
+
+   return 0;
+ONERR:
+   free_vmreserve(&vmres);
+   return EINVAL;
+}
+
+static int test_chain_adapter(void)
+{
+   wbuffer_chain_t chain = wbuffer_chain_FREE;
+   wbuffer_t       wbuf  = wbuffer_INIT_CHAIN(&chain);
+   size_t const    datasize = 4096 - sizeof(wbuffer_page_t);
+   size_t const    sizepgcache = SIZEALLOCATED_PAGECACHE();
+   memvec_T(4)     memvec;
+   uint8_t       * buffer = 0;
+   uint8_t       * addr;
+
+   // TEST wbuffer_chain_FREE
+   TEST(0 == chain.first);
+   TEST(0 == chain.last);
+   TEST(0 == chain.size);
+   TEST(0 == chain.pgsize);
+
+   // TEST init_wbufferchain
+   memset(&chain, 255, sizeof(chain));
+   TEST(0 == init_wbufferchain(&chain, pagesize_4096));
+   TEST(0 == chain.first);
+   TEST(0 == chain.last);
+   TEST(0 == chain.size);
+   TEST(pagesize_4096 == chain.pgsize);
+
+   // TEST init_wbufferchain: EINVAL
+   TEST(EINVAL == init_wbufferchain(&chain, pagesize__NROF));
+   TEST(pagesize_4096 == chain.pgsize);
+
+   // TEST size_chain_wbuffer: empty chain
+   TEST(0 == size_chain_wbuffer(wbuf.impl, cast_memstream(&wbuf,)));
+
+   // TEST shrink_chain_wbuffer: empty chain
+   TEST(0 == shrink_chain_wbuffer(wbuf.impl, 0, cast_memstream(&wbuf,)));
+   TEST(EINVAL == shrink_chain_wbuffer(wbuf.impl, 1, cast_memstream(&wbuf,)));
+   TEST(0 == wbuf.next);
+   TEST(0 == wbuf.end);
+
+   // TEST alloc_chain_wbuffer: first page
+   TEST(0 == alloc_chain_wbuffer(wbuf.impl, 1, cast_memstream(&wbuf,)));
+   TEST(0 != chain.first);
+   TEST(chain.first == chain.last);
+   TEST(0 == chain.size);
+   TEST(wbuf.next == (uint8_t*)chain.first + sizeof(wbuffer_page_t));
+   TEST(wbuf.end  == (uint8_t*)chain.first + 4096);
+   TEST(sizepgcache + 4096 == SIZEALLOCATED_PAGECACHE());
+
+   // TEST appendbytes_wbuffer: bytes are never moved
+   addr = wbuf.next;
+   for (unsigned i = 0; i < datasize; ++i) {
+      TEST(0 == appendbyte_wbuffer(&wbuf, (uint8_t)i));
+   }
+   TEST(datasize == size_wbuffer(&wbuf));
+   TEST(0 == appendbytes_wbuffer(&wbuf, 100, &buffer));
+   TEST(chain.first != chain.last);
+   TEST(chain.first->next == chain.last);
+   TEST(datasize == chain.size);
+   TEST(datasize == chain.first->used);
+   TEST(buffer == (uint8_t*)chain.last + sizeof(wbuffer_page_t));
+   TEST(datasize+100 == size_wbuffer(&wbuf));
+   for (unsigned i = 0; i < datasize; ++i) {
+      TEST((uint8_t)i == addr[i]);
+   }
+   memset(buffer, 1, 100);
+
+   // TEST getmemvec_wbuffer: chain
+   memvec.size = lengthof(memvec.vec);
+   TEST(2 == getmemvec_wbuffer(&wbuf, 0, cast_memvec(&memvec)));
+   TEST(2 == memvec.size);
+   TEST(addr   == memvec.vec[0].addr);
+   TEST(datasize == memvec.vec[0].size);
+   TEST(buffer == memvec.vec[1].addr);
+   TEST(100    == memvec.vec[1].size);
+
+   // TEST getmemvec_wbuffer: startseg
+   memvec.size = lengthof(memvec.vec);
+   TEST(2 == getmemvec_wbuffer(&wbuf, 1, cast_memvec(&memvec)));
+   TEST(1 == memvec.size);
+   TEST(buffer == memvec.vec[0].addr);
+   TEST(100    == memvec.vec[0].size);
+   memvec.size = lengthof(memvec.vec);
+   TEST(2 == getmemvec_wbuffer(&wbuf, 2, cast_memvec(&memvec)));
+   TEST(0 == memvec.size);
+
+   // TEST getmemvec_wbuffer: capacity of memvec too small
+   memvec.size = 1;
+   TEST(2 == getmemvec_wbuffer(&wbuf, 0, cast_memvec(&memvec)));
+   TEST(1 == memvec.size);
+   TEST(addr == memvec.vec[0].addr);
+
+   // TEST alloc_chain_wbuffer: larger page if freesize does not fit
+   TEST(0 == appendbytes_wbuffer(&wbuf, 5000, &buffer));
+   TEST(pagesize_8192 == chain.last->pgsize);
+   TEST(buffer == (uint8_t*)chain.last + sizeof(wbuffer_page_t));
+   TEST(datasize+100+5000 == size_wbuffer(&wbuf));
+   TEST(datasize+100 == chain.size);
+   TEST(sizepgcache + 2*4096 + 8192 == SIZEALLOCATED_PAGECACHE());
+
+   // TEST alloc_chain_wbuffer: ENOMEM
+   TEST(ENOMEM == alloc_chain_wbuffer(wbuf.impl, wbuffer_page_MAXDATASIZE+1, cast_memstream(&wbuf,)));
+   TEST(datasize+100+5000 == size_wbuffer(&wbuf));
+
+   // TEST alloc_chain_wbuffer: simulated ERROR
+   init_testerrortimer(&s_wbuffer_errtimer, 1, ENOMEM);
+   TEST(ENOMEM == alloc_chain_wbuffer(wbuf.impl, 1, cast_memstream(&wbuf,)));
+   TEST(datasize+100+5000 == size_wbuffer(&wbuf));
+   TEST(sizepgcache + 2*4096 + 8192 == SIZEALLOCATED_PAGECACHE());
+
+   // TEST shrink_chain_wbuffer: EINVAL
+   TEST(EINVAL == shrink_chain_wbuffer(wbuf.impl, datasize+100+5001, cast_memstream(&wbuf,)));
+   TEST(datasize+100+5000 == size_wbuffer(&wbuf));
+
+   // TEST shrink_chain_wbuffer: releases following pages
+   TEST(0 == shrink_chain_wbuffer(wbuf.impl, datasize+50, cast_memstream(&wbuf,)));
+   TEST(chain.first->next == chain.last);
+   TEST(0 == chain.last->next);
+   TEST(datasize+50 == size_wbuffer(&wbuf));
+   TEST(wbuf.next == (uint8_t*)chain.last + sizeof(wbuffer_page_t) + 50);
+   TEST(wbuf.end  == (uint8_t*)chain.last + 4096);
+   TEST(sizepgcache + 2*4096 == SIZEALLOCATED_PAGECACHE());
+
+   // TEST shrink_chain_wbuffer: keepsize at end of page
+   TEST(0 == shrink_chain_wbuffer(wbuf.impl, datasize, cast_memstream(&wbuf,)));
+   TEST(chain.first == chain.last);
+   TEST(0 == chain.size);
+   TEST(wbuf.next == wbuf.end);
+   TEST(datasize == size_wbuffer(&wbuf));
+   TEST(sizepgcache + 4096 == SIZEALLOCATED_PAGECACHE());
+
+   // TEST clear_wbuffer: first page is kept
+   clear_wbuffer(&wbuf);
+   TEST(0 != chain.first);
+   TEST(chain.first == chain.last);
+   TEST(0 == size_wbuffer(&wbuf));
+   TEST(wbuf.next == addr);
+   memvec.size = lengthof(memvec.vec);
+   TEST(0 == getmemvec_wbuffer(&wbuf, 0, cast_memvec(&memvec)));
+   TEST(0 == memvec.size);
+
+   // TEST appendcopy_wbuffer: content larger than largest page is split
+   {
+      size_t   bigsize = 2*wbuffer_page_MAXDATASIZE + datasize + 10;
+      memblock_t big = memblock_FREE;
+      TEST(0 == ALLOC_MM(bigsize, &big));
+      for (size_t i = 0; i < bigsize; ++i) {
+         big.addr[i] = (uint8_t) (i * 13);
+      }
+      TEST(0 == appendbyte_wbuffer(&wbuf, 99));
+      TEST(0 == appendcopy_wbuffer(&wbuf, bigsize, big.addr));
+      TEST(1+bigsize == size_wbuffer(&wbuf));
+      memvec.size = lengthof(memvec.vec);
+      TEST(4 == getmemvec_wbuffer(&wbuf, 0, cast_memvec(&memvec)));
+      TEST(4 == memvec.size);
+      TEST(datasize == memvec.vec[0].size);
+      TEST(wbuffer_page_MAXDATASIZE == memvec.vec[1].size);
+      TEST(wbuffer_page_MAXDATASIZE == memvec.vec[2].size);
+      TEST(bigsize+1-datasize-2*wbuffer_page_MAXDATASIZE == memvec.vec[3].size);
+      TEST(99 == memvec.vec[0].addr[0]);
+      size_t off = 0;
+      for (unsigned v = 0; v < memvec.size; ++v) {
+         for (size_t i = (v == 0); i < memvec.vec[v].size; ++i, ++off) {
+            TEST((uint8_t)(off * 13) == memvec.vec[v].addr[i]);
+         }
+      }
+      TEST(off == bigsize);
+      TEST(0 == FREE_MM(&big));
+   }
+
+   // TEST free_wbufferchain
+   TEST(0 == free_wbufferchain(&chain));
+   TEST(0 == chain.first);
+   TEST(0 == chain.last);
+   TEST(0 == chain.size);
+   TEST(pagesize_4096 == chain.pgsize);
+   TEST(sizepgcache == SIZEALLOCATED_PAGECACHE());
+   TEST(0 == free_wbufferchain(&chain));
+
+   // TEST getmemvec_wbuffer: contiguous buffer
+   uint8_t static_buffer[10];
+   wbuf = (wbuffer_t) wbuffer_INIT_STATIC(sizeof(static_buffer), static_buffer);
+   memvec.size = lengthof(memvec.vec);
+   TEST(0 == getmemvec_wbuffer(&wbuf, 0, cast_memvec(&memvec)));
+   TEST(0 == memvec.size);
+   TEST(0 == appendbytes_wbuffer(&wbuf, 7, &buffer));
+   memvec.size = lengthof(memvec.vec);
+   TEST(1 == getmemvec_wbuffer(&wbuf, 0, cast_memvec(&memvec)));
+   TEST(1 == memvec.size);
+   TEST(static_buffer == memvec.vec[0].addr);
+   TEST(7 == memvec.vec[0].size);
+   memvec.size = lengthof(memvec.vec);
+   TEST(1 == getmemvec_wbuffer(&wbuf, 1, cast_memvec(&memvec)));
+   TEST(0 == memvec.size);
+
+   return 0;
+ONERR:
+   free_wbufferchain(&chain);
+   return EINVAL;
+}
+
 static int test_query(void)
 {
    uint8_t     buffer[256] = { 0 } ;
@@ -1014,6 +1681,8 @@ int unittest_memory_wbuffer()
    if (test_cstring_adapter())   goto ONERR;
    if (test_memblock_adapter())  goto ONERR;
    if (test_static_adapter())    goto ONERR;
+   if (test_vmreserve_adapter()) goto ONERR;
+   if (test_chain_adapter())     goto ONERR;
    if (test_query())             goto ONERR;
    if (test_update())            goto ONERR;
    if (test_other_impl())        goto ONERR;
@@ -302,6 +302,31 @@ struct memblock_t threadstack_threadstack(thread_stack_t* st)
    return (memblock_t) memblock_INIT(sizestack, (uint8_t*)st + offset);
 }
 
+// group: prefault
+
+int prefault_threadstack(thread_stack_t* st, uint8_t prefault)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(prefault <= vmprefault_LOCK, ONERR, );
+
+   vmpage_t     vars = vmpage_INIT(get_sizevars(st), (uint8_t*)st);
+   memblock_t   sigstack = signalstack_threadstack(st);
+   memblock_t   stack    = threadstack_threadstack(st);
+
+   err = prefault_vmpage(&vars, prefault);
+   if (err) goto ONERR;
+   err = prefault_vmpage(cast_vmpage(&sigstack, ), prefault);
+   if (err) goto ONERR;
+   err = prefault_vmpage(cast_vmpage(&stack, ), prefault);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
 // group: static-memory
 
 int allocstatic_threadstack(thread_stack_t* st, ilog_t* initlog, size_t bytesize, /*out*/struct memblock_t* memblock)
@@ -664,6 +689,56 @@ ONERR:
    return EINVAL;
 }
 
+static bool isresident_memblock(const memblock_t * mblock)
+{
+   unsigned char vec[128];
+   const size_t  nrpages = mblock->size / sys_pagesize_vm();
+
+   if (nrpages > sizeof(vec) || mincore(mblock->addr, mblock->size, vec)) return false;
+
+   for (size_t i = 0; i < nrpages; ++i) {
+      if (! (vec[i] & 1)) return false;
+   }
+
+   return true;
+}
+
+static int test_prefault(void)
+{
+   thread_stack_t* st = 0;
+   ilog_t  *  defaultlog = GETWRITER0_LOG();
+
+   for (uint8_t prefault = vmprefault_NONE; prefault <= vmprefault_LOCK; ++prefault) {
+      // prepare
+      TEST(0 == new_threadstack(&st, defaultlog, 2012, 0, 0));
+      memblock_t vars     = memblock_INIT(get_sizevars(st), (uint8_t*)st);
+      memblock_t sigstack = signalstack_threadstack(st);
+      memblock_t stack    = threadstack_threadstack(st);
+      TEST(! isresident_memblock(&stack));
+
+      // TEST prefault_threadstack
+      TEST(0 == prefault_threadstack(st, prefault));
+      if (prefault != vmprefault_NONE) {
+         TEST(isresident_memblock(&vars));
+         TEST(isresident_memblock(&sigstack));
+      }
+      TEST((prefault != vmprefault_NONE) == isresident_memblock(&stack));
+
+      // unprepare
+      TEST(0 == delete_threadstack(&st, defaultlog));
+   }
+
+   // TEST prefault_threadstack: EINVAL
+   TEST(0 == new_threadstack(&st, defaultlog, 2012, 0, 0));
+   TEST(EINVAL == prefault_threadstack(st, vmprefault_LOCK+1));
+   TEST(0 == delete_threadstack(&st, defaultlog));
+
+   return 0;
+ONERR:
+   delete_threadstack(&st, defaultlog);
+   return EINVAL;
+}
+
 int unittest_platform_task_thread_stack()
 {
    int err;
@@ -671,6 +746,7 @@ int unittest_platform_task_thread_stack()
    err = test_initfree();
    if (!err) err = test_query();
    if (!err) err = test_memory();
+   if (!err) err = test_prefault();
 
    return err;
 }
@@ -23,6 +23,7 @@
 #include "C-kern/api/memory/memblock.h"
 #include "C-kern/api/memory/mm/mm_macros.h"
 #ifdef KONFIG_UNITTEST
+#include "C-kern/api/io/filesystem/file.h"
 #include "C-kern/api/test/unittest.h"
 #endif
 
@@ -522,6 +523,86 @@ ONERR:
    return err;
 }
 
+int initalignedhuge_vmpage(/*out*/vmpage_t * vmpage, size_t powerof2_size_in_bytes, vmhuge_e mode, /*out*/vmhuge_e * huge)
+{
+   int err;
+   const bool ishugesize = (0 == (powerof2_size_in_bytes & (vm_HUGEPAGESIZE-1)));
+
+   *vmpage = (vmpage_t) vmpage_FREE;
+
+   VALIDATE_INPARAM_TEST(mode <= vmhuge_HUGETLB, ONERR,);
+   VALIDATE_INPARAM_TEST(powerof2_size_in_bytes >= pagesize_vm(), ONERR,);
+   VALIDATE_INPARAM_TEST(ispowerof2_int(powerof2_size_in_bytes), ONERR,);
+   VALIDATE_INPARAM_TEST(2*powerof2_size_in_bytes > powerof2_size_in_bytes, ONERR,);
+
+#ifdef MAP_HUGETLB
+   if (mode == vmhuge_HUGETLB && ishugesize) {
+      // reserve address range of double size and map huge pages at aligned address into it
+      const size_t size2    = 2 * powerof2_size_in_bytes;
+      uint8_t *    reserved = mmap(0, size2, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+      if (reserved != MAP_FAILED) {
+         uint8_t * aligned = (uint8_t*) (((uintptr_t)reserved + (powerof2_size_in_bytes-1)) & ~(uintptr_t)(powerof2_size_in_bytes-1));
+         uint8_t * end     = aligned + powerof2_size_in_bytes;
+         void *    mapped  = mmap(aligned, powerof2_size_in_bytes, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED|MAP_HUGETLB, -1, 0);
+         if (mapped != MAP_FAILED) {
+            if (aligned != reserved) (void) munmap(reserved, (size_t) (aligned - reserved));
+            if (end != reserved + size2) (void) munmap(end, (size_t) (reserved + size2 - end));
+            vmpage->addr = aligned;
+            vmpage->size = powerof2_size_in_bytes;
+            *huge = vmhuge_HUGETLB;
+            return 0;
+         }
+         (void) munmap(reserved, size2);
+      }
+   }
+#endif
+
+   err = initaligned_vmpage(vmpage, powerof2_size_in_bytes);
+   if (err) goto ONERR;
+
+   *huge = vmhuge_NONE;
+#ifdef MADV_HUGEPAGE
+   if (mode != vmhuge_NONE && ishugesize) {
+      if (0 == madvise(vmpage->addr, vmpage->size, MADV_HUGEPAGE)) {
+         *huge = vmhuge_ADVISE;
+      }
+   }
+#endif
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int initfile_vmpage(/*out*/vmpage_t * vmpage, sys_iochannel_t fd, size_t size_in_bytes)
+{
+   int err;
+   const size_t   pgsize       = pagesize_vm();
+   size_t         aligned_size = (size_in_bytes + (pgsize-1)) & ~(pgsize-1);
+
+   VALIDATE_INPARAM_TEST(size_in_bytes > 0, ONERR,);
+   VALIDATE_INPARAM_TEST(aligned_size >= size_in_bytes, ONERR,);
+
+   void * mapped_pages = mmap(0, aligned_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+   if (mapped_pages == MAP_FAILED) {
+      err = errno;
+      TRACESYSCALL_ERRLOG("mmap", err);
+      PRINTINT_ERRLOG(fd);
+      PRINTSIZE_ERRLOG(aligned_size);
+      goto ONERR;
+   }
+
+   vmpage->addr = mapped_pages;
+   vmpage->size = aligned_size;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
 int free_vmpage(vmpage_t * vmpage)
 {
    int err;
@@ -659,6 +740,176 @@ ONERR:
 }
 
 
+// section: vmreserve_t
+
+// group: lifetime
+
+int init_vmreserve(/*out*/vmreserve_t * vmres, size_t size_in_bytes, size_t reserve_in_bytes)
+{
+   int err;
+   const size_t   pgsize   = pagesize_vm();
+   size_t         size     = (size_in_bytes + (pgsize-1)) & ~(pgsize-1);
+   size_t         reserved = (reserve_in_bytes + (pgsize-1)) & ~(pgsize-1);
+
+   VALIDATE_INPARAM_TEST(reserve_in_bytes > 0, ONERR,);
+   VALIDATE_INPARAM_TEST(reserved >= reserve_in_bytes, ONERR,);
+   VALIDATE_INPARAM_TEST(size_in_bytes <= reserve_in_bytes, ONERR,);
+
+   uint8_t * addr = mmap(0, reserved, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+   if (addr == MAP_FAILED) {
+      err = errno;
+      TRACESYSCALL_ERRLOG("mmap", err);
+      PRINTSIZE_ERRLOG(reserved);
+      goto ONERR;
+   }
+
+   if (size && mprotect(addr, size, PROT_READ|PROT_WRITE)) {
+      err = errno;
+      TRACESYSCALL_ERRLOG("mprotect", err);
+      PRINTSIZE_ERRLOG(size);
+      (void) munmap(addr, reserved);
+      goto ONERR;
+   }
+
+   vmres->addr     = addr;
+   vmres->size     = size;
+   vmres->reserved = reserved;
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int free_vmreserve(vmreserve_t * vmres)
+{
+   int err;
+   vmpage_t vmpage = vmpage_INIT(vmres->reserved, vmres->addr);
+
+   *vmres = (vmreserve_t) vmreserve_FREE;
+
+   err = free_vmpage(&vmpage);
+   if (err) goto ONERR;
+
+   return 0;
+ONERR:
+   TRACEEXITFREE_ERRLOG(err);
+   return err;
+}
+
+// group: change
+
+int grow_vmreserve(vmreserve_t * vmres, size_t size_in_bytes)
+{
+   int err;
+
+   if (size_in_bytes > vmres->reserved) {
+      return ENOMEM; // no LOGGING
+   }
+
+   const size_t pgsize = pagesize_vm();
+   size_t aligned_size = (size_in_bytes + (pgsize-1)) & ~(pgsize-1);
+
+   VALIDATE_INPARAM_TEST(aligned_size >= vmres->size, ONERR,);
+
+   if (aligned_size > vmres->size) {
+      if (mprotect(vmres->addr + vmres->size, aligned_size - vmres->size, PROT_READ|PROT_WRITE)) {
+         err = errno;
+         TRACESYSCALL_ERRLOG("mprotect", err);
+         PRINTPTR_ERRLOG(vmres->addr + vmres->size);
+         PRINTSIZE_ERRLOG(aligned_size - vmres->size);
+         goto ONERR;
+      }
+
+      vmres->size = aligned_size;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+int shrink_vmreserve(vmreserve_t * vmres, size_t size_in_bytes)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(size_in_bytes <= vmres->size, ONERR,);
+
+   const size_t pgsize = pagesize_vm();
+   size_t aligned_size = (size_in_bytes + (pgsize-1)) & ~(pgsize-1);
+
+   if (aligned_size < vmres->size) {
+      uint8_t * addr = vmres->addr + aligned_size;
+      size_t    size = vmres->size - aligned_size;
+
+      if (madvise(addr, size, MADV_DONTNEED)) {
+         err = errno;
+         TRACESYSCALL_ERRLOG("madvise", err);
+         PRINTPTR_ERRLOG(addr);
+         PRINTSIZE_ERRLOG(size);
+         goto ONERR;
+      }
+
+      if (mprotect(addr, size, PROT_NONE)) {
+         err = errno;
+         TRACESYSCALL_ERRLOG("mprotect", err);
+         PRINTPTR_ERRLOG(addr);
+         PRINTSIZE_ERRLOG(size);
+         goto ONERR;
+      }
+
+      vmres->size = aligned_size;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
+// section: vmpage_t
+
+// group: prefault
+
+int prefault_vmpage(const vmpage_t * vmpage, vmprefault_e mode)
+{
+   int err;
+
+   VALIDATE_INPARAM_TEST(mode <= vmprefault_LOCK, ONERR, PRINTINT_ERRLOG(mode));
+
+   if (! vmpage->size || mode == vmprefault_NONE) return 0;
+
+   if (mode == vmprefault_LOCK) {
+      if (mlock(vmpage->addr, vmpage->size)) {
+         err = errno;
+         TRACESYSCALL_ERRLOG("mlock", err);
+         PRINTPTR_ERRLOG(vmpage->addr);
+         PRINTSIZE_ERRLOG(vmpage->size);
+         goto ONERR;
+      }
+      return 0;
+   }
+
+#ifdef MADV_POPULATE_WRITE
+   if (0 == madvise(vmpage->addr, vmpage->size, MADV_POPULATE_WRITE)) return 0;
+   // not supported by kernel (EINVAL) ==> fall back to writing
+#endif
+
+   const size_t pgsize = pagesize_vm();
+   for (size_t offset = 0; offset < vmpage->size; offset += pgsize) {
+      volatile uint8_t * addr = vmpage->addr + offset;
+      *addr = *addr;
+   }
+
+   return 0;
+ONERR:
+   TRACEEXIT_ERRLOG(err);
+   return err;
+}
+
+
 #ifdef KONFIG_UNITTEST
 
 static int test_functions(void)
@@ -1018,6 +1269,45 @@ static int test_vmpage(void)
    TEST(EINVAL == initaligned_vmpage(&page, ~(SIZE_MAX/2)));
    TEST(1 == isfree_vmpage(&page));
 
+   // TEST initalignedhuge_vmpage
+   for (vmhuge_e mode = vmhuge_NONE; mode <= vmhuge_HUGETLB; ++mode) {
+      for (size_t size = pagesize_vm(); size <= 16*vm_HUGEPAGESIZE; size *= 2) {
+         vmhuge_e huge = (vmhuge_e) -1;
+         TEST(0 == initalignedhuge_vmpage(&page, size, mode, &huge));
+         TEST(1 == ismapped_vm(&page, accessmode_RDWR));
+         TEST(0 != page.addr);
+         TEST(0 == ((uintptr_t)page.addr % size))
+         TEST(size == page.size);
+         TEST(huge <= mode);
+         if (size < vm_HUGEPAGESIZE) {
+            TEST(vmhuge_NONE == huge);
+         }
+         // memory is usable
+         page.addr[0] = 1;
+         page.addr[size-1] = 2;
+         unpage = page;
+         TEST(0 == free_vmpage(&unpage));
+         TEST(1 == isunmapped_vm(&page));
+      }
+   }
+
+   // TEST initalignedhuge_vmpage: EINVAL
+   {
+      vmhuge_e huge = vmhuge_NONE;
+      // wrong mode
+      TEST(EINVAL == initalignedhuge_vmpage(&page, vm_HUGEPAGESIZE, vmhuge_HUGETLB+1, &huge));
+      TEST(1 == isfree_vmpage(&page));
+      // too small
+      TEST(EINVAL == initalignedhuge_vmpage(&page, pagesize_vm()/2, vmhuge_ADVISE, &huge));
+      TEST(1 == isfree_vmpage(&page));
+      // not a power of two
+      TEST(EINVAL == initalignedhuge_vmpage(&page, vm_HUGEPAGESIZE+1, vmhuge_ADVISE, &huge));
+      TEST(1 == isfree_vmpage(&page));
+      // too big
+      TEST(EINVAL == initalignedhuge_vmpage(&page, ~(SIZE_MAX/2), vmhuge_ADVISE, &huge));
+      TEST(1 == isfree_vmpage(&page));
+   }
+
    // TEST shrink_vmpage, tryexpand_vmpage
    size_in_pages = 50;
    TEST(0 == init_vmpage(&page, size_in_pages * pagesize_vm()));
@@ -1204,6 +1494,115 @@ ONERR:
    return EINVAL;
 }
 
+static int test_vmreserve(void)
+{
+   vmreserve_t vmres = vmreserve_FREE;
+   vmpage_t    vmpage;
+   const size_t pgsize = pagesize_vm();
+
+   // TEST vmreserve_FREE
+   TEST(0 == vmres.addr);
+   TEST(0 == vmres.size);
+   TEST(0 == vmres.reserved);
+   TEST(1 == isfree_vmreserve(&vmres));
+
+   // TEST init_vmreserve: reserved range is not accessible
+   TEST(0 == init_vmreserve(&vmres, 0, 100*pgsize));
+   TEST(0 != vmres.addr);
+   TEST(0 == vmres.size);
+   TEST(100*pgsize == vmres.reserved);
+   TEST(0 == isfree_vmreserve(&vmres));
+   vmpage = (vmpage_t) vmpage_INIT(vmres.reserved, vmres.addr);
+   TEST(1 == ismapped_vm(&vmpage, accessmode_NONE));
+
+   // TEST free_vmreserve
+   TEST(0 == free_vmreserve(&vmres));
+   TEST(1 == isfree_vmreserve(&vmres));
+   TEST(1 == isunmapped_vm(&vmpage));
+   TEST(0 == free_vmreserve(&vmres));
+   TEST(1 == isfree_vmreserve(&vmres));
+
+   // TEST init_vmreserve: sizes are rounded up to pagesize_vm
+   TEST(0 == init_vmreserve(&vmres, pgsize+1, 10*pgsize-1));
+   TEST(2*pgsize  == vmres.size);
+   TEST(10*pgsize == vmres.reserved);
+   vmpage = (vmpage_t) vmpage_INIT(vmres.size, vmres.addr);
+   TEST(1 == ismapped_vm(&vmpage, accessmode_RDWR));
+   vmpage = (vmpage_t) vmpage_INIT(vmres.reserved-vmres.size, vmres.addr+vmres.size);
+   TEST(1 == ismapped_vm(&vmpage, accessmode_NONE));
+   TEST(0 == free_vmreserve(&vmres));
+
+   // TEST init_vmreserve: EINVAL
+   TEST(EINVAL == init_vmreserve(&vmres, 0, 0));
+   TEST(EINVAL == init_vmreserve(&vmres, 2*pgsize, pgsize));
+   TEST(EINVAL == init_vmreserve(&vmres, 0, (size_t)-1));
+   TEST(1 == isfree_vmreserve(&vmres));
+
+   // TEST grow_vmreserve: address never changes
+   TEST(0 == init_vmreserve(&vmres, pgsize, 16*pgsize));
+   uint8_t * addr = vmres.addr;
+   memset(vmres.addr, 1, vmres.size);
+   for (size_t i = 2; i <= 16; ++i) {
+      TEST(0 == grow_vmreserve(&vmres, i*pgsize-1));
+      TEST(addr == vmres.addr);
+      TEST(i*pgsize == vmres.size);
+      vmres.addr[vmres.size-1] = (uint8_t) i;
+      vmpage = (vmpage_t) vmpage_INIT(vmres.size, vmres.addr);
+      TEST(1 == ismapped_vm(&vmpage, accessmode_RDWR));
+      TEST(1 == vmres.addr[0]);
+   }
+
+   // TEST grow_vmreserve: same size does nothing
+   TEST(0 == grow_vmreserve(&vmres, vmres.size));
+   TEST(16*pgsize == vmres.size);
+
+   // TEST grow_vmreserve: smaller size which rounds up to same size does nothing
+   TEST(0 == grow_vmreserve(&vmres, vmres.size-pgsize+1));
+   TEST(16*pgsize == vmres.size);
+
+   // TEST grow_vmreserve: ENOMEM
+   TEST(ENOMEM == grow_vmreserve(&vmres, vmres.reserved+1));
+   TEST(addr == vmres.addr);
+   TEST(16*pgsize == vmres.size);
+
+   // TEST shrink_vmreserve: returns pages to OS
+   for (size_t i = 15; i > 0; --i) {
+      TEST(0 == shrink_vmreserve(&vmres, i*pgsize-1));
+      TEST(addr == vmres.addr);
+      TEST(i*pgsize == vmres.size);
+      TEST(1 == vmres.addr[0]);
+      vmpage = (vmpage_t) vmpage_INIT(vmres.reserved-vmres.size, vmres.addr+vmres.size);
+      TEST(1 == ismapped_vm(&vmpage, accessmode_NONE));
+   }
+
+   // TEST grow_vmreserve: content of returned pages is lost
+   TEST(0 == grow_vmreserve(&vmres, 16*pgsize));
+   for (size_t i = pgsize; i < vmres.size; ++i) {
+      TEST(0 == vmres.addr[i]);
+   }
+
+   // TEST shrink_vmreserve: zero size
+   TEST(0 == shrink_vmreserve(&vmres, 0));
+   TEST(addr == vmres.addr);
+   TEST(0 == vmres.size);
+   vmpage = (vmpage_t) vmpage_INIT(vmres.reserved, vmres.addr);
+   TEST(1 == ismapped_vm(&vmpage, accessmode_NONE));
+
+   // TEST shrink_vmreserve, grow_vmreserve: EINVAL
+   TEST(0 == grow_vmreserve(&vmres, pgsize));
+   TEST(EINVAL == shrink_vmreserve(&vmres, pgsize+1));
+   TEST(EINVAL == grow_vmreserve(&vmres, 0));
+   TEST(pgsize == vmres.size);
+
+   // unprepare
+   TEST(0 == free_vmreserve(&vmres));
+
+   return 0;
+ONERR:
+   free_vmreserve(&vmres);
+   return EINVAL;
+}
+
 static ucontext_t s_usercontext;
 
 static void sigsegfault(int _signr)
@@ -1296,6 +1695,140 @@ ONERR:
    return EINVAL;
 }
 
+/* function: nrresident_vm
+ * Returns the number of pages of vmpage which are mapped to physical memory. */
+static size_t nrresident_vm(const vmpage_t * vmpage)
+{
+   size_t        nrresident = 0;
+   unsigned char vec[64];
+   const size_t  nrpages = vmpage->size / pagesize_vm();
+
+   if (nrpages > sizeof(vec) || mincore(vmpage->addr, vmpage->size, vec)) return SIZE_MAX;
+
+   for (size_t i = 0; i < nrpages; ++i) {
+      nrresident += (vec[i] & 1);
+   }
+
+   return nrresident;
+}
+
+static int test_prefault(void)
+{
+   vmpage_t vmpage = vmpage_FREE;
+
+   // TEST prefault_vmpage: vmprefault_NONE
+   TEST(0 == init_vmpage(&vmpage, 16*pagesize_vm()));
+   TEST(0 == nrresident_vm(&vmpage));
+   TEST(0 == prefault_vmpage(&vmpage, vmprefault_NONE));
+   TEST(0 == nrresident_vm(&vmpage));
+   TEST(0 == free_vmpage(&vmpage));
+
+   // TEST prefault_vmpage: vmprefault_POPULATE
+   TEST(0 == init_vmpage(&vmpage, 16*pagesize_vm()));
+   TEST(0 == prefault_vmpage(&vmpage, vmprefault_POPULATE));
+   TEST(16 == nrresident_vm(&vmpage));
+   for (size_t i = 0; i < vmpage.size; ++i) {
+      TEST(0 == vmpage.addr[i]);
+   }
+   TEST(0 == free_vmpage(&vmpage));
+
+   // TEST prefault_vmpage: vmprefault_POPULATE keeps content
+   TEST(0 == init_vmpage(&vmpage, 16*pagesize_vm()));
+   vmpage.addr[0] = 1;
+   vmpage.addr[vmpage.size-1] = 2;
+   TEST(0 == prefault_vmpage(&vmpage, vmprefault_POPULATE));
+   TEST(16 == nrresident_vm(&vmpage));
+   TEST(1 == vmpage.addr[0]);
+   TEST(2 == vmpage.addr[vmpage.size-1]);
+   TEST(0 == free_vmpage(&vmpage));
+
+   // TEST prefault_vmpage: vmprefault_LOCK
+   TEST(0 == init_vmpage(&vmpage, 16*pagesize_vm()));
+   TEST(0 == prefault_vmpage(&vmpage, vmprefault_LOCK));
+   TEST(16 == nrresident_vm(&vmpage));
+   TEST(0 == free_vmpage(&vmpage));
+
+   // TEST prefault_vmpage: size == 0
+   TEST(0 == prefault_vmpage(&vmpage, vmprefault_POPULATE));
+   TEST(0 == prefault_vmpage(&vmpage, vmprefault_LOCK));
+
+   // TEST prefault_vmpage: EINVAL
+   TEST(0 == init_vmpage(&vmpage, pagesize_vm()));
+   TEST(EINVAL == prefault_vmpage(&vmpage, vmprefault_LOCK+1));
+   TEST(0 == nrresident_vm(&vmpage));
+   TEST(0 == free_vmpage(&vmpage));
+
+   return 0;
+ONERR:
+   free_vmpage(&vmpage);
+   return EINVAL;
+}
+
+static int test_filemap(void)
+{
+   vmpage_t vmpage = vmpage_FREE;
+   file_t   file   = file_FREE;
+   uint8_t  buffer[1000];
+   size_t   bytes;
+
+   // prepare
+   TEST(0 == inittempdeleted_file(&file));
+   for (unsigned i = 0; i < sizeof(buffer); ++i) {
+      buffer[i] = (uint8_t) (i * 13);
+   }
+   for (unsigned i = 0; i < 3; ++i) {
+      TEST(0 == write_file(file, sizeof(buffer), buffer, &bytes));
+      TEST(sizeof(buffer) == bytes);
+   }
+
+   for (size_t size = 1; size <= 3*sizeof(buffer); size += sizeof(buffer)-1) {
+      // TEST initfile_vmpage
+      TEST(0 == initfile_vmpage(&vmpage, io_file(file), size));
+      TEST(0 != vmpage.addr);
+      TEST(0 == vmpage.size % pagesize_vm());
+      TEST(size <= vmpage.size);
+      TEST(size + pagesize_vm() > vmpage.size);
+      TEST(1 == ismapped_vm(&vmpage, accessmode_READ|accessmode_PRIVATE));
+      for (size_t i = 0; i < size; ++i) {
+         TEST(buffer[i % sizeof(buffer)] == vmpage.addr[i]);
+      }
+
+      // TEST initfile_vmpage: bytes beyond end of file are 0
+      for (size_t i = 3*sizeof(buffer); i < vmpage.size; ++i) {
+         TEST(0 == vmpage.addr[i]);
+      }
+
+      // TEST free_vmpage
+      vmpage_t old = vmpage;
+      TEST(0 == free_vmpage(&vmpage));
+      TEST(1 == isfree_vmpage(&vmpage));
+      TEST(1 == isunmapped_vm(&old));
+   }
+
+   // TEST initfile_vmpage: mapping is independent of file
+   TEST(0 == initfile_vmpage(&vmpage, io_file(file), 3*sizeof(buffer)));
+   TEST(0 == free_file(&file));
+   for (size_t i = 0; i < 3*sizeof(buffer); ++i) {
+      TEST(buffer[i % sizeof(buffer)] == vmpage.addr[i]);
+   }
+   TEST(0 == free_vmpage(&vmpage));
+
+   // TEST initfile_vmpage: EBADF
+   TEST(EBADF == initfile_vmpage(&vmpage, file, 1));
+   TEST(1 == isfree_vmpage(&vmpage));
+
+   // TEST initfile_vmpage: EINVAL
+   TEST(EINVAL == initfile_vmpage(&vmpage, sys_iochannel_STDIN, 0));
+   TEST(EINVAL == initfile_vmpage(&vmpage, sys_iochannel_STDIN, SIZE_MAX));
+   TEST(1 == isfree_vmpage(&vmpage));
+
+   return 0;
+ONERR:
+   free_vmpage(&vmpage);
+   free_file(&file);
+   return EINVAL;
+}
+
 int unittest_platform_vm()
 {
    vm_mappedregions_t mappedregions  = vm_mappedregions_FREE;
@@ -1306,8 +1839,11 @@ int unittest_platform_vm()
 
    if (test_functions())      goto ONERR;
    if (test_mappedregions())  goto ONERR;
+   if (test_vmreserve())      goto ONERR;
    if (test_vmpage())         goto ONERR;
    if (test_protection())     goto ONERR;
+   if (test_prefault())       goto ONERR;
+   if (test_filemap())        goto ONERR;
 
    // TEST mapping has not changed
    TEST(0 == init_vmmappedregions(&mappedregions2));
@@ -100,6 +100,63 @@ int run_perftest(maincontext_t* maincontext)
 
    RUN(perftest_task_syncrunner);
    RUN(perftest_task_syncrunner_raw);
+   RUN(perftest_memory_mm_mmimpl);
+   RUN(perftest_memory_mm_mmimpl_remote);
+   RUN(perftest_memory_mm_mmimpl_malloc);
+   RUN(perftest_ds_inmem_arraysf_sequential);
+   RUN(perftest_ds_inmem_arraysf_random);
+   RUN(perftest_ds_inmem_arraysf_small);
+   RUN(perftest_ds_inmem_arraystf_sequential);
+   RUN(perftest_ds_inmem_arraystf_random);
+   RUN(perftest_ds_inmem_arraystf_small);
+   RUN(perftest_ds_inmem_redblacktree);
+   RUN(perftest_ds_inmem_redblacktree_cmp);
+   RUN(perftest_ds_inmem_redblacktree_sequential);
+   RUN(perftest_ds_inmem_redblacktree_random);
+   RUN(perftest_ds_inmem_redblacktree_small);
+   RUN(perftest_ds_inmem_splaytree);
+   RUN(perftest_ds_inmem_splaytree_cmp);
+   RUN(perftest_ds_inmem_splaytree_sequential);
+   RUN(perftest_ds_inmem_splaytree_random);
+   RUN(perftest_ds_inmem_splaytree_small);
+   RUN(perftest_ds_inmem_exthash);
+   RUN(perftest_ds_inmem_exthash_cmp);
+   RUN(perftest_ds_inmem_exthash_sequential);
+   RUN(perftest_ds_inmem_exthash_random);
+   RUN(perftest_ds_inmem_exthash_small);
+   RUN(perftest_ds_inmem_flathash);
+   RUN(perftest_ds_inmem_flathash_exthash);
+   RUN(perftest_ds_inmem_dheap);
+   RUN(perftest_ds_inmem_dheap_heap);
+   RUN(perftest_ds_inmem_heap_sequential);
+   RUN(perftest_ds_inmem_heap_random);
+   RUN(perftest_ds_inmem_heap_small);
+   RUN(perftest_ds_inmem_cqueue_spsc);
+   RUN(perftest_ds_inmem_cqueue_mpsc);
+   RUN(perftest_ds_inmem_queue);
+   RUN(perftest_ds_inmem_queue_small);
+   RUN(perftest_ds_inmem_slist);
+   RUN(perftest_ds_inmem_slist_small);
+   RUN(perftest_ds_inmem_dlist_sequential);
+   RUN(perftest_ds_inmem_dlist_random);
+   RUN(perftest_ds_inmem_dlist_small);
+   RUN(perftest_ds_inmem_bloomfilter_8);
+   RUN(perftest_ds_inmem_bloomfilter_12);
+   RUN(perftest_ds_inmem_bloomfilter_16);
+   RUN(perftest_ds_inmem_patriciatrie_sequential);
+   RUN(perftest_ds_inmem_patriciatrie_random);
+   RUN(perftest_ds_inmem_patriciatrie_small);
+   RUN(perftest_ds_inmem_trie_sequential);
+   RUN(perftest_ds_inmem_trie_random);
+   RUN(perftest_ds_inmem_trie_small);
+   RUN(perftest_ds_sort_mergesort);
+   RUN(perftest_ds_sort_mergesort_ptr);
+   RUN(perftest_ds_sort_mergesort_implement);
+   RUN(perftest_ds_sort_mergesort_parallel2);
+   RUN(perftest_ds_sort_mergesort_parallel4);
+   RUN(perftest_ds_sort_mergesort_sorted);
+   RUN(perftest_ds_sort_mergesort_small);
+   RUN(perftest_ds_sort_radixsort);
 
    return 0;
 }
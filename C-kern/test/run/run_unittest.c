@@ -132,9 +132,15 @@ static int run_all_test(maincontext_t* maincontext)
       RUN(unittest_ds_inmem_arraystf);
       RUN(unittest_ds_inmem_binarystack);
       RUN(unittest_ds_inmem_blockarray);
+      RUN(unittest_ds_inmem_bloomfilter);
+      RUN(unittest_ds_inmem_bptree);
       RUN(unittest_ds_inmem_dlist);
       RUN(unittest_ds_inmem_olist);
       RUN(unittest_ds_inmem_exthash);
+      RUN(unittest_ds_inmem_cexthash);
+      RUN(unittest_ds_inmem_flathash);
+      RUN(unittest_ds_inmem_dheap);
+      RUN(unittest_ds_inmem_cqueue);
       RUN(unittest_ds_inmem_heap);
       RUN(unittest_ds_inmem_patriciatrie);
       RUN(unittest_ds_inmem_queue);
@@ -142,9 +148,11 @@ static int run_all_test(maincontext_t* maincontext)
       RUN(unittest_ds_inmem_slist);
       RUN(unittest_ds_inmem_splaytree);
       RUN(unittest_ds_inmem_suffixtree);
+      RUN(unittest_ds_inmem_suffixarray);
       RUN(unittest_ds_inmem_trie);
       // sort algorithms
       RUN(unittest_ds_sort_mergesort);
+      RUN(unittest_ds_sort_radixsort);
       // type adapter
       RUN(unittest_ds_typeadapt);
       RUN(unittest_ds_typeadapt_comparator);
@@ -189,6 +197,7 @@ static int run_all_test(maincontext_t* maincontext)
       RUN(unittest_memory_ptr);
       RUN(unittest_memory_wbuffer);
       RUN(unittest_memory_mm_mm);
+      RUN(unittest_memory_mm_mmarena);
       RUN(unittest_memory_mm_mmimpl);
 //}
 